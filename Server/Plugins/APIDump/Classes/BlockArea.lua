@@ -1991,6 +1991,65 @@ return
 					Notes = "Writes the area into World at the specified coords, returns true if successful. DataTypes is the sum of baXXX datatypes to write.",
 				},
 			},
+			WriteInSteps =
+			{
+				{
+					Params =
+					{
+						{
+							Name = "World",
+							Type = "cWorld",
+						},
+						{
+							Name = "MinPoint",
+							Type = "Vector3i",
+						},
+						{
+							Name = "DataTypes",
+							Type = "number",
+							IsOptional = true,
+						},
+						{
+							Name = "OnFinished",
+							Type = "function",
+							IsOptional = true,
+						},
+					},
+					Notes = "Writes a copy of the area into World at the specified coords in small, bounded steps, a few chunk sections per tick, so that writing a large area doesn't stall the world tick. The world sees the area partially written until the write is finished. DataTypes is the sum of baXXX datatypes to write, all present datatypes are written if not given. Once the whole area has been written, the OnFinished callback is called on the world's tick thread: <pre class=\"prettyprint lang-lua\">function (a_World, a_IsSuccess)</pre> a_IsSuccess is false if any of the chunks wasn't available.",
+				},
+				{
+					Params =
+					{
+						{
+							Name = "World",
+							Type = "cWorld",
+						},
+						{
+							Name = "MinX",
+							Type = "number",
+						},
+						{
+							Name = "MinY",
+							Type = "number",
+						},
+						{
+							Name = "MinZ",
+							Type = "number",
+						},
+						{
+							Name = "DataTypes",
+							Type = "number",
+							IsOptional = true,
+						},
+						{
+							Name = "OnFinished",
+							Type = "function",
+							IsOptional = true,
+						},
+					},
+					Notes = "Writes a copy of the area into World at the specified coords in small, bounded steps spread over several ticks. See the Vector3i overload for details.",
+				},
+			},
 		},
 		Constants =
 		{
@@ -0,0 +1,132 @@
+
+-- Metrics.lua
+
+-- Defines the documentation for the cMetrics class
+
+
+
+
+
+return
+{
+	cMetrics =
+	{
+		Desc = [[
+			Provides access to the server's runtime metrics: counters (such as the number of chunks generated or
+			packets sent), gauges (such as the queue lengths) and latency histograms (such as the durations of the
+			world tick phases). The same metrics are served in the Prometheus text format by the webadmin at the
+			/metrics URL.</p>
+			<p>
+			Plugins may also publish their own metrics. Each metric is identified by its name and its labels, a
+			dictionary-table of string label names to string values; the metric is created upon its first use.
+			The names must consist of letters, digits and underscores, and should follow the Prometheus
+			conventions, such as a plugin-specific prefix and a "_total" suffix for counters. A name can only be
+			used for one type of metric.</p>
+			<p>
+			All the functions are static, call them using the <code>cMetrics:Function()</code> convention:
+<pre class="prettyprint lang-lua">
+cMetrics:AddCounter("myplugin_homes_set_total", "The number of homes set by the players", 1, {world = a_Player:GetWorld():GetName()})
+</pre></p>
+		]],
+		Functions =
+		{
+			AddCounter =
+			{
+				IsStatic = true,
+				Params =
+				{
+					{
+						Name = "Name",
+						Type = "string",
+					},
+					{
+						Name = "Help",
+						Type = "string",
+					},
+					{
+						Name = "Amount",
+						Type = "number",
+					},
+					{
+						Name = "Labels",
+						Type = "table",
+						IsOptional = true,
+					},
+				},
+				Notes = "Adds the (non-negative) amount to the counter of the specified name and labels. The Help text describes the metric in the export.",
+			},
+			GetPrometheusText =
+			{
+				IsStatic = true,
+				Returns =
+				{
+					{
+						Type = "string",
+					},
+				},
+				Notes = "Returns all the metrics in the Prometheus text exposition format.",
+			},
+			GetSamples =
+			{
+				IsStatic = true,
+				Returns =
+				{
+					{
+						Type = "table",
+					},
+				},
+				Notes = "Returns an array-table of the current values of all the metrics. Each item is a dictionary-table with the Name, Labels (a dictionary-table), Type (\"counter\", \"gauge\" or \"histogram\") and Value members. For histograms, Value is the number of the recorded durations, and the Sum, P50, P90, P99 and Max members give their sum, median, 90th and 99th percentile and maximum, in seconds.",
+			},
+			RecordDuration =
+			{
+				IsStatic = true,
+				Params =
+				{
+					{
+						Name = "Name",
+						Type = "string",
+					},
+					{
+						Name = "Help",
+						Type = "string",
+					},
+					{
+						Name = "Seconds",
+						Type = "number",
+					},
+					{
+						Name = "Labels",
+						Type = "table",
+						IsOptional = true,
+					},
+				},
+				Notes = "Records the duration, in seconds, into the histogram of the specified name and labels.",
+			},
+			SetGauge =
+			{
+				IsStatic = true,
+				Params =
+				{
+					{
+						Name = "Name",
+						Type = "string",
+					},
+					{
+						Name = "Help",
+						Type = "string",
+					},
+					{
+						Name = "Value",
+						Type = "number",
+					},
+					{
+						Name = "Labels",
+						Type = "table",
+						IsOptional = true,
+					},
+				},
+				Notes = "Sets the gauge of the specified name and labels to the (integral) value.",
+			},
+		},
+	},
+}
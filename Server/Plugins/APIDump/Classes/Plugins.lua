@@ -177,6 +177,25 @@ cPluginManager.AddHook(cPluginManager.HOOK_CHAT, OnChatMessage);
 					},
 					Notes = "Informs the plugin manager that it should call the specified function when the specified hook event occurs. If a function is not specified, a default global function name is looked up, based on the hook type",
 				},
+				{
+					IsStatic = true,
+					Params =
+					{
+						{
+							Name = "HookType",
+							Type = "cPluginManager#PluginHook",
+						},
+						{
+							Name = "Callback",
+							Type = "function",
+						},
+						{
+							Name = "MinIntervalMSec",
+							Type = "number",
+						},
+					},
+					Notes = "Adds a rate-limited callback: the function is called at most once per MinIntervalMSec milliseconds for each player (HOOK_PLAYER_MOVING), each world (HOOK_WORLD_TICK) or for the server (HOOK_TICK). The tick callbacks receive the time delta summed over the ticks since their previous call. The HOOK_PLAYER_MOVING callback receives the moves coalesced since its previous call, from the position before the first one to the position after the last one; it only observes the moves, its return value is ignored and it cannot cancel them. Once the player stops moving, the last coalesced move is delivered from the world tick after the interval has elapsed. Other hook types can be cancelled and are not supported, the callback is not added.",
+				},
 			},
 			BindCommand =
 			{
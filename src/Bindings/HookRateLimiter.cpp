@@ -0,0 +1,136 @@
+// HookRateLimiter.cpp
+
+// Implements the cHookRateLimiter class that coalesces the calls of a rate-limited hook callback
+
+#include "Globals.h"
+#include "HookRateLimiter.h"
+#include "PluginManager.h"
+
+
+
+
+
+cHookRateLimiter::cHookRateLimiter(std::chrono::milliseconds a_MinInterval, cClock::time_point a_Now):
+	m_MinInterval(a_MinInterval),
+	m_LastPurge(a_Now)
+{
+}
+
+
+
+
+
+bool cHookRateLimiter::IsSupported(int a_HookType)
+{
+	switch (a_HookType)
+	{
+		case cPluginManager::HOOK_PLAYER_MOVING:
+		case cPluginManager::HOOK_TICK:
+		case cPluginManager::HOOK_WORLD_TICK:
+		{
+			return true;
+		}
+		default:
+		{
+			// The other hooks can be cancelled and have no observe-only variant, or aren't called often enough to need rate-limiting
+			return false;
+		}
+	}
+}
+
+
+
+
+
+bool cHookRateLimiter::Trigger(UInt64 a_Subject, float a_DtMSec, cClock::time_point a_Now, float & a_CoalescedDtMSec)
+{
+	auto & Subject = GetSubject(a_Subject, a_Now);
+	Subject.m_DtMSec += a_DtMSec;
+	if (a_Now - Subject.m_LastCall < m_MinInterval)
+	{
+		return false;
+	}
+	Subject.m_LastCall = a_Now;
+	a_CoalescedDtMSec = Subject.m_DtMSec;
+	Subject.m_DtMSec = 0;
+	return true;
+}
+
+
+
+
+
+bool cHookRateLimiter::TriggerMove(UInt64 a_Subject, UInt64 a_Group, const sMove & a_Move, cClock::time_point a_Now, sMove & a_CoalescedMove)
+{
+	auto & Subject = GetSubject(a_Subject, a_Now);
+	if (!Subject.m_HasPendingMove || (Subject.m_Group != a_Group))
+	{
+		// Start a new coalesced move; a move pending in another world is dropped, the player has left it:
+		Subject.m_PendingMove = a_Move;
+		Subject.m_HasPendingMove = true;
+		Subject.m_Group = a_Group;
+	}
+	else
+	{
+		Subject.m_PendingMove.m_NewPosition = a_Move.m_NewPosition;
+	}
+	if (a_Now - Subject.m_LastCall < m_MinInterval)
+	{
+		return false;
+	}
+	Subject.m_LastCall = a_Now;
+	a_CoalescedMove = Subject.m_PendingMove;
+	Subject.m_HasPendingMove = false;
+	return true;
+}
+
+
+
+
+
+void cHookRateLimiter::FlushMoves(UInt64 a_Group, cClock::time_point a_Now, cSubjectMoves & a_Moves)
+{
+	for (auto & Subject: m_Subjects)
+	{
+		auto & State = Subject.second;
+		if (!State.m_HasPendingMove || (State.m_Group != a_Group) || (a_Now - State.m_LastCall < m_MinInterval))
+		{
+			continue;
+		}
+		State.m_LastCall = a_Now;
+		State.m_HasPendingMove = false;
+		a_Moves.emplace_back(Subject.first, State.m_PendingMove);
+	}
+}
+
+
+
+
+
+cHookRateLimiter::sSubject & cHookRateLimiter::GetSubject(UInt64 a_Subject, cClock::time_point a_Now)
+{
+	// Purge the subjects that haven't triggered the hook for a while:
+	if (a_Now - m_LastPurge > PURGE_AGE)
+	{
+		m_LastPurge = a_Now;
+		for (auto itr = m_Subjects.begin(); itr != m_Subjects.end();)
+		{
+			if (a_Now - itr->second.m_LastSeen > PURGE_AGE)
+			{
+				itr = m_Subjects.erase(itr);
+			}
+			else
+			{
+				++itr;
+			}
+		}
+	}
+
+	auto & Subject = m_Subjects[a_Subject];
+	Subject.m_LastSeen = a_Now;
+	return Subject;
+}
+
+
+
+
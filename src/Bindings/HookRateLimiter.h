@@ -0,0 +1,110 @@
+// HookRateLimiter.h
+
+// Declares the cHookRateLimiter class that coalesces the calls of a rate-limited hook callback
+
+/*
+A plugin may register a hook callback with a minimum interval between the calls (cPluginManager:AddHook() with the
+MinIntervalMSec parameter). The callback is then called at most once per interval for each subject of the hook - each
+world for HOOK_WORLD_TICK, the server for HOOK_TICK, each player for HOOK_PLAYER_MOVING.
+The tick hooks sum the time deltas of the skipped calls into the next call that is made. They keep coming for as long as
+their subject exists, so the summed time always reaches the plugin with the next call, without any flushing.
+The player moves are coalesced into a single move, from the position before the first skipped move to the position after
+the last one. Such a callback only observes the moves, it cannot cancel them, so a skipped call doesn't let anything
+through that the plugin would otherwise have stopped. A player that stops moving doesn't trigger the hook anymore, so the
+coalesced move is flushed from the world tick once the interval has elapsed, see FlushMoves().
+The other hooks can be cancelled and have no observe-only variant, they cannot be rate-limited.
+*/
+
+
+
+
+#pragma once
+
+
+
+
+
+class cHookRateLimiter
+{
+public:
+
+	using cClock = std::chrono::steady_clock;
+
+	/** A player move, possibly coalesced from several moves reported by HOOK_PLAYER_MOVING. */
+	struct sMove
+	{
+		Vector3d m_OldPosition;
+		Vector3d m_NewPosition;
+		bool m_PreviousIsOnGround = false;
+	};
+
+	/** A coalesced move to be flushed, together with the subject (player's entity ID) that made it. */
+	using cSubjectMoves = std::vector<std::pair<UInt64, sMove>>;
+
+
+	cHookRateLimiter(std::chrono::milliseconds a_MinInterval, cClock::time_point a_Now);
+
+	/** Returns true if callbacks for the specified hook type may be rate-limited. */
+	static bool IsSupported(int a_HookType);
+
+	/** Records the hook being triggered for the subject, with the specified time delta.
+	Returns true if the callback is to be called now, in which case a_CoalescedDtMSec receives the time delta summed since the
+	previous call. Returns false if the call is to be coalesced into a later one. */
+	bool Trigger(UInt64 a_Subject, float a_DtMSec, cClock::time_point a_Now, float & a_CoalescedDtMSec);
+
+	/** Records the subject's move within the group (world), as reported by HOOK_PLAYER_MOVING.
+	Returns true if the callback is to be called now, in which case a_Move receives the move coalesced since the previous call.
+	Returns false if the move is to be coalesced into a later call, or flushed by FlushMoves(). */
+	bool TriggerMove(UInt64 a_Subject, UInt64 a_Group, const sMove & a_Move, cClock::time_point a_Now, sMove & a_CoalescedMove);
+
+	/** Moves the coalesced moves of the group's subjects whose interval has elapsed by a_Now to a_Moves, they count as called.
+	Used for the players that have stopped moving, so that the plugin learns their final position. */
+	void FlushMoves(UInt64 a_Group, cClock::time_point a_Now, cSubjectMoves & a_Moves);
+
+	/** Returns the number of the subjects whose state is kept. */
+	size_t GetNumSubjects(void) const { return m_Subjects.size(); }
+
+	/** The time after which a subject that hasn't triggered the hook is dropped, such as a world that was unloaded. */
+	static constexpr std::chrono::minutes PURGE_AGE{1};
+
+protected:
+
+	/** The state of the coalesced calls for a single subject of the hook. */
+	struct sSubject
+	{
+		/** The time of the last call made for the subject. */
+		cClock::time_point m_LastCall;
+
+		/** The time the hook was last triggered for the subject. */
+		cClock::time_point m_LastSeen;
+
+		/** The time delta summed over the calls coalesced since the last call. */
+		float m_DtMSec = 0;
+
+		/** Set if m_PendingMove holds the moves coalesced since the last call. */
+		bool m_HasPendingMove = false;
+
+		/** The moves coalesced since the last call. */
+		sMove m_PendingMove;
+
+		/** The group (world) in which the pending move was made. */
+		UInt64 m_Group = 0;
+	};
+
+
+	std::chrono::milliseconds m_MinInterval;
+
+	/** The subjects of the hook, keyed by the world's address, 0 for HOOK_TICK, or the player's entity ID. */
+	std::unordered_map<UInt64, sSubject> m_Subjects;
+
+	/** The time the stale subjects were last purged. */
+	cClock::time_point m_LastPurge;
+
+
+	/** Returns the subject's state, purging the subjects that haven't triggered the hook for a while first. */
+	sSubject & GetSubject(UInt64 a_Subject, cClock::time_point a_Now);
+};
+
+
+
+
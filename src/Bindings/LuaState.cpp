@@ -432,6 +432,8 @@ cLuaState::cLuaState(const AString & a_SubsystemName) :
 	m_LuaState(nullptr),
 	m_IsOwned(false),
 	m_SubsystemName(a_SubsystemName),
+	m_CurrentFunctionName(nullptr),
+	m_IsCurrentFunctionTableCallback(false),
 	m_NumCurrentFunctionArgs(-1)
 {
 }
@@ -444,6 +446,8 @@ cLuaState::cLuaState(lua_State * a_AttachState) :
 	m_LuaState(a_AttachState),
 	m_IsOwned(false),
 	m_SubsystemName("<attached>"),
+	m_CurrentFunctionName(nullptr),
+	m_IsCurrentFunctionTableCallback(false),
 	m_NumCurrentFunctionArgs(-1)
 {
 }
@@ -739,7 +743,8 @@ bool cLuaState::PushFunction(const char * a_FunctionName)
 		lua_pop(m_LuaState, 2);
 		return false;
 	}
-	m_CurrentFunctionName.assign(a_FunctionName);
+	m_CurrentFunctionName = a_FunctionName;
+	m_IsCurrentFunctionTableCallback = false;
 	m_NumCurrentFunctionArgs = 0;
 	return true;
 }
@@ -763,6 +768,7 @@ bool cLuaState::PushFunction(const cRef & a_FnRef)
 		return false;
 	}
 	m_CurrentFunctionName = "<callback>";
+	m_IsCurrentFunctionTableCallback = false;
 	m_NumCurrentFunctionArgs = 0;
 	return true;
 }
@@ -803,7 +809,8 @@ bool cLuaState::PushFunction(const cRef & a_TableRef, const char * a_FnName)
 	// Pop the table off the stack:
 	lua_remove(m_LuaState, -2);
 
-	Printf(m_CurrentFunctionName, "<table-callback %s>", a_FnName);
+	m_CurrentFunctionName = a_FnName;
+	m_IsCurrentFunctionTableCallback = true;
 	m_NumCurrentFunctionArgs = 0;
 	return true;
 }
@@ -1621,8 +1628,9 @@ bool cLuaState::CallFunction(int a_NumResults)
 	ASSERT(lua_isfunction(m_LuaState, -m_NumCurrentFunctionArgs - 2));  // The error handler
 
 	// Save the current "stack" state and reset, in case the callback calls another function:
-	AString CurrentFunctionName;
-	std::swap(m_CurrentFunctionName, CurrentFunctionName);
+	auto CurrentFunctionName = m_CurrentFunctionName;
+	auto IsTableCallback = m_IsCurrentFunctionTableCallback;
+	m_CurrentFunctionName = nullptr;
 	int NumArgs = m_NumCurrentFunctionArgs;
 	m_NumCurrentFunctionArgs = -1;
 
@@ -1631,7 +1639,18 @@ bool cLuaState::CallFunction(int a_NumResults)
 	if (s != 0)
 	{
 		// The error has already been printed together with the stacktrace
-		LOGWARNING("Error in %s calling function %s()", m_SubsystemName.c_str(), CurrentFunctionName.c_str());
+		if (CurrentFunctionName == nullptr)
+		{
+			CurrentFunctionName = "<unknown>";
+		}
+		if (IsTableCallback)
+		{
+			LOGWARNING("Error in %s calling function <table-callback %s>()", m_SubsystemName.c_str(), CurrentFunctionName);
+		}
+		else
+		{
+			LOGWARNING("Error in %s calling function %s()", m_SubsystemName.c_str(), CurrentFunctionName);
+		}
 
 		// Remove the error handler and error message from the stack:
 		auto top = lua_gettop(m_LuaState);
@@ -2212,7 +2231,7 @@ int cLuaState::CallFunctionWithForeignParams(
 		// Something went wrong, fix the stack and exit
 		lua_settop(m_LuaState, OldTop);
 		m_NumCurrentFunctionArgs = -1;
-		m_CurrentFunctionName.clear();
+		m_CurrentFunctionName = nullptr;
 		return -1;
 	}
 
@@ -2226,7 +2245,7 @@ int cLuaState::CallFunctionWithForeignParams(
 
 		// Reset the internal checking mechanisms:
 		m_NumCurrentFunctionArgs = -1;
-		m_CurrentFunctionName.clear();
+		m_CurrentFunctionName = nullptr;
 
 		// Make Lua think everything is okay and return 0 values, so that plugins continue executing.
 		// The failure is indicated by the zero return values.
@@ -2235,7 +2254,7 @@ int cLuaState::CallFunctionWithForeignParams(
 
 	// Reset the internal checking mechanisms:
 	m_NumCurrentFunctionArgs = -1;
-	m_CurrentFunctionName.clear();
+	m_CurrentFunctionName = nullptr;
 
 	// Remove the error handler from the stack:
 	lua_remove(m_LuaState, OldTop + 1);
@@ -924,8 +924,12 @@ protected:
 	whatever is given to the constructor. */
 	AString m_SubsystemName;
 
-	/** Name of the currently pushed function (for the Push / Call chain) */
-	AString m_CurrentFunctionName;
+	/** Name of the currently pushed function (for the Push / Call chain), used only for error reporting.
+	Points to the name given to PushFunction(), which outlives the call; no copy is made on the hot hook path. */
+	const char * m_CurrentFunctionName;
+
+	/** True if the currently pushed function is a table's member, pushed by PushFunction(cRef, FnName); reported as "<table-callback Name>". */
+	bool m_IsCurrentFunctionTableCallback;
 
 	/** Number of arguments currently pushed (for the Push / Call chain) */
 	int m_NumCurrentFunctionArgs;
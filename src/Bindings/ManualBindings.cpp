@@ -54,13 +54,16 @@
 ////////////////////////////////////////////////////////////////////////////////
 // LuaCommandHandler:
 
-/** Defines a bridge between cPluginManager::cCommandHandler and cLuaState::cCallback. */
+/** Defines a bridge between cPluginManager::cCommandHandler and cLuaState::cCallback.
+The handler's time is accounted to the plugin under a_CallbackName. */
 class LuaCommandHandler:
 	public cPluginManager::cCommandHandler
 {
 public:
-	LuaCommandHandler(cLuaState::cCallbackPtr && a_Callback):
-		m_Callback(std::move(a_Callback))
+	LuaCommandHandler(cLuaState::cCallbackPtr && a_Callback, std::shared_ptr<cPluginCpuStats> a_CpuStats, const AString & a_CallbackName):
+		m_Callback(std::move(a_Callback)),
+		m_CpuStats(std::move(a_CpuStats)),
+		m_CallbackName(a_CallbackName)
 	{
 	}
 
@@ -73,6 +76,7 @@ public:
 	{
 		bool res = false;
 		AString s;
+		cPluginCpuStats::cTimer Timer(m_CpuStats.get(), m_CallbackName);
 		if (!m_Callback->Call(a_Split, a_Player, a_Command, cLuaState::Return, res, s))
 		{
 			return false;
@@ -86,6 +90,8 @@ public:
 
 protected:
 	cLuaState::cCallbackPtr m_Callback;
+	std::shared_ptr<cPluginCpuStats> m_CpuStats;
+	AString m_CallbackName;
 };
 
 
@@ -1031,7 +1037,30 @@ static int tolua_cPluginManager_AddHook_FnRef(cPluginManager * a_PluginManager,
 		S.LogStackTrace();
 		return 0;
 	}
-	if (!Plugin->AddHookCallback(HookType, std::move(callback)))
+
+	// An optional minimum interval makes the callback rate-limited, with the calls in between coalesced:
+	if (lua_isnumber(S, a_ParamIdx + 2))
+	{
+		int MinIntervalMSec = 0;
+		S.GetStackValue(a_ParamIdx + 2, MinIntervalMSec);
+		if (MinIntervalMSec < 0)
+		{
+			LOGWARNING("cPluginManager.AddHook(): The minimum interval cannot be negative (%d).", MinIntervalMSec);
+			S.LogStackTrace();
+			return 0;
+		}
+		if (!Plugin->AddHookCallback(HookType, std::move(callback), std::chrono::milliseconds(MinIntervalMSec)))
+		{
+			S.LogStackTrace();
+			return 0;
+		}
+		if (HookType == cPluginManager::HOOK_PLAYER_MOVING)
+		{
+			// The coalesced moves of the players that stop moving are flushed from the world tick:
+			a_PluginManager->AddHook(Plugin, cPluginManager::HOOK_WORLD_TICK);
+		}
+	}
+	else if (!Plugin->AddHookCallback(HookType, std::move(callback)))
 	{
 		LOGWARNING("cPluginManager.AddHook(): Cannot add hook %d, unknown error.", HookType);
 		S.LogStackTrace();
@@ -1113,6 +1142,7 @@ static int tolua_cPluginManager_AddHook(lua_State * tolua_S)
 	/*
 	Function signatures:
 	cPluginManager:AddHook(HOOK_TYPE, CallbackFunction)        -- (1) recommended
+	cPluginManager:AddHook(HOOK_TYPE, CallbackFunction, MinIntervalMSec)  -- (1) rate-limited, only for HOOK_PLAYER_MOVING, HOOK_WORLD_TICK and HOOK_TICK
 	cPluginManager.AddHook(HOOK_TYPE, CallbackFunction)        -- (2) accepted silently (#401 deprecates this)
 	cPluginManager:Get():AddHook(HOOK_TYPE, CallbackFunction)  -- (3) accepted silently
 	cPluginManager:Get():AddHook(Plugin, HOOK_TYPE)            -- (4) old style (#121), accepted but complained about in the console
@@ -1333,7 +1363,7 @@ static int tolua_cPluginManager_BindCommand(lua_State * a_LuaState)
 		return 0;
 	}
 
-	auto CommandHandler = std::make_shared<LuaCommandHandler>(std::move(Handler));
+	auto CommandHandler = std::make_shared<LuaCommandHandler>(std::move(Handler), Plugin->GetCpuStatsPtr(), "Command " + Command);
 	if (!self->BindCommand(Command, Plugin, CommandHandler, Permission, HelpString))
 	{
 		// Refused. Possibly already bound. Error message has been given, display the callstack:
@@ -1399,7 +1429,7 @@ static int tolua_cPluginManager_BindConsoleCommand(lua_State * a_LuaState)
 		return 0;
 	}
 
-	auto CommandHandler = std::make_shared<LuaCommandHandler>(std::move(Handler));
+	auto CommandHandler = std::make_shared<LuaCommandHandler>(std::move(Handler), Plugin->GetCpuStatsPtr(), "ConsoleCommand " + Command);
 	if (!self->BindConsoleCommand(Command, Plugin, CommandHandler, HelpString))
 	{
 		// Refused. Possibly already bound. Error message has been given, display the callstack:
@@ -1595,6 +1625,35 @@ static int tolua_cPlayer_GetRestrictions(lua_State * tolua_S)
 
 
 
+static int tolua_cPlayer_HasPermission(lua_State * tolua_S)
+{
+	// Function signature: cPlayer:HasPermission(PermissionStr) -> bool
+
+	// Check the params:
+	cLuaState L(tolua_S);
+	if (
+		!L.CheckParamSelf("cPlayer") ||
+		!L.CheckParamString(2) ||
+		!L.CheckParamEnd(3)
+	)
+	{
+		return 0;
+	}
+
+	// Get the params:
+	cPlayer * Self = nullptr;
+	std::string_view Permission;
+	L.GetStackValues(1, Self, Permission);
+
+	// Push the result of the check:
+	L.Push(Self->HasPermission(Permission));
+	return 1;
+}
+
+
+
+
+
 static int tolua_cPlayer_PermissionMatches(lua_State * tolua_S)
 {
 	// Function signature: cPlayer:PermissionMatches(PermissionStr, TemplateStr) -> bool
@@ -1681,6 +1740,10 @@ public:
 	/** The Lua callback to call to generate the page contents. */
 	cLuaState::cCallback m_Callback;
 
+	/** The accounting of the plugin's CPU time, and the name under which the tab's time is accounted. */
+	std::shared_ptr<cPluginCpuStats> m_CpuStats;
+	AString m_CallbackName;
+
 	virtual bool Call(
 		const HTTPRequest & a_Request,
 		const AString & a_UrlPath,
@@ -1689,6 +1752,7 @@ public:
 	) override
 	{
 		AString content, contentType;
+		cPluginCpuStats::cTimer Timer(m_CpuStats.get(), m_CallbackName);
 		return m_Callback.Call(const_cast<HTTPRequest *>(&a_Request), a_UrlPath, cLuaState::Return, a_Content, a_ContentType);
 	}
 };
@@ -1736,6 +1800,8 @@ static int tolua_cPluginLua_AddWebTab(lua_State * tolua_S)
 		urlPath = cWebAdmin::GetURLEncodedString(title);
 	}
 
+	callback->m_CpuStats = self->GetCpuStatsPtr();
+	callback->m_CallbackName = "WebTab " + title;
 	cRoot::Get()->GetWebAdmin()->AddWebTab(title, urlPath, self->GetName(), callback);
 
 	return 0;
@@ -2182,6 +2248,8 @@ static int tolua_cWebAdmin_AddWebTab(lua_State * tolua_S)
 		return 0;
 	}
 
+	callback->m_CpuStats = self->GetCpuStatsPtr();
+	callback->m_CallbackName = "WebTab " + title;
 	cRoot::Get()->GetWebAdmin()->AddWebTab(title, urlPath, self->GetName(), callback);
 
 	return 0;
@@ -4601,6 +4669,7 @@ void cManualBindings::Bind(lua_State * tolua_S)
 		tolua_beginmodule(tolua_S, "cPlayer");
 			tolua_function(tolua_S, "GetPermissions",    tolua_cPlayer_GetPermissions);
 			tolua_function(tolua_S, "GetRestrictions",   tolua_cPlayer_GetRestrictions);
+			tolua_function(tolua_S, "HasPermission",     tolua_cPlayer_HasPermission);
 			tolua_function(tolua_S, "PermissionMatches", tolua_cPlayer_PermissionMatches);
 			tolua_function(tolua_S, "GetUUID",           tolua_cPlayer_GetUUID);
 		tolua_endmodule(tolua_S);
@@ -4689,6 +4758,7 @@ void cManualBindings::Bind(lua_State * tolua_S)
 			tolua_array(tolua_S, "Custom", tolua_get_StatisticsManager_Custom, tolua_set_StatisticsManager_Custom);
 		tolua_endmodule(tolua_S);
 
+		BindMetrics(tolua_S);
 		BindNetwork(tolua_S);
 		BindRankManager(tolua_S);
 		BindWorld(tolua_S);
@@ -30,6 +30,10 @@ public:
 	static void Bind(lua_State * tolua_S);
 
 protected:
+	/** Binds the manually implemented cMetrics API to tolua_S.
+	Implemented in ManualBindings_Metrics.cpp. */
+	static void BindMetrics(lua_State * tolua_S);
+
 	/** Binds the manually implemented cNetwork-related API to tolua_S.
 	Implemented in ManualBindings_Network.cpp. */
 	static void BindNetwork(lua_State * tolua_S);
@@ -842,6 +842,98 @@ static int tolua_cBlockArea_Write(lua_State * a_LuaState)
 
 
 
+/** Binding for the cBlockArea:WriteInSteps() function. Supports the same overloads as Write(), plus an optional callback. */
+static int tolua_cBlockArea_WriteInSteps(lua_State * a_LuaState)
+{
+	// Function signatures:
+	// BlockArea:WriteInSteps(World, MinX, MinY, MinZ, [DataTypes], [OnFinished])
+	// BlockArea:WriteInSteps(World, MinCoords, [DataTypes], [OnFinished])
+
+	// Check the common params:
+	cLuaState L(a_LuaState);
+	if (
+		!L.CheckParamSelf("cBlockArea") ||
+		!L.CheckParamUserType(2, "cWorld")
+	)
+	{
+		return 0;
+	}
+
+	// Get the common params:
+	cBlockArea * self = nullptr;
+	cWorld * world = nullptr;
+	if (!L.GetStackValues(1, self, world))
+	{
+		return L.ApiParamError("Cannot read self or world");
+	}
+	if (world == nullptr)
+	{
+		return L.ApiParamError("Invalid world instance. The world must be not nil");
+	}
+
+	// Check and get the overloaded and optional params:
+	Vector3i coords;
+	int dataTypes = self->GetDataTypes();
+	auto idx = readVector3iOverloadParams(L, 3, coords, "coords");
+	if (L.IsParamNumber(idx))
+	{
+		L.GetStackValue(idx, dataTypes);
+		idx += 1;
+		if (!cBlockArea::IsValidDataTypeCombination(dataTypes))
+		{
+			return L.ApiParamError("Invalid datatype combination (%d)", dataTypes);
+		}
+		if ((self->GetDataTypes() & dataTypes) != dataTypes)
+		{
+			return L.ApiParamError("Requesting datatypes not present in the cBlockArea. Got only 0x%02x, requested 0x%02x",
+				self->GetDataTypes(), dataTypes
+			);
+		}
+	}
+	cLuaState::cCallbackSharedPtr onFinished;
+	if (lua_isfunction(L, idx) && !L.GetStackValue(idx, onFinished))
+	{
+		return L.ApiParamError("Cannot read the OnFinished callback");
+	}
+
+	// Adjust the coord params, same as Write():
+	if (coords.y < 0)
+	{
+		LOGWARNING("cBlockArea:WriteInSteps(): MinBlockY less than zero, adjusting to zero");
+		L.LogStackTrace();
+		coords.y = 0;
+	}
+	else if (coords.y > cChunkDef::Height - self->GetSizeY())
+	{
+		LOGWARNING("cBlockArea:WriteInSteps(): MinBlockY + m_SizeY more than chunk height, adjusting to chunk height");
+		L.LogStackTrace();
+		coords.y = cChunkDef::Height - self->GetSizeY();
+	}
+
+	// The plugin may change the area while it is being written, write a copy of it:
+	auto area = std::make_shared<cBlockArea>();
+	self->CopyTo(*area);
+
+	// Account the callback's time to the plugin that started the write:
+	std::function<void(cWorld &, bool)> onFinishedFn;
+	if (onFinished != nullptr)
+	{
+		auto plugin = cManualBindings::GetLuaPlugin(a_LuaState);
+		auto cpuStats = (plugin == nullptr) ? nullptr : plugin->GetCpuStatsPtr();
+		onFinishedFn = [onFinished, cpuStats](cWorld & a_World, bool a_IsSuccessful)
+		{
+			cPluginCpuStats::cTimer Timer(cpuStats.get(), "WriteInSteps");
+			onFinished->Call(&a_World, a_IsSuccessful);
+		};
+	}
+	world->WriteBlockAreaInSteps(std::move(area), coords, dataTypes, std::move(onFinishedFn));
+	return 0;
+}
+
+
+
+
+
 /** Templated bindings for the GetBlock___() functions.
 DataType is either BLOCKTYPE or NIBBLETYPE.
 DataTypeFlag is the ba___ constant used for the datatype being queried.
@@ -1186,6 +1278,7 @@ void cManualBindings::BindBlockArea(lua_State * a_LuaState)
 			tolua_function(a_LuaState, "SetRelBlockSkyLight",     SetRelBlock<NIBBLETYPE, cBlockArea::baSkyLight, &cBlockArea::SetRelBlockSkyLight>);
 			tolua_function(a_LuaState, "SetRelBlockTypeMeta",     tolua_cBlockArea_SetRelBlockTypeMeta);
 			tolua_function(a_LuaState, "Write",                   tolua_cBlockArea_Write);
+			tolua_function(a_LuaState, "WriteInSteps",            tolua_cBlockArea_WriteInSteps);
 		tolua_endmodule(a_LuaState);
 	tolua_endmodule(a_LuaState);
 }
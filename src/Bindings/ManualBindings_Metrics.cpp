@@ -0,0 +1,252 @@
+// ManualBindings_Metrics.cpp
+
+// Implements the cMetrics Lua bindings
+
+#include "Globals.h"
+#include "ManualBindings.h"
+#include "tolua++/include/tolua++.h"
+#include "LuaState.h"
+#include "../Metrics.h"
+
+
+
+
+
+/** Returns the name of the metric type, as used in the Lua API. */
+static const char * MetricTypeToString(cMetric::eType a_Type)
+{
+	switch (a_Type)
+	{
+		case cMetric::eType::Counter:   return "counter";
+		case cMetric::eType::Gauge:     return "gauge";
+		case cMetric::eType::Histogram: return "histogram";
+	}
+	UNREACHABLE("Unsupported metric type");
+}
+
+
+
+
+
+/** Binds cMetrics::GetCounter() and cMetricCounter::Add() */
+static int tolua_cMetrics_AddCounter(lua_State * L)
+{
+	// Function signature:
+	// cMetrics:AddCounter(Name, Help, Amount, [Labels])
+
+	cLuaState S(L);
+	if (
+		!S.CheckParamStaticSelf("cMetrics") ||
+		!S.CheckParamString(2, 3) ||
+		!S.CheckParamNumber(4) ||
+		!S.CheckParamEnd(6)
+	)
+	{
+		return 0;
+	}
+
+	// Read the params:
+	AString Name, Help;
+	double Amount;
+	AStringMap Labels;
+	if (!S.GetStackValues(2, Name, Help, Amount, cLuaState::cOptionalParam<AStringMap>(Labels)))
+	{
+		return S.ApiParamError("Cannot read the parameters");
+	}
+	if (Amount < 0)
+	{
+		return S.ApiParamError("A counter cannot decrease, the Amount must not be negative");
+	}
+
+	// Add to the counter:
+	try
+	{
+		cMetrics::Get().GetCounter(Name, Help, Labels).Add(static_cast<UInt64>(Amount));
+	}
+	catch (const std::logic_error & exc)
+	{
+		return S.ApiParamError(exc.what());
+	}
+	return 0;
+}
+
+
+
+
+
+/** Binds cMetrics::GetPrometheusText() */
+static int tolua_cMetrics_GetPrometheusText(lua_State * L)
+{
+	// Function signature:
+	// cMetrics:GetPrometheusText() -> string
+
+	cLuaState S(L);
+	if (
+		!S.CheckParamStaticSelf("cMetrics") ||
+		!S.CheckParamEnd(2)
+	)
+	{
+		return 0;
+	}
+
+	S.Push(cMetrics::Get().GetPrometheusText());
+	return 1;
+}
+
+
+
+
+
+/** Binds cMetrics::GetSamples() */
+static int tolua_cMetrics_GetSamples(lua_State * L)
+{
+	// Function signature:
+	// cMetrics:GetSamples() -> { {Name = "", Labels = {}, Type = "", Value = 0, Sum = 0, P50 = 0, P90 = 0, P99 = 0, Max = 0}, ... }
+
+	cLuaState S(L);
+	if (
+		!S.CheckParamStaticSelf("cMetrics") ||
+		!S.CheckParamEnd(2)
+	)
+	{
+		return 0;
+	}
+
+	auto Samples = cMetrics::Get().GetSamples();
+	lua_createtable(L, static_cast<int>(Samples.size()), 0);
+	int Index = 1;
+	for (const auto & Sample: Samples)
+	{
+		lua_createtable(L, 0, 9);
+		S.Push(Sample.m_Name);
+		lua_setfield(L, -2, "Name");
+		S.Push(Sample.m_Labels);
+		lua_setfield(L, -2, "Labels");
+		S.Push(MetricTypeToString(Sample.m_Type));
+		lua_setfield(L, -2, "Type");
+		S.Push(Sample.m_Value);
+		lua_setfield(L, -2, "Value");
+		if (Sample.m_Type == cMetric::eType::Histogram)
+		{
+			S.Push(Sample.m_Sum);
+			lua_setfield(L, -2, "Sum");
+			S.Push(Sample.m_P50);
+			lua_setfield(L, -2, "P50");
+			S.Push(Sample.m_P90);
+			lua_setfield(L, -2, "P90");
+			S.Push(Sample.m_P99);
+			lua_setfield(L, -2, "P99");
+			S.Push(Sample.m_Max);
+			lua_setfield(L, -2, "Max");
+		}
+		lua_rawseti(L, -2, Index);
+		++Index;
+	}
+	return 1;
+}
+
+
+
+
+
+/** Binds cMetrics::GetHistogram() and cMetricHistogram::Record() */
+static int tolua_cMetrics_RecordDuration(lua_State * L)
+{
+	// Function signature:
+	// cMetrics:RecordDuration(Name, Help, Seconds, [Labels])
+
+	cLuaState S(L);
+	if (
+		!S.CheckParamStaticSelf("cMetrics") ||
+		!S.CheckParamString(2, 3) ||
+		!S.CheckParamNumber(4) ||
+		!S.CheckParamEnd(6)
+	)
+	{
+		return 0;
+	}
+
+	// Read the params:
+	AString Name, Help;
+	double Seconds;
+	AStringMap Labels;
+	if (!S.GetStackValues(2, Name, Help, Seconds, cLuaState::cOptionalParam<AStringMap>(Labels)))
+	{
+		return S.ApiParamError("Cannot read the parameters");
+	}
+
+	// Record into the histogram:
+	try
+	{
+		cMetrics::Get().GetHistogram(Name, Help, Labels).Record(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(Seconds))
+		);
+	}
+	catch (const std::logic_error & exc)
+	{
+		return S.ApiParamError(exc.what());
+	}
+	return 0;
+}
+
+
+
+
+
+/** Binds cMetrics::GetGauge() and cMetricGauge::Set() */
+static int tolua_cMetrics_SetGauge(lua_State * L)
+{
+	// Function signature:
+	// cMetrics:SetGauge(Name, Help, Value, [Labels])
+
+	cLuaState S(L);
+	if (
+		!S.CheckParamStaticSelf("cMetrics") ||
+		!S.CheckParamString(2, 3) ||
+		!S.CheckParamNumber(4) ||
+		!S.CheckParamEnd(6)
+	)
+	{
+		return 0;
+	}
+
+	// Read the params:
+	AString Name, Help;
+	double Value;
+	AStringMap Labels;
+	if (!S.GetStackValues(2, Name, Help, Value, cLuaState::cOptionalParam<AStringMap>(Labels)))
+	{
+		return S.ApiParamError("Cannot read the parameters");
+	}
+
+	// Set the gauge:
+	try
+	{
+		cMetrics::Get().GetGauge(Name, Help, Labels).Set(static_cast<Int64>(Value));
+	}
+	catch (const std::logic_error & exc)
+	{
+		return S.ApiParamError(exc.what());
+	}
+	return 0;
+}
+
+
+
+
+
+void cManualBindings::BindMetrics(lua_State * tolua_S)
+{
+	// Create the cMetrics class in the API:
+	tolua_usertype(tolua_S, "cMetrics");
+	tolua_cclass(tolua_S, "cMetrics", "cMetrics", "", nullptr);
+
+	// Fill in the functions (alpha-sorted):
+	tolua_beginmodule(tolua_S, "cMetrics");
+		tolua_function(tolua_S, "AddCounter",        tolua_cMetrics_AddCounter);
+		tolua_function(tolua_S, "GetPrometheusText", tolua_cMetrics_GetPrometheusText);
+		tolua_function(tolua_S, "GetSamples",        tolua_cMetrics_GetSamples);
+		tolua_function(tolua_S, "RecordDuration",    tolua_cMetrics_RecordDuration);
+		tolua_function(tolua_S, "SetGauge",          tolua_cMetrics_SetGauge);
+	tolua_endmodule(tolua_S);
+}
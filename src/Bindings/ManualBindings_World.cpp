@@ -1412,8 +1412,12 @@ static int tolua_cWorld_QueueTask(lua_State * tolua_S)
 		return cManualBindings::lua_do_error(tolua_S, "Error in function call '#funcname#': Could not store the callback parameter");
 	}
 
-	World->QueueTask([Task](cWorld & a_World)
+	// Account the task's time to the plugin that queued it:
+	auto Plugin = cManualBindings::GetLuaPlugin(tolua_S);
+	auto CpuStats = (Plugin == nullptr) ? nullptr : Plugin->GetCpuStatsPtr();
+	World->QueueTask([Task, CpuStats](cWorld & a_World)
 		{
+			cPluginCpuStats::cTimer Timer(CpuStats.get(), "QueueTask");
 			Task->Call(&a_World);
 		}
 	);
@@ -1585,8 +1589,12 @@ static int tolua_cWorld_ScheduleTask(lua_State * tolua_S)
 		return cManualBindings::lua_do_error(tolua_S, "Error in function call '#funcname#': Could not store the callback parameter");
 	}
 
-	World->ScheduleTask(cTickTime(NumTicks), [Task](cWorld & a_World)
+	// Account the task's time to the plugin that queued it:
+	auto Plugin = cManualBindings::GetLuaPlugin(tolua_S);
+	auto CpuStats = (Plugin == nullptr) ? nullptr : Plugin->GetCpuStatsPtr();
+	World->ScheduleTask(cTickTime(NumTicks), [Task, CpuStats](cWorld & a_World)
 		{
+			cPluginCpuStats::cTimer Timer(CpuStats.get(), "ScheduleTask");
 			Task->Call(&a_World);
 		}
 	);
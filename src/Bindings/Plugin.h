@@ -11,6 +11,7 @@
 
 #include "../Defines.h"
 #include "PluginManager.h"
+#include "PluginCpuStats.h"
 
 
 
@@ -116,7 +117,7 @@ public:
 
 	// tolua_begin
 	const AString & GetName(void) const  { return m_Name; }
-	void SetName(const AString & a_Name) { m_Name = a_Name; }
+	void SetName(const AString & a_Name) { m_Name = a_Name; m_CpuStats->SetPluginName(a_Name); }
 
 	int GetVersion(void) const     { return m_Version; }
 	void SetVersion(int a_Version) { m_Version = a_Version; }
@@ -138,6 +139,12 @@ public:
 	// Needed for ManualBindings' tolua_ForEach<>
 	static const char * GetClassStatic(void) { return "cPlugin"; }
 
+	/** Returns the accounting of the time spent in the plugin's callbacks. */
+	cPluginCpuStats & GetCpuStats(void) { return *m_CpuStats; }
+
+	/** Returns the accounting of the time spent in the plugin's callbacks, for the callbacks that may outlive the plugin. */
+	const std::shared_ptr<cPluginCpuStats> & GetCpuStatsPtr(void) const { return m_CpuStats; }
+
 protected:
 	friend class cPluginManager;
 
@@ -155,6 +162,10 @@ protected:
 	Only valid if m_Status == psError. */
 	AString m_LoadError;
 
+	/** The time spent in the plugin's callbacks.
+	Shared with the world tasks, command handlers and webadmin tabs that the plugin registers. */
+	std::shared_ptr<cPluginCpuStats> m_CpuStats;
+
 
 	/** Sets m_LoadError to the specified string and m_Status to psError. */
 	void SetLoadError(const AString & a_LoadError);
@@ -0,0 +1,378 @@
+
+// PluginCpuStats.cpp
+
+// Implements the cPluginCpuStats class that accounts the time a plugin spends in each of its callbacks
+
+#include "Globals.h"
+#include "PluginCpuStats.h"
+#include "../Metrics.h"
+
+
+
+
+
+/** Returns the duration in milliseconds, for the reports. */
+static double ToMSec(std::chrono::nanoseconds a_Duration)
+{
+	return static_cast<double>(a_Duration.count()) / 1000000;
+}
+
+
+
+
+
+/** Returns the note appended to a budget warning about the number of the preceding warnings that were suppressed. */
+static AString FormatSuppressed(UInt64 a_NumSuppressed)
+{
+	if (a_NumSuppressed == 0)
+	{
+		return {};
+	}
+	return fmt::format(FMT_STRING(" ({} more such warnings suppressed)"), a_NumSuppressed);
+}
+
+
+
+
+
+/** Raises the atomic value to a_Value, if it is lower. */
+static void UpdateMax(std::atomic<Int64> & a_Max, Int64 a_Value)
+{
+	// Most of the time the value is lower and this is a single load:
+	auto Max = a_Max.load(std::memory_order_relaxed);
+	while ((a_Value > Max) && !a_Max.compare_exchange_weak(Max, a_Value, std::memory_order_relaxed))
+	{
+	}
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cPluginCpuStats::sCallback:
+
+cPluginCpuStats::sStats cPluginCpuStats::sCallback::GetStats(void) const
+{
+	sStats res;
+	res.m_Name = m_Name;
+	res.m_NumCalls = m_NumCalls.load(std::memory_order_relaxed);
+	res.m_TotalTime = std::chrono::nanoseconds(m_TotalTime.load(std::memory_order_relaxed));
+	res.m_MaxCallTime = std::chrono::nanoseconds(m_MaxCallTime.load(std::memory_order_relaxed));
+	res.m_LastTickTime = m_LastTickTime;
+	res.m_MaxTickTime = m_MaxTickTime;
+	return res;
+}
+
+
+
+
+
+void cPluginCpuStats::sCallback::Clear(void)
+{
+	m_NumCalls.store(0, std::memory_order_relaxed);
+	m_TotalTime.store(0, std::memory_order_relaxed);
+	m_MaxCallTime.store(0, std::memory_order_relaxed);
+	m_CurrentTickTime.store(0, std::memory_order_relaxed);
+	m_LastTickTime = std::chrono::nanoseconds(0);
+	m_MaxTickTime = std::chrono::nanoseconds(0);
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cPluginCpuStats:
+
+cPluginCpuStats::cPluginCpuStats(const AString & a_PluginName):
+	m_PluginName(a_PluginName),
+	m_CallBudget(0),
+	m_TickBudget(0)
+{
+	for (auto & HookCallback: m_HookCallbacks)
+	{
+		HookCallback.store(nullptr, std::memory_order_relaxed);
+	}
+	m_Totals.m_Name = a_PluginName;
+	m_Totals.m_Metric = &cMetrics::Get().GetHistogram("cuberite_plugin_tick_seconds", "The time spent in the plugin's callbacks in each server tick", {{"plugin", a_PluginName}});
+}
+
+
+
+
+
+void cPluginCpuStats::SetPluginName(const AString & a_PluginName)
+{
+	cCSLock Lock(m_CS);
+	if (a_PluginName == m_PluginName)
+	{
+		return;
+	}
+	m_PluginName = a_PluginName;
+	m_Totals.m_Name = a_PluginName;
+	m_Totals.m_Metric = &cMetrics::Get().GetHistogram("cuberite_plugin_tick_seconds", "The time spent in the plugin's callbacks in each server tick", {{"plugin", a_PluginName}});
+	for (auto & Callback: m_Callbacks)
+	{
+		Callback.second.m_Metric = GetCallbackMetric(Callback.first);
+	}
+}
+
+
+
+
+
+void cPluginCpuStats::SetBudgets(std::chrono::milliseconds a_CallBudget, std::chrono::milliseconds a_TickBudget)
+{
+	cCSLock Lock(m_CS);
+	m_CallBudget = std::chrono::duration_cast<std::chrono::nanoseconds>(a_CallBudget).count();
+	m_TickBudget = a_TickBudget;
+}
+
+
+
+
+
+void cPluginCpuStats::Record(std::string_view a_Callback, std::chrono::nanoseconds a_Duration)
+{
+	RecordCall(GetCallback(a_Callback), a_Duration);
+}
+
+
+
+
+
+void cPluginCpuStats::RecordHook(size_t a_HookIndex, const char * a_HookName, std::chrono::nanoseconds a_Duration)
+{
+	ASSERT(a_HookIndex < NumHookSlots);
+	auto Callback = m_HookCallbacks[a_HookIndex].load(std::memory_order_acquire);
+	if (Callback == nullptr)
+	{
+		// The hook's first call, look its callback up. Racing threads find the same one:
+		Callback = &GetCallback(a_HookName);
+		m_HookCallbacks[a_HookIndex].store(Callback, std::memory_order_release);
+	}
+	RecordCall(*Callback, a_Duration);
+}
+
+
+
+
+
+void cPluginCpuStats::EndTick(void)
+{
+	std::chrono::nanoseconds TickTime, TickBudget;
+	cMetricHistogram * Metric;
+	bool ShouldLog;
+	UInt64 NumSuppressed = 0;
+	AString PluginName;
+	{
+		cCSLock Lock(m_CS);
+		auto FinishTick = [](sCallback & a_Callback)
+		{
+			const std::chrono::nanoseconds CurrentTickTime(a_Callback.m_CurrentTickTime.exchange(0, std::memory_order_relaxed));
+			a_Callback.m_LastTickTime = CurrentTickTime;
+			a_Callback.m_MaxTickTime = std::max(a_Callback.m_MaxTickTime, CurrentTickTime);
+			return CurrentTickTime;
+		};
+		for (auto & Callback: m_Callbacks)
+		{
+			FinishTick(Callback.second);
+		}
+		TickTime = FinishTick(m_Totals);
+		Metric = m_Totals.m_Metric;
+		TickBudget = m_TickBudget;
+		ShouldLog = (TickBudget.count() > 0) && (TickTime > TickBudget) && ShouldWarn(m_Totals, NumSuppressed);
+		if (ShouldLog)
+		{
+			PluginName = m_PluginName;
+		}
+	}
+
+	Metric->Record(TickTime);
+	if (ShouldLog)
+	{
+		FLOGWARNING("Plugin {} spent {:.2f} ms in a single tick, over the budget of {:.2f} ms{}",
+			PluginName, ToMSec(TickTime), ToMSec(TickBudget), FormatSuppressed(NumSuppressed)
+		);
+	}
+}
+
+
+
+
+
+cPluginCpuStats::sStats cPluginCpuStats::GetTotals(void)
+{
+	cCSLock Lock(m_CS);
+	return m_Totals.GetStats();
+}
+
+
+
+
+
+std::vector<cPluginCpuStats::sStats> cPluginCpuStats::GetCallbacks(void)
+{
+	std::vector<sStats> res;
+	{
+		cCSLock Lock(m_CS);
+		res.reserve(m_Callbacks.size());
+		for (const auto & Callback: m_Callbacks)
+		{
+			// The callbacks are kept after a reset, skip those not called since:
+			auto Stats = Callback.second.GetStats();
+			if (Stats.m_NumCalls > 0)
+			{
+				res.push_back(std::move(Stats));
+			}
+		}
+	}
+	std::stable_sort(res.begin(), res.end(), [](const sStats & a_First, const sStats & a_Second)
+		{
+			return (a_First.m_TotalTime > a_Second.m_TotalTime);
+		}
+	);
+	return res;
+}
+
+
+
+
+
+AString cPluginCpuStats::GetReport(size_t a_NumTopCallbacks)
+{
+	auto Totals = GetTotals();
+	auto Callbacks = GetCallbacks();
+	AString res = FormatStats(Totals);
+	for (size_t i = 0; (i < Callbacks.size()) && (i < a_NumTopCallbacks); i++)
+	{
+		res.append("  ");
+		res.append(FormatStats(Callbacks[i]));
+	}
+	if (Callbacks.size() > a_NumTopCallbacks)
+	{
+		res.append(fmt::format(FMT_STRING("  ... and {} more callbacks\n"), Callbacks.size() - a_NumTopCallbacks));
+	}
+	return res;
+}
+
+
+
+
+
+void cPluginCpuStats::Reset(void)
+{
+	// The callbacks are only cleared, RecordHook() may be holding pointers to them:
+	cCSLock Lock(m_CS);
+	for (auto & Callback: m_Callbacks)
+	{
+		Callback.second.Clear();
+	}
+	m_Totals.Clear();
+}
+
+
+
+
+
+cPluginCpuStats::sCallback & cPluginCpuStats::GetCallback(std::string_view a_Callback)
+{
+	cCSLock Lock(m_CS);
+	auto itr = m_Callbacks.find(a_Callback);
+	if (itr == m_Callbacks.end())
+	{
+		AString Name(a_Callback);
+		itr = m_Callbacks.emplace(std::piecewise_construct, std::forward_as_tuple(Name), std::forward_as_tuple()).first;
+		itr->second.m_Name = Name;
+		itr->second.m_Metric = GetCallbackMetric(Name);
+	}
+	return itr->second;
+}
+
+
+
+
+
+void cPluginCpuStats::RecordCall(sCallback & a_Callback, std::chrono::nanoseconds a_Duration)
+{
+	const auto Duration = static_cast<Int64>(a_Duration.count());
+	for (auto Callback: {&a_Callback, &m_Totals})
+	{
+		Callback->m_NumCalls.fetch_add(1, std::memory_order_relaxed);
+		Callback->m_TotalTime.fetch_add(Duration, std::memory_order_relaxed);
+		Callback->m_CurrentTickTime.fetch_add(Duration, std::memory_order_relaxed);
+		UpdateMax(Callback->m_MaxCallTime, Duration);
+	}
+	a_Callback.m_Metric.load(std::memory_order_relaxed)->Record(a_Duration);
+
+	// Only the calls over the budget need the lock, for the warning bookkeeping:
+	const auto CallBudget = m_CallBudget.load(std::memory_order_relaxed);
+	if ((CallBudget <= 0) || (Duration <= CallBudget))
+	{
+		return;
+	}
+	UInt64 NumSuppressed = 0;
+	AString PluginName;
+	{
+		cCSLock Lock(m_CS);
+		if (!ShouldWarn(a_Callback, NumSuppressed))
+		{
+			return;
+		}
+		PluginName = m_PluginName;
+	}
+	FLOGWARNING("Plugin {}: {} took {:.2f} ms, over the budget of {:.2f} ms{}",
+		PluginName, a_Callback.m_Name, ToMSec(a_Duration), ToMSec(std::chrono::nanoseconds(CallBudget)), FormatSuppressed(NumSuppressed)
+	);
+}
+
+
+
+
+
+cMetricHistogram * cPluginCpuStats::GetCallbackMetric(const AString & a_Callback)
+{
+	return &cMetrics::Get().GetHistogram("cuberite_plugin_callback_seconds", "The time spent in a single call of the plugin's callback",
+		{{"plugin", m_PluginName}, {"callback", a_Callback}}
+	);
+}
+
+
+
+
+
+bool cPluginCpuStats::ShouldWarn(sCallback & a_Callback, UInt64 & a_NumSuppressed)
+{
+	auto Now = std::chrono::steady_clock::now();
+	if ((a_Callback.m_LastWarning.time_since_epoch().count() != 0) && (Now - a_Callback.m_LastWarning < WarningInterval))
+	{
+		a_Callback.m_NumSuppressedWarnings += 1;
+		return false;
+	}
+	a_NumSuppressed = a_Callback.m_NumSuppressedWarnings;
+	a_Callback.m_NumSuppressedWarnings = 0;
+	a_Callback.m_LastWarning = Now;
+	return true;
+}
+
+
+
+
+
+AString cPluginCpuStats::FormatStats(const sStats & a_Stats)
+{
+	return fmt::format(FMT_STRING("{}: {} calls, total {:.2f} ms, avg {:.3f} ms, max {:.3f} ms; per tick last {:.3f} ms, max {:.3f} ms\n"),
+		a_Stats.m_Name,
+		a_Stats.m_NumCalls,
+		ToMSec(a_Stats.m_TotalTime),
+		(a_Stats.m_NumCalls == 0) ? 0.0 : ToMSec(a_Stats.m_TotalTime) / a_Stats.m_NumCalls,
+		ToMSec(a_Stats.m_MaxCallTime),
+		ToMSec(a_Stats.m_LastTickTime),
+		ToMSec(a_Stats.m_MaxTickTime)
+	);
+}
+
+
+
+
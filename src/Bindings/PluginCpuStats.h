@@ -0,0 +1,202 @@
+
+// PluginCpuStats.h
+
+// Declares the cPluginCpuStats class that accounts the time a plugin spends in each of its callbacks
+
+/*
+Each plugin owns a cPluginCpuStats object. The server times each of its calls into the plugin - the hooks, the world tasks,
+the command handlers and the webadmin tabs - and records it under the callback's name, such as "OnPlayerMoving" or
+"Command /spawn". The times are inclusive: if a callback calls into another plugin, the time spent there is counted, too.
+The server tick calls EndTick() for all the plugins, so that the per-tick times are the times spent in each server tick
+interval (50 ms), regardless of which thread the callbacks ran on.
+Recording a call only updates atomic counters. The hooks, called the most often, additionally have their callback cached
+by the hook's index, so that recording them needs no lock and no name lookup.
+Each callback's times are also recorded into the cuberite_plugin_callback_seconds histogram in cMetrics, and each tick's
+total into cuberite_plugin_tick_seconds.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../OSSupport/CriticalSection.h"
+
+
+
+
+
+// fwd:
+class cMetricHistogram;
+
+
+
+
+
+class cPluginCpuStats
+{
+public:
+
+	/** The statistics of a single callback, or of the whole plugin. */
+	struct sStats
+	{
+		AString m_Name;
+		UInt64 m_NumCalls = 0;
+		std::chrono::nanoseconds m_TotalTime{0};
+
+		/** The longest single call. */
+		std::chrono::nanoseconds m_MaxCallTime{0};
+
+		/** The time spent in the last finished tick. */
+		std::chrono::nanoseconds m_LastTickTime{0};
+
+		/** The longest time spent in a single tick. */
+		std::chrono::nanoseconds m_MaxTickTime{0};
+	};
+
+
+	/** Records the time between its construction and destruction as a single call of the callback.
+	Records nothing if constructed with nullptr stats, for the callbacks that don't belong to a plugin.
+	The callback name is not copied, it needs to outlive the timer. */
+	class cTimer
+	{
+	public:
+
+		cTimer(cPluginCpuStats * a_Stats, std::string_view a_Callback):
+			m_Stats(a_Stats),
+			m_Callback(a_Callback),
+			m_Start(std::chrono::steady_clock::now())
+		{
+		}
+
+		~cTimer()
+		{
+			if (m_Stats != nullptr)
+			{
+				m_Stats->Record(m_Callback, std::chrono::steady_clock::now() - m_Start);
+			}
+		}
+
+	protected:
+
+		cPluginCpuStats * m_Stats;
+		std::string_view m_Callback;
+		std::chrono::steady_clock::time_point m_Start;
+	};
+
+
+	/** The shortest interval between two budget warnings about the same callback, or about the plugin's ticks. */
+	static constexpr std::chrono::seconds WarningInterval{10};
+
+	/** The number of the hook indices for which RecordHook() caches the callback. */
+	static constexpr size_t NumHookSlots = 128;
+
+
+	cPluginCpuStats(const AString & a_PluginName);
+
+	/** Changes the plugin name under which the times are logged and recorded in cMetrics. */
+	void SetPluginName(const AString & a_PluginName);
+
+	/** Sets the budgets over which a single call, and the plugin's total time in a single tick, is logged as a warning.
+	Zero disables the respective warning. */
+	void SetBudgets(std::chrono::milliseconds a_CallBudget, std::chrono::milliseconds a_TickBudget);
+
+	/** Records a single call of the specified callback. May be called from any thread. */
+	void Record(std::string_view a_Callback, std::chrono::nanoseconds a_Duration);
+
+	/** Records a single call of the handler of the hook with the specified index (cPluginManager::PluginHook), named a_HookName.
+	The callback is looked up by its name only in the hook's first call, the following calls take no lock.
+	a_HookIndex needs to be less than NumHookSlots, and always come with the same a_HookName. May be called from any thread. */
+	void RecordHook(size_t a_HookIndex, const char * a_HookName, std::chrono::nanoseconds a_Duration);
+
+	/** Finishes the current tick, moving the times recorded since the last call into the per-tick statistics. */
+	void EndTick(void);
+
+	/** Returns the statistics of the whole plugin. */
+	sStats GetTotals(void);
+
+	/** Returns the statistics of all the callbacks called so far, the ones with the longest total time first. */
+	std::vector<sStats> GetCallbacks(void);
+
+	/** Returns the statistics of the plugin and of its a_NumTopCallbacks callbacks with the longest total time,
+	as text for the "pluginstats" console command. */
+	AString GetReport(size_t a_NumTopCallbacks);
+
+	/** Clears all the statistics. The cMetrics histograms are not affected. */
+	void Reset(void);
+
+protected:
+
+	/** The statistics of a callback, or of the whole plugin, with the bookkeeping of the current tick and the warnings.
+	The call counters and the histogram are atomic, so that a call is recorded without locking; the rest is protected by m_CS.
+	The durations are in nanoseconds. */
+	struct sCallback
+	{
+		AString m_Name;
+		std::atomic<UInt64> m_NumCalls{0};
+		std::atomic<Int64> m_TotalTime{0};
+		std::atomic<Int64> m_MaxCallTime{0};
+
+		/** The time spent since the start of the current tick. */
+		std::atomic<Int64> m_CurrentTickTime{0};
+
+		std::chrono::nanoseconds m_LastTickTime{0};
+		std::chrono::nanoseconds m_MaxTickTime{0};
+
+		/** The time of the last budget warning, and the number of warnings suppressed since then. */
+		std::chrono::steady_clock::time_point m_LastWarning;
+		UInt64 m_NumSuppressedWarnings = 0;
+
+		/** The histogram in cMetrics into which the calls (or the plugin's ticks) are recorded. */
+		std::atomic<cMetricHistogram *> m_Metric{nullptr};
+
+		/** Returns the current statistics. */
+		sStats GetStats(void) const;
+
+		/** Clears the statistics, keeping the name and the histogram. */
+		void Clear(void);
+	};
+
+
+	/** Protects the members against multithreaded access, except for the atomic ones. */
+	cCriticalSection m_CS;
+
+	AString m_PluginName;
+
+	/** The budgets, in nanoseconds. */
+	std::atomic<Int64> m_CallBudget;
+	std::chrono::nanoseconds m_TickBudget;
+
+	/** The statistics of the individual callbacks, indexed by their name.
+	The items are never removed, so that the pointers to them stay valid. */
+	std::map<AString, sCallback, std::less<>> m_Callbacks;
+
+	/** The callbacks of the hooks, indexed by the hook index given to RecordHook(); nullptr until the hook's first call. */
+	std::array<std::atomic<sCallback *>, NumHookSlots> m_HookCallbacks;
+
+	/** The statistics of the whole plugin. */
+	sCallback m_Totals;
+
+
+	/** Returns the statistics of the specified callback, creating them on its first call. Locks m_CS. */
+	sCallback & GetCallback(std::string_view a_Callback);
+
+	/** Records a single call of the callback into its statistics and into the plugin's totals.
+	Takes no lock, unless the call is over the budget. */
+	void RecordCall(sCallback & a_Callback, std::chrono::nanoseconds a_Duration);
+
+	/** Returns the histogram in cMetrics for the specified callback of this plugin. */
+	cMetricHistogram * GetCallbackMetric(const AString & a_Callback);
+
+	/** Returns true if a budget warning about the callback should be logged now, updating its warning bookkeeping.
+	a_NumSuppressed receives the number of the warnings suppressed since the last one. */
+	static bool ShouldWarn(sCallback & a_Callback, UInt64 & a_NumSuppressed);
+
+	/** Returns the statistics formatted as a single line of the report. */
+	static AString FormatStats(const sStats & a_Stats);
+};
+
+
+
+
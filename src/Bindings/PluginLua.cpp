@@ -17,6 +17,8 @@
 #include "../Item.h"
 #include "../Root.h"
 #include "../WebAdmin.h"
+#include "../World.h"
+#include "../Entities/Player.h"
 
 #include "lua/src/lauxlib.h"
 
@@ -58,7 +60,8 @@ void cPluginLua::Close(void)
 	// If already closed, bail out:
 	if (!op().IsValid())
 	{
-		ASSERT(m_HookMap.empty());
+		ASSERT(std::all_of(m_HookMap.begin(), m_HookMap.end(), [](const cLuaCallbacks & a_Callbacks) { return a_Callbacks.empty(); }));
+		ASSERT(m_RateLimitedHooks.empty());
 		return;
 	}
 
@@ -66,7 +69,11 @@ void cPluginLua::Close(void)
 	ClearWebTabs();
 
 	// Release all the references in the hook map:
-	m_HookMap.clear();
+	for (auto & Callbacks: m_HookMap)
+	{
+		Callbacks.clear();
+	}
+	m_RateLimitedHooks.clear();
 
 	// Close the Lua engine:
 	op().Close();
@@ -208,7 +215,22 @@ void cPluginLua::OnDisable(void)
 
 void cPluginLua::Tick(float a_Dt)
 {
+	cOperation op(*this);
 	CallSimpleHooks(cPluginManager::HOOK_TICK, a_Dt);
+
+	auto Now = std::chrono::steady_clock::now();
+	for (auto & Hook: m_RateLimitedHooks)
+	{
+		if (Hook.m_HookType != cPluginManager::HOOK_TICK)
+		{
+			continue;
+		}
+		float Dt;
+		if (Hook.m_Limiter.Trigger(0, a_Dt, Now, Dt))
+		{
+			Hook.m_Callback->Call(Dt);
+		}
+	}
 }
 
 
@@ -673,7 +695,29 @@ bool cPluginLua::OnPlayerLeftClick(cPlayer & a_Player, int a_BlockX, int a_Block
 
 bool cPluginLua::OnPlayerMoving(cPlayer & a_Player, const Vector3d & a_OldPosition, const Vector3d & a_NewPosition, bool a_PreviousIsOnGround)
 {
-	return CallSimpleHooks(cPluginManager::HOOK_PLAYER_MOVING, &a_Player, a_OldPosition, a_NewPosition, a_PreviousIsOnGround);
+	cOperation op(*this);
+	if (CallSimpleHooks(cPluginManager::HOOK_PLAYER_MOVING, &a_Player, a_OldPosition, a_NewPosition, a_PreviousIsOnGround))
+	{
+		return true;
+	}
+
+	// The rate-limited callbacks only observe the moves that went through, coalesced; their return value is ignored:
+	auto Now = std::chrono::steady_clock::now();
+	const auto World = static_cast<UInt64>(reinterpret_cast<uintptr_t>(a_Player.GetWorld()));
+	const cHookRateLimiter::sMove Move{a_OldPosition, a_NewPosition, a_PreviousIsOnGround};
+	for (auto & Hook: m_RateLimitedHooks)
+	{
+		if (Hook.m_HookType != cPluginManager::HOOK_PLAYER_MOVING)
+		{
+			continue;
+		}
+		cHookRateLimiter::sMove Coalesced;
+		if (Hook.m_Limiter.TriggerMove(a_Player.GetUniqueID(), World, Move, Now, Coalesced))
+		{
+			Hook.m_Callback->Call(&a_Player, Coalesced.m_OldPosition, Coalesced.m_NewPosition, Coalesced.m_PreviousIsOnGround);
+		}
+	}
+	return false;
 }
 
 
@@ -1038,7 +1082,59 @@ bool cPluginLua::OnWorldStarted(cWorld & a_World)
 
 bool cPluginLua::OnWorldTick(cWorld & a_World, std::chrono::milliseconds a_Dt, std::chrono::milliseconds a_LastTickDurationMSec)
 {
-	return CallSimpleHooks(cPluginManager::HOOK_WORLD_TICK, &a_World, a_Dt, a_LastTickDurationMSec);
+	cOperation op(*this);
+	auto Now = std::chrono::steady_clock::now();
+	const auto World = static_cast<UInt64>(reinterpret_cast<uintptr_t>(&a_World));
+
+	// Flush the coalesced moves of the players in this world that have stopped moving, so that the plugin learns their final position:
+	cHookRateLimiter::cSubjectMoves Moves;
+	for (auto & Hook: m_RateLimitedHooks)
+	{
+		if (Hook.m_HookType != cPluginManager::HOOK_PLAYER_MOVING)
+		{
+			continue;
+		}
+		Moves.clear();
+		Hook.m_Limiter.FlushMoves(World, Now, Moves);
+		for (const auto & Move: Moves)
+		{
+			a_World.DoWithEntityByID(static_cast<UInt32>(Move.first), [&](cEntity & a_Entity)
+				{
+					if (a_Entity.IsPlayer())
+					{
+						Hook.m_Callback->Call(static_cast<cPlayer *>(&a_Entity), Move.second.m_OldPosition, Move.second.m_NewPosition, Move.second.m_PreviousIsOnGround);
+					}
+					return true;
+				}
+			);
+		}
+	}
+
+	if (CallSimpleHooks(cPluginManager::HOOK_WORLD_TICK, &a_World, a_Dt, a_LastTickDurationMSec))
+	{
+		return true;
+	}
+
+	for (auto & Hook: m_RateLimitedHooks)
+	{
+		if (Hook.m_HookType != cPluginManager::HOOK_WORLD_TICK)
+		{
+			continue;
+		}
+		float DtMSec;
+		if (!Hook.m_Limiter.Trigger(World, static_cast<float>(a_Dt.count()), Now, DtMSec))
+		{
+			continue;
+		}
+		bool res = false;
+		auto Dt = std::chrono::milliseconds(static_cast<std::chrono::milliseconds::rep>(DtMSec));
+		Hook.m_Callback->Call(&a_World, Dt, a_LastTickDurationMSec, cLuaState::Return, res);
+		if (res)
+		{
+			return true;
+		}
+	}
+	return false;
 }
 
 
@@ -1154,7 +1250,27 @@ const char * cPluginLua::GetHookFnName(int a_HookType)
 
 bool cPluginLua::AddHookCallback(int a_HookType, cLuaState::cCallbackPtr && a_Callback)
 {
-	m_HookMap[a_HookType].push_back(std::move(a_Callback));
+	cOperation op(*this);
+	m_HookMap[static_cast<size_t>(a_HookType)].push_back(std::move(a_Callback));
+	return true;
+}
+
+
+
+
+
+bool cPluginLua::AddHookCallback(int a_HookType, cLuaState::cCallbackPtr && a_Callback, std::chrono::milliseconds a_MinInterval)
+{
+	if (!cHookRateLimiter::IsSupported(a_HookType))
+	{
+		LOGWARNING("Plugin %s wants to add a rate-limited callback for hook %s, which only supports HOOK_PLAYER_MOVING, HOOK_WORLD_TICK and HOOK_TICK.",
+			GetName().c_str(), (GetHookFnName(a_HookType) == nullptr) ? "<unknown>" : GetHookFnName(a_HookType)
+		);
+		return false;
+	}
+
+	cOperation op(*this);
+	m_RateLimitedHooks.emplace_back(a_HookType, std::move(a_Callback), a_MinInterval);
 	return true;
 }
 
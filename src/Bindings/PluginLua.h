@@ -11,6 +11,7 @@
 
 #include "Plugin.h"
 #include "LuaState.h"
+#include "HookRateLimiter.h"
 
 // Names for the global variables through which the plugin is identified in its LuaState
 #define LUA_PLUGIN_NAME_VAR_NAME     "_CuberiteInternal_PluginName"
@@ -146,6 +147,13 @@ public:
 	Returns true if the hook was added successfully. */
 	bool AddHookCallback(int a_HookType, cLuaState::cCallbackPtr && a_Callback);
 
+	/** Adds a Lua callback to be called for the specified hook at most once per a_MinInterval for each subject of the hook.
+	The calls that come sooner are coalesced into the next call that is made, which reports the summed time delta or the whole move.
+	Only HOOK_PLAYER_MOVING (per player, observe-only), HOOK_WORLD_TICK (per world) and HOOK_TICK are supported, see cHookRateLimiter;
+	returns false for the other hook types. For HOOK_PLAYER_MOVING the caller needs to register the plugin for HOOK_WORLD_TICK as well,
+	the moves of the players that have stopped moving are flushed from there. */
+	bool AddHookCallback(int a_HookType, cLuaState::cCallbackPtr && a_Callback, std::chrono::milliseconds a_MinInterval);
+
 	/** Calls a function in this plugin's LuaState with parameters copied over from a_ForeignState.
 	The values that the function returns are placed onto a_ForeignState.
 	Returns the number of values returned, if successful, or negative number on failure. */
@@ -167,8 +175,23 @@ protected:
 	/** Provides an array of Lua function references */
 	typedef std::vector<cLuaState::cCallbackPtr> cLuaCallbacks;
 
-	/** Maps hook types into arrays of Lua function references to call for each hook type */
-	typedef std::map<int, cLuaCallbacks> cHookMap;
+	/** Maps hook types into arrays of Lua function references to call for each hook type, indexed by the hook type */
+	typedef std::array<cLuaCallbacks, cPluginManager::HOOK_NUM_HOOKS> cHookMap;
+
+	/** A callback registered with a minimum interval between the calls, see AddHookCallback(). */
+	struct sRateLimitedCallback
+	{
+		sRateLimitedCallback(int a_HookType, cLuaState::cCallbackPtr && a_Callback, std::chrono::milliseconds a_MinInterval):
+			m_HookType(a_HookType),
+			m_Callback(std::move(a_Callback)),
+			m_Limiter(a_MinInterval, cHookRateLimiter::cClock::now())
+		{
+		}
+
+		int m_HookType;
+		cLuaState::cCallbackPtr m_Callback;
+		cHookRateLimiter m_Limiter;
+	};
 
 
 	/** The plugin's Lua state. */
@@ -177,6 +200,9 @@ protected:
 	/** Hooks that the plugin has registered. */
 	cHookMap m_HookMap;
 
+	/** Hooks that the plugin has registered with a minimum interval between the calls. */
+	std::vector<sRateLimitedCallback> m_RateLimitedHooks;
+
 	/** The DeadlockDetect object to which the plugin's CS is tracked. */
 	cDeadlockDetect & m_DeadlockDetect;
 
@@ -195,6 +221,11 @@ protected:
 	{
 		cOperation op(*this);
 		auto & hooks = m_HookMap[a_HookType];
+		if (hooks.empty())
+		{
+			// Only the rate-limited callbacks are registered for this hook
+			return false;
+		}
 		bool res = false;
 		for (auto & hook: hooks)
 		{
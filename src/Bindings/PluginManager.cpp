@@ -11,6 +11,7 @@
 
 #include "../IniFile.h"
 #include "../Entities/Player.h"
+#include "../TickProfiler.h"
 
 
 
@@ -27,6 +28,8 @@ cPluginManager * cPluginManager::Get(void)
 
 cPluginManager::cPluginManager(cDeadlockDetect & a_DeadlockDetect) :
 	m_bReloadPlugins(false),
+	m_CallbackBudget(0),
+	m_TickBudget(0),
 	m_DeadlockDetect(a_DeadlockDetect)
 {
 }
@@ -123,6 +126,10 @@ void cPluginManager::ReloadPluginsNow(cSettingsRepositoryInterface & a_Settings)
 	// Refresh the list of plugins to load new ones from disk / remove the deleted ones:
 	RefreshPluginList();
 
+	// Read the budgets of the plugins' CPU time, over which a warning is logged:
+	m_CallbackBudget = std::chrono::milliseconds(a_Settings.GetValueSetI("PluginCpuStats", "WarnCallbackMS", 0));
+	m_TickBudget = std::chrono::milliseconds(a_Settings.GetValueSetI("PluginCpuStats", "WarnTickMS", 0));
+
 	// Load the plugins:
 	AStringVector ToLoad = GetFoldersToLoad(a_Settings);
 	for (auto & pluginFolder: ToLoad)
@@ -222,15 +229,24 @@ void cPluginManager::Tick(float a_Dt)
 		ReloadPluginsNow();
 	}
 
-	auto Plugins = m_Hooks.find(HOOK_TICK);
-	if (Plugins == m_Hooks.end())
+	for (auto * Plugin : m_Hooks[HOOK_TICK])
 	{
-		return;
+		cPluginCpuStats::cTimer Timer(&Plugin->GetCpuStats(), "OnTick");
+		Plugin->Tick(a_Dt);
 	}
 
-	for (auto * Plugin : Plugins->second)
+	// Finish the tick in the CPU time accounting of all the plugins:
+	for (auto & Plugin: m_Plugins)
 	{
-		Plugin->Tick(a_Dt);
+		Plugin->GetCpuStats().EndTick();
+	}
+
+	// Refresh the statistics for the webadmin, which cannot access the plugins from its threads:
+	const auto Now = std::chrono::steady_clock::now();
+	if (Now - m_PluginCpuStatsSnapshotTime >= std::chrono::seconds(1))
+	{
+		m_PluginCpuStatsSnapshotTime = Now;
+		UpdatePluginCpuStatsSnapshot();
 	}
 }
 
@@ -241,13 +257,52 @@ void cPluginManager::Tick(float a_Dt)
 template <typename HookFunction>
 bool cPluginManager::GenericCallHook(PluginHook a_HookName, HookFunction a_HookFunction)
 {
-	auto Plugins = m_Hooks.find(a_HookName);
-	if (Plugins == m_Hooks.end())
+	// Fast path for hooks that no plugin handles, the hook arguments aren't touched at all:
+	const auto & Plugins = m_Hooks[a_HookName];
+	if (Plugins.empty())
 	{
 		return false;
 	}
 
-	return std::any_of(Plugins->second.begin(), Plugins->second.end(), a_HookFunction);
+	// Time each plugin's handler separately for the plugin's CPU time accounting,
+	// and for the tick profiler if called from a world tick that collects the detailed timings:
+	static_assert(HOOK_NUM_HOOKS <= cPluginCpuStats::NumHookSlots, "The plugin CPU stats need a slot for each hook");
+	const auto Start = std::chrono::steady_clock::now();
+	auto PluginStart = Start;
+	auto Profiler = cTickProfiler::GetCurrent();
+	const bool ShouldProfile = (Profiler != nullptr) && Profiler->IsCapturingDetails();
+	const char * HookName = cPluginLua::GetHookFnName(a_HookName);
+	if (HookName == nullptr)
+	{
+		HookName = "<unknown hook>";
+	}
+	bool res = std::any_of(Plugins.begin(), Plugins.end(), [&](cPlugin * a_Plugin)
+		{
+			bool PluginRes = a_HookFunction(a_Plugin);
+
+			// Each handler ends where the next one starts, a single clock read per handler is enough:
+			const auto PluginEnd = std::chrono::steady_clock::now();
+			const auto PluginDuration = PluginEnd - PluginStart;
+			PluginStart = PluginEnd;
+			a_Plugin->GetCpuStats().RecordHook(static_cast<size_t>(a_HookName), HookName, PluginDuration);
+			if (ShouldProfile)
+			{
+				Profiler->AddPluginHookTiming(a_Plugin->GetName(), HookName, PluginDuration);
+			}
+			return PluginRes;
+		}
+	);
+	auto Duration = static_cast<UInt64>(std::chrono::duration_cast<std::chrono::nanoseconds>(PluginStart - Start).count());
+
+	// Update the dispatch statistics, the hooks may be called from several threads at once:
+	auto & Stats = m_HookStats[a_HookName];
+	Stats.m_NumCalls.fetch_add(1, std::memory_order_relaxed);
+	Stats.m_TotalNSec.fetch_add(Duration, std::memory_order_relaxed);
+	auto Max = Stats.m_MaxNSec.load(std::memory_order_relaxed);
+	while ((Duration > Max) && !Stats.m_MaxNSec.compare_exchange_weak(Max, Duration, std::memory_order_relaxed))
+	{
+	}
+	return res;
 }
 
 
@@ -1024,14 +1079,8 @@ bool cPluginManager::CallHookPluginMessage(cClientHandle & a_Client, const AStri
 
 bool cPluginManager::CallHookPluginsLoaded(void)
 {
-	auto Plugins = m_Hooks.find(HOOK_PLUGINS_LOADED);
-	if (Plugins == m_Hooks.end())
-	{
-		return false;
-	}
-
 	bool res = false;
-	for (auto * Plugin : Plugins->second)
+	for (auto * Plugin : m_Hooks[HOOK_PLUGINS_LOADED])
 	{
 		if (!Plugin->OnPluginsLoaded())
 		{
@@ -1313,7 +1362,10 @@ cPluginManager::CommandResult cPluginManager::HandleCommand(cPlayer & a_Player,
 void cPluginManager::UnloadPluginsNow()
 {
 	// Remove all bindings:
-	m_Hooks.clear();
+	for (auto & Plugins : m_Hooks)
+	{
+		Plugins.clear();
+	}
 	m_Commands.clear();
 	m_ConsoleCommands.clear();
 
@@ -1362,6 +1414,7 @@ bool cPluginManager::LoadPlugin(const AString & a_FolderName)
 		{
 			if (!plugin->IsLoaded())
 			{
+				plugin->GetCpuStats().SetBudgets(m_CallbackBudget, m_TickBudget);
 				return plugin->Load();
 			}
 			return true;
@@ -1379,9 +1432,9 @@ bool cPluginManager::LoadPlugin(const AString & a_FolderName)
 
 void cPluginManager::RemoveHooks(cPlugin * a_Plugin)
 {
-	for (auto & Hook : m_Hooks)
+	for (auto & Plugins : m_Hooks)
 	{
-		Hook.second.remove(a_Plugin);
+		Plugins.remove(a_Plugin);
 	}
 }
 
@@ -1673,6 +1726,121 @@ bool cPluginManager::IsValidHookType(int a_HookType)
 
 
 
+AString cPluginManager::GetHookStats(bool a_Reset)
+{
+	AString res("Hook dispatch statistics:\n");
+	for (size_t Hook = 0; Hook < m_HookStats.size(); Hook++)
+	{
+		auto & Stats = m_HookStats[Hook];
+		auto NumCalls = a_Reset ? Stats.m_NumCalls.exchange(0) : Stats.m_NumCalls.load();
+		auto TotalNSec = a_Reset ? Stats.m_TotalNSec.exchange(0) : Stats.m_TotalNSec.load();
+		auto MaxNSec = a_Reset ? Stats.m_MaxNSec.exchange(0) : Stats.m_MaxNSec.load();
+		if (NumCalls == 0)
+		{
+			continue;
+		}
+		auto HookName = cPluginLua::GetHookFnName(static_cast<int>(Hook));
+		res.append(fmt::format(FMT_STRING("  {}: {} calls, avg {:.2f} us, max {:.2f} us, total {:.2f} ms\n"),
+			(HookName == nullptr) ? fmt::format(FMT_STRING("hook {}"), Hook) : AString(HookName),
+			NumCalls,
+			static_cast<double>(TotalNSec) / NumCalls / 1000,
+			static_cast<double>(MaxNSec) / 1000,
+			static_cast<double>(TotalNSec) / 1000000
+		));
+	}
+	return res;
+}
+
+
+
+
+
+AString cPluginManager::GetPluginCpuStats(const AString & a_PluginName)
+{
+	// A single plugin, with all its callbacks:
+	if (!a_PluginName.empty())
+	{
+		for (auto & Plugin: m_Plugins)
+		{
+			if (Plugin->GetName() == a_PluginName)
+			{
+				return Plugin->GetCpuStats().GetReport(std::numeric_limits<size_t>::max());
+			}
+		}
+		return fmt::format(FMT_STRING("There is no plugin named \"{}\"\n"), a_PluginName);
+	}
+
+	// All the loaded plugins, those that have spent the most time first, with their top callbacks:
+	std::vector<std::pair<std::chrono::nanoseconds, cPlugin *>> Plugins;
+	for (auto & Plugin: m_Plugins)
+	{
+		if (Plugin->IsLoaded())
+		{
+			Plugins.emplace_back(Plugin->GetCpuStats().GetTotals().m_TotalTime, Plugin.get());
+		}
+	}
+	std::stable_sort(Plugins.begin(), Plugins.end(), [](const auto & a_First, const auto & a_Second)
+		{
+			return (a_First.first > a_Second.first);
+		}
+	);
+	AString res("Time spent in the plugins' callbacks:\n");
+	for (const auto & Plugin: Plugins)
+	{
+		res.append(Plugin.second->GetCpuStats().GetReport(5));
+	}
+	return res;
+}
+
+
+
+
+
+void cPluginManager::ResetPluginCpuStats(void)
+{
+	for (auto & Plugin: m_Plugins)
+	{
+		Plugin->GetCpuStats().Reset();
+	}
+}
+
+
+
+
+
+AString cPluginManager::GetPluginCpuStatsSnapshot(const AString & a_PluginName) const
+{
+	cCSLock Lock(m_CSPluginCpuStatsSnapshot);
+	auto itr = m_PluginCpuStatsSnapshot.find(a_PluginName);
+	if (itr == m_PluginCpuStatsSnapshot.end())
+	{
+		return fmt::format(FMT_STRING("There is no plugin named \"{}\"\n"), a_PluginName);
+	}
+	return itr->second;
+}
+
+
+
+
+
+void cPluginManager::UpdatePluginCpuStatsSnapshot(void)
+{
+	// Generate the reports without holding the lock, the readers only wait for the swap:
+	std::map<AString, AString> Snapshot;
+	Snapshot.emplace(AString(), GetPluginCpuStats(AString()));
+	for (auto & Plugin: m_Plugins)
+	{
+		Snapshot.emplace(Plugin->GetName(), Plugin->GetCpuStats().GetReport(std::numeric_limits<size_t>::max()));
+	}
+
+	cCSLock Lock(m_CSPluginCpuStatsSnapshot);
+	std::swap(Snapshot, m_PluginCpuStatsSnapshot);
+}
+
+
+
+
+
 bool cPluginManager::DoWithPlugin(const AString & a_PluginName, cPluginCallback a_Callback)
 {
 	// TODO: Implement locking for plugins
@@ -1731,7 +1899,12 @@ void cPluginManager::AddHook(cPlugin * a_Plugin, int a_Hook)
 		LOGWARN("Called cPluginManager::AddHook() with a_Plugin == nullptr");
 		return;
 	}
-	PluginList & Plugins = m_Hooks[a_Hook];
+	if (!IsValidHookType(a_Hook))
+	{
+		LOGWARN("Called cPluginManager::AddHook() with an invalid hook type %d", a_Hook);
+		return;
+	}
+	PluginList & Plugins = m_Hooks[static_cast<size_t>(a_Hook)];
 	if (std::find(Plugins.cbegin(), Plugins.cend(), a_Plugin) == Plugins.cend())
 	{
 		Plugins.push_back(a_Plugin);
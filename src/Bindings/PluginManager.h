@@ -389,6 +389,23 @@ public:
 	/** Returns true if the specified hook type is within the allowed range */
 	static bool IsValidHookType(int a_HookType);
 
+	/** Returns the dispatch statistics of all the hooks that have been called, as text for the "hookstats" console command.
+	Each hook reports the number of calls and the average, maximum and total time spent in its handlers.
+	If a_Reset is true, the statistics are reset afterwards. */
+	AString GetHookStats(bool a_Reset);
+
+	/** Returns the time spent in the plugins' callbacks, as text for the "pluginstats" console command and the webadmin.
+	If a_PluginName is empty, all the loaded plugins are reported, each with its top callbacks; otherwise only the specified plugin
+	is reported, with all its callbacks. */
+	AString GetPluginCpuStats(const AString & a_PluginName);
+
+	/** Clears the statistics of the time spent in the plugins' callbacks. */
+	void ResetPluginCpuStats(void);
+
+	/** Returns the same report as GetPluginCpuStats(), taken from the snapshot that Tick() refreshes every second.
+	Unlike GetPluginCpuStats(), may be called from any thread. */
+	AString GetPluginCpuStatsSnapshot(const AString & a_PluginName) const;
+
 	/** Calls the specified callback with the plugin object of the specified plugin.
 	Returns false if plugin not found, otherwise returns the value that the callback has returned. */
 	bool DoWithPlugin(const AString & a_PluginName, cPluginCallback a_Callback);
@@ -416,7 +433,16 @@ private:
 		cCommandHandlerPtr m_Handler;
 	} ;
 
-	typedef std::map<int, cPluginManager::PluginList> HookMap;
+	/** The plugins registered for each hook type, indexed by the hook type. */
+	typedef std::array<cPluginManager::PluginList, HOOK_NUM_HOOKS> HookMap;
+
+	/** The dispatch statistics of a single hook type, updated from whichever thread calls the hook. */
+	struct sHookStats
+	{
+		std::atomic<UInt64> m_NumCalls{0};
+		std::atomic<UInt64> m_TotalNSec{0};
+		std::atomic<UInt64> m_MaxNSec{0};
+	};
 	typedef std::map<AString, cCommandReg> CommandMap;
 
 
@@ -432,12 +458,31 @@ private:
 	cPluginPtrs m_Plugins;
 
 	HookMap    m_Hooks;
+
+	/** The dispatch statistics of each hook type, indexed by the hook type.
+	Only the calls that reach at least one plugin are counted. */
+	std::array<sHookStats, HOOK_NUM_HOOKS> m_HookStats;
 	CommandMap m_Commands;
 	CommandMap m_ConsoleCommands;
 
 	/** If set to true, all the plugins will be reloaded within the next call to Tick(). */
 	bool m_bReloadPlugins;
 
+	/** The budgets of a single plugin callback's time, and of a plugin's total time in a single tick, over which a warning is logged.
+	Zero disables the warning. Read from settings.ini upon (re)loading the plugins. */
+	std::chrono::milliseconds m_CallbackBudget;
+	std::chrono::milliseconds m_TickBudget;
+
+	/** The reports of GetPluginCpuStats() as of the last refresh in Tick(): the overview under the empty name, each plugin under its name.
+	Protected against multithreaded access by m_CSPluginCpuStatsSnapshot. */
+	std::map<AString, AString> m_PluginCpuStatsSnapshot;
+
+	/** Protects m_PluginCpuStatsSnapshot against multithreaded access. */
+	mutable cCriticalSection m_CSPluginCpuStatsSnapshot;
+
+	/** The time when Tick() last refreshed m_PluginCpuStatsSnapshot. */
+	std::chrono::steady_clock::time_point m_PluginCpuStatsSnapshotTime;
+
 	/** The deadlock detect in which all plugins should track their CSs. */
 	cDeadlockDetect & m_DeadlockDetect;
 
@@ -448,6 +493,9 @@ private:
 	/** Reloads all plugins, defaulting to settings.ini for settings location */
 	void ReloadPluginsNow(void);
 
+	/** Regenerates m_PluginCpuStatsSnapshot from the current statistics. */
+	void UpdatePluginCpuStatsSnapshot(void);
+
 	/** Reloads all plugins with a settings repo expected to be initialised to settings.ini */
 	void ReloadPluginsNow(cSettingsRepositoryInterface & a_Settings);
 
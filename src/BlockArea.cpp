@@ -16,6 +16,7 @@
 #include "BlockEntities/BlockEntity.h"
 #include "Item.h"
 #include "BlockInfo.h"
+#include "OSSupport/ThreadPool.h"
 
 
 
@@ -31,10 +32,219 @@
 
 
 
+/** The minimum number of blocks to process in a single task in ForEachSliceParallel().
+Smaller amounts of work are not worth handing over to another thread. */
+static const size_t MIN_BLOCKS_PER_TASK = 256 * 1024;
+
+
+
+
+
+/** Splits the range [0, a_Count) into contiguous slices and calls a_SliceFn(Start, End) for each of them.
+If the work is large enough, the slices are processed in parallel on the shared cThreadPool, the calling thread included.
+a_BlocksPerItem is the number of blocks processed for each item of the range, used for estimating the work.
+The slices must be independent of each other. */
+template <typename SliceFn>
+void ForEachSliceParallel(int a_Count, size_t a_BlocksPerItem, SliceFn a_SliceFn)
+{
+	if (a_Count <= 0)
+	{
+		return;
+	}
+	auto & Pool = cThreadPool::Get();
+	const auto NumItems = static_cast<size_t>(a_Count);
+	const auto NumSlices = std::min({ Pool.GetConcurrency(), NumItems, NumItems * a_BlocksPerItem / MIN_BLOCKS_PER_TASK });
+	if (NumSlices <= 1)
+	{
+		a_SliceFn(0, a_Count);
+		return;
+	}
+
+	std::vector<cThreadPool::cTask> Tasks;
+	Tasks.reserve(NumSlices);
+	for (size_t i = 0; i < NumSlices; i++)
+	{
+		const auto Start = static_cast<int>(NumItems * i / NumSlices);
+		const auto End = static_cast<int>(NumItems * (i + 1) / NumSlices);
+		Tasks.emplace_back([&a_SliceFn, Start, End]()
+			{
+				a_SliceFn(Start, End);
+			}
+		);
+	}
+	Pool.RunAll(Tasks);
+}
+
+
+
+
+
+/** Copies the chunk's section, if it has one, into the same section of the snapshot store. */
+template <class StoreType>
+void SnapshotSection(StoreType & a_Dst, const typename StoreType::Type * a_Src, size_t a_Y)
+{
+	if (a_Src != nullptr)
+	{
+		a_Dst.Store[a_Y] = std::make_unique<typename StoreType::Type>(*a_Src);
+	}
+}
+
+
+
+
+
+/** The size of the square tiles in which RotateArray() transposes the XZ layers. */
+static const int ROTATE_TILE_SIZE = 32;
+
+
+
+
+
+/** Rotates the per-block values in a_Src around the Y axis into a_Dst.
+a_Size is the size of the source area, the destination has the X and Z sizes swapped.
+Each XZ layer is transposed in square tiles, so that both the reads and the writes stay within the cache;
+the destination is written in contiguous rows. Large areas are rotated in parallel, in horizontal slabs. */
+template <typename T>
+void RotateArray(const T * a_Src, T * a_Dst, Vector3i a_Size, bool a_Clockwise)
+{
+	const auto LayerSize = static_cast<ptrdiff_t>(a_Size.x) * a_Size.z;
+
+	// The destination block {NewX, y, NewZ} comes from the source index y * LayerSize + RowBase(NewZ) + NewX * StrideX:
+	const ptrdiff_t StrideX = a_Clockwise ? -a_Size.x : a_Size.x;
+	const auto RowBase = [a_Size, a_Clockwise](int a_NewZ) -> ptrdiff_t
+	{
+		return a_Clockwise ? (a_NewZ + static_cast<ptrdiff_t>(a_Size.z - 1) * a_Size.x) : (a_Size.x - 1 - a_NewZ);
+	};
+
+	ForEachSliceParallel(a_Size.y, static_cast<size_t>(LayerSize), [=](int a_StartY, int a_EndY)
+		{
+			for (int y = a_StartY; y < a_EndY; y++)
+			{
+				const T * SrcLayer = a_Src + y * LayerSize;
+				T * DstLayer = a_Dst + y * LayerSize;
+				for (int TileZ = 0; TileZ < a_Size.x; TileZ += ROTATE_TILE_SIZE)
+				{
+					int EndZ = std::min(TileZ + ROTATE_TILE_SIZE, a_Size.x);
+					for (int TileX = 0; TileX < a_Size.z; TileX += ROTATE_TILE_SIZE)
+					{
+						int EndX = std::min(TileX + ROTATE_TILE_SIZE, a_Size.z);
+						for (int NewZ = TileZ; NewZ < EndZ; NewZ++)
+						{
+							const T * SrcRow = SrcLayer + RowBase(NewZ);
+							T * DstRow = DstLayer + NewZ * a_Size.z;
+							for (int NewX = TileX; NewX < EndX; NewX++)
+							{
+								DstRow[NewX] = SrcRow[NewX * StrideX];
+							}
+						}  // for NewZ
+					}  // for TileX
+				}  // for TileZ
+			}  // for y
+		}
+	);
+}
+
+
+
+
+
+/** Caches a cBlockHandler meta transformation (MetaRotateCW, MetaMirrorXY, ...) for the block types present in an area,
+so that the bulk rotations and mirrors don't need a virtual call per block. */
+template <NIBBLETYPE (cBlockHandler::*MetaFn)(NIBBLETYPE) const>
+class cMetaTransformTable
+{
+public:
+
+	/** Queries the block handlers of all the block types present in a_Types. */
+	cMetaTransformTable(const BLOCKTYPE * a_Types, size_t a_NumBlocks)
+	{
+		std::array<bool, 256> IsPresent{};
+		for (size_t i = 0; i < a_NumBlocks; i++)
+		{
+			IsPresent[a_Types[i]] = true;
+		}
+		for (size_t Type = 0; Type < IsPresent.size(); Type++)
+		{
+			// Only query the types present, cBlockHandler::For() doesn't accept unknown types:
+			if (!IsPresent[Type])
+			{
+				continue;
+			}
+			const auto & Handler = cBlockHandler::For(static_cast<BLOCKTYPE>(Type));
+			for (NIBBLETYPE Meta = 0; Meta < 16; Meta++)
+			{
+				m_Table[Type * 16 + Meta] = (Handler.*MetaFn)(Meta);
+			}
+		}
+	}
+
+	/** Returns the transformed meta, as the block handler for a_Type would. a_Type must be one of the types present in the area. */
+	NIBBLETYPE operator () (BLOCKTYPE a_Type, NIBBLETYPE a_Meta) const
+	{
+		if (a_Meta >= 16)
+		{
+			// Not a valid meta, but still give the same result as the handler:
+			return (cBlockHandler::For(a_Type).*MetaFn)(a_Meta);
+		}
+		return m_Table[static_cast<size_t>(a_Type) * 16 + a_Meta];
+	}
+
+protected:
+
+	std::array<NIBBLETYPE, 256 * 16> m_Table;
+};
+
+
+
+
+
+/** Transforms all the metas in the area by the table, each according to its block's type. */
+template <typename Table>
+void TransformMetas(const BLOCKTYPE * a_Types, NIBBLETYPE * a_Metas, Vector3i a_Size, const Table & a_Table)
+{
+	const auto LayerSize = static_cast<size_t>(a_Size.x) * static_cast<size_t>(a_Size.z);
+	ForEachSliceParallel(a_Size.y, LayerSize, [=, &a_Table](int a_StartY, int a_EndY)
+		{
+			for (size_t i = static_cast<size_t>(a_StartY) * LayerSize, End = static_cast<size_t>(a_EndY) * LayerSize; i < End; i++)
+			{
+				a_Metas[i] = a_Table(a_Types[i], a_Metas[i]);
+			}
+		}
+	);
+}
+
+
+
+
+
+/** Swaps the blocks of two non-overlapping runs of a_Count blocks, transforming the metas by the table according to their block's type.
+Used for mirroring, the runs being the mirror images of each other. */
+template <typename Table>
+void SwapMirroredBlocks(BLOCKTYPE * a_Types1, NIBBLETYPE * a_Metas1, BLOCKTYPE * a_Types2, NIBBLETYPE * a_Metas2, size_t a_Count, const Table & a_Table)
+{
+	for (size_t i = 0; i < a_Count; i++)
+	{
+		BLOCKTYPE Type1 = a_Types1[i];
+		BLOCKTYPE Type2 = a_Types2[i];
+		NIBBLETYPE Meta1 = a_Metas1[i];
+		NIBBLETYPE Meta2 = a_Metas2[i];
+		a_Types1[i] = Type2;
+		a_Metas1[i] = a_Table(Type2, Meta2);
+		a_Types2[i] = Type1;
+		a_Metas2[i] = a_Table(Type1, Meta1);
+	}
+}
+
+
+
+
+
 typedef void (CombinatorFunc)(BLOCKTYPE & a_DstType, BLOCKTYPE a_SrcType, NIBBLETYPE & a_DstMeta, NIBBLETYPE a_SrcMeta);
 
 /** Merges two blocktypes and blockmetas of the specified sizes and offsets using the specified combinator function
-This wild construct allows us to pass a function argument and still have it inlined by the compiler. */
+This wild construct allows us to pass a function argument and still have it inlined by the compiler.
+The combinator is applied to whole X rows at once, so that the compiler can vectorise the row loop.
+Large areas are merged in parallel, in horizontal slabs. */
 template <bool MetasValid, CombinatorFunc Combinator>
 void InternalMergeBlocks(
 	BLOCKTYPE * a_DstTypes, const BLOCKTYPE * a_SrcTypes,
@@ -48,38 +258,55 @@ void InternalMergeBlocks(
 {
 	UNUSED(a_SrcSizeY);
 	UNUSED(a_DstSizeY);
-	for (int y = 0; y < a_SizeY; y++)
+	const auto MergeSlab = [=](int a_StartY, int a_EndY)
 	{
-		int SrcBaseY = (y + a_SrcOffY) * a_SrcSizeX * a_SrcSizeZ;
-		int DstBaseY = (y + a_DstOffY) * a_DstSizeX * a_DstSizeZ;
-		for (int z = 0; z < a_SizeZ; z++)
+		for (int y = a_StartY; y < a_EndY; y++)
 		{
-			int SrcBaseZ = SrcBaseY + (z + a_SrcOffZ) * a_SrcSizeX;
-			int DstBaseZ = DstBaseY + (z + a_DstOffZ) * a_DstSizeX;
-			int SrcIdx = SrcBaseZ + a_SrcOffX;
-			int DstIdx = DstBaseZ + a_DstOffX;
-			for (int x = 0; x < a_SizeX; x++)
+			int SrcBaseY = (y + a_SrcOffY) * a_SrcSizeX * a_SrcSizeZ;
+			int DstBaseY = (y + a_DstOffY) * a_DstSizeX * a_DstSizeZ;
+			for (int z = 0; z < a_SizeZ; z++)
 			{
+				int SrcIdx = SrcBaseY + (z + a_SrcOffZ) * a_SrcSizeX + a_SrcOffX;
+				int DstIdx = DstBaseY + (z + a_DstOffZ) * a_DstSizeX + a_DstOffX;
+				BLOCKTYPE * DstTypes = a_DstTypes + DstIdx;
+				const BLOCKTYPE * SrcTypes = a_SrcTypes + SrcIdx;
 				if (MetasValid)
 				{
-					Combinator(a_DstTypes[DstIdx], a_SrcTypes[SrcIdx], a_DstMetas[DstIdx], a_SrcMetas[SrcIdx]);
+					NIBBLETYPE * DstMetas = a_DstMetas + DstIdx;
+					const NIBBLETYPE * SrcMetas = a_SrcMetas + SrcIdx;
+					for (int x = 0; x < a_SizeX; x++)
+					{
+						Combinator(DstTypes[x], SrcTypes[x], DstMetas[x], SrcMetas[x]);
+					}
 				}
 				else
 				{
-					NIBBLETYPE FakeDestMeta = 0;
-					Combinator(a_DstTypes[DstIdx], a_SrcTypes[SrcIdx], FakeDestMeta, static_cast<NIBBLETYPE>(0));
+					for (int x = 0; x < a_SizeX; x++)
+					{
+						NIBBLETYPE FakeDestMeta = 0;
+						Combinator(DstTypes[x], SrcTypes[x], FakeDestMeta, static_cast<NIBBLETYPE>(0));
+					}
 				}
-				++DstIdx;
-				++SrcIdx;
-			}  // for x
-		}  // for z
-	}  // for y
+			}  // for z
+		}  // for y
+	};
+
+	if (a_DstTypes == a_SrcTypes)
+	{
+		// Merging an area into itself, the order of the blocks matters, merge serially:
+		MergeSlab(0, a_SizeY);
+		return;
+	}
+	ForEachSliceParallel(a_SizeY, static_cast<size_t>(a_SizeX * a_SizeZ), MergeSlab);
 }
 
 
 
 
 
+// The merge combinators.
+// Wherever possible they are written as selects rather than branches, so that the merging loop in InternalMergeBlocks() gets vectorised.
+
 /** Combinator used for cBlockArea::msOverwrite merging */
 template <bool MetaValid>
 void MergeCombinatorOverwrite(BLOCKTYPE & a_DstType, BLOCKTYPE a_SrcType, NIBBLETYPE & a_DstMeta, NIBBLETYPE a_SrcMeta)
@@ -99,15 +326,12 @@ void MergeCombinatorOverwrite(BLOCKTYPE & a_DstType, BLOCKTYPE a_SrcType, NIBBLE
 template <bool MetaValid>
 void MergeCombinatorFillAir(BLOCKTYPE & a_DstType, BLOCKTYPE a_SrcType, NIBBLETYPE & a_DstMeta, NIBBLETYPE a_SrcMeta)
 {
-	if (a_DstType == E_BLOCK_AIR)
+	bool IsAir = (a_DstType == E_BLOCK_AIR);
+	a_DstType = IsAir ? a_SrcType : a_DstType;
+	if (MetaValid)
 	{
-		a_DstType = a_SrcType;
-		if (MetaValid)
-		{
-			a_DstMeta = a_SrcMeta;
-		}
+		a_DstMeta = IsAir ? a_SrcMeta : a_DstMeta;
 	}
-	// "else" is the default, already in place
 }
 
 
@@ -118,15 +342,12 @@ void MergeCombinatorFillAir(BLOCKTYPE & a_DstType, BLOCKTYPE a_SrcType, NIBBLETY
 template <bool MetaValid>
 void MergeCombinatorImprint(BLOCKTYPE & a_DstType, BLOCKTYPE a_SrcType, NIBBLETYPE & a_DstMeta, NIBBLETYPE a_SrcMeta)
 {
-	if (a_SrcType != E_BLOCK_AIR)
+	bool IsSrcSolid = (a_SrcType != E_BLOCK_AIR);
+	a_DstType = IsSrcSolid ? a_SrcType : a_DstType;
+	if (MetaValid)
 	{
-		a_DstType = a_SrcType;
-		if (MetaValid)
-		{
-			a_DstMeta = a_SrcMeta;
-		}
+		a_DstMeta = IsSrcSolid ? a_SrcMeta : a_DstMeta;
 	}
-	// "else" is the default, already in place
 }
 
 
@@ -212,13 +433,11 @@ template <bool MetaValid>
 void MergeCombinatorSpongePrint(BLOCKTYPE & a_DstType, BLOCKTYPE a_SrcType, NIBBLETYPE & a_DstMeta, NIBBLETYPE a_SrcMeta)
 {
 	// Sponge overwrites nothing, everything else overwrites anything
-	if (a_SrcType != E_BLOCK_SPONGE)
+	bool IsSrcSponge = (a_SrcType == E_BLOCK_SPONGE);
+	a_DstType = IsSrcSponge ? a_DstType : a_SrcType;
+	if (MetaValid)
 	{
-		a_DstType = a_SrcType;
-		if (MetaValid)
-		{
-			a_DstMeta = a_SrcMeta;
-		}
+		a_DstMeta = IsSrcSponge ? a_DstMeta : a_SrcMeta;
 	}
 }
 
@@ -230,21 +449,11 @@ void MergeCombinatorSpongePrint(BLOCKTYPE & a_DstType, BLOCKTYPE a_SrcType, NIBB
 template <bool MetaValid>
 void MergeCombinatorDifference(BLOCKTYPE & a_DstType, BLOCKTYPE a_SrcType, NIBBLETYPE & a_DstMeta, NIBBLETYPE a_SrcMeta)
 {
-	if ((a_DstType == a_SrcType) && (!MetaValid || (a_DstMeta == a_SrcMeta)))
-	{
-		a_DstType = E_BLOCK_AIR;
-		if (MetaValid)
-		{
-			a_DstMeta = 0;
-		}
-	}
-	else
+	bool IsSame = (a_DstType == a_SrcType) & (!MetaValid || (a_DstMeta == a_SrcMeta));
+	a_DstType = IsSame ? static_cast<BLOCKTYPE>(E_BLOCK_AIR) : a_SrcType;
+	if (MetaValid)
 	{
-		a_DstType = a_SrcType;
-		if (MetaValid)
-		{
-			a_DstMeta = a_SrcMeta;
-		}
+		a_DstMeta = IsSame ? static_cast<NIBBLETYPE>(0) : a_SrcMeta;
 	}
 }
 
@@ -256,16 +465,9 @@ void MergeCombinatorDifference(BLOCKTYPE & a_DstType, BLOCKTYPE a_SrcType, NIBBL
 template <bool MetaValid>
 void MergeCombinatorSimpleCompare(BLOCKTYPE & a_DstType, BLOCKTYPE a_SrcType, NIBBLETYPE & a_DstMeta, NIBBLETYPE a_SrcMeta)
 {
-	if ((a_DstType == a_SrcType) && (!MetaValid || (a_DstMeta == a_SrcMeta)))
-	{
-		// The blocktypes are the same, and the blockmetas are not present or are the same
-		a_DstType = E_BLOCK_AIR;
-	}
-	else
-	{
-		// The blocktypes or blockmetas differ
-		a_DstType = E_BLOCK_STONE;
-	}
+	// Air if the blocktypes are the same and the blockmetas are not present or are the same, stone if they differ:
+	bool IsSame = (a_DstType == a_SrcType) & (!MetaValid || (a_DstMeta == a_SrcMeta));
+	a_DstType = IsSame ? static_cast<BLOCKTYPE>(E_BLOCK_AIR) : static_cast<BLOCKTYPE>(E_BLOCK_STONE);
 }
 
 
@@ -277,13 +479,11 @@ template <bool MetaValid>
 void MergeCombinatorMask(BLOCKTYPE & a_DstType, BLOCKTYPE a_SrcType, NIBBLETYPE & a_DstMeta, NIBBLETYPE a_SrcMeta)
 {
 	// If the blocks are the same, keep the dest; otherwise replace with air
-	if ((a_SrcType != a_DstType) || !MetaValid || (a_SrcMeta != a_DstMeta))
+	bool IsDifferent = (a_SrcType != a_DstType) | !MetaValid | (a_SrcMeta != a_DstMeta);
+	a_DstType = IsDifferent ? static_cast<BLOCKTYPE>(E_BLOCK_AIR) : a_DstType;
+	if (MetaValid)
 	{
-		a_DstType = E_BLOCK_AIR;
-		if (MetaValid)
-		{
-			a_DstMeta = 0;
-		}
+		a_DstMeta = IsDifferent ? static_cast<NIBBLETYPE>(0) : a_DstMeta;
 	}
 }
 
@@ -477,6 +677,7 @@ bool cBlockArea::Read(cForEachChunkProvider & a_ForEachChunkProvider, int a_MinB
 		Clear();
 		return false;
 	}
+	Reader.CopySnapshots();
 
 	return true;
 }
@@ -1053,24 +1254,13 @@ void cBlockArea::RotateCCW(void)
 		return;
 	}
 
-	// We are guaranteed that both blocktypes and blockmetas exist; rotate both at the same time:
+	// We are guaranteed that both blocktypes and blockmetas exist; rotate both, then rotate the metas themselves:
+	cMetaTransformTable<&cBlockHandler::MetaRotateCCW> MetaTable(GetBlockTypes(), GetBlockCount());
 	BLOCKARRAY NewTypes{ new BLOCKTYPE[GetBlockCount()] };
 	NIBBLEARRAY NewMetas{ new NIBBLETYPE[GetBlockCount()] };
-	for (int x = 0; x < m_Size.x; x++)
-	{
-		int NewZ = m_Size.x - x - 1;
-		for (int z = 0; z < m_Size.z; z++)
-		{
-			int NewX = z;
-			for (int y = 0; y < m_Size.y; y++)
-			{
-				auto NewIdx = MakeIndexForSize({ NewX, y, NewZ }, { m_Size.z, m_Size.y, m_Size.x });
-				auto OldIdx = MakeIndex(x, y, z);
-				NewTypes[NewIdx] = m_BlockTypes[OldIdx];
-				NewMetas[NewIdx] = cBlockHandler::For(m_BlockTypes[OldIdx]).MetaRotateCCW(m_BlockMetas[OldIdx]);
-			}  // for y
-		}  // for z
-	}  // for x
+	RotateArray(m_BlockTypes.get(), NewTypes.get(), m_Size, false);
+	RotateArray(m_BlockMetas.get(), NewMetas.get(), m_Size, false);
+	TransformMetas(NewTypes.get(), NewMetas.get(), m_Size, MetaTable);
 	m_BlockTypes = std::move(NewTypes);
 	m_BlockMetas = std::move(NewMetas);
 
@@ -1113,24 +1303,13 @@ void cBlockArea::RotateCW(void)
 		return;
 	}
 
-	// We are guaranteed that both blocktypes and blockmetas exist; rotate both at the same time:
+	// We are guaranteed that both blocktypes and blockmetas exist; rotate both, then rotate the metas themselves:
+	cMetaTransformTable<&cBlockHandler::MetaRotateCW> MetaTable(GetBlockTypes(), GetBlockCount());
 	BLOCKARRAY NewTypes{ new BLOCKTYPE[GetBlockCount()] };
 	NIBBLEARRAY NewMetas{ new NIBBLETYPE[GetBlockCount()] };
-	for (int x = 0; x < m_Size.x; x++)
-	{
-		int NewZ = x;
-		for (int z = 0; z < m_Size.z; z++)
-		{
-			int NewX = m_Size.z - z - 1;
-			for (int y = 0; y < m_Size.y; y++)
-			{
-				auto NewIdx = MakeIndexForSize({ NewX, y, NewZ }, { m_Size.z, m_Size.y, m_Size.x });
-				auto OldIdx = MakeIndex(x, y, z);
-				NewTypes[NewIdx] = m_BlockTypes[OldIdx];
-				NewMetas[NewIdx] = cBlockHandler::For(m_BlockTypes[OldIdx]).MetaRotateCW(m_BlockMetas[OldIdx]);
-			}  // for y
-		}  // for z
-	}  // for x
+	RotateArray(m_BlockTypes.get(), NewTypes.get(), m_Size, true);
+	RotateArray(m_BlockMetas.get(), NewMetas.get(), m_Size, true);
+	TransformMetas(NewTypes.get(), NewMetas.get(), m_Size, MetaTable);
 	m_BlockTypes = std::move(NewTypes);
 	m_BlockMetas = std::move(NewMetas);
 
@@ -1173,23 +1352,17 @@ void cBlockArea::MirrorXY(void)
 		return;
 	}
 
-	// We are guaranteed that both blocktypes and blockmetas exist; mirror both at the same time:
+	// We are guaranteed that both blocktypes and blockmetas exist; mirror both at the same time, swapping whole X rows:
+	cMetaTransformTable<&cBlockHandler::MetaMirrorXY> MetaTable(GetBlockTypes(), GetBlockCount());
 	int HalfZ = m_Size.z / 2;
 	int MaxZ = m_Size.z - 1;
 	for (int y = 0; y < m_Size.y; y++)
 	{
 		for (int z = 0; z < HalfZ; z++)
 		{
-			for (int x = 0; x < m_Size.x; x++)
-			{
-				auto Idx1 = MakeIndex(x, y, z);
-				auto Idx2 = MakeIndex(x, y, MaxZ - z);
-				std::swap(m_BlockTypes[Idx1], m_BlockTypes[Idx2]);
-				NIBBLETYPE Meta1 = cBlockHandler::For(m_BlockTypes[Idx2]).MetaMirrorXY(m_BlockMetas[Idx1]);
-				NIBBLETYPE Meta2 = cBlockHandler::For(m_BlockTypes[Idx1]).MetaMirrorXY(m_BlockMetas[Idx2]);
-				m_BlockMetas[Idx1] = Meta2;
-				m_BlockMetas[Idx2] = Meta1;
-			}  // for x
+			auto Idx1 = MakeIndex(0, y, z);
+			auto Idx2 = MakeIndex(0, y, MaxZ - z);
+			SwapMirroredBlocks(&m_BlockTypes[Idx1], &m_BlockMetas[Idx1], &m_BlockTypes[Idx2], &m_BlockMetas[Idx2], static_cast<size_t>(m_Size.x), MetaTable);
 		}  // for z
 	}  // for y
 
@@ -1230,24 +1403,15 @@ void cBlockArea::MirrorXZ(void)
 		return;
 	}
 
-	// We are guaranteed that both blocktypes and blockmetas exist; mirror both at the same time:
+	// We are guaranteed that both blocktypes and blockmetas exist; mirror both at the same time, swapping whole XZ layers:
+	cMetaTransformTable<&cBlockHandler::MetaMirrorXZ> MetaTable(GetBlockTypes(), GetBlockCount());
 	int HalfY = m_Size.y / 2;
 	int MaxY = m_Size.y - 1;
 	for (int y = 0; y < HalfY; y++)
 	{
-		for (int z = 0; z < m_Size.z; z++)
-		{
-			for (int x = 0; x < m_Size.x; x++)
-			{
-				auto Idx1 = MakeIndex(x, y, z);
-				auto Idx2 = MakeIndex(x, MaxY - y, z);
-				std::swap(m_BlockTypes[Idx1], m_BlockTypes[Idx2]);
-				NIBBLETYPE Meta1 = cBlockHandler::For(m_BlockTypes[Idx2]).MetaMirrorXZ(m_BlockMetas[Idx1]);
-				NIBBLETYPE Meta2 = cBlockHandler::For(m_BlockTypes[Idx1]).MetaMirrorXZ(m_BlockMetas[Idx2]);
-				m_BlockMetas[Idx1] = Meta2;
-				m_BlockMetas[Idx2] = Meta1;
-			}  // for x
-		}  // for z
+		auto Idx1 = MakeIndex(0, y, 0);
+		auto Idx2 = MakeIndex(0, MaxY - y, 0);
+		SwapMirroredBlocks(&m_BlockTypes[Idx1], &m_BlockMetas[Idx1], &m_BlockTypes[Idx2], &m_BlockMetas[Idx2], static_cast<size_t>(m_Size.x * m_Size.z), MetaTable);
 	}  // for y
 
 	// Mirror the BlockEntities:
@@ -1287,22 +1451,27 @@ void cBlockArea::MirrorYZ(void)
 		return;
 	}
 
-	// We are guaranteed that both blocktypes and blockmetas exist; mirror both at the same time:
+	// We are guaranteed that both blocktypes and blockmetas exist; mirror both at the same time, reversing each X row:
+	cMetaTransformTable<&cBlockHandler::MetaMirrorYZ> MetaTable(GetBlockTypes(), GetBlockCount());
 	int HalfX = m_Size.x / 2;
 	int MaxX = m_Size.x - 1;
 	for (int y = 0; y < m_Size.y; y++)
 	{
 		for (int z = 0; z < m_Size.z; z++)
 		{
+			auto RowIdx = MakeIndex(0, y, z);
+			BLOCKTYPE * Types = &m_BlockTypes[RowIdx];
+			NIBBLETYPE * Metas = &m_BlockMetas[RowIdx];
 			for (int x = 0; x < HalfX; x++)
 			{
-				auto Idx1 = MakeIndex(x, y, z);
-				auto Idx2 = MakeIndex(MaxX - x, y, z);
-				std::swap(m_BlockTypes[Idx1], m_BlockTypes[Idx2]);
-				NIBBLETYPE Meta1 = cBlockHandler::For(m_BlockTypes[Idx2]).MetaMirrorYZ(m_BlockMetas[Idx1]);
-				NIBBLETYPE Meta2 = cBlockHandler::For(m_BlockTypes[Idx1]).MetaMirrorYZ(m_BlockMetas[Idx2]);
-				m_BlockMetas[Idx1] = Meta2;
-				m_BlockMetas[Idx2] = Meta1;
+				BLOCKTYPE Type1 = Types[x];
+				BLOCKTYPE Type2 = Types[MaxX - x];
+				NIBBLETYPE Meta1 = Metas[x];
+				NIBBLETYPE Meta2 = Metas[MaxX - x];
+				Types[x] = Type2;
+				Metas[x] = MetaTable(Type2, Meta2);
+				Types[MaxX - x] = Type1;
+				Metas[MaxX - x] = MetaTable(Type1, Meta1);
 			}  // for x
 		}  // for z
 	}  // for y
@@ -1334,35 +1503,13 @@ void cBlockArea::RotateCCWNoMeta(void)
 	if (HasBlockTypes())
 	{
 		BLOCKARRAY NewTypes{ new BLOCKTYPE[GetBlockCount()] };
-		for (int x = 0; x < m_Size.x; x++)
-		{
-			int NewZ = m_Size.x - x - 1;
-			for (int z = 0; z < m_Size.z; z++)
-			{
-				int NewX = z;
-				for (int y = 0; y < m_Size.y; y++)
-				{
-					NewTypes[MakeIndexForSize({ NewX, y, NewZ }, { m_Size.z, m_Size.y, m_Size.x })] = m_BlockTypes[MakeIndex(x, y, z)];
-				}  // for y
-			}  // for z
-		}  // for x
+		RotateArray(m_BlockTypes.get(), NewTypes.get(), m_Size, false);
 		m_BlockTypes = std::move(NewTypes);
 	}
 	if (HasBlockMetas())
 	{
 		NIBBLEARRAY NewMetas{ new NIBBLETYPE[GetBlockCount()] };
-		for (int x = 0; x < m_Size.x; x++)
-		{
-			int NewZ = m_Size.x - x - 1;
-			for (int z = 0; z < m_Size.z; z++)
-			{
-				int NewX = z;
-				for (int y = 0; y < m_Size.y; y++)
-				{
-					NewMetas[MakeIndexForSize({ NewX, y, NewZ }, { m_Size.z, m_Size.y, m_Size.x })] = m_BlockMetas[MakeIndex(x, y, z)];
-				}  // for y
-			}  // for z
-		}  // for x
+		RotateArray(m_BlockMetas.get(), NewMetas.get(), m_Size, false);
 		m_BlockMetas = std::move(NewMetas);
 	}
 
@@ -1395,35 +1542,13 @@ void cBlockArea::RotateCWNoMeta(void)
 	if (HasBlockTypes())
 	{
 		BLOCKARRAY NewTypes{ new BLOCKTYPE[GetBlockCount()] };
-		for (int z = 0; z < m_Size.z; z++)
-		{
-			int NewX = m_Size.z - z - 1;
-			for (int x = 0; x < m_Size.x; x++)
-			{
-				int NewZ = x;
-				for (int y = 0; y < m_Size.y; y++)
-				{
-					NewTypes[MakeIndexForSize({ NewX, y, NewZ }, { m_Size.z, m_Size.y, m_Size.x })] = m_BlockTypes[MakeIndex(x, y, z)];
-				}  // for y
-			}  // for x
-		}  // for z
+		RotateArray(m_BlockTypes.get(), NewTypes.get(), m_Size, true);
 		m_BlockTypes = std::move(NewTypes);
 	}
 	if (HasBlockMetas())
 	{
 		NIBBLEARRAY NewMetas{ new NIBBLETYPE[GetBlockCount()] };
-		for (int z = 0; z < m_Size.z; z++)
-		{
-			int NewX = m_Size.z - z - 1;
-			for (int x = 0; x < m_Size.x; x++)
-			{
-				int NewZ = x;
-				for (int y = 0; y < m_Size.y; y++)
-				{
-					NewMetas[MakeIndexForSize({ NewX, y, NewZ }, { m_Size.z, m_Size.y, m_Size.x })] = m_BlockMetas[MakeIndex(x, y, z)];
-				}  // for y
-			}  // for x
-		}  // for z
+		RotateArray(m_BlockMetas.get(), NewMetas.get(), m_Size, true);
 		m_BlockMetas = std::move(NewMetas);
 	}
 
@@ -1461,10 +1586,8 @@ void cBlockArea::MirrorXYNoMeta(void)
 		{
 			for (int z = 0; z < HalfZ; z++)
 			{
-				for (int x = 0; x < m_Size.x; x++)
-				{
-					std::swap(m_BlockTypes[MakeIndex(x, y, z)], m_BlockTypes[MakeIndex(x, y, MaxZ - z)]);
-				}  // for x
+				auto Row1 = &m_BlockTypes[MakeIndex(0, y, z)];
+				std::swap_ranges(Row1, Row1 + m_Size.x, &m_BlockTypes[MakeIndex(0, y, MaxZ - z)]);
 			}  // for z
 		}  // for y
 	}  // if (HasBlockTypes)
@@ -1475,10 +1598,8 @@ void cBlockArea::MirrorXYNoMeta(void)
 		{
 			for (int z = 0; z < HalfZ; z++)
 			{
-				for (int x = 0; x < m_Size.x; x++)
-				{
-					std::swap(m_BlockMetas[MakeIndex(x, y, z)], m_BlockMetas[MakeIndex(x, y, MaxZ - z)]);
-				}  // for x
+				auto Row1 = &m_BlockMetas[MakeIndex(0, y, z)];
+				std::swap_ranges(Row1, Row1 + m_Size.x, &m_BlockMetas[MakeIndex(0, y, MaxZ - z)]);
 			}  // for z
 		}  // for y
 	}  // if (HasBlockMetas)
@@ -1509,17 +1630,13 @@ void cBlockArea::MirrorXZNoMeta(void)
 {
 	int HalfY = m_Size.y / 2;
 	int MaxY = m_Size.y - 1;
+	int LayerSize = m_Size.x * m_Size.z;
 	if (HasBlockTypes())
 	{
 		for (int y = 0; y < HalfY; y++)
 		{
-			for (int z = 0; z < m_Size.z; z++)
-			{
-				for (int x = 0; x < m_Size.x; x++)
-				{
-					std::swap(m_BlockTypes[MakeIndex(x, y, z)], m_BlockTypes[MakeIndex(x, MaxY - y, z)]);
-				}  // for x
-			}  // for z
+			auto Layer1 = &m_BlockTypes[MakeIndex(0, y, 0)];
+			std::swap_ranges(Layer1, Layer1 + LayerSize, &m_BlockTypes[MakeIndex(0, MaxY - y, 0)]);
 		}  // for y
 	}  // if (HasBlockTypes)
 
@@ -1527,13 +1644,8 @@ void cBlockArea::MirrorXZNoMeta(void)
 	{
 		for (int y = 0; y < HalfY; y++)
 		{
-			for (int z = 0; z < m_Size.z; z++)
-			{
-				for (int x = 0; x < m_Size.x; x++)
-				{
-					std::swap(m_BlockMetas[MakeIndex(x, y, z)], m_BlockMetas[MakeIndex(x, MaxY - y, z)]);
-				}  // for x
-			}  // for z
+			auto Layer1 = &m_BlockMetas[MakeIndex(0, y, 0)];
+			std::swap_ranges(Layer1, Layer1 + LayerSize, &m_BlockMetas[MakeIndex(0, MaxY - y, 0)]);
 		}  // for y
 	}  // if (HasBlockMetas)
 
@@ -1561,7 +1673,6 @@ void cBlockArea::MirrorXZNoMeta(void)
 
 void cBlockArea::MirrorYZNoMeta(void)
 {
-	int HalfX = m_Size.x / 2;
 	int MaxX = m_Size.x - 1;
 	if (HasBlockTypes())
 	{
@@ -1569,10 +1680,8 @@ void cBlockArea::MirrorYZNoMeta(void)
 		{
 			for (int z = 0; z < m_Size.z; z++)
 			{
-				for (int x = 0; x < HalfX; x++)
-				{
-					std::swap(m_BlockTypes[MakeIndex(x, y, z)], m_BlockTypes[MakeIndex(MaxX - x, y, z)]);
-				}  // for x
+				auto Row = &m_BlockTypes[MakeIndex(0, y, z)];
+				std::reverse(Row, Row + m_Size.x);
 			}  // for z
 		}  // for y
 	}  // if (HasBlockTypes)
@@ -1583,10 +1692,8 @@ void cBlockArea::MirrorYZNoMeta(void)
 		{
 			for (int z = 0; z < m_Size.z; z++)
 			{
-				for (int x = 0; x < HalfX; x++)
-				{
-					std::swap(m_BlockMetas[MakeIndex(x, y, z)], m_BlockMetas[MakeIndex(MaxX - x, y, z)]);
-				}  // for x
+				auto Row = &m_BlockMetas[MakeIndex(0, y, z)];
+				std::reverse(Row, Row + m_Size.x);
 			}  // for z
 		}  // for y
 	}  // if (HasBlockMetas)
@@ -2790,6 +2897,60 @@ bool cBlockArea::cChunkReader::Coords(int a_ChunkX, int a_ChunkZ)
 
 
 void cBlockArea::cChunkReader::ChunkData(const ChunkBlockData & a_BlockData, const ChunkLightData & a_LightData)
+{
+	// Only take the snapshot of the data here, the chunk map is locked; the snapshots are copied in CopySnapshots().
+	// Copy only the sections that intersect the area, and only the datatypes that the area holds:
+	auto Snapshot = std::make_unique<sChunkSnapshot>();
+	Snapshot->m_ChunkX = m_CurrentChunkX;
+	Snapshot->m_ChunkZ = m_CurrentChunkZ;
+	const auto MinSection = static_cast<size_t>(m_Origin.y / cChunkDef::SectionHeight);
+	const auto MaxSection = static_cast<size_t>((m_Origin.y + m_Area.m_Size.y - 1) / cChunkDef::SectionHeight);
+	for (auto Y = MinSection; Y <= MaxSection; ++Y)
+	{
+		if (m_Area.m_BlockTypes != nullptr)
+		{
+			SnapshotSection(Snapshot->m_BlockTypes, a_BlockData.GetSection(Y), Y);
+		}
+		if (m_Area.m_BlockMetas != nullptr)
+		{
+			SnapshotSection(Snapshot->m_BlockMetas, a_BlockData.GetMetaSection(Y), Y);
+		}
+		if (m_Area.m_BlockLight != nullptr)
+		{
+			SnapshotSection(Snapshot->m_BlockLight, a_LightData.GetBlockLightSection(Y), Y);
+		}
+		if (m_Area.m_BlockSkyLight != nullptr)
+		{
+			SnapshotSection(Snapshot->m_BlockSkyLight, a_LightData.GetSkyLightSection(Y), Y);
+		}
+	}
+	m_Snapshots.push_back(std::move(Snapshot));
+}
+
+
+
+
+
+void cBlockArea::cChunkReader::CopySnapshots(void)
+{
+	// Each chunk covers different columns of the area, so the chunks can be copied in parallel:
+	const auto BlocksPerChunk = static_cast<size_t>(cChunkDef::Width * cChunkDef::Width * m_Area.m_Size.y);
+	ForEachSliceParallel(static_cast<int>(m_Snapshots.size()), BlocksPerChunk, [this](int a_Start, int a_End)
+		{
+			for (int i = a_Start; i < a_End; i++)
+			{
+				CopySnapshot(*m_Snapshots[static_cast<size_t>(i)]);
+			}
+		}
+	);
+	m_Snapshots.clear();
+}
+
+
+
+
+
+void cBlockArea::cChunkReader::CopySnapshot(const sChunkSnapshot & a_Snapshot)
 {
 	int SizeY = m_Area.m_Size.y;
 	int MinY = m_Origin.y;
@@ -2801,7 +2962,7 @@ void cBlockArea::cChunkReader::ChunkData(const ChunkBlockData & a_BlockData, con
 	int SizeZ = cChunkDef::Width;
 	int OffX, OffZ;
 	int BaseX, BaseZ;
-	OffX = m_CurrentChunkX * cChunkDef::Width - m_Origin.x;
+	OffX = a_Snapshot.m_ChunkX * cChunkDef::Width - m_Origin.x;
 	if (OffX < 0)
 	{
 		BaseX = -OffX;
@@ -2812,7 +2973,7 @@ void cBlockArea::cChunkReader::ChunkData(const ChunkBlockData & a_BlockData, con
 	{
 		BaseX = 0;
 	}
-	OffZ = m_CurrentChunkZ * cChunkDef::Width - m_Origin.z;
+	OffZ = a_Snapshot.m_ChunkZ * cChunkDef::Width - m_Origin.z;
 	if (OffZ < 0)
 	{
 		BaseZ = -OffZ;
@@ -2824,13 +2985,13 @@ void cBlockArea::cChunkReader::ChunkData(const ChunkBlockData & a_BlockData, con
 		BaseZ = 0;
 	}
 	// If the chunk extends beyond the area in the X or Z axis, cut off the Size:
-	if ((m_CurrentChunkX + 1) * cChunkDef::Width > m_Origin.x + m_Area.m_Size.x)
+	if ((a_Snapshot.m_ChunkX + 1) * cChunkDef::Width > m_Origin.x + m_Area.m_Size.x)
 	{
-		SizeX -= (m_CurrentChunkX + 1) * cChunkDef::Width - (m_Origin.x + m_Area.m_Size.x);
+		SizeX -= (a_Snapshot.m_ChunkX + 1) * cChunkDef::Width - (m_Origin.x + m_Area.m_Size.x);
 	}
-	if ((m_CurrentChunkZ + 1) * cChunkDef::Width > m_Origin.z + m_Area.m_Size.z)
+	if ((a_Snapshot.m_ChunkZ + 1) * cChunkDef::Width > m_Origin.z + m_Area.m_Size.z)
 	{
-		SizeZ -= (m_CurrentChunkZ + 1) * cChunkDef::Width - (m_Origin.z + m_Area.m_Size.z);
+		SizeZ -= (a_Snapshot.m_ChunkZ + 1) * cChunkDef::Width - (m_Origin.z + m_Area.m_Size.z);
 	}
 
 	// Copy the blocktypes:
@@ -2848,7 +3009,7 @@ void cBlockArea::cChunkReader::ChunkData(const ChunkBlockData & a_BlockData, con
 				{
 					int InChunkX = BaseX + x;
 					int AreaX = OffX + x;
-					m_Area.m_BlockTypes[m_Area.MakeIndex(AreaX, AreaY, AreaZ)] = a_BlockData.GetBlock({ InChunkX, InChunkY, InChunkZ });
+					m_Area.m_BlockTypes[m_Area.MakeIndex(AreaX, AreaY, AreaZ)] = a_Snapshot.m_BlockTypes.Get({ InChunkX, InChunkY, InChunkZ });
 				}  // for x
 			}  // for z
 		}  // for y
@@ -2869,7 +3030,7 @@ void cBlockArea::cChunkReader::ChunkData(const ChunkBlockData & a_BlockData, con
 				{
 					int InChunkX = BaseX + x;
 					int AreaX = OffX + x;
-					m_Area.m_BlockMetas[m_Area.MakeIndex(AreaX, AreaY, AreaZ)] = a_BlockData.GetMeta({ InChunkX, InChunkY, InChunkZ });
+					m_Area.m_BlockMetas[m_Area.MakeIndex(AreaX, AreaY, AreaZ)] = a_Snapshot.m_BlockMetas.Get({ InChunkX, InChunkY, InChunkZ });
 				}  // for x
 			}  // for z
 		}  // for y
@@ -2890,7 +3051,7 @@ void cBlockArea::cChunkReader::ChunkData(const ChunkBlockData & a_BlockData, con
 				{
 					int InChunkX = BaseX + x;
 					int AreaX = OffX + x;
-					m_Area.m_BlockLight[m_Area.MakeIndex(AreaX, AreaY, AreaZ)] = a_LightData.GetBlockLight({ InChunkX, InChunkY, InChunkZ });
+					m_Area.m_BlockLight[m_Area.MakeIndex(AreaX, AreaY, AreaZ)] = a_Snapshot.m_BlockLight.Get({ InChunkX, InChunkY, InChunkZ });
 				}  // for x
 			}  // for z
 		}  // for y
@@ -2911,7 +3072,7 @@ void cBlockArea::cChunkReader::ChunkData(const ChunkBlockData & a_BlockData, con
 				{
 					int InChunkX = BaseX + x;
 					int AreaX = OffX + x;
-					m_Area.m_BlockSkyLight[m_Area.MakeIndex(AreaX, AreaY, AreaZ)] = a_LightData.GetSkyLight({ InChunkX, InChunkY, InChunkZ });
+					m_Area.m_BlockSkyLight[m_Area.MakeIndex(AreaX, AreaY, AreaZ)] = a_Snapshot.m_BlockSkyLight.Get({ InChunkX, InChunkY, InChunkZ });
 				}  // for x
 			}  // for z
 		}  // for y
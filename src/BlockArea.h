@@ -429,24 +429,52 @@ public:
 
 protected:
 
+	friend class cBlockAreaWriter;
 	friend class cChunkDesc;
 	friend class cSchematicFileSerializer;
 
+	/** Reads the chunk data into the area.
+	While the chunks are being enumerated (with the chunk map locked), only a snapshot of each chunk's data is taken,
+	limited to the sections that intersect the area and to the datatypes that the area holds;
+	the snapshots are then copied into the area by CopySnapshots(), in parallel and without holding any locks. */
 	class cChunkReader:
 		public cChunkDataCallback
 	{
 	public:
 		cChunkReader(cBlockArea & a_Area);
 
+		/** Copies the data from all the chunk snapshots taken so far into the area, and frees the snapshots. */
+		void CopySnapshots(void);
+
 	protected:
+
+		/** A copy of a single chunk's sections that intersect the area, only the datatypes that the area holds.
+		The sections not copied read as the default values, same as the sections the chunk doesn't have. */
+		struct sChunkSnapshot
+		{
+			int m_ChunkX;
+			int m_ChunkZ;
+			ChunkDataStore<BLOCKTYPE, ChunkBlockData::SectionBlockCount, ChunkBlockData::DefaultValue> m_BlockTypes;
+			ChunkDataStore<NIBBLETYPE, ChunkBlockData::SectionMetaCount, ChunkBlockData::DefaultMetaValue> m_BlockMetas;
+			ChunkDataStore<NIBBLETYPE, ChunkLightData::SectionLightCount, ChunkLightData::DefaultBlockLightValue> m_BlockLight;
+			ChunkDataStore<NIBBLETYPE, ChunkLightData::SectionLightCount, ChunkLightData::DefaultSkyLightValue> m_BlockSkyLight;
+		};
+
 		cBlockArea & m_Area;
 		cCuboid m_AreaBounds;  ///< Bounds of the whole area being read, in world coords
 		Vector3i m_Origin;
 		int m_CurrentChunkX;
 		int m_CurrentChunkZ;
 
+		/** The snapshots of the chunks enumerated so far, waiting for CopySnapshots(). */
+		std::vector<std::unique_ptr<sChunkSnapshot>> m_Snapshots;
+
 		void CopyNibbles(NIBBLETYPE * a_AreaDst, const NIBBLETYPE * a_ChunkSrc);
 
+		/** Copies the data from the single chunk snapshot into the area.
+		Writes only the area's blocks in the chunk's columns, so different chunks can be copied in parallel. */
+		void CopySnapshot(const sChunkSnapshot & a_Snapshot);
+
 		// cChunkDataCallback overrides:
 		virtual bool Coords(int a_ChunkX, int a_ChunkZ) override;
 		virtual void ChunkData(const ChunkBlockData & a_BlockData, const ChunkLightData & a_LightData) override;
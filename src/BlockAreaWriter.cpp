@@ -0,0 +1,146 @@
+// BlockAreaWriter.cpp
+
+// Implements the cBlockAreaWriter class that writes a block area into the world in small, bounded steps
+
+#include "Globals.h"
+#include "BlockAreaWriter.h"
+#include "ForEachChunkProvider.h"
+#include "BlockEntities/BlockEntity.h"
+
+
+
+
+
+/** Splits the world coord range [a_Min, a_Min + a_Size) at the multiples of a_Step (the chunk or section borders).
+Returns the pieces as {Start, Size} pairs, relative to a_Min. */
+static std::vector<std::pair<int, int>> SplitRange(int a_Min, int a_Size, int a_Step)
+{
+	std::vector<std::pair<int, int>> Res;
+	int Start = 0;
+	while (Start < a_Size)
+	{
+		const int Abs = a_Min + Start;
+		const int NextBorder = Abs - (((Abs % a_Step) + a_Step) % a_Step) + a_Step;
+		const int End = std::min(a_Size, NextBorder - a_Min);
+		Res.emplace_back(Start, End - Start);
+		Start = End;
+	}
+	return Res;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cBlockAreaWriter:
+
+cBlockAreaWriter::cBlockAreaWriter(std::shared_ptr<const cBlockArea> a_Area, Vector3i a_MinCoords, int a_DataTypes):
+	m_Area(std::move(a_Area)),
+	m_MinCoords(a_MinCoords),
+	m_DataTypes(a_DataTypes),
+	m_NextStep(0),
+	m_IsSuccessful(true)
+{
+	// Split the area into the pieces within single chunk sections, chunk by chunk:
+	const auto & Size = m_Area->GetSize();
+	const auto RangesX = SplitRange(m_MinCoords.x, Size.x, cChunkDef::Width);
+	const auto RangesY = SplitRange(m_MinCoords.y, Size.y, cChunkDef::SectionHeight);
+	const auto RangesZ = SplitRange(m_MinCoords.z, Size.z, cChunkDef::Width);
+	m_Steps.reserve(RangesX.size() * RangesY.size() * RangesZ.size());
+	for (const auto & RangeZ: RangesZ)
+	{
+		for (const auto & RangeX: RangesX)
+		{
+			for (const auto & RangeY: RangesY)
+			{
+				m_Steps.push_back({
+					{ RangeX.first, RangeY.first, RangeZ.first },
+					{ RangeX.second, RangeY.second, RangeZ.second }
+				});
+			}
+		}
+	}
+}
+
+
+
+
+
+bool cBlockAreaWriter::WriteSteps(cForEachChunkProvider & a_ForEachChunkProvider, size_t a_MaxBlocks)
+{
+	size_t NumBlocks = 0;
+	while (!IsFinished() && (NumBlocks < a_MaxBlocks))
+	{
+		const auto & Step = m_Steps[m_NextStep];
+		m_NextStep += 1;
+		PrepareStep(Step);
+		const auto Min = m_MinCoords + Step.m_Min;
+		if (!a_ForEachChunkProvider.WriteBlockArea(m_StepArea, Min.x, Min.y, Min.z, m_DataTypes))
+		{
+			m_IsSuccessful = false;
+		}
+		NumBlocks += static_cast<size_t>(Step.m_Size.x * Step.m_Size.y * Step.m_Size.z);
+	}
+	return IsFinished();
+}
+
+
+
+
+
+void cBlockAreaWriter::PrepareStep(const sStep & a_Step)
+{
+	const auto & Src = *m_Area;
+	m_StepArea.Clear();
+	m_StepArea.SetSize(a_Step.m_Size.x, a_Step.m_Size.y, a_Step.m_Size.z, m_DataTypes & Src.GetDataTypes());
+
+	// Copy the block data, row by row:
+	for (int y = 0; y < a_Step.m_Size.y; y++)
+	{
+		for (int z = 0; z < a_Step.m_Size.z; z++)
+		{
+			const auto SrcIdx = Src.MakeIndex(a_Step.m_Min + Vector3i(0, y, z));
+			const auto DstIdx = m_StepArea.MakeIndex(0, y, z);
+			if (m_StepArea.HasBlockTypes())
+			{
+				std::copy_n(Src.m_BlockTypes.get() + SrcIdx, a_Step.m_Size.x, m_StepArea.m_BlockTypes.get() + DstIdx);
+			}
+			if (m_StepArea.HasBlockMetas())
+			{
+				std::copy_n(Src.m_BlockMetas.get() + SrcIdx, a_Step.m_Size.x, m_StepArea.m_BlockMetas.get() + DstIdx);
+			}
+			if (m_StepArea.HasBlockLights())
+			{
+				std::copy_n(Src.m_BlockLight.get() + SrcIdx, a_Step.m_Size.x, m_StepArea.m_BlockLight.get() + DstIdx);
+			}
+			if (m_StepArea.HasBlockSkyLights())
+			{
+				std::copy_n(Src.m_BlockSkyLight.get() + SrcIdx, a_Step.m_Size.x, m_StepArea.m_BlockSkyLight.get() + DstIdx);
+			}
+		}
+	}
+
+	// Clone the block entities within the piece:
+	if (!m_StepArea.HasBlockEntities() || !m_StepArea.HasBlockTypes())
+	{
+		return;
+	}
+	for (int y = 0; y < a_Step.m_Size.y; y++) for (int z = 0; z < a_Step.m_Size.z; z++) for (int x = 0; x < a_Step.m_Size.x; x++)
+	{
+		const auto DstIdx = m_StepArea.MakeIndex(x, y, z);
+		if (!cBlockEntity::IsBlockEntityBlockType(m_StepArea.m_BlockTypes[DstIdx]))
+		{
+			continue;
+		}
+		const auto itr = Src.m_BlockEntities->find(Src.MakeIndex(a_Step.m_Min + Vector3i(x, y, z)));
+		if (itr != Src.m_BlockEntities->end())
+		{
+			m_StepArea.m_BlockEntities->emplace(DstIdx, itr->second->Clone({ x, y, z }));
+		}
+	}
+}
+
+
+
+
@@ -0,0 +1,84 @@
+// BlockAreaWriter.h
+
+// Declares the cBlockAreaWriter class that writes a block area into the world in small, bounded steps
+
+/*
+Writing a large area (cBlockArea:Write()) sets all of its blocks within a single call, which blocks the world tick for
+as long as it takes. The writer splits the area along the chunk and section borders and writes one such piece (at most
+16 * 16 * 16 blocks) per step, so that the writing can be spread over several ticks; see cWorld::WriteBlockAreaInSteps().
+The world sees the area partially written in between the steps.
+*/
+
+
+
+
+
+#pragma once
+
+#include "BlockArea.h"
+
+// fwd:
+class cForEachChunkProvider;
+
+
+
+
+
+class cBlockAreaWriter
+{
+public:
+
+	/** The number of blocks that cWorld::WriteBlockAreaInSteps() writes in a single tick. */
+	static const size_t BLOCKS_PER_TICK = 32 * 1024;
+
+
+	/** Creates a writer of the area's a_DataTypes into the world at a_MinCoords.
+	The area must not be modified until the writer is finished. */
+	cBlockAreaWriter(std::shared_ptr<const cBlockArea> a_Area, Vector3i a_MinCoords, int a_DataTypes);
+
+	/** Writes the next pieces of the area, until at least a_MaxBlocks blocks have been written or the whole area is done.
+	Returns true once the whole area has been written. */
+	bool WriteSteps(cForEachChunkProvider & a_ForEachChunkProvider, size_t a_MaxBlocks);
+
+	/** Returns true if all the pieces written so far have been written, false if any of their chunks wasn't available. */
+	bool IsSuccessful(void) const { return m_IsSuccessful; }
+
+	/** Returns true once the whole area has been written. */
+	bool IsFinished(void) const { return (m_NextStep >= m_Steps.size()); }
+
+	/** Returns the number of the pieces into which the area is split. */
+	size_t GetNumSteps(void) const { return m_Steps.size(); }
+
+protected:
+
+	/** A piece of the area within a single chunk section, in the area's relative coords. */
+	struct sStep
+	{
+		Vector3i m_Min;
+		Vector3i m_Size;
+	};
+
+
+	std::shared_ptr<const cBlockArea> m_Area;
+	Vector3i m_MinCoords;
+	int m_DataTypes;
+
+	/** The pieces of the area, chunk by chunk and bottom-up within each chunk, in the order of writing. */
+	std::vector<sStep> m_Steps;
+
+	/** The index into m_Steps of the piece to be written next. */
+	size_t m_NextStep;
+
+	bool m_IsSuccessful;
+
+	/** The area holding the copy of the piece being written. */
+	cBlockArea m_StepArea;
+
+
+	/** Copies the specified piece of the area into m_StepArea, block entities included. */
+	void PrepareStep(const sStep & a_Step);
+};
+
+
+
+
@@ -24,6 +24,8 @@
 #include "JukeboxEntity.h"
 #include "NoteEntity.h"
 #include "SignEntity.h"
+#include "../Chunk.h"
+#include "../World.h"
 
 
 
@@ -35,7 +37,10 @@ cBlockEntity::cBlockEntity(const BLOCKTYPE a_BlockType, const NIBBLETYPE a_Block
 	m_RelZ(a_Pos.z - cChunkDef::Width * FAST_FLOOR_DIV(a_Pos.z, cChunkDef::Width)),
 	m_BlockType(a_BlockType),
 	m_BlockMeta(a_BlockMeta),
-	m_World(a_World)
+	m_World(a_World),
+	m_IsSleeping(false),
+	m_WantsToSleep(false),
+	m_WakeUpAge(cTickTimeLong::max())
 {
 }
 
@@ -207,5 +212,38 @@ void cBlockEntity::SetWorld(cWorld * const a_World)
 bool cBlockEntity::Tick(const std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 {
 	UNUSED(a_Dt);
+
+	// Nothing to do until something changes:
+	Sleep();
 	return false;
 }
+
+
+
+
+
+void cBlockEntity::WakeUp(void)
+{
+	m_WantsToSleep = false;
+	if (!m_IsSleeping || (m_World == nullptr))
+	{
+		return;
+	}
+
+	m_World->DoWithChunk(GetChunkX(), GetChunkZ(), [this](cChunk & a_Chunk)
+		{
+			a_Chunk.WakeUpBlockEntity(*this);
+			return true;
+		}
+	);
+}
+
+
+
+
+
+void cBlockEntity::Sleep(const cTickTimeLong a_WakeUpAge)
+{
+	m_WantsToSleep = true;
+	m_WakeUpAge = a_WakeUpAge;
+}
@@ -23,6 +23,12 @@ using cBlockEntities = std::unordered_map<size_t, OwnedBlockEntity>;
 // tolua_begin
 class cBlockEntity
 {
+	// tolua_end
+
+	template <class> friend class cBlockEntityTickScheduler;  // Manages the sleeping state
+
+	// tolua_begin
+
 protected:
 
 	cBlockEntity(BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta, Vector3i a_Pos, cWorld * a_World);
@@ -77,9 +83,19 @@ public:
 
 	void SetWorld(cWorld * a_World);
 
-	/** Ticks the entity; returns true if the chunk should be marked as dirty as a result of this ticking. By default does nothing. */
+	/** Ticks the entity; returns true if the chunk should be marked as dirty as a result of this ticking.
+	Descendants that have nothing to do should call Sleep() so that they aren't ticked needlessly.
+	By default does nothing and sleeps until woken up. */
 	virtual bool Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk);
 
+	/** Wakes the block entity up, if it is sleeping, so that it is ticked again.
+	The chunk wakes up the block entities on changes in their neighborhood and in their contents (via cSimulatorManager::WakeUp()),
+	descendants should call this whenever their state changes in a way that needs ticking. */
+	void WakeUp(void);
+
+	/** Returns true if the block entity is sleeping - not being ticked until woken up. */
+	bool IsSleeping(void) const { return m_IsSleeping; }
+
 	/** Called when a player uses this entity; should open the UI window.
 	returns true if the use was successful, return false to use the block as a "normal" block */
 	virtual bool UsedBy(cPlayer * a_Player) = 0;
@@ -124,4 +140,20 @@ protected:
 	NIBBLETYPE m_BlockMeta;
 
 	cWorld * m_World;
+
+
+	/** Requests the block entity to stop being ticked after the current tick.
+	It will be ticked again once woken up by WakeUp(), or once the world age reaches a_WakeUpAge. */
+	void Sleep(cTickTimeLong a_WakeUpAge = cTickTimeLong::max());
+
+private:
+
+	/** Set by the chunk's cBlockEntityTickScheduler while the block entity is not being ticked. */
+	bool m_IsSleeping;
+
+	/** Set by Sleep(), processed by the chunk's cBlockEntityTickScheduler after the tick. Cleared by WakeUp(). */
+	bool m_WantsToSleep;
+
+	/** The world age at which the sleeping block entity is woken up; cTickTimeLong::max() for none. */
+	cTickTimeLong m_WakeUpAge;
 } ;  // tolua_export
@@ -0,0 +1,166 @@
+
+// BlockEntityTickScheduler.h
+
+// Declares the cBlockEntityTickScheduler class that decides which of a chunk's block entities are ticked
+
+/*
+The block entities start awake and are ticked each tick. A block entity that has nothing to do requests sleep from
+its Tick (cBlockEntity::Sleep()) and is no longer ticked, until it is woken up by WakeUp(), or until the world age
+reaches the wake-up age it requested.
+The scheduler is a template only so that it can be tested without the world; the chunk uses it with cBlockEntity.
+The block entity type needs these members, accessible to the scheduler:
+	bool m_IsSleeping;            // Maintained by the scheduler
+	bool m_WantsToSleep;          // Set by the block entity's tick to request sleep
+	cTickTimeLong m_WakeUpAge;    // The scheduled wake-up requested along with sleep; cTickTimeLong::max() for none
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+template <class BlockEntityType>
+class cBlockEntityTickScheduler
+{
+public:
+
+	/** Adds the block entity to the scheduling, awake. */
+	void Add(BlockEntityType & a_BlockEntity)
+	{
+		a_BlockEntity.m_IsSleeping = false;
+		a_BlockEntity.m_WantsToSleep = false;
+		a_BlockEntity.m_WakeUpAge = cTickTimeLong::max();
+		m_Awake.push_back(&a_BlockEntity);
+	}
+
+
+	/** Removes the block entity from the scheduling. Must be called before the block entity is destroyed.
+	May be called while ticking, even from the tick of the block entity being removed. */
+	void Remove(BlockEntityType & a_BlockEntity)
+	{
+		// Only replace with nullptr, the list may be being iterated over in Tick():
+		std::replace(m_Awake.begin(), m_Awake.end(), &a_BlockEntity, static_cast<BlockEntityType *>(nullptr));
+		UnscheduleWakeUp(a_BlockEntity);
+	}
+
+
+	/** Removes all the block entities from the scheduling. */
+	void Clear(void)
+	{
+		m_Awake.clear();
+		m_WakeUps.clear();
+	}
+
+
+	/** Wakes up the block entity, if it is sleeping, and cancels its sleep request, if it has made one in its current tick. */
+	void WakeUp(BlockEntityType & a_BlockEntity)
+	{
+		a_BlockEntity.m_WantsToSleep = false;
+		if (!a_BlockEntity.m_IsSleeping)
+		{
+			return;
+		}
+		a_BlockEntity.m_IsSleeping = false;
+		m_Awake.push_back(&a_BlockEntity);
+		UnscheduleWakeUp(a_BlockEntity);
+	}
+
+
+	/** Wakes up the block entities whose scheduled wake-up age has come, then calls a_Tick for each awake block entity.
+	Those that request sleep in a_Tick are put to sleep. Block entities woken up while ticking are ticked from the next tick on. */
+	template <class TickCallback>
+	void Tick(const cTickTimeLong a_WorldAge, TickCallback a_Tick)
+	{
+		// Wake up the block entities whose scheduled time has come:
+		while (!m_WakeUps.empty() && (m_WakeUps.begin()->first <= a_WorldAge))
+		{
+			auto BlockEntity = m_WakeUps.begin()->second;
+			m_WakeUps.erase(m_WakeUps.begin());
+			BlockEntity->m_WakeUpAge = cTickTimeLong::max();
+			WakeUp(*BlockEntity);
+		}
+
+		// Tick the awake block entities, compacting the list as those that want to sleep drop out:
+		const auto NumToTick = m_Awake.size();
+		size_t NumAwake = 0;
+		for (size_t i = 0; i < NumToTick; i++)
+		{
+			auto BlockEntity = m_Awake[i];
+			if (BlockEntity == nullptr)
+			{
+				// Removed while ticking another block entity
+				continue;
+			}
+
+			a_Tick(*BlockEntity);
+
+			if (m_Awake[i] == nullptr)
+			{
+				// Removed by its own tick
+				continue;
+			}
+			if (BlockEntity->m_WantsToSleep)
+			{
+				BlockEntity->m_WantsToSleep = false;
+				BlockEntity->m_IsSleeping = true;
+				if (BlockEntity->m_WakeUpAge != cTickTimeLong::max())
+				{
+					m_WakeUps.emplace(BlockEntity->m_WakeUpAge, BlockEntity);
+				}
+				continue;
+			}
+			m_Awake[NumAwake++] = BlockEntity;
+		}
+
+		// Keep the block entities woken up while ticking:
+		for (size_t i = NumToTick; i < m_Awake.size(); i++)
+		{
+			if (m_Awake[i] != nullptr)
+			{
+				m_Awake[NumAwake++] = m_Awake[i];
+			}
+		}
+		m_Awake.resize(NumAwake);
+	}
+
+
+	/** Returns the number of the awake block entities. Only exact outside of Tick(). */
+	size_t GetNumAwake(void) const { return m_Awake.size(); }
+
+	/** Returns the number of the scheduled wake-ups. */
+	size_t GetNumWakeUps(void) const { return m_WakeUps.size(); }
+
+protected:
+
+	/** The block entities that are awake and ticked each tick; the sleeping ones are not included.
+	Block entities removed while ticking are replaced with nullptr, until the list is compacted after the tick. */
+	std::vector<BlockEntityType *> m_Awake;
+
+	/** The sleeping block entities that have a scheduled wake-up, by the world age of the wake-up. */
+	std::multimap<cTickTimeLong, BlockEntityType *> m_WakeUps;
+
+
+	/** Removes the block entity's scheduled wake-up, if it has one. */
+	void UnscheduleWakeUp(BlockEntityType & a_BlockEntity)
+	{
+		if (a_BlockEntity.m_WakeUpAge == cTickTimeLong::max())
+		{
+			return;
+		}
+		auto Range = m_WakeUps.equal_range(a_BlockEntity.m_WakeUpAge);
+		for (auto itr = Range.first; itr != Range.second; ++itr)
+		{
+			if (itr->second == &a_BlockEntity)
+			{
+				m_WakeUps.erase(itr);
+				break;
+			}
+		}
+		a_BlockEntity.m_WakeUpAge = cTickTimeLong::max();
+	}
+};
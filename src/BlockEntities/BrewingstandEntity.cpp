@@ -75,6 +75,8 @@ bool cBrewingstandEntity::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 
 	if (!m_IsBrewing)
 	{
+		// Nothing to do until the contents change (OnSlotChanged wakes us):
+		Sleep();
 		return false;
 	}
 
@@ -279,6 +281,7 @@ void cBrewingstandEntity::OnSlotChanged(cItemGrid * a_ItemGrid, int a_SlotNum)
 	if (!m_IsBrewing)
 	{
 		m_IsBrewing = true;
+		WakeUp();
 	}
 }
 
@@ -307,6 +310,7 @@ void cBrewingstandEntity::ContinueBrewing(void)
 	if ((m_TimeBrewed > 0) && (m_RemainingFuel > 0))
 	{
 		m_IsBrewing = true;
+		WakeUp();
 	}
 }
 
@@ -97,6 +97,7 @@ NIBBLETYPE cCommandBlockEntity::GetResult(void) const
 void cCommandBlockEntity::Activate(void)
 {
 	m_ShouldExecute = true;
+	WakeUp();
 }
 
 
@@ -123,6 +124,8 @@ bool cCommandBlockEntity::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 	UNUSED(a_Chunk);
 	if (!m_ShouldExecute)
 	{
+		// Nothing to do until activated:
+		Sleep();
 		return false;
 	}
 
@@ -100,6 +100,7 @@ void cDropSpenserEntity::DropSpense(cChunk & a_Chunk)
 void cDropSpenserEntity::Activate(void)
 {
 	m_ShouldDropSpense = true;
+	WakeUp();
 }
 
 
@@ -137,6 +138,8 @@ bool cDropSpenserEntity::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 	UNUSED(a_Dt);
 	if (!m_ShouldDropSpense)
 	{
+		// Nothing to do until activated:
+		Sleep();
 		return false;
 	}
 
@@ -96,6 +96,12 @@ bool cFurnaceEntity::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 		m_BlockType = E_BLOCK_FURNACE;
 		a_Chunk.FastSetBlock(GetRelPos(), E_BLOCK_FURNACE, m_BlockMeta);
 		UpdateProgressBars();
+
+		// Once the progress bar is back to zero, there's nothing to do until new fuel or input arrives (OnSlotChanged wakes us):
+		if (m_TimeCooked == 0)
+		{
+			Sleep();
+		}
 		return false;
 	}
 
@@ -40,6 +40,10 @@ cHopperEntity::cHopperEntity(BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta, Vect
 void cHopperEntity::SetLocked(bool a_Value)
 {
 	m_Locked = a_Value;
+	if (!m_Locked)
+	{
+		WakeUp();
+	}
 }
 
 
@@ -84,14 +88,24 @@ bool cHopperEntity::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 {
 	UNUSED(a_Dt);
 
-	bool isDirty = false;
-	if (!m_Locked)
+	if (m_Locked)
 	{
-		const auto CurrentTick = a_Chunk.GetWorld()->GetWorldAge();
-		isDirty = MoveItemsIn(a_Chunk, CurrentTick) || isDirty;
-		isDirty = MovePickupsIn(a_Chunk) || isDirty;
-		isDirty = MoveItemsOut(a_Chunk, CurrentTick) || isDirty;
+		// Nothing to do until unlocked:
+		Sleep();
+		return false;
 	}
+
+	bool isDirty = false;
+	const auto CurrentTick = a_Chunk.GetWorld()->GetWorldAge();
+	isDirty = MoveItemsIn(a_Chunk, CurrentTick) || isDirty;
+	isDirty = MovePickupsIn(a_Chunk) || isDirty;
+	isDirty = MoveItemsOut(a_Chunk, CurrentTick) || isDirty;
+
+	// Neighbor changes and pickups falling in (cPickup::Tick()) wake the hopper up. A double chest's other half isn't
+	// a neighbor, and the transfers have a cooldown, so poll for the transfers at the transfer rate:
+	const auto NextMoveIn = std::max(m_LastMoveItemsInTick + TICKS_PER_TRANSFER, CurrentTick + TICKS_PER_TRANSFER);
+	const auto NextMoveOut = std::max(m_LastMoveItemsOutTick + TICKS_PER_TRANSFER, CurrentTick + TICKS_PER_TRANSFER);
+	Sleep(std::min(NextMoveIn, NextMoveOut));
 	return isDirty;
 }
 
@@ -119,13 +119,22 @@ cChunk::~cChunk()
 
 void cChunk::BroadcastPendingChanges(void)
 {
-	if (const auto PendingBlocksCount = m_PendingSendBlocks.size(); PendingBlocksCount >= 10240)
+	auto & Stats = m_ChunkMap->m_BlockChangeStats;
+	const auto NumQueued = m_PendingSendBlocks.size();
+	CoalesceSetBlocks(m_PendingSendBlocks);
+	const auto NumClients = m_LoadedByClient.size();
+	const auto PendingBlocksCount = m_PendingSendBlocks.size();
+	Stats.m_NumQueued += NumQueued;
+	Stats.m_NumCoalesced += NumQueued - PendingBlocksCount;
+
+	if (PendingBlocksCount >= MAX_PENDING_SEND_BLOCKS)
 	{
 		// Resend the full chunk:
 		for (const auto ClientHandle : m_LoadedByClient)
 		{
 			m_World->ForceSendChunkTo(m_PosX, m_PosZ, cChunkSender::Priority::Medium, ClientHandle);
 		}
+		Stats.m_NumChunkResends += NumClients;
 	}
 	else if (PendingBlocksCount == 0)
 	{
@@ -150,6 +159,12 @@ void cChunk::BroadcastPendingChanges(void)
 				BlockEntity->SendTo(*ClientHandle);
 			}
 		}
+		Stats.m_NumPacketsSent += NumClients;
+		if (NumQueued >= MAX_PENDING_SEND_BLOCKS)
+		{
+			// Without the coalescing, the whole chunk would have been resent:
+			Stats.m_NumChunkResendsAvoided += NumClients;
+		}
 	}
 
 	// Flush out all buffered data:
@@ -374,6 +389,7 @@ void cChunk::SetAllData(SetChunkData && a_SetChunkData)
 
 	// Clear the old ones:
 	m_BlockEntities = std::move(a_SetChunkData.BlockEntities);
+	m_BlockEntityScheduler.Clear();
 
 	// Check that all block entities have a valid blocktype at their respective coords (DEBUG-mode only):
 #ifndef NDEBUG
@@ -391,10 +407,11 @@ void cChunk::SetAllData(SetChunkData && a_SetChunkData)
 	// as well as some block entities upon being added to the chunk (Chests).
 	SetPresence(cpPresent);
 
-	// Initialise all block entities:
+	// Initialise all block entities, they start awake:
 	for (auto & KeyPair : m_BlockEntities)
 	{
 		KeyPair.second->OnAddToWorld(*m_World, *this);
+		m_BlockEntityScheduler.Add(*KeyPair.second);
 	}
 
 	// Wake up all simulators for their respective blocks:
@@ -487,6 +504,7 @@ void cChunk::WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlock
 			{
 				itr->second->Destroy();
 				itr->second->OnRemoveFromWorld();
+				m_BlockEntityScheduler.Remove(*itr->second);
 
 				PendingRemove = std::remove(m_PendingSendBlockEntities.begin(), PendingRemove, itr->second.get());  // Search the remaining valid pending sends.
 				itr = m_BlockEntities.erase(itr);
@@ -707,11 +725,12 @@ void cChunk::Tick(std::chrono::milliseconds a_Dt)
 
 	TickBlocks();
 
-	// Tick all block entities in this chunk:
-	for (auto & KeyPair : m_BlockEntities)
-	{
-		m_IsDirty = KeyPair.second->Tick(a_Dt, *this) | m_IsDirty;
-	}
+	// Tick the awake block entities in this chunk:
+	m_BlockEntityScheduler.Tick(m_World->GetWorldAge(), [this, a_Dt](cBlockEntity & a_BlockEntity)
+		{
+			m_IsDirty = a_BlockEntity.Tick(a_Dt, *this) | m_IsDirty;
+		}
+	);
 
 	for (auto itr = m_Entities.begin(); itr != m_Entities.end();)
 	{
@@ -1298,6 +1317,7 @@ void cChunk::SetBlock(Vector3i a_RelPos, BLOCKTYPE a_BlockType, NIBBLETYPE a_Blo
 
 		BlockEntity.Destroy();
 		BlockEntity.OnRemoveFromWorld();
+		m_BlockEntityScheduler.Remove(BlockEntity);
 
 		m_BlockEntities.erase(FindResult);
 		m_PendingSendBlockEntities.erase(std::remove(m_PendingSendBlockEntities.begin(), m_PendingSendBlockEntities.end(), &BlockEntity), m_PendingSendBlockEntities.end());
@@ -1430,6 +1450,7 @@ void cChunk::AddBlockEntity(OwnedBlockEntity a_BlockEntity)
 
 	ASSERT(Result.second);  // No block entity already at this position.
 	BlockEntityPtr->OnAddToWorld(*m_World, *this);
+	m_BlockEntityScheduler.Add(*BlockEntityPtr);
 }
 
 
@@ -1492,6 +1513,49 @@ void cChunk::SetAlwaysTicked(bool a_AlwaysTicked)
 
 
 
+void cChunk::WakeUpBlockEntity(Vector3i a_RelPos)
+{
+	if (m_BlockEntities.empty())
+	{
+		return;
+	}
+	auto itr = m_BlockEntities.find(cChunkDef::MakeIndex(a_RelPos));
+	if (itr != m_BlockEntities.end())
+	{
+		WakeUpBlockEntity(*itr->second);
+	}
+}
+
+
+
+
+
+void cChunk::WakeUpBlockEntity(cBlockEntity & a_BlockEntity)
+{
+	ASSERT((a_BlockEntity.GetChunkX() == m_PosX) && (a_BlockEntity.GetChunkZ() == m_PosZ));
+
+	m_BlockEntityScheduler.WakeUp(a_BlockEntity);
+}
+
+
+
+
+
+void cChunk::WakeUpBlockEntities(const cCuboid & a_Area)
+{
+	for (auto & KeyPair : m_BlockEntities)
+	{
+		if (KeyPair.second->IsSleeping() && a_Area.IsInside(KeyPair.second->GetPos()))
+		{
+			WakeUpBlockEntity(*KeyPair.second);
+		}
+	}
+}
+
+
+
+
+
 bool cChunk::UseBlockEntity(cPlayer * a_Player, int a_X, int a_Y, int a_Z)
 {
 	cBlockEntity * be = GetBlockEntity(a_X, a_Y, a_Z);
@@ -2,6 +2,7 @@
 #pragma once
 
 #include "BlockEntities/BlockEntity.h"
+#include "BlockEntities/BlockEntityTickScheduler.h"
 #include "ChunkData.h"
 
 #include "Simulator/FireSimulator.h"
@@ -18,6 +19,7 @@ class cClientHandle;
 class cPlayer;
 class cChunkMap;
 class cBoundingBox;
+class cCuboid;
 class cChunkDataCallback;
 class cBlockArea;
 class cBlockArea;
@@ -148,6 +150,9 @@ public:
 	BLOCKTYPE GetBlock(int a_RelX, int a_RelY, int a_RelZ) const { return m_BlockData.GetBlock({ a_RelX, a_RelY, a_RelZ }); }
 	BLOCKTYPE GetBlock(Vector3i a_RelCoords) const { return m_BlockData.GetBlock(a_RelCoords); }
 
+	/** Returns the chunk's block types and metas, for reading whole sections at once. */
+	const ChunkBlockData & GetBlockData(void) const { return m_BlockData; }
+
 	void GetBlockTypeMeta(Vector3i a_RelPos, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta) const;
 	void GetBlockTypeMeta(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta) const
 	{
@@ -250,6 +255,15 @@ public:
 	/** Calls the callback for the block entity at the specified coords; returns false if there's no block entity at those coords, and whatever the callback returns if found. */
 	bool DoWithBlockEntityAt(Vector3i a_Position, cBlockEntityCallback a_Callback);  // Lua-acessible
 
+	/** Wakes up the block entity at the specified relative coords, if there is one and it is sleeping. */
+	void WakeUpBlockEntity(Vector3i a_RelPos);
+
+	/** Wakes up the specified block entity, if it is sleeping. The block entity must reside in this chunk. */
+	void WakeUpBlockEntity(cBlockEntity & a_BlockEntity);
+
+	/** Wakes up all the sleeping block entities within the specified area (in world coords). */
+	void WakeUpBlockEntities(const cCuboid & a_Area);
+
 	/** Use block entity on coordinate.
 	returns true if the use was successful, return false to use the block as a "normal" block */
 	bool UseBlockEntity(cPlayer * a_Player, int a_X, int a_Y, int a_Z);  // [x, y, z] in world block coords
@@ -488,6 +502,9 @@ private:
 	It will collect the block changes that occur in a tick, before being flushed in BroadcastPendingSendBlocks. */
 	sSetBlockVector m_PendingSendBlocks;
 
+	/** If there are at least this many distinct pending block changes in a tick, the entire chunk is resent instead. */
+	static const size_t MAX_PENDING_SEND_BLOCKS = 10240;
+
 	/** Block entities that have been touched and need to be sent to all clients.
 	Because block changes are buffered and we need to happen after them, this buffer exists too.
 	Pointers to block entities that were destroyed are guaranteed to be removed from this array by SetAllData, SetBlock, WriteBlockArea. */
@@ -502,6 +519,9 @@ private:
 	std::vector<OwnedEntity> m_Entities;
 	cBlockEntities m_BlockEntities;
 
+	/** Decides which of the block entities are ticked; all of m_BlockEntities are added to it. */
+	cBlockEntityTickScheduler<cBlockEntity> m_BlockEntityScheduler;
+
 	/** Number of times the chunk has been requested to stay (by various cChunkStay objects); if zero, the chunk can be unloaded */
 	unsigned m_StayCount;
 
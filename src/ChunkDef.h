@@ -423,6 +423,41 @@ struct sSetBlock
 
 typedef std::vector<sSetBlock> sSetBlockVector;
 
+/** Removes the superseded changes from a_Changes, so that only the last change of each block remains.
+All the changes must be in the same chunk. The remaining changes are sorted by their block index. */
+inline void CoalesceSetBlocks(sSetBlockVector & a_Changes)
+{
+	if (a_Changes.size() < 2)
+	{
+		return;
+	}
+
+	// Sort by the block, keeping the changes of each block in the order in which they were made:
+	const auto Index = [](const sSetBlock & a_Change)
+	{
+		return cChunkDef::MakeIndex(a_Change.m_RelX, a_Change.m_RelY, a_Change.m_RelZ);
+	};
+	std::stable_sort(a_Changes.begin(), a_Changes.end(), [&Index](const sSetBlock & a_First, const sSetBlock & a_Second)
+		{
+			return (Index(a_First) < Index(a_Second));
+		}
+	);
+
+	// Keep only the last change in each run of the changes of the same block:
+	auto Kept = a_Changes.begin();
+	for (auto itr = a_Changes.begin(), end = a_Changes.end(); itr != end; ++itr)
+	{
+		const auto Next = itr + 1;
+		if ((Next != end) && (Index(*Next) == Index(*itr)))
+		{
+			continue;
+		}
+		*Kept = *itr;
+		++Kept;
+	}
+	a_Changes.erase(Kept, a_Changes.end());
+}
+
 typedef std::list<cChunkCoords> cChunkCoordsList;
 typedef std::vector<cChunkCoords> cChunkCoordsVector;
 
@@ -2,6 +2,7 @@
 #include "ChunkGeneratorThread.h"
 #include "Generating/ChunkGenerator.h"
 #include "Generating/ChunkDesc.h"
+#include "Metrics.h"
 
 
 
@@ -21,7 +22,9 @@ cChunkGeneratorThread::cChunkGeneratorThread(void) :
 	Super("Chunk Generator"),
 	m_Generator(nullptr),
 	m_PluginInterface(nullptr),
-	m_ChunkSink(nullptr)
+	m_ChunkSink(nullptr),
+	m_NumGeneratedMetric(nullptr),
+	m_GenerationTimeMetric(nullptr)
 {
 }
 
@@ -38,10 +41,12 @@ cChunkGeneratorThread::~cChunkGeneratorThread()
 
 
 
-bool cChunkGeneratorThread::Initialize(cPluginInterface & a_PluginInterface, cChunkSink & a_ChunkSink, cIniFile & a_IniFile)
+bool cChunkGeneratorThread::Initialize(cPluginInterface & a_PluginInterface, cChunkSink & a_ChunkSink, cIniFile & a_IniFile, const AString & a_WorldName)
 {
 	m_PluginInterface = &a_PluginInterface;
 	m_ChunkSink = &a_ChunkSink;
+	m_NumGeneratedMetric = &cMetrics::Get().GetCounter("cuberite_chunks_generated_total", "The number of the chunks generated", {{"world", a_WorldName}});
+	m_GenerationTimeMetric = &cMetrics::Get().GetHistogram("cuberite_chunk_generation_seconds", "The time taken to generate a chunk, including the plugin hooks", {{"world", a_WorldName}});
 
 	m_Generator = cChunkGenerator::CreateFromIniFile(a_IniFile);
 	if (m_Generator == nullptr)
@@ -245,6 +250,7 @@ void cChunkGeneratorThread::DoGenerate(cChunkCoords a_Coords)
 	ASSERT(m_PluginInterface != nullptr);
 	ASSERT(m_ChunkSink != nullptr);
 
+	cMetricTimer Timer(*m_GenerationTimeMetric);
 	cChunkDesc ChunkDesc(a_Coords);
 	m_PluginInterface->CallHookChunkGenerating(ChunkDesc);
 	m_Generator->Generate(ChunkDesc);
@@ -256,4 +262,5 @@ void cChunkGeneratorThread::DoGenerate(cChunkCoords a_Coords)
 	#endif
 
 	m_ChunkSink->OnChunkGenerated(ChunkDesc);
+	m_NumGeneratedMetric->Add();
 }
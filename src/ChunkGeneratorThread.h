@@ -10,6 +10,8 @@
 class cIniFile;
 class cChunkDesc;
 class cChunkGenerator;
+class cMetricCounter;
+class cMetricHistogram;
 
 
 
@@ -76,8 +78,9 @@ public:
 	cChunkGeneratorThread (void);
 	virtual ~cChunkGeneratorThread() override;
 
-	/** Read settings from the ini file and initialize in preperation for being started. */
-	bool Initialize(cPluginInterface & a_PluginInterface, cChunkSink & a_ChunkSink, cIniFile & a_IniFile);
+	/** Read settings from the ini file and initialize in preperation for being started.
+	a_WorldName labels the generator's metrics. */
+	bool Initialize(cPluginInterface & a_PluginInterface, cChunkSink & a_ChunkSink, cIniFile & a_IniFile, const AString & a_WorldName);
 
 	void Stop(void);
 
@@ -146,6 +149,10 @@ private:
 	/** The destination where the generated chunks are sent */
 	cChunkSink * m_ChunkSink;
 
+	/** The number of the chunks generated, and the time taken by each, in cMetrics. Set in Initialize(). */
+	cMetricCounter * m_NumGeneratedMetric;
+	cMetricHistogram * m_GenerationTimeMetric;
+
 
 	// cIsThread override:
 	virtual void Execute(void) override;
@@ -1345,9 +1345,22 @@ void cChunkMap::Tick(std::chrono::milliseconds a_Dt)
 	cCSLock Lock(m_CSChunks);
 
 	// Do the magic of updating the world:
-	for (auto & Chunk : m_Chunks)
+	auto & Profiler = m_World->GetTickProfiler();
+	if (Profiler.IsCapturingDetails())
 	{
-		Chunk.second.Tick(a_Dt);
+		for (auto & Chunk : m_Chunks)
+		{
+			const auto Start = std::chrono::steady_clock::now();
+			Chunk.second.Tick(a_Dt);
+			Profiler.AddChunkTiming(Chunk.first, std::chrono::steady_clock::now() - Start);
+		}
+	}
+	else
+	{
+		for (auto & Chunk : m_Chunks)
+		{
+			Chunk.second.Tick(a_Dt);
+		}
 	}
 
 	// Finally, only after all chunks are ticked, tell the client about all aggregated changes:
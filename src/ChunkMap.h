@@ -236,6 +236,28 @@ public:
 	/** Returns the number of valid chunks and the number of dirty chunks */
 	void GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty) const;
 
+	/** Statistics of the block changes broadcast to the clients, summed over all chunks. */
+	struct sBlockChangeStats
+	{
+		/** Number of block changes queued for sending. */
+		std::atomic<UInt64> m_NumQueued{0};
+
+		/** Number of queued changes dropped because a later change in the same tick superseded them. */
+		std::atomic<UInt64> m_NumCoalesced{0};
+
+		/** Number of multi-block-change packets sent, over all clients. */
+		std::atomic<UInt64> m_NumPacketsSent{0};
+
+		/** Number of full chunk resends used instead of the block changes, over all clients. */
+		std::atomic<UInt64> m_NumChunkResends{0};
+
+		/** Number of full chunk resends, over all clients, avoided because the coalesced changes fell below the resend threshold. */
+		std::atomic<UInt64> m_NumChunkResendsAvoided{0};
+	};
+
+	/** Returns the statistics of the block changes broadcast to the clients. */
+	const sBlockChangeStats & GetBlockChangeStats(void) const { return m_BlockChangeStats; }
+
 	/** Grows the plant at the specified position by at most a_NumStages.
 	The block's Grow handler is invoked.
 	Returns the number of stages the plant has grown, 0 if not a plant. */
@@ -303,6 +325,9 @@ private:
 
 	cEvent m_evtChunkValid;  // Set whenever any chunk becomes valid, via ChunkValidated()
 
+	/** Statistics of the block changes, updated by the chunks in cChunk::BroadcastPendingChanges(). */
+	sBlockChangeStats m_BlockChangeStats;
+
 	cWorld * m_World;
 
 	/** The cChunkStay descendants that are currently enabled in this chunkmap */
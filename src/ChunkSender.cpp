@@ -13,6 +13,7 @@
 #include "BlockEntities/BlockEntity.h"
 #include "ClientHandle.h"
 #include "Chunk.h"
+#include "Metrics.h"
 
 
 
@@ -61,7 +62,9 @@ public:
 cChunkSender::cChunkSender(cWorld & a_World) :
 	Super("Chunk Sender"),
 	m_World(a_World),
-	m_Serializer(m_World.GetDimension())
+	m_Serializer(m_World.GetDimension()),
+	m_NumSentMetric(cMetrics::Get().GetCounter("cuberite_chunks_sent_total", "The number of the chunks sent to the clients", {{"world", a_World.GetName()}})),
+	m_SendTimeMetric(cMetrics::Get().GetHistogram("cuberite_chunk_send_seconds", "The time taken to serialize and queue a chunk for all its clients", {{"world", a_World.GetName()}}))
 {
 }
 
@@ -232,6 +235,7 @@ void cChunkSender::SendChunk(int a_ChunkX, int a_ChunkZ, const WeakClients & a_C
 	}
 
 	// Query and prepare chunk data:
+	cMetricTimer Timer(m_SendTimeMetric);
 	if (!m_World.GetChunkData({a_ChunkX, a_ChunkZ}, *this))
 	{
 		return;
@@ -239,6 +243,7 @@ void cChunkSender::SendChunk(int a_ChunkX, int a_ChunkZ, const WeakClients & a_C
 
 	// Send:
 	m_Serializer.SendToClients(a_ChunkX, a_ChunkZ, m_BlockData, m_LightData, m_BiomeMap, Clients);
+	m_NumSentMetric.Add(Clients.size());
 
 	for (const auto & Client : Clients)
 	{
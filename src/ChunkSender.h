@@ -35,6 +35,8 @@ Note that it may be called by world's BroadcastToChunk() if the client is still
 
 class cWorld;
 class cClientHandle;
+class cMetricCounter;
+class cMetricHistogram;
 
 
 
@@ -109,6 +111,10 @@ protected:
 	/** An instance of a chunk serializer, held to maintain its internal cache. */
 	cChunkDataSerializer m_Serializer;
 
+	/** The number of the chunks sent, counted once for each client, and the time taken to send each chunk to all its clients, in cMetrics. */
+	cMetricCounter & m_NumSentMetric;
+	cMetricHistogram & m_SendTimeMetric;
+
 	cCriticalSection  m_CS;
 	std::priority_queue<sChunkQueue> m_SendChunks;
 	std::unordered_map<cChunkCoords, sSendChunk, cChunkCoordsHash> m_ChunkInfo;
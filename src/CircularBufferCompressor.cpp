@@ -7,6 +7,16 @@
 
 
 
+CircularBufferCompressor::CircularBufferCompressor(const int CompressionFactor) :
+	m_Compressor(CompressionFactor),
+	m_CompressionFactor(CompressionFactor)
+{
+}
+
+
+
+
+
 ContiguousByteBufferView CircularBufferCompressor::GetView() const
 {
 	return m_ContiguousIntermediate;
@@ -16,6 +26,19 @@ ContiguousByteBufferView CircularBufferCompressor::GetView() const
 
 
 
+void CircularBufferCompressor::SetCompressionFactor(const int CompressionFactor)
+{
+	if (CompressionFactor != m_CompressionFactor)
+	{
+		m_Compressor.SetCompressionFactor(CompressionFactor);
+		m_CompressionFactor = CompressionFactor;
+	}
+}
+
+
+
+
+
 Compression::Result CircularBufferCompressor::Compress()
 {
 	return m_Compressor.CompressZLib(m_ContiguousIntermediate);
@@ -17,8 +17,16 @@ class CircularBufferCompressor
 {
 public:
 
+	CircularBufferCompressor(int CompressionFactor = 6);
+
 	ContiguousByteBufferView GetView() const;
 
+	/** Returns the compression factor [0-12] used by Compress(). */
+	int GetCompressionFactor() const { return m_CompressionFactor; }
+
+	/** Changes the compression factor [0-12] used by the subsequent calls to Compress(). */
+	void SetCompressionFactor(int CompressionFactor);
+
 	Compression::Result Compress();
 	void ReadFrom(cByteBuffer & Buffer);
 	void ReadFrom(cByteBuffer & Buffer, size_t Size);
@@ -26,6 +34,7 @@ public:
 private:
 
 	Compression::Compressor m_Compressor;
+	int m_CompressionFactor;
 	std::basic_string<std::byte> m_ContiguousIntermediate;
 };
 
@@ -35,6 +35,7 @@
 #include "Protocol/Protocol.h"
 #include "CompositeChat.h"
 #include "Items/ItemSword.h"
+#include "Metrics.h"
 
 #include "mbedtls/md5.h"
 
@@ -49,6 +50,31 @@
 /** Maximum number of bytes that a chat message sent by a player may consist of */
 #define MAX_CHAT_MSG_LENGTH 1024
 
+/** Number of bytes waiting in the link for the OS to accept them, above which the chunk data is held back and no more chunks are streamed */
+#define MAX_LINK_QUEUE_SIZE (256 KiB)
+
+/** Number of bytes of the chunk data held back, above which no more chunks are streamed */
+#define MAX_QUEUED_CHUNK_DATA (1 MiB)
+
+
+
+
+
+/** The network metrics, shared by all the clients. */
+static cMetricCounter & BytesReceivedMetric = cMetrics::Get().GetCounter("cuberite_network_received_bytes_total", "The number of bytes received from the clients");
+static cMetricCounter & BytesSentMetric = cMetrics::Get().GetCounter("cuberite_network_sent_bytes_total", "The number of bytes sent to the clients, after compression and encryption");
+static cMetricCounter & ChunkStallsMetric = cMetrics::Get().GetCounter("cuberite_network_chunk_stalls_total", "The number of times the chunk data was held back for a congested link");
+
+/** The number of the packets sent to the clients, indexed by cProtocol::ePacketPriority. */
+static cMetricCounter * const PacketsSentMetrics[] =
+{
+	&cMetrics::Get().GetCounter("cuberite_network_sent_packets_total", "The number of the packets sent to the clients", {{"priority", "critical"}}),
+	&cMetrics::Get().GetCounter("cuberite_network_sent_packets_total", "The number of the packets sent to the clients", {{"priority", "entity"}}),
+	&cMetrics::Get().GetCounter("cuberite_network_sent_packets_total", "The number of the packets sent to the clients", {{"priority", "chunk"}}),
+	&cMetrics::Get().GetCounter("cuberite_network_sent_packets_total", "The number of the packets sent to the clients", {{"priority", "spawn"}}),
+};
+static_assert(ARRAYCOUNT(PacketsSentMetrics) == static_cast<size_t>(cProtocol::ePacketPriority::EntitySpawn) + 1, "Each packet priority needs a metric");
+
 
 
 
@@ -68,6 +94,9 @@ cClientHandle::cClientHandle(const AString & a_IPString, int a_ViewDistance) :
 	m_CurrentViewDistance(a_ViewDistance),
 	m_RequestedViewDistance(a_ViewDistance),
 	m_IPString(a_IPString),
+	m_IsDecodingOffTickThread(false),
+	m_OutgoingData(MAX_LINK_QUEUE_SIZE, MAX_QUEUED_CHUNK_DATA),
+	m_PlayerChunkDataMark(0),
 	m_Player(nullptr),
 	m_CachedSentChunk(0x7fffffff, 0x7fffffff),
 	m_HasSentDC(false),
@@ -130,7 +159,13 @@ void cClientHandle::Destroy(void)
 
 	{
 		cCSLock Lock(m_CSOutgoingData);
-		m_Link->Send(m_OutgoingData.data(), m_OutgoingData.size());  // Flush remaining data.
+
+		// Flush remaining data, including the held back chunk data:
+		m_OutgoingSendBuffer.clear();
+		m_OutgoingData.PopAll(m_OutgoingSendBuffer);
+		m_Protocol.EncryptOutgoingData(m_OutgoingSendBuffer);
+		m_Link->Send(m_OutgoingSendBuffer.data(), m_OutgoingSendBuffer.size());
+
 		m_Link->Shutdown();  // Cleanly close the connection.
 		m_Link.reset();  // Release the strong reference cTCPLink holds to ourself.
 	}
@@ -220,26 +255,64 @@ bool cClientHandle::IsUUIDOnline(const cUUID & a_UUID)
 
 void cClientHandle::ProcessProtocolOut()
 {
-	decltype(m_OutgoingData) OutgoingData;
+	// The data is encrypted by a stream cipher, so it must be handed over to the link in the order of encryption.
+	// Hence the whole flush is done under the lock:
+	cCSLock Lock(m_CSOutgoingData);
+
+	// Due to cTCPLink's design of holding a strong pointer to ourself, we need to explicitly reset m_Link.
+	// This means we need to check it's not nullptr before trying to send:
+	if (m_Link == nullptr)
 	{
-		cCSLock Lock(m_CSOutgoingData);
+		return;
+	}
 
-		// Bail out when there's nothing to send to avoid TCPLink::Send overhead:
-		if (m_OutgoingData.empty())
-		{
-			return;
-		}
+	// Send the classes in the order of their priority, holding back the chunk data while the link is congested:
+	const auto NumStalls = m_OutgoingData.GetNumStalls();
+	m_OutgoingSendBuffer.clear();
+	m_OutgoingData.Pop(m_OutgoingSendBuffer, m_Link->GetOutgoingQueueSize(), std::chrono::steady_clock::now());
+	if (m_OutgoingData.GetNumStalls() != NumStalls)
+	{
+		ChunkStallsMetric.Add();
+	}
 
-		std::swap(OutgoingData, m_OutgoingData);
+	// Bail out when there's nothing to send to avoid TCPLink::Send overhead:
+	if (m_OutgoingSendBuffer.empty())
+	{
+		return;
 	}
 
-	// Due to cTCPLink's design of holding a strong pointer to ourself, we need to explicitly reset m_Link.
-	// This means we need to check it's not nullptr before trying to send, but also capture the link,
-	// to prevent it being reset between the null check and the Send:
-	if (auto Link = m_Link; Link != nullptr)
+	m_Protocol.EncryptOutgoingData(m_OutgoingSendBuffer);
+	m_Link->Send(m_OutgoingSendBuffer.data(), m_OutgoingSendBuffer.size());
+	BytesSentMetric.Add(m_OutgoingSendBuffer.size());
+}
+
+
+
+
+
+bool cClientHandle::IsOutgoingCongested(void)
+{
+	cCSLock Lock(m_CSOutgoingData);
+	return m_OutgoingData.IsCongested((m_Link == nullptr) ? 0 : m_Link->GetOutgoingQueueSize());
+}
+
+
+
+
+
+cClientHandle::sOutgoingStats cClientHandle::GetOutgoingStats(void)
+{
+	cCSLock Lock(m_CSOutgoingData);
+	sOutgoingStats Stats;
+	for (size_t i = 0; i < Stats.m_NumQueuedBytes.size(); i++)
 	{
-		Link->Send(OutgoingData.data(), OutgoingData.size());
+		Stats.m_NumQueuedBytes[i] = m_OutgoingData.GetNumQueuedBytes(static_cast<cProtocol::ePacketPriority>(i));
 	}
+	Stats.m_LinkQueueSize = (m_Link == nullptr) ? 0 : m_Link->GetOutgoingQueueSize();
+	Stats.m_NumStalls = m_OutgoingData.GetNumStalls();
+	Stats.m_IsStalled = m_OutgoingData.IsStalled();
+	Stats.m_StallTime = std::chrono::duration_cast<std::chrono::milliseconds>(m_OutgoingData.GetStallTime(std::chrono::steady_clock::now()));
+	return Stats;
 }
 
 
@@ -1888,7 +1961,7 @@ void cClientHandle::HandleTabCompletion(const AString & a_Text)
 
 
 
-void cClientHandle::SendData(const ContiguousByteBufferView a_Data)
+void cClientHandle::SendData(const ContiguousByteBufferView a_Data, const cProtocol::ePacketPriority a_Priority)
 {
 	if (m_HasSentDC)
 	{
@@ -1897,7 +1970,27 @@ void cClientHandle::SendData(const ContiguousByteBufferView a_Data)
 	}
 
 	cCSLock Lock(m_CSOutgoingData);
-	m_OutgoingData += a_Data;
+	m_OutgoingData.Push(a_Data, a_Priority);
+	PacketsSentMetrics[static_cast<size_t>(a_Priority)]->Add();
+}
+
+
+
+
+
+bool cClientHandle::IsCompressionEnabled(void)
+{
+	return m_Protocol.VersionRecognitionSuccessful() && m_Protocol->IsCompressionEnabled();
+}
+
+
+
+
+
+int cClientHandle::GetCompressionLevel(void)
+{
+	ASSERT(IsCompressionEnabled());
+	return m_Protocol->GetCompressionLevel();
 }
 
 
@@ -1914,7 +2007,11 @@ void cClientHandle::RemoveFromWorld(void)
 		m_SentChunks.clear();
 	}
 
-	// Flush outgoing data:
+	// The queued entity and chunk data belong to the old world, drop them; flush the rest:
+	{
+		cCSLock Lock(m_CSOutgoingData);
+		m_OutgoingData.ClearWorldData();
+	}
 	ProcessProtocolOut();
 
 	// No need to send Unload Chunk packets, the client unloads automatically.
@@ -2019,7 +2116,14 @@ void cClientHandle::Tick(float a_Dt)
 		}
 	}
 
-	// If the chunk the player's in was just sent, spawn the player:
+	// If the chunk the player's in was just sent, spawn the player.
+	// Wait for that chunk to leave the outgoing queue first, so that the player doesn't spawn in an empty world;
+	// the chunks queued after it don't delay the spawn:
+	if (m_HasSentPlayerChunk && (m_State == csDownloadingWorld))
+	{
+		cCSLock Lock(m_CSOutgoingData);
+		m_HasSentPlayerChunk = m_OutgoingData.HasPopped(m_PlayerChunkDataMark);
+	}
 	{
 		cCSLock lock(m_CSState);
 		if (m_HasSentPlayerChunk && (m_State == csDownloadingWorld))
@@ -2047,8 +2151,8 @@ void cClientHandle::Tick(float a_Dt)
 		}
 	}
 
-	// Stream 4 chunks per tick
-	for (int i = 0; i < 4; i++)
+	// Stream 4 chunks per tick, unless the client doesn't keep up with the chunks already sent:
+	for (int i = 0; (i < 4) && !IsOutgoingCongested(); i++)
 	{
 		// Stream the next chunk
 		if (StreamNextChunk())
@@ -2082,6 +2186,9 @@ void cClientHandle::Tick(float a_Dt)
 	// Reset explosion & block change counters:
 	m_NumExplosionsThisTick = 0;
 	m_NumBlockChangeInteractionsThisTick = 0;
+
+	// Send out the data queued this tick, and the chunk data held back before, if the link has caught up:
+	ProcessProtocolOut();
 }
 
 
@@ -2388,7 +2495,15 @@ void cClientHandle::SendChunkData(int a_ChunkX, int a_ChunkZ, const ContiguousBy
 		return;
 	}
 
-	m_Protocol->SendChunkData(a_ChunkData);
+	{
+		cCSLock Lock(m_CSOutgoingData);
+		m_Protocol->SendChunkData(a_ChunkData);
+		if ((a_ChunkX == m_Player->GetChunkX()) && (a_ChunkZ == m_Player->GetChunkZ()))
+		{
+			// Remember where the player's chunk ends in the queue, the player is spawned once it's been sent out:
+			m_PlayerChunkDataMark = m_OutgoingData.GetChunkDataMark();
+		}
+	}
 
 	// Add the chunk to the list of chunks sent to the player:
 	{
@@ -3280,21 +3395,42 @@ void cClientHandle::ProcessProtocolIn(void)
 {
 	// Process received network data:
 	decltype(m_IncomingData) IncomingData;
+	bool IsDecodingOffTickThread;
 	{
 		cCSLock Lock(m_CSIncomingData);
+		IsDecodingOffTickThread = m_IsDecodingOffTickThread;
+		std::swap(IncomingData, m_IncomingData);
+	}
 
-		// Bail out when nothing was received:
-		if (m_IncomingData.empty())
+	try
+	{
+		if (IsDecodingOffTickThread)
 		{
+			// The network thread has already decoded the packets, only handle them:
+			m_Protocol->HandleDecodedPackets();
 			return;
 		}
 
-		std::swap(IncomingData, m_IncomingData);
-	}
+		// Bail out when nothing was received:
+		if (IncomingData.empty())
+		{
+			return;
+		}
 
-	try
-	{
 		m_Protocol.HandleIncomingData(*this, std::move(IncomingData));
+
+		// Once the decoding state is final, hand the decoding over to the network thread.
+		// The data received meanwhile is decoded here first, under the lock, so that the packets stay in order:
+		if (m_Protocol.VersionRecognitionSuccessful() && m_Protocol->CanDecodeOffTickThread())
+		{
+			cCSLock Lock(m_CSIncomingData);
+			if (!m_IncomingData.empty())
+			{
+				m_Protocol.DecodeIncomingData(std::move(m_IncomingData));
+				m_IncomingData.clear();
+			}
+			m_IsDecodingOffTickThread = true;
+		}
 	}
 	catch (const std::exception & Oops)
 	{
@@ -3319,10 +3455,19 @@ void cClientHandle::OnReceivedData(const char * a_Data, size_t a_Length)
 {
 	// Reset the timeout:
 	m_TicksSinceLastPacket = 0;
+	BytesReceivedMetric.Add(a_Length);
 
-	// Queue the incoming data to be processed in the tick thread:
 	cCSLock Lock(m_CSIncomingData);
-	m_IncomingData.append(reinterpret_cast<const std::byte *>(a_Data), a_Length);
+	if (!m_IsDecodingOffTickThread)
+	{
+		// Queue the incoming data to be processed in the tick thread:
+		m_IncomingData.append(reinterpret_cast<const std::byte *>(a_Data), a_Length);
+		return;
+	}
+
+	// Decrypt, decompress and frame the packets here, the tick thread only handles them.
+	// Nothing here may act on the client, the decoding errors are reported by the tick thread, too:
+	m_Protocol.DecodeIncomingData(ContiguousByteBuffer(reinterpret_cast<const std::byte *>(a_Data), a_Length));
 }
 
 
@@ -101,9 +101,36 @@ public:  // tolua_export
 	We use Version-3 UUIDs for offline UUIDs, online UUIDs are Version-4, thus we can tell them apart. */
 	static bool IsUUIDOnline(const cUUID & a_UUID);  // Exported in ManualBindings.cpp
 
-	/** Flushes all buffered outgoing data to the network. */
+	/** The statistics of the client's outgoing data, as reported by GetOutgoingStats(). */
+	struct sOutgoingStats
+	{
+		/** The number of bytes waiting in each cProtocol::ePacketPriority class to be handed over to the link. */
+		std::array<size_t, cProtocol::NumPacketPriorities> m_NumQueuedBytes;
+
+		/** The number of bytes handed over to the link that the OS hasn't accepted yet. */
+		size_t m_LinkQueueSize;
+
+		/** The number of times the chunk data was held back because the link was congested. */
+		UInt64 m_NumStalls;
+
+		/** The total time for which the chunk data was held back, including the current stall. */
+		std::chrono::milliseconds m_StallTime;
+
+		/** True if the chunk data is being held back right now. */
+		bool m_IsStalled;
+	};
+
+
+	/** Flushes the buffered outgoing data to the network, in the order of the cProtocol::ePacketPriority classes.
+	The chunk data is held back while the link is congested, so that it doesn't delay the more important data queued later. */
 	void ProcessProtocolOut();
 
+	/** Returns true if the link or the queued chunk data is backed up, and no more chunks should be streamed to the client for now. */
+	bool IsOutgoingCongested(void);
+
+	/** Returns the statistics of the outgoing data. */
+	sOutgoingStats GetOutgoingStats(void);
+
 	/** Formats the type of message with the proper color and prefix for sending to the client. */
 	static AString FormatMessageType(bool ShouldAppendChatPrefixes, eMessageType a_ChatPrefix, const AString & a_AdditionalData);
 
@@ -395,7 +422,8 @@ public:  // tolua_export
 	Return true to allow the user in; false to kick them. */
 	bool HandleLogin();
 
-	void SendData(ContiguousByteBufferView a_Data);
+	/** Queues the data, consisting of whole packets, in the specified priority class, to be sent out by ProcessProtocolOut(). */
+	void SendData(ContiguousByteBufferView a_Data, cProtocol::ePacketPriority a_Priority);
 
 	/** Called when the player moves into a different world.
 	Sends an UnloadChunk packet for each loaded chunk and resets the streamed chunks. */
@@ -407,6 +435,12 @@ public:  // tolua_export
 	/** Returns the protocol version number of the protocol that the client is talking. Returns zero if the protocol version is not (yet) known. */
 	UInt32 GetProtocolVersion(void) const { return m_ProtocolVersion; }  // tolua_export
 
+	/** Returns true if the packets sent to the client use the compressed framing. */
+	bool IsCompressionEnabled(void);
+
+	/** Returns the level at which the packets sent to the client are compressed, if IsCompressionEnabled(). */
+	int GetCompressionLevel(void);
+
 	void InvalidateCachedSentChunk();
 
 	bool IsPlayerChunkSent();
@@ -452,12 +486,28 @@ private:
 	Protected by m_CSIncomingData. */
 	ContiguousByteBuffer m_IncomingData;
 
-	/** Protects m_OutgoingData against multithreaded access. */
+	/** Set by ProcessProtocolIn() once handling the packets can no longer change how the incoming data is decoded.
+	From then on OnReceivedData() decrypts, decompresses and frames the data on the network thread, and the tick thread only handles the packets.
+	Protected by m_CSIncomingData. */
+	bool m_IsDecodingOffTickThread;
+
+	/** Protects m_OutgoingData and the related members against multithreaded access.
+	Held while the data is encrypted and handed over to the link, so that the data reaches the link in the order of encryption. */
 	cCriticalSection m_CSOutgoingData;
 
-	/** Buffer for storing outgoing data from any thread; will get sent in ProcessProtocolOut() at the end of each tick.
+	/** Buffers for storing outgoing data from any thread, one per cProtocol::ePacketPriority class; will get sent in ProcessProtocolOut().
+	The data is stored unencrypted, it is encrypted only once the order of sending is known.
+	Protected by m_CSOutgoingData. */
+	cOutgoingPacketQueue m_OutgoingData;
+
+	/** The data being encrypted and handed over to the link in ProcessProtocolOut(), kept to reuse its allocation.
+	Protected by m_CSOutgoingData. */
+	ContiguousByteBuffer m_OutgoingSendBuffer;
+
+	/** The cOutgoingPacketQueue::GetChunkDataMark() taken when the chunk that the player is in was queued.
+	The player is spawned once the data up to this mark has left the queue, regardless of the chunks queued after it.
 	Protected by m_CSOutgoingData. */
-	ContiguousByteBuffer m_OutgoingData;
+	UInt64 m_PlayerChunkDataMark;
 
 	/** A pointer to a World-owned player object, created in FinishAuthenticate when authentication succeeds.
 	The player should only be accessed from the tick thread of the World that owns him.
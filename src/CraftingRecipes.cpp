@@ -260,6 +260,34 @@ void cCraftingRecipe::Dump(void)
 
 
 
+////////////////////////////////////////////////////////////////////////////////
+// cCraftingRecipes::cRecipeKey:
+
+cCraftingRecipes::cRecipeKey::cRecipeKey(void) :
+	m_Width(0),
+	m_Height(0)
+{
+	m_ItemTypes.fill(E_ITEM_EMPTY);
+}
+
+
+
+
+
+size_t cCraftingRecipes::cRecipeKeyHasher::operator () (const cRecipeKey & a_Key) const
+{
+	size_t Hash = static_cast<size_t>(a_Key.m_Width * 4 + a_Key.m_Height);
+	for (const auto ItemType : a_Key.m_ItemTypes)
+	{
+		Hash = Hash * 31 + static_cast<UInt16>(ItemType);
+	}
+	return Hash;
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cCraftingRecipes:
 
@@ -413,6 +441,7 @@ void cCraftingRecipes::LoadRecipes(void)
 		}
 		AddRecipeLine(LineNum, Recipe);
 	}  // for itr - Split[]
+	BuildRecipeIndex();
 	LOG("Loaded %zu crafting recipes", m_Recipes.size());
 }
 
@@ -442,6 +471,112 @@ void cCraftingRecipes::ClearRecipes(void)
 		delete *itr;
 	}
 	m_Recipes.clear();
+	m_RecipeIndex.clear();
+}
+
+
+
+
+
+void cCraftingRecipes::BuildRecipeIndex(void)
+{
+	m_RecipeIndex.clear();
+	for (UInt32 i = 0; i < m_Recipes.size(); i++)
+	{
+		cRecipeKey Key;
+		if (GetRecipeKey(*m_Recipes[i], Key))
+		{
+			m_RecipeIndex[Key].push_back(i);
+		}
+	}
+}
+
+
+
+
+
+bool cCraftingRecipes::GetRecipeKey(const cRecipe & a_Recipe, cRecipeKey & a_Key)
+{
+	// Collect the regular items into their cells; multiple ingredients in a single cell must agree on the item type:
+	std::array<short, MAX_GRID_WIDTH * MAX_GRID_HEIGHT> Cells;
+	Cells.fill(E_ITEM_EMPTY);
+	std::vector<short> AnywhereTypes;
+	for (const auto & Slot : a_Recipe.m_Ingredients)
+	{
+		if ((Slot.x < 0) || (Slot.y < 0))
+		{
+			AnywhereTypes.push_back(Slot.m_Item.m_ItemType);
+			continue;
+		}
+		if ((Slot.x >= MAX_GRID_WIDTH) || (Slot.y >= MAX_GRID_HEIGHT))
+		{
+			return false;
+		}
+		auto & Cell = Cells[static_cast<size_t>(Slot.x + Slot.y * MAX_GRID_WIDTH)];
+		if ((Cell != E_ITEM_EMPTY) && (Cell != Slot.m_Item.m_ItemType))
+		{
+			return false;
+		}
+		Cell = Slot.m_Item.m_ItemType;
+	}
+
+	if (AnywhereTypes.empty())
+	{
+		// Exact shape:
+		a_Key.m_Width = a_Recipe.m_Width;
+		a_Key.m_Height = a_Recipe.m_Height;
+		size_t Idx = 0;
+		for (int y = 0; y < a_Recipe.m_Height; y++)
+		{
+			for (int x = 0; x < a_Recipe.m_Width; x++)
+			{
+				a_Key.m_ItemTypes[Idx++] = Cells[static_cast<size_t>(x + y * MAX_GRID_WIDTH)];
+			}
+		}
+		return true;
+	}
+
+	// Multiset of the item types, each "anywhere" ingredient takes up a cell of its own:
+	for (const auto Cell : Cells)
+	{
+		if (Cell != E_ITEM_EMPTY)
+		{
+			AnywhereTypes.push_back(Cell);
+		}
+	}
+	if (AnywhereTypes.size() > a_Key.m_ItemTypes.size())
+	{
+		return false;
+	}
+	std::sort(AnywhereTypes.begin(), AnywhereTypes.end());
+	std::copy(AnywhereTypes.begin(), AnywhereTypes.end(), a_Key.m_ItemTypes.begin());
+	return true;
+}
+
+
+
+
+
+void cCraftingRecipes::GetGridKeys(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight, int a_GridStride, cRecipeKey & a_ShapeKey, cRecipeKey & a_MultisetKey)
+{
+	a_ShapeKey.m_Width = a_GridWidth;
+	a_ShapeKey.m_Height = a_GridHeight;
+	size_t ShapeIdx = 0, NumItems = 0;
+	for (int y = 0; y < a_GridHeight; y++)
+	{
+		for (int x = 0; x < a_GridWidth; x++)
+		{
+			const cItem & Item = a_CraftingGrid[x + y * a_GridStride];
+			if (Item.IsEmpty())
+			{
+				ShapeIdx++;
+				continue;
+			}
+			a_ShapeKey.m_ItemTypes[ShapeIdx++] = Item.m_ItemType;
+			a_MultisetKey.m_ItemTypes[NumItems++] = Item.m_ItemType;
+		}
+	}
+	std::sort(a_MultisetKey.m_ItemTypes.begin(), a_MultisetKey.m_ItemTypes.begin() + static_cast<std::ptrdiff_t>(NumItems));
 }
 
 
@@ -716,25 +851,59 @@ cCraftingRecipes::cRecipe * cCraftingRecipes::FindRecipe(const cItem * a_Craftin
 
 cCraftingRecipes::cRecipe * cCraftingRecipes::FindRecipeCropped(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight, int a_GridStride)
 {
-	for (cRecipes::const_iterator itr = m_Recipes.begin(); itr != m_Recipes.end(); ++itr)
+	if ((a_GridWidth <= 0) || (a_GridHeight <= 0))
+	{
+		// Empty grid
+		return nullptr;
+	}
+
+	// Look up the candidates for both key types:
+	static const std::vector<UInt32> NoCandidates;
+	cRecipeKey ShapeKey, MultisetKey;
+	GetGridKeys(a_CraftingGrid, a_GridWidth, a_GridHeight, a_GridStride, ShapeKey, MultisetKey);
+	auto ShapeItr = m_RecipeIndex.find(ShapeKey);
+	auto MultisetItr = m_RecipeIndex.find(MultisetKey);
+	const auto & ShapeCandidates = (ShapeItr == m_RecipeIndex.end()) ? NoCandidates : ShapeItr->second;
+	const auto & MultisetCandidates = (MultisetItr == m_RecipeIndex.end()) ? NoCandidates : MultisetItr->second;
+
+	// Check the candidates in the order of the recipes, so that the first recipe in the file wins, as before:
+	auto ShapeCandidate = ShapeCandidates.begin();
+	auto MultisetCandidate = MultisetCandidates.begin();
+	while ((ShapeCandidate != ShapeCandidates.end()) || (MultisetCandidate != MultisetCandidates.end()))
 	{
+		if (
+			(MultisetCandidate == MultisetCandidates.end()) ||
+			((ShapeCandidate != ShapeCandidates.end()) && (*ShapeCandidate < *MultisetCandidate))
+		)
+		{
+			// The shape matches exactly, so the recipe can only be at zero offset:
+			cRecipe * Recipe = MatchRecipe(a_CraftingGrid, a_GridWidth, a_GridHeight, a_GridStride, m_Recipes[*ShapeCandidate], 0, 0);
+			if (Recipe != nullptr)
+			{
+				return Recipe;
+			}
+			++ShapeCandidate;
+			continue;
+		}
+
 		// Both the crafting grid and the recipes are normalized. The only variable possible is the "anywhere" items.
 		// This still means that the "anywhere" item may be the one that is offsetting the grid contents to the right or downwards, so we need to check all possible positions.
 		// E. g. recipe "A, * | B, 1:1 | ..." still needs to check grid for B at 2:2 (in case A was in grid's 1:1)
 		// Calculate the maximum offsets for this recipe relative to the grid size, and iterate through all combinations of offsets.
 		// Also, this calculation automatically filters out recipes that are too large for the current grid - the loop won't be entered at all.
-
-		int MaxOfsX = a_GridWidth  - (*itr)->m_Width;
-		int MaxOfsY = a_GridHeight - (*itr)->m_Height;
+		const cRecipe * Candidate = m_Recipes[*MultisetCandidate];
+		int MaxOfsX = a_GridWidth  - Candidate->m_Width;
+		int MaxOfsY = a_GridHeight - Candidate->m_Height;
 		for (int x = 0; x <= MaxOfsX; x++) for (int y = 0; y <= MaxOfsY; y++)
 		{
-			cRecipe * Recipe = MatchRecipe(a_CraftingGrid, a_GridWidth, a_GridHeight, a_GridStride, *itr, x, y);
+			cRecipe * Recipe = MatchRecipe(a_CraftingGrid, a_GridWidth, a_GridHeight, a_GridStride, Candidate, x, y);
 			if (Recipe != nullptr)
 			{
 				return Recipe;
 			}
 		}  // for y, for x
-	}  // for itr - m_Recipes[]
+		++MultisetCandidate;
+	}  // while (candidates)
 
 	// No matching recipe found
 	return nullptr;
@@ -159,11 +159,51 @@ protected:
 
 	typedef std::vector<cRecipe *> cRecipes;
 
+	/** The key into the recipe index.
+	For recipes without any "anywhere" ingredients, the key is the exact shape: the dimensions and the item type in each cell, row by row.
+	For recipes with "anywhere" ingredients, the key is the sorted multiset of the ingredients' item types, with zero dimensions.
+	Damage values are not part of the key, so that wildcard damage ingredients share the key with the specific ones;
+	the candidates are verified using MatchRecipe(). */
+	struct cRecipeKey
+	{
+		int m_Width;
+		int m_Height;
+		std::array<short, MAX_GRID_WIDTH * MAX_GRID_HEIGHT> m_ItemTypes;
+
+		cRecipeKey(void);
+
+		bool operator == (const cRecipeKey & a_Other) const
+		{
+			return (m_Width == a_Other.m_Width) && (m_Height == a_Other.m_Height) && (m_ItemTypes == a_Other.m_ItemTypes);
+		}
+	} ;
+
+	struct cRecipeKeyHasher
+	{
+		size_t operator () (const cRecipeKey & a_Key) const;
+	} ;
+
+	/** Maps each key to the ids of all the recipes that may match a grid with such a key, in ascending order. */
+	typedef std::unordered_map<cRecipeKey, std::vector<UInt32>, cRecipeKeyHasher> cRecipeIndex;
+
 	cRecipes m_Recipes;
 
+	/** The index of m_Recipes, used for finding the candidates for a crafting grid without walking all the recipes. */
+	cRecipeIndex m_RecipeIndex;
+
 	void LoadRecipes(void);
 	void ClearRecipes(void);
 
+	/** Rebuilds m_RecipeIndex from m_Recipes. */
+	void BuildRecipeIndex(void);
+
+	/** Calculates the index key of the specified normalized recipe.
+	Returns false if the recipe cannot ever match (conflicting or too many ingredients), and thus shouldn't be indexed. */
+	static bool GetRecipeKey(const cRecipe & a_Recipe, cRecipeKey & a_Key);
+
+	/** Calculates the index keys of the specified cropped crafting grid, one for each key type. */
+	static void GetGridKeys(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight, int a_GridStride, cRecipeKey & a_ShapeKey, cRecipeKey & a_MultisetKey);
+
 	/** Parses the recipe line and adds it into m_Recipes. a_LineNum is used for diagnostic warnings only */
 	void AddRecipeLine(int a_LineNum, const AString & a_RecipeLine);
 
@@ -179,7 +219,8 @@ protected:
 	/** Finds a recipe matching the crafting grid. Returns a newly allocated recipe (with all its coords set) or nullptr if not found. Caller must delete return value! */
 	cRecipe * FindRecipe(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight);
 
-	/** Same as FindRecipe, but the grid is guaranteed to be of minimal dimensions needed */
+	/** Same as FindRecipe, but the grid is guaranteed to be of minimal dimensions needed.
+	Only checks the recipes listed in m_RecipeIndex under the grid's keys, in the order in which they were loaded. */
 	cRecipe * FindRecipeCropped(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight, int a_GridStride);
 
 	/** Checks if the grid matches the specified recipe, offset by the specified offsets. Returns a matched cRecipe * if so, or nullptr if not matching. Caller must delete the return value! */
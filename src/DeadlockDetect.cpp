@@ -22,7 +22,8 @@ const int CYCLE_MILLISECONDS = 100;
 
 cDeadlockDetect::cDeadlockDetect(void) :
 	Super("Deadlock Detector"),
-	m_IntervalSec(1000)
+	m_IntervalSec(1000),
+	m_SamplingInterval(std::chrono::milliseconds(0))
 {
 }
 
@@ -69,6 +70,20 @@ void cDeadlockDetect::Start(int a_IntervalSec)
 
 
 
+bool cDeadlockDetect::StartSampling(std::chrono::milliseconds a_Interval)
+{
+	if (!cSamplingProfiler::IsSupported())
+	{
+		return false;
+	}
+	m_SamplingInterval = std::max(a_Interval, std::chrono::milliseconds(1));
+	return true;
+}
+
+
+
+
+
 void cDeadlockDetect::TrackCriticalSection(cCriticalSection & a_CS, const AString & a_Name)
 {
 	cCSLock lock(m_CS);
@@ -99,16 +114,35 @@ void cDeadlockDetect::UntrackCriticalSection(cCriticalSection & a_CS)
 void cDeadlockDetect::Execute(void)
 {
 	// Loop until the signal to terminate:
+	auto NextCheck = std::chrono::steady_clock::now();
 	while (!m_ShouldTerminate)
 	{
-		// Check the world ages:
-		cRoot::Get()->ForEachWorld([=](cWorld & a_World)
+		auto Now = std::chrono::steady_clock::now();
+		if (Now >= NextCheck)
 		{
-			CheckWorldAge(a_World.GetName(), a_World.GetWorldAge());
-			return false;
-		});
+			// Check the world ages:
+			if (m_IntervalSec > 0)
+			{
+				cRoot::Get()->ForEachWorld([=](cWorld & a_World)
+				{
+					CheckWorldAge(a_World.GetName(), a_World.GetWorldAge());
+					return false;
+				});
+			}
+			NextCheck = Now + std::chrono::milliseconds(CYCLE_MILLISECONDS);
+		}
 
-		std::this_thread::sleep_for(std::chrono::milliseconds(CYCLE_MILLISECONDS));
+		// Sample the stacks, if requested, until the next check:
+		const auto SamplingInterval = m_SamplingInterval.load();
+		if (SamplingInterval.count() > 0)
+		{
+			m_SamplingProfiler.Sample();
+			std::this_thread::sleep_until(std::min(NextCheck, std::chrono::steady_clock::now() + SamplingInterval));
+		}
+		else
+		{
+			std::this_thread::sleep_until(NextCheck);
+		}
 	}  // while (should run)
 }
 
@@ -8,6 +8,9 @@ This class simply monitors each world's m_WorldAge, which is expected to grow on
 If the world age doesn't grow for several seconds, it's either because the server is Super-overloaded,
 or because the world tick thread hangs in a deadlock. We presume the latter and therefore kill the server.
 Once we learn to write crashdumps programmatically, we should do so just before killing, to enable debugging.
+
+The same thread also drives the sampling profiler: while sampling is enabled, it samples the stacks of the tracked
+threads (the world tick threads) at the requested interval, in between the world age checks.
 */
 
 
@@ -15,6 +18,7 @@ Once we learn to write crashdumps programmatically, we should do so just before
 #pragma once
 
 #include "OSSupport/IsThread.h"
+#include "OSSupport/SamplingProfiler.h"
 
 
 
@@ -30,7 +34,8 @@ public:
 	cDeadlockDetect();
 	virtual ~cDeadlockDetect() override;
 
-	/** Starts the detection. Hides cIsThread's Start, because we need some initialization */
+	/** Starts the detection. Hides cIsThread's Start, because we need some initialization.
+	An a_IntervalSec of zero disables the detection, the thread then only drives the sampling profiler. */
 	void Start(int a_IntervalSec);
 
 	/** Adds the critical section for tracking.
@@ -42,6 +47,25 @@ public:
 	/** Removes the CS from the tracking. */
 	void UntrackCriticalSection(cCriticalSection & a_CS);
 
+	/** Adds the thread to be sampled by the sampling profiler. The thread must be untracked before it is stopped.
+	a_Name is the root frame of the thread's stacks in the profile. */
+	void TrackThread(cIsThread & a_Thread, const AString & a_Name) { m_SamplingProfiler.TrackThread(a_Thread, a_Name); }
+
+	/** Removes the thread from the sampling. */
+	void UntrackThread(cIsThread & a_Thread) { m_SamplingProfiler.UntrackThread(a_Thread); }
+
+	/** Starts sampling the tracked threads' stacks every a_Interval, adding to the samples already taken.
+	Returns false if the sampling is not supported on this platform. */
+	bool StartSampling(std::chrono::milliseconds a_Interval);
+
+	/** Stops sampling the stacks. The samples are kept in the profiler until cleared. */
+	void StopSampling(void) { m_SamplingInterval = std::chrono::milliseconds(0); }
+
+	/** Returns true if the stacks are being sampled. */
+	bool IsSampling(void) const { return (m_SamplingInterval.load().count() > 0); }
+
+	cSamplingProfiler & GetSamplingProfiler(void) { return m_SamplingProfiler; }
+
 protected:
 	struct sWorldAge
 	{
@@ -64,9 +88,14 @@ protected:
 
 	WorldAges m_WorldAges;
 
-	/** Number of secods for which the ages must be the same for the detection to trigger */
+	/** Number of secods for which the ages must be the same for the detection to trigger; zero if the detection is disabled. */
 	int m_IntervalSec;
 
+	cSamplingProfiler m_SamplingProfiler;
+
+	/** The interval between the stack samples, zero if not sampling. */
+	std::atomic<std::chrono::milliseconds> m_SamplingInterval;
+
 
 	// cIsThread overrides:
 	virtual void Execute(void) override;
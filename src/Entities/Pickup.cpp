@@ -146,6 +146,16 @@ void cPickup::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 			// Position might have changed due to physics. So we have to make sure we have the correct chunk.
 			GET_AND_VERIFY_CURRENT_CHUNK(CurrentChunk, BlockX, BlockZ);
 
+			// Wake up the hopper below, if any, so that it sucks the pickup in:
+			if (BlockY > 0)
+			{
+				const auto HopperPos = cChunkDef::AbsoluteToRelative({BlockX, BlockY - 1, BlockZ});
+				if (CurrentChunk->GetBlock(HopperPos) == E_BLOCK_HOPPER)
+				{
+					CurrentChunk->WakeUpBlockEntity(HopperPos);
+				}
+			}
+
 			// Destroy the pickup if it is on fire:
 			if (IsOnFire())
 			{
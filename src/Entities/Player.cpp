@@ -18,6 +18,7 @@
 #include "../FastRandom.h"
 #include "../ClientHandle.h"
 
+#include "../WorldStorage/PlayerDataWriter.h"
 #include "../WorldStorage/StatisticsSerializer.h"
 #include "../CompositeChat.h"
 
@@ -26,7 +27,6 @@
 #include "../Blocks/ChunkInterface.h"
 
 #include "../IniFile.h"
-#include "../JsonUtils.h"
 #include "json/json.h"
 
 #include "../CraftingRecipes.h"
@@ -35,27 +35,6 @@
 
 
 
-namespace
-{
-
-/** Returns the folder for the player data based on the UUID given.
-This can be used both for online and offline UUIDs. */
-AString GetUUIDFolderName(const cUUID & a_Uuid)
-{
-	AString UUID = a_Uuid.ToShortString();
-
-	AString res("players/");
-	res.append(UUID, 0, 2);
-	res.push_back('/');
-	return res;
-}
-
-}  // namespace (anonymous)
-
-
-
-
-
 const int cPlayer::MAX_HEALTH = 20;
 
 const int cPlayer::MAX_FOOD_LEVEL = 20;
@@ -1517,7 +1496,7 @@ void cPlayer::PermuteEnchantmentSeed()
 
 
 
-bool cPlayer::HasPermission(const AString & a_Permission)
+bool cPlayer::HasPermission(const std::string_view a_Permission)
 {
 	if (a_Permission.empty())
 	{
@@ -1525,28 +1504,8 @@ bool cPlayer::HasPermission(const AString & a_Permission)
 		return true;
 	}
 
-	AStringVector Split = StringSplit(a_Permission, ".");
-
-	// Iterate over all restrictions; if any matches, then return failure:
-	for (auto & Restriction: m_SplitRestrictions)
-	{
-		if (PermissionMatches(Split, Restriction))
-		{
-			return false;
-		}
-	}  // for Restriction - m_SplitRestrictions[]
-
-	// Iterate over all granted permissions; if any matches, then return success:
-	for (auto & Permission: m_SplitPermissions)
-	{
-		if (PermissionMatches(Split, Permission))
-		{
-			return true;
-		}
-	}  // for Permission - m_SplitPermissions[]
-
-	// No granted permission matches
-	return false;
+	// If any restriction matches, return failure; otherwise the permission is granted if any permission matches:
+	return !m_RestrictionTrie.Matches(a_Permission) && m_PermissionTrie.Matches(a_Permission);
 }
 
 
@@ -1741,7 +1700,7 @@ void cPlayer::LoadFromDisk()
 	const auto & UUID = GetUUID();
 
 	// Load from the UUID file:
-	if (LoadFromFile(GetUUIDFileName(UUID)))
+	if (LoadFromFile(GetUUIDFileBaseName(UUID)))
 	{
 		return;
 	}
@@ -1764,29 +1723,16 @@ void cPlayer::LoadFromDisk()
 
 
 
-bool cPlayer::LoadFromFile(const AString & a_FileName)
+bool cPlayer::LoadFromFile(const AString & a_FileBaseName)
 {
-	Json::Value Root;
+	auto & Writer = cRoot::Get()->GetPlayerDataWriter();
 
-	try
-	{
-		// Load the data from the file and parse:
-		InputFileStream(a_FileName) >> Root;
-	}
-	catch (const Json::Exception & Oops)
-	{
-		// Parse failure:
-		throw std::runtime_error(Oops.what());
-	}
-	catch (const InputFileStream::failure &)
+	// Load the data from the file, or the data still waiting to be written into it:
+	Json::Value Root;
+	if (!Writer.Load(a_FileBaseName, Root))
 	{
-		if (errno == ENOENT)
-		{
-			// This is a new player whom we haven't seen yet, bail out, let them have the defaults:
-			return false;
-		}
-
-		throw;
+		// This is a new player whom we haven't seen yet, bail out, let them have the defaults:
+		return false;
 	}
 
 	// Load the player data:
@@ -1868,7 +1814,11 @@ bool cPlayer::LoadFromFile(const AString & a_FileName)
 	{
 		// Load the player stats.
 		// We use the default world name (like bukkit) because stats are shared between dimensions / worlds.
-		StatisticsSerializer::Load(m_Stats, m_DefaultWorldPath, GetUUID().ToLongString());
+		Json::Value Stats;
+		if (Writer.Load(StatisticsSerializer::GetFileBaseName(m_DefaultWorldPath, GetUUID().ToLongString()), Stats))
+		{
+			StatisticsSerializer::LoadFromJSON(m_Stats, Stats);
+		}
 	}
 	catch (...)
 	{
@@ -1876,7 +1826,7 @@ bool cPlayer::LoadFromFile(const AString & a_FileName)
 	}
 
 	FLOGD("Player {0} was read from file \"{1}\", spawning at {2:.2f} in world \"{3}\"",
-		GetName(), a_FileName, GetPosition(), m_World->GetName()
+		GetName(), a_FileBaseName, GetPosition(), m_World->GetName()
 	);
 
 	return true;
@@ -1917,9 +1867,6 @@ void cPlayer::OpenHorseInventory()
 
 void cPlayer::SaveToDisk()
 {
-	const auto & UUID = GetUUID();
-	cFile::CreateFolderRecursive(GetUUIDFolderName(UUID));
-
 	// create the JSON data
 	Json::Value JSON_PlayerPosition;
 	JSON_PlayerPosition.append(Json::Value(GetPosX()));
@@ -1978,36 +1925,18 @@ void cPlayer::SaveToDisk()
 	root["world"]               = m_CurrentWorldName;
 	root["gamemode"]            = static_cast<int>(m_GameMode);
 
-	auto JsonData = JsonUtils::WriteStyledString(root);
-	AString SourceFile = GetUUIDFileName(UUID);
-
-	cFile f;
-	if (!f.Open(SourceFile, cFile::fmWrite))
-	{
-		LOGWARNING("Error writing player \"%s\" to file \"%s\": cannot open file. Player will lose their progress",
-			GetName().c_str(), SourceFile.c_str()
-		);
-		return;
-	}
-	if (f.Write(JsonData.c_str(), JsonData.size()) != static_cast<int>(JsonData.size()))
-	{
-		LOGWARNING("Error writing player \"%s\" to file \"%s\": cannot save data. Player will lose their progress",
-			GetName().c_str(), SourceFile.c_str()
-		);
-		return;
-	}
-
-	try
-	{
-		// Save the player stats.
-		// We use the default world name (like bukkit) because stats are shared between dimensions / worlds.
-		// TODO: save together with player.dat, not in some other place.
-		StatisticsSerializer::Save(m_Stats, m_DefaultWorldPath, GetUUID().ToLongString());
-	}
-	catch (...)
-	{
-		LOGWARNING("Error writing player \"%s\" statistics to file", GetName().c_str());
-	}
+	// Only the snapshot is taken here, the files are written by the player data writer thread:
+	auto & Writer = cRoot::Get()->GetPlayerDataWriter();
+	Writer.Queue(GetUUIDFileBaseName(GetUUID()), std::move(root), Writer.GetFormat());
+
+	// Save the player stats, always as JSON.
+	// We use the default world name (like bukkit) because stats are shared between dimensions / worlds.
+	// TODO: save together with player.dat, not in some other place.
+	Writer.Queue(
+		StatisticsSerializer::GetFileBaseName(m_DefaultWorldPath, GetUUID().ToLongString()),
+		StatisticsSerializer::SaveToJSON(m_Stats),
+		cPlayerDataWriter::eFormat::Json
+	);
 }
 
 
@@ -2313,21 +2242,9 @@ void cPlayer::LoadRank(void)
 	m_Restrictions = RankMgr->GetPlayerRestrictions(UUID);
 	RankMgr->GetRankVisuals(m_Rank, m_MsgPrefix, m_MsgSuffix, m_MsgNameColorCode);
 
-	// Break up the individual permissions on each dot, into m_SplitPermissions:
-	m_SplitPermissions.clear();
-	m_SplitPermissions.reserve(m_Permissions.size());
-	for (auto & Permission: m_Permissions)
-	{
-		m_SplitPermissions.push_back(StringSplit(Permission, "."));
-	}  // for Permission - m_Permissions[]
-
-	// Break up the individual restrictions on each dot, into m_SplitRestrictions:
-	m_SplitRestrictions.clear();
-	m_SplitRestrictions.reserve(m_Restrictions.size());
-	for (auto & Restriction: m_Restrictions)
-	{
-		m_SplitRestrictions.push_back(StringSplit(Restriction, "."));
-	}  // for itr - m_Restrictions[]
+	// Compile the permissions and restrictions for the HasPermission() lookup:
+	m_PermissionTrie.Compile(m_Permissions);
+	m_RestrictionTrie.Compile(m_Restrictions);
 }
 
 
@@ -2595,7 +2512,7 @@ void cPlayer::Detach()
 
 
 
-AString cPlayer::GetUUIDFileName(const cUUID & a_UUID)
+AString cPlayer::GetUUIDFileBaseName(const cUUID & a_UUID)
 {
 	AString UUID = a_UUID.ToLongString();
 
@@ -2603,7 +2520,6 @@ AString cPlayer::GetUUIDFileName(const cUUID & a_UUID)
 	res.append(UUID, 0, 2);
 	res.push_back('/');
 	res.append(UUID, 2, AString::npos);
-	res.append(".json");
 	return res;
 }
 
@@ -6,6 +6,7 @@
 #include "../Defines.h"
 #include "../World.h"
 #include "../Items/ItemHandler.h"
+#include "../PermissionTrie.h"
 
 #include "../StatisticsManager.h"
 
@@ -301,7 +302,8 @@ public:
 
 	// tolua_end
 
-	bool HasPermission(const AString & a_Permission);  // tolua_export
+	/** Returns true if the player's rank grants the permission and doesn't restrict it. The empty permission is always granted. */
+	bool HasPermission(std::string_view a_Permission);  // Exported in ManualBindings.cpp
 
 	/** Returns true iff a_Permission matches the a_Template.
 	A match is defined by either being exactly the same, or each sub-item matches until there's a wildcard in a_Template.
@@ -416,17 +418,18 @@ public:
 
 	void SetVisible( bool a_bVisible);  // tolua_export
 
-	/** Saves all player data, such as inventory, to JSON. */
+	/** Saves all player data, such as inventory, to JSON.
+	Takes a snapshot of the data, the file is written by cPlayerDataWriter on its own thread. */
 	void SaveToDisk(void);
 
 	/** Loads the player data from the disk file.
 	Sets m_World to the world where the player will spawn, based on the stored world name or the default world by calling LoadFromFile(). */
 	void LoadFromDisk();
 
-	/** Loads the player data from the specified file.
+	/** Loads the player data from the specified file, given without the extension, in any of the cPlayerDataWriter formats.
 	Sets m_World to the world where the player will spawn, based on the stored world name or the default world.
 	Returns true on success, false if the player wasn't found, and excepts with base std::runtime_error if the data couldn't be read or parsed. */
-	bool LoadFromFile(const AString & a_FileName);
+	bool LoadFromFile(const AString & a_FileBaseName);
 
 	const AString & GetLoadedWorldName() const { return m_CurrentWorldName; }
 
@@ -611,8 +614,6 @@ public:
 
 private:
 
-	typedef std::vector<std::vector<AString> > AStringVectorVector;
-
 	/** The current body stance the player has adopted. */
 	std::variant<BodyStanceCrouching, BodyStanceSleeping, BodyStanceSprinting, BodyStanceStanding, BodyStanceGliding> m_BodyStance;
 
@@ -625,13 +626,11 @@ private:
 	/** All the restrictions that this player has, based on their rank. */
 	AStringVector m_Restrictions;
 
-	/** All the permissions that this player has, based on their rank, split into individual dot-delimited parts.
-	This is used mainly by the HasPermission() function to optimize the lookup. */
-	AStringVectorVector m_SplitPermissions;
+	/** All the permissions that this player has, based on their rank, compiled for the HasPermission() lookup. */
+	cPermissionTrie m_PermissionTrie;
 
-	/** All the restrictions that this player has, based on their rank, split into individual dot-delimited parts.
-	This is used mainly by the HasPermission() function to optimize the lookup. */
-	AStringVectorVector m_SplitRestrictions;
+	/** All the restrictions that this player has, based on their rank, compiled for the HasPermission() lookup. */
+	cPermissionTrie m_RestrictionTrie;
 
 
 	// Message visuals:
@@ -758,9 +757,9 @@ private:
 	/** Called in each tick if the player is fishing to make sure the floater dissapears when the player doesn't have a fishing rod as equipped item. */
 	void HandleFloater(void);
 
-	/** Returns the filename for the player data based on the UUID given.
+	/** Returns the filename for the player data based on the UUID given, without the extension, which depends on the storage format.
 	This can be used both for online and offline UUIDs. */
-	AString GetUUIDFileName(const cUUID & a_UUID);
+	AString GetUUIDFileBaseName(const cUUID & a_UUID);
 
 	/** Pins the player to a_Location until Unfreeze() is called.
 	If ManuallyFrozen is false, the player will unfreeze when the chunk is loaded. */
@@ -1100,14 +1100,17 @@ public:
 			std::make_shared<cProtIntGenLandOcean      >(a_Seed + 100, 30
 		)))))))))))))))))))))))))))))));
 
+		// The upper levels are evaluated in tiles shared by the neighboring chunks;
+		// each chunk only needs an 8 * 8 area of the mixed biomes, so a 24 * 24 tile serves up to 36 chunks:
 		m_Gen =
 			std::make_shared<cProtIntGenSmooth   >(a_Seed,
 			std::make_shared<cProtIntGenZoom     >(a_Seed,
 			std::make_shared<cProtIntGenSmooth   >(a_Seed,
 			std::make_shared<cProtIntGenZoom     >(a_Seed,
+			std::make_shared<cProtIntGenTileCache>(24, 16,
 			std::make_shared<cProtIntGenMixRivers>(
 			FinalBiomes, FinalRivers
-		)))));
+		))))));
 	}
 
 	virtual void GenBiomes(cChunkCoords a_ChunkCoords, cChunkDef::BiomeMap & a_Biomes) override
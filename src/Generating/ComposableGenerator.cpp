@@ -18,6 +18,7 @@
 #include "CompoGenBiomal.h"
 
 #include "CompositedHeiGen.h"
+#include "GenDiskCache.h"
 
 #include "Caves.h"
 #include "DistortedHeightmap.h"
@@ -133,10 +134,17 @@ void cComposableGenerator::Initialize(cIniFile & a_IniFile)
 	// Add the defaults, if they're not overridden:
 	InitializeGeneratorDefaults(a_IniFile, m_Dimension);
 
+	// The disk cache object is needed by the subgenerators' adapters, but the file is opened only after all settings are read:
+	if (a_IniFile.GetValueSetB("Generator", "DiskCache", false))
+	{
+		m_DiskCache = std::make_shared<cGenDiskCache>();
+	}
+
 	InitBiomeGen(a_IniFile);
 	InitShapeGen(a_IniFile);
 	InitCompositionGen(a_IniFile);
 	InitFinishGens(a_IniFile);
+	OpenDiskCache(a_IniFile);
 }
 
 
@@ -285,6 +293,12 @@ void cComposableGenerator::InitBiomeGen(cIniFile & a_IniFile)
 	bool CacheOffByDefault = false;
 	m_BiomeGen = cBiomeGen::CreateBiomeGen(a_IniFile, m_Seed, CacheOffByDefault);
 
+	// Add the disk cache below the in-memory cache, so that it is only consulted on in-memory misses:
+	if (m_DiskCache != nullptr)
+	{
+		m_BiomeGen = std::make_unique<cBioGenDiskCache>(std::move(m_BiomeGen), m_DiskCache);
+	}
+
 	// Add a cache, if requested:
 	// The default is 16 * 128 caches, which is 2 MiB of RAM. Reasonable, for the amount of work this is saving.
 	int CacheSize = a_IniFile.GetValueSetI("Generator", "BiomeGenCacheSize", CacheOffByDefault ? 0 : 16);
@@ -367,7 +381,12 @@ void cComposableGenerator::InitCompositionGen(cIniFile & a_IniFile)
 	}
 
 	// Create a cache of the composited heightmaps, so that finishers may use it:
-	m_CompositedHeightCache = std::make_unique<cHeiGenMultiCache>(std::make_unique<cCompositedHeiGen>(*m_BiomeGen, *m_ShapeGen, *m_CompositionGen), 16, 128);
+	std::unique_ptr<cTerrainHeightGen> CompositedHeiGen = std::make_unique<cCompositedHeiGen>(*m_BiomeGen, *m_ShapeGen, *m_CompositionGen);
+	if (m_DiskCache != nullptr)
+	{
+		CompositedHeiGen = std::make_unique<cHeiGenDiskCache>(std::move(CompositedHeiGen), m_DiskCache);
+	}
+	m_CompositedHeightCache = std::make_unique<cHeiGenMultiCache>(std::move(CompositedHeiGen), 16, 128);
 	// 128 subcaches of depth 16 each = 0.5 MiB of RAM. Acceptable, for the amount of work this saves.
 }
 
@@ -375,6 +394,39 @@ void cComposableGenerator::InitCompositionGen(cIniFile & a_IniFile)
 
 
 
+void cComposableGenerator::OpenDiskCache(cIniFile & a_IniFile)
+{
+	if (m_DiskCache == nullptr)
+	{
+		return;
+	}
+
+	// The file lives in the world folder, next to world.ini, unless configured otherwise:
+	auto FileName = a_IniFile.GetValue("Generator", "DiskCacheFile");
+	if (FileName.empty())
+	{
+		const auto & IniFileName = a_IniFile.GetFileName();
+		const auto LastSeparator = IniFileName.find_last_of("/\\");
+		FileName = ((LastSeparator == AString::npos) ? AString() : IniFileName.substr(0, LastSeparator + 1)) + "GeneratorCache.dat";
+	}
+
+	// The default is 64 Ki chunks (a 256 x 256 chunk area), which is 33 MiB on the disk:
+	auto NumSlots = a_IniFile.GetValueSetI("Generator", "DiskCacheSize", 65536);
+	if (NumSlots <= 0)
+	{
+		LOGWARNING("Generator disk cache size set to %d, disabling the disk cache.", NumSlots);
+		return;
+	}
+
+	// Only calculate the hash after all settings have been read, since reading them may have added defaults.
+	// If the file cannot be opened, the adapters stay in place, but the unopened cache always misses and never stores anything.
+	m_DiskCache->Open(FileName, static_cast<size_t>(NumSlots), m_Seed, cGenDiskCache::CalcConfigHash(a_IniFile));
+}
+
+
+
+
+
 void cComposableGenerator::InitFinishGens(cIniFile & a_IniFile)
 {
 	auto seaLevel = a_IniFile.GetValueI("Generator", "SeaLevel");
@@ -30,6 +30,7 @@ class cTerrainShapeGen;
 class cTerrainHeightGen;
 class cTerrainCompositionGen;
 class cFinishGen;
+class cGenDiskCache;
 
 
 
@@ -230,6 +231,10 @@ protected:
 	/** The finisher generators, in the order in which they are applied. */
 	std::vector<std::unique_ptr<cFinishGen>> m_FinishGens;
 
+	/** The persistent cache of biome maps and composited heightmaps, shared by their disk cache adapters.
+	nullptr if the disk cache is disabled in the ini. */
+	std::shared_ptr<cGenDiskCache> m_DiskCache;
+
 
 	/** Reads the BiomeGen settings from the ini and initializes m_BiomeGen accordingly */
 	void InitBiomeGen(cIniFile & a_IniFile);
@@ -242,4 +247,8 @@ protected:
 
 	/** Reads the finishers from the ini and initializes m_FinishGens accordingly */
 	void InitFinishGens(cIniFile & a_IniFile);
+
+	/** Opens the disk cache file, if the disk cache is enabled.
+	Needs to be called after all the other generators have been initialized, so that the config hash covers all their settings. */
+	void OpenDiskCache(cIniFile & a_IniFile);
 } ;
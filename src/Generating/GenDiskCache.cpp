@@ -0,0 +1,375 @@
+
+// GenDiskCache.cpp
+
+// Implements the cGenDiskCache class representing a persistent, per-world file cache of biome maps and heightmaps
+
+#include "Globals.h"
+#include "GenDiskCache.h"
+#include "../IniFile.h"
+
+
+
+
+
+/** The magic bytes at the start of each cache file. */
+static const char CACHE_FILE_MAGIC[] = "CGDC";
+
+/** The version of the cache file format. Bump when the layout changes. */
+static const Int32 CACHE_FILE_VERSION = 1;
+
+/** Number of slots at which the cache is capped, so that slot offsets fit the cFile::Seek() range. */
+static const size_t MAX_NUM_SLOTS = 1024 * 1024;
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cGenDiskCache:
+
+cGenDiskCache::cGenDiskCache(void):
+	m_NumSlots(0),
+	m_NumHits(0),
+	m_NumMisses(0)
+{
+}
+
+
+
+
+
+bool cGenDiskCache::Open(const AString & a_FileName, size_t a_NumSlots, int a_Seed, UInt32 a_ConfigHash)
+{
+	cCSLock Lock(m_CS);
+	m_NumSlots = Clamp<size_t>(a_NumSlots, 1, MAX_NUM_SLOTS);
+
+	// Check the header of the existing file, if any:
+	if (cFile::IsFile(a_FileName) && m_File.Open(a_FileName, cFile::fmReadWrite))
+	{
+		std::array<std::byte, HEADER_SIZE> Header;
+		if (
+			(m_File.Read(Header.data(), Header.size()) == static_cast<int>(Header.size())) &&
+			(memcmp(Header.data(), CACHE_FILE_MAGIC, 4) == 0) &&
+			(GetBEInt(Header.data() + 4) == CACHE_FILE_VERSION) &&
+			(GetBEInt(Header.data() + 8) == a_Seed) &&
+			(static_cast<UInt32>(GetBEInt(Header.data() + 12)) == a_ConfigHash) &&
+			(static_cast<size_t>(GetBEInt(Header.data() + 16)) == m_NumSlots) &&
+			(m_File.GetSize() == static_cast<long>(HEADER_SIZE + m_NumSlots * SLOT_SIZE))
+		)
+		{
+			LOGD("Using the generator disk cache at \"%s\" (%zu slots).", a_FileName, m_NumSlots);
+			return true;
+		}
+		m_File.Close();
+		LOGINFO("The generator disk cache at \"%s\" is outdated (seed, settings or size changed), rebuilding.", a_FileName);
+	}
+
+	if (!CreateEmpty(a_FileName, a_Seed, a_ConfigHash))
+	{
+		LOGWARNING("Cannot create the generator disk cache at \"%s\", the disk cache will be disabled.", a_FileName);
+		m_File.Close();
+		return false;
+	}
+	return true;
+}
+
+
+
+
+
+bool cGenDiskCache::ReadBiomes(cChunkCoords a_Coords, cChunkDef::BiomeMap & a_BiomeMap)
+{
+	cSlot Slot;
+	if (!ReadSlot(a_Coords, slotHasBiomes, Slot))
+	{
+		return false;
+	}
+	for (size_t i = 0; i < ARRAYCOUNT(a_BiomeMap); i++)
+	{
+		a_BiomeMap[i] = static_cast<EMCSBiome>(Slot[SLOT_BIOMES_OFFSET + i]);
+	}
+	return true;
+}
+
+
+
+
+
+bool cGenDiskCache::ReadHeightMap(cChunkCoords a_Coords, cChunkDef::HeightMap & a_HeightMap)
+{
+	cSlot Slot;
+	if (!ReadSlot(a_Coords, slotHasHeightMap, Slot))
+	{
+		return false;
+	}
+	static_assert(sizeof(HEIGHTTYPE) == 1, "The disk cache stores heights as single bytes");
+	memcpy(a_HeightMap, Slot.data() + SLOT_HEIGHTS_OFFSET, sizeof(a_HeightMap));
+	return true;
+}
+
+
+
+
+
+void cGenDiskCache::WriteBiomes(cChunkCoords a_Coords, const cChunkDef::BiomeMap & a_BiomeMap)
+{
+	std::array<std::byte, cChunkDef::Width * cChunkDef::Width> Biomes;
+	for (size_t i = 0; i < Biomes.size(); i++)
+	{
+		ASSERT((a_BiomeMap[i] >= 0) && (a_BiomeMap[i] <= 255));
+		Biomes[i] = static_cast<std::byte>(a_BiomeMap[i]);
+	}
+	WriteSlotData(a_Coords, slotHasBiomes, SLOT_BIOMES_OFFSET, Biomes.data(), Biomes.size());
+}
+
+
+
+
+
+void cGenDiskCache::WriteHeightMap(cChunkCoords a_Coords, const cChunkDef::HeightMap & a_HeightMap)
+{
+	WriteSlotData(a_Coords, slotHasHeightMap, SLOT_HEIGHTS_OFFSET, a_HeightMap, sizeof(a_HeightMap));
+}
+
+
+
+
+
+UInt32 cGenDiskCache::CalcConfigHash(cIniFile & a_IniFile)
+{
+	// FNV-1a over all "name=value" pairs of the [Generator] section:
+	UInt32 Hash = 2166136261u;
+	auto HashString = [&Hash](const AString & a_String)
+	{
+		for (auto ch: a_String)
+		{
+			Hash ^= static_cast<UInt8>(ch);
+			Hash *= 16777619u;
+		}
+	};
+
+	int KeyID = a_IniFile.FindKey("Generator");
+	if (KeyID == cIniFile::noID)
+	{
+		return Hash;
+	}
+	int NumValues = a_IniFile.GetNumValues(KeyID);
+	for (int i = 0; i < NumValues; i++)
+	{
+		auto Name = a_IniFile.GetValueName(KeyID, i);
+		if (NoCaseCompare(Name.substr(0, 9), "DiskCache") == 0)
+		{
+			// The cache's own settings don't affect the generated data
+			continue;
+		}
+		HashString(StrToLower(Name));
+		HashString("=");
+		HashString(a_IniFile.GetValue(KeyID, i));
+		HashString("\n");
+	}
+	return Hash;
+}
+
+
+
+
+
+long cGenDiskCache::GetSlotOffset(cChunkCoords a_Coords) const
+{
+	auto Hash = static_cast<UInt32>(a_Coords.m_ChunkX) * 0x9e3779b1u ^ static_cast<UInt32>(a_Coords.m_ChunkZ) * 0x85ebca77u;
+	return static_cast<long>(HEADER_SIZE + (Hash % m_NumSlots) * SLOT_SIZE);
+}
+
+
+
+
+
+bool cGenDiskCache::ReadSlot(cChunkCoords a_Coords, UInt8 a_Flags, cSlot & a_Slot)
+{
+	cCSLock Lock(m_CS);
+	if (!m_File.IsOpen())
+	{
+		return false;
+	}
+	if (
+		(m_File.Seek(static_cast<int>(GetSlotOffset(a_Coords))) < 0) ||
+		(m_File.Read(a_Slot.data(), a_Slot.size()) != static_cast<int>(a_Slot.size()))
+	)
+	{
+		m_NumMisses++;
+		return false;
+	}
+	auto Flags = static_cast<UInt8>(a_Slot[8]);
+	if (
+		((Flags & a_Flags) != a_Flags) ||
+		(GetBEInt(a_Slot.data()) != a_Coords.m_ChunkX) ||
+		(GetBEInt(a_Slot.data() + 4) != a_Coords.m_ChunkZ)
+	)
+	{
+		m_NumMisses++;
+		return false;
+	}
+	m_NumHits++;
+	return true;
+}
+
+
+
+
+
+void cGenDiskCache::WriteSlotData(cChunkCoords a_Coords, UInt8 a_Flags, size_t a_Offset, const void * a_Data, size_t a_NumBytes)
+{
+	cCSLock Lock(m_CS);
+	if (!m_File.IsOpen())
+	{
+		return;
+	}
+
+	// Read the slot header, to find out whether the slot already holds (some) data for this chunk:
+	auto SlotOffset = static_cast<int>(GetSlotOffset(a_Coords));
+	std::array<std::byte, SLOT_BIOMES_OFFSET> SlotHeader;
+	if (
+		(m_File.Seek(SlotOffset) < 0) ||
+		(m_File.Read(SlotHeader.data(), SlotHeader.size()) != static_cast<int>(SlotHeader.size()))
+	)
+	{
+		return;
+	}
+	auto Flags = static_cast<UInt8>(SlotHeader[8]);
+	if ((GetBEInt(SlotHeader.data()) != a_Coords.m_ChunkX) || (GetBEInt(SlotHeader.data() + 4) != a_Coords.m_ChunkZ))
+	{
+		// The slot holds another chunk, evict it:
+		Flags = 0;
+		SetBEInt(SlotHeader.data(), a_Coords.m_ChunkX);
+		SetBEInt(SlotHeader.data() + 4, a_Coords.m_ChunkZ);
+	}
+	SlotHeader[8] = static_cast<std::byte>(Flags | a_Flags);
+
+	// Write the data first and the header last, so that an interrupted write doesn't mark garbage as valid:
+	if (
+		(m_File.Seek(SlotOffset + static_cast<int>(a_Offset)) < 0) ||
+		(m_File.Write(a_Data, a_NumBytes) != static_cast<int>(a_NumBytes))
+	)
+	{
+		return;
+	}
+	m_File.Seek(SlotOffset);
+	m_File.Write(SlotHeader.data(), SlotHeader.size());
+}
+
+
+
+
+
+bool cGenDiskCache::CreateEmpty(const AString & a_FileName, int a_Seed, UInt32 a_ConfigHash)
+{
+	if (!m_File.Open(a_FileName, cFile::fmWrite))
+	{
+		return false;
+	}
+
+	std::array<std::byte, HEADER_SIZE> Header{};
+	memcpy(Header.data(), CACHE_FILE_MAGIC, 4);
+	SetBEInt(Header.data() + 4, CACHE_FILE_VERSION);
+	SetBEInt(Header.data() + 8, a_Seed);
+	SetBEInt(Header.data() + 12, static_cast<Int32>(a_ConfigHash));
+	SetBEInt(Header.data() + 16, static_cast<Int32>(m_NumSlots));
+	if (m_File.Write(Header.data(), Header.size()) != static_cast<int>(Header.size()))
+	{
+		return false;
+	}
+
+	// Zero all the slots, in batches, so that the file has its final size and all slots are marked empty:
+	const size_t SlotsPerBatch = 256;
+	std::vector<std::byte> Zeroes(SlotsPerBatch * SLOT_SIZE);
+	for (size_t i = 0; i < m_NumSlots; i += SlotsPerBatch)
+	{
+		auto NumBytes = std::min(SlotsPerBatch, m_NumSlots - i) * SLOT_SIZE;
+		if (m_File.Write(Zeroes.data(), NumBytes) != static_cast<int>(NumBytes))
+		{
+			return false;
+		}
+	}
+
+	// Re-open for random access:
+	m_File.Close();
+	return m_File.Open(a_FileName, cFile::fmReadWrite);
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cBioGenDiskCache:
+
+cBioGenDiskCache::cBioGenDiskCache(std::unique_ptr<cBiomeGen> a_BioGenToCache, std::shared_ptr<cGenDiskCache> a_DiskCache):
+	m_Underlying(std::move(a_BioGenToCache)),
+	m_DiskCache(std::move(a_DiskCache))
+{
+}
+
+
+
+
+
+void cBioGenDiskCache::GenBiomes(cChunkCoords a_ChunkCoords, cChunkDef::BiomeMap & a_BiomeMap)
+{
+	if (m_DiskCache->ReadBiomes(a_ChunkCoords, a_BiomeMap))
+	{
+		return;
+	}
+	m_Underlying->GenBiomes(a_ChunkCoords, a_BiomeMap);
+	m_DiskCache->WriteBiomes(a_ChunkCoords, a_BiomeMap);
+}
+
+
+
+
+
+void cBioGenDiskCache::InitializeBiomeGen(cIniFile & a_IniFile)
+{
+	Super::InitializeBiomeGen(a_IniFile);
+	m_Underlying->InitializeBiomeGen(a_IniFile);
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cHeiGenDiskCache:
+
+cHeiGenDiskCache::cHeiGenDiskCache(std::unique_ptr<cTerrainHeightGen> a_HeiGenToCache, std::shared_ptr<cGenDiskCache> a_DiskCache):
+	m_Underlying(std::move(a_HeiGenToCache)),
+	m_DiskCache(std::move(a_DiskCache))
+{
+}
+
+
+
+
+
+void cHeiGenDiskCache::GenHeightMap(cChunkCoords a_ChunkCoords, cChunkDef::HeightMap & a_HeightMap)
+{
+	if (m_DiskCache->ReadHeightMap(a_ChunkCoords, a_HeightMap))
+	{
+		return;
+	}
+	m_Underlying->GenHeightMap(a_ChunkCoords, a_HeightMap);
+	m_DiskCache->WriteHeightMap(a_ChunkCoords, a_HeightMap);
+}
+
+
+
+
+
+void cHeiGenDiskCache::InitializeHeightGen(cIniFile & a_IniFile)
+{
+	Super::InitializeHeightGen(a_IniFile);
+	m_Underlying->InitializeHeightGen(a_IniFile);
+}
+
+
+
+
@@ -0,0 +1,172 @@
+
+// GenDiskCache.h
+
+// Declares the cGenDiskCache class representing a persistent, per-world file cache of biome maps and heightmaps
+// Also declares the cBioGenDiskCache and cHeiGenDiskCache adapters that put the file cache in front of a generator
+
+/*
+The cache file is a fixed-size, direct-mapped table of slots, each slot holding one chunk's biome map and
+composited heightmap. A chunk maps to exactly one slot; a colliding chunk simply overwrites the slot.
+The file header stores the world seed and a hash of the [Generator] ini section; if either differs from the
+current values, the entire file is discarded and rebuilt, so that stale data is never returned.
+
+The disk cache is meant to sit below the in-memory caches (cBioGenMulticache, cHeiGenMultiCache), so that
+it is only consulted on their misses.
+*/
+
+
+
+
+
+#pragma once
+
+#include "ComposableGenerator.h"
+
+
+
+
+
+class cGenDiskCache
+{
+public:
+
+	/** Creates an unopened cache. Use Open() to attach it to a file. */
+	cGenDiskCache(void);
+
+	/** Opens the specified cache file, creating or resetting it if needed.
+	a_NumSlots is the number of chunks the file can hold.
+	a_Seed and a_ConfigHash version the data; a file created with different values is discarded.
+	Returns true on success, false if the file couldn't be opened (the cache then stays inactive). */
+	bool Open(const AString & a_FileName, size_t a_NumSlots, int a_Seed, UInt32 a_ConfigHash);
+
+	/** Returns true if the cache has been successfully opened. */
+	bool IsOpen(void) const { return m_File.IsOpen(); }
+
+	/** Reads the biome map for the specified chunk into a_BiomeMap.
+	Returns true on hit, false if the chunk's biomes are not stored in the cache. */
+	bool ReadBiomes(cChunkCoords a_Coords, cChunkDef::BiomeMap & a_BiomeMap);
+
+	/** Reads the heightmap for the specified chunk into a_HeightMap.
+	Returns true on hit, false if the chunk's heightmap is not stored in the cache. */
+	bool ReadHeightMap(cChunkCoords a_Coords, cChunkDef::HeightMap & a_HeightMap);
+
+	/** Stores the biome map for the specified chunk. */
+	void WriteBiomes(cChunkCoords a_Coords, const cChunkDef::BiomeMap & a_BiomeMap);
+
+	/** Stores the heightmap for the specified chunk. */
+	void WriteHeightMap(cChunkCoords a_Coords, const cChunkDef::HeightMap & a_HeightMap);
+
+	/** Calculates the hash of the generator configuration, used for versioning the cache file.
+	Hashes all the values in the [Generator] section of the ini file, except for the disk cache's own settings. */
+	static UInt32 CalcConfigHash(cIniFile & a_IniFile);
+
+protected:
+
+	/** Bits in the slot's flags byte marking the data present in the slot. */
+	enum
+	{
+		slotHasBiomes    = 0x01,
+		slotHasHeightMap = 0x02,
+	};
+
+	/** Size of the file header, in bytes. */
+	static const size_t HEADER_SIZE = 32;
+
+	/** Size of a single slot, in bytes: ChunkX, ChunkZ, Flags + padding, biomes, heights. */
+	static const size_t SLOT_SIZE = 4 + 4 + 4 + cChunkDef::Width * cChunkDef::Width * 2;
+
+	/** Offset of the biome data within a slot. */
+	static const size_t SLOT_BIOMES_OFFSET = 12;
+
+	/** Offset of the heightmap data within a slot. */
+	static const size_t SLOT_HEIGHTS_OFFSET = SLOT_BIOMES_OFFSET + cChunkDef::Width * cChunkDef::Width;
+
+	using cSlot = std::array<std::byte, SLOT_SIZE>;
+
+	/** Protects m_File, since the file position is shared state. */
+	cCriticalSection m_CS;
+
+	/** The underlying file. */
+	cFile m_File;
+
+	/** Number of slots in the file. */
+	size_t m_NumSlots;
+
+	// Statistics:
+	size_t m_NumHits;
+	size_t m_NumMisses;
+
+
+	/** Returns the file offset of the slot that holds the specified chunk. */
+	long GetSlotOffset(cChunkCoords a_Coords) const;
+
+	/** Reads the slot for the specified chunk.
+	Returns true if the slot holds the specified chunk and has all the bits of a_Flags set. */
+	bool ReadSlot(cChunkCoords a_Coords, UInt8 a_Flags, cSlot & a_Slot);
+
+	/** Writes a_NumBytes bytes of a_Data into the specified chunk's slot at the specified offset, adding a_Flags to the slot.
+	If the slot currently holds a different chunk, it is overwritten. */
+	void WriteSlotData(cChunkCoords a_Coords, UInt8 a_Flags, size_t a_Offset, const void * a_Data, size_t a_NumBytes);
+
+	/** Creates a new empty file with the header and all slots zeroed. Returns true on success. */
+	bool CreateEmpty(const AString & a_FileName, int a_Seed, UInt32 a_ConfigHash);
+};
+
+
+
+
+
+/** A biome generator that stores biome maps in the disk cache, and returns them from there when available. */
+class cBioGenDiskCache:
+	public cBiomeGen
+{
+	using Super = cBiomeGen;
+
+public:
+
+	cBioGenDiskCache(std::unique_ptr<cBiomeGen> a_BioGenToCache, std::shared_ptr<cGenDiskCache> a_DiskCache);
+
+protected:
+
+	/** The underlying biome generator. */
+	std::unique_ptr<cBiomeGen> m_Underlying;
+
+	/** The file cache, shared with the heightmap cache. */
+	std::shared_ptr<cGenDiskCache> m_DiskCache;
+
+
+	// cBiomeGen overrides:
+	virtual void GenBiomes(cChunkCoords a_ChunkCoords, cChunkDef::BiomeMap & a_BiomeMap) override;
+	virtual void InitializeBiomeGen(cIniFile & a_IniFile) override;
+};
+
+
+
+
+
+/** A height generator that stores heightmaps in the disk cache, and returns them from there when available. */
+class cHeiGenDiskCache:
+	public cTerrainHeightGen
+{
+	using Super = cTerrainHeightGen;
+
+public:
+
+	cHeiGenDiskCache(std::unique_ptr<cTerrainHeightGen> a_HeiGenToCache, std::shared_ptr<cGenDiskCache> a_DiskCache);
+
+	// cTerrainHeightGen overrides:
+	virtual void GenHeightMap(cChunkCoords a_ChunkCoords, cChunkDef::HeightMap & a_HeightMap) override;
+	virtual void InitializeHeightGen(cIniFile & a_IniFile) override;
+
+protected:
+
+	/** The underlying height generator. */
+	std::unique_ptr<cTerrainHeightGen> m_Underlying;
+
+	/** The file cache, shared with the biome cache. */
+	std::shared_ptr<cGenDiskCache> m_DiskCache;
+};
+
+
+
+
@@ -54,7 +54,10 @@ cGridStructGen::cGridStructGen(
 	m_MaxOffsetZ(a_MaxOffsetZ),
 	m_MaxStructureSizeX(a_MaxStructureSizeX),
 	m_MaxStructureSizeZ(a_MaxStructureSizeZ),
-	m_MaxCacheSize(a_MaxCacheSize)
+	m_MaxCacheSize(a_MaxCacheSize),
+	m_CacheCost(0),
+	m_NumCacheHits(0),
+	m_NumCacheMisses(0)
 {
 	if (m_GridSizeX == 0)
 	{
@@ -91,7 +94,10 @@ cGridStructGen::cGridStructGen(int a_Seed):
 	m_MaxOffsetZ(128),
 	m_MaxStructureSizeX(128),
 	m_MaxStructureSizeZ(128),
-	m_MaxCacheSize(256)
+	m_MaxCacheSize(256),
+	m_CacheCost(0),
+	m_NumCacheHits(0),
+	m_NumCacheMisses(0)
 {
 }
 
@@ -99,6 +105,21 @@ cGridStructGen::cGridStructGen(int a_Seed):
 
 
 
+cGridStructGen::~cGridStructGen()
+{
+	size_t NumQueries = m_NumCacheHits + m_NumCacheMisses;
+	if (NumQueries > 0)
+	{
+		LOGD("cGridStructGen: %zu cache hits, %zu misses, saved %.2f %%",
+			m_NumCacheHits.load(), m_NumCacheMisses.load(), 100.0 * m_NumCacheHits / NumQueries
+		);
+	}
+}
+
+
+
+
+
 void cGridStructGen::SetGeneratorParams(const AStringMap & a_GeneratorParams)
 {
 	ASSERT(m_Cache.empty());  // No changing the params after chunks are generated
@@ -130,6 +151,33 @@ void cGridStructGen::SetGeneratorParams(const AStringMap & a_GeneratorParams)
 
 
 
+void cGridStructGen::ClearCache(void)
+{
+	cCSLock Lock(m_CSCache);
+	m_Cache.clear();
+	m_CacheIndex.clear();
+	m_CacheCost = 0;
+}
+
+
+
+
+
+void cGridStructGen::TrimCache(void)
+{
+	while ((m_CacheCost > m_MaxCacheSize) && !m_Cache.empty())
+	{
+		const auto & Oldest = m_Cache.back();
+		m_CacheIndex.erase(GridCellKey(Oldest.m_Structure->m_GridX, Oldest.m_Structure->m_GridZ));
+		m_CacheCost -= Oldest.m_Cost;
+		m_Cache.pop_back();
+	}
+}
+
+
+
+
+
 void cGridStructGen::GetStructuresForChunk(int a_ChunkX, int a_ChunkZ, cStructurePtrs & a_Structures)
 {
 	// Calculate the min and max grid coords of the structures to be returned:
@@ -141,76 +189,45 @@ void cGridStructGen::GetStructuresForChunk(int a_ChunkX, int a_ChunkZ, cStructur
 	int MinGridZ = MinBlockZ / m_GridSizeZ;
 	int MaxGridX = (MaxBlockX + m_GridSizeX - 1) / m_GridSizeX;
 	int MaxGridZ = (MaxBlockZ + m_GridSizeZ - 1) / m_GridSizeZ;
-	int MinX = MinGridX * m_GridSizeX;
-	int MaxX = MaxGridX * m_GridSizeX;
-	int MinZ = MinGridZ * m_GridSizeZ;
-	int MaxZ = MaxGridZ * m_GridSizeZ;
-
-	// Walk the cache, move each structure that we want into a_Structures:
-	for (cStructurePtrs::iterator itr = m_Cache.begin(), end = m_Cache.end(); itr != end;)
-	{
-		if (
-			((*itr)->m_GridX >= MinX) && ((*itr)->m_GridX < MaxX) &&
-			((*itr)->m_GridZ >= MinZ) && ((*itr)->m_GridZ < MaxZ)
-		)
-		{
-			// want
-			a_Structures.push_back(*itr);
-			itr = m_Cache.erase(itr);
-		}
-		else
-		{
-			// don't want
-			++itr;
-		}
-	}  // for itr - m_Cache[]
 
-	// Create those structures that haven't been in the cache:
+	cCSLock Lock(m_CSCache);
 	for (int x = MinGridX; x < MaxGridX; x++)
 	{
 		int GridX = x * m_GridSizeX;
 		for (int z = MinGridZ; z < MaxGridZ; z++)
 		{
 			int GridZ = z * m_GridSizeZ;
-			bool Found = false;
-			for (cStructurePtrs::const_iterator itr = a_Structures.begin(), end = a_Structures.end(); itr != end; ++itr)
+			auto Key = GridCellKey(GridX, GridZ);
+
+			// If the structure is in the cache, move it to the front (most recently used):
+			auto itr = m_CacheIndex.find(Key);
+			if (itr != m_CacheIndex.end())
 			{
-				if (((*itr)->m_GridX == GridX) && ((*itr)->m_GridZ == GridZ))
-				{
-					Found = true;
-					break;
-				}
-			}  // for itr - a_Structures[]
-			if (!Found)
+				m_Cache.splice(m_Cache.begin(), m_Cache, itr->second);
+				a_Structures.push_back(itr->second->m_Structure);
+				m_NumCacheHits++;
+				continue;
+			}
+
+			// Not in the cache, create the structure and insert it at the front:
+			m_NumCacheMisses++;
+			int OriginX = GridX + ((m_Noise.IntNoise2DInt(GridX + 3, GridZ + 5) / 7) % (m_MaxOffsetX * 2)) - m_MaxOffsetX;
+			int OriginZ = GridZ + ((m_Noise.IntNoise2DInt(GridX + 5, GridZ + 3) / 7) % (m_MaxOffsetZ * 2)) - m_MaxOffsetZ;
+			cStructurePtr Structure = CreateStructure(GridX, GridZ, OriginX, OriginZ);
+			if (Structure.get() == nullptr)
 			{
-				int OriginX = GridX + ((m_Noise.IntNoise2DInt(GridX + 3, GridZ + 5) / 7) % (m_MaxOffsetX * 2)) - m_MaxOffsetX;
-				int OriginZ = GridZ + ((m_Noise.IntNoise2DInt(GridX + 5, GridZ + 3) / 7) % (m_MaxOffsetZ * 2)) - m_MaxOffsetZ;
-				cStructurePtr Structure = CreateStructure(GridX, GridZ, OriginX, OriginZ);
-				if (Structure.get() == nullptr)
-				{
-					Structure.reset(new cEmptyStructure(GridX, GridZ, OriginX, OriginZ));
-				}
-				a_Structures.push_back(Structure);
+				Structure.reset(new cEmptyStructure(GridX, GridZ, OriginX, OriginZ));
 			}
+			auto Cost = Structure->GetCacheCost();
+			m_Cache.push_front({Structure, Cost});
+			m_CacheIndex[Key] = m_Cache.begin();
+			m_CacheCost += Cost;
+			a_Structures.push_back(std::move(Structure));
 		}  // for z
 	}  // for x
 
-	// Copy a_Forts into m_Cache to the beginning:
-	cStructurePtrs StructuresCopy (a_Structures);
-	m_Cache.splice(m_Cache.begin(), StructuresCopy, StructuresCopy.begin(), StructuresCopy.end());
-
-	// Trim the cache if it's too long:
-	size_t CacheSize = 0;
-	for (cStructurePtrs::iterator itr = m_Cache.begin(), end = m_Cache.end(); itr != end; ++itr)
-	{
-		CacheSize += (*itr)->GetCacheCost();
-		if (CacheSize > m_MaxCacheSize)
-		{
-			// Erase all items from this one till the cache end
-			m_Cache.erase(itr, m_Cache.end());
-			break;
-		}
-	}
+	// Trim the cache if it's too large; the structures for this chunk are kept alive by a_Structures even if evicted:
+	TrimCache();
 }
 
 
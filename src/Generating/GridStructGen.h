@@ -29,9 +29,10 @@ which it's built (m_OriginX, m_OriginZ).
 This class provides a cache for the structures generated for successive chunks and manages that cache. It
 also provides the cFinishGen override that uses the cache to actually generate the structure into chunk data.
 
-After generating each chunk the cache is checked for size, each item in the cache has a cost associated with
+The cache is indexed by a hash map from the grid cell to the structure, so each chunk only probes the cells it
+needs. After generating each chunk the cache is checked for size, each item in the cache has a cost associated with
 it and the cache is trimmed (from its least-recently-used end) so that the sum of the cost in the cache is
-less than m_MaxCacheSize
+less than m_MaxCacheSize. The cache is protected by a lock, so a single instance may be queried from multiple threads.
 
 To use this class, declare a descendant class that implements the overridable methods, then create an
 instance of that class. The descendant must provide the CreateStructure() function that is called to generate
@@ -94,10 +95,31 @@ public:
 	Note that this must not be called anymore after generating a chunk. */
 	void SetGeneratorParams(const AStringMap & a_GeneratorParams);
 
+	virtual ~cGridStructGen() override;
+
 	// cFinishGen override:
 	virtual void GenFinish(cChunkDesc & a_ChunkDesc) override;
 
+	/** Returns the number of grid cells that were found in the cache since the generator was created. */
+	size_t GetNumCacheHits(void) const { return m_NumCacheHits; }
+
+	/** Returns the number of grid cells that needed a structure created since the generator was created. */
+	size_t GetNumCacheMisses(void) const { return m_NumCacheMisses; }
+
 protected:
+
+	/** A single item in the structure cache. */
+	struct sCacheItem
+	{
+		cStructurePtr m_Structure;
+
+		/** The cost of the structure, as reported by its GetCacheCost() when it was inserted. */
+		size_t m_Cost;
+	};
+
+	using cCacheItems = std::list<sCacheItem>;
+
+
 	/** Base seed of the world for which the generator generates chunk. */
 	int m_BaseSeed;
 
@@ -134,16 +156,40 @@ protected:
 	cache, oldest-first */
 	size_t m_MaxCacheSize;
 
-	/** Cache for the most recently generated structures, ordered by the recentness. */
-	cStructurePtrs m_Cache;
+	/** Protects the cache and its statistics against concurrent access. */
+	cCriticalSection m_CSCache;
+
+	/** Cache for the most recently generated structures, ordered by the recentness (most recent first). */
+	cCacheItems m_Cache;
+
+	/** Index into m_Cache, maps the grid cell (as returned by GridCellKey()) to the cache item. */
+	std::unordered_map<UInt64, cCacheItems::iterator> m_CacheIndex;
+
+	/** Sum of the costs of all the items in m_Cache. */
+	size_t m_CacheCost;
+
+	// Cache statistics:
+	std::atomic<size_t> m_NumCacheHits;
+	std::atomic<size_t> m_NumCacheMisses;
 
 
 	/** Clears everything from the cache */
 	void ClearCache(void);
 
+	/** Returns the key into m_CacheIndex for the specified grid cell. */
+	static UInt64 GridCellKey(int a_GridX, int a_GridZ)
+	{
+		return (static_cast<UInt64>(static_cast<UInt32>(a_GridX)) << 32) | static_cast<UInt32>(a_GridZ);
+	}
+
+	/** Removes the least recently used items from the cache until its cost fits within m_MaxCacheSize.
+	Expects m_CSCache to be held by the caller. */
+	void TrimCache(void);
+
 	/** Returns all structures that may intersect the given chunk.
 	The structures are considered as intersecting iff their bounding box (defined by m_MaxStructureSize)
-	around their gridpoint intersects the chunk. */
+	around their gridpoint intersects the chunk.
+	The structures are returned in the grid order (X-major), regardless of the cache state. */
 	void GetStructuresForChunk(int a_ChunkX, int a_ChunkZ, cStructurePtrs & a_Structures);
 
 	// Functions for the descendants to override:
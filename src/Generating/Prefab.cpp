@@ -29,14 +29,15 @@ cPrefab::cPrefab(const cPrefab::sDef & a_Def) :
 	m_AddWeightIfSame(a_Def.m_AddWeightIfSame),
 	m_MoveToGround(a_Def.m_MoveToGround)
 {
-	m_BlockArea[0].Create(m_Size);
+	cBlockArea Image;
+	Image.Create(m_Size, cBlockArea::baTypes | cBlockArea::baMetas);
 	CharMap cm;
 	ParseCharMap(cm, a_Def.m_CharMap);
-	ParseBlockImage(cm, a_Def.m_Image);
+	ParseBlockImage(cm, a_Def.m_Image, Image);
 	ParseConnectors(a_Def.m_Connectors);
 	ParseDepthWeight(a_Def.m_DepthWeight);
 
-	AddRotatedBlockAreas();
+	PackBlockAreas(Image);
 }
 
 
@@ -54,8 +55,7 @@ cPrefab::cPrefab(const cBlockArea & a_Image, int a_AllowedRotations) :
 {
 	m_HitBox.p1.Set(0, 0, 0);
 	m_HitBox.p2.Set(m_Size.x - 1, m_Size.y - 1, m_Size.z - 1);
-	m_BlockArea[0].CopyFrom(a_Image);
-	AddRotatedBlockAreas();
+	PackBlockAreas(a_Image);
 }
 
 
@@ -73,7 +73,7 @@ cPrefab::cPrefab(const cBlockArea & a_Image) :
 {
 	m_HitBox.p1.Set(0, 0, 0);
 	m_HitBox.p2.Set(m_Size.x - 1, m_Size.y - 1, m_Size.z - 1);
-	m_BlockArea[0].CopyFrom(a_Image);
+	PackBlockAreas(a_Image);
 }
 
 
@@ -91,38 +91,48 @@ cPrefab::cPrefab(const AString & a_BlockDefinitions, const AString & a_BlockData
 {
 	m_HitBox.p1.Set(0, 0, 0);
 	m_HitBox.p2.Set(m_Size.x - 1, m_Size.y - 1, m_Size.z - 1);
-	m_BlockArea[0].Create(m_Size);
+	cBlockArea Image;
+	Image.Create(m_Size, cBlockArea::baTypes | cBlockArea::baMetas);
 	CharMap cm;
 	ParseCharMap(cm, a_BlockDefinitions.c_str());
-	ParseBlockImage(cm, a_BlockData.c_str());
+	ParseBlockImage(cm, a_BlockData.c_str(), Image);
+	PackBlockAreas(Image);
 }
 
 
 
 
 
-void cPrefab::AddRotatedBlockAreas(void)
+void cPrefab::PackBlockAreas(const cBlockArea & a_Image)
 {
+	m_BlockArea[0].Pack(a_Image);
+
+	// The rotations are done on a temporary unpacked copy:
+	cBlockArea Rotated;
+
 	// 1 CCW rotation:
 	if ((m_AllowedRotations & 0x01) != 0)
 	{
-		m_BlockArea[1].CopyFrom(m_BlockArea[0]);
-		m_BlockArea[1].RotateCCW();
+		Rotated.CopyFrom(a_Image);
+		Rotated.RotateCCW();
+		m_BlockArea[1].Pack(Rotated);
 	}
 
 	// 2 rotations are the same as mirroring twice; mirroring is faster because it has no reallocations
 	if ((m_AllowedRotations & 0x02) != 0)
 	{
-		m_BlockArea[2].CopyFrom(m_BlockArea[0]);
-		m_BlockArea[2].MirrorXY();
-		m_BlockArea[2].MirrorYZ();
+		Rotated.CopyFrom(a_Image);
+		Rotated.MirrorXY();
+		Rotated.MirrorYZ();
+		m_BlockArea[2].Pack(Rotated);
 	}
 
 	// 3 CCW rotations = 1 CW rotation:
 	if ((m_AllowedRotations & 0x04) != 0)
 	{
-		m_BlockArea[3].CopyFrom(m_BlockArea[0]);
-		m_BlockArea[3].RotateCW();
+		Rotated.CopyFrom(a_Image);
+		Rotated.RotateCW();
+		m_BlockArea[3].Pack(Rotated);
 	}
 }
 
@@ -146,7 +156,7 @@ void cPrefab::Draw(cChunkDesc & a_Dest, const Vector3i & a_Placement, int a_NumR
 	int ChunkStartX = a_Dest.GetChunkX() * cChunkDef::Width;
 	int ChunkStartZ = a_Dest.GetChunkZ() * cChunkDef::Width;
 	Placement.Move(-ChunkStartX, 0, -ChunkStartZ);
-	const cBlockArea & Image = m_BlockArea[a_NumRotations];
+	const cPackedBlockArea & Image = m_BlockArea[a_NumRotations];
 
 	// If the placement is outside this chunk, bail out:
 	if (
@@ -159,13 +169,22 @@ void cPrefab::Draw(cChunkDesc & a_Dest, const Vector3i & a_Placement, int a_NumR
 
 	if (m_Modifiers.size() == 0)
 	{
-		// Write the image:
-		a_Dest.WriteBlockArea(Image, Placement.x, Placement.y, Placement.z, m_MergeStrategy);
+		// Unpack and write only the part of the image that is within this chunk:
+		cCuboid InChunk(
+			{-Placement.x, 0, -Placement.z},
+			{cChunkDef::Width - 1 - Placement.x, Image.GetSizeY() - 1, cChunkDef::Width - 1 - Placement.z}
+		);
+		cBlockArea ChunkImage;
+		if (Image.Unpack(ChunkImage, InChunk))
+		{
+			a_Dest.WriteBlockArea(ChunkImage, Placement.x + std::max(InChunk.p1.x, 0), Placement.y, Placement.z + std::max(InChunk.p1.z, 0), m_MergeStrategy);
+		}
 	}
 	else
 	{
+		// The modifiers work on the whole image:
 		cBlockArea RandomizedImage;
-		Image.CopyTo(RandomizedImage);
+		Image.Unpack(RandomizedImage);
 
 		for (size_t i = 0; i < m_Modifiers.size(); i++)
 		{
@@ -329,7 +348,9 @@ void cPrefab::AddConnector(int a_RelX, int a_RelY, int a_RelZ, cPiece::cConnecto
 void cPrefab::SetAllowedRotations(int a_AllowedRotations)
 {
 	m_AllowedRotations = a_AllowedRotations;
-	AddRotatedBlockAreas();
+	cBlockArea Image;
+	m_BlockArea[0].Unpack(Image);
+	PackBlockAreas(Image);
 }
 
 
@@ -375,7 +396,7 @@ void cPrefab::ParseCharMap(CharMap & a_CharMapOut, const char * a_CharMapDef)
 
 
 
-void cPrefab::ParseBlockImage(const CharMap & a_CharMap, const char * a_BlockImage)
+void cPrefab::ParseBlockImage(const CharMap & a_CharMap, const char * a_BlockImage, cBlockArea & a_Image)
 {
 	// Map each letter in the a_BlockImage (from the in-source definition) to real blocktype / blockmeta:
 	for (int y = 0; y < m_Size.y; y++)
@@ -387,7 +408,7 @@ void cPrefab::ParseBlockImage(const CharMap & a_CharMap, const char * a_BlockIma
 			{
 				const sBlockTypeDef & MappedValue = a_CharMap[BlockImage[x]];
 				ASSERT(MappedValue.m_BlockMeta != 16);  // Using a letter not defined in the CharMap?
-				m_BlockArea[0].SetRelBlockTypeMeta(x, y, z, MappedValue.m_BlockType, MappedValue.m_BlockMeta);
+				a_Image.SetRelBlockTypeMeta(x, y, z, MappedValue.m_BlockType, MappedValue.m_BlockMeta);
 			}
 		}
 	}
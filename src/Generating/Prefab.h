@@ -16,6 +16,7 @@ declared in this file as well; the Gallery server exports areas in this format.
 
 #include "PiecePool.h"
 #include "../BlockArea.h"
+#include "../PackedBlockArea.h"
 
 
 
@@ -171,9 +172,9 @@ protected:
 	typedef std::map<int, int> cDepthWeight;
 
 
-	/** The cBlockArea that contains the block definitions for the prefab.
+	/** The block definitions for the prefab, packed to save memory; the pools keep all their prefabs loaded for the server's lifetime.
 	The index identifies the number of CCW rotations applied (0 = no rotation, 1 = 1 CCW rotation, ...). */
-	cBlockArea m_BlockArea[4];
+	cPackedBlockArea m_BlockArea[4];
 
 	/** The size of the prefab */
 	Vector3i m_Size;
@@ -220,15 +221,14 @@ protected:
 	virtual cCuboid GetHitBox(void) const override;
 	virtual bool CanRotateCCW(int a_NumRotations) const override;
 
-	/** Based on the m_AllowedRotations, adds rotated cBlockAreas to the m_BlockArea array.
-	To be called only from this class's constructor! */
-	void AddRotatedBlockAreas(void);
+	/** Packs a_Image into m_BlockArea[0] and, based on the m_AllowedRotations, adds its rotated versions to the m_BlockArea array. */
+	void PackBlockAreas(const cBlockArea & a_Image);
 
 	/** Parses the CharMap in the definition into a CharMap binary data used for translating the definition into BlockArea. */
 	void ParseCharMap(CharMap & a_CharMapOut, const char * a_CharMapDef);
 
-	/** Parses the Image in the definition into m_BlockArea[0]'s block types and metas, using the specified CharMap. */
-	void ParseBlockImage(const CharMap & a_CharMap, const char * a_BlockImage);
+	/** Parses the Image in the definition into a_Image's block types and metas, using the specified CharMap. */
+	void ParseBlockImage(const CharMap & a_CharMap, const char * a_BlockImage, cBlockArea & a_Image);
 
 	/** Parses the connectors definition text into m_Connectors member. */
 	void ParseConnectors(const char * a_ConnectorsDef);
@@ -24,6 +24,8 @@ overhead; this however means that there's (an arbitrary) limit to the size of th
 // We need the biome group constants defined there:
 #include "IntGen.h"
 
+#include "../OSSupport/ThreadPool.h"
+
 
 
 
@@ -1727,3 +1729,209 @@ protected:
 
 
 
+
+
+
+
+
+/** Caches the underlying generator's values in square tiles, aligned to a grid of the tile size.
+Neighboring requests, such as the upper pipeline levels of neighboring chunks, share the tiles instead of
+each generating its own overlapping area. Since all the generators are pure functions of the absolute
+coordinates, the output is identical to querying the underlying generator directly.
+When a request needs more than one tile that is not cached yet, the missing tiles are generated in parallel.
+The underlying generators must be thread-safe (which all the generators in this file are). */
+class cProtIntGenTileCache:
+	public cProtIntGen
+{
+	using Super = cProtIntGen;
+
+public:
+
+	/** Creates a new cache of a_NumTiles tiles, each a_TileSize * a_TileSize values, over the specified generator. */
+	cProtIntGenTileCache(int a_TileSize, size_t a_NumTiles, Underlying a_Underlying):
+		m_TileSize(a_TileSize),
+		m_NumTiles(a_NumTiles),
+		m_Underlying(a_Underlying),
+		m_NumHits(0),
+		m_NumMisses(0)
+	{
+		ASSERT(a_TileSize > 0);
+		ASSERT(a_TileSize * a_TileSize <= m_BufferSize);
+		ASSERT(a_NumTiles > 0);
+	}
+
+
+	virtual void GetInts(int a_MinX, int a_MinZ, size_t a_SizeX, size_t a_SizeZ, int * a_Values) override
+	{
+		// Collect the tiles covering the requested area:
+		const int MinTileX = FloorDiv(a_MinX);
+		const int MinTileZ = FloorDiv(a_MinZ);
+		const int MaxTileX = FloorDiv(a_MinX + static_cast<int>(a_SizeX) - 1);
+		const int MaxTileZ = FloorDiv(a_MinZ + static_cast<int>(a_SizeZ) - 1);
+		std::vector<cTilePtr> Tiles;
+		Tiles.reserve(static_cast<size_t>((MaxTileX - MinTileX + 1) * (MaxTileZ - MinTileZ + 1)));
+		for (int TileZ = MinTileZ; TileZ <= MaxTileZ; TileZ++)
+		{
+			for (int TileX = MinTileX; TileX <= MaxTileX; TileX++)
+			{
+				Tiles.push_back(GetTile(TileX, TileZ));
+			}
+		}
+		GenerateMissingTiles(Tiles);
+
+		// Copy the overlapping part of each tile into the output:
+		for (const auto & Tile : Tiles)
+		{
+			const int TileMinX = Tile->m_TileX * m_TileSize;
+			const int TileMinZ = Tile->m_TileZ * m_TileSize;
+			const int FromX = std::max(a_MinX, TileMinX);
+			const int ToX = std::min(a_MinX + static_cast<int>(a_SizeX), TileMinX + m_TileSize);
+			const int FromZ = std::max(a_MinZ, TileMinZ);
+			const int ToZ = std::min(a_MinZ + static_cast<int>(a_SizeZ), TileMinZ + m_TileSize);
+			for (int z = FromZ; z < ToZ; z++)
+			{
+				memcpy(
+					a_Values + static_cast<size_t>(FromX - a_MinX) + static_cast<size_t>(z - a_MinZ) * a_SizeX,
+					Tile->m_Values.data() + (FromX - TileMinX) + (z - TileMinZ) * m_TileSize,
+					static_cast<size_t>(ToX - FromX) * sizeof(int)
+				);
+			}
+		}
+	}
+
+	/** Returns the number of tiles that were found in the cache. */
+	size_t GetNumHits(void) const { return m_NumHits; }
+
+	/** Returns the number of tiles that had to be generated. */
+	size_t GetNumMisses(void) const { return m_NumMisses; }
+
+protected:
+
+	/** A single tile of the underlying generator's values.
+	m_Values is empty until the tile is generated. */
+	struct sTile
+	{
+		int m_TileX, m_TileZ;
+		std::vector<int> m_Values;
+
+		sTile(int a_TileX, int a_TileZ):
+			m_TileX(a_TileX),
+			m_TileZ(a_TileZ)
+		{
+		}
+	};
+
+	using cTilePtr = std::shared_ptr<sTile>;
+
+
+	/** Size of the tiles' sides. */
+	int m_TileSize;
+
+	/** Maximum number of tiles kept in the cache. */
+	size_t m_NumTiles;
+
+	/** The generator whose values are being cached. */
+	Underlying m_Underlying;
+
+	/** Protects m_Tiles and the statistics against concurrent access. */
+	std::mutex m_CS;
+
+	/** The cached tiles, the most recently used first. Only generated tiles are stored here. */
+	std::vector<cTilePtr> m_Tiles;
+
+	// Statistics:
+	size_t m_NumHits;
+	size_t m_NumMisses;
+
+
+	/** Returns the tile coord containing the specified value coord. */
+	int FloorDiv(int a_Coord) const
+	{
+		return (a_Coord >= 0) ? (a_Coord / m_TileSize) : ((a_Coord + 1) / m_TileSize - 1);
+	}
+
+
+	/** Returns the cached tile at the specified tile coords, or a new, not yet generated tile if not cached. */
+	cTilePtr GetTile(int a_TileX, int a_TileZ)
+	{
+		std::lock_guard<std::mutex> Lock(m_CS);
+		for (size_t i = 0; i < m_Tiles.size(); i++)
+		{
+			if ((m_Tiles[i]->m_TileX != a_TileX) || (m_Tiles[i]->m_TileZ != a_TileZ))
+			{
+				continue;
+			}
+
+			// Move to front:
+			auto Tile = m_Tiles[i];
+			std::rotate(m_Tiles.begin(), m_Tiles.begin() + static_cast<ptrdiff_t>(i), m_Tiles.begin() + static_cast<ptrdiff_t>(i) + 1);
+			m_NumHits++;
+			return Tile;
+		}
+		m_NumMisses++;
+		return std::make_shared<sTile>(a_TileX, a_TileZ);
+	}
+
+
+	/** Generates the values for the tiles that haven't been generated yet and stores them in the cache.
+	If there is more than one such tile, they are generated in parallel on the shared thread pool. */
+	void GenerateMissingTiles(std::vector<cTilePtr> & a_Tiles)
+	{
+		std::vector<cTilePtr> Missing;
+		for (const auto & Tile : a_Tiles)
+		{
+			if (Tile->m_Values.empty())
+			{
+				Missing.push_back(Tile);
+			}
+		}
+		if (Missing.empty())
+		{
+			return;
+		}
+
+		// Generate the tiles on the shared thread pool:
+		std::vector<cThreadPool::cTask> Tasks;
+		Tasks.reserve(Missing.size());
+		for (const auto & Tile : Missing)
+		{
+			Tasks.emplace_back([this, &Tile]()
+				{
+					GenerateTile(*Tile);
+				}
+			);
+		}
+		cThreadPool::Get().RunAll(Tasks);
+
+		// Insert the new tiles as the most recently used, evicting the least recently used ones.
+		// Another thread may have generated the same tile in the meantime, don't store it twice:
+		std::lock_guard<std::mutex> Lock(m_CS);
+		for (const auto & Tile : Missing)
+		{
+			const auto IsSameTile = [&Tile](const cTilePtr & a_Cached)
+			{
+				return (a_Cached->m_TileX == Tile->m_TileX) && (a_Cached->m_TileZ == Tile->m_TileZ);
+			};
+			if (std::none_of(m_Tiles.begin(), m_Tiles.end(), IsSameTile))
+			{
+				m_Tiles.insert(m_Tiles.begin(), Tile);
+			}
+		}
+		if (m_Tiles.size() > m_NumTiles)
+		{
+			m_Tiles.resize(m_NumTiles);
+		}
+	}
+
+
+	/** Fills the tile's values from the underlying generator. */
+	void GenerateTile(sTile & a_Tile)
+	{
+		a_Tile.m_Values.resize(static_cast<size_t>(m_TileSize * m_TileSize));
+		m_Underlying->GetInts(
+			a_Tile.m_TileX * m_TileSize, a_Tile.m_TileZ * m_TileSize,
+			static_cast<size_t>(m_TileSize), static_cast<size_t>(m_TileSize),
+			a_Tile.m_Values.data()
+		);
+	}
+};
@@ -82,6 +82,9 @@ public:
 
 	virtual bool KeyExists(const AString a_keyName) const override;
 
+	/** Returns the name of the file last passed to ReadFile(), or an empty string if no file has been read. */
+	const AString & GetFileName(void) const { return m_Filename; }
+
 	// tolua_begin
 
 	// Sets whether or not keynames and valuenames should be case sensitive.
@@ -8,6 +8,7 @@
 #include "ChunkMap.h"
 #include "World.h"
 #include "BlockInfo.h"
+#include "Metrics.h"
 
 
 
@@ -102,6 +103,8 @@ public:
 cLightingThread::cLightingThread(cWorld & a_World):
 	Super("Lighting Executor"),
 	m_World(a_World),
+	m_NumLitMetric(cMetrics::Get().GetCounter("cuberite_chunks_lit_total", "The number of the chunks lit", {{"world", a_World.GetName()}})),
+	m_LightingTimeMetric(cMetrics::Get().GetHistogram("cuberite_chunk_lighting_seconds", "The time taken to light a chunk", {{"world", a_World.GetName()}})),
 	m_MaxHeight(0),
 	m_NumSeeds(0)
 {
@@ -243,6 +246,7 @@ void cLightingThread::LightChunk(cLightingChunkStay & a_Item)
 		return;
 	}
 
+	cMetricTimer Timer(m_LightingTimeMetric);
 	cChunkDef::BlockNibbles BlockLight, SkyLight;
 
 	ReadChunks(a_Item.m_ChunkX, a_Item.m_ChunkZ);
@@ -316,6 +320,7 @@ void cLightingThread::LightChunk(cLightingChunkStay & a_Item)
 	CompressLight(m_SkyLight, SkyLight);
 
 	m_World.ChunkLighted(a_Item.m_ChunkX, a_Item.m_ChunkZ, BlockLight, SkyLight);
+	m_NumLitMetric.Add();
 
 	if (a_Item.m_CallbackAfter != nullptr)
 	{
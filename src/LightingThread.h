@@ -41,6 +41,10 @@ Chunks from m_PostponedQueue are moved back into m_Queue when their neighbors ge
 // fwd: "cWorld.h"
 class cWorld;
 
+// fwd: "Metrics.h"
+class cMetricCounter;
+class cMetricHistogram;
+
 
 
 
@@ -94,6 +98,10 @@ protected:
 
 	cWorld & m_World;
 
+	/** The number of the chunks lit, and the time taken by each, in cMetrics. */
+	cMetricCounter & m_NumLitMetric;
+	cMetricHistogram & m_LightingTimeMetric;
+
 	/** The mutex to protect m_Queue and m_PendingQueue */
 	cCriticalSection m_CS;
 
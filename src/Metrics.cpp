@@ -0,0 +1,419 @@
+
+// Metrics.cpp
+
+// Implements the cMetrics registry of the server's runtime metrics and their Prometheus text export
+
+#include "Globals.h"
+#include "Metrics.h"
+
+
+
+
+
+/** The powers of two, in nanoseconds, used as the bucket bounds of the exported histograms: 4 us, 16 us, ..., 68.7 s.
+The internal buckets are much finer, but a short fixed set of bounds keeps the exported series cheap to scrape and store. */
+static const int ExportedBucketBits[] = {12, 14, 16, 18, 20, 22, 24, 26, 28, 30, 32, 34, 36};
+
+
+
+
+
+/** Returns the index of the highest set bit of the value. The value must be nonzero. */
+static int HighestBit(UInt64 a_Value)
+{
+	int res = 0;
+	for (int Shift = 32; Shift > 0; Shift /= 2)
+	{
+		if (a_Value >= (UInt64(1) << Shift))
+		{
+			a_Value >>= Shift;
+			res += Shift;
+		}
+	}
+	return res;
+}
+
+
+
+
+
+/** Returns the string escaped for use as a label value or a help text in the Prometheus text format. */
+static AString EscapePrometheus(const AString & a_String, bool a_ShouldEscapeQuotes)
+{
+	AString res;
+	res.reserve(a_String.size());
+	for (auto ch: a_String)
+	{
+		switch (ch)
+		{
+			case '\\': res.append("\\\\"); break;
+			case '\n': res.append("\\n");  break;
+			case '"':  res.append(a_ShouldEscapeQuotes ? "\\\"" : "\""); break;
+			default:   res.push_back(ch);  break;
+		}
+	}
+	return res;
+}
+
+
+
+
+
+/** Returns the name of the type as used in the Prometheus text format. */
+static const char * TypeToString(cMetric::eType a_Type)
+{
+	switch (a_Type)
+	{
+		case cMetric::eType::Counter:   return "counter";
+		case cMetric::eType::Gauge:     return "gauge";
+		case cMetric::eType::Histogram: return "histogram";
+	}
+	UNREACHABLE("Unsupported metric type");
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cMetricCounter:
+
+void cMetricCounter::ExportPrometheus(AString & a_Out, const AString & a_Name, const AString & a_Labels) const
+{
+	a_Out.append(fmt::format(FMT_STRING("{}{} {}\n"), a_Name, a_Labels, GetValue()));
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cMetricGauge:
+
+void cMetricGauge::ExportPrometheus(AString & a_Out, const AString & a_Name, const AString & a_Labels) const
+{
+	a_Out.append(fmt::format(FMT_STRING("{}{} {}\n"), a_Name, a_Labels, GetValue()));
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cMetricHistogram:
+
+void cMetricHistogram::Record(std::chrono::nanoseconds a_Duration)
+{
+	RecordNs(static_cast<UInt64>(std::max<std::chrono::nanoseconds::rep>(a_Duration.count(), 0)));
+}
+
+
+
+
+
+void cMetricHistogram::RecordNs(UInt64 a_Nanoseconds)
+{
+	m_Buckets[BucketIndex(a_Nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+	m_Count.fetch_add(1, std::memory_order_relaxed);
+	m_SumNs.fetch_add(a_Nanoseconds, std::memory_order_relaxed);
+
+	// Update the maximum; most of the time the value is lower and this is a single load:
+	auto Max = m_MaxNs.load(std::memory_order_relaxed);
+	while ((a_Nanoseconds > Max) && !m_MaxNs.compare_exchange_weak(Max, a_Nanoseconds, std::memory_order_relaxed))
+	{
+	}
+}
+
+
+
+
+
+std::chrono::nanoseconds cMetricHistogram::GetPercentile(double a_Fraction) const
+{
+	// Take a snapshot of the buckets, so that the total is consistent with the counts:
+	std::array<UInt64, NumBuckets> Buckets;
+	UInt64 Total = 0;
+	for (size_t i = 0; i < NumBuckets; i++)
+	{
+		Buckets[i] = m_Buckets[i].load(std::memory_order_relaxed);
+		Total += Buckets[i];
+	}
+	if (Total == 0)
+	{
+		return std::chrono::nanoseconds(0);
+	}
+
+	// Find the bucket containing the requested rank:
+	auto Rank = static_cast<UInt64>(std::ceil(Clamp(a_Fraction, 0.0, 1.0) * static_cast<double>(Total)));
+	Rank = Clamp<UInt64>(Rank, 1, Total);
+	UInt64 Cumulative = 0;
+	auto Max = m_MaxNs.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < NumBuckets; i++)
+	{
+		Cumulative += Buckets[i];
+		if (Cumulative >= Rank)
+		{
+			return std::chrono::nanoseconds(std::min(BucketLowerBound(i + 1), Max));
+		}
+	}
+	return std::chrono::nanoseconds(Max);
+}
+
+
+
+
+
+size_t cMetricHistogram::BucketIndex(UInt64 a_Nanoseconds)
+{
+	if (a_Nanoseconds < NumSubBuckets)
+	{
+		// The small values have a bucket each:
+		return static_cast<size_t>(a_Nanoseconds);
+	}
+	auto Value = std::min(a_Nanoseconds, MaxValueNs);
+	auto Shift = HighestBit(Value) - SubBucketBits;
+	return static_cast<size_t>(static_cast<UInt64>(Shift + 1) * NumSubBuckets + ((Value >> Shift) & (NumSubBuckets - 1)));
+}
+
+
+
+
+
+UInt64 cMetricHistogram::BucketLowerBound(size_t a_Index)
+{
+	if (a_Index < NumSubBuckets)
+	{
+		return a_Index;
+	}
+	auto Shift = a_Index / NumSubBuckets - 1;
+	auto SubBucket = a_Index % NumSubBuckets;
+	return (NumSubBuckets + SubBucket) << Shift;
+}
+
+
+
+
+
+void cMetricHistogram::ExportPrometheus(AString & a_Out, const AString & a_Name, const AString & a_Labels) const
+{
+	// The "le" label is added to the label set of the metric:
+	auto LabelsPrefix = a_Labels.empty() ? AString("{") : (a_Labels.substr(0, a_Labels.size() - 1) + ",");
+
+	// The exported bounds are powers of two, and thus all fall on the internal bucket bounds:
+	UInt64 Cumulative = 0;
+	size_t Bucket = 0;
+	for (auto Bits: ExportedBucketBits)
+	{
+		auto BoundIndex = BucketIndex(UInt64(1) << Bits);
+		for (; Bucket < BoundIndex; Bucket++)
+		{
+			Cumulative += m_Buckets[Bucket].load(std::memory_order_relaxed);
+		}
+		a_Out.append(fmt::format(FMT_STRING("{}_bucket{}le=\"{}\"}} {}\n"),
+			a_Name, LabelsPrefix, static_cast<double>(UInt64(1) << Bits) / 1e9, Cumulative
+		));
+	}
+	for (; Bucket < NumBuckets; Bucket++)
+	{
+		Cumulative += m_Buckets[Bucket].load(std::memory_order_relaxed);
+	}
+
+	// Report the count as the sum of the buckets, so that it matches the "+Inf" bucket even while other threads record values:
+	a_Out.append(fmt::format(FMT_STRING("{}_bucket{}le=\"+Inf\"}} {}\n"), a_Name, LabelsPrefix, Cumulative));
+	a_Out.append(fmt::format(FMT_STRING("{}_sum{} {}\n"), a_Name, a_Labels, static_cast<double>(m_SumNs.load(std::memory_order_relaxed)) / 1e9));
+	a_Out.append(fmt::format(FMT_STRING("{}_count{} {}\n"), a_Name, a_Labels, Cumulative));
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cMetrics:
+
+cMetrics & cMetrics::Get(void)
+{
+	static cMetrics Instance;
+	return Instance;
+}
+
+
+
+
+
+cMetricCounter & cMetrics::GetCounter(const AString & a_Name, const AString & a_Help, const AStringMap & a_Labels)
+{
+	return static_cast<cMetricCounter &>(GetMetric(a_Name, a_Help, a_Labels, cMetric::eType::Counter));
+}
+
+
+
+
+
+cMetricGauge & cMetrics::GetGauge(const AString & a_Name, const AString & a_Help, const AStringMap & a_Labels)
+{
+	return static_cast<cMetricGauge &>(GetMetric(a_Name, a_Help, a_Labels, cMetric::eType::Gauge));
+}
+
+
+
+
+
+cMetricHistogram & cMetrics::GetHistogram(const AString & a_Name, const AString & a_Help, const AStringMap & a_Labels)
+{
+	return static_cast<cMetricHistogram &>(GetMetric(a_Name, a_Help, a_Labels, cMetric::eType::Histogram));
+}
+
+
+
+
+
+AString cMetrics::GetPrometheusText(void)
+{
+	AString res;
+	cCSLock Lock(m_CS);
+	for (const auto & Family: m_Families)
+	{
+		res.append(fmt::format(FMT_STRING("# HELP {} {}\n"), Family.first, EscapePrometheus(Family.second.m_Help, false)));
+		res.append(fmt::format(FMT_STRING("# TYPE {} {}\n"), Family.first, TypeToString(Family.second.m_Type)));
+		for (const auto & Metric: Family.second.m_Metrics)
+		{
+			Metric.second->ExportPrometheus(res, Family.first, FormatLabels(Metric.first));
+		}
+	}
+	return res;
+}
+
+
+
+
+
+std::vector<cMetrics::sSample> cMetrics::GetSamples(void)
+{
+	std::vector<sSample> res;
+	cCSLock Lock(m_CS);
+	for (const auto & Family: m_Families)
+	{
+		for (const auto & Metric: Family.second.m_Metrics)
+		{
+			sSample Sample{Family.first, Metric.first, Family.second.m_Type, 0, 0, 0, 0, 0, 0};
+			switch (Family.second.m_Type)
+			{
+				case cMetric::eType::Counter:
+				{
+					Sample.m_Value = static_cast<double>(static_cast<const cMetricCounter &>(*Metric.second).GetValue());
+					break;
+				}
+				case cMetric::eType::Gauge:
+				{
+					Sample.m_Value = static_cast<double>(static_cast<const cMetricGauge &>(*Metric.second).GetValue());
+					break;
+				}
+				case cMetric::eType::Histogram:
+				{
+					using FloatSeconds = std::chrono::duration<double>;
+					const auto & Histogram = static_cast<const cMetricHistogram &>(*Metric.second);
+					Sample.m_Value = static_cast<double>(Histogram.GetCount());
+					Sample.m_Sum = std::chrono::duration_cast<FloatSeconds>(Histogram.GetSum()).count();
+					Sample.m_P50 = std::chrono::duration_cast<FloatSeconds>(Histogram.GetPercentile(0.5)).count();
+					Sample.m_P90 = std::chrono::duration_cast<FloatSeconds>(Histogram.GetPercentile(0.9)).count();
+					Sample.m_P99 = std::chrono::duration_cast<FloatSeconds>(Histogram.GetPercentile(0.99)).count();
+					Sample.m_Max = std::chrono::duration_cast<FloatSeconds>(Histogram.GetMax()).count();
+					break;
+				}
+			}
+			res.push_back(std::move(Sample));
+		}
+	}
+	return res;
+}
+
+
+
+
+
+AString cMetrics::FormatLabels(const AStringMap & a_Labels)
+{
+	if (a_Labels.empty())
+	{
+		return {};
+	}
+	AString res("{");
+	for (const auto & Label: a_Labels)
+	{
+		if (res.size() > 1)
+		{
+			res.push_back(',');
+		}
+		res.append(fmt::format(FMT_STRING("{}=\"{}\""), Label.first, EscapePrometheus(Label.second, true)));
+	}
+	res.push_back('}');
+	return res;
+}
+
+
+
+
+
+bool cMetrics::IsValidName(const AString & a_Name)
+{
+	if (a_Name.empty() || ((a_Name[0] >= '0') && (a_Name[0] <= '9')))
+	{
+		return false;
+	}
+	for (auto ch: a_Name)
+	{
+		if (
+			!((ch >= 'a') && (ch <= 'z')) &&
+			!((ch >= 'A') && (ch <= 'Z')) &&
+			!((ch >= '0') && (ch <= '9')) &&
+			(ch != '_')
+		)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+
+
+cMetric & cMetrics::GetMetric(const AString & a_Name, const AString & a_Help, const AStringMap & a_Labels, cMetric::eType a_Type)
+{
+	if (!IsValidName(a_Name))
+	{
+		throw std::logic_error(fmt::format(FMT_STRING("Invalid metric name \"{}\""), a_Name));
+	}
+	for (const auto & Label: a_Labels)
+	{
+		if (!IsValidName(Label.first) || (Label.first == "le"))
+		{
+			throw std::logic_error(fmt::format(FMT_STRING("Invalid label name \"{}\" of metric \"{}\""), Label.first, a_Name));
+		}
+	}
+
+	cCSLock Lock(m_CS);
+	auto itr = m_Families.find(a_Name);
+	if (itr == m_Families.end())
+	{
+		itr = m_Families.emplace(a_Name, sFamily{a_Help, a_Type, {}}).first;
+	}
+	else if (itr->second.m_Type != a_Type)
+	{
+		throw std::logic_error(fmt::format(FMT_STRING("Metric \"{}\" is already registered as a {}"), a_Name, TypeToString(itr->second.m_Type)));
+	}
+
+	auto & Metric = itr->second.m_Metrics[a_Labels];
+	if (Metric == nullptr)
+	{
+		switch (a_Type)
+		{
+			case cMetric::eType::Counter:   Metric = std::make_unique<cMetricCounter>();   break;
+			case cMetric::eType::Gauge:     Metric = std::make_unique<cMetricGauge>();     break;
+			case cMetric::eType::Histogram: Metric = std::make_unique<cMetricHistogram>(); break;
+		}
+	}
+	return *Metric;
+}
@@ -0,0 +1,256 @@
+
+// Metrics.h
+
+// Declares the cMetrics registry of the server's runtime metrics (counters, gauges and latency histograms)
+// and exports them in the Prometheus text format
+
+#pragma once
+
+#include "OSSupport/CriticalSection.h"
+
+
+
+
+
+/** The base of all the metrics stored in the cMetrics registry. */
+class cMetric
+{
+public:
+
+	enum class eType
+	{
+		Counter,
+		Gauge,
+		Histogram,
+	};
+
+	virtual ~cMetric() {}
+
+	/** Returns the type of the metric. */
+	virtual eType GetType(void) const = 0;
+
+	/** Appends the samples of the metric, in the Prometheus text format, to a_Out.
+	a_Labels is the already formatted label set, including the braces, or empty if the metric has no labels. */
+	virtual void ExportPrometheus(AString & a_Out, const AString & a_Name, const AString & a_Labels) const = 0;
+};
+
+
+
+
+
+/** A value that only ever increases, such as the number of packets sent.
+All the operations are lock-free and may be called from any thread. */
+class cMetricCounter:
+	public cMetric
+{
+public:
+
+	void Add(UInt64 a_Value = 1) { m_Value.fetch_add(a_Value, std::memory_order_relaxed); }
+
+	UInt64 GetValue(void) const { return m_Value.load(std::memory_order_relaxed); }
+
+	// cMetric overrides:
+	virtual eType GetType(void) const override { return eType::Counter; }
+	virtual void ExportPrometheus(AString & a_Out, const AString & a_Name, const AString & a_Labels) const override;
+
+protected:
+
+	std::atomic<UInt64> m_Value{0};
+};
+
+
+
+
+
+/** A value that goes up and down, such as a queue length.
+All the operations are lock-free and may be called from any thread. */
+class cMetricGauge:
+	public cMetric
+{
+public:
+
+	void Set(Int64 a_Value) { m_Value.store(a_Value, std::memory_order_relaxed); }
+
+	void Add(Int64 a_Value) { m_Value.fetch_add(a_Value, std::memory_order_relaxed); }
+
+	Int64 GetValue(void) const { return m_Value.load(std::memory_order_relaxed); }
+
+	// cMetric overrides:
+	virtual eType GetType(void) const override { return eType::Gauge; }
+	virtual void ExportPrometheus(AString & a_Out, const AString & a_Name, const AString & a_Labels) const override;
+
+protected:
+
+	std::atomic<Int64> m_Value{0};
+};
+
+
+
+
+
+/** A distribution of durations, such as the tick phase times.
+The durations are counted in log-linear buckets, HDR-histogram style: each power of two is split into NumSubBuckets
+equal sub-buckets, so the percentiles have a relative error of at most 1 / NumSubBuckets over the whole range
+(up to MaxValueNs) while recording stays a single atomic increment.
+All the operations are lock-free and may be called from any thread. */
+class cMetricHistogram:
+	public cMetric
+{
+public:
+
+	/** The number of bits of each value that select the sub-bucket within its power of two. */
+	static constexpr int SubBucketBits = 3;
+	static constexpr UInt64 NumSubBuckets = 1 << SubBucketBits;
+
+	/** The values are recorded in nanoseconds, the longer durations are clamped to MaxValueNs (about 18 minutes). */
+	static constexpr int MaxValueBits = 40;
+	static constexpr UInt64 MaxValueNs = (UInt64(1) << MaxValueBits) - 1;
+
+	static constexpr size_t NumBuckets = static_cast<size_t>((MaxValueBits - SubBucketBits + 1) * NumSubBuckets);
+
+
+	/** Records a single duration. */
+	void Record(std::chrono::nanoseconds a_Duration);
+
+	/** Records a single duration given in nanoseconds. */
+	void RecordNs(UInt64 a_Nanoseconds);
+
+	/** Returns the number of the recorded durations. */
+	UInt64 GetCount(void) const { return m_Count.load(std::memory_order_relaxed); }
+
+	/** Returns the sum of the recorded durations. */
+	std::chrono::nanoseconds GetSum(void) const { return std::chrono::nanoseconds(m_SumNs.load(std::memory_order_relaxed)); }
+
+	/** Returns the longest recorded duration. */
+	std::chrono::nanoseconds GetMax(void) const { return std::chrono::nanoseconds(m_MaxNs.load(std::memory_order_relaxed)); }
+
+	/** Returns the duration below which the specified fraction (0 .. 1) of the recorded durations lies.
+	The result is the upper bound of the bucket containing the percentile, but never more than the maximum. Returns zero if nothing was recorded. */
+	std::chrono::nanoseconds GetPercentile(double a_Fraction) const;
+
+	/** Returns the index of the bucket into which the value, in nanoseconds, is recorded. */
+	static size_t BucketIndex(UInt64 a_Nanoseconds);
+
+	/** Returns the smallest value, in nanoseconds, recorded into the specified bucket. */
+	static UInt64 BucketLowerBound(size_t a_Index);
+
+	// cMetric overrides:
+	virtual eType GetType(void) const override { return eType::Histogram; }
+	virtual void ExportPrometheus(AString & a_Out, const AString & a_Name, const AString & a_Labels) const override;
+
+protected:
+
+	std::array<std::atomic<UInt64>, NumBuckets> m_Buckets{};
+	std::atomic<UInt64> m_Count{0};
+	std::atomic<UInt64> m_SumNs{0};
+	std::atomic<UInt64> m_MaxNs{0};
+};
+
+
+
+
+
+/** Measures the time between its construction and destruction into a histogram. */
+class cMetricTimer
+{
+public:
+
+	cMetricTimer(cMetricHistogram & a_Histogram):
+		m_Histogram(a_Histogram),
+		m_Start(std::chrono::steady_clock::now())
+	{
+	}
+
+	~cMetricTimer()
+	{
+		m_Histogram.Record(std::chrono::steady_clock::now() - m_Start);
+	}
+
+protected:
+
+	cMetricHistogram & m_Histogram;
+	std::chrono::steady_clock::time_point m_Start;
+};
+
+
+
+
+
+/** The registry of all the runtime metrics of the server.
+The metrics are identified by their name and their labels; the Get...() functions create the metric upon the first request,
+and return the same object for the same name and labels afterwards. The returned references stay valid for the lifetime
+of the process, so the instrumented code looks the metrics up once and then updates them lock-free on its hot path.
+Only the lookups and the export lock the registry. */
+class cMetrics
+{
+public:
+
+	/** A snapshot of a single metric's values, used by the Lua API. */
+	struct sSample
+	{
+		AString m_Name;
+		AStringMap m_Labels;
+		cMetric::eType m_Type;
+
+		/** The value of a counter or a gauge, the number of the recorded durations of a histogram. */
+		double m_Value;
+
+		/** The histogram statistics, in seconds. Zero for the other types. */
+		double m_Sum, m_P50, m_P90, m_P99, m_Max;
+	};
+
+
+	/** Returns the process-wide instance of the registry. */
+	static cMetrics & Get(void);
+
+	/** Returns the counter of the specified name and labels, creating it if needed.
+	Throws a std::logic_error if a metric of the same name but of a different type exists. */
+	cMetricCounter & GetCounter(const AString & a_Name, const AString & a_Help, const AStringMap & a_Labels = {});
+
+	/** Returns the gauge of the specified name and labels, creating it if needed.
+	Throws a std::logic_error if a metric of the same name but of a different type exists. */
+	cMetricGauge & GetGauge(const AString & a_Name, const AString & a_Help, const AStringMap & a_Labels = {});
+
+	/** Returns the histogram of the specified name and labels, creating it if needed.
+	Throws a std::logic_error if a metric of the same name but of a different type exists. */
+	cMetricHistogram & GetHistogram(const AString & a_Name, const AString & a_Help, const AStringMap & a_Labels = {});
+
+	/** Returns all the metrics in the Prometheus text exposition format. */
+	AString GetPrometheusText(void);
+
+	/** Returns a snapshot of all the metrics, sorted by their name and labels. */
+	std::vector<sSample> GetSamples(void);
+
+	/** Returns the label set formatted for the Prometheus text format, including the braces, or an empty string for no labels. */
+	static AString FormatLabels(const AStringMap & a_Labels);
+
+	/** Returns true if the name is a valid Prometheus metric or label name. */
+	static bool IsValidName(const AString & a_Name);
+
+protected:
+
+	/** All the metrics sharing a name. */
+	struct sFamily
+	{
+		AString m_Help;
+		cMetric::eType m_Type;
+
+		/** The metrics of the family, indexed by their label set. */
+		std::map<AStringMap, std::unique_ptr<cMetric>> m_Metrics;
+	};
+
+
+	/** Protects m_Families against multithreaded access. Doesn't protect the values of the metrics, those are atomic. */
+	cCriticalSection m_CS;
+
+	/** All the metric families, indexed by their name. */
+	std::map<AString, sFamily> m_Families;
+
+
+	/** Returns the metric of the specified name, type and labels, creating it if needed. */
+	cMetric & GetMetric(const AString & a_Name, const AString & a_Help, const AStringMap & a_Labels, cMetric::eType a_Type);
+};
+
+
+
+
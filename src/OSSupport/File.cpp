@@ -383,6 +383,20 @@ bool cFile::Rename(const AString & a_OrigFileName, const AString & a_NewFileName
 
 
 
+bool cFile::Replace(const AString & a_SrcFileName, const AString & a_DstFileName)
+{
+	#ifdef _WIN32
+		return (MoveFileExA(a_SrcFileName.c_str(), a_DstFileName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0);
+	#else
+		// POSIX rename() replaces the destination atomically:
+		return (rename(a_SrcFileName.c_str(), a_DstFileName.c_str()) == 0);
+	#endif
+}
+
+
+
+
+
 bool cFile::Copy(const AString & a_SrcFileName, const AString & a_DstFileName)
 {
 	#ifdef _WIN32
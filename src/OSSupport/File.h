@@ -120,6 +120,10 @@ public:
 	/** Renames a file or folder, returns true if successful. May fail if dest already exists (libc-dependant)! */
 	static bool Rename(const AString & a_OrigPath, const AString & a_NewPath);  // Exported in ManualBindings.cpp
 
+	/** Renames a file over the destination file, replacing it if it exists, returns true if successful.
+	Readers see either the whole old file or the whole new file, never a partially written one. */
+	static bool Replace(const AString & a_SrcFileName, const AString & a_DstFileName);
+
 	/** Copies a file, returns true if successful.
 	Overwrites the dest file if it already exists. */
 	static bool Copy(const AString & a_SrcFileName, const AString & a_DstFileName);  // Exported in ManualBindings.cpp
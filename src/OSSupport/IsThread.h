@@ -36,6 +36,9 @@ public:
 	/** Returns true if the thread calling this function is the thread contained within this object. */
 	bool IsCurrentThread(void) const { return std::this_thread::get_id() == m_Thread.get_id(); }
 
+	/** Returns the OS handle of the thread, valid while the thread is running. Used for sampling the thread's stack. */
+	std::thread::native_handle_type GetNativeHandle(void) { return m_Thread.native_handle(); }
+
 protected:
 
 	/** This function, overloaded by the descendants, is called in the new thread. */
@@ -85,6 +85,10 @@ public:
 		return Send(a_Data.data(), a_Data.size());
 	}
 
+	/** Returns the number of bytes that have been queued by Send() but not yet accepted by the OS for sending.
+	A steadily growing number means that the remote peer doesn't keep up with the data being sent to it. */
+	virtual size_t GetOutgoingQueueSize(void) const = 0;
+
 	/** Returns the IP address of the local endpoint of the connection. */
 	virtual AString GetLocalIP(void) const = 0;
 
@@ -2,7 +2,7 @@
 // NetworkSingleton.cpp
 
 // Implements the cNetworkSingleton class representing the storage for global data pertaining to network API
-// such as a list of all connections, all listening sockets and the LibEvent dispatch thread.
+// such as a list of all connections, all listening sockets and the LibEvent dispatch threads.
 
 #include "Globals.h"
 #include "NetworkSingleton.h"
@@ -15,7 +15,113 @@
 
 
 
+////////////////////////////////////////////////////////////////////////////////
+// cNetworkEventLoop:
+
+cNetworkEventLoop::cNetworkEventLoop(void):
+	m_IsRunning(false)
+{
+	event_config * config = event_config_new();
+	event_config_set_flag(config, EVENT_BASE_FLAG_STARTUP_IOCP);
+	m_EventBase = event_base_new_with_config(config);
+	if (m_EventBase == nullptr)
+	{
+		LOGERROR("Failed to initialize LibEvent. The server will now terminate.");
+		abort();
+	}
+	event_config_free(config);
+}
+
+
+
+
+
+cNetworkEventLoop::~cNetworkEventLoop()
+{
+	ASSERT(!m_Thread.joinable());
+	event_base_free(m_EventBase);
+}
+
+
+
+
+
+void cNetworkEventLoop::Start(void)
+{
+	m_Thread = std::thread(RunEventLoop, this);
+	m_StartupEvent.Wait();  // Wait for the LibEvent loop to actually start running (otherwise calling Terminate too soon would hang, see #3228)
+}
+
+
+
+
+
+void cNetworkEventLoop::Stop(void)
+{
+	event_base_loopbreak(m_EventBase);
+	m_Thread.join();
+}
+
+
+
+
+
+void cNetworkEventLoop::Schedule(std::function<void()> a_Callback)
+{
+	auto Callback = new std::function<void()>(std::move(a_Callback));
+	timeval timeout{};  // Zero timeout - execute as soon as possible
+	if (event_base_once(m_EventBase, -1, EV_TIMEOUT, ScheduledCallback, Callback, &timeout) != 0)
+	{
+		LOGWARNING("%s: Cannot schedule a callback in the network event loop", __FUNCTION__);
+		delete Callback;
+	}
+}
+
+
+
+
+
+void cNetworkEventLoop::RunEventLoop(cNetworkEventLoop * a_Self)
+{
+	auto timer = evtimer_new(a_Self->m_EventBase, SignalizeStartup, a_Self);
+	timeval timeout{};  // Zero timeout - execute immediately
+	evtimer_add(timer, &timeout);
+	event_base_loop(a_Self->m_EventBase, EVLOOP_NO_EXIT_ON_EMPTY);
+	a_Self->m_IsRunning = false;
+	event_free(timer);
+}
+
+
+
+
+
+void cNetworkEventLoop::SignalizeStartup(evutil_socket_t a_Socket, short a_Events, void * a_Self)
+{
+	auto self = static_cast<cNetworkEventLoop *>(a_Self);
+	ASSERT(self != nullptr);
+	self->m_IsRunning = true;
+	self->m_StartupEvent.Set();
+}
+
+
+
+
+
+void cNetworkEventLoop::ScheduledCallback(evutil_socket_t a_Socket, short a_Events, void * a_Callback)
+{
+	std::unique_ptr<std::function<void()>> Callback(static_cast<std::function<void()> *>(a_Callback));
+	(*Callback)();
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cNetworkSingleton:
+
 cNetworkSingleton::cNetworkSingleton() :
+	m_NextEventLoop(0),
 	m_HasTerminated(true)
 {
 }
@@ -44,7 +150,7 @@ cNetworkSingleton & cNetworkSingleton::Get(void)
 
 
 
-void cNetworkSingleton::Initialise(void)
+void cNetworkSingleton::Initialise(unsigned a_NumEventLoops)
 {
 	// Start the lookup thread
 	m_LookupThread.Start();
@@ -74,21 +180,24 @@ void cNetworkSingleton::Initialise(void)
 		#error No threading implemented for EVTHREAD
 	#endif
 
-	// Create the main event_base:
-	event_config * config = event_config_new();
-	event_config_set_flag(config, EVENT_BASE_FLAG_STARTUP_IOCP);
-	m_EventBase = event_base_new_with_config(config);
-	if (m_EventBase == nullptr)
+	// Create the event loops, the first one is the main loop:
+	if (a_NumEventLoops == 0)
 	{
-		LOGERROR("Failed to initialize LibEvent. The server will now terminate.");
-		abort();
+		a_NumEventLoops = std::max(std::thread::hardware_concurrency(), 1U);
+	}
+	for (unsigned i = 0; i < a_NumEventLoops; i++)
+	{
+		m_EventLoops.push_back(std::make_unique<cNetworkEventLoop>());
 	}
-	event_config_free(config);
 
-	// Create the event loop thread:
+	// Start the event loop threads:
 	m_HasTerminated = false;
-	m_EventLoopThread = std::thread(RunEventLoop, this);
-	m_StartupEvent.Wait();  // Wait for the LibEvent loop to actually start running (otherwise calling Terminate too soon would hang, see #3228)
+	m_NextEventLoop = 0;
+	for (auto & EventLoop: m_EventLoops)
+	{
+		EventLoop->Start();
+	}
+	LOGD("Network: running %u event loops", a_NumEventLoops);
 }
 
 
@@ -102,11 +211,15 @@ void cNetworkSingleton::Terminate(void)
 	// Wait for the lookup thread to stop
 	m_LookupThread.Stop();
 
-	// Wait for the LibEvent event loop to terminate:
-	event_base_loopbreak(m_EventBase);
-	m_EventLoopThread.join();
+	// Wait for the LibEvent event loops to terminate:
+	for (auto & EventLoop: m_EventLoops)
+	{
+		EventLoop->Stop();
+		ASSERT(!EventLoop->IsRunning());
+	}
 
-	// Close all open connections:
+	// Close all open connections.
+	// No loop is running anymore, so the links close synchronously in this thread, including the TLS ones:
 	{
 		cCSLock Lock(m_CS);
 		// Must take copies because Close will modify lists
@@ -128,7 +241,7 @@ void cNetworkSingleton::Terminate(void)
 	}
 
 	// Free the underlying LibEvent objects:
-	event_base_free(m_EventBase);
+	m_EventLoops.clear();
 
 	libevent_global_shutdown();
 
@@ -161,24 +274,10 @@ void cNetworkSingleton::LogCallback(int a_Severity, const char * a_Msg)
 
 
 
-void cNetworkSingleton::RunEventLoop(cNetworkSingleton * a_Self)
+cNetworkEventLoop & cNetworkSingleton::GetNextEventLoop(void)
 {
-	auto timer = evtimer_new(a_Self->m_EventBase, SignalizeStartup, a_Self);
-	timeval timeout{};  // Zero timeout - execute immediately
-	evtimer_add(timer, &timeout);
-	event_base_loop(a_Self->m_EventBase, EVLOOP_NO_EXIT_ON_EMPTY);
-	event_free(timer);
-}
-
-
-
-
-
-void cNetworkSingleton::SignalizeStartup(evutil_socket_t a_Socket, short a_Events, void * a_Self)
-{
-	auto self = static_cast<cNetworkSingleton *>(a_Self);
-	ASSERT(self != nullptr);
-	self->m_StartupEvent.Set();
+	ASSERT(!m_EventLoops.empty());
+	return *m_EventLoops[m_NextEventLoop++ % m_EventLoops.size()];
 }
 
 
@@ -2,7 +2,7 @@
 // NetworkSingleton.h
 
 // Declares the cNetworkSingleton class representing the storage for global data pertaining to network API
-// such as a list of all connections, all listening sockets and the LibEvent dispatch thread.
+// such as a list of all connections, all listening sockets and the LibEvent dispatch threads.
 
 // This is an internal header, no-one outside OSSupport should need to include it; use Network.h instead;
 // the only exception being the main app entrypoint that needs to call Terminate before quitting.
@@ -24,6 +24,8 @@
 
 // fwd:
 struct event_base;
+class cNetworkEventLoop;
+typedef std::unique_ptr<cNetworkEventLoop> cNetworkEventLoopPtr;
 class cTCPLink;
 typedef std::shared_ptr<cTCPLink> cTCPLinkPtr;
 typedef std::vector<cTCPLinkPtr> cTCPLinkPtrs;
@@ -35,6 +37,71 @@ typedef std::vector<cServerHandlePtr> cServerHandlePtrs;
 
 
 
+/** A LibEvent event_base together with the thread that runs its dispatch loop.
+All the callbacks of the events registered in the event_base are called in that thread. */
+class cNetworkEventLoop
+{
+public:
+
+	/** Creates the event_base. Aborts the app if LibEvent cannot be initialized. */
+	cNetworkEventLoop(void);
+
+	/** Frees the event_base. The loop must have been stopped already. */
+	~cNetworkEventLoop();
+
+	/** Starts the thread running the dispatch loop, returns once the loop is running. */
+	void Start(void);
+
+	/** Breaks the dispatch loop and waits for the thread to finish. */
+	void Stop(void);
+
+	/** Returns the LibEvent handle for event registering. */
+	event_base * GetEventBase(void) { return m_EventBase; }
+
+	/** Returns true if called from the thread that runs this loop. */
+	bool IsLoopThread(void) const { return (std::this_thread::get_id() == m_Thread.get_id()); }
+
+	/** Returns true if the dispatch loop is running, from its startup until Stop() breaks it. */
+	bool IsRunning(void) const { return m_IsRunning; }
+
+	/** Returns true if the work on the objects of this loop needs to be Schedule()-d into the loop rather than done directly,
+	because the loop is running in another thread. Once the loop has stopped, the work may be done directly from any thread,
+	the scheduled callbacks would never run. */
+	bool NeedsScheduling(void) const { return m_IsRunning && !IsLoopThread(); }
+
+	/** Queues the callback to be called in the thread running this loop.
+	Thread-safe. The callbacks aren't guaranteed to run in the order they were scheduled. */
+	void Schedule(std::function<void()> a_Callback);
+
+protected:
+
+	/** The LibEvent container for driving the event loop. */
+	event_base * m_EventBase;
+
+	/** The thread in which the LibEvent loop runs. */
+	std::thread m_Thread;
+
+	/** Event that is signalled once the startup is finished and the LibEvent loop is running. */
+	cEvent m_StartupEvent;
+
+	/** Set while the dispatch loop is running. */
+	std::atomic<bool> m_IsRunning;
+
+
+	/** Implements the thread that runs LibEvent's event dispatcher loop. */
+	static void RunEventLoop(cNetworkEventLoop * a_Self);
+
+	/** Callback called by LibEvent when the event loop is started. */
+	static void SignalizeStartup(evutil_socket_t a_Socket, short a_Events, void * a_Self);
+
+	/** Callback called by LibEvent for the callbacks queued by Schedule(). */
+	static void ScheduledCallback(evutil_socket_t a_Socket, short a_Events, void * a_Callback);
+};
+
+
+
+
+
 class cNetworkSingleton
 {
 public:
@@ -45,16 +112,26 @@ public:
 	static cNetworkSingleton & Get(void);
 
 	/** Initialises all network-related threads.
+	a_NumEventLoops is the number of the LibEvent loops, each in its own thread, that the TCP links are distributed across.
+	Zero means one loop per CPU core.
 	To be called on first run or after app restart. */
-	void Initialise(void);
+	void Initialise(unsigned a_NumEventLoops = 0);
 
 	/** Terminates all network-related threads.
 	To be used only on app shutdown or restart.
 	MSVC runtime requires that the LibEvent networking be shut down before the main() function is exitted; this is the way to do it. */
 	void Terminate(void);
 
-	/** Returns the main LibEvent handle for event registering. */
-	event_base * GetEventBase(void) { return m_EventBase; }
+	/** Returns the main LibEvent handle for event registering.
+	Used by the listening sockets and UDP endpoints, its loop serves TCP links as well. */
+	event_base * GetEventBase(void) { return m_EventLoops.front()->GetEventBase(); }
+
+	/** Returns the event loop that should serve a new TCP link.
+	The loops are assigned round-robin, so that the links are spread evenly across the threads. */
+	cNetworkEventLoop & GetNextEventLoop(void);
+
+	/** Returns the number of the event loops. */
+	size_t GetNumEventLoops(void) const { return m_EventLoops.size(); }
 
 	/** Returns the thread used to perform hostname and IP lookups */
 	cNetworkLookup & GetLookupThread() { return m_LookupThread; }
@@ -78,8 +155,12 @@ public:
 
 protected:
 
-	/** The main LibEvent container for driving the event loop. */
-	event_base * m_EventBase;
+	/** The LibEvent loops, each running in its own thread.
+	The first one is the main loop, used for listening and UDP as well. */
+	std::vector<cNetworkEventLoopPtr> m_EventLoops;
+
+	/** The index of the event loop to be returned by the next GetNextEventLoop() call, modulo the loop count. */
+	std::atomic<size_t> m_NextEventLoop;
 
 	/** Container for all client connections, including ones with pending-connect. */
 	cTCPLinkPtrs m_Connections;
@@ -93,24 +174,12 @@ protected:
 	/** Set to true if Terminate has been called. */
 	std::atomic<bool> m_HasTerminated;
 
-	/** The thread in which the main LibEvent loop runs. */
-	std::thread m_EventLoopThread;
-
-	/** Event that is signalled once the startup is finished and the LibEvent loop is running. */
-	cEvent m_StartupEvent;
-
 	/** The thread on which hostname and ip address lookup is performed. */
 	cNetworkLookup m_LookupThread;
 
 
 	/** Converts LibEvent-generated log events into log messages in MCS log. */
 	static void LogCallback(int a_Severity, const char * a_Msg);
-
-	/** Implements the thread that runs LibEvent's event dispatcher loop. */
-	static void RunEventLoop(cNetworkSingleton * a_Self);
-
-	/** Callback called by LibEvent when the event loop is started. */
-	static void SignalizeStartup(evutil_socket_t a_Socket, short a_Events, void * a_Self);
 };
 
 
@@ -0,0 +1,399 @@
+
+// SamplingProfiler.cpp
+
+// Implements the cSamplingProfiler class that periodically samples the stacks of selected threads
+
+#include "Globals.h"
+#include "SamplingProfiler.h"
+#include "IsThread.h"
+
+#if defined(_WIN32)
+	#include <DbgHelp.h>
+	#pragma comment(lib, "DbgHelp.lib")
+#elif defined(__GLIBC__)
+	#include <execinfo.h>
+	#include <dlfcn.h>
+	#include <cxxabi.h>
+	#include <pthread.h>
+	#include <signal.h>
+#endif
+
+
+
+
+
+#if defined(_WIN32) && defined(_M_X64)
+
+#define SAMPLING_SUPPORTED
+
+/** Resolves the addresses to the function names using DbgHelp.
+DbgHelp is initialized only for the lifetime of the object, so that it doesn't interfere with WinStackWalker. */
+class cSymbolResolver
+{
+public:
+
+	cSymbolResolver(void):
+		m_IsInitialized(SymInitialize(GetCurrentProcess(), nullptr, TRUE) != FALSE)
+	{
+		SymSetOptions(SymGetOptions() | SYMOPT_UNDNAME);
+	}
+
+	~cSymbolResolver()
+	{
+		if (m_IsInitialized)
+		{
+			SymCleanup(GetCurrentProcess());
+		}
+	}
+
+	AString GetName(void * a_Address)
+	{
+		alignas(SYMBOL_INFO) char Buffer[sizeof(SYMBOL_INFO) + MAX_SYM_NAME];
+		auto Symbol = reinterpret_cast<SYMBOL_INFO *>(Buffer);
+		Symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+		Symbol->MaxNameLen = MAX_SYM_NAME;
+		DWORD64 Displacement;
+		if (m_IsInitialized && SymFromAddr(GetCurrentProcess(), reinterpret_cast<DWORD64>(a_Address), &Displacement, Symbol))
+		{
+			return AString(Symbol->Name, Symbol->NameLen);
+		}
+		return fmt::format(FMT_STRING("{}"), a_Address);
+	}
+
+protected:
+
+	bool m_IsInitialized;
+};
+
+
+
+
+
+bool cSamplingProfiler::CaptureStack(cIsThread & a_Thread, std::vector<void *> & a_Frames)
+{
+	auto Thread = a_Thread.GetNativeHandle();
+	if (SuspendThread(Thread) == static_cast<DWORD>(-1))
+	{
+		return false;
+	}
+	CONTEXT Context = {};
+	Context.ContextFlags = CONTEXT_FULL;
+	if (!GetThreadContext(Thread, &Context))
+	{
+		ResumeThread(Thread);
+		return false;
+	}
+
+	// Unwind the stack using the unwind data in the images. Unlike StackWalk64 and the symbol lookups,
+	// this doesn't allocate memory, so it cannot deadlock on a heap lock held by the suspended thread:
+	while ((Context.Rip != 0) && (a_Frames.size() < MaxFrames))
+	{
+		a_Frames.push_back(reinterpret_cast<void *>(Context.Rip));
+		DWORD64 ImageBase;
+		auto Function = RtlLookupFunctionEntry(Context.Rip, &ImageBase, nullptr);
+		if (Function == nullptr)
+		{
+			// A leaf function, the return address is on the top of the stack:
+			Context.Rip = *reinterpret_cast<DWORD64 *>(Context.Rsp);
+			Context.Rsp += sizeof(DWORD64);
+		}
+		else
+		{
+			PVOID HandlerData;
+			DWORD64 EstablisherFrame;
+			RtlVirtualUnwind(UNW_FLAG_NHANDLER, ImageBase, Context.Rip, Function, &Context, &HandlerData, &EstablisherFrame, nullptr);
+		}
+	}
+	ResumeThread(Thread);
+	return true;
+}
+
+#elif defined(__GLIBC__)
+
+#define SAMPLING_SUPPORTED
+
+/** The number of the innermost frames captured by the signal handler that belong to the handler itself and the signal trampoline. */
+static const int NumSignalFrames = 2;
+
+/** The buffer into which the signal handler captures the stack of the sampled thread. Only one thread is sampled at a time. */
+static void * g_SampleFrames[cSamplingProfiler::MaxFrames + NumSignalFrames];
+
+/** The number of the frames captured into g_SampleFrames, or -1 while the signal handler hasn't run yet. */
+static std::atomic<int> g_NumSampleFrames(0);
+
+
+
+
+
+/** Captures the stack of the thread that has received the signal. */
+static void SampleSignalHandler(int a_Signal)
+{
+	UNUSED(a_Signal);
+	auto SavedErrno = errno;
+	g_NumSampleFrames.store(backtrace(g_SampleFrames, static_cast<int>(ARRAYCOUNT(g_SampleFrames))), std::memory_order_release);
+	errno = SavedErrno;
+}
+
+
+
+
+
+/** Resolves the addresses to the function names using the dynamic linker.
+Only the exported symbols have names; for the others, the module name and the offset within the module
+is returned, suitable for addr2line. */
+class cSymbolResolver
+{
+public:
+
+	AString GetName(void * a_Address)
+	{
+		Dl_info Info;
+		if (dladdr(a_Address, &Info) == 0)
+		{
+			return fmt::format(FMT_STRING("{}"), a_Address);
+		}
+		if (Info.dli_sname != nullptr)
+		{
+			int Status;
+			auto Demangled = abi::__cxa_demangle(Info.dli_sname, nullptr, nullptr, &Status);
+			AString res((Status == 0) ? Demangled : Info.dli_sname);
+			free(Demangled);
+			return res;
+		}
+		AString ModuleName((Info.dli_fname != nullptr) ? Info.dli_fname : "");
+		auto Slash = ModuleName.rfind('/');
+		if (Slash != AString::npos)
+		{
+			ModuleName.erase(0, Slash + 1);
+		}
+		return fmt::format(FMT_STRING("{}+{:#x}"),
+			ModuleName, reinterpret_cast<uintptr_t>(a_Address) - reinterpret_cast<uintptr_t>(Info.dli_fbase)
+		);
+	}
+};
+
+
+
+
+
+bool cSamplingProfiler::CaptureStack(cIsThread & a_Thread, std::vector<void *> & a_Frames)
+{
+	// If the previous signal still hasn't been handled, the buffer is not ours to use yet:
+	int Expected = g_NumSampleFrames.load(std::memory_order_acquire);
+	if ((Expected < 0) || !g_NumSampleFrames.compare_exchange_strong(Expected, -1))
+	{
+		return false;
+	}
+	if (pthread_kill(a_Thread.GetNativeHandle(), SIGPROF) != 0)
+	{
+		g_NumSampleFrames.store(0);
+		return false;
+	}
+
+	// Wait for the handler; a thread in an uninterruptible state may not run it in time:
+	const auto Deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+	int NumFrames;
+	while ((NumFrames = g_NumSampleFrames.load(std::memory_order_acquire)) < 0)
+	{
+		if (std::chrono::steady_clock::now() > Deadline)
+		{
+			return false;
+		}
+		std::this_thread::yield();
+	}
+	for (int i = NumSignalFrames; i < NumFrames; i++)
+	{
+		a_Frames.push_back(g_SampleFrames[i]);
+	}
+	return true;
+}
+
+#else
+
+/** No symbols without the sampling. */
+class cSymbolResolver
+{
+public:
+
+	AString GetName(void * a_Address)
+	{
+		return fmt::format(FMT_STRING("{}"), a_Address);
+	}
+};
+
+
+
+
+
+bool cSamplingProfiler::CaptureStack(cIsThread & a_Thread, std::vector<void *> & a_Frames)
+{
+	UNUSED(a_Thread);
+	UNUSED(a_Frames);
+	return false;
+}
+
+#endif
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cSamplingProfiler:
+
+cSamplingProfiler::cSamplingProfiler(void):
+	m_NumSamples(0),
+	m_NumFailedSamples(0)
+{
+	#if defined(__GLIBC__)
+		// The first backtrace() call loads libgcc, which is not safe inside a signal handler; do it now:
+		void * Frames[1];
+		backtrace(Frames, 1);
+
+		struct sigaction Action = {};
+		Action.sa_handler = &SampleSignalHandler;
+		Action.sa_flags = SA_RESTART;
+		sigemptyset(&Action.sa_mask);
+		sigaction(SIGPROF, &Action, nullptr);
+	#endif
+}
+
+
+
+
+
+bool cSamplingProfiler::IsSupported(void)
+{
+	#ifdef SAMPLING_SUPPORTED
+		return true;
+	#else
+		return false;
+	#endif
+}
+
+
+
+
+
+void cSamplingProfiler::TrackThread(cIsThread & a_Thread, const AString & a_Name)
+{
+	cCSLock Lock(m_CS);
+	m_Threads.push_back({&a_Thread, a_Name});
+}
+
+
+
+
+
+void cSamplingProfiler::UntrackThread(cIsThread & a_Thread)
+{
+	cCSLock Lock(m_CS);
+	m_Threads.erase(
+		std::remove_if(m_Threads.begin(), m_Threads.end(), [&a_Thread](const sThread & a_Tracked)
+			{
+				return (a_Tracked.m_Thread == &a_Thread);
+			}
+		),
+		m_Threads.end()
+	);
+}
+
+
+
+
+
+void cSamplingProfiler::Sample(void)
+{
+	// The lock also keeps the threads from being untracked (and stopped) while they're being sampled:
+	cCSLock Lock(m_CS);
+	std::vector<void *> Frames;
+	Frames.reserve(MaxFrames);
+	for (const auto & Thread: m_Threads)
+	{
+		Frames.clear();
+		if (!CaptureStack(*Thread.m_Thread, Frames) || Frames.empty())
+		{
+			m_NumFailedSamples += 1;
+			continue;
+		}
+		m_Stacks[std::make_pair(Thread.m_Name, Frames)] += 1;
+		m_NumSamples += 1;
+	}
+}
+
+
+
+
+
+AString cSamplingProfiler::GetFoldedStacks(void)
+{
+	decltype(m_Stacks) Stacks;
+	{
+		cCSLock Lock(m_CS);
+		Stacks = m_Stacks;
+	}
+
+	// Resolve each address only once, and merge the stacks that resolve to the same names:
+	cSymbolResolver Resolver;
+	std::unordered_map<void *, AString> Names;
+	std::map<AString, UInt64> Folded;
+	for (const auto & Stack: Stacks)
+	{
+		AString Line(Stack.first.first);
+		const auto & Frames = Stack.first.second;
+		for (auto itr = Frames.rbegin(); itr != Frames.rend(); ++itr)
+		{
+			auto & Name = Names[*itr];
+			if (Name.empty())
+			{
+				Name = Resolver.GetName(*itr);
+			}
+			Line.push_back(';');
+			Line.append(Name);
+		}
+		Folded[Line] += Stack.second;
+	}
+
+	AString res;
+	for (const auto & Line: Folded)
+	{
+		res.append(fmt::format(FMT_STRING("{} {}\n"), Line.first, Line.second));
+	}
+	return res;
+}
+
+
+
+
+
+UInt64 cSamplingProfiler::GetNumSamples(void)
+{
+	cCSLock Lock(m_CS);
+	return m_NumSamples;
+}
+
+
+
+
+
+UInt64 cSamplingProfiler::GetNumFailedSamples(void)
+{
+	cCSLock Lock(m_CS);
+	return m_NumFailedSamples;
+}
+
+
+
+
+
+void cSamplingProfiler::Clear(void)
+{
+	cCSLock Lock(m_CS);
+	m_Stacks.clear();
+	m_NumSamples = 0;
+	m_NumFailedSamples = 0;
+}
+
+
+
+
@@ -0,0 +1,99 @@
+
+// SamplingProfiler.h
+
+// Declares the cSamplingProfiler class that periodically samples the stacks of selected threads
+
+/*
+The sampling is driven by an outside thread (cDeadlockDetect's) calling Sample() periodically. Each call captures
+the current stack of every tracked thread:
+	- On Linux (glibc), the thread is sent a SIGPROF and captures its own stack using backtrace() in the signal handler
+	- On Windows (x64), the thread is suspended and its stack is unwound from the outside using the unwind data
+The stacks are kept as return addresses and only resolved to names when the profile is exported, in the "folded"
+format used by the flame graph tools (https://github.com/brendangregg/FlameGraph): one line per distinct stack, the
+frames from the outermost to the innermost separated by semicolons, followed by the number of samples.
+*/
+
+
+
+
+
+#pragma once
+
+#include "CriticalSection.h"
+
+
+
+
+
+// fwd:
+class cIsThread;
+
+
+
+
+
+class cSamplingProfiler
+{
+public:
+
+	/** The maximum number of frames captured for each stack; the outermost frames of deeper stacks are lost. */
+	static const size_t MaxFrames = 64;
+
+
+	cSamplingProfiler(void);
+
+	/** Returns true if the stack sampling is implemented for this platform. */
+	static bool IsSupported(void);
+
+	/** Adds the thread to be sampled. The thread must be running until it is untracked.
+	a_Name is used as the root frame of the thread's stacks. */
+	void TrackThread(cIsThread & a_Thread, const AString & a_Name);
+
+	/** Removes the thread from the sampling. */
+	void UntrackThread(cIsThread & a_Thread);
+
+	/** Captures the current stack of each tracked thread. */
+	void Sample(void);
+
+	/** Returns the stacks sampled so far in the folded format. */
+	AString GetFoldedStacks(void);
+
+	/** Returns the number of the stacks captured so far. */
+	UInt64 GetNumSamples(void);
+
+	/** Returns the number of the stacks that couldn't be captured, such as when a thread didn't respond in time. */
+	UInt64 GetNumFailedSamples(void);
+
+	/** Removes all the sampled stacks. */
+	void Clear(void);
+
+protected:
+
+	/** A sampled thread. */
+	struct sThread
+	{
+		cIsThread * m_Thread;
+		AString m_Name;
+	};
+
+
+	/** Protects all the members against multithreaded access. */
+	cCriticalSection m_CS;
+
+	std::vector<sThread> m_Threads;
+
+	/** The number of the samples of each distinct stack, indexed by the thread's name and the return addresses, the innermost first. */
+	std::map<std::pair<AString, std::vector<void *>>, UInt64> m_Stacks;
+
+	UInt64 m_NumSamples;
+	UInt64 m_NumFailedSamples;
+
+
+	/** Captures the current stack of the thread into a_Frames, the innermost frame first.
+	Returns false if the stack cannot be captured. */
+	static bool CaptureStack(cIsThread & a_Thread, std::vector<void *> & a_Frames);
+};
+
+
+
+
@@ -19,7 +19,8 @@
 
 cTCPLinkImpl::cTCPLinkImpl(cTCPLink::cCallbacksPtr a_LinkCallbacks):
 	Super(std::move(a_LinkCallbacks)),
-	m_BufferEvent(bufferevent_socket_new(cNetworkSingleton::Get().GetEventBase(), -1, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE | BEV_OPT_DEFER_CALLBACKS | BEV_OPT_UNLOCK_CALLBACKS)),
+	m_EventLoop(cNetworkSingleton::Get().GetNextEventLoop()),
+	m_BufferEvent(bufferevent_socket_new(m_EventLoop.GetEventBase(), -1, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE | BEV_OPT_DEFER_CALLBACKS | BEV_OPT_UNLOCK_CALLBACKS)),
 	m_LocalPort(0),
 	m_RemotePort(0),
 	m_ShouldShutdown(false)
@@ -32,7 +33,8 @@ cTCPLinkImpl::cTCPLinkImpl(cTCPLink::cCallbacksPtr a_LinkCallbacks):
 
 cTCPLinkImpl::cTCPLinkImpl(evutil_socket_t a_Socket, cTCPLink::cCallbacksPtr a_LinkCallbacks, cServerHandleImplPtr a_Server, const sockaddr * a_Address, socklen_t a_AddrLen):
 	Super(std::move(a_LinkCallbacks)),
-	m_BufferEvent(bufferevent_socket_new(cNetworkSingleton::Get().GetEventBase(), a_Socket, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE | BEV_OPT_DEFER_CALLBACKS | BEV_OPT_UNLOCK_CALLBACKS)),
+	m_EventLoop(cNetworkSingleton::Get().GetNextEventLoop()),
+	m_BufferEvent(bufferevent_socket_new(m_EventLoop.GetEventBase(), a_Socket, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE | BEV_OPT_DEFER_CALLBACKS | BEV_OPT_UNLOCK_CALLBACKS)),
 	m_Server(std::move(a_Server)),
 	m_LocalPort(0),
 	m_RemotePort(0),
@@ -169,8 +171,33 @@ bool cTCPLinkImpl::Send(const void * a_Data, size_t a_Length)
 	}
 
 	// If running in TLS mode, push the data into the TLS context instead:
-	if (m_TlsContext != nullptr)
+	if (m_EventLoop.NeedsScheduling())
+	{
+		// The TLS context may only be used in the event loop thread, queue the data for it.
+		// The loop thread resets the context under the same lock, so check for it under the lock, too:
+		cCSLock Lock(m_CSPendingTlsData);
+		if (m_TlsContext != nullptr)
+		{
+			bool ShouldSchedule = m_PendingTlsData.empty();
+			m_PendingTlsData.append(static_cast<const char *>(a_Data), a_Length);
+			if (ShouldSchedule)
+			{
+				m_EventLoop.Schedule([Self = weak_from_this()]()
+					{
+						if (auto Link = Self.lock())
+						{
+							Link->FlushPendingTlsData();
+						}
+					}
+				);
+			}
+			return true;
+		}
+	}
+	else if (m_TlsContext != nullptr)
 	{
+		// Push the data queued by the other threads first, so that the stream stays in order:
+		FlushPendingTlsData();
 		m_TlsContext->Send(a_Data, a_Length);
 		return true;
 	}
@@ -183,14 +210,36 @@ bool cTCPLinkImpl::Send(const void * a_Data, size_t a_Length)
 
 
 
+size_t cTCPLinkImpl::GetOutgoingQueueSize(void) const
+{
+	return evbuffer_get_length(bufferevent_get_output(m_BufferEvent));
+}
+
+
+
+
+
 void cTCPLinkImpl::Shutdown(void)
 {
-	// If running in TLS mode, notify the TLS layer:
+	// The TLS context may only be used in the event loop thread, shut down there:
+	if (m_EventLoop.NeedsScheduling() && HasTlsContext())
+	{
+		m_EventLoop.Schedule([Self = weak_from_this()]()
+			{
+				if (auto Link = Self.lock())
+				{
+					Link->Shutdown();
+				}
+			}
+		);
+		return;
+	}
+
+	// If running in TLS mode, send the data still queued for the TLS layer, then notify it:
 	if (m_TlsContext != nullptr)
 	{
-		m_TlsContext->NotifyClose();
-		m_TlsContext->ResetSelf();
-		m_TlsContext.reset();
+		FlushPendingTlsData();
+		CloseTlsContext();
 	}
 
 	// If there's no outgoing data, shutdown the socket directly:
@@ -210,12 +259,24 @@ void cTCPLinkImpl::Shutdown(void)
 
 void cTCPLinkImpl::Close(void)
 {
+	// The TLS context may only be used in the event loop thread, close there:
+	if (m_EventLoop.NeedsScheduling() && HasTlsContext())
+	{
+		m_EventLoop.Schedule([Self = weak_from_this()]()
+			{
+				if (auto Link = Self.lock())
+				{
+					Link->Close();
+				}
+			}
+		);
+		return;
+	}
+
 	// If running in TLS mode, notify the TLS layer:
 	if (m_TlsContext != nullptr)
 	{
-		m_TlsContext->NotifyClose();
-		m_TlsContext->ResetSelf();
-		m_TlsContext.reset();
+		CloseTlsContext();
 	}
 
 	// Disable all events on the socket, but keep it alive:
@@ -526,6 +587,57 @@ bool cTCPLinkImpl::SendRaw(const void * a_Data, size_t a_Length)
 
 
 
+bool cTCPLinkImpl::HasTlsContext(void)
+{
+	cCSLock Lock(m_CSPendingTlsData);
+	return (m_TlsContext != nullptr);
+}
+
+
+
+
+
+void cTCPLinkImpl::CloseTlsContext(void)
+{
+	ASSERT(!m_EventLoop.NeedsScheduling());
+
+	m_TlsContext->NotifyClose();
+	m_TlsContext->ResetSelf();
+
+	cCSLock Lock(m_CSPendingTlsData);
+	m_TlsContext.reset();
+}
+
+
+
+
+
+void cTCPLinkImpl::FlushPendingTlsData(void)
+{
+	ASSERT(!m_EventLoop.NeedsScheduling());
+
+	AString Data;
+	{
+		cCSLock Lock(m_CSPendingTlsData);
+		if (m_PendingTlsData.empty())
+		{
+			return;
+		}
+		std::swap(Data, m_PendingTlsData);
+	}
+
+	// The link may have been closed since the data was queued:
+	auto tlsContext = m_TlsContext;
+	if (tlsContext != nullptr)
+	{
+		tlsContext->Send(Data.data(), Data.size());
+	}
+}
+
+
+
+
+
 void cTCPLinkImpl::ReceivedCleartextData(const char * a_Data, size_t a_Length)
 {
 	ASSERT(m_Callbacks != nullptr);
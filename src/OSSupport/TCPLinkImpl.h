@@ -15,12 +15,14 @@
 #include <event2/event.h>
 #include <event2/bufferevent.h>
 #include "../mbedTLS++/SslContext.h"
+#include "CriticalSection.h"
 
 
 
 
 
 // fwd:
+class cNetworkEventLoop;
 class cServerHandleImpl;
 typedef std::shared_ptr<cServerHandleImpl> cServerHandleImplPtr;
 class cTCPLinkImpl;
@@ -32,7 +34,8 @@ typedef std::vector<cTCPLinkImplPtr> cTCPLinkImplPtrs;
 
 
 class cTCPLinkImpl:
-	public cTCPLink
+	public cTCPLink,
+	public std::enable_shared_from_this<cTCPLinkImpl>
 {
 	using Super = cTCPLink;
 
@@ -60,6 +63,7 @@ public:
 
 	// cTCPLink overrides:
 	virtual bool Send(const void * a_Data, size_t a_Length) override;
+	virtual size_t GetOutgoingQueueSize(void) const override;
 	virtual AString GetLocalIP(void) const override { return m_LocalIP; }
 	virtual UInt16 GetLocalPort(void) const override { return m_LocalPort; }
 	virtual AString GetRemoteIP(void) const override { return m_RemoteIP; }
@@ -137,6 +141,9 @@ protected:
 	May be NULL if not used. Only used for outgoing connections (cNetwork::Connect()). */
 	cNetwork::cConnectCallbacksPtr m_ConnectCallbacks;
 
+	/** The event loop serving this link; all the LibEvent callbacks of the link are called in its thread. */
+	cNetworkEventLoop & m_EventLoop;
+
 	/** The LibEvent handle representing this connection. */
 	bufferevent * m_BufferEvent;
 
@@ -169,6 +176,14 @@ protected:
 	If valid, the link uses encryption through this context. */
 	cLinkTlsContextPtr m_TlsContext;
 
+	/** Protects m_PendingTlsData, and m_TlsContext against being reset while another thread than the event loop's checks it. */
+	cCriticalSection m_CSPendingTlsData;
+
+	/** The cleartext data sent from other threads than the event loop's, waiting to be pushed into the TLS context by the event loop thread.
+	The TLS context is not thread-safe, so only the event loop thread may use it.
+	Protected by m_CSPendingTlsData. */
+	AString m_PendingTlsData;
+
 
 	/** Creates a new link to be queued to connect to a specified host:port.
 	Used for outgoing connections created using cNetwork::Connect().
@@ -201,6 +216,17 @@ protected:
 	/** Sends the data directly to the socket (without the optional TLS). */
 	bool SendRaw(const void * a_Data, size_t a_Length);
 
+	/** Pushes the data queued in m_PendingTlsData into the TLS context.
+	Called in the event loop thread. */
+	void FlushPendingTlsData(void);
+
+	/** Returns true if the link uses TLS. Safe to call from any thread. */
+	bool HasTlsContext(void);
+
+	/** Notifies the TLS layer of the link closing and releases the TLS context.
+	Called in the event loop thread; Shutdown() and Close() called from other threads are scheduled there when the link uses TLS. */
+	void CloseTlsContext(void);
+
 	/** Called by the TLS when it has decoded a piece of incoming cleartext data from the socket. */
 	void ReceivedCleartextData(const char * a_Data, size_t a_Length);
 };
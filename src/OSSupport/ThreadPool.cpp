@@ -0,0 +1,143 @@
+
+// ThreadPool.cpp
+
+// Implements the cThreadPool class representing a fixed set of worker threads that run batches of CPU-bound tasks
+
+#include "Globals.h"
+#include "ThreadPool.h"
+
+
+
+
+
+cThreadPool::cThreadPool(size_t a_NumWorkers):
+	m_ShouldTerminate(false)
+{
+	m_Workers.reserve(a_NumWorkers);
+	for (size_t i = 0; i < a_NumWorkers; i++)
+	{
+		m_Workers.emplace_back(&cThreadPool::Execute, this);
+	}
+}
+
+
+
+
+
+cThreadPool::~cThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> Lock(m_CS);
+		m_ShouldTerminate = true;
+	}
+	m_HasWork.notify_all();
+	for (auto & Worker : m_Workers)
+	{
+		Worker.join();
+	}
+}
+
+
+
+
+
+cThreadPool & cThreadPool::Get(void)
+{
+	static cThreadPool Pool(std::max(std::thread::hardware_concurrency(), 1U) - 1);
+	return Pool;
+}
+
+
+
+
+
+void cThreadPool::RunAll(const std::vector<cTask> & a_Tasks)
+{
+	if (a_Tasks.empty())
+	{
+		return;
+	}
+	if (m_Workers.empty() || (a_Tasks.size() == 1))
+	{
+		for (const auto & Task : a_Tasks)
+		{
+			Task();
+		}
+		return;
+	}
+
+	sBatch Batch(a_Tasks);
+	std::unique_lock<std::mutex> Lock(m_CS);
+	m_Batches.push_back(&Batch);
+	m_HasWork.notify_all();
+
+	// Run the tasks that no worker has taken yet:
+	size_t Index;
+	while (TakeNextTask(Batch, Index))
+	{
+		RunTask(Lock, Batch, Index);
+	}
+
+	// Wait for the tasks taken by the workers:
+	Batch.m_Finished.wait(Lock, [&Batch]() { return (Batch.m_NumFinished == Batch.m_Tasks.size()); });
+}
+
+
+
+
+
+void cThreadPool::Execute(void)
+{
+	std::unique_lock<std::mutex> Lock(m_CS);
+	for (;;)
+	{
+		m_HasWork.wait(Lock, [this]() { return (m_ShouldTerminate || !m_Batches.empty()); });
+		if (m_ShouldTerminate)
+		{
+			return;
+		}
+
+		// A queued batch always has a task not yet taken, and it stays alive until that task finishes:
+		auto & Batch = *m_Batches.front();
+		size_t Index;
+		VERIFY(TakeNextTask(Batch, Index));
+		RunTask(Lock, Batch, Index);
+	}
+}
+
+
+
+
+
+bool cThreadPool::TakeNextTask(sBatch & a_Batch, size_t & a_Index)
+{
+	if (a_Batch.m_NextTask >= a_Batch.m_Tasks.size())
+	{
+		return false;
+	}
+
+	a_Index = a_Batch.m_NextTask++;
+	if (a_Batch.m_NextTask == a_Batch.m_Tasks.size())
+	{
+		// No other thread needs to see the batch anymore:
+		m_Batches.erase(std::find(m_Batches.begin(), m_Batches.end(), &a_Batch));
+	}
+	return true;
+}
+
+
+
+
+
+void cThreadPool::RunTask(std::unique_lock<std::mutex> & a_Lock, sBatch & a_Batch, size_t a_Index)
+{
+	a_Lock.unlock();
+	a_Batch.m_Tasks[a_Index]();
+	a_Lock.lock();
+
+	a_Batch.m_NumFinished += 1;
+	if (a_Batch.m_NumFinished == a_Batch.m_Tasks.size())
+	{
+		a_Batch.m_Finished.notify_all();
+	}
+}
@@ -0,0 +1,104 @@
+
+// ThreadPool.h
+
+// Declares the cThreadPool class representing a fixed set of worker threads that run batches of CPU-bound tasks
+
+/*
+Usage:
+Split the work into independent tasks and pass them to RunAll(), which returns once all of them have finished:
+	std::vector<std::function<void()>> Tasks;
+	...
+	cThreadPool::Get().RunAll(Tasks);
+The calling thread runs the tasks, too, so RunAll() may be called from within a task without a deadlock, and
+a pool without any workers (on a single-core machine) simply runs the tasks serially.
+The tasks must not throw.
+*/
+
+
+
+
+
+#pragma once
+
+#include <functional>
+
+
+
+
+
+class cThreadPool
+{
+public:
+
+	using cTask = std::function<void()>;
+
+
+	/** Creates a pool with the specified number of worker threads. */
+	explicit cThreadPool(size_t a_NumWorkers);
+
+	/** Waits for the workers to finish their current task and stops them. */
+	~cThreadPool();
+
+	cThreadPool(const cThreadPool &) = delete;
+	cThreadPool & operator = (const cThreadPool &) = delete;
+
+	/** Returns the pool shared by the whole server, created on first use.
+	It has one worker less than there are hardware threads, since the thread calling RunAll() works, too. */
+	static cThreadPool & Get(void);
+
+	/** Runs all the tasks, on the workers and on the calling thread, and returns once all of them have finished. */
+	void RunAll(const std::vector<cTask> & a_Tasks);
+
+	/** Returns the number of the threads that may run a batch's tasks at once, including the calling thread. */
+	size_t GetConcurrency(void) const { return m_Workers.size() + 1; }
+
+protected:
+
+	/** The tasks of a single RunAll() call. */
+	struct sBatch
+	{
+		sBatch(const std::vector<cTask> & a_Tasks):
+			m_Tasks(a_Tasks),
+			m_NextTask(0),
+			m_NumFinished(0)
+		{
+		}
+
+		const std::vector<cTask> & m_Tasks;
+
+		/** The index of the next task that hasn't been taken by any thread yet. */
+		size_t m_NextTask;
+
+		/** The number of the finished tasks. */
+		size_t m_NumFinished;
+
+		/** Signalled when the last task finishes. */
+		std::condition_variable m_Finished;
+	};
+
+
+	/** Protects m_Batches, m_ShouldTerminate and the counters in the batches. */
+	std::mutex m_CS;
+
+	/** Signalled when a new batch is queued, or when the workers should terminate. */
+	std::condition_variable m_HasWork;
+
+	/** The batches that still have tasks not taken by any thread, in the order in which they were queued. */
+	std::deque<sBatch *> m_Batches;
+
+	bool m_ShouldTerminate;
+
+	std::vector<std::thread> m_Workers;
+
+
+	/** The worker threads' main loop. */
+	void Execute(void);
+
+	/** Takes the next task of the batch that no thread has taken yet, and dequeues the batch if it was its last task.
+	Returns false if all the batch's tasks have already been taken. Must be called with m_CS locked. */
+	bool TakeNextTask(sBatch & a_Batch, size_t & a_Index);
+
+	/** Runs the specified task of the batch, which the calling thread has taken, and counts it as finished.
+	Must be called with m_CS locked, unlocks it while the task runs. */
+	void RunTask(std::unique_lock<std::mutex> & a_Lock, sBatch & a_Batch, size_t a_Index);
+};
@@ -0,0 +1,419 @@
+
+// PackedBlockArea.cpp
+
+// Implements the cPackedBlockArea class that stores the blocktypes and blockmetas of an area in a compact, paletted form
+
+#include "Globals.h"
+#include "PackedBlockArea.h"
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cPackedBlockArea::sSection:
+
+size_t cPackedBlockArea::sSection::GetPaletteIndex(size_t a_Index) const
+{
+	if (m_BitsPerBlock == 0)
+	{
+		return 0;
+	}
+	auto Word = m_Data[a_Index / m_BlocksPerWord];
+	auto Shift = (a_Index % m_BlocksPerWord) * m_BitsPerBlock;
+	return static_cast<size_t>((Word >> Shift) & ((UInt64{1} << m_BitsPerBlock) - 1));
+}
+
+
+
+
+
+void cPackedBlockArea::sSection::SetPaletteIndex(size_t a_Index, size_t a_PaletteIndex)
+{
+	ASSERT(a_PaletteIndex < (size_t{1} << m_BitsPerBlock));
+	if (m_BitsPerBlock == 0)
+	{
+		return;
+	}
+	auto & Word = m_Data[a_Index / m_BlocksPerWord];
+	auto Shift = (a_Index % m_BlocksPerWord) * m_BitsPerBlock;
+	auto Mask = ((UInt64{1} << m_BitsPerBlock) - 1) << Shift;
+	Word = (Word & ~Mask) | (static_cast<UInt64>(a_PaletteIndex) << Shift);
+}
+
+
+
+
+
+void cPackedBlockArea::sSection::Repack(unsigned a_NewBitsPerBlock)
+{
+	ASSERT(m_Palette.size() <= (size_t{1} << a_NewBitsPerBlock));
+
+	auto NumBlocks = static_cast<size_t>(m_Size.x * m_Size.y * m_Size.z);
+	std::vector<size_t> Indices(NumBlocks);
+	for (size_t i = 0; i < NumBlocks; i++)
+	{
+		Indices[i] = GetPaletteIndex(i);
+	}
+
+	m_BitsPerBlock = a_NewBitsPerBlock;
+	if (m_BitsPerBlock == 0)
+	{
+		m_BlocksPerWord = 0;
+		m_Data.clear();
+		m_Data.shrink_to_fit();
+		return;
+	}
+	m_BlocksPerWord = 64 / m_BitsPerBlock;
+	m_Data.assign((NumBlocks + m_BlocksPerWord - 1) / m_BlocksPerWord, 0);
+	for (size_t i = 0; i < NumBlocks; i++)
+	{
+		SetPaletteIndex(i, Indices[i]);
+	}
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cPackedBlockArea:
+
+cPackedBlockArea::cPackedBlockArea(void) :
+	m_Size(0, 0, 0),
+	m_NumSections(0, 0, 0)
+{
+}
+
+
+
+
+
+void cPackedBlockArea::Pack(const cBlockArea & a_Src)
+{
+	ASSERT(a_Src.HasBlockTypes());
+	m_Size = a_Src.GetSize();
+	m_NumSections.Set(
+		(m_Size.x + SECTION_SIZE - 1) / SECTION_SIZE,
+		(m_Size.y + SECTION_SIZE - 1) / SECTION_SIZE,
+		(m_Size.z + SECTION_SIZE - 1) / SECTION_SIZE
+	);
+	m_Sections.clear();
+	m_Sections.resize(static_cast<size_t>(m_NumSections.x * m_NumSections.y * m_NumSections.z));
+
+	const BLOCKTYPE * SrcTypes = a_Src.GetBlockTypes();
+	const NIBBLETYPE * SrcMetas = a_Src.GetBlockMetas();  // May be nullptr
+
+	// Maps each block value onto its index in the current section's palette, -1 if not in the palette:
+	std::vector<int> PaletteMap(256 * 16, -1);
+	std::vector<size_t> Indices;
+	auto Section = m_Sections.begin();
+	for (int sy = 0; sy < m_NumSections.y; sy++) for (int sz = 0; sz < m_NumSections.z; sz++) for (int sx = 0; sx < m_NumSections.x; sx++)
+	{
+		Vector3i Origin(sx * SECTION_SIZE, sy * SECTION_SIZE, sz * SECTION_SIZE);
+		Section->m_Size.Set(
+			std::min(SECTION_SIZE, m_Size.x - Origin.x),
+			std::min(SECTION_SIZE, m_Size.y - Origin.y),
+			std::min(SECTION_SIZE, m_Size.z - Origin.z)
+		);
+
+		// Build the palette and the unpacked indices:
+		Indices.clear();
+		for (int y = 0; y < Section->m_Size.y; y++) for (int z = 0; z < Section->m_Size.z; z++)
+		{
+			auto SrcIdx = a_Src.MakeIndex(Origin.x, Origin.y + y, Origin.z + z);
+			for (int x = 0; x < Section->m_Size.x; x++, SrcIdx++)
+			{
+				auto Value = static_cast<BlockValue>((SrcTypes[SrcIdx] << 4) | ((SrcMetas == nullptr) ? 0 : (SrcMetas[SrcIdx] & 0x0f)));
+				if (PaletteMap[Value] < 0)
+				{
+					PaletteMap[Value] = static_cast<int>(Section->m_Palette.size());
+					Section->m_Palette.push_back(Value);
+				}
+				Indices.push_back(static_cast<size_t>(PaletteMap[Value]));
+			}
+		}
+
+		// Pack the indices:
+		Section->m_BitsPerBlock = BitsForPaletteSize(Section->m_Palette.size());
+		if (Section->m_BitsPerBlock > 0)
+		{
+			Section->m_BlocksPerWord = 64 / Section->m_BitsPerBlock;
+			Section->m_Data.assign((Indices.size() + Section->m_BlocksPerWord - 1) / Section->m_BlocksPerWord, 0);
+			for (size_t i = 0; i < Indices.size(); i++)
+			{
+				Section->SetPaletteIndex(i, Indices[i]);
+			}
+		}
+		else
+		{
+			Section->m_BlocksPerWord = 0;
+		}
+		Section->m_Palette.shrink_to_fit();
+
+		// Reset the map for the next section:
+		for (auto Value: Section->m_Palette)
+		{
+			PaletteMap[Value] = -1;
+		}
+		++Section;
+	}
+}
+
+
+
+
+
+void cPackedBlockArea::Unpack(cBlockArea & a_Dst) const
+{
+	if ((m_Size.x <= 0) || (m_Size.y <= 0) || (m_Size.z <= 0))
+	{
+		a_Dst.Clear();
+		return;
+	}
+	Unpack(a_Dst, cCuboid({0, 0, 0}, m_Size - Vector3i(1, 1, 1)));
+}
+
+
+
+
+
+bool cPackedBlockArea::Unpack(cBlockArea & a_Dst, cCuboid a_RelArea) const
+{
+	// Crop the requested area to the size of this area:
+	a_RelArea.Sort();
+	a_RelArea.p1.Set(std::max(a_RelArea.p1.x, 0), std::max(a_RelArea.p1.y, 0), std::max(a_RelArea.p1.z, 0));
+	a_RelArea.p2.Set(std::min(a_RelArea.p2.x, m_Size.x - 1), std::min(a_RelArea.p2.y, m_Size.y - 1), std::min(a_RelArea.p2.z, m_Size.z - 1));
+	if ((a_RelArea.p1.x > a_RelArea.p2.x) || (a_RelArea.p1.y > a_RelArea.p2.y) || (a_RelArea.p1.z > a_RelArea.p2.z))
+	{
+		return false;
+	}
+
+	Vector3i DstSize(a_RelArea.DifX() + 1, a_RelArea.DifY() + 1, a_RelArea.DifZ() + 1);
+	a_Dst.Create(DstSize, cBlockArea::baTypes | cBlockArea::baMetas);
+
+	// Decompress only the sections intersecting the area:
+	for (int sy = a_RelArea.p1.y / SECTION_SIZE; sy <= a_RelArea.p2.y / SECTION_SIZE; sy++)
+	{
+		for (int sz = a_RelArea.p1.z / SECTION_SIZE; sz <= a_RelArea.p2.z / SECTION_SIZE; sz++)
+		{
+			for (int sx = a_RelArea.p1.x / SECTION_SIZE; sx <= a_RelArea.p2.x / SECTION_SIZE; sx++)
+			{
+				const auto & Section = m_Sections[static_cast<size_t>(sx + sz * m_NumSections.x + sy * m_NumSections.x * m_NumSections.z)];
+				UnpackSection(
+					Section, {sx * SECTION_SIZE, sy * SECTION_SIZE, sz * SECTION_SIZE}, a_RelArea,
+					a_Dst.GetBlockTypes(), a_Dst.GetBlockMetas(), a_RelArea.p1, DstSize
+				);
+			}
+		}
+	}
+	return true;
+}
+
+
+
+
+
+void cPackedBlockArea::Clear(void)
+{
+	m_Size.Set(0, 0, 0);
+	m_NumSections.Set(0, 0, 0);
+	m_Sections.clear();
+	m_Sections.shrink_to_fit();
+}
+
+
+
+
+
+bool cPackedBlockArea::IsValidRelCoords(int a_RelX, int a_RelY, int a_RelZ) const
+{
+	return (
+		(a_RelX >= 0) && (a_RelX < m_Size.x) &&
+		(a_RelY >= 0) && (a_RelY < m_Size.y) &&
+		(a_RelZ >= 0) && (a_RelZ < m_Size.z)
+	);
+}
+
+
+
+
+
+BLOCKTYPE cPackedBlockArea::GetRelBlockType(int a_RelX, int a_RelY, int a_RelZ) const
+{
+	return static_cast<BLOCKTYPE>(GetBlockValue(a_RelX, a_RelY, a_RelZ) >> 4);
+}
+
+
+
+
+
+NIBBLETYPE cPackedBlockArea::GetRelBlockMeta(int a_RelX, int a_RelY, int a_RelZ) const
+{
+	return static_cast<NIBBLETYPE>(GetBlockValue(a_RelX, a_RelY, a_RelZ) & 0x0f);
+}
+
+
+
+
+
+void cPackedBlockArea::GetRelBlockTypeMeta(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta) const
+{
+	auto Value = GetBlockValue(a_RelX, a_RelY, a_RelZ);
+	a_BlockType = static_cast<BLOCKTYPE>(Value >> 4);
+	a_BlockMeta = static_cast<NIBBLETYPE>(Value & 0x0f);
+}
+
+
+
+
+
+void cPackedBlockArea::SetRelBlockType(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType)
+{
+	SetRelBlockTypeMeta(a_RelX, a_RelY, a_RelZ, a_BlockType, GetRelBlockMeta(a_RelX, a_RelY, a_RelZ));
+}
+
+
+
+
+
+void cPackedBlockArea::SetRelBlockMeta(int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_BlockMeta)
+{
+	SetRelBlockTypeMeta(a_RelX, a_RelY, a_RelZ, GetRelBlockType(a_RelX, a_RelY, a_RelZ), a_BlockMeta);
+}
+
+
+
+
+
+void cPackedBlockArea::SetRelBlockTypeMeta(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta)
+{
+	SetBlockValue(a_RelX, a_RelY, a_RelZ, static_cast<BlockValue>((a_BlockType << 4) | (a_BlockMeta & 0x0f)));
+}
+
+
+
+
+
+size_t cPackedBlockArea::GetMemoryUsage(void) const
+{
+	size_t Res = sizeof(*this) + m_Sections.capacity() * sizeof(sSection);
+	for (const auto & Section: m_Sections)
+	{
+		Res += Section.m_Palette.capacity() * sizeof(BlockValue) + Section.m_Data.capacity() * sizeof(UInt64);
+	}
+	return Res;
+}
+
+
+
+
+
+unsigned cPackedBlockArea::BitsForPaletteSize(size_t a_PaletteSize)
+{
+	unsigned Bits = 0;
+	while ((size_t{1} << Bits) < a_PaletteSize)
+	{
+		Bits += 1;
+	}
+	return Bits;
+}
+
+
+
+
+
+const cPackedBlockArea::sSection & cPackedBlockArea::GetSection(int a_RelX, int a_RelY, int a_RelZ, size_t & a_Index) const
+{
+	ASSERT(IsValidRelCoords(a_RelX, a_RelY, a_RelZ));
+	const auto & Section = m_Sections[static_cast<size_t>(
+		a_RelX / SECTION_SIZE +
+		(a_RelZ / SECTION_SIZE) * m_NumSections.x +
+		(a_RelY / SECTION_SIZE) * m_NumSections.x * m_NumSections.z
+	)];
+	int X = a_RelX % SECTION_SIZE;
+	int Y = a_RelY % SECTION_SIZE;
+	int Z = a_RelZ % SECTION_SIZE;
+	a_Index = static_cast<size_t>(X + Z * Section.m_Size.x + Y * Section.m_Size.x * Section.m_Size.z);
+	return Section;
+}
+
+
+
+
+
+cPackedBlockArea::sSection & cPackedBlockArea::GetSection(int a_RelX, int a_RelY, int a_RelZ, size_t & a_Index)
+{
+	return const_cast<sSection &>(static_cast<const cPackedBlockArea *>(this)->GetSection(a_RelX, a_RelY, a_RelZ, a_Index));
+}
+
+
+
+
+
+cPackedBlockArea::BlockValue cPackedBlockArea::GetBlockValue(int a_RelX, int a_RelY, int a_RelZ) const
+{
+	size_t Index;
+	const auto & Section = GetSection(a_RelX, a_RelY, a_RelZ, Index);
+	return Section.m_Palette[Section.GetPaletteIndex(Index)];
+}
+
+
+
+
+
+void cPackedBlockArea::SetBlockValue(int a_RelX, int a_RelY, int a_RelZ, BlockValue a_Value)
+{
+	size_t Index;
+	auto & Section = GetSection(a_RelX, a_RelY, a_RelZ, Index);
+	auto itr = std::find(Section.m_Palette.begin(), Section.m_Palette.end(), a_Value);
+	auto PaletteIndex = static_cast<size_t>(itr - Section.m_Palette.begin());
+	if (itr == Section.m_Palette.end())
+	{
+		// A new value for this section, add it to the palette and make room for its index:
+		Section.m_Palette.push_back(a_Value);
+		auto NewBitsPerBlock = BitsForPaletteSize(Section.m_Palette.size());
+		if (NewBitsPerBlock != Section.m_BitsPerBlock)
+		{
+			Section.Repack(NewBitsPerBlock);
+		}
+	}
+	Section.SetPaletteIndex(Index, PaletteIndex);
+}
+
+
+
+
+
+void cPackedBlockArea::UnpackSection(
+	const sSection & a_Section, Vector3i a_SectionOrigin, const cCuboid & a_RelArea,
+	BLOCKTYPE * a_DstTypes, NIBBLETYPE * a_DstMetas, Vector3i a_DstOrigin, Vector3i a_DstSize
+) const
+{
+	// The part of the section within a_RelArea, in coords relative to the section:
+	Vector3i Min(
+		std::max(a_RelArea.p1.x - a_SectionOrigin.x, 0),
+		std::max(a_RelArea.p1.y - a_SectionOrigin.y, 0),
+		std::max(a_RelArea.p1.z - a_SectionOrigin.z, 0)
+	);
+	Vector3i Max(
+		std::min(a_RelArea.p2.x - a_SectionOrigin.x, a_Section.m_Size.x - 1),
+		std::min(a_RelArea.p2.y - a_SectionOrigin.y, a_Section.m_Size.y - 1),
+		std::min(a_RelArea.p2.z - a_SectionOrigin.z, a_Section.m_Size.z - 1)
+	);
+
+	for (int y = Min.y; y <= Max.y; y++)
+	{
+		for (int z = Min.z; z <= Max.z; z++)
+		{
+			auto SrcIdx = static_cast<size_t>(Min.x + z * a_Section.m_Size.x + y * a_Section.m_Size.x * a_Section.m_Size.z);
+			auto DstIdx = cBlockArea::MakeIndexForSize(a_SectionOrigin + Vector3i(Min.x, y, z) - a_DstOrigin, a_DstSize);
+			for (int x = Min.x; x <= Max.x; x++, SrcIdx++, DstIdx++)
+			{
+				auto Value = a_Section.m_Palette[a_Section.GetPaletteIndex(SrcIdx)];
+				a_DstTypes[DstIdx] = static_cast<BLOCKTYPE>(Value >> 4);
+				a_DstMetas[DstIdx] = static_cast<NIBBLETYPE>(Value & 0x0f);
+			}
+		}
+	}
+}
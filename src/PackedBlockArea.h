@@ -0,0 +1,141 @@
+
+// PackedBlockArea.h
+
+// Declares the cPackedBlockArea class that stores the blocktypes and blockmetas of an area in a compact, paletted form
+
+
+
+
+
+#pragma once
+
+#include "BlockArea.h"
+
+
+
+
+
+/** Stores the blocktypes and blockmetas of an area, bit-packed through per-section palettes.
+The area is split into sections of up to SECTION_SIZE ^ 3 blocks (clipped to the area's size at its edges).
+Each section has a palette of the block type + meta combinations used in it, and stores, for each block, its index into the palette,
+using as few bits as the palette size allows. A section containing a single block (such as air) stores no indices at all.
+This uses a fraction of the memory of a cBlockArea when the area is made of a handful of blocks, as is usual for prefabs and schematics.
+Individual blocks can be read and written directly; bulk Unpack() calls only decompress the sections they touch.
+The object provides no thread safety, the users need to handle locking if the object is written to. */
+class cPackedBlockArea
+{
+public:
+
+	/** The size of the cubic sections in which the blocks are packed. */
+	static const int SECTION_SIZE = 16;
+
+
+	cPackedBlockArea(void);
+
+	/** Replaces the contents with the blocktypes and blockmetas of a_Src.
+	Any other datatypes in a_Src are ignored; if a_Src has no blockmetas, all the metas are zero. */
+	void Pack(const cBlockArea & a_Src);
+
+	/** Unpacks the entire area into a_Dst, which is re-created with blocktypes and blockmetas. */
+	void Unpack(cBlockArea & a_Dst) const;
+
+	/** Unpacks the blocks within a_RelArea (relative coords, inclusive, cropped to the area's size) into a_Dst,
+	which is re-created with blocktypes and blockmetas and the size of the cropped a_RelArea.
+	Only the sections intersecting a_RelArea are decompressed.
+	Returns false and leaves a_Dst untouched if a_RelArea doesn't intersect the area. */
+	bool Unpack(cBlockArea & a_Dst, cCuboid a_RelArea) const;
+
+	/** Removes all the blocks, the area becomes zero-sized. */
+	void Clear(void);
+
+	const Vector3i & GetSize(void) const { return m_Size; }
+	int GetSizeX(void) const { return m_Size.x; }
+	int GetSizeY(void) const { return m_Size.y; }
+	int GetSizeZ(void) const { return m_Size.z; }
+
+	/** Returns true if the specified relative coords are within this area's coord range (0 - size). */
+	bool IsValidRelCoords(int a_RelX, int a_RelY, int a_RelZ) const;
+
+	// Block accessors, using the same relative coords as the cBlockArea ones:
+	BLOCKTYPE  GetRelBlockType(int a_RelX, int a_RelY, int a_RelZ) const;
+	NIBBLETYPE GetRelBlockMeta(int a_RelX, int a_RelY, int a_RelZ) const;
+	void GetRelBlockTypeMeta(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta) const;
+	void SetRelBlockType(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType);
+	void SetRelBlockMeta(int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_BlockMeta);
+	void SetRelBlockTypeMeta(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta);
+
+	/** Returns the number of bytes of memory used by the packed blocks, including this object itself. */
+	size_t GetMemoryUsage(void) const;
+
+
+protected:
+
+	/** The combination of a block type and meta, as stored in the palettes: (BlockType << 4) | BlockMeta. */
+	using BlockValue = UInt16;
+
+	/** A single section of the area. */
+	struct sSection
+	{
+		/** The size of the section, SECTION_SIZE in all coords except for the sections clipped by the area's edge. */
+		Vector3i m_Size;
+
+		/** The block values used in the section. Never empty. */
+		std::vector<BlockValue> m_Palette;
+
+		/** The palette index of each block, in the same XZY order as cBlockArea, packed m_BitsPerBlock bits per block.
+		Blocks never straddle two words, the unused top bits of each word are zero.
+		Empty when the palette has a single item. */
+		std::vector<UInt64> m_Data;
+
+		/** The number of bits used for each palette index, 0 when the palette has a single item. */
+		unsigned m_BitsPerBlock;
+
+		/** The number of palette indices packed in each word of m_Data. */
+		unsigned m_BlocksPerWord;
+
+
+		/** Returns the palette index of the block at the specified index within the section. */
+		size_t GetPaletteIndex(size_t a_Index) const;
+
+		/** Sets the palette index of the block at the specified index within the section. */
+		void SetPaletteIndex(size_t a_Index, size_t a_PaletteIndex);
+
+		/** Re-packs the data of the section for the specified bits per block, which must fit the palette. */
+		void Repack(unsigned a_NewBitsPerBlock);
+	};
+
+
+	/** The size of the area. */
+	Vector3i m_Size;
+
+	/** The number of sections in each axis. */
+	Vector3i m_NumSections;
+
+	/** The sections, in the XZY order, same as the blocks. */
+	std::vector<sSection> m_Sections;
+
+
+	/** Returns the number of bits needed for indexing a palette of the specified size. */
+	static unsigned BitsForPaletteSize(size_t a_PaletteSize);
+
+	/** Returns the section containing the specified block, and sets a_Index to the block's index within the section. */
+	const sSection & GetSection(int a_RelX, int a_RelY, int a_RelZ, size_t & a_Index) const;
+	sSection & GetSection(int a_RelX, int a_RelY, int a_RelZ, size_t & a_Index);
+
+	/** Returns the packed value of the block at the specified coords. */
+	BlockValue GetBlockValue(int a_RelX, int a_RelY, int a_RelZ) const;
+
+	/** Sets the packed value of the block at the specified coords, extending the section's palette if needed. */
+	void SetBlockValue(int a_RelX, int a_RelY, int a_RelZ, BlockValue a_Value);
+
+	/** Decompresses the part of the section that is within a_RelArea (relative to the whole area, clamped to the section)
+	into a_DstTypes / a_DstMetas, which have the size a_DstSize and start at the coords a_DstOrigin of the whole area. */
+	void UnpackSection(
+		const sSection & a_Section, Vector3i a_SectionOrigin, const cCuboid & a_RelArea,
+		BLOCKTYPE * a_DstTypes, NIBBLETYPE * a_DstMetas, Vector3i a_DstOrigin, Vector3i a_DstSize
+	) const;
+};
+
+
+
+
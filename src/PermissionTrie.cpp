@@ -0,0 +1,92 @@
+
+// PermissionTrie.cpp
+
+// Implements the cPermissionTrie class representing a compiled set of permission templates for fast matching
+
+#include "Globals.h"
+#include "PermissionTrie.h"
+
+
+
+
+
+cPermissionTrie::cPermissionTrie(void):
+	m_Nodes(1)
+{
+}
+
+
+
+
+
+void cPermissionTrie::Compile(const AStringVector & a_Templates)
+{
+	m_Nodes.clear();
+	m_Nodes.emplace_back();
+	for (const auto & Template: a_Templates)
+	{
+		size_t Node = 0;
+		bool HasWildcard = false;
+		for (const auto & Part: StringSplit(Template, "."))
+		{
+			if (Part == "*")
+			{
+				// Anything after the wildcard is irrelevant:
+				m_Nodes[Node].m_HasWildcard = true;
+				HasWildcard = true;
+				break;
+			}
+			auto itr = m_Nodes[Node].m_Children.find(Part);
+			if (itr == m_Nodes[Node].m_Children.end())
+			{
+				const auto Child = m_Nodes.size();
+				m_Nodes[Node].m_Children.emplace(Part, Child);
+				m_Nodes.emplace_back();  // Invalidates all references to m_Nodes' items, hence the indices
+				Node = Child;
+			}
+			else
+			{
+				Node = itr->second;
+			}
+		}  // for Part - StringSplit(Template)
+		if (!HasWildcard)
+		{
+			m_Nodes[Node].m_IsTerminal = true;
+		}
+	}  // for Template - a_Templates[]
+}
+
+
+
+
+
+bool cPermissionTrie::Matches(std::string_view a_Permission) const
+{
+	ASSERT(!a_Permission.empty());
+
+	// Walk the parts the same way StringSplit() would produce them, that is, ignoring a trailing empty part:
+	const sNode * Node = &m_Nodes[0];
+	size_t Start = 0;
+	for (;;)
+	{
+		if (Node->m_HasWildcard)
+		{
+			// There's at least one more part in the permission, which the wildcard matches:
+			return true;
+		}
+		const auto Dot = a_Permission.find('.', Start);
+		const auto Part = a_Permission.substr(Start, (Dot == std::string_view::npos) ? std::string_view::npos : Dot - Start);
+		const auto itr = Node->m_Children.find(Part);
+		if (itr == Node->m_Children.end())
+		{
+			return false;
+		}
+		Node = &m_Nodes[itr->second];
+		if ((Dot == std::string_view::npos) || (Dot + 1 == a_Permission.size()))
+		{
+			// This was the last part, the permission matches only if a template ends here, too:
+			return Node->m_IsTerminal;
+		}
+		Start = Dot + 1;
+	}
+}
@@ -0,0 +1,57 @@
+
+// PermissionTrie.h
+
+// Declares the cPermissionTrie class representing a compiled set of permission templates for fast matching
+
+/*
+Permissions are dot-separated lists of parts, such as "core.teleport.player". A template matches a permission
+if all their parts are equal, or if all the parts are equal up to a "*" part in the template, which matches
+any non-empty remainder (see cPlayer::PermissionMatches()).
+
+The templates are compiled into a trie of parts, with the wildcard stored as a flag on the node preceding it.
+Matching a permission then walks the trie once, taking the parts directly out of the permission string,
+so that no memory is allocated and the cost doesn't depend on the number of templates.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+class cPermissionTrie
+{
+public:
+
+	/** Creates an empty trie, that matches nothing. */
+	cPermissionTrie(void);
+
+	/** Replaces the contents of the trie with the specified templates. */
+	void Compile(const AStringVector & a_Templates);
+
+	/** Returns true if the permission matches any of the compiled templates.
+	The rules are the same as in cPlayer::PermissionMatches(). a_Permission must not be empty. */
+	bool Matches(std::string_view a_Permission) const;
+
+protected:
+
+	/** A single node of the trie, representing a sequence of parts shared by one or more templates. */
+	struct sNode
+	{
+		/** Indices of the child nodes into m_Nodes, by the next part of the template. */
+		std::map<AString, size_t, std::less<>> m_Children;
+
+		/** True if a template ends at this node. */
+		bool m_IsTerminal = false;
+
+		/** True if a template has a wildcard after this node's parts. */
+		bool m_HasWildcard = false;
+	};
+
+	/** All the nodes of the trie, the root is the first one. */
+	std::vector<sNode> m_Nodes;
+};
@@ -7,7 +7,10 @@
 #include "Chunk.h"
 #include "ClientHandle.h"
 #include "Entities/FallingBlock.h"
+#include "ExplosionBatch.h"
+#include "ExplosionTracer.h"
 #include "LineBlockTracer.h"
+#include "OSSupport/ThreadPool.h"
 #include "Simulator/SandSimulator.h"
 
 
@@ -16,10 +19,7 @@
 
 namespace Explodinator
 {
-	static const auto StepUnit = 0.3f;
 	static const auto KnockbackFactor = 25U;
-	static const auto StepAttenuation = 0.225f;
-	static const auto TraceCubeSideLength = 16U;
 	static const auto BoundingBoxStepUnit = 0.5;
 
 	/** Converts an absolute floating-point Position into a Chunk-relative one. */
@@ -28,137 +28,6 @@ namespace Explodinator
 		return { a_Position.x - a_ChunkPosition.m_ChunkX * cChunkDef::Width, a_Position.y, a_Position.z - a_ChunkPosition.m_ChunkZ * cChunkDef::Width };
 	}
 
-	/** Make a From Chunk-relative Position into a To Chunk-relative position. */
-	static Vector3f RebaseRelativePosition(const cChunkCoords a_From, const cChunkCoords a_To, const Vector3f a_Position)
-	{
-		return
-		{
-			a_Position.x + (a_From.m_ChunkX - a_To.m_ChunkX) * cChunkDef::Width,
-			a_Position.y,
-			a_Position.z + (a_From.m_ChunkZ - a_To.m_ChunkZ) * cChunkDef::Width
-		};
-	}
-
-	/** Returns how much of an explosion Destruction Lazor's (tm) intensity the given block attenuates.
-	Values are scaled as 0.3 * (0.3 + Wiki) since some compilers miss the constant folding optimisation.
-	Wiki values are https://minecraft.gamepedia.com/Explosion#Blast_resistance as of 2021-02-06. */
-	static float GetExplosionAbsorption(const BLOCKTYPE Block)
-	{
-		switch (Block)
-		{
-			case E_BLOCK_BEDROCK:
-			case E_BLOCK_COMMAND_BLOCK:
-			case E_BLOCK_END_GATEWAY:
-			case E_BLOCK_END_PORTAL:
-			case E_BLOCK_END_PORTAL_FRAME: return 1080000.09f;
-			case E_BLOCK_ANVIL:
-			case E_BLOCK_ENCHANTMENT_TABLE:
-			case E_BLOCK_OBSIDIAN: return 360.09f;
-			case E_BLOCK_ENDER_CHEST: return 180.09f;
-			case E_BLOCK_LAVA:
-			case E_BLOCK_STATIONARY_LAVA:
-			case E_BLOCK_WATER:
-			case E_BLOCK_STATIONARY_WATER: return 30.09f;
-			case E_BLOCK_DRAGON_EGG:
-			case E_BLOCK_END_STONE:
-			case E_BLOCK_END_BRICKS: return 2.79f;
-			case E_BLOCK_STONE:
-			case E_BLOCK_BLOCK_OF_COAL:
-			case E_BLOCK_DIAMOND_BLOCK:
-			case E_BLOCK_EMERALD_BLOCK:
-			case E_BLOCK_GOLD_BLOCK:
-			case E_BLOCK_IRON_BLOCK:
-			case E_BLOCK_BLOCK_OF_REDSTONE:
-			case E_BLOCK_BRICK:
-			case E_BLOCK_BRICK_STAIRS:
-			case E_BLOCK_COBBLESTONE:
-			case E_BLOCK_COBBLESTONE_STAIRS:
-			case E_BLOCK_IRON_BARS:
-			case E_BLOCK_JUKEBOX:
-			case E_BLOCK_MOSSY_COBBLESTONE:
-			case E_BLOCK_NETHER_BRICK:
-			case E_BLOCK_NETHER_BRICK_FENCE:
-			case E_BLOCK_NETHER_BRICK_STAIRS:
-			case E_BLOCK_PRISMARINE_BLOCK:
-			case E_BLOCK_STONE_BRICKS:
-			case E_BLOCK_STONE_BRICK_STAIRS:
-			case E_BLOCK_COBBLESTONE_WALL: return 1.89f;
-			case E_BLOCK_IRON_DOOR:
-			case E_BLOCK_IRON_TRAPDOOR:
-			case E_BLOCK_MOB_SPAWNER: return 1.59f;
-			case E_BLOCK_HOPPER: return 1.53f;
-			case E_BLOCK_TERRACOTTA: return 1.35f;
-			case E_BLOCK_COBWEB: return 1.29f;
-			case E_BLOCK_DISPENSER:
-			case E_BLOCK_DROPPER:
-			case E_BLOCK_FURNACE:
-			case E_BLOCK_OBSERVER: return 1.14f;
-			case E_BLOCK_BEACON:
-			case E_BLOCK_COAL_ORE:
-			case E_BLOCK_COCOA_POD:
-			case E_BLOCK_DIAMOND_ORE:
-			case E_BLOCK_EMERALD_ORE:
-			case E_BLOCK_GOLD_ORE:
-			case E_BLOCK_IRON_ORE:
-			case E_BLOCK_LAPIS_BLOCK:
-			case E_BLOCK_LAPIS_ORE:
-			case E_BLOCK_NETHER_QUARTZ_ORE:
-			case E_BLOCK_PLANKS:
-			case E_BLOCK_REDSTONE_ORE:
-			case E_BLOCK_FENCE:
-			case E_BLOCK_FENCE_GATE:
-			case E_BLOCK_WOODEN_DOOR:
-			case E_BLOCK_WOODEN_SLAB:
-			case E_BLOCK_WOODEN_STAIRS:
-			case E_BLOCK_TRAPDOOR: return 0.99f;
-			case E_BLOCK_CHEST:
-			case E_BLOCK_WORKBENCH:
-			case E_BLOCK_TRAPPED_CHEST: return 0.84f;
-			case E_BLOCK_BONE_BLOCK:
-			case E_BLOCK_CAULDRON:
-			case E_BLOCK_LOG: return 0.69f;  // nIcE
-			case E_BLOCK_CONCRETE: return 0.63f;
-			case E_BLOCK_BOOKCASE: return 0.54f;
-			case E_BLOCK_STANDING_BANNER:
-			case E_BLOCK_WALL_BANNER:
-			case E_BLOCK_JACK_O_LANTERN:
-			case E_BLOCK_MELON:
-			case E_BLOCK_HEAD:
-			case E_BLOCK_NETHER_WART_BLOCK:
-			case E_BLOCK_PUMPKIN:
-			case E_BLOCK_SIGN_POST:
-			case E_BLOCK_WALLSIGN: return 0.39f;
-			case E_BLOCK_QUARTZ_BLOCK:
-			case E_BLOCK_QUARTZ_STAIRS:
-			case E_BLOCK_RED_SANDSTONE:
-			case E_BLOCK_RED_SANDSTONE_STAIRS:
-			case E_BLOCK_SANDSTONE:
-			case E_BLOCK_SANDSTONE_STAIRS:
-			case E_BLOCK_WOOL: return 0.33f;
-			case E_BLOCK_SILVERFISH_EGG: return 0.315f;
-			case E_BLOCK_ACTIVATOR_RAIL:
-			case E_BLOCK_DETECTOR_RAIL:
-			case E_BLOCK_POWERED_RAIL:
-			case E_BLOCK_RAIL: return 0.3f;
-			case E_BLOCK_GRASS_PATH:
-			case E_BLOCK_CLAY:
-			case E_BLOCK_FARMLAND:
-			case E_BLOCK_GRASS:
-			case E_BLOCK_GRAVEL:
-			case E_BLOCK_SPONGE: return 0.27f;
-			case E_BLOCK_BREWING_STAND:
-			case E_BLOCK_STONE_BUTTON:
-			case E_BLOCK_WOODEN_BUTTON:
-			case E_BLOCK_CAKE:
-			case E_BLOCK_CONCRETE_POWDER:
-			case E_BLOCK_DIRT:
-			case E_BLOCK_FROSTED_ICE:
-			case E_BLOCK_HAY_BALE:
-			case E_BLOCK_ICE: return 0.24f;
-			default: return 0.09f;
-		}
-	}
-
 	/** Calculates the approximate percentage of an Entity's bounding box that is exposed to an explosion centred at Position. */
 	static float CalculateEntityExposure(const cChunk & a_Chunk, const cEntity & a_Entity, const Vector3f a_Position, const int a_SquareRadius)
 	{
@@ -330,49 +199,67 @@ namespace Explodinator
 		SetBlock(World, a_Chunk, Absolute, a_Position, DestroyedBlock, E_BLOCK_AIR, a_ExplodingEntity);
 	}
 
-	/** Traces the path taken by one Explosion Lazor (tm) with given direction and intensity, that will destroy blocks until it is exhausted. */
-	static void DestructionTrace(cChunk * a_Chunk, Vector3f a_Origin, const Vector3f a_Direction, const int a_Power, const bool a_Fiery, float a_Intensity, const cEntity * const a_ExplodingEntity)
+	/** The chunks that an explosion's rays may reach, indexed by their offset from the exploding chunk.
+	Serves as the block source for TraceRay, the rays look up the chunk they cross into with a single lookup instead of walking the chunk neighbours. */
+	class cBlastArea
 	{
-		// The current position the ray is at.
-		auto Checkpoint = a_Origin;
-
-		// The displacement that the ray in one iteration step should travel.
-		const auto Step = a_Direction.NormalizeCopy() * StepUnit;
-
-		// Loop until intensity runs out:
-		while (a_Intensity > 0)
+	public:
+
+		cBlastArea(cChunk & a_Chunk, const int a_Power, const bool a_Fiery, const cEntity * const a_ExplodingEntity):
+			m_Power(a_Power),
+			m_Fiery(a_Fiery),
+			m_ExplodingEntity(a_ExplodingEntity),
+			m_Radius(GetMaximumReach(a_Power) / cChunkDef::Width + 1),
+			m_Side(2 * m_Radius + 1),
+			m_Chunks(static_cast<size_t>(m_Side * m_Side), nullptr)
 		{
-			auto Position = Checkpoint.Floor();
-			if (!cChunkDef::IsValidHeight(Position.y))
+			for (int ChunkZ = -m_Radius; ChunkZ <= m_Radius; ChunkZ++)
 			{
-				break;
+				for (int ChunkX = -m_Radius; ChunkX <= m_Radius; ChunkX++)
+				{
+					const auto Neighbour = a_Chunk.GetRelNeighborChunk(ChunkX * cChunkDef::Width, ChunkZ * cChunkDef::Width);
+					if ((Neighbour != nullptr) && Neighbour->IsValid())
+					{
+						m_Chunks[static_cast<size_t>((ChunkZ + m_Radius) * m_Side + ChunkX + m_Radius)] = Neighbour;
+					}
+				}
 			}
+		}
 
-			const auto Neighbour = a_Chunk->GetRelNeighborChunkAdjustCoords(Position);
-			if ((Neighbour == nullptr) || !Neighbour->IsValid())
+		cChunk * GetChunk(const int a_ChunkX, const int a_ChunkZ) const
+		{
+			if ((std::abs(a_ChunkX) > m_Radius) || (std::abs(a_ChunkZ) > m_Radius))
 			{
-				break;
+				return nullptr;
 			}
+			return m_Chunks[static_cast<size_t>((a_ChunkZ + m_Radius) * m_Side + a_ChunkX + m_Radius)];
+		}
 
-			a_Intensity -= GetExplosionAbsorption(Neighbour->GetBlock(Position));
-			if (a_Intensity <= 0)
-			{
-				// The ray is exhausted:
-				break;
-			}
+		static BLOCKTYPE GetBlock(const cChunk & a_Chunk, const Vector3i a_RelPos)
+		{
+			return a_Chunk.GetBlock(a_RelPos);
+		}
 
-			DestroyBlock(*Neighbour, Position, a_Power, a_Fiery, a_ExplodingEntity);
+		void DestroyBlock(cChunk & a_Chunk, const Vector3i a_RelPos) const
+		{
+			Explodinator::DestroyBlock(a_Chunk, a_RelPos, m_Power, m_Fiery, m_ExplodingEntity);
+		}
 
-			// Adjust coordinates to be relative to the neighbour chunk:
-			Checkpoint = RebaseRelativePosition(a_Chunk->GetPos(), Neighbour->GetPos(), Checkpoint);
-			a_Origin = RebaseRelativePosition(a_Chunk->GetPos(), Neighbour->GetPos(), a_Origin);
-			a_Chunk = Neighbour;
+	private:
 
-			// Increment the simulation, weaken the ray:
-			Checkpoint += Step;
-			a_Intensity -= StepAttenuation;
-		}
-	}
+		const int m_Power;
+		const bool m_Fiery;
+		const cEntity * const m_ExplodingEntity;
+
+		/** The number of chunks around the exploding chunk, in each direction, that are included. */
+		const int m_Radius;
+
+		/** The number of chunks in each row of m_Chunks. */
+		const int m_Side;
+
+		/** The chunks, nullptr for the ones not loaded. */
+		std::vector<cChunk *> m_Chunks;
+	};
 
 	/** Returns a random intensity for an Explosion Lazor (tm) as a function of the explosion's power. */
 	static float RandomIntensity(MTRand & a_Random, const int a_Power)
@@ -384,41 +271,12 @@ namespace Explodinator
 	static void DamageBlocks(cChunk & a_Chunk, const Vector3f a_Position, const int a_Power, const bool a_Fiery, const cEntity * const a_ExplodingEntity)
 	{
 		// Oh boy... Better hope you have a hot cache, 'cos this little manoeuvre's gonna cost us 1352 raytraces in one tick...
-		const int HalfSide = TraceCubeSideLength / 2;
 		auto & Random = GetRandomProvider();
-
-		// The following loops implement the tracing algorithm described in http://minecraft.gamepedia.com/Explosion
-
-		// Trace rays from the explosion centre to all points in a square of area TraceCubeSideLength * TraceCubeSideLength
-		// for the top and bottom sides:
-		for (int OffsetX = -HalfSide; OffsetX < HalfSide; OffsetX++)
-		{
-			for (int OffsetZ = -HalfSide; OffsetZ < HalfSide; OffsetZ++)
-			{
-				DestructionTrace(&a_Chunk, a_Position, Vector3f(OffsetX, +HalfSide, OffsetZ), a_Power, a_Fiery, RandomIntensity(Random, a_Power), a_ExplodingEntity);
-				DestructionTrace(&a_Chunk, a_Position, Vector3f(OffsetX, -HalfSide, OffsetZ), a_Power, a_Fiery, RandomIntensity(Random, a_Power), a_ExplodingEntity);
-			}
-		}
-
-		// Left and right sides, avoid duplicates at top and bottom edges:
-		for (int OffsetX = -HalfSide; OffsetX < HalfSide; OffsetX++)
+		cBlastArea Area(a_Chunk, a_Power, a_Fiery, a_ExplodingEntity);
+		ForEachRayDirection([&Area, &Random, a_Position, a_Power](const Vector3f a_Direction)
 		{
-			for (int OffsetY = -HalfSide + 1; OffsetY < HalfSide - 1; OffsetY++)
-			{
-				DestructionTrace(&a_Chunk, a_Position, Vector3f(OffsetX, OffsetY, +HalfSide), a_Power, a_Fiery, RandomIntensity(Random, a_Power), a_ExplodingEntity);
-				DestructionTrace(&a_Chunk, a_Position, Vector3f(OffsetX, OffsetY, -HalfSide), a_Power, a_Fiery, RandomIntensity(Random, a_Power), a_ExplodingEntity);
-			}
-		}
-
-		// Front and back sides, avoid all edges:
-		for (int OffsetZ = -HalfSide + 1; OffsetZ < HalfSide - 1; OffsetZ++)
-		{
-			for (int OffsetY = -HalfSide + 1; OffsetY < HalfSide - 1; OffsetY++)
-			{
-				DestructionTrace(&a_Chunk, a_Position, Vector3f(+HalfSide, OffsetY, OffsetZ), a_Power, a_Fiery, RandomIntensity(Random, a_Power), a_ExplodingEntity);
-				DestructionTrace(&a_Chunk, a_Position, Vector3f(-HalfSide, OffsetY, OffsetZ), a_Power, a_Fiery, RandomIntensity(Random, a_Power), a_ExplodingEntity);
-			}
-		}
+			TraceRay(Area, a_Position, a_Direction, RandomIntensity(Random, a_Power));
+		});
 	}
 
 	/** Sends an explosion packet to all clients in the given chunk. */
@@ -441,4 +299,75 @@ namespace Explodinator
 			return false;
 		});
 	}
+
+	/** Copies the block types of the chunks that the blasts may reach into the snapshot, only the sections within their reach. */
+	static void TakeSnapshot(cWorld & a_World, cBlastSnapshot & a_Snapshot)
+	{
+		for (const auto & Coords: a_Snapshot.GetChunkCoords())
+		{
+			a_World.DoWithChunk(Coords.m_ChunkX, Coords.m_ChunkZ, [&a_Snapshot, Coords](cChunk & a_Chunk)
+			{
+				for (int Y = a_Snapshot.GetMinSection(); Y <= a_Snapshot.GetMaxSection(); Y++)
+				{
+					const auto Section = a_Chunk.GetBlockData().GetSection(static_cast<size_t>(Y));
+					a_Snapshot.SetSection(Coords, Y, (Section == nullptr) ? nullptr : Section->data());
+				}
+				return true;
+			});
+		}
+	}
+
+	void Kaboom(cWorld & a_World, const std::vector<sExplosion> & a_Explosions)
+	{
+		// Draw the rays' intensities up front, in the order of the explosions, so that the tracing may run in parallel:
+		auto & Random = GetRandomProvider();
+		std::vector<sBlast> Blasts;
+		std::vector<const sExplosion *> BlastExplosions;
+		Blasts.reserve(a_Explosions.size());
+		BlastExplosions.reserve(a_Explosions.size());
+		for (const auto & Explosion: a_Explosions)
+		{
+			const auto Chunk = cChunkDef::BlockToChunk(Explosion.m_Position.Floor());
+			if (!a_World.IsChunkValid(Chunk.m_ChunkX, Chunk.m_ChunkZ))
+			{
+				// Same as Kaboom(), nothing explodes in a chunk that isn't loaded:
+				continue;
+			}
+
+			sBlast Blast{ Chunk, AbsoluteToRelative(Explosion.m_Position, Chunk), Explosion.m_Power, {}, {} };
+			Blast.m_Intensities.reserve(NumRays);
+			for (size_t i = 0; i < NumRays; i++)
+			{
+				Blast.m_Intensities.push_back(RandomIntensity(Random, Explosion.m_Power));
+			}
+			Blasts.push_back(std::move(Blast));
+			BlastExplosions.push_back(&Explosion);
+		}
+
+		cBlastSnapshot Snapshot(Blasts);
+		TakeSnapshot(a_World, Snapshot);
+		TraceBlasts(Snapshot, Blasts, cThreadPool::Get());
+
+		// Apply the explosions to the world one after another, each in the same order as Kaboom() does:
+		for (size_t i = 0; i < Blasts.size(); i++)
+		{
+			const auto & Blast = Blasts[i];
+			const auto & Explosion = *BlastExplosions[i];
+			a_World.DoWithChunk(Blast.m_Chunk.m_ChunkX, Blast.m_Chunk.m_ChunkZ, [&Blast, &Explosion](cChunk & a_Chunk)
+			{
+				LagTheClient(a_Chunk, Explosion.m_Position, Explosion.m_Power);
+				DamageEntities(a_Chunk, Explosion.m_Position, Explosion.m_Power);
+				for (const auto & Destroyed: Blast.m_Destroyed)
+				{
+					auto Relative = Destroyed;
+					const auto Neighbour = a_Chunk.GetRelNeighborChunkAdjustCoords(Relative);
+					if ((Neighbour != nullptr) && Neighbour->IsValid())
+					{
+						DestroyBlock(*Neighbour, Relative, Explosion.m_Power, Explosion.m_Fiery, Explosion.m_ExplodingEntity);
+					}
+				}
+				return false;
+			});
+		}
+	}
 }
@@ -18,4 +18,20 @@ namespace Explodinator
 	The entity pointer is used to trigger OnBreak for the destroyed blocks.
 	Kaboom indeed, you drunken wretch. */
 	void Kaboom(cWorld & World, Vector3f Position, int Power, bool Fiery, const cEntity * a_ExplodingEntity);
+
+	/** An explosion to be carried out together with others, see the Kaboom() overload below. */
+	struct sExplosion
+	{
+		Vector3f m_Position;
+		int m_Power;
+		bool m_Fiery;
+		const cEntity * m_ExplodingEntity;
+	};
+
+	/** Creates all the explosions at once, with the same effects as calling Kaboom() for each of them, in their order.
+	The blocks around them are copied out of the world, the explosions are traced against the copy, in parallel for those
+	that don't overlap, and then their effects are applied to the world in a single pass, in the order of the explosions.
+	Unlike with the separate calls, the blocks broken by another block's OnBroken() (the other half of a door or a bed)
+	are still seen by the rest of the batch's rays. */
+	void Kaboom(cWorld & World, const std::vector<sExplosion> & Explosions);
 }
@@ -0,0 +1,292 @@
+// ExplosionBatch.cpp
+
+// Implements the cBlastSnapshot class and the TraceBlasts() function that trace a whole batch of explosions at once
+
+#include "Globals.h"
+#include "ExplosionBatch.h"
+#include "ExplosionTracer.h"
+#include "../Cuboid.h"
+#include "../OSSupport/ThreadPool.h"
+
+
+
+
+
+namespace Explodinator
+{
+	static const auto SectionBlockCount = static_cast<size_t>(cChunkDef::SectionHeight * cChunkDef::Width * cChunkDef::Width);
+
+	/** Returns the blocks that the blast's rays may reach, relative to the blast's chunk. */
+	static cCuboid GetRelativeReach(const sBlast & a_Blast)
+	{
+		const auto Reach = GetMaximumReach(a_Blast.m_Power);
+		const auto Centre = a_Blast.m_Position.Floor();
+		return cCuboid(Centre - Vector3i(Reach, Reach, Reach), Centre + Vector3i(Reach, Reach, Reach));
+	}
+
+	/** Returns the blocks that the blast's rays may reach, in absolute coords. */
+	static cCuboid GetReach(const sBlast & a_Blast)
+	{
+		auto Reach = GetRelativeReach(a_Blast);
+		Reach.Move({ a_Blast.m_Chunk.m_ChunkX * cChunkDef::Width, 0, a_Blast.m_Chunk.m_ChunkZ * cChunkDef::Width });
+		return Reach;
+	}
+
+	/** Splits the blasts into the groups whose reach overlaps, directly or through other blasts of the group.
+	Returns the indices of the blasts in each group, in their order; the groups are ordered by their first blast. */
+	static std::vector<std::vector<size_t>> GroupOverlapping(const std::vector<sBlast> & a_Blasts)
+	{
+		std::vector<cCuboid> Reaches;
+		Reaches.reserve(a_Blasts.size());
+		for (const auto & Blast: a_Blasts)
+		{
+			Reaches.push_back(GetReach(Blast));
+		}
+
+		// Union-find, each set is represented by its lowest index:
+		std::vector<size_t> Parent(a_Blasts.size());
+		std::iota(Parent.begin(), Parent.end(), 0);
+		auto Find = [&Parent](size_t a_Index)
+		{
+			while (Parent[a_Index] != a_Index)
+			{
+				Parent[a_Index] = Parent[Parent[a_Index]];
+				a_Index = Parent[a_Index];
+			}
+			return a_Index;
+		};
+		for (size_t i = 0; i < Reaches.size(); i++)
+		{
+			for (size_t j = i + 1; j < Reaches.size(); j++)
+			{
+				if (Reaches[i].DoesIntersect(Reaches[j]))
+				{
+					const auto RootI = Find(i);
+					const auto RootJ = Find(j);
+					Parent[std::max(RootI, RootJ)] = std::min(RootI, RootJ);
+				}
+			}
+		}
+
+		std::vector<std::vector<size_t>> Groups;
+		std::vector<size_t> GroupOfRoot(a_Blasts.size(), std::numeric_limits<size_t>::max());
+		for (size_t i = 0; i < a_Blasts.size(); i++)
+		{
+			auto & Group = GroupOfRoot[Find(i)];
+			if (Group == std::numeric_limits<size_t>::max())
+			{
+				Group = Groups.size();
+				Groups.emplace_back();
+			}
+			Groups[Group].push_back(i);
+		}
+		return Groups;
+	}
+
+	/** Serves as the block source for tracing a single blast against the snapshot.
+	The chunks within the blast's reach are looked up when created, the tracing then only reads and writes their blocks.
+	The rays never get further than GetMaximumReach(), so the tracing doesn't touch any blocks outside the blast's reach,
+	and the blasts not overlapping may be traced in parallel. */
+	class cSnapshotBlockSource
+	{
+	public:
+
+		/** A chunk of the snapshot, as seen from the blast. */
+		struct sChunk
+		{
+			/** The block types of the chunk, starting at the snapshot's lowest section. */
+			BLOCKTYPE * m_Blocks;
+
+			/** The offset of the chunk from the blast's chunk, in blocks. */
+			int m_OffsetX;
+			int m_OffsetZ;
+		};
+
+
+		cSnapshotBlockSource(cBlastSnapshot & a_Snapshot, sBlast & a_Blast):
+			m_Blast(a_Blast),
+			m_Radius(GetMaximumReach(a_Blast.m_Power) / cChunkDef::Width + 1),
+			m_Side(2 * m_Radius + 1),
+			m_MinY(a_Snapshot.GetMinSection() * cChunkDef::SectionHeight)
+		{
+			m_Chunks.reserve(static_cast<size_t>(m_Side * m_Side));
+			for (int ChunkZ = -m_Radius; ChunkZ <= m_Radius; ChunkZ++)
+			{
+				for (int ChunkX = -m_Radius; ChunkX <= m_Radius; ChunkX++)
+				{
+					const cChunkCoords Coords(a_Blast.m_Chunk.m_ChunkX + ChunkX, a_Blast.m_Chunk.m_ChunkZ + ChunkZ);
+					m_Chunks.push_back({ a_Snapshot.GetChunkBlocks(Coords), ChunkX * cChunkDef::Width, ChunkZ * cChunkDef::Width });
+				}
+			}
+		}
+
+		sChunk * GetChunk(const int a_ChunkX, const int a_ChunkZ)
+		{
+			if ((std::abs(a_ChunkX) > m_Radius) || (std::abs(a_ChunkZ) > m_Radius))
+			{
+				return nullptr;
+			}
+
+			auto & Chunk = m_Chunks[static_cast<size_t>((a_ChunkZ + m_Radius) * m_Side + a_ChunkX + m_Radius)];
+			return (Chunk.m_Blocks == nullptr) ? nullptr : &Chunk;
+		}
+
+		BLOCKTYPE GetBlock(const sChunk & a_Chunk, const Vector3i a_RelPos) const
+		{
+			return a_Chunk.m_Blocks[GetIndex(a_Chunk, a_RelPos)];
+		}
+
+		void DestroyBlock(sChunk & a_Chunk, const Vector3i a_RelPos)
+		{
+			a_Chunk.m_Blocks[GetIndex(a_Chunk, a_RelPos)] = E_BLOCK_AIR;
+			m_Blast.m_Destroyed.push_back(a_RelPos.addedXZ(a_Chunk.m_OffsetX, a_Chunk.m_OffsetZ));
+		}
+
+	private:
+
+		sBlast & m_Blast;
+
+		/** The number of chunks around the blast's chunk, in each direction, that are included. */
+		const int m_Radius;
+
+		/** The number of chunks in each row of m_Chunks. */
+		const int m_Side;
+
+		/** The height of the lowest block in the snapshot. */
+		const int m_MinY;
+
+		/** The chunks around the blast's chunk, the ones not available have no blocks. */
+		std::vector<sChunk> m_Chunks;
+
+		/** Returns the index of the block, relative to the chunk, in the chunk's m_Blocks. */
+		size_t GetIndex(const sChunk & a_Chunk, const Vector3i a_RelPos) const
+		{
+			ASSERT(GetRelativeReach(m_Blast).IsInside(a_RelPos.addedXZ(a_Chunk.m_OffsetX, a_Chunk.m_OffsetZ)));
+			UNUSED(a_Chunk);
+			return cChunkDef::MakeIndex(a_RelPos.x, a_RelPos.y - m_MinY, a_RelPos.z);
+		}
+	};
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cBlastSnapshot:
+
+Explodinator::cBlastSnapshot::cBlastSnapshot(const std::vector<sBlast> & a_Blasts):
+	m_MinSection(cChunkDef::NumSections - 1),
+	m_MaxSection(0)
+{
+	for (const auto & Blast: a_Blasts)
+	{
+		const auto Reach = GetReach(Blast);
+		m_MinSection = std::min(m_MinSection, Clamp(Reach.p1.y, 0, cChunkDef::Height - 1) / cChunkDef::SectionHeight);
+		m_MaxSection = std::max(m_MaxSection, Clamp(Reach.p2.y, 0, cChunkDef::Height - 1) / cChunkDef::SectionHeight);
+		for (int ChunkZ = FAST_FLOOR_DIV(Reach.p1.z, cChunkDef::Width); ChunkZ <= FAST_FLOOR_DIV(Reach.p2.z, cChunkDef::Width); ChunkZ++)
+		{
+			for (int ChunkX = FAST_FLOOR_DIV(Reach.p1.x, cChunkDef::Width); ChunkX <= FAST_FLOOR_DIV(Reach.p2.x, cChunkDef::Width); ChunkX++)
+			{
+				if (m_Chunks.emplace(cChunkCoords(ChunkX, ChunkZ), std::vector<BLOCKTYPE>()).second)
+				{
+					m_ChunkCoords.emplace_back(ChunkX, ChunkZ);
+				}
+			}
+		}
+	}
+}
+
+
+
+
+
+void Explodinator::cBlastSnapshot::SetSection(const cChunkCoords a_Chunk, const int a_SectionY, const BLOCKTYPE * const a_Blocks)
+{
+	ASSERT((a_SectionY >= m_MinSection) && (a_SectionY <= m_MaxSection));
+	auto itr = m_Chunks.find(a_Chunk);
+	ASSERT(itr != m_Chunks.end());
+	auto & Blocks = itr->second;
+	if (Blocks.empty())
+	{
+		Blocks.resize(static_cast<size_t>(m_MaxSection - m_MinSection + 1) * SectionBlockCount, E_BLOCK_AIR);
+	}
+
+	const auto Section = Blocks.begin() + static_cast<ptrdiff_t>(static_cast<size_t>(a_SectionY - m_MinSection) * SectionBlockCount);
+	if (a_Blocks == nullptr)
+	{
+		std::fill_n(Section, SectionBlockCount, E_BLOCK_AIR);
+	}
+	else
+	{
+		std::copy_n(a_Blocks, SectionBlockCount, Section);
+	}
+}
+
+
+
+
+
+BLOCKTYPE * Explodinator::cBlastSnapshot::GetChunkBlocks(const cChunkCoords a_Chunk)
+{
+	auto itr = m_Chunks.find(a_Chunk);
+	if ((itr == m_Chunks.end()) || itr->second.empty())
+	{
+		return nullptr;
+	}
+	return itr->second.data();
+}
+
+
+
+
+
+size_t Explodinator::cBlastSnapshot::GetNumBytes(void) const
+{
+	size_t Res = 0;
+	for (const auto & Chunk: m_Chunks)
+	{
+		Res += Chunk.second.size();
+	}
+	return Res;
+}
+
+
+
+
+
+void Explodinator::TraceBlasts(cBlastSnapshot & a_Snapshot, std::vector<sBlast> & a_Blasts, cThreadPool & a_Pool)
+{
+	// Look up the chunks for all the blasts up front, the snapshot isn't modified from within the parallel tracing:
+	std::vector<cSnapshotBlockSource> Sources;
+	Sources.reserve(a_Blasts.size());
+	for (auto & Blast: a_Blasts)
+	{
+		ASSERT(Blast.m_Intensities.size() == NumRays);
+		Blast.m_Destroyed.clear();
+		Sources.emplace_back(a_Snapshot, Blast);
+	}
+
+	// Each group is traced in order by a single task:
+	const auto Groups = GroupOverlapping(a_Blasts);
+	std::vector<cThreadPool::cTask> Tasks;
+	Tasks.reserve(Groups.size());
+	for (const auto & Group: Groups)
+	{
+		Tasks.emplace_back([&Group, &Sources, &a_Blasts]()
+		{
+			for (const auto Index: Group)
+			{
+				auto & Source = Sources[Index];
+				const auto & Blast = a_Blasts[Index];
+				size_t Ray = 0;
+				ForEachRayDirection([&Source, &Blast, &Ray](const Vector3f a_Direction)
+				{
+					TraceRay(Source, Blast.m_Position, a_Direction, Blast.m_Intensities[Ray]);
+					Ray += 1;
+				});
+			}
+		});
+	}
+	a_Pool.RunAll(Tasks);
+}
@@ -0,0 +1,106 @@
+// ExplosionBatch.h
+
+// Declares the cBlastSnapshot class and the TraceBlasts() function that trace a whole batch of explosions at once
+
+/*
+When many explosions happen within a single tick (chain TNT), tracing them one by one in the world means walking the chunk
+neighbours for each step of each ray and applying each destroyed block to the world before the next ray starts.
+Instead, the blocks around all the explosions are copied into a snapshot once, the explosions are traced against it,
+and the caller applies the destroyed blocks to the world afterwards, in a single pass:
+	std::vector<Explodinator::sBlast> Blasts;
+	... // Add the explosions, with their rays' intensities
+	Explodinator::cBlastSnapshot Snapshot(Blasts);
+	... // Fill in the sections of the chunks in Snapshot.GetChunkCoords()
+	Explodinator::TraceBlasts(Snapshot, Blasts, cThreadPool::Get());
+	... // Destroy the blocks in each blast's m_Destroyed, in order
+The explosions are traced in the order in which they were added and each of them sees the blocks destroyed by those
+before it, so the same blocks are destroyed as if they exploded one after another. The explosions whose reach doesn't
+overlap can't affect each other, such groups of explosions are traced in parallel.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../ChunkDef.h"
+
+// fwd:
+class cThreadPool;
+
+
+
+
+
+namespace Explodinator
+{
+	/** A single explosion within a batch traced by TraceBlasts(). */
+	struct sBlast
+	{
+		/** The chunk in which the explosion is. */
+		cChunkCoords m_Chunk;
+
+		/** The centre of the explosion, relative to m_Chunk. */
+		Vector3f m_Position;
+
+		int m_Power;
+
+		/** The intensities of the explosion's rays, in the order of ForEachRayDirection(). */
+		std::vector<float> m_Intensities;
+
+		/** The blocks that the explosion destroys, relative to m_Chunk, in the order of their destruction. Filled in by TraceBlasts(). */
+		std::vector<Vector3i> m_Destroyed;
+	};
+
+
+
+
+
+	/** The block types of the chunks that a batch of explosions may reach, copied out of the world before tracing them.
+	Only the sections within the explosions' reach are stored. */
+	class cBlastSnapshot
+	{
+	public:
+
+		/** Creates a snapshot covering the reach of all the blasts, with all the chunks unavailable until their sections are set. */
+		cBlastSnapshot(const std::vector<sBlast> & a_Blasts);
+
+		/** Returns the coords of all the chunks that the blasts may reach. */
+		const std::vector<cChunkCoords> & GetChunkCoords(void) const { return m_ChunkCoords; }
+
+		/** Returns the lowest and the highest section index that the blasts may reach. */
+		int GetMinSection(void) const { return m_MinSection; }
+		int GetMaxSection(void) const { return m_MaxSection; }
+
+		/** Copies the block types of the specified section of the chunk into the snapshot, nullptr meaning an empty section.
+		The chunk becomes available to the tracing; the chunks that have no section set are treated as not loaded. */
+		void SetSection(cChunkCoords a_Chunk, int a_SectionY, const BLOCKTYPE * a_Blocks);
+
+		/** Returns the block types of the chunk, starting with the section GetMinSection(), indexed as cChunkDef::MakeIndex(),
+		or nullptr if the chunk isn't available. */
+		BLOCKTYPE * GetChunkBlocks(cChunkCoords a_Chunk);
+
+		/** Returns the number of bytes of the block data held by the snapshot. */
+		size_t GetNumBytes(void) const;
+
+	private:
+
+		std::vector<cChunkCoords> m_ChunkCoords;
+
+		/** The block types of each chunk, empty for the chunks not available. */
+		std::map<cChunkCoords, std::vector<BLOCKTYPE>> m_Chunks;
+
+		int m_MinSection;
+		int m_MaxSection;
+	};
+
+
+
+
+
+	/** Traces all the blasts against the snapshot, destroying the blocks in it, and fills in the blasts' m_Destroyed.
+	The blasts are traced in their order, each one seeing the blocks destroyed by those before it. The groups of blasts
+	whose reach doesn't overlap are traced in parallel on a_Pool, which doesn't change the result. */
+	void TraceBlasts(cBlastSnapshot & a_Snapshot, std::vector<sBlast> & a_Blasts, cThreadPool & a_Pool);
+}
@@ -0,0 +1,145 @@
+
+// ExplosionTracer.cpp
+
+// Implements the helpers that trace the Explosion Lazors (tm) of a single explosion through the blocks around it
+
+#include "Globals.h"
+#include "ExplosionTracer.h"
+
+
+
+
+
+// Values are scaled as 0.3 * (0.3 + Wiki) since some compilers miss the constant folding optimisation.
+// Wiki values are https://minecraft.gamepedia.com/Explosion#Blast_resistance as of 2021-02-06.
+float Explodinator::GetExplosionAbsorption(const BLOCKTYPE a_Block)
+{
+	switch (a_Block)
+	{
+		case E_BLOCK_BEDROCK:
+		case E_BLOCK_COMMAND_BLOCK:
+		case E_BLOCK_END_GATEWAY:
+		case E_BLOCK_END_PORTAL:
+		case E_BLOCK_END_PORTAL_FRAME: return 1080000.09f;
+		case E_BLOCK_ANVIL:
+		case E_BLOCK_ENCHANTMENT_TABLE:
+		case E_BLOCK_OBSIDIAN: return 360.09f;
+		case E_BLOCK_ENDER_CHEST: return 180.09f;
+		case E_BLOCK_LAVA:
+		case E_BLOCK_STATIONARY_LAVA:
+		case E_BLOCK_WATER:
+		case E_BLOCK_STATIONARY_WATER: return 30.09f;
+		case E_BLOCK_DRAGON_EGG:
+		case E_BLOCK_END_STONE:
+		case E_BLOCK_END_BRICKS: return 2.79f;
+		case E_BLOCK_STONE:
+		case E_BLOCK_BLOCK_OF_COAL:
+		case E_BLOCK_DIAMOND_BLOCK:
+		case E_BLOCK_EMERALD_BLOCK:
+		case E_BLOCK_GOLD_BLOCK:
+		case E_BLOCK_IRON_BLOCK:
+		case E_BLOCK_BLOCK_OF_REDSTONE:
+		case E_BLOCK_BRICK:
+		case E_BLOCK_BRICK_STAIRS:
+		case E_BLOCK_COBBLESTONE:
+		case E_BLOCK_COBBLESTONE_STAIRS:
+		case E_BLOCK_IRON_BARS:
+		case E_BLOCK_JUKEBOX:
+		case E_BLOCK_MOSSY_COBBLESTONE:
+		case E_BLOCK_NETHER_BRICK:
+		case E_BLOCK_NETHER_BRICK_FENCE:
+		case E_BLOCK_NETHER_BRICK_STAIRS:
+		case E_BLOCK_PRISMARINE_BLOCK:
+		case E_BLOCK_STONE_BRICKS:
+		case E_BLOCK_STONE_BRICK_STAIRS:
+		case E_BLOCK_COBBLESTONE_WALL: return 1.89f;
+		case E_BLOCK_IRON_DOOR:
+		case E_BLOCK_IRON_TRAPDOOR:
+		case E_BLOCK_MOB_SPAWNER: return 1.59f;
+		case E_BLOCK_HOPPER: return 1.53f;
+		case E_BLOCK_TERRACOTTA: return 1.35f;
+		case E_BLOCK_COBWEB: return 1.29f;
+		case E_BLOCK_DISPENSER:
+		case E_BLOCK_DROPPER:
+		case E_BLOCK_FURNACE:
+		case E_BLOCK_OBSERVER: return 1.14f;
+		case E_BLOCK_BEACON:
+		case E_BLOCK_COAL_ORE:
+		case E_BLOCK_COCOA_POD:
+		case E_BLOCK_DIAMOND_ORE:
+		case E_BLOCK_EMERALD_ORE:
+		case E_BLOCK_GOLD_ORE:
+		case E_BLOCK_IRON_ORE:
+		case E_BLOCK_LAPIS_BLOCK:
+		case E_BLOCK_LAPIS_ORE:
+		case E_BLOCK_NETHER_QUARTZ_ORE:
+		case E_BLOCK_PLANKS:
+		case E_BLOCK_REDSTONE_ORE:
+		case E_BLOCK_FENCE:
+		case E_BLOCK_FENCE_GATE:
+		case E_BLOCK_WOODEN_DOOR:
+		case E_BLOCK_WOODEN_SLAB:
+		case E_BLOCK_WOODEN_STAIRS:
+		case E_BLOCK_TRAPDOOR: return 0.99f;
+		case E_BLOCK_CHEST:
+		case E_BLOCK_WORKBENCH:
+		case E_BLOCK_TRAPPED_CHEST: return 0.84f;
+		case E_BLOCK_BONE_BLOCK:
+		case E_BLOCK_CAULDRON:
+		case E_BLOCK_LOG: return 0.69f;  // nIcE
+		case E_BLOCK_CONCRETE: return 0.63f;
+		case E_BLOCK_BOOKCASE: return 0.54f;
+		case E_BLOCK_STANDING_BANNER:
+		case E_BLOCK_WALL_BANNER:
+		case E_BLOCK_JACK_O_LANTERN:
+		case E_BLOCK_MELON:
+		case E_BLOCK_HEAD:
+		case E_BLOCK_NETHER_WART_BLOCK:
+		case E_BLOCK_PUMPKIN:
+		case E_BLOCK_SIGN_POST:
+		case E_BLOCK_WALLSIGN: return 0.39f;
+		case E_BLOCK_QUARTZ_BLOCK:
+		case E_BLOCK_QUARTZ_STAIRS:
+		case E_BLOCK_RED_SANDSTONE:
+		case E_BLOCK_RED_SANDSTONE_STAIRS:
+		case E_BLOCK_SANDSTONE:
+		case E_BLOCK_SANDSTONE_STAIRS:
+		case E_BLOCK_WOOL: return 0.33f;
+		case E_BLOCK_SILVERFISH_EGG: return 0.315f;
+		case E_BLOCK_ACTIVATOR_RAIL:
+		case E_BLOCK_DETECTOR_RAIL:
+		case E_BLOCK_POWERED_RAIL:
+		case E_BLOCK_RAIL: return 0.3f;
+		case E_BLOCK_GRASS_PATH:
+		case E_BLOCK_CLAY:
+		case E_BLOCK_FARMLAND:
+		case E_BLOCK_GRASS:
+		case E_BLOCK_GRAVEL:
+		case E_BLOCK_SPONGE: return 0.27f;
+		case E_BLOCK_BREWING_STAND:
+		case E_BLOCK_STONE_BUTTON:
+		case E_BLOCK_WOODEN_BUTTON:
+		case E_BLOCK_CAKE:
+		case E_BLOCK_CONCRETE_POWDER:
+		case E_BLOCK_DIRT:
+		case E_BLOCK_FROSTED_ICE:
+		case E_BLOCK_HAY_BALE:
+		case E_BLOCK_ICE: return 0.24f;
+		default: return 0.09f;
+	}
+}
+
+
+
+
+
+int Explodinator::GetMaximumReach(const int a_Power)
+{
+	// The maximum intensity of a ray is 1.3 * Power, and each step costs at least the air absorption plus the step attenuation:
+	return CeilC(1.3f * a_Power / (GetExplosionAbsorption(E_BLOCK_AIR) + StepAttenuation) * StepUnit) + 1;
+}
+
+
+
+
+
@@ -0,0 +1,148 @@
+
+// ExplosionTracer.h
+
+// Declares the helpers that trace the Explosion Lazors (tm) of a single explosion through the blocks around it
+
+/*
+The tracing doesn't touch the world directly, it works on a block source so that it can be tested on its own.
+The block source provides these three functions, the chunk coords relative to the exploding chunk and the positions relative to the chunk:
+	Chunk * GetChunk(int a_ChunkX, int a_ChunkZ);            // Returns nullptr if the chunk isn't available (not loaded)
+	BLOCKTYPE GetBlock(Chunk & a_Chunk, Vector3i a_RelPos);
+	void DestroyBlock(Chunk & a_Chunk, Vector3i a_RelPos);   // Destroys the (non-air) block, the ray then continues past it
+A ray looks up the chunk only when it crosses into it.
+The rays are traced one after another and each ray destroys the blocks it reaches right away, so a ray sees the
+destruction done by all the rays traced before it.
+See ExplosionBatch.h for tracing many explosions at once.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../BlockType.h"
+#include "../ChunkDef.h"
+
+
+
+
+
+namespace Explodinator
+{
+	static const auto StepUnit = 0.3f;
+	static const auto StepAttenuation = 0.225f;
+	static const auto TraceCubeSideLength = 16U;
+
+	/** The number of the rays of a single explosion, see ForEachRayDirection(). */
+	static const auto NumRays = 6 * TraceCubeSideLength * TraceCubeSideLength - 12 * TraceCubeSideLength + 8;
+
+	/** Returns how much of an explosion Destruction Lazor's (tm) intensity the given block attenuates. */
+	float GetExplosionAbsorption(BLOCKTYPE a_Block);
+
+	/** Returns the maximum distance, in blocks, that a ray of an explosion of the given power may travel. */
+	int GetMaximumReach(int a_Power);
+
+	/** Calls a_Callback with the direction of each ray of an explosion, in the order in which the rays are traced.
+	Implements the tracing algorithm described in http://minecraft.gamepedia.com/Explosion - the rays go from the
+	explosion centre to all points on the surface of a cube of side TraceCubeSideLength, 1352 of them. */
+	template <typename Callback>
+	void ForEachRayDirection(Callback a_Callback)
+	{
+		const int HalfSide = TraceCubeSideLength / 2;
+
+		// Top and bottom sides:
+		for (int OffsetX = -HalfSide; OffsetX < HalfSide; OffsetX++)
+		{
+			for (int OffsetZ = -HalfSide; OffsetZ < HalfSide; OffsetZ++)
+			{
+				a_Callback(Vector3f(OffsetX, +HalfSide, OffsetZ));
+				a_Callback(Vector3f(OffsetX, -HalfSide, OffsetZ));
+			}
+		}
+
+		// Left and right sides, avoid duplicates at top and bottom edges:
+		for (int OffsetX = -HalfSide; OffsetX < HalfSide; OffsetX++)
+		{
+			for (int OffsetY = -HalfSide + 1; OffsetY < HalfSide - 1; OffsetY++)
+			{
+				a_Callback(Vector3f(OffsetX, OffsetY, +HalfSide));
+				a_Callback(Vector3f(OffsetX, OffsetY, -HalfSide));
+			}
+		}
+
+		// Front and back sides, avoid all edges:
+		for (int OffsetZ = -HalfSide + 1; OffsetZ < HalfSide - 1; OffsetZ++)
+		{
+			for (int OffsetY = -HalfSide + 1; OffsetY < HalfSide - 1; OffsetY++)
+			{
+				a_Callback(Vector3f(+HalfSide, OffsetY, OffsetZ));
+				a_Callback(Vector3f(-HalfSide, OffsetY, OffsetZ));
+			}
+		}
+	}
+
+	/** Traces the path taken by one Explosion Lazor (tm) with given direction and intensity, destroying the blocks in the block source until it is exhausted.
+	a_Origin is relative to the exploding chunk. The ray keeps its position relative to the chunk it is in, rebasing it whenever it crosses into
+	another chunk, just as the original tracing through the chunk neighbours did, so that it takes the very same steps.
+	The ray stops at the world's vertical bounds and at the chunks that the source doesn't provide. */
+	template <class BlockSource>
+	void TraceRay(BlockSource & a_Source, const Vector3f a_Origin, const Vector3f a_Direction, float a_Intensity)
+	{
+		// The displacement that the ray in one iteration step should travel:
+		const auto Step = a_Direction.NormalizeCopy() * StepUnit;
+
+		// The chunk that the ray is in, and its offset from the exploding chunk:
+		auto Chunk = a_Source.GetChunk(0, 0);
+		int ChunkX = 0;
+		int ChunkZ = 0;
+
+		// Loop until intensity runs out:
+		for (auto Checkpoint = a_Origin; a_Intensity > 0; Checkpoint += Step)
+		{
+			auto Position = Checkpoint.Floor();
+			if (!cChunkDef::IsValidHeight(Position.y))
+			{
+				return;
+			}
+
+			if (
+				(Position.x < 0) || (Position.x >= cChunkDef::Width) ||
+				(Position.z < 0) || (Position.z >= cChunkDef::Width)
+			)
+			{
+				// The ray has crossed into another chunk, continue relative to that one:
+				const auto DiffX = FAST_FLOOR_DIV(Position.x, cChunkDef::Width);
+				const auto DiffZ = FAST_FLOOR_DIV(Position.z, cChunkDef::Width);
+				ChunkX += DiffX;
+				ChunkZ += DiffZ;
+				Chunk = a_Source.GetChunk(ChunkX, ChunkZ);
+				Position.x -= DiffX * cChunkDef::Width;
+				Position.z -= DiffZ * cChunkDef::Width;
+				Checkpoint.x += static_cast<float>(-DiffX * cChunkDef::Width);
+				Checkpoint.z += static_cast<float>(-DiffZ * cChunkDef::Width);
+			}
+
+			if (Chunk == nullptr)
+			{
+				return;
+			}
+
+			const auto Block = a_Source.GetBlock(*Chunk, Position);
+			a_Intensity -= GetExplosionAbsorption(Block);
+			if (a_Intensity <= 0)
+			{
+				// The ray is exhausted:
+				return;
+			}
+
+			if (Block != E_BLOCK_AIR)
+			{
+				a_Source.DestroyBlock(*Chunk, Position);
+			}
+
+			// Weaken the ray:
+			a_Intensity -= StepAttenuation;
+		}
+	}
+}
@@ -3,12 +3,11 @@
 #include "Protocol_1_8.h"
 #include "Protocol_1_9.h"
 #include "../ClientHandle.h"
+#include "../Root.h"
+#include "../Server.h"
 #include "../WorldStorage/FastNBT.h"
 
-#include "Palettes/Upgrade.h"
-#include "Palettes/Palette_1_13.h"
-#include "Palettes/Palette_1_13_1.h"
-#include "Palettes/Palette_1_14.h"
+#include "Palettes/BlockTables.h"
 
 
 
@@ -35,19 +34,13 @@ namespace
 		return (a_BlockType << 4) | a_Meta;
 	}
 
-	auto Palette393(const BLOCKTYPE a_BlockType, const NIBBLETYPE a_Meta)
+	/** Returns the palette function that looks the blocks up in the specified table. */
+	auto PaletteFromTable(const BlockTables::Table & a_Table)
 	{
-		return Palette_1_13::From(PaletteUpgrade::FromBlock(a_BlockType, a_Meta));
-	}
-
-	auto Palette401(const BLOCKTYPE a_BlockType, const NIBBLETYPE a_Meta)
-	{
-		return Palette_1_13_1::From(PaletteUpgrade::FromBlock(a_BlockType, a_Meta));
-	}
-
-	auto Palette477(const BLOCKTYPE a_BlockType, const NIBBLETYPE a_Meta)
-	{
-		return Palette_1_14::From(PaletteUpgrade::FromBlock(a_BlockType, a_Meta));
+		return [&a_Table](const BLOCKTYPE a_BlockType, const NIBBLETYPE a_Meta)
+		{
+			return a_Table[BlockTables::Index(a_BlockType, a_Meta)];
+		};
 	}
 }
 
@@ -60,6 +53,7 @@ namespace
 
 cChunkDataSerializer::cChunkDataSerializer(const eDimension a_Dimension) :
 	m_Packet(512 KiB),
+	m_SectionData(256 KiB),
 	m_Dimension(a_Dimension)
 {
 }
@@ -120,8 +114,10 @@ void cChunkDataSerializer::SendToClients(const int a_ChunkX, const int a_ChunkZ,
 	// Our cache is only persistent during the function call:
 	for (auto & Cache : m_Cache)
 	{
-		Cache.Engaged = false;
+		Cache.Engaged.fill(false);
+		Cache.EngagedUncompressed = false;
 	}
+	m_PayloadVersion.reset();
 }
 
 
@@ -131,10 +127,23 @@ void cChunkDataSerializer::SendToClients(const int a_ChunkX, const int a_ChunkZ,
 inline void cChunkDataSerializer::Serialize(const ClientHandles::value_type & a_Client, const int a_ChunkX, const int a_ChunkZ, const ChunkBlockData & a_BlockData, const ChunkLightData & a_LightData, const unsigned char * a_BiomeMap, const CacheVersion a_CacheVersion)
 {
 	auto & Cache = m_Cache[static_cast<size_t>(a_CacheVersion)];
-	if (Cache.Engaged)
+	const bool IsCompressed = a_Client->IsCompressionEnabled();
+
+	// Each connection gets the chunk compressed at its own tuned level, the clients at the same level share it:
+	const int Level = IsCompressed ? Clamp(a_Client->GetCompressionLevel(), cCompressionPolicy::LevelStored, cCompressionPolicy::LevelMax) : 0;
+	const auto & ToSend = IsCompressed ? Cache.ToSend[static_cast<size_t>(Level)] : Cache.ToSendUncompressed;
+	if (IsCompressed ? Cache.Engaged[static_cast<size_t>(Level)] : Cache.EngagedUncompressed)
 	{
 		// Success! We've done it already, just re-use:
-		a_Client->SendChunkData(a_ChunkX, a_ChunkZ, Cache.ToSend);
+		a_Client->SendChunkData(a_ChunkX, a_ChunkZ, ToSend);
+		return;
+	}
+
+	if (m_PayloadVersion == a_CacheVersion)
+	{
+		// The payload is serialised already, only the framing for this client is missing:
+		CompressPacketInto(Cache, IsCompressed, Level);
+		a_Client->SendChunkData(a_ChunkX, a_ChunkZ, ToSend);
 		return;
 	}
 
@@ -157,12 +166,12 @@ inline void cChunkDataSerializer::Serialize(const ClientHandles::value_type & a_
 		}
 		case CacheVersion::v393:
 		{
-			Serialize393<&Palette393>(a_ChunkX, a_ChunkZ, a_BlockData, a_LightData, a_BiomeMap);
+			Serialize393<&BlockTables::From_1_13>(a_ChunkX, a_ChunkZ, a_BlockData, a_LightData, a_BiomeMap);
 			break;
 		}
 		case CacheVersion::v401:
 		{
-			Serialize393<&Palette401>(a_ChunkX, a_ChunkZ, a_BlockData, a_LightData, a_BiomeMap);
+			Serialize393<&BlockTables::From_1_13_1>(a_ChunkX, a_ChunkZ, a_BlockData, a_LightData, a_BiomeMap);
 			break;
 		}
 		case CacheVersion::v477:
@@ -172,9 +181,13 @@ inline void cChunkDataSerializer::Serialize(const ClientHandles::value_type & a_
 		}
 	}
 
-	CompressPacketInto(Cache);
-	ASSERT(Cache.Engaged);  // Cache must be populated now
-	a_Client->SendChunkData(a_ChunkX, a_ChunkZ, Cache.ToSend);
+	m_Compressor.ReadFrom(m_Packet);
+	m_Packet.CommitRead();
+	m_PayloadVersion = a_CacheVersion;
+
+	CompressPacketInto(Cache, IsCompressed, Level);
+	ASSERT(IsCompressed ? Cache.Engaged[static_cast<size_t>(Level)] : Cache.EngagedUncompressed);  // Cache must be populated now
+	a_Client->SendChunkData(a_ChunkX, a_ChunkZ, ToSend);
 }
 
 
@@ -259,8 +272,7 @@ inline void cChunkDataSerializer::Serialize107(const int a_ChunkX, const int a_C
 	// This function returns the fully compressed packet (including packet size), not the raw packet!
 	// Below variables tagged static because of https://developercommunity.visualstudio.com/content/problem/367326
 
-	static constexpr UInt8 BitsPerEntry = 13;
-	static constexpr size_t ChunkSectionDataArraySize = (ChunkBlockData::SectionBlockCount * BitsPerEntry) / 8 / 8;  // Convert from bit count to long count
+	static constexpr UInt8 GlobalBitsPerEntry = 13;
 
 	const auto Bitmask = GetSectionBitmask(a_BlockData, a_LightData);
 
@@ -271,39 +283,19 @@ inline void cChunkDataSerializer::Serialize107(const int a_ChunkX, const int a_C
 	m_Packet.WriteBool(true);        // "Ground-up continuous", or rather, "biome data present" flag
 	m_Packet.WriteVarInt32(Bitmask.first);
 
-	size_t ChunkSectionSize = (
-		1 +                                // Bits per block - set to 13, so the global palette is used and the palette has a length of 0
-		1 +                                // Palette length
-		2 +                                // Data array length VarInt - 2 bytes for the current value
-		ChunkSectionDataArraySize * 8 +    // Actual block data - multiplied by 8 because first number is longs
-		ChunkLightData::SectionLightCount  // Block light
-	);
-
-	if (m_Dimension == dimOverworld)
-	{
-		// Sky light is only sent in the overworld.
-		ChunkSectionSize += ChunkLightData::SectionLightCount;
-	}
-
-	const size_t BiomeDataSize = cChunkDef::Width * cChunkDef::Width;
-	const size_t ChunkSize = (
-		ChunkSectionSize * Bitmask.second +
-		BiomeDataSize
-	);
-
-	// Write the chunk size:
-	m_Packet.WriteVarInt32(static_cast<UInt32>(ChunkSize));
-
-	// Write each chunk section...
+	// Write each chunk section into the staging buffer, their sizes depend on their palettes:
 	ChunkDef_ForEachSection(a_BlockData, a_LightData,
 	{
-		m_Packet.WriteBEUInt8(BitsPerEntry);
-		m_Packet.WriteVarInt32(0);  // Palette length is 0
-		m_Packet.WriteVarInt32(static_cast<UInt32>(ChunkSectionDataArraySize));
-		WriteBlockSectionSeamless<&PaletteLegacy>(Blocks, Metas, BitsPerEntry);
-		WriteLightSectionGrouped(BlockLights, SkyLights);
+		m_SectionPalette.Build(Blocks, Metas, &PaletteLegacy, GlobalBitsPerEntry);
+		m_SectionPalette.Write(m_SectionData, true);
+		WriteLightSectionGrouped(m_SectionData, BlockLights, SkyLights);
 	});
 
+	// Write the chunk size and the sections:
+	const size_t BiomeDataSize = cChunkDef::Width * cChunkDef::Width;
+	m_Packet.WriteVarInt32(static_cast<UInt32>(m_SectionData.GetReadableSpace() + BiomeDataSize));
+	MoveSectionDataToPacket();
+
 	// Write the biome data
 	m_Packet.WriteBuf(a_BiomeMap, BiomeDataSize);
 }
@@ -317,8 +309,7 @@ inline void cChunkDataSerializer::Serialize110(const int a_ChunkX, const int a_C
 	// This function returns the fully compressed packet (including packet size), not the raw packet!
 	// Below variables tagged static because of https://developercommunity.visualstudio.com/content/problem/367326
 
-	static constexpr UInt8 BitsPerEntry = 13;
-	static constexpr size_t ChunkSectionDataArraySize = (ChunkBlockData::SectionBlockCount * BitsPerEntry) / 8 / 8;  // Convert from bit count to long count
+	static constexpr UInt8 GlobalBitsPerEntry = 13;
 
 	const auto Bitmask = GetSectionBitmask(a_BlockData, a_LightData);
 
@@ -329,39 +320,19 @@ inline void cChunkDataSerializer::Serialize110(const int a_ChunkX, const int a_C
 	m_Packet.WriteBool(true);        // "Ground-up continuous", or rather, "biome data present" flag
 	m_Packet.WriteVarInt32(Bitmask.first);
 
-	size_t ChunkSectionSize = (
-		1 +                                // Bits per block - set to 13, so the global palette is used and the palette has a length of 0
-		1 +                                // Palette length
-		2 +                                // Data array length VarInt - 2 bytes for the current value
-		ChunkSectionDataArraySize * 8 +    // Actual block data - multiplied by 8 because first number is longs
-		ChunkLightData::SectionLightCount  // Block light
-	);
-
-	if (m_Dimension == dimOverworld)
-	{
-		// Sky light is only sent in the overworld.
-		ChunkSectionSize += ChunkLightData::SectionLightCount;
-	}
-
-	const size_t BiomeDataSize = cChunkDef::Width * cChunkDef::Width;
-	const size_t ChunkSize = (
-		ChunkSectionSize * Bitmask.second +
-		BiomeDataSize
-	);
-
-	// Write the chunk size:
-	m_Packet.WriteVarInt32(static_cast<UInt32>(ChunkSize));
-
-	// Write each chunk section...
+	// Write each chunk section into the staging buffer, their sizes depend on their palettes:
 	ChunkDef_ForEachSection(a_BlockData, a_LightData,
 	{
-		m_Packet.WriteBEUInt8(BitsPerEntry);
-		m_Packet.WriteVarInt32(0);  // Palette length is 0
-		m_Packet.WriteVarInt32(static_cast<UInt32>(ChunkSectionDataArraySize));
-		WriteBlockSectionSeamless<&PaletteLegacy>(Blocks, Metas, BitsPerEntry);
-		WriteLightSectionGrouped(BlockLights, SkyLights);
+		m_SectionPalette.Build(Blocks, Metas, &PaletteLegacy, GlobalBitsPerEntry);
+		m_SectionPalette.Write(m_SectionData, true);
+		WriteLightSectionGrouped(m_SectionData, BlockLights, SkyLights);
 	});
 
+	// Write the chunk size and the sections:
+	const size_t BiomeDataSize = cChunkDef::Width * cChunkDef::Width;
+	m_Packet.WriteVarInt32(static_cast<UInt32>(m_SectionData.GetReadableSpace() + BiomeDataSize));
+	MoveSectionDataToPacket();
+
 	// Write the biome data
 	m_Packet.WriteBuf(a_BiomeMap, BiomeDataSize);
 
@@ -373,16 +344,16 @@ inline void cChunkDataSerializer::Serialize110(const int a_ChunkX, const int a_C
 
 
 
-template <auto Palette>
+template <auto PaletteTable>
 inline void cChunkDataSerializer::Serialize393(const int a_ChunkX, const int a_ChunkZ, const ChunkBlockData & a_BlockData, const ChunkLightData & a_LightData, const unsigned char * a_BiomeMap)
 {
 	// This function returns the fully compressed packet (including packet size), not the raw packet!
 	// Below variables tagged static because of https://developercommunity.visualstudio.com/content/problem/367326
 
-	static constexpr UInt8 BitsPerEntry = 14;
-	static constexpr size_t ChunkSectionDataArraySize = (ChunkBlockData::SectionBlockCount * BitsPerEntry) / 8 / 8;
+	static constexpr UInt8 GlobalBitsPerEntry = 14;
 
 	const auto Bitmask = GetSectionBitmask(a_BlockData, a_LightData);
+	const auto Palette = PaletteFromTable(PaletteTable());
 
 	// Create the packet:
 	m_Packet.WriteVarInt32(0x22);  // Packet id (Chunk Data packet)
@@ -391,37 +362,19 @@ inline void cChunkDataSerializer::Serialize393(const int a_ChunkX, const int a_C
 	m_Packet.WriteBool(true);  // "Ground-up continuous", or rather, "biome data present" flag
 	m_Packet.WriteVarInt32(Bitmask.first);
 
-	size_t ChunkSectionSize = (
-		1 +  // Bits per entry, BEUInt8, 1 byte
-		m_Packet.GetVarIntSize(static_cast<UInt32>(ChunkSectionDataArraySize)) +  // Field containing "size of whole section", VarInt32, variable size
-		ChunkSectionDataArraySize * 8 +  // Actual section data, lots of bytes (multiplier 1 long = 8 bytes)
-		ChunkLightData::SectionLightCount  // Size of blocklight which is always sent
-	);
-
-	if (m_Dimension == dimOverworld)
-	{
-		// Sky light is only sent in the overworld.
-		ChunkSectionSize += ChunkLightData::SectionLightCount;
-	}
-
-	const size_t BiomeDataSize = cChunkDef::Width * cChunkDef::Width;
-	const size_t ChunkSize = (
-		ChunkSectionSize * Bitmask.second +
-		BiomeDataSize * 4  // Biome data now BE ints
-	);
-
-	// Write the chunk size in bytes:
-	m_Packet.WriteVarInt32(static_cast<UInt32>(ChunkSize));
-
-	// Write each chunk section...
+	// Write each chunk section into the staging buffer, their sizes depend on their palettes:
 	ChunkDef_ForEachSection(a_BlockData, a_LightData,
 	{
-		m_Packet.WriteBEUInt8(BitsPerEntry);
-		m_Packet.WriteVarInt32(static_cast<UInt32>(ChunkSectionDataArraySize));
-		WriteBlockSectionSeamless<Palette>(Blocks, Metas, BitsPerEntry);
-		WriteLightSectionGrouped(BlockLights, SkyLights);
+		m_SectionPalette.Build(Blocks, Metas, Palette, GlobalBitsPerEntry);
+		m_SectionPalette.Write(m_SectionData, false);
+		WriteLightSectionGrouped(m_SectionData, BlockLights, SkyLights);
 	});
 
+	// Write the chunk size and the sections:
+	const size_t BiomeDataSize = cChunkDef::Width * cChunkDef::Width;
+	m_Packet.WriteVarInt32(static_cast<UInt32>(m_SectionData.GetReadableSpace() + BiomeDataSize * 4));  // Biome data now BE ints
+	MoveSectionDataToPacket();
+
 	// Write the biome data
 	for (size_t i = 0; i != BiomeDataSize; i++)
 	{
@@ -441,10 +394,10 @@ inline void cChunkDataSerializer::Serialize477(const int a_ChunkX, const int a_C
 	// This function returns the fully compressed packet (including packet size), not the raw packet!
 	// Below variables tagged static because of https://developercommunity.visualstudio.com/content/problem/367326
 
-	static constexpr UInt8 BitsPerEntry = 14;
-	static constexpr size_t ChunkSectionDataArraySize = (ChunkBlockData::SectionBlockCount * BitsPerEntry) / 8 / 8;
+	static constexpr UInt8 GlobalBitsPerEntry = 14;
 
 	const auto Bitmask = GetSectionBitmask(a_BlockData, a_LightData);
+	const auto Palette = PaletteFromTable(BlockTables::From_1_14());
 
 	// Create the packet:
 	m_Packet.WriteVarInt32(0x21);  // Packet id (Chunk Data packet)
@@ -462,31 +415,19 @@ inline void cChunkDataSerializer::Serialize477(const int a_ChunkX, const int a_C
 		m_Packet.Write(Writer.GetResult().data(), Writer.GetResult().size());
 	}
 
-	const size_t ChunkSectionSize = (
-		2 +  // Block count, BEInt16, 2 bytes
-		1 +  // Bits per entry, BEUInt8, 1 byte
-		m_Packet.GetVarIntSize(static_cast<UInt32>(ChunkSectionDataArraySize)) +  // Field containing "size of whole section", VarInt32, variable size
-		ChunkSectionDataArraySize * 8  // Actual section data, lots of bytes (multiplier 1 long = 8 bytes)
-	);
-
-	const size_t BiomeDataSize = cChunkDef::Width * cChunkDef::Width;
-	const size_t ChunkSize = (
-		ChunkSectionSize * Bitmask.second +
-		BiomeDataSize * 4  // Biome data now BE ints
-	);
-
-	// Write the chunk size in bytes:
-	m_Packet.WriteVarInt32(static_cast<UInt32>(ChunkSize));
-
-	// Write each chunk section...
+	// Write each chunk section into the staging buffer, their sizes depend on their palettes:
 	ChunkDef_ForEachSection(a_BlockData, a_LightData,
 	{
-		m_Packet.WriteBEInt16(-1);
-		m_Packet.WriteBEUInt8(BitsPerEntry);
-		m_Packet.WriteVarInt32(static_cast<UInt32>(ChunkSectionDataArraySize));
-		WriteBlockSectionSeamless<&Palette477>(Blocks, Metas, BitsPerEntry);
+		m_SectionData.WriteBEInt16(-1);
+		m_SectionPalette.Build(Blocks, Metas, Palette, GlobalBitsPerEntry);
+		m_SectionPalette.Write(m_SectionData, false);
 	});
 
+	// Write the chunk size and the sections:
+	const size_t BiomeDataSize = cChunkDef::Width * cChunkDef::Width;
+	m_Packet.WriteVarInt32(static_cast<UInt32>(m_SectionData.GetReadableSpace() + BiomeDataSize * 4));  // Biome data now BE ints
+	MoveSectionDataToPacket();
+
 	// Write the biome data
 	for (size_t i = 0; i != BiomeDataSize; i++)
 	{
@@ -501,66 +442,16 @@ inline void cChunkDataSerializer::Serialize477(const int a_ChunkX, const int a_C
 
 
 
-template <auto Palette>
-inline void cChunkDataSerializer::WriteBlockSectionSeamless(const ChunkBlockData::BlockArray * a_Blocks, const ChunkBlockData::MetaArray * a_Metas, const UInt8 a_BitsPerEntry)
-{
-	// https://wiki.vg/Chunk_Format#Data_structure
-
-	// We shift a UInt64 by a_BitsPerEntry, the latter cannot be too big:
-	ASSERT(a_BitsPerEntry < 64);
-
-	UInt64 Buffer = 0;  // A buffer to compose multiple smaller bitsizes into one 64-bit number
-	unsigned char BitIndex = 0;  // The bit-position in Buffer that represents where to write next
-
-	const bool BlocksExist = a_Blocks != nullptr;
-	const bool MetasExist = a_Metas != nullptr;
-
-	for (size_t Index = 0; Index != ChunkBlockData::SectionBlockCount; Index++)
-	{
-		const BLOCKTYPE BlockType = BlocksExist ? (*a_Blocks)[Index] : 0;
-		const NIBBLETYPE BlockMeta = MetasExist ? cChunkDef::ExpandNibble(a_Metas->data(), Index) : 0;
-		const auto Value = Palette(BlockType, BlockMeta);
-
-		// Write as much as possible of Value, starting from BitIndex, into Buffer:
-		Buffer |= static_cast<UInt64>(Value) << BitIndex;
-
-		// The _signed_ count of bits in Value left to write
-		const auto Remaining = static_cast<char>(a_BitsPerEntry - (64 - BitIndex));
-		if (Remaining >= 0)
-		{
-			// There were some bits remaining: we've filled the buffer. Flush it:
-			m_Packet.WriteBEUInt64(Buffer);
-
-			// And write the remaining bits, setting the new BitIndex:
-			Buffer = static_cast<UInt64>(Value >> (a_BitsPerEntry - Remaining));
-			BitIndex = static_cast<unsigned char>(Remaining);
-		}
-		else
-		{
-			// It fit, excellent.
-			BitIndex += a_BitsPerEntry;
-		}
-	}
-
-	static_assert((ChunkBlockData::SectionBlockCount % 64) == 0, "Section must fit wholly into a 64-bit long array");
-	ASSERT(BitIndex == 0);
-	ASSERT(Buffer == 0);
-}
-
-
-
-
-
-inline void cChunkDataSerializer::WriteLightSectionGrouped(const ChunkLightData::LightArray * const a_BlockLights, const ChunkLightData::LightArray * const a_SkyLights)
+inline void cChunkDataSerializer::WriteLightSectionGrouped(cByteBuffer & a_Out, const ChunkLightData::LightArray * const a_BlockLights, const ChunkLightData::LightArray * const a_SkyLights)
 {
 	// Write lighting:
 	if (a_BlockLights == nullptr)
 	{
-		m_Packet.WriteBuf(ChunkLightData::SectionLightCount, ChunkLightData::DefaultBlockLightValue);
+		a_Out.WriteBuf(ChunkLightData::SectionLightCount, ChunkLightData::DefaultBlockLightValue);
 	}
 	else
 	{
-		m_Packet.WriteBuf(a_BlockLights->data(), a_BlockLights->size());
+		a_Out.WriteBuf(a_BlockLights->data(), a_BlockLights->size());
 	}
 
 	// Skylight is only sent in the overworld; the nether and end do not use it:
@@ -568,11 +459,11 @@ inline void cChunkDataSerializer::WriteLightSectionGrouped(const ChunkLightData:
 	{
 		if (a_SkyLights == nullptr)
 		{
-			m_Packet.WriteBuf(ChunkLightData::SectionLightCount, ChunkLightData::DefaultSkyLightValue);
+			a_Out.WriteBuf(ChunkLightData::SectionLightCount, ChunkLightData::DefaultSkyLightValue);
 		}
 		else
 		{
-			m_Packet.WriteBuf(a_SkyLights->data(), a_SkyLights->size());
+			a_Out.WriteBuf(a_SkyLights->data(), a_SkyLights->size());
 		}
 	}
 }
@@ -581,12 +472,43 @@ inline void cChunkDataSerializer::WriteLightSectionGrouped(const ChunkLightData:
 
 
 
-inline void cChunkDataSerializer::CompressPacketInto(ChunkDataCache & a_Cache)
+inline void cChunkDataSerializer::MoveSectionDataToPacket(void)
 {
-	m_Compressor.ReadFrom(m_Packet);
-	m_Packet.CommitRead();
+	VERIFY(m_SectionData.ReadToByteBuffer(m_Packet, m_SectionData.GetReadableSpace()));
+	m_SectionData.CommitRead();
+}
+
+
+
 
-	cProtocol_1_8_0::CompressPacket(m_Compressor, a_Cache.ToSend);
 
-	a_Cache.Engaged = true;
+inline void cChunkDataSerializer::CompressPacketInto(ChunkDataCache & a_Cache, const bool a_IsCompressed, const int a_Level)
+{
+	auto & Policy = cRoot::Get()->GetServer()->GetCompressionPolicy();
+	const auto PacketSize = m_Compressor.GetView().size();
+	if (!a_IsCompressed)
+	{
+		cProtocol_1_8_0::FramePacket(m_Compressor.GetView(), a_Cache.ToSendUncompressed);
+		Policy.AddUncompressedStats(PacketSize);
+		a_Cache.EngagedUncompressed = true;
+		return;
+	}
+
+	auto & ToSend = a_Cache.ToSend[static_cast<size_t>(a_Level)];
+	const auto Start = std::chrono::steady_clock::now();
+	if (a_Level == cCompressionPolicy::LevelStored)
+	{
+		cProtocol_1_8_0::CompressPacket(m_Compressor, ToSend, std::numeric_limits<UInt32>::max());
+	}
+	else
+	{
+		m_Compressor.SetCompressionFactor(a_Level);
+		cProtocol_1_8_0::CompressPacket(m_Compressor, ToSend, Policy.GetThreshold());
+	}
+	if (PacketSize >= Policy.GetThreshold())
+	{
+		Policy.AddStats(a_Level, PacketSize, ToSend.size(), std::chrono::steady_clock::now() - Start);
+	}
+
+	a_Cache.Engaged[static_cast<size_t>(a_Level)] = true;
 }
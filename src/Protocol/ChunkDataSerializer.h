@@ -1,8 +1,12 @@
 #pragma once
 
+#include <optional>
+
 #include "../ByteBuffer.h"
 #include "../ChunkData.h"
 #include "../Defines.h"
+#include "ChunkSectionPalette.h"
+#include "CompressionPolicy.h"
 #include "CircularBufferCompressor.h"
 #include "StringCompression.h"
 
@@ -36,11 +40,14 @@ class cChunkDataSerializer
 		Last = CacheVersion::v477
 	};
 
-	/** A single cache entry containing the raw data, compressed data, and a validity flag. */
+	/** A single cache entry containing the packet framed for the connections without compression and compressed at each level,
+	and their validity flags. Each framing is only built once a client needing it is found. */
 	struct ChunkDataCache
 	{
-		ContiguousByteBuffer ToSend;
-		bool Engaged = false;
+		std::array<ContiguousByteBuffer, cCompressionPolicy::LevelMax + 1> ToSend;
+		ContiguousByteBuffer ToSendUncompressed;
+		std::array<bool, cCompressionPolicy::LevelMax + 1> Engaged{};
+		bool EngagedUncompressed = false;
 	};
 
 public:
@@ -54,33 +61,43 @@ public:
 private:
 
 	/** Serialises the given chunk, storing the result into the given cache entry, and sends the data.
-	If the cache entry is already present, simply re-uses it. */
+	If the cache entry already has the framing for the client's compression level, simply re-uses it.
+	If only the framing is missing, it is built from the serialised payload still held in m_Compressor, without serialising again. */
 	inline void Serialize(const ClientHandles::value_type & a_Client, int a_ChunkX, int a_ChunkZ, const ChunkBlockData & a_BlockData, const ChunkLightData & a_LightData, const unsigned char * a_BiomeMap, CacheVersion a_CacheVersion);
 
 	inline void Serialize47 (int a_ChunkX, int a_ChunkZ, const ChunkBlockData & a_BlockData, const ChunkLightData & a_LightData, const unsigned char * a_BiomeMap);  // Release 1.8
 	inline void Serialize107(int a_ChunkX, int a_ChunkZ, const ChunkBlockData & a_BlockData, const ChunkLightData & a_LightData, const unsigned char * a_BiomeMap);  // Release 1.9
 	inline void Serialize110(int a_ChunkX, int a_ChunkZ, const ChunkBlockData & a_BlockData, const ChunkLightData & a_LightData, const unsigned char * a_BiomeMap);  // Release 1.9.4
-	template <auto Palette>
+	template <auto PaletteTable>
 	inline void Serialize393(int a_ChunkX, int a_ChunkZ, const ChunkBlockData & a_BlockData, const ChunkLightData & a_LightData, const unsigned char * a_BiomeMap);  // Release 1.13 - 1.13.2
 	inline void Serialize477(int a_ChunkX, int a_ChunkZ, const ChunkBlockData & a_BlockData, const ChunkLightData & a_LightData, const unsigned char * a_BiomeMap);  // Release 1.14 - 1.14.4
 
-	/** Writes all blocks in a chunk section into a series of Int64.
-	Writes start from the bit directly subsequent to the previous write's end, possibly crossing over to the next Int64. */
-	template <auto Palette>
-	inline void WriteBlockSectionSeamless(const ChunkBlockData::BlockArray * a_Blocks, const ChunkBlockData::MetaArray * a_Metas, UInt8 a_BitsPerEntry);
+	/** Copies all lights in a chunk section into a_Out, block light followed immediately by sky light. */
+	inline void WriteLightSectionGrouped(cByteBuffer & a_Out, const ChunkLightData::LightArray * a_BlockLights, const ChunkLightData::LightArray * a_SkyLights);
 
-	/** Copies all lights in a chunk section into the packet, block light followed immediately by sky light. */
-	inline void WriteLightSectionGrouped(const ChunkLightData::LightArray * a_BlockLights, const ChunkLightData::LightArray * a_SkyLights);
+	/** Moves the sections written into m_SectionData to the packet. */
+	inline void MoveSectionDataToPacket(void);
 
-	/** Finalises the data, compresses it if required, and stores it into cache. */
-	inline void CompressPacketInto(ChunkDataCache & a_Cache);
+	/** Frames the payload held in m_Compressor, compressing it at a_Level, and stores it into the cache.
+	If a_IsCompressed is false, the packet is framed for a connection not using compression instead, a_Level is ignored. */
+	inline void CompressPacketInto(ChunkDataCache & a_Cache, bool a_IsCompressed, int a_Level);
 
 	/** A staging area used to construct the chunk packet, persistent to avoid reallocating. */
 	cByteBuffer m_Packet;
 
-	/** A compressor used to compress the chunk data. */
+	/** A staging area for the chunk sections, whose size needs to be written into the packet before them.
+	The size depends on the sections' palettes, so it is only known after the sections are written. */
+	cByteBuffer m_SectionData;
+
+	/** Builds and writes the section-local palettes, persistent to reuse its lookup arrays. */
+	cChunkSectionPalette m_SectionPalette;
+
+	/** A compressor used to compress the chunk data. Holds the serialised payload of the last serialised version. */
 	CircularBufferCompressor m_Compressor;
 
+	/** The version whose serialised payload m_Compressor holds, if any. */
+	std::optional<CacheVersion> m_PayloadVersion;
+
 	/** The dimension for the World this Serializer is tied to. */
 	const eDimension m_Dimension;
 
@@ -0,0 +1,179 @@
+
+// ChunkSectionPalette.cpp
+
+// Implements the cChunkSectionPalette class that writes the block data of a chunk section with a section-local palette
+
+#include "Globals.h"
+#include "ChunkSectionPalette.h"
+#include "../ByteBuffer.h"
+
+
+
+
+
+cChunkSectionPalette::cChunkSectionPalette(void):
+	m_Blocks(nullptr),
+	m_Metas(nullptr),
+	m_GlobalBitsPerEntry(0),
+	m_BitsPerEntry(0),
+	m_IsGlobal(false),
+	m_Generation(0)
+{
+	m_KeyGeneration.fill(0);
+	m_Entries.reserve(1 << MaxLocalBitsPerEntry);
+}
+
+
+
+
+
+void cChunkSectionPalette::StartBuild(const ChunkBlockData::BlockArray * a_Blocks, const ChunkBlockData::MetaArray * a_Metas, UInt8 a_GlobalBitsPerEntry)
+{
+	ASSERT(a_GlobalBitsPerEntry < 64);  // The packing shifts a UInt64 by the bits per entry
+
+	m_Blocks = a_Blocks;
+	m_Metas = a_Metas;
+	m_GlobalBitsPerEntry = a_GlobalBitsPerEntry;
+	m_IsGlobal = false;
+	m_Entries.clear();
+
+	// Start a new generation, invalidating all the keys of the previous sections:
+	m_Generation += 1;
+	if (m_Generation == 0)
+	{
+		// Wrapped around, the old generation numbers may collide with the new ones:
+		m_KeyGeneration.fill(0);
+		m_Generation = 1;
+	}
+}
+
+
+
+
+
+void cChunkSectionPalette::AddKey(Key a_Key, UInt32 a_GlobalID)
+{
+	m_KeyGeneration[a_Key] = m_Generation;
+	m_GlobalIDs[a_Key] = a_GlobalID;
+	if (m_IsGlobal)
+	{
+		// The local palette has already overflown, no need to track it anymore
+		return;
+	}
+
+	// Several keys may map onto the same global ID, share the palette entry for those:
+	auto itr = std::find(m_Entries.begin(), m_Entries.end(), a_GlobalID);
+	m_LocalIndices[a_Key] = static_cast<UInt16>(itr - m_Entries.begin());
+	if (itr != m_Entries.end())
+	{
+		return;
+	}
+	if (m_Entries.size() == (1U << MaxLocalBitsPerEntry))
+	{
+		m_IsGlobal = true;
+		m_Entries.clear();
+		return;
+	}
+	m_Entries.push_back(a_GlobalID);
+}
+
+
+
+
+
+void cChunkSectionPalette::FinishBuild(void)
+{
+	if (m_IsGlobal)
+	{
+		m_BitsPerEntry = m_GlobalBitsPerEntry;
+		return;
+	}
+
+	// The smallest number of bits that can index all the entries, but at least the minimum the clients accept:
+	m_BitsPerEntry = MinLocalBitsPerEntry;
+	while ((1U << m_BitsPerEntry) < m_Entries.size())
+	{
+		m_BitsPerEntry += 1;
+	}
+	ASSERT(m_BitsPerEntry <= MaxLocalBitsPerEntry);
+}
+
+
+
+
+
+void cChunkSectionPalette::Write(cByteBuffer & a_Out, bool a_WriteGlobalPaletteLength) const
+{
+	// https://wiki.vg/Chunk_Format#Data_structure
+
+	a_Out.WriteBEUInt8(m_BitsPerEntry);
+	if (m_IsGlobal)
+	{
+		if (a_WriteGlobalPaletteLength)
+		{
+			a_Out.WriteVarInt32(0);
+		}
+	}
+	else
+	{
+		a_Out.WriteVarInt32(static_cast<UInt32>(m_Entries.size()));
+		for (const auto Entry: m_Entries)
+		{
+			a_Out.WriteVarInt32(Entry);
+		}
+	}
+
+	static_assert((ChunkBlockData::SectionBlockCount % 64) == 0, "Section must fit wholly into a 64-bit long array");
+	a_Out.WriteVarInt32(static_cast<UInt32>(ChunkBlockData::SectionBlockCount * m_BitsPerEntry / 64));
+
+	if (m_IsGlobal)
+	{
+		WriteDataArray(a_Out, m_GlobalIDs);
+	}
+	else
+	{
+		WriteDataArray(a_Out, m_LocalIndices);
+	}
+}
+
+
+
+
+
+template <typename ValueArray>
+void cChunkSectionPalette::WriteDataArray(cByteBuffer & a_Out, const ValueArray & a_Values) const
+{
+	// Write all the entries into a series of UInt64, each entry starting directly after the previous one,
+	// possibly crossing over to the next UInt64:
+	UInt64 Buffer = 0;  // A buffer to compose multiple smaller bitsizes into one 64-bit number
+	unsigned char BitIndex = 0;  // The bit-position in Buffer that represents where to write next
+	for (size_t Index = 0; Index != ChunkBlockData::SectionBlockCount; Index++)
+	{
+		const auto Key = GetKey(Index);
+		ASSERT(m_KeyGeneration[Key] == m_Generation);
+		const auto Value = static_cast<UInt64>(a_Values[Key]);
+
+		// Write as much as possible of Value, starting from BitIndex, into Buffer:
+		Buffer |= Value << BitIndex;
+
+		// The _signed_ count of bits in Value left to write
+		const auto Remaining = static_cast<char>(m_BitsPerEntry - (64 - BitIndex));
+		if (Remaining >= 0)
+		{
+			// There were some bits remaining: we've filled the buffer. Flush it:
+			a_Out.WriteBEUInt64(Buffer);
+
+			// And write the remaining bits, setting the new BitIndex:
+			Buffer = Value >> (m_BitsPerEntry - Remaining);
+			BitIndex = static_cast<unsigned char>(Remaining);
+		}
+		else
+		{
+			// It fit, excellent.
+			BitIndex += m_BitsPerEntry;
+		}
+	}
+
+	ASSERT(BitIndex == 0);
+	ASSERT(Buffer == 0);
+}
@@ -0,0 +1,131 @@
+
+// ChunkSectionPalette.h
+
+// Declares the cChunkSectionPalette class that writes the block data of a chunk section with a section-local palette
+
+
+
+
+
+#pragma once
+
+#include "../ChunkData.h"
+
+
+
+
+class cByteBuffer;
+
+
+
+
+
+/** Builds the section-local palette of a chunk section and writes the section's block data in the 1.9+ chunk data format.
+Sections with at most 256 distinct block IDs are written with a local palette and the minimal bits per entry (at least 4),
+the others use the global palette with the protocol's full bits per entry.
+The object is meant to be reused for all the sections, it keeps its lookup arrays between the sections. */
+class cChunkSectionPalette
+{
+public:
+
+	/** The smallest number of bits per entry the clients accept for a local palette. */
+	static constexpr UInt8 MinLocalBitsPerEntry = 4;
+
+	/** The largest number of bits per entry the clients accept for a local palette. */
+	static constexpr UInt8 MaxLocalBitsPerEntry = 8;
+
+
+	cChunkSectionPalette(void);
+
+	/** Builds the palette of the specified section, mapping each block to its global ID by calling a_Palette(BlockType, Meta).
+	The blocks and metas may be nullptr, in which case they are all zero.
+	a_GlobalBitsPerEntry is the number of bits per entry the protocol uses for the global palette. */
+	template <typename PaletteFn>
+	void Build(const ChunkBlockData::BlockArray * a_Blocks, const ChunkBlockData::MetaArray * a_Metas, PaletteFn a_Palette, UInt8 a_GlobalBitsPerEntry)
+	{
+		StartBuild(a_Blocks, a_Metas, a_GlobalBitsPerEntry);
+		for (size_t Index = 0; Index != ChunkBlockData::SectionBlockCount; Index++)
+		{
+			const auto Key = GetKey(Index);
+			if (m_KeyGeneration[Key] != m_Generation)
+			{
+				// The first block of this type and meta in the section:
+				AddKey(Key, static_cast<UInt32>(a_Palette(static_cast<BLOCKTYPE>(Key >> 4), static_cast<NIBBLETYPE>(Key & 0x0f))));
+			}
+		}
+		FinishBuild();
+	}
+
+	/** Returns true if the built section uses the global palette. */
+	bool IsGlobal(void) const { return m_IsGlobal; }
+
+	/** Returns the number of bits per entry of the built section. */
+	UInt8 GetBitsPerEntry(void) const { return m_BitsPerEntry; }
+
+	/** Returns the global IDs in the local palette of the built section. Empty if the section uses the global palette. */
+	const std::vector<UInt32> & GetEntries(void) const { return m_Entries; }
+
+	/** Writes the built section's bits per entry, palette, data array length and data array.
+	If a_WriteGlobalPaletteLength is true, a zero palette length is written for the global palette (1.9 - 1.12), otherwise it is left out (1.13+). */
+	void Write(cByteBuffer & a_Out, bool a_WriteGlobalPaletteLength) const;
+
+protected:
+
+	/** The index into the per-block-type arrays, (BlockType << 4) | Meta. */
+	using Key = UInt16;
+
+	/** The number of different keys. */
+	static constexpr size_t NumKeys = 256 * 16;
+
+
+	/** The section being built and written. */
+	const ChunkBlockData::BlockArray * m_Blocks;
+	const ChunkBlockData::MetaArray * m_Metas;
+
+	/** The number of bits per entry the protocol uses for the global palette. */
+	UInt8 m_GlobalBitsPerEntry;
+
+	/** The number of bits per entry of the built section. */
+	UInt8 m_BitsPerEntry;
+
+	/** True if the built section has too many distinct IDs for a local palette. */
+	bool m_IsGlobal;
+
+	/** The global IDs of the local palette, in the order of their first appearance in the section. */
+	std::vector<UInt32> m_Entries;
+
+	/** The global ID of each key present in the section. */
+	std::array<UInt32, NumKeys> m_GlobalIDs;
+
+	/** The local palette index of each key present in the section. */
+	std::array<UInt16, NumKeys> m_LocalIndices;
+
+	/** The generation in which each key was last seen; the keys of older generations aren't present in the current section.
+	This saves clearing the arrays for each section. */
+	std::array<UInt32, NumKeys> m_KeyGeneration;
+
+	/** The generation of the current section. */
+	UInt32 m_Generation;
+
+
+	/** Returns the key of the block at the specified index in the current section. */
+	Key GetKey(size_t a_Index) const
+	{
+		const BLOCKTYPE BlockType = (m_Blocks != nullptr) ? (*m_Blocks)[a_Index] : 0;
+		const NIBBLETYPE BlockMeta = (m_Metas != nullptr) ? cChunkDef::ExpandNibble(m_Metas->data(), a_Index) : 0;
+		return static_cast<Key>((BlockType << 4) | BlockMeta);
+	}
+
+	/** Resets the state for building the palette of a new section. */
+	void StartBuild(const ChunkBlockData::BlockArray * a_Blocks, const ChunkBlockData::MetaArray * a_Metas, UInt8 a_GlobalBitsPerEntry);
+
+	/** Adds a key first seen in the current section, with its global ID, to the palette. */
+	void AddKey(Key a_Key, UInt32 a_GlobalID);
+
+	/** Decides the bits per entry once all the keys have been added. */
+	void FinishBuild(void);
+
+	/** Writes the data array of the section, each block written as its key's value in a_Values. */
+	template <typename ValueArray>
+	void WriteDataArray(cByteBuffer & a_Out, const ValueArray & a_Values) const;
+};
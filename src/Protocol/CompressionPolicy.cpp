@@ -0,0 +1,224 @@
+
+// CompressionPolicy.cpp
+
+// Implements the cCompressionPolicy class that decides how the game data sent to the clients is compressed
+
+#include "Globals.h"
+#include "CompressionPolicy.h"
+#include "../SettingsRepositoryInterface.h"
+
+
+
+
+
+/** The prefix of the IPv4 addresses mapped into IPv6, as reported for the IPv4 clients of a dual-stack socket. */
+static const AString IPv4MappedPrefix = "::ffff:";
+
+
+
+
+
+cCompressionPolicy::cCompressionPolicy(void) :
+	m_Threshold(256),
+	m_Level(6),
+	m_MinLevel(1),
+	m_MaxLevel(9),
+	m_IsAdaptive(true),
+	m_CPUBudget(0.05)
+{
+}
+
+
+
+
+
+void cCompressionPolicy::Load(cSettingsRepositoryInterface & a_Settings)
+{
+	m_Threshold = static_cast<UInt32>(Clamp(a_Settings.GetValueSetI("Compression", "Threshold", 256), 0, 65536));
+	m_Level = Clamp(a_Settings.GetValueSetI("Compression", "Level", 6), LevelStored, LevelMax);
+	m_IsAdaptive = a_Settings.GetValueSetB("Compression", "Adaptive", true);
+	m_MinLevel = Clamp(a_Settings.GetValueSetI("Compression", "MinLevel", 1), LevelStored, m_Level);
+	m_MaxLevel = Clamp(a_Settings.GetValueSetI("Compression", "MaxLevel", 9), m_Level, LevelMax);
+	m_CPUBudget = Clamp(a_Settings.GetValueSetI("Compression", "CPUBudgetPercent", 5), 1, 100) / 100.0;
+
+	m_NoCompressionNetworks.clear();
+	for (const auto & Network: StringSplitAndTrim(a_Settings.GetValueSet("Compression", "NoCompressionNetworks", ""), ","))
+	{
+		if (Network.empty())
+		{
+			continue;
+		}
+		sNetwork Parsed{0, 0, ""};
+		if (!ParseNetwork(Network, Parsed.m_Address, Parsed.m_Mask))
+		{
+			if (Network.find(':') == AString::npos)
+			{
+				LOGWARNING("Compression: Ignoring an invalid network in NoCompressionNetworks: \"%s\"", Network);
+				continue;
+			}
+			Parsed.m_Text = Network;  // An IPv6 address, compared as a string
+		}
+		m_NoCompressionNetworks.push_back(std::move(Parsed));
+	}
+}
+
+
+
+
+
+bool cCompressionPolicy::IsEnabledFor(const AString & a_IP) const
+{
+	UInt32 Address = 0, Mask = 0;
+	const bool IsIPv4 = ParseNetwork(
+		(a_IP.compare(0, IPv4MappedPrefix.size(), IPv4MappedPrefix) == 0) ? a_IP.substr(IPv4MappedPrefix.size()) : a_IP,
+		Address, Mask
+	);
+	for (const auto & Network: m_NoCompressionNetworks)
+	{
+		if (Network.m_Mask != 0)
+		{
+			if (IsIPv4 && ((Address & Network.m_Mask) == Network.m_Address))
+			{
+				return false;
+			}
+		}
+		else if (NoCaseCompare(Network.m_Text, a_IP) == 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+
+
+int cCompressionPolicy::TuneLevel(int a_Level, double a_CPUShare, bool a_IsLinkCongested, bool a_IsLinkIdle) const
+{
+	if (!m_IsAdaptive)
+	{
+		return a_Level;
+	}
+
+	// Over the CPU budget, compress less, even if the link is congested:
+	if (a_CPUShare > m_CPUBudget)
+	{
+		return std::max(a_Level - 1, m_MinLevel);
+	}
+
+	// The link doesn't keep up, trade more CPU time for less data:
+	if (a_IsLinkCongested)
+	{
+		return std::min(a_Level + 1, m_MaxLevel);
+	}
+
+	// Once the link is idle, return to the configured level; when raising it back, keep a reserve in the CPU budget:
+	if (a_IsLinkIdle)
+	{
+		if (a_Level > m_Level)
+		{
+			return a_Level - 1;
+		}
+		if ((a_Level < m_Level) && (a_CPUShare < m_CPUBudget / 2))
+		{
+			return a_Level + 1;
+		}
+	}
+	return a_Level;
+}
+
+
+
+
+
+void cCompressionPolicy::AddStats(int a_Level, size_t a_BytesIn, size_t a_BytesOut, std::chrono::nanoseconds a_CPUTime)
+{
+	auto & Stats = m_Stats[static_cast<size_t>(Clamp(a_Level, LevelStored, LevelMax))];
+	Stats.m_NumPackets += 1;
+	Stats.m_BytesIn += a_BytesIn;
+	Stats.m_BytesOut += a_BytesOut;
+	Stats.m_CPUTimeNs += static_cast<UInt64>(a_CPUTime.count());
+}
+
+
+
+
+
+void cCompressionPolicy::AddUncompressedStats(size_t a_Bytes)
+{
+	m_UncompressedStats.m_NumPackets += 1;
+	m_UncompressedStats.m_BytesIn += a_Bytes;
+	m_UncompressedStats.m_BytesOut += a_Bytes;
+}
+
+
+
+
+
+AString cCompressionPolicy::GetStats(bool a_ShouldReset)
+{
+	AString res(fmt::format(
+		FMT_STRING("Compression statistics (packets above the threshold):\n"
+		"  The connections start at Level {}; the chunk data is compressed once for each level in use and shared by the clients at that level.\n"),
+		m_Level
+	));
+	auto AddRow = [&res, a_ShouldReset](const AString & a_Name, sLevelStats & a_Stats)
+	{
+		auto NumPackets = a_ShouldReset ? a_Stats.m_NumPackets.exchange(0) : a_Stats.m_NumPackets.load();
+		auto BytesIn = a_ShouldReset ? a_Stats.m_BytesIn.exchange(0) : a_Stats.m_BytesIn.load();
+		auto BytesOut = a_ShouldReset ? a_Stats.m_BytesOut.exchange(0) : a_Stats.m_BytesOut.load();
+		auto CPUTimeNs = a_ShouldReset ? a_Stats.m_CPUTimeNs.exchange(0) : a_Stats.m_CPUTimeNs.load();
+		if (NumPackets == 0)
+		{
+			return;
+		}
+		res.append(fmt::format(FMT_STRING("  {}: {} packets, {:.1f} KiB in, {:.1f} KiB saved ({:.1f} %), CPU {:.2f} ms ({:.1f} MiB / s)\n"),
+			a_Name,
+			NumPackets,
+			static_cast<double>(BytesIn) / 1024,
+			(static_cast<double>(BytesIn) - static_cast<double>(BytesOut)) / 1024,
+			(BytesIn == 0) ? 0.0 : (100.0 - 100.0 * static_cast<double>(BytesOut) / static_cast<double>(BytesIn)),
+			static_cast<double>(CPUTimeNs) / 1000000,
+			(CPUTimeNs == 0) ? 0.0 : (static_cast<double>(BytesIn) / 1024 / 1024 / (static_cast<double>(CPUTimeNs) / 1e9))
+		));
+	};
+	for (size_t Level = 0; Level < m_Stats.size(); Level++)
+	{
+		AddRow(fmt::format(FMT_STRING("level {}"), Level), m_Stats[Level]);
+	}
+	AddRow("no compression", m_UncompressedStats);
+	return res;
+}
+
+
+
+
+
+bool cCompressionPolicy::ParseNetwork(const AString & a_Network, UInt32 & a_Address, UInt32 & a_Mask)
+{
+	auto Slash = a_Network.find('/');
+	unsigned Bits = 32;
+	if ((Slash != AString::npos) && (!StringToInteger(a_Network.substr(Slash + 1), Bits) || (Bits < 1) || (Bits > 32)))
+	{
+		return false;
+	}
+	auto Octets = StringSplit(a_Network.substr(0, Slash), ".");
+	if (Octets.size() != 4)
+	{
+		return false;
+	}
+	UInt32 Address = 0;
+	for (const auto & Octet: Octets)
+	{
+		unsigned Value;
+		if (Octet.empty() || !StringToInteger(Octet, Value) || (Value > 255))
+		{
+			return false;
+		}
+		Address = (Address << 8) | Value;
+	}
+	a_Mask = (Bits == 32) ? 0xffffffff : ~(0xffffffffU >> Bits);
+	a_Address = Address & a_Mask;
+	return true;
+}
@@ -0,0 +1,118 @@
+
+// CompressionPolicy.h
+
+// Declares the cCompressionPolicy class that decides how the game data sent to the clients is compressed
+
+#pragma once
+
+
+
+
+
+// fwd:
+class cSettingsRepositoryInterface;
+
+
+
+
+
+/** The server-wide policy of compressing the game data sent to the clients, configured in the [Compression] section of settings.ini.
+Connections from the networks listed in NoCompressionNetworks don't use compression at all; this is meant for trusted proxies on a fast link,
+where deflating the data costs more CPU time than it saves in the transfer.
+The other connections start at the configured level; if the policy is adaptive, each connection periodically retunes its level through TuneLevel(),
+raising it while its link is congested and lowering it while the compression takes more than the CPU budget.
+Also collects the bytes-saved and CPU-time statistics of the compression at each level. */
+class cCompressionPolicy
+{
+public:
+
+	/** The compression level at which the packets are not deflated at all, while the connection keeps using the compressed framing. */
+	static constexpr int LevelStored = 0;
+
+	/** The highest compression level supported by the compressor. */
+	static constexpr int LevelMax = 12;
+
+
+	cCompressionPolicy(void);
+
+	/** Reads the settings from the [Compression] section, writing the defaults of the missing values. */
+	void Load(cSettingsRepositoryInterface & a_Settings);
+
+	/** Returns true if the connection from the specified IP address should use compression. */
+	bool IsEnabledFor(const AString & a_IP) const;
+
+	/** Returns the size of the packet, in bytes, from which the packets are compressed. Announced to the clients when enabling the compression. */
+	UInt32 GetThreshold(void) const { return m_Threshold; }
+
+	/** Returns the level at which the connections start. */
+	int GetLevel(void) const { return m_Level; }
+
+	/** Returns true if the connections should retune their level through TuneLevel(). */
+	bool IsAdaptive(void) const { return m_IsAdaptive; }
+
+	/** Returns the level to use for the next period, given the level and the share of a CPU core spent on the compression in the last period,
+	and the state of the connection's link at the end of the period. */
+	int TuneLevel(int a_Level, double a_CPUShare, bool a_IsLinkCongested, bool a_IsLinkIdle) const;
+
+	/** Records a packet sent over a connection using compression, at the specified level. */
+	void AddStats(int a_Level, size_t a_BytesIn, size_t a_BytesOut, std::chrono::nanoseconds a_CPUTime);
+
+	/** Records a packet sent over a connection not using compression. */
+	void AddUncompressedStats(size_t a_Bytes);
+
+	/** Returns the statistics of each level as a human-readable table, resetting them if requested.
+	The table notes how the chunk data, shared by the clients, is compressed. */
+	AString GetStats(bool a_ShouldReset);
+
+	/** Parses the network, given as "a.b.c.d/bits" or a single IPv4 address, into the address and the mask.
+	Returns false if the network is not a valid IPv4 network. */
+	static bool ParseNetwork(const AString & a_Network, UInt32 & a_Address, UInt32 & a_Mask);
+
+protected:
+
+	/** A network whose connections don't use compression. */
+	struct sNetwork
+	{
+		/** The IPv4 network in the host byte order, used if m_Mask is nonzero. */
+		UInt32 m_Address;
+		UInt32 m_Mask;
+
+		/** The address compared as a string, for addresses that aren't IPv4 (IPv6). */
+		AString m_Text;
+	};
+
+	/** The statistics of the packets compressed at a single level. */
+	struct sLevelStats
+	{
+		std::atomic<UInt64> m_NumPackets{0};
+		std::atomic<UInt64> m_BytesIn{0};
+		std::atomic<UInt64> m_BytesOut{0};
+		std::atomic<UInt64> m_CPUTimeNs{0};
+	};
+
+
+	/** The networks whose connections don't use compression. */
+	std::vector<sNetwork> m_NoCompressionNetworks;
+
+	/** The size of the packet from which the packets are compressed. */
+	UInt32 m_Threshold;
+
+	/** The level at which the connections start, and to which the adaptive tuning returns once the link is idle. */
+	int m_Level;
+
+	/** The bounds of the adaptive tuning. */
+	int m_MinLevel;
+	int m_MaxLevel;
+
+	/** If true, the connections retune their level through TuneLevel(). */
+	bool m_IsAdaptive;
+
+	/** The share of a CPU core that the compression for a single connection may take before its level is lowered. */
+	double m_CPUBudget;
+
+	/** The statistics of each level. */
+	std::array<sLevelStats, LevelMax + 1> m_Stats;
+
+	/** The statistics of the connections not using compression. */
+	sLevelStats m_UncompressedStats;
+};
@@ -0,0 +1,82 @@
+// DecodedPacketQueue.cpp
+
+// Implements the cDecodedPacketQueue class that passes the received packets from the decoding thread to the tick thread
+
+#include "Globals.h"
+#include "DecodedPacketQueue.h"
+
+
+
+
+
+cDecodedPacketQueue::cDecodedPacketQueue(size_t a_MaxSize):
+	m_MaxSize(a_MaxSize),
+	m_Error(eError::None),
+	m_IsErrorReported(false)
+{
+}
+
+
+
+
+
+bool cDecodedPacketQueue::Push(const ContiguousByteBufferView a_Packet)
+{
+	const auto PacketLen = static_cast<UInt32>(a_Packet.size());
+
+	cCSLock Lock(m_CS);
+	if (m_Error != eError::None)
+	{
+		return false;
+	}
+	if (m_Queued.size() + sizeof(PacketLen) + PacketLen > m_MaxSize)
+	{
+		m_Error = eError::QueueFull;
+		return false;
+	}
+	m_Queued.append(reinterpret_cast<const std::byte *>(&PacketLen), sizeof(PacketLen));
+	m_Queued.append(a_Packet);
+	return true;
+}
+
+
+
+
+
+void cDecodedPacketQueue::SetQueueFull(void)
+{
+	cCSLock Lock(m_CS);
+	if (m_Error == eError::None)
+	{
+		m_Error = eError::QueueFull;
+	}
+}
+
+
+
+
+
+void cDecodedPacketQueue::SetMalformed(const AString & a_Reason)
+{
+	cCSLock Lock(m_CS);
+	if (m_Error != eError::None)
+	{
+		return;
+	}
+	m_Error = eError::Malformed;
+	m_ErrorReason = a_Reason;
+}
+
+
+
+
+
+bool cDecodedPacketQueue::HasError(void) const
+{
+	cCSLock Lock(m_CS);
+	return (m_Error != eError::None);
+}
+
+
+
+
@@ -0,0 +1,105 @@
+// DecodedPacketQueue.h
+
+// Declares the cDecodedPacketQueue class that passes the received packets from the decoding thread to the tick thread
+
+#pragma once
+
+#include "../OSSupport/CriticalSection.h"
+
+
+
+
+
+/** The packets that have been decrypted, decompressed and framed, waiting to be handled by the tick thread.
+Once a client is in game, its packets are decoded on the network thread. The decoder must not act on the client directly from there,
+so it records a decoding error in the queue instead, and the tick thread reports it after handling the packets that came before it.
+Nothing is queued after an error; the client is being kicked anyway. */
+class cDecodedPacketQueue
+{
+public:
+
+	enum class eError
+	{
+		None,
+
+		/** Too much data is waiting to be handled, the server is too busy. */
+		QueueFull,
+
+		/** The received data couldn't be decoded, the reason is reported along with the error. */
+		Malformed,
+	};
+
+
+	/** Creates a queue that holds at most a_MaxSize bytes of packets, including the framing. */
+	explicit cDecodedPacketQueue(size_t a_MaxSize);
+
+	/** Queues the packet. Returns false if the packet was not queued, either because of an earlier error,
+	or because the queue would have grown too large, in which case the QueueFull error is recorded. */
+	bool Push(ContiguousByteBufferView a_Packet);
+
+	/** Records the QueueFull error, unless an error has already been recorded.
+	Used when the data waiting to be decoded overflows, too. */
+	void SetQueueFull(void);
+
+	/** Records the Malformed error, unless an error has already been recorded. */
+	void SetMalformed(const AString & a_Reason);
+
+	/** Returns true if an error has been recorded, in which case there is no point in decoding any more data. */
+	bool HasError(void) const;
+
+	/** Calls a_Handler for each of the queued packets, in the order in which they were queued, and removes them from the queue.
+	Returns the recorded error, once, after all the packets queued before it have been handled; a_ErrorReason receives its reason.
+	Must only be called from a single thread at a time, the packets are handled without holding the lock. */
+	template <class Handler>
+	eError HandleAll(Handler a_Handler, AString & a_ErrorReason)
+	{
+		eError Error;
+		{
+			cCSLock Lock(m_CS);
+			std::swap(m_Handled, m_Queued);
+			Error = m_IsErrorReported ? eError::None : m_Error;
+			if (Error != eError::None)
+			{
+				m_IsErrorReported = true;
+				a_ErrorReason = m_ErrorReason;
+			}
+		}
+
+		for (size_t Pos = 0; Pos < m_Handled.size();)
+		{
+			UInt32 PacketLen;
+			ASSERT(Pos + sizeof(PacketLen) <= m_Handled.size());
+			memcpy(&PacketLen, m_Handled.data() + Pos, sizeof(PacketLen));
+			Pos += sizeof(PacketLen);
+			ASSERT(Pos + PacketLen <= m_Handled.size());
+			a_Handler(ContiguousByteBufferView(m_Handled.data() + Pos, PacketLen));
+			Pos += PacketLen;
+		}
+		m_Handled.clear();
+		return Error;
+	}
+
+protected:
+
+	/** Protects all the members, except m_Handled. */
+	mutable cCriticalSection m_CS;
+
+	const size_t m_MaxSize;
+
+	/** The queued packets, each stored as its UInt32 length in native byte order, followed by the packet type and data. */
+	ContiguousByteBuffer m_Queued;
+
+	/** The packets being handled by HandleAll(), swapped with m_Queued so that both keep their memory.
+	Used only by the thread calling HandleAll(). */
+	ContiguousByteBuffer m_Handled;
+
+	eError m_Error;
+	AString m_ErrorReason;
+
+	/** Set once HandleAll() has returned the error, so that it is reported only once. */
+	bool m_IsErrorReported;
+};
+
+
+
+
@@ -0,0 +1,164 @@
+// OutgoingPacketQueue.cpp
+
+// Implements the cOutgoingPacketQueue class that orders the client's outgoing packets by their priority and holds back the chunk data on congested links
+
+#include "Globals.h"
+#include "OutgoingPacketQueue.h"
+
+
+
+
+
+cOutgoingPacketQueue::cOutgoingPacketQueue(size_t a_MaxLinkQueueSize, size_t a_MaxQueuedChunkData):
+	m_MaxLinkQueueSize(a_MaxLinkQueueSize),
+	m_MaxQueuedChunkData(a_MaxQueuedChunkData),
+	m_HasQueuedSpawns(false),
+	m_NumChunkBytesPushed(0),
+	m_NumChunkBytesPopped(0),
+	m_NumStalls(0),
+	m_StallTime(0)
+{
+}
+
+
+
+
+
+void cOutgoingPacketQueue::Push(const ContiguousByteBufferView a_Data, const ePriority a_Priority)
+{
+	switch (a_Priority)
+	{
+		case ePriority::EntitySpawn:
+		{
+			m_HasQueuedSpawns = true;
+			break;
+		}
+		case ePriority::Entity:
+		{
+			if (m_HasQueuedSpawns)
+			{
+				// The data may refer to an entity whose spawn is still queued, keep it behind the spawn:
+				m_Data[ClassOf(ePriority::Chunk)] += a_Data;
+				m_NumChunkBytesPushed += a_Data.size();
+				return;
+			}
+			break;
+		}
+		default: break;
+	}
+	const auto Class = ClassOf(a_Priority);
+	m_Data[Class] += a_Data;
+	if (Class == ClassOf(ePriority::Chunk))
+	{
+		m_NumChunkBytesPushed += a_Data.size();
+	}
+}
+
+
+
+
+
+void cOutgoingPacketQueue::Pop(ContiguousByteBuffer & a_Out, const size_t a_LinkQueueSize, const cClock::time_point a_Now)
+{
+	// Hold back the chunk data while the link is congested, it would delay everything queued after it:
+	const auto ChunkIdx = ClassOf(ePriority::Chunk);
+	const bool ShouldHoldChunks = !m_Data[ChunkIdx].empty() && (a_LinkQueueSize >= m_MaxLinkQueueSize);
+	if (ShouldHoldChunks && !IsStalled())
+	{
+		m_NumStalls += 1;
+		m_StallStart = a_Now;
+	}
+	else if (!ShouldHoldChunks && IsStalled())
+	{
+		m_StallTime += a_Now - m_StallStart;
+		m_StallStart = {};
+	}
+
+	// Send the classes in the order of their priority:
+	for (size_t i = 0; i < m_Data.size(); i++)
+	{
+		if ((i == ChunkIdx) && ShouldHoldChunks)
+		{
+			continue;
+		}
+		a_Out += m_Data[i];
+		m_Data[i].clear();
+	}
+	if (!ShouldHoldChunks)
+	{
+		m_HasQueuedSpawns = false;
+		m_NumChunkBytesPopped = m_NumChunkBytesPushed;
+	}
+}
+
+
+
+
+
+void cOutgoingPacketQueue::PopAll(ContiguousByteBuffer & a_Out)
+{
+	for (auto & Data: m_Data)
+	{
+		a_Out += Data;
+		Data.clear();
+	}
+	m_HasQueuedSpawns = false;
+	m_NumChunkBytesPopped = m_NumChunkBytesPushed;
+}
+
+
+
+
+
+void cOutgoingPacketQueue::ClearWorldData(void)
+{
+	m_Data[ClassOf(ePriority::Entity)].clear();
+	m_Data[ClassOf(ePriority::Chunk)].clear();
+	m_HasQueuedSpawns = false;
+	m_NumChunkBytesPopped = m_NumChunkBytesPushed;
+}
+
+
+
+
+
+bool cOutgoingPacketQueue::IsCongested(const size_t a_LinkQueueSize) const
+{
+	return (
+		(m_Data[ClassOf(ePriority::Chunk)].size() >= m_MaxQueuedChunkData) ||
+		(a_LinkQueueSize >= m_MaxLinkQueueSize)
+	);
+}
+
+
+
+
+
+cOutgoingPacketQueue::cClock::duration cOutgoingPacketQueue::GetStallTime(const cClock::time_point a_Now) const
+{
+	if (IsStalled())
+	{
+		return m_StallTime + (a_Now - m_StallStart);
+	}
+	return m_StallTime;
+}
+
+
+
+
+
+size_t cOutgoingPacketQueue::ClassOf(const ePriority a_Priority)
+{
+	switch (a_Priority)
+	{
+		case ePriority::Critical:    return 0;
+		case ePriority::Entity:      return 1;
+		case ePriority::Chunk:       return 2;
+		case ePriority::EntitySpawn: return 2;
+	}
+	UNREACHABLE("Unsupported packet priority");
+}
+
+
+
+
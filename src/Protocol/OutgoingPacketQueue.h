@@ -0,0 +1,116 @@
+// OutgoingPacketQueue.h
+
+// Declares the cOutgoingPacketQueue class that orders the client's outgoing packets by their priority and holds back the chunk data on congested links
+
+
+
+
+
+#pragma once
+
+
+
+
+
+/** The outgoing packets of a single client, waiting to be handed over to the link.
+The packets are queued in classes by their priority, the classes are sent out in the order of the ePriority values.
+While the link is congested, the Chunk class is held back, so that it doesn't delay the more important data queued after it.
+Not thread-safe, the client handle serializes the access. */
+class cOutgoingPacketQueue
+{
+public:
+
+	using cClock = std::chrono::steady_clock;
+
+	/** Classes of the outgoing data, in the order in which they are sent out.
+	The packets within a single class are always sent in the order in which they were queued. */
+	enum class ePriority
+	{
+		Critical,     // Login, player state, chat, inventory; anything not classified below
+		Entity,       // Moving and updating the spawned entities
+		Chunk,        // Chunk data and the block updates within them, map data
+		EntitySpawn,  // Spawning an entity; not a class of its own, queued in the Chunk class, see Push()
+	};
+
+	/** The number of the classes, EntitySpawn shares the Chunk class. */
+	static constexpr size_t NumClasses = 3;
+
+
+	/** Creates a queue that holds the chunk data back while the link has at least a_MaxLinkQueueSize bytes to send,
+	and reports congestion once a_MaxQueuedChunkData bytes of the chunk data are waiting. */
+	cOutgoingPacketQueue(size_t a_MaxLinkQueueSize, size_t a_MaxQueuedChunkData);
+
+	/** Queues the data, consisting of whole packets, in the class of a_Priority.
+	The entity spawns are queued in the Chunk class, so that they never reach the client before the chunk the entity is in.
+	Until that class is sent out, the Entity data is queued behind the spawns as well, so that the entity updates don't overtake their spawn. */
+	void Push(ContiguousByteBufferView a_Data, ePriority a_Priority);
+
+	/** Moves the data that should be sent now to the end of a_Out, in the order of the classes.
+	The Chunk class is held back if the link has a_LinkQueueSize bytes to send, which is too many. a_Now is used for the stall statistics. */
+	void Pop(ContiguousByteBuffer & a_Out, size_t a_LinkQueueSize, cClock::time_point a_Now);
+
+	/** Moves all the queued data to the end of a_Out, in the order of the classes, including the held back chunk data.
+	Used when the link is closing. */
+	void PopAll(ContiguousByteBuffer & a_Out);
+
+	/** Drops the queued Entity and Chunk data, it belongs to the world that the client has just left. */
+	void ClearWorldData(void);
+
+	/** Returns true if the link, having a_LinkQueueSize bytes to send, or the queued chunk data is backed up,
+	and no more chunks should be streamed to the client for now. */
+	bool IsCongested(size_t a_LinkQueueSize) const;
+
+	/** Returns the number of bytes queued in the class of a_Priority. */
+	size_t GetNumQueuedBytes(ePriority a_Priority) const { return m_Data[ClassOf(a_Priority)].size(); }
+
+	/** Returns the number of times the chunk data was held back because the link was congested. */
+	UInt64 GetNumStalls(void) const { return m_NumStalls; }
+
+	/** Returns true if the chunk data is being held back right now. */
+	bool IsStalled(void) const { return (m_StallStart != cClock::time_point()); }
+
+	/** Returns the total time for which the chunk data was held back, including the current stall up to a_Now. */
+	cClock::duration GetStallTime(cClock::time_point a_Now) const;
+
+	/** Returns the mark of the end of the data queued in the Chunk class so far.
+	Taken right after queueing a chunk, it tells when that chunk has left the queue, see HasPopped(). */
+	UInt64 GetChunkDataMark(void) const { return m_NumChunkBytesPushed; }
+
+	/** Returns true if all the Chunk class data up to a_Mark, obtained from GetChunkDataMark(), has left the queue.
+	The data dropped by ClearWorldData() counts as having left the queue. */
+	bool HasPopped(UInt64 a_Mark) const { return (m_NumChunkBytesPopped >= a_Mark); }
+
+protected:
+
+	const size_t m_MaxLinkQueueSize;
+	const size_t m_MaxQueuedChunkData;
+
+	/** The queued data, one buffer per class. */
+	std::array<ContiguousByteBuffer, NumClasses> m_Data;
+
+	/** Set while the Chunk class contains an entity spawn; the Entity data is then queued in the Chunk class, too. */
+	bool m_HasQueuedSpawns;
+
+	/** The total number of bytes ever queued in the Chunk class. */
+	UInt64 m_NumChunkBytesPushed;
+
+	/** The total number of bytes that have left the Chunk class, either popped or dropped. */
+	UInt64 m_NumChunkBytesPopped;
+
+	/** The number of times the chunk data was held back. */
+	UInt64 m_NumStalls;
+
+	/** The total duration of the finished stalls of the chunk data. */
+	cClock::duration m_StallTime;
+
+	/** The time when the current stall of the chunk data started, or the default value if the chunk data is not being held back. */
+	cClock::time_point m_StallStart;
+
+
+	/** Returns the index of the class in which the data of a_Priority is queued. */
+	static size_t ClassOf(ePriority a_Priority);
+};
+
+
+
+
@@ -0,0 +1,48 @@
+#include "Globals.h"
+
+#include "BlockTables.h"
+#include "Palette_1_13.h"
+#include "Palette_1_13_1.h"
+#include "Palette_1_14.h"
+#include "Upgrade.h"
+
+namespace BlockTables
+{
+	namespace
+	{
+		/** Builds a table from the specified palette's mapping of the upgraded block states. */
+		template <UInt32 Palette(BlockState)>
+		Table Build()
+		{
+			Table Result;
+			for (size_t Block = 0; Block < 256; Block++)
+			{
+				for (NIBBLETYPE Meta = 0; Meta < 16; Meta++)
+				{
+					const auto ID = Palette(PaletteUpgrade::FromBlock(static_cast<BLOCKTYPE>(Block), Meta));
+					ASSERT(ID <= std::numeric_limits<Table::value_type>::max());
+					Result[Index(static_cast<BLOCKTYPE>(Block), Meta)] = static_cast<Table::value_type>(ID);
+				}
+			}
+			return Result;
+		}
+	}
+
+	const Table & From_1_13()
+	{
+		static const Table Result = Build<&Palette_1_13::From>();
+		return Result;
+	}
+
+	const Table & From_1_13_1()
+	{
+		static const Table Result = Build<&Palette_1_13_1::From>();
+		return Result;
+	}
+
+	const Table & From_1_14()
+	{
+		static const Table Result = Build<&Palette_1_14::From>();
+		return Result;
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "ChunkDef.h"
+
+/** Flat lookup tables mapping each legacy (BLOCKTYPE, meta) pair to its block ID in a protocol's global palette.
+Chunk serialization looks the blocks up in these instead of going through PaletteUpgrade::FromBlock and the generated palette switches for every block.
+The tables are built from those same functions on first use. */
+namespace BlockTables
+{
+	/** A table of the protocol block IDs, indexed by (BlockType << 4) | Meta. */
+	using Table = std::array<UInt16, 256 * 16>;
+
+	/** Returns the index into a Table for the specified block. */
+	inline size_t Index(const BLOCKTYPE Block, const NIBBLETYPE Meta)
+	{
+		return static_cast<size_t>((Block << 4) | (Meta & 0x0f));
+	}
+
+	const Table & From_1_13();
+	const Table & From_1_13_1();
+	const Table & From_1_14();
+}
@@ -15,6 +15,7 @@
 #include "../ByteBuffer.h"
 #include "../EffectID.h"
 #include "../World.h"
+#include "OutgoingPacketQueue.h"
 
 
 
@@ -43,8 +44,7 @@ public:
 
 	cProtocol(cClientHandle * a_Client) :
 		m_Client(a_Client),
-		m_OutPacketBuffer(64 KiB),
-		m_OutPacketLenBuffer(20)  // 20 bytes is more than enough for one VarInt
+		m_OutPacketBuffer(64 KiB)
 	{
 	}
 
@@ -133,6 +133,13 @@ public:
 		pktWindowProperty
 	};
 
+	/** Classes of the outgoing data, in the order in which the client handle sends them out.
+	The Chunk class may be held back while the link to the client is congested, see cOutgoingPacketQueue. */
+	using ePacketPriority = cOutgoingPacketQueue::ePriority;
+
+	/** The number of the ePacketPriority classes. */
+	static constexpr size_t NumPacketPriorities = cOutgoingPacketQueue::NumClasses;
+
 	enum class EntityMetadata
 	{
 		EntityFlags,
@@ -350,6 +357,24 @@ public:
 	The protocol uses the provided buffers for storage and processing, and must have exclusive access to them. */
 	virtual void DataReceived(cByteBuffer & a_Buffer, ContiguousByteBuffer && a_Data) = 0;
 
+	/** Decrypts, decompresses and frames the received data, queueing the complete packets to be handled by HandleDecodedPackets().
+	Called on the network thread once CanDecodeOffTickThread() returns true, with the same exclusive access to the buffers as DataReceived().
+	Must not act on the client, nor throw; the decoding errors are reported to the client by HandleDecodedPackets(). */
+	virtual void DecodeReceivedData(cByteBuffer & a_Buffer, ContiguousByteBuffer && a_Data) = 0;
+
+	/** Handles the packets queued by DecodeReceivedData(), then reports the decoding error that followed them, if any. Called on the tick thread. */
+	virtual void HandleDecodedPackets(void) = 0;
+
+	/** Returns true if handling the packets can no longer change how the received data is decoded (encryption, compression),
+	so that the data can be decoded on the network thread and only the packet handling is left to the tick thread. */
+	virtual bool CanDecodeOffTickThread(void) const = 0;
+
+	/** Returns true if the packets exchanged with the client use the compressed framing (the client has been sent the compression threshold). */
+	virtual bool IsCompressionEnabled(void) const = 0;
+
+	/** Returns the level at which the packets sent to the client are compressed, if IsCompressionEnabled(). May be called from any thread. */
+	virtual int GetCompressionLevel(void) const = 0;
+
 	// Sending stuff to clients (alphabetically sorted):
 	virtual void SendAttachEntity               (const cEntity & a_Entity, const cEntity & a_Vehicle) = 0;
 	virtual void SendBlockAction                (int a_BlockX, int a_BlockY, int a_BlockZ, char a_Byte1, char a_Byte2, BLOCKTYPE a_BlockType) = 0;
@@ -443,6 +468,11 @@ public:
 	/** Returns the ServerID used for authentication through session.minecraft.net */
 	virtual AString GetAuthServerID(void) = 0;
 
+	/** Encrypts the outgoing data in place, if the encryption has been negotiated with the client.
+	Called by the client handle just before the data is handed over to the link, so that the stream cipher
+	processes the data in the order in which it is sent, regardless of the order in which it was queued. */
+	virtual void EncryptOutgoingData(ContiguousByteBuffer & a_Data) = 0;
+
 protected:
 
 	friend class cPacketizer;
@@ -457,17 +487,15 @@ protected:
 	/** Buffer for composing the outgoing packets, through cPacketizer */
 	cByteBuffer m_OutPacketBuffer;
 
-	/** Buffer for composing packet length (so that each cPacketizer instance doesn't allocate a new cPacketBuffer) */
-	cByteBuffer m_OutPacketLenBuffer;
-
 	/** Returns the protocol-specific packet ID given the protocol-agnostic packet enum. */
 	virtual UInt32 GetPacketID(ePacketType a_Packet) const = 0;
 
 	/** Returns the current protocol's version, for handling status requests. */
 	virtual Version GetProtocolVersion() const = 0;
 
-	/** A generic data-sending routine, all outgoing packet data needs to be routed through this so that descendants may override it. */
-	virtual void SendData(ContiguousByteBufferView a_Data) = 0;
+	/** A generic data-sending routine, all outgoing packet data needs to be routed through this so that descendants may override it.
+	a_Data must consist of whole packets, the client handle may send the data of different priorities out of order. */
+	virtual void SendData(ContiguousByteBufferView a_Data, ePacketPriority a_Priority) = 0;
 
 	/** Sends a single packet contained within the cPacketizer class.
 	The cPacketizer's destructor calls this to send the contained packet; protocol may transform the data (compression in 1.8 etc). */
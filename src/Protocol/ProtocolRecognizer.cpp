@@ -312,13 +312,13 @@ void cMultiVersionProtocol::SendPacket(cClientHandle & a_Client, cByteBuffer & a
 	VERIFY(OutPacketLenBuffer.WriteVarInt32(PacketLen));
 	ContiguousByteBuffer LengthData;
 	OutPacketLenBuffer.ReadAll(LengthData);
-	a_Client.SendData(LengthData);
+	a_Client.SendData(LengthData, cProtocol::ePacketPriority::Critical);
 
 	// Send the packet's payload:
 	ContiguousByteBuffer PacketData;
 	a_OutPacketBuffer.ReadAll(PacketData);
 	a_OutPacketBuffer.CommitRead();
-	a_Client.SendData(PacketData);
+	a_Client.SendData(PacketData, cProtocol::ePacketPriority::Critical);
 }
 
 
@@ -44,6 +44,23 @@ public:
 	/** The function that's responsible for processing incoming protocol data. */
 	std::function<void(cClientHandle &, OwnedContiguousByteBuffer)> HandleIncomingData;
 
+	/** Decrypts, decompresses and frames the incoming data, leaving the packets queued in the protocol for HandleDecodedPackets().
+	Used instead of HandleIncomingData once the protocol has been recognized and its CanDecodeOffTickThread() returned true. */
+	void DecodeIncomingData(ContiguousByteBuffer && a_Data)
+	{
+		m_Protocol->DecodeReceivedData(m_Buffer, std::move(a_Data));
+	}
+
+	/** Encrypts the outgoing data in place, if the recognized protocol has negotiated the encryption.
+	Data sent before the protocol has been recognized is never encrypted. */
+	void EncryptOutgoingData(ContiguousByteBuffer & a_Data)
+	{
+		if (m_Protocol != nullptr)
+		{
+			m_Protocol->EncryptOutgoingData(a_Data);
+		}
+	}
+
 	/** Sends a disconnect to the client as a result of a recognition error.
 	This function can be used to disconnect before any protocol has been recognised. */
 	void SendDisconnect(cClientHandle & a_Client, const AString & a_Reason);
@@ -12,6 +12,7 @@ Implements the 1.8 protocol classes:
 #include "main.h"
 #include "../mbedTLS++/Sha1Checksum.h"
 #include "Packetizer.h"
+#include "CompressionPolicy.h"
 
 #include "../ClientHandle.h"
 #include "../Root.h"
@@ -23,6 +24,7 @@ Implements the 1.8 protocol classes:
 #include "../UUID.h"
 #include "../World.h"
 #include "../JsonUtils.h"
+#include "../Metrics.h"
 
 #include "../WorldStorage/FastNBT.h"
 #include "../WorldStorage/EnchantmentSerializer.h"
@@ -86,7 +88,11 @@ Implements the 1.8 protocol classes:
 
 
 const int MAX_ENC_LEN = 512;  // Maximum size of the encrypted message; should be 128, but who knows...
-static const UInt32 CompressionThreshold = 256;  // After how large a packet should we compress it.
+static const auto CompressionTuningPeriod = std::chrono::seconds(1);  // How often the compression level of a connection is retuned.
+static const size_t MaxDecodedPacketsSize = 256 KiB;  // How much decoded packet data may wait for the tick thread before the client is kicked.
+
+/** The number of the packets received from the clients, in cMetrics. */
+static cMetricCounter & PacketsReceivedMetric = cMetrics::Get().GetCounter("cuberite_network_received_packets_total", "The number of the packets received from the clients");
 
 
 
@@ -99,7 +105,13 @@ cProtocol_1_8_0::cProtocol_1_8_0(cClientHandle * a_Client, const AString & a_Ser
 	Super(a_Client),
 	m_State(a_State),
 	m_ServerAddress(a_ServerAddress),
-	m_IsEncrypted(false)
+	m_IsEncrypted(false),
+	m_IsCompressionAllowed(cRoot::Get()->GetServer()->GetCompressionPolicy().IsEnabledFor(a_Client->GetIPString())),  // Before BungeeCord replaces the IP
+	m_IsCompressionEnabled(false),
+	m_CompressionLevel(cRoot::Get()->GetServer()->GetCompressionPolicy().GetLevel()),
+	m_CompressionTime(0),
+	m_CompressionPeriodStart(std::chrono::steady_clock::now()),
+	m_DecodedPackets(MaxDecodedPacketsSize)
 {
 	AStringVector Params;
 	SplitZeroTerminatedStrings(a_ServerAddress, Params);
@@ -176,12 +188,78 @@ cProtocol_1_8_0::cProtocol_1_8_0(cClientHandle * a_Client, const AString & a_Ser
 
 void cProtocol_1_8_0::DataReceived(cByteBuffer & a_Buffer, ContiguousByteBuffer && a_Data)
 {
-	if (m_IsEncrypted)
+	DecodeReceivedData(a_Buffer, std::move(a_Data));
+	HandleDecodedPackets();
+}
+
+
+
+
+
+void cProtocol_1_8_0::DecodeReceivedData(cByteBuffer & a_Buffer, ContiguousByteBuffer && a_Data)
+{
+	if (m_DecodedPackets.HasError())
+	{
+		// The client is being kicked, don't bother decoding any more:
+		return;
+	}
+
+	try
+	{
+		if (m_IsEncrypted)
+		{
+			m_Decryptor.ProcessData(a_Data.data(), a_Data.size());
+		}
+
+		AddReceivedData(a_Buffer, a_Data);
+	}
+	catch (const std::exception & Oops)
 	{
-		m_Decryptor.ProcessData(a_Data.data(), a_Data.size());
+		m_DecodedPackets.SetMalformed(Oops.what());
+	}
+}
+
+
+
+
+
+void cProtocol_1_8_0::HandleDecodedPackets(void)
+{
+	AString ErrorReason;
+	auto Error = m_DecodedPackets.HandleAll([this](const ContiguousByteBufferView a_Packet)
+		{
+			cByteBuffer bb(a_Packet.size());
+			VERIFY(bb.Write(a_Packet.data(), a_Packet.size()));
+			HandlePacket(bb);
+		},
+		ErrorReason
+	);
+
+	// Report the decoding error only after handling the packets that came before it, and here on the tick thread:
+	switch (Error)
+	{
+		case cDecodedPacketQueue::eError::None: break;
+		case cDecodedPacketQueue::eError::QueueFull:
+		{
+			m_Client->PacketBufferFull();
+			break;
+		}
+		case cDecodedPacketQueue::eError::Malformed:
+		{
+			m_Client->Kick(ErrorReason);
+			break;
+		}
 	}
+}
+
+
 
-	AddReceivedData(a_Buffer, a_Data);
+
+
+bool cProtocol_1_8_0::CanDecodeOffTickThread(void) const
+{
+	// Encryption is started and compression is enabled while logging in, neither changes once in game:
+	return (m_State == State::Game);
 }
 
 
@@ -369,7 +447,7 @@ void cProtocol_1_8_0::SendChunkData(const ContiguousByteBufferView a_ChunkData)
 	ASSERT(m_State == 3);  // In game mode?
 
 	cCSLock Lock(m_CSPacket);
-	SendData(a_ChunkData);
+	SendData(a_ChunkData, ePacketPriority::Chunk);
 }
 
 
@@ -851,10 +929,21 @@ void cProtocol_1_8_0::SendLoginSuccess(void)
 {
 	ASSERT(m_State == 2);  // State: login?
 
-	// Enable compression:
+	// Enable compression, unless the client connects from a network where it isn't worth it:
+	if (m_IsCompressionAllowed)
 	{
-		cPacketizer Pkt(*this, pktStartCompression);
-		Pkt.WriteVarInt32(CompressionThreshold);
+		{
+			cPacketizer Pkt(*this, pktStartCompression);
+			Pkt.WriteVarInt32(cRoot::Get()->GetServer()->GetCompressionPolicy().GetThreshold());
+		}
+		m_IsCompressionEnabled = true;
+
+		// The first tuning period starts now, the time spent in the login is not part of the CPU share:
+		m_CompressionPeriodStart = std::chrono::steady_clock::now();
+		if (m_CompressionLevel != cCompressionPolicy::LevelStored)
+		{
+			m_Compressor.SetCompressionFactor(m_CompressionLevel);
+		}
 	}
 
 	m_State = State::Game;
@@ -1753,11 +1842,11 @@ void cProtocol_1_8_0::SendWindowProperty(const cWindow & a_Window, size_t a_Prop
 
 
 
-void cProtocol_1_8_0::CompressPacket(CircularBufferCompressor & a_Packet, ContiguousByteBuffer & a_CompressedData)
+void cProtocol_1_8_0::CompressPacket(CircularBufferCompressor & a_Packet, ContiguousByteBuffer & a_CompressedData, const UInt32 a_Threshold)
 {
 	const auto Uncompressed = a_Packet.GetView();
 
-	if (Uncompressed.size() < CompressionThreshold)
+	if (Uncompressed.size() < a_Threshold)
 	{
 		/* Size doesn't reach threshold, not worth compressing.
 
@@ -1827,6 +1916,22 @@ void cProtocol_1_8_0::CompressPacket(CircularBufferCompressor & a_Packet, Contig
 
 
 
+void cProtocol_1_8_0::FramePacket(const ContiguousByteBufferView a_Packet, ContiguousByteBuffer & a_Framed)
+{
+	const auto PacketSize = static_cast<UInt32>(a_Packet.size());
+
+	cByteBuffer LengthHeaderBuffer(cByteBuffer::GetVarIntSize(PacketSize));
+	LengthHeaderBuffer.WriteVarInt32(PacketSize);
+	LengthHeaderBuffer.ReadAll(a_Framed);
+
+	a_Framed.reserve(a_Framed.size() + a_Packet.size());
+	a_Framed += a_Packet;
+}
+
+
+
+
+
 eBlockFace cProtocol_1_8_0::FaceIntToBlockFace(const Int32 a_BlockFace)
 {
 	// Normalize the blockface values returned from the protocol
@@ -1938,6 +2043,70 @@ UInt32 cProtocol_1_8_0::GetPacketID(ePacketType a_PacketType) const
 
 
 
+cProtocol::ePacketPriority cProtocol_1_8_0::GetPacketPriority(ePacketType a_PacketType)
+{
+	switch (a_PacketType)
+	{
+		// Packets referring to an entity; the client ignores them unless the entity has been spawned first:
+		case pktAttachEntity:
+		case pktCameraSetTo:
+		case pktCollectEntity:
+		case pktDestroyEntity:
+		case pktEntityAnimation:
+		case pktEntityEffect:
+		case pktEntityEquipment:
+		case pktEntityHeadLook:
+		case pktEntityLook:
+		case pktEntityMeta:
+		case pktEntityProperties:
+		case pktEntityRelMove:
+		case pktEntityRelMoveLook:
+		case pktEntityStatus:
+		case pktEntityVelocity:
+		case pktLeashEntity:
+		case pktRemoveEntityEffect:
+		case pktTeleportEntity:
+		case pktUseBed:
+		{
+			return ePacketPriority::Entity;
+		}
+
+		// Spawning the entities; the chunk sender spawns the entities right after their chunk, they mustn't overtake it:
+		case pktSpawnExperienceOrb:
+		case pktSpawnGlobalEntity:
+		case pktSpawnMob:
+		case pktSpawnObject:
+		case pktSpawnOtherPlayer:
+		case pktSpawnPainting:
+		{
+			return ePacketPriority::EntitySpawn;
+		}
+
+		// Packets referring to the blocks; they must follow the chunk data they modify:
+		case pktBlockAction:
+		case pktBlockBreakAnim:
+		case pktBlockChange:
+		case pktBlockChanges:
+		case pktExplosion:
+		case pktMapData:
+		case pktUnloadChunk:
+		case pktUpdateBlockEntity:
+		case pktUpdateSign:
+		{
+			return ePacketPriority::Chunk;
+		}
+
+		default:
+		{
+			return ePacketPriority::Critical;
+		}
+	}
+}
+
+
+
+
+
 unsigned char cProtocol_1_8_0::GetProtocolEntityAnimation(const EntityAnimation a_Animation) const
 {
 	switch (a_Animation)
@@ -3002,24 +3171,20 @@ void cProtocol_1_8_0::SendEntitySpawn(const cEntity & a_Entity, const UInt8 a_Ob
 
 
 
-void cProtocol_1_8_0::SendData(ContiguousByteBufferView a_Data)
+void cProtocol_1_8_0::SendData(ContiguousByteBufferView a_Data, ePacketPriority a_Priority)
 {
-	if (m_IsEncrypted)
-	{
-		std::byte Encrypted[8 KiB];  // Larger buffer, we may be sending lots of data (chunks)
+	m_Client->SendData(a_Data, a_Priority);
+}
 
-		while (a_Data.size() > 0)
-		{
-			const auto NumBytes = (a_Data.size() > sizeof(Encrypted)) ? sizeof(Encrypted) : a_Data.size();
-			m_Encryptor.ProcessData(Encrypted, a_Data.data(), NumBytes);
-			m_Client->SendData({ Encrypted, NumBytes });
 
-			a_Data = a_Data.substr(NumBytes);
-		}
-	}
-	else
+
+
+
+void cProtocol_1_8_0::EncryptOutgoingData(ContiguousByteBuffer & a_Data)
+{
+	if (m_IsEncrypted)
 	{
-		m_Client->SendData(a_Data);
+		m_Encryptor.ProcessData(a_Data.data(), a_Data.data(), a_Data.size());
 	}
 }
 
@@ -3035,33 +3200,43 @@ void cProtocol_1_8_0::SendPacket(cPacketizer & a_Pkt)
 	m_OutPacketBuffer.CommitRead();
 
 	const auto PacketData = m_Compressor.GetView();
+	auto & Policy = cRoot::Get()->GetServer()->GetCompressionPolicy();
+	ContiguousByteBuffer FramedPacket;
 
-	if (m_State == 3)
+	if (m_IsCompressionEnabled)
 	{
-		ContiguousByteBuffer CompressedPacket;
-
-		// Compress the packet payload:
-		cProtocol_1_8_0::CompressPacket(m_Compressor, CompressedPacket);
-
-		// Send the packet's payload compressed:
-		SendData(CompressedPacket);
+		// Compress the packet payload, unless the connection is tuned not to; measure the time spent on it:
+		const auto Start = std::chrono::steady_clock::now();
+		const auto Threshold = (m_CompressionLevel == cCompressionPolicy::LevelStored) ? std::numeric_limits<UInt32>::max() : Policy.GetThreshold();
+		cProtocol_1_8_0::CompressPacket(m_Compressor, FramedPacket, Threshold);
+		if (PacketData.size() >= Policy.GetThreshold())
+		{
+			const auto End = std::chrono::steady_clock::now();
+			m_CompressionTime += End - Start;
+			Policy.AddStats(m_CompressionLevel, PacketData.size(), FramedPacket.size(), End - Start);
+			if (End - m_CompressionPeriodStart >= CompressionTuningPeriod)
+			{
+				TuneCompression(End);
+			}
+		}
 	}
 	else
 	{
-		// Compression doesn't apply to this state, send raw data:
-		m_OutPacketLenBuffer.WriteVarInt32(static_cast<UInt32>(PacketData.size()));
-		ContiguousByteBuffer LengthData;
-		m_OutPacketLenBuffer.ReadAll(LengthData);
-		m_OutPacketLenBuffer.CommitRead();
-		SendData(LengthData);
-
-		// Send the packet's payload directly:
-		SendData(PacketData);
+		// Compression doesn't apply to this state or connection, send raw data:
+		cProtocol_1_8_0::FramePacket(PacketData, FramedPacket);
+		if ((m_State == State::Game) && (PacketData.size() >= Policy.GetThreshold()))
+		{
+			Policy.AddUncompressedStats(PacketData.size());
+		}
 	}
 
+	// Only the game packets may be reordered by their priority, the login must go out in order:
+	SendData(FramedPacket, (m_State == State::Game) ? GetPacketPriority(a_Pkt.GetPacketType()) : ePacketPriority::Critical);
+
 	// Log the comm into logfile:
 	if (g_ShouldLogCommOut && m_CommLogFile.IsOpen())
 	{
+		cCSLock Lock(m_CSCommLog);
 		AString Hex;
 		ASSERT(PacketData.size() > 0);
 		CreateHexDump(Hex, PacketData.data(), PacketData.size(), 16);
@@ -3798,6 +3973,7 @@ void cProtocol_1_8_0::AddReceivedData(cByteBuffer & a_Buffer, const ContiguousBy
 	// Write the incoming data into the comm log file:
 	if (g_ShouldLogCommIn && m_CommLogFile.IsOpen())
 	{
+		cCSLock Lock(m_CSCommLog);
 		if (a_Buffer.GetReadableSpace() > 0)
 		{
 			ContiguousByteBuffer AllData;
@@ -3822,8 +3998,8 @@ void cProtocol_1_8_0::AddReceivedData(cByteBuffer & a_Buffer, const ContiguousBy
 
 	if (!a_Buffer.Write(a_Data.data(), a_Data.size()))
 	{
-		// Too much data in the incoming queue, report to caller:
-		m_Client->PacketBufferFull();
+		// Too much data in the incoming queue, report to the tick thread:
+		m_DecodedPackets.SetQueueFull();
 		return;
 	}
 
@@ -3845,14 +4021,14 @@ void cProtocol_1_8_0::AddReceivedData(cByteBuffer & a_Buffer, const ContiguousBy
 		}
 
 		// Check packet for compression:
-		if (m_State == 3)
+		if (m_IsCompressionEnabled)
 		{
 			UInt32 NumBytesRead = static_cast<UInt32>(a_Buffer.GetReadableSpace());
 
 			UInt32 UncompressedSize;
 			if (!a_Buffer.ReadVarInt(UncompressedSize))
 			{
-				m_Client->Kick("Compression packet incomplete");
+				m_DecodedPackets.SetMalformed("Compression packet incomplete");
 				return;
 			}
 
@@ -3867,30 +4043,30 @@ void cProtocol_1_8_0::AddReceivedData(cByteBuffer & a_Buffer, const ContiguousBy
 				a_Buffer.CommitRead();
 
 				const auto UncompressedData = m_Extractor.Extract(UncompressedSize);
-				const auto Uncompressed = UncompressedData.GetView();
-				cByteBuffer bb(Uncompressed.size());
 
-				// Compression was used, move the uncompressed data:
-				VERIFY(bb.Write(Uncompressed.data(), Uncompressed.size()));
-
-				HandlePacket(bb);
+				// Compression was used, queue the uncompressed data:
+				if (!QueueDecodedPacket(UncompressedData.GetView()))
+				{
+					return;
+				}
 				continue;
 			}
 		}
 
-		// Move the packet payload to a separate cByteBuffer, bb:
-		cByteBuffer bb(PacketLen);
-
-		// No compression was used, move directly:
-		VERIFY(a_Buffer.ReadToByteBuffer(bb, static_cast<size_t>(PacketLen)));
+		// No compression was used, queue the packet payload directly:
+		VERIFY(a_Buffer.ReadSome(m_PacketPayload, static_cast<size_t>(PacketLen)));
 		a_Buffer.CommitRead();
 
-		HandlePacket(bb);
+		if (!QueueDecodedPacket(m_PacketPayload))
+		{
+			return;
+		}
 	}  // for (ever)
 
 	// Log any leftover bytes into the logfile:
 	if (g_ShouldLogCommIn && (a_Buffer.GetReadableSpace() > 0) && m_CommLogFile.IsOpen())
 	{
+		cCSLock Lock(m_CSCommLog);
 		ContiguousByteBuffer AllData;
 		size_t OldReadableSpace = a_Buffer.GetReadableSpace();
 		a_Buffer.ReadAll(AllData);
@@ -3910,6 +4086,20 @@ void cProtocol_1_8_0::AddReceivedData(cByteBuffer & a_Buffer, const ContiguousBy
 
 
 
+bool cProtocol_1_8_0::QueueDecodedPacket(const ContiguousByteBufferView a_Packet)
+{
+	if (!m_DecodedPackets.Push(a_Packet))
+	{
+		return false;
+	}
+	PacketsReceivedMetric.Add();
+	return true;
+}
+
+
+
+
+
 UInt8 cProtocol_1_8_0::GetProtocolEntityType(const cEntity & a_Entity)
 {
 	using Type = cEntity::eEntityType;
@@ -4144,6 +4334,7 @@ void cProtocol_1_8_0::HandlePacket(cByteBuffer & a_Buffer)
 	// Log the packet info into the comm log file:
 	if (g_ShouldLogCommIn && m_CommLogFile.IsOpen())
 	{
+		cCSLock Lock(m_CSCommLog);
 		ContiguousByteBuffer PacketData;
 		a_Buffer.ReadAll(PacketData);
 		a_Buffer.ResetRead();
@@ -4176,6 +4367,7 @@ void cProtocol_1_8_0::HandlePacket(cByteBuffer & a_Buffer)
 		// Put a message in the comm log:
 		if (g_ShouldLogCommIn && m_CommLogFile.IsOpen())
 		{
+			cCSLock Lock(m_CSCommLog);
 			m_CommLogFile.Printf("^^^^^^ Unhandled packet ^^^^^^\n\n\n");
 		}
 
@@ -4193,6 +4385,7 @@ void cProtocol_1_8_0::HandlePacket(cByteBuffer & a_Buffer)
 		// Put a message in the comm log:
 		if (g_ShouldLogCommIn && m_CommLogFile.IsOpen())
 		{
+			cCSLock Lock(m_CSCommLog);
 			m_CommLogFile.Printf("^^^^^^ Wrong number of bytes read for this packet (exp %d left, got %zu left) ^^^^^^\n\n\n",
 				1, a_Buffer.GetReadableSpace()
 			);
@@ -4224,8 +4417,37 @@ void cProtocol_1_8_0::SendEntityTeleport(const cEntity & a_Entity)
 
 
 
+void cProtocol_1_8_0::TuneCompression(const std::chrono::steady_clock::time_point a_Now)
+{
+	const auto Period = std::chrono::duration<double>(a_Now - m_CompressionPeriodStart).count();
+	const auto CPUShare = std::chrono::duration<double>(m_CompressionTime).count() / Period;
+	m_CompressionTime = {};
+	m_CompressionPeriodStart = a_Now;
+
+	const auto Stats = m_Client->GetOutgoingStats();
+	const bool IsLinkIdle = (Stats.m_LinkQueueSize == 0) && (Stats.m_NumQueuedBytes[static_cast<size_t>(ePacketPriority::Chunk)] == 0);
+	const auto Level = cRoot::Get()->GetServer()->GetCompressionPolicy().TuneLevel(m_CompressionLevel, CPUShare, m_Client->IsOutgoingCongested(), IsLinkIdle);
+	if (Level == m_CompressionLevel)
+	{
+		return;
+	}
+
+	m_CompressionLevel = Level;
+	if (Level != cCompressionPolicy::LevelStored)
+	{
+		m_Compressor.SetCompressionFactor(Level);
+	}
+}
+
+
+
+
+
 void cProtocol_1_8_0::StartEncryption(const Byte * a_Key)
 {
+	// The data queued so far was composed before the encryption was negotiated, send it out as plaintext:
+	m_Client->ProcessProtocolOut();
+
 	m_Encryptor.Init(a_Key, a_Key);
 	m_Decryptor.Init(a_Key, a_Key);
 	m_IsEncrypted = true;
@@ -21,6 +21,7 @@ Declares the 1.8 protocol classes:
 #include "../mbedTLS++/AesCfb128Encryptor.h"
 
 #include "CircularBufferCompressor.h"
+#include "DecodedPacketQueue.h"
 #include "StringCompression.h"
 
 
@@ -40,6 +41,12 @@ public:
 	The protocol uses the provided buffers for storage and processing, and must have exclusive access to them. */
 	virtual void DataReceived(cByteBuffer & a_Buffer, ContiguousByteBuffer && a_Data) override;
 
+	virtual void DecodeReceivedData(cByteBuffer & a_Buffer, ContiguousByteBuffer && a_Data) override;
+	virtual void HandleDecodedPackets(void) override;
+	virtual bool CanDecodeOffTickThread(void) const override;
+	virtual bool IsCompressionEnabled(void) const override { return m_IsCompressionEnabled; }
+	virtual int GetCompressionLevel(void) const override { return m_CompressionLevel; }
+
 	/** Sending stuff to clients (alphabetically sorted): */
 	virtual void SendAttachEntity               (const cEntity & a_Entity, const cEntity & a_Vehicle) override;
 	virtual void SendBlockAction                (int a_BlockX, int a_BlockY, int a_BlockZ, char a_Byte1, char a_Byte2, BLOCKTYPE a_BlockType) override;
@@ -132,9 +139,16 @@ public:
 
 	virtual AString GetAuthServerID(void) override { return m_AuthServerID; }
 
+	virtual void EncryptOutgoingData(ContiguousByteBuffer & a_Data) override;
+
 	/** Compress the packet. a_Packet must be without packet length.
-	a_Compressed will be set to the compressed packet includes packet length and data length. */
-	static void CompressPacket(CircularBufferCompressor & a_Packet, ContiguousByteBuffer & a_Compressed);
+	a_Compressed will be set to the compressed packet includes packet length and data length.
+	Packets smaller than a_Threshold are stored uncompressed, with the data length of zero. */
+	static void CompressPacket(CircularBufferCompressor & a_Packet, ContiguousByteBuffer & a_Compressed, UInt32 a_Threshold);
+
+	/** Frames the packet for a connection not using compression. a_Packet must be without packet length.
+	a_Framed will be set to the packet length followed by a_Packet. */
+	static void FramePacket(ContiguousByteBufferView a_Packet, ContiguousByteBuffer & a_Framed);
 
 protected:
 
@@ -148,6 +162,9 @@ protected:
 	/** Get the packet ID for a given packet. */
 	virtual UInt32 GetPacketID(ePacketType a_Packet) const override;
 
+	/** Returns the class in which the packet is queued for sending in the game state. */
+	static ePacketPriority GetPacketPriority(ePacketType a_Packet);
+
 	/** Converts an animation into an ID suitable for use with the Entity Animation packet.
 	Returns (uchar)-1 if the protocol version doesn't support this animation. */
 	virtual unsigned char GetProtocolEntityAnimation(EntityAnimation a_Animation) const;
@@ -216,8 +233,8 @@ protected:
 	/** Sends the entity type and entity-dependent data required for the entity to initially spawn. */
 	virtual void SendEntitySpawn(const cEntity & a_Entity, const UInt8 a_ObjectType, const Int32 a_ObjectData);
 
-	/** Sends the data to the client, encrypting them if needed. */
-	virtual void SendData(ContiguousByteBufferView a_Size) override;
+	/** Queues the data in the client handle, to be encrypted, if needed, once it is sent out. */
+	virtual void SendData(ContiguousByteBufferView a_Data, ePacketPriority a_Priority) override;
 
 	/** Sends the packet to the client. Called by the cPacketizer's destructor. */
 	virtual void SendPacket(cPacketizer & a_Packet) override;
@@ -245,18 +262,48 @@ private:
 
 	bool m_IsEncrypted;
 
+	/** True if the policy allows compression for the client's connection, decided by the address of the connection's remote end. */
+	bool m_IsCompressionAllowed;
+
+	/** True once the client has been sent the compression threshold; from then on the packets use the compressed framing. */
+	bool m_IsCompressionEnabled;
+
+	/** The compression level currently used for the connection, retuned by TuneCompression().
+	Atomic, because the chunk sender reads it to pick the chunk data compressed at the same level. */
+	std::atomic<int> m_CompressionLevel;
+
+	/** The time spent compressing the packets in the current tuning period. */
+	std::chrono::steady_clock::duration m_CompressionTime;
+
+	/** The start of the current tuning period. */
+	std::chrono::steady_clock::time_point m_CompressionPeriodStart;
+
 	cAesCfb128Decryptor m_Decryptor;
 	cAesCfb128Encryptor m_Encryptor;
 
 	CircularBufferCompressor m_Compressor;
 	CircularBufferExtractor m_Extractor;
 
+	/** Protects m_CommLogFile, which is written by the network thread decoding the received data, as well as by the threads sending and handling the packets. */
+	cCriticalSection m_CSCommLog;
+
 	/** The logfile where the comm is logged, when g_ShouldLogComm is true */
 	cFile m_CommLogFile;
 
-	/** Adds the received (unencrypted) data to m_ReceivedData, parses complete packets */
+	/** The packets framed and decompressed by AddReceivedData(), waiting to be handled by HandleDecodedPackets().
+	Also carries the decoding errors over to the tick thread. */
+	cDecodedPacketQueue m_DecodedPackets;
+
+	/** The payload of the uncompressed packet being framed, kept to reuse its memory. */
+	ContiguousByteBuffer m_PacketPayload;
+
+	/** Adds the received (unencrypted) data to a_Buffer, moves the complete packets into m_DecodedPackets, decompressing them if needed.
+	Doesn't act on the client, the errors are recorded in m_DecodedPackets and reported by HandleDecodedPackets() on the tick thread. */
 	void AddReceivedData(cByteBuffer & a_Buffer, ContiguousByteBufferView a_Data);
 
+	/** Appends the packet to m_DecodedPackets. Returns false if it wasn't queued, the error is then recorded in the queue. */
+	bool QueueDecodedPacket(ContiguousByteBufferView a_Packet);
+
 	/** Converts an entity to a protocol-specific entity type.
 	Only entities that the Send Spawn Entity packet supports are valid inputs to this method */
 	static UInt8 GetProtocolEntityType(const cEntity & a_Entity);
@@ -278,4 +325,7 @@ private:
 	void SendEntityTeleport(const cEntity & a_Entity);
 
 	void StartEncryption(const Byte * a_Key);
+
+	/** Retunes the compression level at the end of a tuning period, based on the time spent compressing and the state of the client's link. */
+	void TuneCompression(std::chrono::steady_clock::time_point a_Now);
 } ;
@@ -5,8 +5,180 @@
 
 #include "Globals.h"
 #include "RankManager.h"
+#include "SQLiteCpp/Statement.h"
+#include "SQLiteCpp/Transaction.h"
 #include "Protocol/MojangAPI.h"
-#include "ClientHandle.h"
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cRankManager::cDBWriter:
+
+cRankManager::cDBWriter::cDBWriter(cRankManager & a_RankManager) :
+	Super("Rank DB Writer"),
+	m_RankManager(a_RankManager),
+	m_HasFailedWrites(false),
+	m_NeedsReload(false)
+{
+}
+
+
+
+
+
+cRankManager::cDBWriter::~cDBWriter()
+{
+	Stop();
+
+	// Write anything that has been queued after the thread has finished:
+	ExecuteBatch();
+}
+
+
+
+
+
+void cRankManager::cDBWriter::Queue(cDBWrite && a_Write)
+{
+	{
+		cCSLock Lock(m_CSQueue);
+		m_Queue.push_back(std::move(a_Write));
+	}
+	m_Event.Set();
+}
+
+
+
+
+
+void cRankManager::cDBWriter::ExecuteBatch(void)
+{
+	{
+		cCSLock ExecuteLock(m_CSExecute);
+		if (WriteQueued())
+		{
+			return;
+		}
+		m_HasFailedWrites = true;
+		m_NeedsReload = true;
+	}
+	ReloadIfNeeded();
+}
+
+
+
+
+
+bool cRankManager::cDBWriter::Flush(void)
+{
+	ExecuteBatch();
+
+	// If the writer thread has failed a write, wait for it to reload the model, or reload it here:
+	ReloadIfNeeded();
+
+	cCSLock ExecuteLock(m_CSExecute);
+	bool HasFailedWrites = m_HasFailedWrites;
+	m_HasFailedWrites = false;
+	return !HasFailedWrites;
+}
+
+
+
+
+
+void cRankManager::cDBWriter::Stop(void)
+{
+	m_ShouldTerminate = true;
+	m_Event.Set();
+	Super::Stop();
+}
+
+
+
+
+
+void cRankManager::cDBWriter::Execute(void)
+{
+	while (!m_ShouldTerminate)
+	{
+		m_Event.Wait();
+		ExecuteBatch();
+	}
+}
+
+
+
+
+
+void cRankManager::cDBWriter::ReloadIfNeeded(void)
+{
+	// The model is locked first, so that no other thread changes it and queues more writes meanwhile:
+	cCSLock Lock(m_RankManager.m_CS);
+	cCSLock ExecuteLock(m_CSExecute);
+	if (!m_NeedsReload)
+	{
+		return;
+	}
+
+	// Write whatever has been queued since the failure, then replace the model with what the DB really contains:
+	if (!WriteQueued())
+	{
+		m_HasFailedWrites = true;
+	}
+	m_RankManager.LoadFromDB();
+	m_NeedsReload = false;
+}
+
+
+
+
+
+bool cRankManager::cDBWriter::WriteQueued(void)
+{
+	// Take everything that has been queued so far:
+	std::vector<cDBWrite> Writes;
+	{
+		cCSLock Lock(m_CSQueue);
+		std::swap(Writes, m_Queue);
+	}
+	if (Writes.empty())
+	{
+		return true;
+	}
+
+	// Execute all the writes in a single transaction, each in its own savepoint, so that a failed write is undone
+	// completely, without affecting the others:
+	auto & DB = m_RankManager.m_DB;
+	size_t NumFailed = 0;
+	try
+	{
+		SQLite::Transaction Transaction(DB);
+		for (auto & Write: Writes)
+		{
+			DB.exec("SAVEPOINT RankWrite");
+			try
+			{
+				Write(DB);
+			}
+			catch (const SQLite::Exception & ex)
+			{
+				LOGWARNING("%s: Failed to write rank data to the DB, reverting the change: %s", __FUNCTION__, ex.what());
+				DB.exec("ROLLBACK TO RankWrite");
+				NumFailed += 1;
+			}
+			DB.exec("RELEASE RankWrite");
+		}
+		Transaction.commit();
+	}
+	catch (const SQLite::Exception & ex)
+	{
+		LOGWARNING("%s: Failed to commit %zu rank data changes to the DB, reverting them: %s", __FUNCTION__, Writes.size(), ex.what());
+		return false;
+	}
+	return (NumFailed == 0);
+}
 
 
 
@@ -15,8 +187,11 @@
 ////////////////////////////////////////////////////////////////////////////////
 // cRankManager:
 
-cRankManager::cRankManager(void) :
-	m_DB("Ranks.sqlite", SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE),
+cRankManager::cRankManager(const AString & a_DBFileName) :
+	m_DB(a_DBFileName, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE),
+	m_NextRankID(1),
+	m_NextGroupID(1),
+	m_DBWriter(*this),
 	m_IsInitialized(false),
 	m_MojangAPI(nullptr)
 {
@@ -51,41 +226,38 @@ void cRankManager::Initialize(cMojangAPI & a_MojangAPI)
 	m_DB.exec("CREATE TABLE IF NOT EXISTS RestrictionItem (PermGroupID INTEGER, Permission)");
 	m_DB.exec("CREATE TABLE IF NOT EXISTS DefaultRank (RankID INTEGER)");
 
+	// The writer looks up players by their UUID when updating their rank:
+	m_DB.exec("CREATE INDEX IF NOT EXISTS PlayerRankUUID ON PlayerRank (PlayerUUID)");
+
 	m_IsInitialized = true;
 
+	m_MojangAPI = &a_MojangAPI;
 	a_MojangAPI.SetRankManager(this);
 
-	// If tables are empty, create default ranks
+	// If tables are empty, create default ranks, otherwise load everything into memory:
 	if (AreDBTablesEmpty())
 	{
 		LOGINFO("Creating default ranks...");
 		CreateDefaults();
 		LOGINFO("Default ranks created.");
 	}
-
-	// Load the default rank:
-	try
-	{
-		SQLite::Statement stmt(m_DB,
-			"SELECT Rank.Name FROM Rank "
-			"LEFT JOIN DefaultRank ON Rank.RankID = DefaultRank.RankID"
-		);
-		if (stmt.executeStep())
-		{
-			m_DefaultRank = stmt.getColumn(0).getText();
-		}
-	}
-	catch (const SQLite::Exception & ex)
+	else
 	{
-		LOGWARNING("%s: Cannot load default rank: %s", __FUNCTION__, ex.what());
-		return;
+		LoadFromDB();
 	}
 
 	// If the default rank cannot be loaded, use the first rank:
 	if (m_DefaultRank.empty())
 	{
-		SetDefaultRank(GetAllRanks()[0]);
+		auto Ranks = GetAllRanks();
+		if (!Ranks.empty())
+		{
+			SetDefaultRank(Ranks[0]);
+		}
 	}
+
+	// From now on, the DB is written only by the writer thread:
+	m_DBWriter.Start();
 }
 
 
@@ -97,23 +269,12 @@ AString cRankManager::GetPlayerRankName(const cUUID & a_PlayerUUID)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
-	{
-		SQLite::Statement stmt(m_DB, "SELECT Rank.Name FROM Rank LEFT JOIN PlayerRank ON Rank.RankID = PlayerRank.RankID WHERE PlayerRank.PlayerUUID = ?");
-		stmt.bind(1, a_PlayerUUID.ToShortString());
-		// executeStep returns false on no data
-		if (!stmt.executeStep())
-		{
-			// No data returned from the DB
-			return AString();
-		}
-		return stmt.getColumn(0).getText();
-	}
-	catch (const SQLite::Exception & ex)
+	auto itr = m_Players.find(a_PlayerUUID);
+	if (itr == m_Players.end())
 	{
-		LOGWARNING("%s: Cannot get player rank name: %s", __FUNCTION__, ex.what());
+		return AString();
 	}
-	return AString();
+	return itr->second.m_RankName;
 }
 
 
@@ -125,22 +286,12 @@ AString cRankManager::GetPlayerName(const cUUID & a_PlayerUUID)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
-	{
-		// Prepare the DB statement:
-		SQLite::Statement stmt(m_DB, "SELECT PlayerName FROM PlayerRank WHERE PlayerUUID = ?");
-		stmt.bind(1, a_PlayerUUID.ToShortString());
-
-		if (stmt.executeStep())
-		{
-			return stmt.getColumn(0).getText();
-		}
-	}
-	catch (SQLite::Exception & ex)
+	auto itr = m_Players.find(a_PlayerUUID);
+	if (itr == m_Players.end())
 	{
-		LOGWARNING("%s: Cannot get player name: %s", __FUNCTION__, ex.what());
+		return AString();
 	}
-	return AString();
+	return itr->second.m_Name;
 }
 
 
@@ -152,29 +303,17 @@ AStringVector cRankManager::GetPlayerGroups(const cUUID & a_PlayerUUID)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	AStringVector res;
-	try
+	auto itr = m_Players.find(a_PlayerUUID);
+	if (itr == m_Players.end())
 	{
-		// Prepare the DB statement:
-		SQLite::Statement stmt(m_DB,
-			"SELECT PermGroup.Name FROM PermGroup "
-				"LEFT JOIN RankPermGroup ON PermGroup.PermGroupID = RankPermGroup.PermGroupID "
-				"LEFT JOIN PlayerRank ON PlayerRank.RankID = RankPermGroup.RankID "
-			"WHERE PlayerRank.PlayerUUID = ?"
-		);
-		stmt.bind(1, a_PlayerUUID.ToShortString());
-
-		// Execute and get results:
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
+		return AStringVector();
 	}
-	catch (const SQLite::Exception & ex)
+	auto Rank = FindRank(itr->second.m_RankName);
+	if (Rank == nullptr)
 	{
-		LOGWARNING("%s: Cannot get player groups: %s", __FUNCTION__, ex.what());
+		return AStringVector();
 	}
-	return res;
+	return Rank->m_Groups;
 }
 
 
@@ -183,12 +322,12 @@ AStringVector cRankManager::GetPlayerGroups(const cUUID & a_PlayerUUID)
 
 AStringVector cRankManager::GetPlayerPermissions(const cUUID & a_PlayerUUID)
 {
-	AString Rank = GetPlayerRankName(a_PlayerUUID);
-	if (Rank.empty())
-	{
-		Rank = m_DefaultRank;
-	}
-	return GetRankPermissions(Rank);
+	ASSERT(m_IsInitialized);
+	cCSLock Lock(m_CS);
+
+	AStringVector res;
+	AppendRankItems(GetEffectiveRankName(a_PlayerUUID), false, res);
+	return res;
 }
 
 
@@ -197,12 +336,12 @@ AStringVector cRankManager::GetPlayerPermissions(const cUUID & a_PlayerUUID)
 
 AStringVector cRankManager::GetPlayerRestrictions(const cUUID & a_PlayerUUID)
 {
-	AString Rank = GetPlayerRankName(a_PlayerUUID);
-	if (Rank.empty())
-	{
-		Rank = m_DefaultRank;
-	}
-	return GetRankRestrictions(Rank);
+	ASSERT(m_IsInitialized);
+	cCSLock Lock(m_CS);
+
+	AStringVector res;
+	AppendRankItems(GetEffectiveRankName(a_PlayerUUID), true, res);
+	return res;
 }
 
 
@@ -214,26 +353,12 @@ AStringVector cRankManager::GetRankGroups(const AString & a_RankName)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	AStringVector res;
-	try
-	{
-		SQLite::Statement stmt(m_DB,
-			"SELECT PermGroup.Name FROM PermGroup "
-				"LEFT JOIN RankPermGroup ON RankPermGroup.PermGroupID = PermGroup.PermGroupID "
-				"LEFT JOIN Rank ON Rank.RankID = RankPermGroup.RankID "
-			"WHERE Rank.Name = ?"
-		);
-		stmt.bind(1, a_RankName);
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
-	}
-	catch (const SQLite::Exception & ex)
+	auto Rank = FindRank(a_RankName);
+	if (Rank == nullptr)
 	{
-		LOGWARNING("%s: Failed to get rank groups from DB: %s", __FUNCTION__, ex.what());
+		return AStringVector();
 	}
-	return res;
+	return Rank->m_Groups;
 }
 
 
@@ -245,25 +370,12 @@ AStringVector cRankManager::GetGroupPermissions(const AString & a_GroupName)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	AStringVector res;
-	try
-	{
-		SQLite::Statement stmt(m_DB,
-			"SELECT PermissionItem.Permission FROM PermissionItem "
-				"LEFT JOIN PermGroup ON PermGroup.PermGroupID = PermissionItem.PermGroupID "
-			"WHERE PermGroup.Name = ?"
-		);
-		stmt.bind(1, a_GroupName);
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
-	}
-	catch (const SQLite::Exception & ex)
+	auto Group = FindGroup(a_GroupName);
+	if (Group == nullptr)
 	{
-		LOGWARNING("%s: Failed to get group permissions from DB: %s", __FUNCTION__, ex.what());
+		return AStringVector();
 	}
-	return res;
+	return Group->m_Permissions;
 }
 
 
@@ -275,25 +387,12 @@ AStringVector cRankManager::GetGroupRestrictions(const AString & a_GroupName)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	AStringVector res;
-	try
-	{
-		SQLite::Statement stmt(m_DB,
-			"SELECT RestrictionItem.Permission FROM RestrictionItem "
-				"LEFT JOIN PermGroup ON PermGroup.PermGroupID = RestrictionItem.PermGroupID "
-			"WHERE PermGroup.Name = ?"
-		);
-		stmt.bind(1, a_GroupName);
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
-	}
-	catch (const SQLite::Exception & ex)
+	auto Group = FindGroup(a_GroupName);
+	if (Group == nullptr)
 	{
-		LOGWARNING("%s: Failed to get group restrictions from DB: %s", __FUNCTION__, ex.what());
+		return AStringVector();
 	}
-	return res;
+	return Group->m_Restrictions;
 }
 
 
@@ -306,24 +405,7 @@ AStringVector cRankManager::GetRankPermissions(const AString & a_RankName)
 	cCSLock Lock(m_CS);
 
 	AStringVector res;
-	try
-	{
-		SQLite::Statement stmt(m_DB,
-			"SELECT PermissionItem.Permission FROM PermissionItem "
-				"LEFT JOIN RankPermGroup ON RankPermGroup.PermGroupID = PermissionItem.PermGroupID "
-				"LEFT JOIN Rank ON Rank.RankID = RankPermGroup.RankID "
-			"WHERE Rank.Name = ?"
-		);
-		stmt.bind(1, a_RankName);
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to get rank permissions from DB: %s", __FUNCTION__, ex.what());
-	}
+	AppendRankItems(a_RankName, false, res);
 	return res;
 }
 
@@ -337,24 +419,7 @@ AStringVector cRankManager::GetRankRestrictions(const AString & a_RankName)
 	cCSLock Lock(m_CS);
 
 	AStringVector res;
-	try
-	{
-		SQLite::Statement stmt(m_DB,
-			"SELECT RestrictionItem.Permission FROM RestrictionItem "
-				"LEFT JOIN RankPermGroup ON RankPermGroup.PermGroupID = RestrictionItem.PermGroupID "
-				"LEFT JOIN Rank ON Rank.RankID = RankPermGroup.RankID "
-			"WHERE Rank.Name = ?"
-		);
-		stmt.bind(1, a_RankName);
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to get rank restrictions from DB: %s", __FUNCTION__, ex.what());
-	}
+	AppendRankItems(a_RankName, true, res);
 	return res;
 }
 
@@ -367,24 +432,25 @@ std::vector<cUUID> cRankManager::GetAllPlayerUUIDs(void)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	cUUID tempUUID;
-	std::vector<cUUID> res;
-	try
+	// Sort the players by their name, case-insensitive:
+	std::vector<std::pair<const AString *, cUUID>> Players;
+	Players.reserve(m_Players.size());
+	for (const auto & Player: m_Players)
 	{
-		SQLite::Statement stmt(m_DB, "SELECT PlayerUUID FROM PlayerRank ORDER BY PlayerName COLLATE NOCASE");
-		while (stmt.executeStep())
+		Players.emplace_back(&Player.second.m_Name, Player.first);
+	}
+	std::stable_sort(Players.begin(), Players.end(),
+		[](const std::pair<const AString *, cUUID> & a_First, const std::pair<const AString *, cUUID> & a_Second)
 		{
-			if (!tempUUID.FromString(stmt.getColumn(0).getText()))
-			{
-				// Invalid UUID, ignore
-				continue;
-			}
-			res.push_back(tempUUID);
+			return (NoCaseCompare(*a_First.first, *a_Second.first) < 0);
 		}
-	}
-	catch (const SQLite::Exception & ex)
+	);
+
+	std::vector<cUUID> res;
+	res.reserve(Players.size());
+	for (const auto & Player: Players)
 	{
-		LOGWARNING("%s: Failed to get players from DB: %s", __FUNCTION__, ex.what());
+		res.push_back(Player.second);
 	}
 	return res;
 }
@@ -398,18 +464,20 @@ AStringVector cRankManager::GetAllRanks(void)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	AStringVector res;
-	try
+	// Return the ranks in the order in which they were created:
+	std::vector<std::pair<int, const AString *>> Ranks;
+	Ranks.reserve(m_Ranks.size());
+	for (const auto & Rank: m_Ranks)
 	{
-		SQLite::Statement stmt(m_DB, "SELECT Name FROM Rank");
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
+		Ranks.emplace_back(Rank.second.m_ID, &Rank.first);
 	}
-	catch (const SQLite::Exception & ex)
+	std::sort(Ranks.begin(), Ranks.end());
+
+	AStringVector res;
+	res.reserve(Ranks.size());
+	for (const auto & Rank: Ranks)
 	{
-		LOGWARNING("%s: Failed to get ranks from DB: %s", __FUNCTION__, ex.what());
+		res.push_back(*Rank.second);
 	}
 	return res;
 }
@@ -423,18 +491,20 @@ AStringVector cRankManager::GetAllGroups(void)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	AStringVector res;
-	try
+	// Return the groups in the order in which they were created:
+	std::vector<std::pair<int, const AString *>> Groups;
+	Groups.reserve(m_Groups.size());
+	for (const auto & Group: m_Groups)
 	{
-		SQLite::Statement stmt(m_DB, "SELECT Name FROM PermGroup");
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
+		Groups.emplace_back(Group.second.m_ID, &Group.first);
 	}
-	catch (const SQLite::Exception & ex)
+	std::sort(Groups.begin(), Groups.end());
+
+	AStringVector res;
+	res.reserve(Groups.size());
+	for (const auto & Group: Groups)
 	{
-		LOGWARNING("%s: Failed to get groups from DB: %s", __FUNCTION__, ex.what());
+		res.push_back(*Group.second);
 	}
 	return res;
 }
@@ -448,20 +518,12 @@ AStringVector cRankManager::GetAllPermissions(void)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	AStringVector res;
-	try
+	std::set<AString> Permissions;
+	for (const auto & Group: m_Groups)
 	{
-		SQLite::Statement stmt(m_DB, "SELECT DISTINCT(Permission) FROM PermissionItem");
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to get permissions from DB: %s", __FUNCTION__, ex.what());
+		Permissions.insert(Group.second.m_Permissions.begin(), Group.second.m_Permissions.end());
 	}
-	return res;
+	return AStringVector(Permissions.begin(), Permissions.end());
 }
 
 
@@ -473,20 +535,12 @@ AStringVector cRankManager::GetAllRestrictions(void)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	AStringVector res;
-	try
+	std::set<AString> Restrictions;
+	for (const auto & Group: m_Groups)
 	{
-		SQLite::Statement stmt(m_DB, "SELECT DISTINCT(Permission) FROM RestrictionItem");
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to get restrictions from DB: %s", __FUNCTION__, ex.what());
+		Restrictions.insert(Group.second.m_Restrictions.begin(), Group.second.m_Restrictions.end());
 	}
-	return res;
+	return AStringVector(Restrictions.begin(), Restrictions.end());
 }
 
 
@@ -515,6 +569,9 @@ bool cRankManager::GetPlayerMsgVisuals(
 	AString & a_MsgNameColorCode
 )
 {
+	ASSERT(m_IsInitialized);
+	cCSLock Lock(m_CS);
+
 	AString Rank = GetPlayerRankName(a_PlayerUUID);
 	if (Rank.empty())
 	{
@@ -541,38 +598,26 @@ void cRankManager::AddRank(
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
+	// Check if such a rank name is already used:
+	if (FindRank(a_RankName) != nullptr)
 	{
-		// Check if such a rank name is already used:
-		{
-			SQLite::Statement stmt(m_DB, "SELECT COUNT(*) FROM Rank WHERE Name = ?");
-			stmt.bind(1, a_RankName);
-			if (stmt.executeStep())
-			{
-				if (stmt.getColumn(0).getInt() > 0)
-				{
-					// Rank already exists, do nothing:
-					return;
-				}
-			}
-		}
+		return;
+	}
 
-		// Insert a new rank:
-		SQLite::Statement stmt(m_DB, "INSERT INTO Rank (Name, MsgPrefix, MsgSuffix, MsgNameColorCode) VALUES (?, ?, ?, ?)");
-		stmt.bind(1, a_RankName);
-		stmt.bind(2, a_MsgPrefix);
-		stmt.bind(3, a_MsgSuffix);
-		stmt.bind(4, a_MsgNameColorCode);
-		if (stmt.exec() <= 0)
+	// Insert a new rank:
+	int RankID = m_NextRankID++;
+	m_Ranks[a_RankName] = sRank{RankID, a_MsgPrefix, a_MsgSuffix, a_MsgNameColorCode, {}};
+	m_DBWriter.Queue([=](SQLite::Database & a_DB)
 		{
-			LOGWARNING("%s: Failed to add a new rank \"%s\".", __FUNCTION__, a_RankName.c_str());
-			return;
+			SQLite::Statement stmt(a_DB, "INSERT INTO Rank (RankID, Name, MsgPrefix, MsgSuffix, MsgNameColorCode) VALUES (?, ?, ?, ?, ?)");
+			stmt.bind(1, RankID);
+			stmt.bind(2, a_RankName);
+			stmt.bind(3, a_MsgPrefix);
+			stmt.bind(4, a_MsgSuffix);
+			stmt.bind(5, a_MsgNameColorCode);
+			stmt.exec();
 		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to add a new rank \"%s\": %s", __FUNCTION__, a_RankName.c_str(), ex.what());
-	}
+	);
 }
 
 
@@ -584,35 +629,23 @@ void cRankManager::AddGroup(const AString & a_GroupName)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
+	// Check if such a group name is already used:
+	if (FindGroup(a_GroupName) != nullptr)
 	{
-		// Check if such a group name is already used:
-		{
-			SQLite::Statement stmt(m_DB, "SELECT COUNT(*) FROM PermGroup WHERE Name = ?");
-			stmt.bind(1, a_GroupName);
-			if (stmt.executeStep())
-			{
-				if (stmt.getColumn(0).getInt() > 0)
-				{
-					// Group already exists, do nothing:
-					return;
-				}
-			}
-		}
+		return;
+	}
 
-		// Insert a new group:
-		SQLite::Statement stmt(m_DB, "INSERT INTO PermGroup (Name) VALUES (?)");
-		stmt.bind(1, a_GroupName);
-		if (stmt.exec() <= 0)
+	// Insert a new group:
+	int GroupID = m_NextGroupID++;
+	m_Groups[a_GroupName] = sGroup{GroupID, {}, {}};
+	m_DBWriter.Queue([=](SQLite::Database & a_DB)
 		{
-			LOGWARNING("%s: Failed to add a new group \"%s\".", __FUNCTION__, a_GroupName.c_str());
-			return;
+			SQLite::Statement stmt(a_DB, "INSERT INTO PermGroup (PermGroupID, Name) VALUES (?, ?)");
+			stmt.bind(1, GroupID);
+			stmt.bind(2, a_GroupName);
+			stmt.exec();
 		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to add a new group \"%s\": %s", __FUNCTION__, a_GroupName.c_str(), ex.what());
-	}
+	);
 }
 
 
@@ -624,37 +657,9 @@ void cRankManager::AddGroups(const AStringVector & a_GroupNames)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
+	for (const auto & GroupName: a_GroupNames)
 	{
-		for (AStringVector::const_iterator itr = a_GroupNames.begin(), end = a_GroupNames.end(); itr != end; ++itr)
-		{
-			// Check if such the group name is already used:
-			{
-				SQLite::Statement stmt(m_DB, "SELECT COUNT(*) FROM PermGroup WHERE Name = ?");
-				stmt.bind(1, *itr);
-				if (stmt.executeStep())
-				{
-					if (stmt.getColumn(0).getInt() > 0)
-					{
-						// Group already exists, do nothing:
-						return;
-					}
-				}
-			}
-
-			// Insert a new group:
-			SQLite::Statement stmt(m_DB, "INSERT INTO PermGroup (Name) VALUES (?)");
-			stmt.bind(1, *itr);
-			if (stmt.exec() <= 0)
-			{
-				LOGWARNING("%s: Failed to add a new group \"%s\".", __FUNCTION__, itr->c_str());
-				return;
-			}
-		}  // for itr - a_GroupNames[]
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to add new groups: %s", __FUNCTION__, ex.what());
+		AddGroup(GroupName);
 	}
 }
 
@@ -667,73 +672,41 @@ bool cRankManager::AddGroupToRank(const AString & a_GroupName, const AString & a
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
+	auto Group = FindGroup(a_GroupName);
+	if (Group == nullptr)
 	{
-		// Get the group's ID:
-		int GroupID;
-		{
-			SQLite::Statement stmt(m_DB, "SELECT PermGroupID FROM PermGroup WHERE Name = ?");
-			stmt.bind(1, a_GroupName);
-			if (!stmt.executeStep())
-			{
-				LOGWARNING("%s: No such group (%s), aborting.", __FUNCTION__, a_GroupName.c_str());
-				return false;
-			}
-			GroupID = stmt.getColumn(0);
-		}
-
-		// Get the rank's ID:
-		int RankID;
-		{
-			SQLite::Statement stmt(m_DB, "SELECT RankID FROM Rank WHERE Name = ?");
-			stmt.bind(1, a_RankName);
-			if (!stmt.executeStep())
-			{
-				LOGWARNING("%s: No such rank (%s), aborting.", __FUNCTION__, a_RankName.c_str());
-				return false;
-			}
-			RankID = stmt.getColumn(0);
-		}
+		LOGWARNING("%s: No such group (%s), aborting.", __FUNCTION__, a_GroupName.c_str());
+		return false;
+	}
+	auto Rank = FindRank(a_RankName);
+	if (Rank == nullptr)
+	{
+		LOGWARNING("%s: No such rank (%s), aborting.", __FUNCTION__, a_RankName.c_str());
+		return false;
+	}
 
-		// Check if the group is already there:
-		{
-			SQLite::Statement stmt(m_DB, "SELECT COUNT(*) FROM RankPermGroup WHERE RankID = ? AND PermGroupID = ?");
-			stmt.bind(1, RankID);
-			stmt.bind(2, GroupID);
-			if (!stmt.executeStep())
-			{
-				LOGWARNING("%s: Failed to check binding between rank %s and group %s, aborting.", __FUNCTION__, a_RankName.c_str(), a_GroupName.c_str());
-				return false;
-			}
-			if (stmt.getColumn(0).getInt() > 0)
-			{
-				LOGD("%s: Group %s already present in rank %s, skipping and returning success.",
-					__FUNCTION__, a_GroupName.c_str(), a_RankName.c_str()
-				);
-				return true;
-			}
-		}
+	// Check if the group is already there:
+	if (std::find(Rank->m_Groups.begin(), Rank->m_Groups.end(), a_GroupName) != Rank->m_Groups.end())
+	{
+		LOGD("%s: Group %s already present in rank %s, skipping and returning success.",
+			__FUNCTION__, a_GroupName.c_str(), a_RankName.c_str()
+		);
+		return true;
+	}
 
-		// Add the group:
+	// Add the group:
+	Rank->m_Groups.push_back(a_GroupName);
+	int RankID = Rank->m_ID;
+	int GroupID = Group->m_ID;
+	m_DBWriter.Queue([=](SQLite::Database & a_DB)
 		{
-			SQLite::Statement stmt(m_DB, "INSERT INTO RankPermGroup (RankID, PermGroupID) VALUES (?, ?)");
+			SQLite::Statement stmt(a_DB, "INSERT INTO RankPermGroup (RankID, PermGroupID) VALUES (?, ?)");
 			stmt.bind(1, RankID);
 			stmt.bind(2, GroupID);
-			if (stmt.exec() <= 0)
-			{
-				LOGWARNING("%s: Failed to add group %s to rank %s, aborting.", __FUNCTION__, a_GroupName.c_str(), a_RankName.c_str());
-				return false;
-			}
+			stmt.exec();
 		}
-
-		// Adding succeeded:
-		return true;
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to add group %s to rank %s: %s", __FUNCTION__, a_GroupName.c_str(), a_RankName.c_str(), ex.what());
-	}
-	return false;
+	);
+	return true;
 }
 
 
@@ -742,65 +715,7 @@ bool cRankManager::AddGroupToRank(const AString & a_GroupName, const AString & a
 
 bool cRankManager::AddPermissionToGroup(const AString & a_Permission, const AString & a_GroupName)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	try
-	{
-		// Get the group's ID:
-		int GroupID;
-		{
-			SQLite::Statement stmt(m_DB, "SELECT PermGroupID FROM PermGroup WHERE Name = ?");
-			stmt.bind(1, a_GroupName);
-			if (!stmt.executeStep())
-			{
-				LOGWARNING("%s: No such group (%s), aborting.", __FUNCTION__, a_GroupName.c_str());
-				return false;
-			}
-			GroupID = stmt.getColumn(0).getInt();
-		}
-
-		// Check if the permission is already present:
-		{
-			SQLite::Statement stmt(m_DB, "SELECT COUNT(*) FROM PermissionItem WHERE PermGroupID = ? AND Permission = ?");
-			stmt.bind(1, GroupID);
-			stmt.bind(2, a_Permission);
-			if (!stmt.executeStep())
-			{
-				LOGWARNING("%s: Failed to check binding between permission %s and group %s, aborting.", __FUNCTION__, a_Permission.c_str(), a_GroupName.c_str());
-				return false;
-			}
-			if (stmt.getColumn(0).getInt() > 0)
-			{
-				LOGD("%s: Permission %s is already present in group %s, skipping and returning success.",
-					__FUNCTION__, a_Permission.c_str(), a_GroupName.c_str()
-				);
-				return true;
-			}
-		}
-
-		// Add the permission:
-		{
-			SQLite::Statement stmt(m_DB, "INSERT INTO PermissionItem (Permission, PermGroupID) VALUES (?, ?)");
-			stmt.bind(1, a_Permission);
-			stmt.bind(2, GroupID);
-			if (stmt.exec() <= 0)
-			{
-				LOGWARNING("%s: Failed to add permission %s to group %s, aborting.", __FUNCTION__, a_Permission.c_str(), a_GroupName.c_str());
-				return false;
-			}
-		}
-
-		// Adding succeeded:
-		return true;
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to add permission %s to group %s: %s",
-			__FUNCTION__, a_Permission.c_str(), a_GroupName.c_str(), ex.what()
-		);
-	}
-	return false;
+	return AddPermissionsToGroup({a_Permission}, a_GroupName);
 }
 
 
@@ -809,65 +724,7 @@ bool cRankManager::AddPermissionToGroup(const AString & a_Permission, const AStr
 
 bool cRankManager::AddRestrictionToGroup(const AString & a_Restriction, const AString & a_GroupName)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	try
-	{
-		// Get the group's ID:
-		int GroupID;
-		{
-			SQLite::Statement stmt(m_DB, "SELECT PermGroupID FROM PermGroup WHERE Name = ?");
-			stmt.bind(1, a_GroupName);
-			if (!stmt.executeStep())
-			{
-				LOGWARNING("%s: No such group (%s), aborting.", __FUNCTION__, a_GroupName.c_str());
-				return false;
-			}
-			GroupID = stmt.getColumn(0).getInt();
-		}
-
-		// Check if the restriction is already present:
-		{
-			SQLite::Statement stmt(m_DB, "SELECT COUNT(*) FROM RestrictionItem WHERE PermGroupID = ? AND Permission = ?");
-			stmt.bind(1, GroupID);
-			stmt.bind(2, a_Restriction);
-			if (!stmt.executeStep())
-			{
-				LOGWARNING("%s: Failed to check binding between restriction %s and group %s, aborting.", __FUNCTION__, a_Restriction.c_str(), a_GroupName.c_str());
-				return false;
-			}
-			if (stmt.getColumn(0).getInt() > 0)
-			{
-				LOGD("%s: Restriction %s is already present in group %s, skipping and returning success.",
-					__FUNCTION__, a_Restriction.c_str(), a_GroupName.c_str()
-				);
-				return true;
-			}
-		}
-
-		// Add the restriction:
-		{
-			SQLite::Statement stmt(m_DB, "INSERT INTO RestrictionItem (Permission, PermGroupID) VALUES (?, ?)");
-			stmt.bind(1, a_Restriction);
-			stmt.bind(2, GroupID);
-			if (stmt.exec() <= 0)
-			{
-				LOGWARNING("%s: Failed to add restriction %s to group %s, aborting.", __FUNCTION__, a_Restriction.c_str(), a_GroupName.c_str());
-				return false;
-			}
-		}
-
-		// Adding succeeded:
-		return true;
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to add restriction %s to group %s: %s",
-			__FUNCTION__, a_Restriction.c_str(), a_GroupName.c_str(), ex.what()
-		);
-	}
-	return false;
+	return AddRestrictionsToGroup({a_Restriction}, a_GroupName);
 }
 
 
@@ -879,65 +736,37 @@ bool cRankManager::AddPermissionsToGroup(const AStringVector & a_Permissions, co
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
+	auto Group = FindGroup(a_GroupName);
+	if (Group == nullptr)
 	{
-		// Get the group's ID:
-		int GroupID;
-		{
-			SQLite::Statement stmt(m_DB, "SELECT PermGroupID FROM PermGroup WHERE Name = ?");
-			stmt.bind(1, a_GroupName);
-			if (!stmt.executeStep())
-			{
-				LOGWARNING("%s: No such group (%s), aborting.", __FUNCTION__, a_GroupName.c_str());
-				return false;
-			}
-			GroupID = stmt.getColumn(0).getInt();
-		}
+		LOGWARNING("%s: No such group (%s), aborting.", __FUNCTION__, a_GroupName.c_str());
+		return false;
+	}
 
-		for (AStringVector::const_iterator itr = a_Permissions.begin(), end = a_Permissions.end(); itr != end; ++itr)
+	int GroupID = Group->m_ID;
+	for (const auto & Permission: a_Permissions)
+	{
+		// Check if the permission is already present:
+		if (std::find(Group->m_Permissions.begin(), Group->m_Permissions.end(), Permission) != Group->m_Permissions.end())
 		{
-			// Check if the permission is already present:
-			{
-				SQLite::Statement stmt(m_DB, "SELECT COUNT(*) FROM PermissionItem WHERE PermGroupID = ? AND Permission = ?");
-				stmt.bind(1, GroupID);
-				stmt.bind(2, *itr);
-				if (!stmt.executeStep())
-				{
-					LOGWARNING("%s: Failed to check binding between permission %s and group %s, aborting.", __FUNCTION__, itr->c_str(), a_GroupName.c_str());
-					return false;
-				}
-				if (stmt.getColumn(0).getInt() > 0)
-				{
-					LOGD("%s: Permission %s is already present in group %s, skipping and returning success.",
-						__FUNCTION__, itr->c_str(), a_GroupName.c_str()
-					);
-					continue;
-				}
-			}
+			LOGD("%s: Permission %s is already present in group %s, skipping.",
+				__FUNCTION__, Permission.c_str(), a_GroupName.c_str()
+			);
+			continue;
+		}
 
-			// Add the permission:
+		// Add the permission:
+		Group->m_Permissions.push_back(Permission);
+		m_DBWriter.Queue([=](SQLite::Database & a_DB)
 			{
-				SQLite::Statement stmt(m_DB, "INSERT INTO PermissionItem (Permission, PermGroupID) VALUES (?, ?)");
-				stmt.bind(1, *itr);
+				SQLite::Statement stmt(a_DB, "INSERT INTO PermissionItem (Permission, PermGroupID) VALUES (?, ?)");
+				stmt.bind(1, Permission);
 				stmt.bind(2, GroupID);
-				if (stmt.exec() <= 0)
-				{
-					LOGWARNING("%s: Failed to add permission %s to group %s, skipping.", __FUNCTION__, itr->c_str(), a_GroupName.c_str());
-					continue;
-				}
+				stmt.exec();
 			}
-		}  // for itr - a_Permissions[]
-
-		// Adding succeeded:
-		return true;
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to add permissions to group %s: %s",
-			__FUNCTION__, a_GroupName.c_str(), ex.what()
 		);
-	}
-	return false;
+	}  // for Permission - a_Permissions[]
+	return true;
 }
 
 
@@ -949,65 +778,37 @@ bool cRankManager::AddRestrictionsToGroup(const AStringVector & a_Restrictions,
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
+	auto Group = FindGroup(a_GroupName);
+	if (Group == nullptr)
 	{
-		// Get the group's ID:
-		int GroupID;
-		{
-			SQLite::Statement stmt(m_DB, "SELECT PermGroupID FROM PermGroup WHERE Name = ?");
-			stmt.bind(1, a_GroupName);
-			if (!stmt.executeStep())
-			{
-				LOGWARNING("%s: No such group (%s), aborting.", __FUNCTION__, a_GroupName.c_str());
-				return false;
-			}
-			GroupID = stmt.getColumn(0).getInt();
-		}
+		LOGWARNING("%s: No such group (%s), aborting.", __FUNCTION__, a_GroupName.c_str());
+		return false;
+	}
 
-		for (auto itr = a_Restrictions.cbegin(), end = a_Restrictions.cend(); itr != end; ++itr)
+	int GroupID = Group->m_ID;
+	for (const auto & Restriction: a_Restrictions)
+	{
+		// Check if the restriction is already present:
+		if (std::find(Group->m_Restrictions.begin(), Group->m_Restrictions.end(), Restriction) != Group->m_Restrictions.end())
 		{
-			// Check if the restriction is already present:
-			{
-				SQLite::Statement stmt(m_DB, "SELECT COUNT(*) FROM RestrictionItem WHERE PermGroupID = ? AND Permission = ?");
-				stmt.bind(1, GroupID);
-				stmt.bind(2, *itr);
-				if (!stmt.executeStep())
-				{
-					LOGWARNING("%s: Failed to check binding between restriction %s and group %s, aborting.", __FUNCTION__, itr->c_str(), a_GroupName.c_str());
-					return false;
-				}
-				if (stmt.getColumn(0).getInt() > 0)
-				{
-					LOGD("%s: Restriction %s is already present in group %s, skipping and returning success.",
-						__FUNCTION__, itr->c_str(), a_GroupName.c_str()
-					);
-					continue;
-				}
-			}
+			LOGD("%s: Restriction %s is already present in group %s, skipping.",
+				__FUNCTION__, Restriction.c_str(), a_GroupName.c_str()
+			);
+			continue;
+		}
 
-			// Add the permission:
+		// Add the restriction:
+		Group->m_Restrictions.push_back(Restriction);
+		m_DBWriter.Queue([=](SQLite::Database & a_DB)
 			{
-				SQLite::Statement stmt(m_DB, "INSERT INTO RestrictionItem (Permission, PermGroupID) VALUES (?, ?)");
-				stmt.bind(1, *itr);
+				SQLite::Statement stmt(a_DB, "INSERT INTO RestrictionItem (Permission, PermGroupID) VALUES (?, ?)");
+				stmt.bind(1, Restriction);
 				stmt.bind(2, GroupID);
-				if (stmt.exec() <= 0)
-				{
-					LOGWARNING("%s: Failed to add restriction %s to group %s, skipping.", __FUNCTION__, itr->c_str(), a_GroupName.c_str());
-					continue;
-				}
+				stmt.exec();
 			}
-		}  // for itr - a_Restrictions[]
-
-		// Adding succeeded:
-		return true;
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to add restrictions to group %s: %s",
-			__FUNCTION__, a_GroupName.c_str(), ex.what()
 		);
-	}
-	return false;
+	}  // for Restriction - a_Restrictions[]
+	return true;
 }
 
 
@@ -1020,79 +821,78 @@ void cRankManager::RemoveRank(const AString & a_RankName, const AString & a_Repl
 	cCSLock Lock(m_CS);
 
 	// Check if the default rank is being removed with a proper replacement:
-	if ((a_RankName == m_DefaultRank) && !RankExists(a_ReplacementRankName))
+	auto Replacement = FindRank(a_ReplacementRankName);
+	if ((a_RankName == m_DefaultRank) && ((Replacement == nullptr) || (a_RankName == a_ReplacementRankName)))
 	{
 		LOGWARNING("%s: Cannot remove rank %s, it is the default rank and the replacement rank doesn't exist.", __FUNCTION__, a_RankName.c_str());
 		return;
 	}
 
-	AStringVector res;
-	try
+	auto itr = m_Ranks.find(a_RankName);
+	if (itr == m_Ranks.end())
 	{
-		// Get the RankID for the rank being removed:
-		int RemoveRankID;
-		{
-			SQLite::Statement stmt(m_DB, "SELECT RankID FROM Rank WHERE Name = ?");
-			stmt.bind(1, a_RankName);
-			if (!stmt.executeStep())
-			{
-				LOGINFO("%s: Rank %s was not found. Skipping.", __FUNCTION__, a_RankName.c_str());
-				return;
-			}
-			RemoveRankID = stmt.getColumn(0).getInt();
-		}
+		LOGINFO("%s: Rank %s was not found. Skipping.", __FUNCTION__, a_RankName.c_str());
+		return;
+	}
+	int RemoveRankID = itr->second.m_ID;
+	int ReplacementRankID = (Replacement == nullptr) ? -1 : Replacement->m_ID;
 
-		// Get the RankID for the replacement rank:
-		int ReplacementRankID = -1;
+	// Adjust players:
+	for (auto PlayerItr = m_Players.begin(); PlayerItr != m_Players.end();)
+	{
+		if (PlayerItr->second.m_RankName != a_RankName)
 		{
-			SQLite::Statement stmt(m_DB, "SELECT RankID FROM Rank WHERE Name = ?");
-			stmt.bind(1, a_ReplacementRankName);
-			if (stmt.executeStep())
-			{
-				ReplacementRankID = stmt.getColumn(0).getInt();
-			}
+			++PlayerItr;
 		}
-
-		// Remove the rank's bindings to groups:
+		else if (ReplacementRankID == -1)
 		{
-			SQLite::Statement stmt(m_DB, "DELETE FROM RankPermGroup WHERE RankID = ?");
-			stmt.bind(1, RemoveRankID);
-			stmt.exec();
-		}
-
-		// Adjust players:
-		if (ReplacementRankID == -1)
-		{
-			// No replacement, just delete all the players that have the rank:
-			SQLite::Statement stmt(m_DB, "DELETE FROM PlayerRank WHERE RankID = ?");
-			stmt.bind(1, RemoveRankID);
-			stmt.exec();
+			// No replacement, just delete the player:
+			PlayerItr = m_Players.erase(PlayerItr);
 		}
 		else
 		{
-			// Replacement available, change all the player records:
-			SQLite::Statement stmt(m_DB, "UPDATE PlayerRank SET RankID = ? WHERE RankID = ?");
-			stmt.bind(1, ReplacementRankID);
-			stmt.bind(2, RemoveRankID);
-			stmt.exec();
+			PlayerItr->second.m_RankName = a_ReplacementRankName;
+			++PlayerItr;
 		}
+	}
 
-		// Remove the rank from the DB:
+	// Remove the rank itself:
+	m_Ranks.erase(itr);
+	m_DBWriter.Queue([=](SQLite::Database & a_DB)
 		{
-			SQLite::Statement stmt(m_DB, "DELETE FROM Rank WHERE RankID = ?");
+			// Remove the rank's bindings to groups:
+			{
+				SQLite::Statement stmt(a_DB, "DELETE FROM RankPermGroup WHERE RankID = ?");
+				stmt.bind(1, RemoveRankID);
+				stmt.exec();
+			}
+
+			// Adjust players:
+			if (ReplacementRankID == -1)
+			{
+				SQLite::Statement stmt(a_DB, "DELETE FROM PlayerRank WHERE RankID = ?");
+				stmt.bind(1, RemoveRankID);
+				stmt.exec();
+			}
+			else
+			{
+				SQLite::Statement stmt(a_DB, "UPDATE PlayerRank SET RankID = ? WHERE RankID = ?");
+				stmt.bind(1, ReplacementRankID);
+				stmt.bind(2, RemoveRankID);
+				stmt.exec();
+			}
+
+			// Remove the rank from the DB:
+			SQLite::Statement stmt(a_DB, "DELETE FROM Rank WHERE RankID = ?");
 			stmt.bind(1, RemoveRankID);
 			stmt.exec();
 		}
+	);
 
-		// Update the default rank, if it was the one being removed:
-		if (a_RankName == m_DefaultRank)
-		{
-			m_DefaultRank = a_RankName;
-		}
-	}
-	catch (const SQLite::Exception & ex)
+	// Update the default rank, if it was the one being removed:
+	if (a_RankName == m_DefaultRank)
 	{
-		LOGWARNING("%s: Failed to remove rank from DB: %s", __FUNCTION__, ex.what());
+		SetDefaultRank(a_ReplacementRankName);
 	}
 }
 
@@ -1105,46 +905,32 @@ void cRankManager::RemoveGroup(const AString & a_GroupName)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
+	auto itr = m_Groups.find(a_GroupName);
+	if (itr == m_Groups.end())
 	{
-		// Get the ID of the group:
-		int GroupID;
-		{
-			SQLite::Statement stmt(m_DB, "SELECT PermGroupID FROM PermGroup WHERE Name = ?");
-			stmt.bind(1, a_GroupName);
-			if (!stmt.executeStep())
-			{
-				LOGINFO("%s: Group %s was not found, skipping.", __FUNCTION__, a_GroupName.c_str());
-				return;
-			}
-			GroupID = stmt.getColumn(0).getInt();
-		}
-
-		// Remove all permissions from the group:
-		{
-			SQLite::Statement stmt(m_DB, "DELETE FROM PermissionItem WHERE PermGroupID = ?");
-			stmt.bind(1, GroupID);
-			stmt.exec();
-		}
+		LOGINFO("%s: Group %s was not found, skipping.", __FUNCTION__, a_GroupName.c_str());
+		return;
+	}
+	int GroupID = itr->second.m_ID;
 
-		// Remove the group from all ranks that contain it:
-		{
-			SQLite::Statement stmt(m_DB, "DELETE FROM RankPermGroup WHERE PermGroupID = ?");
-			stmt.bind(1, GroupID);
-			stmt.exec();
-		}
+	// Remove the group from all ranks that contain it, then the group itself:
+	for (auto & Rank: m_Ranks)
+	{
+		auto & Groups = Rank.second.m_Groups;
+		Groups.erase(std::remove(Groups.begin(), Groups.end(), a_GroupName), Groups.end());
+	}
+	m_Groups.erase(itr);
 
-		// Remove the group itself:
+	m_DBWriter.Queue([=](SQLite::Database & a_DB)
 		{
-			SQLite::Statement stmt(m_DB, "DELETE FROM PermGroup WHERE PermGroupID = ?");
-			stmt.bind(1, GroupID);
-			stmt.exec();
+			for (const auto & Table: {"PermissionItem", "RestrictionItem", "RankPermGroup", "PermGroup"})
+			{
+				SQLite::Statement stmt(a_DB, Printf("DELETE FROM %s WHERE PermGroupID = ?", Table));
+				stmt.bind(1, GroupID);
+				stmt.exec();
+			}
 		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to remove group %s from DB: %s", __FUNCTION__, a_GroupName.c_str(), ex.what());
-	}
+	);
 }
 
 
@@ -1156,47 +942,32 @@ void cRankManager::RemoveGroupFromRank(const AString & a_GroupName, const AStrin
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
+	auto Group = FindGroup(a_GroupName);
+	auto Rank = FindRank(a_RankName);
+	if ((Group == nullptr) || (Rank == nullptr))
 	{
-		// Get the IDs of the group and the rank:
-		int GroupID, RankID;
-		{
-			SQLite::Statement stmt(m_DB,
-				"SELECT PermGroup.PermGroupID, Rank.RankID FROM PermGroup "
-					"LEFT JOIN RankPermGroup ON RankPermGroup.PermGroupID = PermGroup.PermGroupID "
-					"LEFT JOIN Rank ON Rank.RankID = RankPermGroup.RankID "
-				"WHERE PermGroup.Name = ? AND Rank.Name = ?"
-			);
-			stmt.bind(1, a_GroupName);
-			stmt.bind(2, a_RankName);
-			if (!stmt.executeStep())
-			{
-				LOGINFO("%s: Group %s was not found in rank %s, skipping.", __FUNCTION__, a_GroupName.c_str(), a_RankName.c_str());
-				return;
-			}
-			GroupID = stmt.getColumn(0).getInt();
-			RankID = stmt.getColumn(1).getInt();
-		}
-
-		// Remove the group from all ranks that contain it:
-		{
-			SQLite::Statement stmt(m_DB, "DELETE FROM RankPermGroup WHERE PermGroupID = ?");
-			stmt.bind(1, GroupID);
-			stmt.exec();
-		}
+		LOGINFO("%s: Group %s was not found in rank %s, skipping.", __FUNCTION__, a_GroupName.c_str(), a_RankName.c_str());
+		return;
+	}
+	auto itr = std::find(Rank->m_Groups.begin(), Rank->m_Groups.end(), a_GroupName);
+	if (itr == Rank->m_Groups.end())
+	{
+		LOGINFO("%s: Group %s was not found in rank %s, skipping.", __FUNCTION__, a_GroupName.c_str(), a_RankName.c_str());
+		return;
+	}
 
-		// Remove the group-to-rank binding:
+	// Remove the group-to-rank binding:
+	Rank->m_Groups.erase(itr);
+	int GroupID = Group->m_ID;
+	int RankID = Rank->m_ID;
+	m_DBWriter.Queue([=](SQLite::Database & a_DB)
 		{
-			SQLite::Statement stmt(m_DB, "DELETE FROM RankPermGroup WHERE PermGroupID = ? AND RankID = ?");
+			SQLite::Statement stmt(a_DB, "DELETE FROM RankPermGroup WHERE PermGroupID = ? AND RankID = ?");
 			stmt.bind(1, GroupID);
-			stmt.bind(1, RankID);
+			stmt.bind(2, RankID);
 			stmt.exec();
 		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to remove group %s from rank %s in the DB: %s", __FUNCTION__, a_GroupName.c_str(), a_RankName.c_str(), ex.what());
-	}
+	);
 }
 
 
@@ -1208,35 +979,25 @@ void cRankManager::RemovePermissionFromGroup(const AString & a_Permission, const
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
+	auto Group = FindGroup(a_GroupName);
+	if (Group == nullptr)
 	{
-		// Get the ID of the group:
-		int GroupID;
-		{
-			SQLite::Statement stmt(m_DB, "SELECT PermGroupID FROM PermGroup WHERE Name = ?");
-			stmt.bind(1, a_GroupName);
-			if (!stmt.executeStep())
-			{
-				LOGINFO("%s: Group %s was not found, skipping.", __FUNCTION__, a_GroupName.c_str());
-				return;
-			}
-			GroupID = stmt.getColumn(0).getInt();
-		}
+		LOGINFO("%s: Group %s was not found, skipping.", __FUNCTION__, a_GroupName.c_str());
+		return;
+	}
 
-		// Remove the permission from the group:
+	// Remove the permission from the group:
+	auto & Permissions = Group->m_Permissions;
+	Permissions.erase(std::remove(Permissions.begin(), Permissions.end(), a_Permission), Permissions.end());
+	int GroupID = Group->m_ID;
+	m_DBWriter.Queue([=](SQLite::Database & a_DB)
 		{
-			SQLite::Statement stmt(m_DB, "DELETE FROM PermissionItem WHERE PermGroupID = ? AND Permission = ?");
+			SQLite::Statement stmt(a_DB, "DELETE FROM PermissionItem WHERE PermGroupID = ? AND Permission = ?");
 			stmt.bind(1, GroupID);
 			stmt.bind(2, a_Permission);
 			stmt.exec();
 		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to remove permission %s from group %s in DB: %s",
-			__FUNCTION__, a_Permission.c_str(), a_GroupName.c_str(), ex.what()
-		);
-	}
+	);
 }
 
 
@@ -1248,35 +1009,25 @@ void cRankManager::RemoveRestrictionFromGroup(const AString & a_Restriction, con
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
+	auto Group = FindGroup(a_GroupName);
+	if (Group == nullptr)
 	{
-		// Get the ID of the group:
-		int GroupID;
-		{
-			SQLite::Statement stmt(m_DB, "SELECT PermGroupID FROM PermGroup WHERE Name = ?");
-			stmt.bind(1, a_GroupName);
-			if (!stmt.executeStep())
-			{
-				LOGINFO("%s: Group %s was not found, skipping.", __FUNCTION__, a_GroupName.c_str());
-				return;
-			}
-			GroupID = stmt.getColumn(0).getInt();
-		}
+		LOGINFO("%s: Group %s was not found, skipping.", __FUNCTION__, a_GroupName.c_str());
+		return;
+	}
 
-		// Remove the permission from the group:
+	// Remove the restriction from the group:
+	auto & Restrictions = Group->m_Restrictions;
+	Restrictions.erase(std::remove(Restrictions.begin(), Restrictions.end(), a_Restriction), Restrictions.end());
+	int GroupID = Group->m_ID;
+	m_DBWriter.Queue([=](SQLite::Database & a_DB)
 		{
-			SQLite::Statement stmt(m_DB, "DELETE FROM RestrictionItem WHERE PermGroupID = ? AND Permission = ?");
+			SQLite::Statement stmt(a_DB, "DELETE FROM RestrictionItem WHERE PermGroupID = ? AND Permission = ?");
 			stmt.bind(1, GroupID);
 			stmt.bind(2, a_Restriction);
 			stmt.exec();
 		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to remove restriction %s from group %s in DB: %s",
-			__FUNCTION__, a_Restriction.c_str(), a_GroupName.c_str(), ex.what()
-		);
-	}
+	);
 }
 
 
@@ -1288,45 +1039,45 @@ bool cRankManager::RenameRank(const AString & a_OldName, const AString & a_NewNa
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
+	// Check that NewName doesn't exist:
+	if (FindRank(a_NewName) != nullptr)
 	{
-		// Check that NewName doesn't exist:
-		{
-			SQLite::Statement stmt(m_DB, "SELECT RankID FROM Rank WHERE Name = ?");
-			stmt.bind(1, a_NewName);
-			if (stmt.executeStep())
-			{
-				LOGINFO("%s: Rank %s is already present, cannot rename %s", __FUNCTION__, a_NewName.c_str(), a_OldName.c_str());
-				return false;
-			}
-		}
+		LOGINFO("%s: Rank %s is already present, cannot rename %s", __FUNCTION__, a_NewName.c_str(), a_OldName.c_str());
+		return false;
+	}
 
-		// Rename:
+	// Rename:
+	auto Node = m_Ranks.extract(a_OldName);
+	if (Node.empty())
+	{
+		LOGINFO("%s: There is no rank %s, cannot rename to %s.", __FUNCTION__, a_OldName.c_str(), a_NewName.c_str());
+		return false;
+	}
+	int RankID = Node.mapped().m_ID;
+	Node.key() = a_NewName;
+	m_Ranks.insert(std::move(Node));
+	for (auto & Player: m_Players)
+	{
+		if (Player.second.m_RankName == a_OldName)
 		{
-			SQLite::Statement stmt(m_DB, "UPDATE Rank SET Name = ? WHERE Name = ?");
-			stmt.bind(1, a_NewName);
-			stmt.bind(2, a_OldName);
-			if (stmt.exec() <= 0)
-			{
-				LOGINFO("%s: There is no rank %s, cannot rename to %s.", __FUNCTION__, a_OldName.c_str(), a_NewName.c_str());
-				return false;
-			}
+			Player.second.m_RankName = a_NewName;
 		}
-
-		// Update the default rank, if it was the one being renamed:
-		if (a_OldName == m_DefaultRank)
+	}
+	m_DBWriter.Queue([=](SQLite::Database & a_DB)
 		{
-			m_DefaultRank = a_NewName;
+			SQLite::Statement stmt(a_DB, "UPDATE Rank SET Name = ? WHERE RankID = ?");
+			stmt.bind(1, a_NewName);
+			stmt.bind(2, RankID);
+			stmt.exec();
 		}
+	);
 
-		return true;
-	}
-	catch (const SQLite::Exception & ex)
+	// Update the default rank, if it was the one being renamed:
+	if (a_OldName == m_DefaultRank)
 	{
-		LOGWARNING("%s: Failed to rename rank %s to %s in DB: %s",
-			__FUNCTION__, a_OldName.c_str(), a_NewName.c_str(), ex.what());
+		m_DefaultRank = a_NewName;
 	}
-	return false;
+	return true;
 }
 
 
@@ -1338,36 +1089,35 @@ bool cRankManager::RenameGroup(const AString & a_OldName, const AString & a_NewN
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
+	// Check that NewName doesn't exist:
+	if (FindGroup(a_NewName) != nullptr)
 	{
-		// Check that NewName doesn't exist:
-		{
-			SQLite::Statement stmt(m_DB, "SELECT PermGroupID FROM PermGroup WHERE Name = ?");
-			stmt.bind(1, a_NewName);
-			if (stmt.executeStep())
-			{
-				LOGD("%s: Group %s is already present, cannot rename %s", __FUNCTION__, a_NewName.c_str(), a_OldName.c_str());
-				return false;
-			}
-		}
-
-		// Rename:
-		bool res;
-		{
-			SQLite::Statement stmt(m_DB, "UPDATE PermGroup SET Name = ? WHERE Name = ?");
-			stmt.bind(1, a_NewName);
-			stmt.bind(2, a_OldName);
-			res = (stmt.exec() > 0);
-		}
+		LOGD("%s: Group %s is already present, cannot rename %s", __FUNCTION__, a_NewName.c_str(), a_OldName.c_str());
+		return false;
+	}
 
-		return res;
+	// Rename:
+	auto Node = m_Groups.extract(a_OldName);
+	if (Node.empty())
+	{
+		return false;
 	}
-	catch (const SQLite::Exception & ex)
+	int GroupID = Node.mapped().m_ID;
+	Node.key() = a_NewName;
+	m_Groups.insert(std::move(Node));
+	for (auto & Rank: m_Ranks)
 	{
-		LOGWARNING("%s: Failed to rename group %s to %s in DB: %s",
-			__FUNCTION__, a_OldName.c_str(), a_NewName.c_str(), ex.what());
+		std::replace(Rank.second.m_Groups.begin(), Rank.second.m_Groups.end(), a_OldName, a_NewName);
 	}
-	return false;
+	m_DBWriter.Queue([=](SQLite::Database & a_DB)
+		{
+			SQLite::Statement stmt(a_DB, "UPDATE PermGroup SET Name = ? WHERE PermGroupID = ?");
+			stmt.bind(1, a_NewName);
+			stmt.bind(2, GroupID);
+			stmt.exec();
+		}
+	);
+	return true;
 }
 
 
@@ -1379,57 +1129,38 @@ void cRankManager::SetPlayerRank(const cUUID & a_PlayerUUID, const AString & a_P
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
+	auto Rank = FindRank(a_RankName);
+	if (Rank == nullptr)
+	{
+		LOGWARNING("%s: There is no rank %s, aborting.", __FUNCTION__, a_RankName.c_str());
+		return;
+	}
+
+	m_Players[a_PlayerUUID] = sPlayer{a_PlayerName, a_RankName};
+	int RankID = Rank->m_ID;
 	AString StrUUID = a_PlayerUUID.ToShortString();
-
-	try
-	{
-		// Get the rank ID:
-		int RankID;
+	m_DBWriter.Queue([=](SQLite::Database & a_DB)
 		{
-			SQLite::Statement stmt(m_DB, "SELECT RankID FROM Rank WHERE Name = ?");
-			stmt.bind(1, a_RankName);
-			if (!stmt.executeStep())
+			// Update the player's rank, if already in DB:
 			{
-				LOGWARNING("%s: There is no rank %s, aborting.", __FUNCTION__, a_RankName.c_str());
-				return;
+				SQLite::Statement stmt(a_DB, "UPDATE PlayerRank SET RankID = ?, PlayerName = ? WHERE PlayerUUID = ?");
+				stmt.bind(1, RankID);
+				stmt.bind(2, a_PlayerName);
+				stmt.bind(3, StrUUID);
+				if (stmt.exec() > 0)
+				{
+					return;
+				}
 			}
-			RankID = stmt.getColumn(0).getInt();
-		}
 
-		// Update the player's rank, if already in DB:
-		{
-			SQLite::Statement stmt(m_DB, "UPDATE PlayerRank SET RankID = ?, PlayerName = ? WHERE PlayerUUID = ?");
+			// The player is not yet in the DB, add them:
+			SQLite::Statement stmt(a_DB, "INSERT INTO PlayerRank (RankID, PlayerUUID, PlayerName) VALUES (?, ?, ?)");
 			stmt.bind(1, RankID);
-			stmt.bind(2, a_PlayerName);
-			stmt.bind(3, StrUUID);
-			if (stmt.exec() > 0)
-			{
-				// Successfully updated the player's rank
-				return;
-			}
-		}
-
-		// The player is not yet in the DB, add them:
-		SQLite::Statement stmt(m_DB, "INSERT INTO PlayerRank (RankID, PlayerUUID, PlayerName) VALUES (?, ?, ?)");
-		stmt.bind(1, RankID);
-		stmt.bind(2, StrUUID);
-		stmt.bind(3, a_PlayerName);
-		if (stmt.exec() > 0)
-		{
-			// Successfully added the player
-			return;
+			stmt.bind(2, StrUUID);
+			stmt.bind(3, a_PlayerName);
+			stmt.exec();
 		}
-
-		LOGWARNING("%s: Failed to set player UUID %s to rank %s.",
-			__FUNCTION__, StrUUID.c_str(), a_RankName.c_str()
-		);
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to set player UUID %s to rank %s: %s",
-			__FUNCTION__, StrUUID.c_str(), a_RankName.c_str(), ex.what()
-		);
-	}
+	);
 }
 
 
@@ -1441,20 +1172,19 @@ void cRankManager::RemovePlayerRank(const cUUID & a_PlayerUUID)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	AString StrUUID = a_PlayerUUID.ToShortString();
-
-	try
-	{
-		SQLite::Statement stmt(m_DB, "DELETE FROM PlayerRank WHERE PlayerUUID = ?");
-		stmt.bind(1, StrUUID);
-		stmt.exec();
-	}
-	catch (const SQLite::Exception & ex)
+	if (m_Players.erase(a_PlayerUUID) == 0)
 	{
-		LOGWARNING("%s: Failed to remove rank from player UUID %s: %s",
-			__FUNCTION__, StrUUID.c_str(), ex.what()
-		);
+		return;
 	}
+
+	AString StrUUID = a_PlayerUUID.ToShortString();
+	m_DBWriter.Queue([=](SQLite::Database & a_DB)
+		{
+			SQLite::Statement stmt(a_DB, "DELETE FROM PlayerRank WHERE PlayerUUID = ?");
+			stmt.bind(1, StrUUID);
+			stmt.exec();
+		}
+	);
 }
 
 
@@ -1471,22 +1201,27 @@ void cRankManager::SetRankVisuals(
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
+	auto Rank = FindRank(a_RankName);
+	if (Rank == nullptr)
 	{
-		SQLite::Statement stmt(m_DB, "UPDATE Rank SET MsgPrefix = ?, MsgSuffix = ?, MsgNameColorCode = ? WHERE Name = ?");
-		stmt.bind(1, a_MsgPrefix);
-		stmt.bind(2, a_MsgSuffix);
-		stmt.bind(3, a_MsgNameColorCode);
-		stmt.bind(4, a_RankName);
-		if (stmt.exec() < 1)
+		LOGINFO("%s: Rank %s not found, visuals not set.", __FUNCTION__, a_RankName.c_str());
+		return;
+	}
+
+	Rank->m_MsgPrefix = a_MsgPrefix;
+	Rank->m_MsgSuffix = a_MsgSuffix;
+	Rank->m_MsgNameColorCode = a_MsgNameColorCode;
+	int RankID = Rank->m_ID;
+	m_DBWriter.Queue([=](SQLite::Database & a_DB)
 		{
-			LOGINFO("%s: Rank %s not found, visuals not set.", __FUNCTION__, a_RankName.c_str());
+			SQLite::Statement stmt(a_DB, "UPDATE Rank SET MsgPrefix = ?, MsgSuffix = ?, MsgNameColorCode = ? WHERE RankID = ?");
+			stmt.bind(1, a_MsgPrefix);
+			stmt.bind(2, a_MsgSuffix);
+			stmt.bind(3, a_MsgNameColorCode);
+			stmt.bind(4, RankID);
+			stmt.exec();
 		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to get ranks from DB: %s", __FUNCTION__, ex.what());
-	}
+	);
 }
 
 
@@ -1503,25 +1238,15 @@ bool cRankManager::GetRankVisuals(
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
+	auto Rank = FindRank(a_RankName);
+	if (Rank == nullptr)
 	{
-		SQLite::Statement stmt(m_DB, "SELECT MsgPrefix, MsgSuffix, MsgNameColorCode FROM Rank WHERE Name = ?");
-		stmt.bind(1, a_RankName);
-		if (!stmt.executeStep())
-		{
-			// Rank not found
-			return false;
-		}
-		a_MsgPrefix = stmt.getColumn(0).getText();
-		a_MsgSuffix = stmt.getColumn(1).getText();
-		a_MsgNameColorCode = stmt.getColumn(2).getText();
-		return true;
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to get ranks from DB: %s", __FUNCTION__, ex.what());
+		return false;
 	}
-	return false;
+	a_MsgPrefix = Rank->m_MsgPrefix;
+	a_MsgSuffix = Rank->m_MsgSuffix;
+	a_MsgNameColorCode = Rank->m_MsgNameColorCode;
+	return true;
 }
 
 
@@ -1533,21 +1258,7 @@ bool cRankManager::RankExists(const AString & a_RankName)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
-	{
-		SQLite::Statement stmt(m_DB, "SELECT * FROM Rank WHERE Name = ?");
-		stmt.bind(1, a_RankName);
-		if (stmt.executeStep())
-		{
-			// The rank was found
-			return true;
-		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to query DB for rank %s: %s", __FUNCTION__, a_RankName.c_str(), ex.what());
-	}
-	return false;
+	return (FindRank(a_RankName) != nullptr);
 }
 
 
@@ -1559,21 +1270,7 @@ bool cRankManager::GroupExists(const AString & a_GroupName)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
-	{
-		SQLite::Statement stmt(m_DB, "SELECT * FROM PermGroup WHERE Name = ?");
-		stmt.bind(1, a_GroupName);
-		if (stmt.executeStep())
-		{
-			// The group was found
-			return true;
-		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to query DB for group %s: %s", __FUNCTION__, a_GroupName.c_str(), ex.what());
-	}
-	return false;
+	return (FindGroup(a_GroupName) != nullptr);
 }
 
 
@@ -1585,239 +1282,353 @@ bool cRankManager::IsPlayerRankSet(const cUUID & a_PlayerUUID)
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	AString StrUUID = a_PlayerUUID.ToShortString();
+	return (m_Players.find(a_PlayerUUID) != m_Players.end());
+}
 
-	try
-	{
-		SQLite::Statement stmt(m_DB, "SELECT * FROM PlayerRank WHERE PlayerUUID = ?");
-		stmt.bind(1, StrUUID);
-		if (stmt.executeStep())
-		{
-			// The player UUID was found, they have a rank
-			return true;
-		}
-	}
-	catch (const SQLite::Exception & ex)
+
+
+
+
+bool cRankManager::IsGroupInRank(const AString & a_GroupName, const AString & a_RankName)
+{
+	ASSERT(m_IsInitialized);
+	cCSLock Lock(m_CS);
+
+	auto Rank = FindRank(a_RankName);
+	if (Rank == nullptr)
 	{
-		LOGWARNING("%s: Failed to query DB for player UUID %s: %s", __FUNCTION__, StrUUID.c_str(), ex.what());
+		return false;
 	}
-	return false;
+	return (std::find(Rank->m_Groups.begin(), Rank->m_Groups.end(), a_GroupName) != Rank->m_Groups.end());
 }
 
 
 
 
 
-bool cRankManager::IsGroupInRank(const AString & a_GroupName, const AString & a_RankName)
+bool cRankManager::IsPermissionInGroup(const AString & a_Permission, const AString & a_GroupName)
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
+	auto Group = FindGroup(a_GroupName);
+	if (Group == nullptr)
 	{
-		SQLite::Statement stmt(m_DB,
-			"SELECT * FROM Rank "
-				"LEFT JOIN RankPermGroup ON Rank.RankID = RankPermGroup.RankID "
-				"LEFT JOIN PermGroup ON PermGroup.PermGroupID = RankPermGroup.PermGroupID "
-			"WHERE Rank.Name = ? AND PermGroup.Name = ?"
-		);
-		stmt.bind(1, a_RankName);
-		stmt.bind(2, a_GroupName);
-		if (stmt.executeStep())
-		{
-			// The group is in the rank
-			return true;
-		}
+		return false;
 	}
-	catch (const SQLite::Exception & ex)
+	return (std::find(Group->m_Permissions.begin(), Group->m_Permissions.end(), a_Permission) != Group->m_Permissions.end());
+}
+
+
+
+
+
+bool cRankManager::IsRestrictionInGroup(const AString & a_Restriction, const AString & a_GroupName)
+{
+	ASSERT(m_IsInitialized);
+	cCSLock Lock(m_CS);
+
+	auto Group = FindGroup(a_GroupName);
+	if (Group == nullptr)
 	{
-		LOGWARNING("%s: Failed to query DB: %s", __FUNCTION__, ex.what());
+		return false;
 	}
-	return false;
+	return (std::find(Group->m_Restrictions.begin(), Group->m_Restrictions.end(), a_Restriction) != Group->m_Restrictions.end());
 }
 
 
 
 
 
-bool cRankManager::IsPermissionInGroup(const AString & a_Permission, const AString & a_GroupName)
+void cRankManager::NotifyNameUUID(const AString & a_PlayerName, const cUUID & a_UUID)
+{
+	UpdatePlayerName(a_UUID, a_PlayerName);
+}
+
+
+
+
+
+bool cRankManager::SetDefaultRank(const AString & a_RankName)
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
+	// Find the rank's ID:
+	auto Rank = FindRank(a_RankName);
+	if (Rank == nullptr)
 	{
-		SQLite::Statement stmt(m_DB,
-			"SELECT * FROM PermissionItem "
-				"LEFT JOIN PermGroup ON PermGroup.PermGroupID = PermissionItem.PermGroupID "
-			"WHERE PermissionItem.Permission = ? AND PermGroup.Name = ?"
-		);
-		stmt.bind(1, a_Permission);
-		stmt.bind(2, a_GroupName);
-		if (stmt.executeStep())
+		LOGINFO("%s: Cannot set rank %s as the default, it does not exist.", __FUNCTION__, a_RankName.c_str());
+		return false;
+	}
+
+	// Set the rank as the default:
+	m_DefaultRank = a_RankName;
+	int RankID = Rank->m_ID;
+	m_DBWriter.Queue([=](SQLite::Database & a_DB)
 		{
-			// The permission is in the group
-			return true;
+			a_DB.exec("DELETE FROM DefaultRank");
+			SQLite::Statement stmt(a_DB, "INSERT INTO DefaultRank (RankID) VALUES (?)");
+			stmt.bind(1, RankID);
+			stmt.exec();
 		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to query DB: %s", __FUNCTION__, ex.what());
-	}
-	return false;
+	);
+	return true;
 }
 
 
 
 
 
-bool cRankManager::IsRestrictionInGroup(const AString & a_Restriction, const AString & a_GroupName)
+AString cRankManager::GetDefaultRank(void) const
+{
+	cCSLock Lock(m_CS);
+	return m_DefaultRank;
+}
+
+
+
+
+
+void cRankManager::ClearPlayerRanks(void)
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
-	{
-		SQLite::Statement stmt(m_DB,
-			"SELECT * FROM RestrictionItem "
-				"LEFT JOIN PermGroup ON PermGroup.PermGroupID = RestrictionItem.PermGroupID "
-			"WHERE RestrictionItem.Permission = ? AND PermGroup.Name = ?"
-		);
-		stmt.bind(1, a_Restriction);
-		stmt.bind(2, a_GroupName);
-		if (stmt.executeStep())
+	m_Players.clear();
+	m_DBWriter.Queue([](SQLite::Database & a_DB)
 		{
-			// The restriction is in the group
-			return true;
+			a_DB.exec("DELETE FROM PlayerRank");
 		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to query DB: %s", __FUNCTION__, ex.what());
-	}
-	return false;
+	);
 }
 
 
 
 
 
-void cRankManager::NotifyNameUUID(const AString & a_PlayerName, const cUUID & a_UUID)
+bool cRankManager::UpdatePlayerName(const cUUID & a_PlayerUUID, const AString & a_NewPlayerName)
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
-	try
+	auto itr = m_Players.find(a_PlayerUUID);
+	if (itr == m_Players.end())
 	{
-		SQLite::Statement stmt(m_DB, "UPDATE PlayerRank SET PlayerName = ? WHERE PlayerUUID = ?");
-		stmt.bind(1, a_PlayerName);
-		stmt.bind(2, a_UUID.ToShortString());
-		stmt.exec();
+		return false;
 	}
-	catch (const SQLite::Exception & ex)
+	if (itr->second.m_Name == a_NewPlayerName)
 	{
-		LOGWARNING("%s: Failed to update DB: %s", __FUNCTION__, ex.what());
+		// No change, no need to write anything:
+		return true;
 	}
+
+	itr->second.m_Name = a_NewPlayerName;
+	AString StrUUID = a_PlayerUUID.ToShortString();
+	m_DBWriter.Queue([=](SQLite::Database & a_DB)
+		{
+			SQLite::Statement stmt(a_DB, "UPDATE PlayerRank SET PlayerName = ? WHERE PlayerUUID = ?");
+			stmt.bind(1, a_NewPlayerName);
+			stmt.bind(2, StrUUID);
+			stmt.exec();
+		}
+	);
+	return true;
 }
 
 
 
 
 
-bool cRankManager::SetDefaultRank(const AString & a_RankName)
+bool cRankManager::Flush(void)
+{
+	return m_DBWriter.Flush();
+}
+
+
+
+
+
+void cRankManager::LoadFromDB(void)
 {
-	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
+	// Start afresh; the default rank is kept if the DB doesn't specify a valid one:
+	m_Ranks.clear();
+	m_Groups.clear();
+	m_Players.clear();
+
 	try
 	{
-		// Find the rank's ID:
-		int RankID = 0;
+		// Load the ranks:
+		std::map<int, AString> RankNames;
 		{
-			SQLite::Statement stmt(m_DB, "SELECT RankID FROM Rank WHERE Name = ?");
-			stmt.bind(1, a_RankName);
-			if (!stmt.executeStep())
+			SQLite::Statement stmt(m_DB, "SELECT RankID, Name, MsgPrefix, MsgSuffix, MsgNameColorCode FROM Rank ORDER BY RankID");
+			while (stmt.executeStep())
 			{
-				LOGINFO("%s: Cannot set rank %s as the default, it does not exist.", __FUNCTION__, a_RankName.c_str());
-				return false;
+				int RankID = stmt.getColumn(0).getInt();
+				AString Name = stmt.getColumn(1).getText();
+				RankNames[RankID] = Name;
+				m_Ranks[Name] = sRank{RankID, stmt.getColumn(2).getText(), stmt.getColumn(3).getText(), stmt.getColumn(4).getText(), {}};
+				m_NextRankID = std::max(m_NextRankID, RankID + 1);
 			}
 		}
 
-		// Set the rank as the default:
+		// Load the groups:
+		std::map<int, sGroup *> Groups;
+		std::map<int, AString> GroupNames;
 		{
-			SQLite::Statement stmt(m_DB, "UPDATE DefaultRank SET RankID = ?");
-			stmt.bind(1, RankID);
-			if (stmt.exec() < 1)
+			SQLite::Statement stmt(m_DB, "SELECT PermGroupID, Name FROM PermGroup ORDER BY PermGroupID");
+			while (stmt.executeStep())
+			{
+				int GroupID = stmt.getColumn(0).getInt();
+				AString Name = stmt.getColumn(1).getText();
+				auto & Group = m_Groups[Name];
+				Group.m_ID = GroupID;
+				Groups[GroupID] = &Group;
+				GroupNames[GroupID] = Name;
+				m_NextGroupID = std::max(m_NextGroupID, GroupID + 1);
+			}
+		}
+
+		// Load the rank-to-group bindings, ignoring those referencing non-existent ranks or groups:
+		{
+			SQLite::Statement stmt(m_DB, "SELECT RankID, PermGroupID FROM RankPermGroup");
+			while (stmt.executeStep())
 			{
-				// Failed to update, there might be none in the DB, try inserting:
-				SQLite::Statement stmt2(m_DB, "INSERT INTO DefaultRank (RankID) VALUES (?)");
-				stmt2.bind(1, RankID);
-				if (stmt2.exec() < 1)
+				auto RankName = RankNames.find(stmt.getColumn(0).getInt());
+				auto GroupName = GroupNames.find(stmt.getColumn(1).getInt());
+				if ((RankName == RankNames.end()) || (GroupName == GroupNames.end()))
+				{
+					continue;
+				}
+				auto & RankGroups = m_Ranks[RankName->second].m_Groups;
+				if (std::find(RankGroups.begin(), RankGroups.end(), GroupName->second) == RankGroups.end())
 				{
-					LOGINFO("%s: Cannot update the default rank in the DB to %s.", __FUNCTION__, a_RankName.c_str());
-					return false;
+					RankGroups.push_back(GroupName->second);
 				}
 			}
 		}
 
-		// Set the internal cache:
-		m_DefaultRank = a_RankName;
-		return true;
+		// Load the permissions and restrictions:
+		for (bool IsRestriction: {false, true})
+		{
+			SQLite::Statement stmt(m_DB, IsRestriction ?
+				"SELECT PermGroupID, Permission FROM RestrictionItem" :
+				"SELECT PermGroupID, Permission FROM PermissionItem"
+			);
+			while (stmt.executeStep())
+			{
+				auto Group = Groups.find(stmt.getColumn(0).getInt());
+				if (Group == Groups.end())
+				{
+					continue;
+				}
+				auto & Items = IsRestriction ? Group->second->m_Restrictions : Group->second->m_Permissions;
+				AString Item = stmt.getColumn(1).getText();
+				if (std::find(Items.begin(), Items.end(), Item) == Items.end())
+				{
+					Items.push_back(std::move(Item));
+				}
+			}
+		}
+
+		// Load the players:
+		{
+			cUUID UUID;
+			SQLite::Statement stmt(m_DB, "SELECT PlayerUUID, PlayerName, RankID FROM PlayerRank");
+			while (stmt.executeStep())
+			{
+				auto RankName = RankNames.find(stmt.getColumn(2).getInt());
+				if (!UUID.FromString(stmt.getColumn(0).getText()) || (RankName == RankNames.end()))
+				{
+					// Invalid UUID or rank, ignore
+					continue;
+				}
+				m_Players[UUID] = sPlayer{stmt.getColumn(1).getText(), RankName->second};
+			}
+		}
+
+		// Load the default rank:
+		{
+			SQLite::Statement stmt(m_DB, "SELECT RankID FROM DefaultRank");
+			if (stmt.executeStep())
+			{
+				auto RankName = RankNames.find(stmt.getColumn(0).getInt());
+				if (RankName != RankNames.end())
+				{
+					m_DefaultRank = RankName->second;
+				}
+			}
+		}
 	}
 	catch (const SQLite::Exception & ex)
 	{
-		LOGWARNING("%s: Failed to update DB: %s", __FUNCTION__, ex.what());
-		return false;
+		LOGWARNING("%s: Failed to load the ranks from the DB: %s", __FUNCTION__, ex.what());
+	}
+	if (m_Ranks.find(m_DefaultRank) == m_Ranks.end())
+	{
+		m_DefaultRank.clear();
 	}
+
+	LOGD("Loaded %zu ranks, %zu groups and %zu players from the DB", m_Ranks.size(), m_Groups.size(), m_Players.size());
 }
 
 
 
 
 
-void cRankManager::ClearPlayerRanks(void)
+cRankManager::sRank * cRankManager::FindRank(const AString & a_RankName)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	try
-	{
-		SQLite::Statement stmt(m_DB, "DELETE FROM PlayerRank");
-		stmt.exec();
-	}
-	catch (SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to remove / clear all players: %s", __FUNCTION__, ex.what());
-	}
+	auto itr = m_Ranks.find(a_RankName);
+	return (itr == m_Ranks.end()) ? nullptr : &itr->second;
 }
 
 
 
 
 
-bool cRankManager::UpdatePlayerName(const cUUID & a_PlayerUUID, const AString & a_NewPlayerName)
+cRankManager::sGroup * cRankManager::FindGroup(const AString & a_GroupName)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
+	auto itr = m_Groups.find(a_GroupName);
+	return (itr == m_Groups.end()) ? nullptr : &itr->second;
+}
 
-	AString StrUUID = a_PlayerUUID.ToShortString();
 
-	try
+
+
+
+void cRankManager::AppendRankItems(const AString & a_RankName, bool a_Restrictions, AStringVector & a_Dest)
+{
+	auto Rank = FindRank(a_RankName);
+	if (Rank == nullptr)
 	{
-		SQLite::Statement stmt(m_DB, "UPDATE PlayerRank SET PlayerName = ? WHERE PlayerUUID = ?");
-		stmt.bind(1, a_NewPlayerName);
-		stmt.bind(2, StrUUID);
-		if (stmt.exec() > 0)
+		return;
+	}
+	for (const auto & GroupName: Rank->m_Groups)
+	{
+		auto Group = FindGroup(GroupName);
+		if (Group == nullptr)
 		{
-			// The player name was changed, returns true
-			return true;
+			continue;
 		}
+		const auto & Items = a_Restrictions ? Group->m_Restrictions : Group->m_Permissions;
+		a_Dest.insert(a_Dest.end(), Items.begin(), Items.end());
 	}
-	catch (const SQLite::Exception & ex)
+}
+
+
+
+
+
+const AString & cRankManager::GetEffectiveRankName(const cUUID & a_PlayerUUID) const
+{
+	auto itr = m_Players.find(a_PlayerUUID);
+	if (itr == m_Players.end())
 	{
-		LOGWARNING("%s: Failed to update player name from UUID %s: %s", __FUNCTION__, StrUUID.c_str(), ex.what());
+		return m_DefaultRank;
 	}
-	return false;
+	return itr->second.m_RankName;
 }
 
 
@@ -1860,7 +1671,7 @@ bool cRankManager::IsDBTableEmpty(const AString & a_TableName)
 
 void cRankManager::CreateDefaults(void)
 {
-	// Wrap everything in a big transaction to speed things up:
+	// Make the defaults appear all at once:
 	cMassChangeLock Lock(*this);
 
 	// Create ranks:
@@ -1948,7 +1759,3 @@ void cRankManager::CreateColumnIfNotExists(const char * a_TableName, const char
 		LOGWARNING("%s: Failed to query DB: %s", __FUNCTION__, exc.what());
 	}
 }
-
-
-
-
@@ -3,13 +3,22 @@
 
 // Declares the cRankManager class that represents the rank manager responsible for assigning permissions and message visuals to players
 
+/*
+The rank manager keeps the entire contents of the DB (ranks, groups, permissions, restrictions and player
+assignments) in memory, loaded in Initialize(). All the queries are answered from the in-memory model and never
+touch the DB. The changes are applied to the model immediately (write-through) and queued as DB writes for the
+writer thread, which executes everything that has been queued so far as a single transaction.
+If any of the writes fails, the model is reloaded from the DB, so that the failed change is rolled back in memory, too,
+instead of the model and the DB silently diverging.
+*/
 
 
 
 #pragma once
 
 #include "SQLiteCpp/Database.h"
-#include "SQLiteCpp/Transaction.h"
+#include "OSSupport/IsThread.h"
+#include "UUID.h"
 
 
 
@@ -25,30 +34,24 @@ class cRankManager
 {
 public:
 	/** Acquire this lock to perform mass changes.
-	Improves performance by wrapping everything into a transaction.
-	Makes sure that no other thread is accessing the DB. */
+	Makes sure that no other thread sees the partially changed data.
+	The DB writes queued while the lock is held end up in the same transaction, unless the writer thread is
+	already idle-waiting and picks up some of them earlier. */
 	class cMassChangeLock
 	{
 	public:
 		cMassChangeLock(cRankManager & a_RankManager) :
-			m_Lock(a_RankManager.m_CS),
-			m_Transaction(a_RankManager.m_DB)
+			m_Lock(a_RankManager.m_CS)
 		{
 		}
 
-		~cMassChangeLock()
-		{
-			m_Transaction.commit();
-		}
-
 	protected:
 		cCSLock m_Lock;
-		SQLite::Transaction m_Transaction;
 	};
 
 
-	/** Creates the rank manager. Needs to be initialized before other use. */
-	cRankManager(void);
+	/** Creates the rank manager, using the specified DB file for storage. Needs to be initialized before other use. */
+	cRankManager(const AString & a_DBFileName = "Ranks.sqlite");
 
 	~cRankManager();
 
@@ -250,7 +253,7 @@ public:
 	bool SetDefaultRank(const AString & a_RankName);
 
 	/** Returns the name of the default rank. */
-	const AString & GetDefaultRank(void) const { return m_DefaultRank; }
+	AString GetDefaultRank(void) const;
 
 	/** Removes all player ranks from the database. Note that this doesn't change the cPlayer instances
 	for the already connected players, you need to update all the instances manually. */
@@ -259,16 +262,137 @@ public:
 	/** Updates the playername that is saved with this uuid. Returns false if a error occurred */
 	bool UpdatePlayerName(const cUUID & a_PlayerUUID, const AString & a_NewPlayerName);
 
+	/** Blocks until all the changes made so far have been written to the DB.
+	Returns false if some of the changes failed to write; these have been rolled back in the model. */
+	bool Flush(void);
+
 protected:
 
-	/** The database storage for all the data. Protected by m_CS. */
+	/** A single DB write, executed on the writer thread. */
+	using cDBWrite = std::function<void(SQLite::Database &)>;
+
+	/** The thread that executes the queued DB writes, in batches, each batch in a single transaction. */
+	class cDBWriter:
+		public cIsThread
+	{
+		using Super = cIsThread;
+
+	public:
+
+		cDBWriter(cRankManager & a_RankManager);
+		virtual ~cDBWriter() override;
+
+		/** Adds the write to the queue and wakes up the thread. */
+		void Queue(cDBWrite && a_Write);
+
+		/** Executes all the currently queued writes on the caller thread, in a single transaction.
+		If any of them fails, reloads the model from the DB. Serialized with the writer thread. */
+		void ExecuteBatch(void);
+
+		/** Executes all the currently queued writes on the caller thread.
+		Returns false if any write has failed since the previous Flush(), on either thread. */
+		bool Flush(void);
+
+		void Stop(void);
+
+	protected:
+
+		/** The rank manager whose DB is written, and whose model is reloaded after a failed write.
+		Its DB is accessed only in ExecuteBatch(), under m_CSExecute. */
+		cRankManager & m_RankManager;
+
+		/** Protects m_Queue. */
+		cCriticalSection m_CSQueue;
+
+		/** Serializes the batch execution between the writer thread and Flush().
+		When locked together with the rank manager's m_CS, m_CS must be locked first. */
+		cCriticalSection m_CSExecute;
+
+		/** The writes that haven't been executed yet, in the order in which they were queued. */
+		std::vector<cDBWrite> m_Queue;
+
+		/** Set when a write is queued, or when the thread should terminate. */
+		cEvent m_Event;
+
+		/** Set when a write fails, cleared by Flush(). Protected by m_CSExecute. */
+		bool m_HasFailedWrites;
+
+		/** Set when a write fails, cleared when the model is reloaded from the DB. Protected by m_CSExecute. */
+		bool m_NeedsReload;
+
+
+		/** Executes all the currently queued writes in a single transaction, each failed write is rolled back on its own.
+		Returns false if any of the writes failed. Must be called with m_CSExecute locked. */
+		bool WriteQueued(void);
+
+		/** Reloads the rank manager's model from the DB, if a write has failed since the last reload. */
+		void ReloadIfNeeded(void);
+
+
+		// cIsThread overrides:
+		virtual void Execute(void) override;
+	};
+
+
+	/** A single rank, as stored in the in-memory model. */
+	struct sRank
+	{
+		/** The RankID in the DB; also determines the order in which the ranks were created. */
+		int m_ID;
+
+		AString m_MsgPrefix;
+		AString m_MsgSuffix;
+		AString m_MsgNameColorCode;
+
+		/** Names of the groups assigned to the rank, in the order of assignment. */
+		AStringVector m_Groups;
+	};
+
+	/** A single permission group, as stored in the in-memory model. */
+	struct sGroup
+	{
+		/** The PermGroupID in the DB; also determines the order in which the groups were created. */
+		int m_ID;
+
+		AStringVector m_Permissions;
+		AStringVector m_Restrictions;
+	};
+
+	/** A single player's rank assignment, as stored in the in-memory model. */
+	struct sPlayer
+	{
+		AString m_Name;
+		AString m_RankName;
+	};
+
+
+	/** The database storage for all the data.
+	Used directly only while initializing, afterwards accessed only through m_DBWriter. */
 	SQLite::Database m_DB;
 
-	/** The name of the default rank. Kept as a cache so that queries for it don't need to go through the DB. */
+	/** The name of the default rank. */
 	AString m_DefaultRank;
 
-	/** The mutex protecting m_DB and m_DefaultRank against multi-threaded access. */
-	cCriticalSection m_CS;
+	/** The mutex protecting the in-memory model against multi-threaded access. */
+	mutable cCriticalSection m_CS;
+
+	/** All the ranks, by their name. Protected by m_CS. */
+	std::map<AString, sRank> m_Ranks;
+
+	/** All the permission groups, by their name. Protected by m_CS. */
+	std::map<AString, sGroup> m_Groups;
+
+	/** All the players that have a rank assigned. Protected by m_CS. */
+	std::map<cUUID, sPlayer> m_Players;
+
+	/** The ID to assign to the next created rank. Protected by m_CS. */
+	int m_NextRankID;
+
+	/** The ID to assign to the next created group. Protected by m_CS. */
+	int m_NextGroupID;
+
+	/** The thread writing the changes into m_DB. */
+	cDBWriter m_DBWriter;
 
 	/** Set to true once the manager is initialized. */
 	bool m_IsInitialized;
@@ -278,6 +402,22 @@ protected:
 	cMojangAPI * m_MojangAPI;
 
 
+	/** Loads the entire contents of the DB into the in-memory model, replacing whatever the model contained. */
+	void LoadFromDB(void);
+
+	/** Returns the rank with the specified name, or nullptr if there's no such rank. Assumes m_CS is held. */
+	sRank * FindRank(const AString & a_RankName);
+
+	/** Returns the group with the specified name, or nullptr if there's no such group. Assumes m_CS is held. */
+	sGroup * FindGroup(const AString & a_GroupName);
+
+	/** Appends the permissions (or restrictions, if a_Restrictions is true) of all the rank's groups to a_Dest.
+	Assumes m_CS is held. */
+	void AppendRankItems(const AString & a_RankName, bool a_Restrictions, AStringVector & a_Dest);
+
+	/** Returns the name of the rank that decides the player's permissions - the assigned one or the default. Assumes m_CS is held. */
+	const AString & GetEffectiveRankName(const cUUID & a_PlayerUUID) const;
+
 	/** Returns true if all the DB tables are empty, indicating a fresh new install. */
 	bool AreDBTablesEmpty(void);
 
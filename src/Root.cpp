@@ -38,6 +38,7 @@
 #include "Bindings/PluginManager.h"
 #include "MonsterConfig.h"
 #include "Entities/Player.h"
+#include "WorldStorage/PlayerDataWriter.h"
 #include "Blocks/BlockHandler.h"
 #include "Items/ItemHandler.h"
 #include "Chunk.h"
@@ -81,7 +82,9 @@ cRoot::cRoot(void) :
 	m_BrewingRecipes(nullptr),
 	m_WebAdmin(nullptr),
 	m_PluginManager(nullptr),
-	m_MojangAPI(nullptr)
+	m_MojangAPI(nullptr),
+	m_DeadlockDetect(nullptr),
+	m_PlayerDataWriter(std::make_unique<cPlayerDataWriter>())
 {
 	s_Root = this;
 	TransitionNextState(NextState::Run);
@@ -124,6 +127,7 @@ bool cRoot::Run(cSettingsRepositoryInterface & a_OverridesRepo)
 #endif
 
 	cDeadlockDetect dd;
+	m_DeadlockDetect = &dd;
 	auto BeginTime = std::chrono::steady_clock::now();
 
 	LoadGlobalSettings();
@@ -168,6 +172,11 @@ bool cRoot::Run(cSettingsRepositoryInterface & a_OverridesRepo)
 	m_WebAdmin = new cWebAdmin();
 	m_WebAdmin->Init();
 
+	LOGD("Starting player data writer...");
+	m_PlayerDataWriter->Start(cPlayerDataWriter::FormatFromString(
+		settingsRepo->GetValueSet("PlayerData", "Format", "Json"), cPlayerDataWriter::eFormat::Json
+	));
+
 	LOGD("Loading settings...");
 	m_RankManager.reset(new cRankManager());
 	m_RankManager->Initialize(*m_MojangAPI);
@@ -193,11 +202,11 @@ bool cRoot::Run(cSettingsRepositoryInterface & a_OverridesRepo)
 	LOGD("Starting worlds...");
 	StartWorlds(dd);
 
-	if (settingsRepo->GetValueSetB("DeadlockDetect", "Enabled", true))
-	{
-		LOGD("Starting deadlock detector...");
-		dd.Start(settingsRepo->GetValueSetI("DeadlockDetect", "IntervalSec", 20));
-	}
+	// The thread runs even with the detection disabled, it also drives the sampling profiler:
+	LOGD("Starting deadlock detector...");
+	const bool IsDeadlockDetectEnabled = settingsRepo->GetValueSetB("DeadlockDetect", "Enabled", true);
+	const int DeadlockDetectInterval = settingsRepo->GetValueSetI("DeadlockDetect", "IntervalSec", 20);
+	dd.Start(IsDeadlockDetectEnabled ? std::max(DeadlockDetectInterval, 1) : 0);
 
 	settingsRepo->Flush();
 
@@ -228,6 +237,11 @@ bool cRoot::Run(cSettingsRepositoryInterface & a_OverridesRepo)
 
 	LOGD("Stopping world threads...");
 	StopWorlds(dd);
+	m_DeadlockDetect = nullptr;
+
+	LOGD("Writing player data...");
+	m_PlayerDataWriter->Stop();
+	m_PlayerDataWriter->Flush();
 
 	LOGD("Stopping authenticator...");
 	m_Authenticator.Stop();
@@ -432,7 +446,7 @@ void cRoot::StartWorlds(cDeadlockDetect & a_DeadlockDetect)
 	for (auto & Entry : m_WorldsByName)
 	{
 		auto & World = Entry.second;
-		World.Start();
+		World.Start(a_DeadlockDetect);
 		World.InitializeSpawn();
 		m_PluginManager->CallHookWorldStarted(World);
 	}
@@ -963,6 +977,12 @@ void cRoot::LogChunkStats(cCommandOutputCallback & a_Output)
 		a_Output.Out("    block lighting: %6zu bytes (%3zu KiB)", 2 * sizeof(cChunkDef::BlockNibbles), (2 * sizeof(cChunkDef::BlockNibbles) + 1023) / 1024);
 		a_Output.Out("    heightmap:      %6zu bytes (%3zu KiB)", sizeof(cChunkDef::HeightMap), (sizeof(cChunkDef::HeightMap) + 1023) / 1024);
 		a_Output.Out("    biomemap:       %6zu bytes (%3zu KiB)", sizeof(cChunkDef::BiomeMap), (sizeof(cChunkDef::BiomeMap) + 1023) / 1024);
+		const auto & BlockChanges = World.GetChunkMap()->GetBlockChangeStats();
+		a_Output.Out("  Block changes queued for clients: %llu", BlockChanges.m_NumQueued.load());
+		a_Output.Out("  Block changes coalesced within a tick: %llu", BlockChanges.m_NumCoalesced.load());
+		a_Output.Out("  Block change packets sent: %llu", BlockChanges.m_NumPacketsSent.load());
+		a_Output.Out("  Chunks resent instead of block changes: %llu", BlockChanges.m_NumChunkResends.load());
+		a_Output.Out("  Chunk resends avoided by coalescing: %llu", BlockChanges.m_NumChunkResendsAvoided.load());
 		SumNumValid += NumValid;
 		SumNumDirty += NumDirty;
 		SumNumInLighting += NumInLighting;
@@ -24,6 +24,7 @@ class cPluginManager;
 class cServer;
 class cWorld;
 class cPlayer;
+class cPlayerDataWriter;
 class cCommandOutputCallback;
 class cCompositeChat;
 class cSettingsRepositoryInterface;
@@ -112,6 +113,10 @@ public:
 	cAuthenticator &   GetAuthenticator  (void) { return m_Authenticator; }
 	cMojangAPI &       GetMojangAPI      (void) { return *m_MojangAPI; }
 	cRankManager *     GetRankManager    (void) { return m_RankManager.get(); }
+	cPlayerDataWriter & GetPlayerDataWriter(void) { return *m_PlayerDataWriter; }
+
+	/** Returns the deadlock detector, which also drives the sampling profiler. Valid only while the server is running. */
+	cDeadlockDetect & GetDeadlockDetect(void) { ASSERT(m_DeadlockDetect != nullptr); return *m_DeadlockDetect; }
 
 	/** Queues a console command for execution through the cServer class.
 	The command will be executed in the tick thread
@@ -230,6 +235,12 @@ private:
 	cAuthenticator     m_Authenticator;
 	cMojangAPI *       m_MojangAPI;
 
+	/** The deadlock detector living in Start(), nullptr outside of it. */
+	cDeadlockDetect *  m_DeadlockDetect;
+
+	/** Writes the player data files in the background; stopped after the worlds, once all the players have been saved. */
+	std::unique_ptr<cPlayerDataWriter> m_PlayerDataWriter;
+
 	std::unique_ptr<cRankManager> m_RankManager;
 
 	cHTTPServer m_HTTPServer;
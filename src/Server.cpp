@@ -17,6 +17,7 @@
 #include "Protocol/ProtocolRecognizer.h"
 #include "CommandOutput.h"
 #include "FastRandom.h"
+#include "DeadlockDetect.h"
 
 #include "IniFile.h"
 
@@ -204,6 +205,7 @@ bool cServer::InitServer(cSettingsRepositoryInterface & a_Settings, bool a_Shoul
 	}
 
 	m_ShouldAllowMultiWorldTabCompletion = a_Settings.GetValueSetB("Server", "AllowMultiWorldTabCompletion", true);
+	m_CompressionPolicy.Load(a_Settings);
 	m_ShouldLimitPlayerBlockChanges = a_Settings.GetValueSetB("AntiCheat", "LimitPlayerBlockChanges", true);
 
 	const auto ClientViewDistance = a_Settings.GetValueSetI("Server", "DefaultViewDistance", cClientHandle::DEFAULT_VIEW_DISTANCE);
@@ -571,6 +573,90 @@ void cServer::ExecuteConsoleCommand(const AString & a_Cmd, cCommandOutputCallbac
 		a_Output.Finished();
 		return;
 	}
+	else if (split[0].compare("hookstats") == 0)
+	{
+		a_Output.Out(cPluginManager::Get()->GetHookStats((split.size() > 1) && (split[1] == "reset")));
+		a_Output.Finished();
+		return;
+	}
+	else if (split[0].compare("pluginstats") == 0)
+	{
+		// "pluginstats reset" or "pluginstats [PluginName]":
+		if ((split.size() > 1) && (split[1] == "reset"))
+		{
+			cPluginManager::Get()->ResetPluginCpuStats();
+			a_Output.Out("The plugin CPU time statistics have been reset");
+		}
+		else
+		{
+			a_Output.Out(cPluginManager::Get()->GetPluginCpuStats((split.size() > 1) ? split[1] : AString()));
+		}
+		a_Output.Finished();
+		return;
+	}
+	else if (split[0].compare("tickprofile") == 0)
+	{
+		// "tickprofile reset" or "tickprofile [NumTop]":
+		const bool ShouldReset = (split.size() > 1) && (split[1] == "reset");
+		size_t NumTop = 5;
+		if (!ShouldReset && (split.size() > 1) && (!StringToInteger(split[1], NumTop) || (NumTop == 0)))
+		{
+			a_Output.Out("Usage: tickprofile [reset | <NumTop>]");
+			a_Output.Finished();
+			return;
+		}
+		cRoot::Get()->ForEachWorld([&a_Output, ShouldReset, NumTop](cWorld & a_World)
+			{
+				if (ShouldReset)
+				{
+					a_World.GetTickProfiler().Reset();
+					return false;
+				}
+				a_Output.Out("World \"%s\": %s", a_World.GetName(), a_World.GetTickProfiler().GetReport(NumTop));
+				return false;
+			}
+		);
+		if (ShouldReset)
+		{
+			a_Output.Out("The tick profiles have been reset");
+		}
+		a_Output.Finished();
+		return;
+	}
+	else if (split[0].compare("stackprofile") == 0)
+	{
+		HandleStackProfileCommand(split, a_Output);
+		a_Output.Finished();
+		return;
+	}
+	else if (split[0].compare("compressionstats") == 0)
+	{
+		a_Output.Out(m_CompressionPolicy.GetStats((split.size() > 1) && (split[1] == "reset")));
+		a_Output.Finished();
+		return;
+	}
+	else if (split[0].compare("netstats") == 0)
+	{
+		a_Output.Out("%-16s %10s %10s %10s %10s %8s %10s", "Player", "Critical", "Entity", "Chunk", "Link", "Stalls", "StallTime");
+		cRoot::Get()->ForEachPlayer([&a_Output](cPlayer & a_Player)
+			{
+				const auto Stats = a_Player.GetClientHandle()->GetOutgoingStats();
+				a_Output.Out("%-16s %8.1fKiB %8.1fKiB %8.1fKiB %8.1fKiB %8llu %8.1fs%s",
+					a_Player.GetName(),
+					static_cast<double>(Stats.m_NumQueuedBytes[static_cast<size_t>(cProtocol::ePacketPriority::Critical)]) / 1024,
+					static_cast<double>(Stats.m_NumQueuedBytes[static_cast<size_t>(cProtocol::ePacketPriority::Entity)]) / 1024,
+					static_cast<double>(Stats.m_NumQueuedBytes[static_cast<size_t>(cProtocol::ePacketPriority::Chunk)]) / 1024,
+					static_cast<double>(Stats.m_LinkQueueSize) / 1024,
+					static_cast<unsigned long long>(Stats.m_NumStalls),
+					static_cast<double>(Stats.m_StallTime.count()) / 1000,
+					Stats.m_IsStalled ? " (stalled)" : ""
+				);
+				return false;
+			}
+		);
+		a_Output.Finished();
+		return;
+	}
 	else if (cPluginManager::Get()->ExecuteConsoleCommand(split, a_Output, a_Cmd))
 	{
 		a_Output.Finished();
@@ -585,6 +671,61 @@ void cServer::ExecuteConsoleCommand(const AString & a_Cmd, cCommandOutputCallbac
 
 
 
+void cServer::HandleStackProfileCommand(const AStringVector & a_Split, cCommandOutputCallback & a_Output)
+{
+	auto & DeadlockDetect = cRoot::Get()->GetDeadlockDetect();
+	auto & Profiler = DeadlockDetect.GetSamplingProfiler();
+	if ((a_Split.size() >= 2) && (a_Split[1] == "start"))
+	{
+		int Interval = 10;
+		if ((a_Split.size() >= 3) && (!StringToInteger(a_Split[2], Interval) || (Interval <= 0)))
+		{
+			a_Output.Out("Usage: stackprofile start [IntervalMS]");
+			return;
+		}
+		if (!DeadlockDetect.StartSampling(std::chrono::milliseconds(Interval)))
+		{
+			a_Output.Out("Stack sampling is not supported on this platform");
+			return;
+		}
+		a_Output.Out("Sampling the world tick threads every %d ms", Interval);
+		return;
+	}
+	if ((a_Split.size() >= 2) && (a_Split[1] == "stop"))
+	{
+		DeadlockDetect.StopSampling();
+		cFile::CreateFolder("logs");
+		const AString FileName = (a_Split.size() >= 3) ? a_Split[2] : fmt::format(FMT_STRING("logs{}stackprofile.folded"), cFile::PathSeparator());
+		cFile File(FileName, cFile::fmWrite);
+		if (!File.IsOpen())
+		{
+			a_Output.Out("Cannot open file \"%s\" for writing, the samples are kept", FileName);
+			return;
+		}
+		File.Write(Profiler.GetFoldedStacks());
+		a_Output.Out("Wrote %llu samples to \"%s\" (%llu failed)",
+			static_cast<unsigned long long>(Profiler.GetNumSamples()), FileName,
+			static_cast<unsigned long long>(Profiler.GetNumFailedSamples())
+		);
+		Profiler.Clear();
+		return;
+	}
+	if (a_Split.size() >= 2)
+	{
+		a_Output.Out("Usage: stackprofile [start [IntervalMS] | stop [FileName]]");
+		return;
+	}
+	a_Output.Out("Stack sampling is %s, %llu samples taken (%llu failed)",
+		DeadlockDetect.IsSampling() ? "running" : "stopped",
+		static_cast<unsigned long long>(Profiler.GetNumSamples()),
+		static_cast<unsigned long long>(Profiler.GetNumFailedSamples())
+	);
+}
+
+
+
+
+
 void cServer::PrintHelp(const AStringVector & a_Split, cCommandOutputCallback & a_Output)
 {
 	UNUSED(a_Split);
@@ -657,6 +798,12 @@ void cServer::BindBuiltInConsoleCommands(void)
 	PlgMgr->BindConsoleCommand("load",            nullptr, handler, "Adds and enables the specified plugin");
 	PlgMgr->BindConsoleCommand("unload",          nullptr, handler, "Disables the specified plugin");
 	PlgMgr->BindConsoleCommand("destroyentities", nullptr, handler, "Destroys all entities in all worlds");
+	PlgMgr->BindConsoleCommand("hookstats",       nullptr, handler, "Displays the plugin hook dispatch statistics, \"hookstats reset\" resets them");
+	PlgMgr->BindConsoleCommand("compressionstats", nullptr, handler, "Displays the bytes saved and the CPU time of the compression at each level, \"compressionstats reset\" resets them");
+	PlgMgr->BindConsoleCommand("netstats",        nullptr, handler, "Displays the outgoing data queued for each player and the stalls of their chunk data");
+	PlgMgr->BindConsoleCommand("pluginstats",     nullptr, handler, "Displays the time spent in each plugin's callbacks, \"pluginstats <PluginName>\" lists all the plugin's callbacks, \"pluginstats reset\" resets them");
+	PlgMgr->BindConsoleCommand("stackprofile",    nullptr, handler, "Samples the world tick threads' stacks: \"stackprofile start [IntervalMS]\", \"stackprofile stop [FileName]\" writes the flame graph folded stacks");
+	PlgMgr->BindConsoleCommand("tickprofile",     nullptr, handler, "Displays the tick phase times and the top N chunks, plugin hooks and simulators in the slow ticks of each world, \"tickprofile reset\" resets them");
 }
 
 
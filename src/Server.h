@@ -10,6 +10,7 @@
 #pragma once
 
 #include "RCONServer.h"
+#include "Protocol/CompressionPolicy.h"
 #include "OSSupport/IsThread.h"
 #include "OSSupport/Network.h"
 
@@ -153,6 +154,9 @@ public:
 	from the settings. */
 	bool ShouldAllowMultiWorldTabCompletion(void) const { return m_ShouldAllowMultiWorldTabCompletion; }
 
+	/** Returns the policy of compressing the data sent to the clients. */
+	cCompressionPolicy & GetCompressionPolicy(void) { return m_CompressionPolicy; }
+
 	/** Get the Forge mods (map of ModName -> ModVersionString) registered for a given protocol. */
 	const AStringMap & GetRegisteredForgeMods(const UInt32 a_Protocol);
 
@@ -243,6 +247,9 @@ private:
 	/** True if usernames should be completed across worlds. */
 	bool m_ShouldAllowMultiWorldTabCompletion;
 
+	/** The policy of compressing the data sent to the clients, read from the settings in InitServer(). */
+	cCompressionPolicy m_CompressionPolicy;
+
 	/** The list of ports on which the server should listen for connections.
 	Initialized in InitServer(), used in Start(). */
 	AStringVector m_Ports;
@@ -265,6 +272,9 @@ private:
 	/** Executes the console command, sends output through the specified callback. */
 	void ExecuteConsoleCommand(const AString & a_Cmd, cCommandOutputCallback & a_Output);
 
+	/** Executes the "stackprofile" console command that controls the sampling profiler in cDeadlockDetect. */
+	void HandleStackProfileCommand(const AStringVector & a_Split, cCommandOutputCallback & a_Output);
+
 	/** Get the Forge mods registered for a given protocol, for modification */
 	AStringMap & RegisteredForgeMods(const UInt32 a_Protocol);
 
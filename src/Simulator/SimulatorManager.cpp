@@ -3,7 +3,9 @@
 
 #include "SimulatorManager.h"
 #include "../Chunk.h"
+#include "../Cuboid.h"
 #include "../World.h"
+#include "../Metrics.h"
 
 
 
@@ -11,7 +13,9 @@
 
 cSimulatorManager::cSimulatorManager(cWorld & a_World) :
 	m_World(a_World),
-	m_Ticks(0)
+	m_Ticks(0),
+	m_NumChunksSimulatedMetric(cMetrics::Get().GetCounter("cuberite_simulator_chunks_total", "The number of the chunks passed to the simulators", {{"world", a_World.GetName()}})),
+	m_NumWakeUpsMetric(cMetrics::Get().GetCounter("cuberite_simulator_wakeups_total", "The number of the block changes that woke up the simulators", {{"world", a_World.GetName()}}))
 {
 }
 
@@ -30,11 +34,22 @@ cSimulatorManager::~cSimulatorManager()
 void cSimulatorManager::Simulate(float a_Dt)
 {
 	m_Ticks++;
-	for (cSimulators::iterator itr = m_Simulators.begin(); itr != m_Simulators.end(); ++itr)
+	auto & Profiler = m_World.GetTickProfiler();
+	for (const auto & Item : m_Simulators)
 	{
-		if ((m_Ticks % itr->second) == 0)
+		if ((m_Ticks % Item.m_Rate) != 0)
 		{
-			itr->first->Simulate(a_Dt);
+			continue;
+		}
+		if (Profiler.IsCapturingDetails())
+		{
+			const auto Start = std::chrono::steady_clock::now();
+			Item.m_Simulator->Simulate(a_Dt);
+			Profiler.AddSimulatorTiming(Item.m_Name, std::chrono::steady_clock::now() - Start);
+		}
+		else
+		{
+			Item.m_Simulator->Simulate(a_Dt);
 		}
 	}
 }
@@ -46,11 +61,23 @@ void cSimulatorManager::Simulate(float a_Dt)
 void cSimulatorManager::SimulateChunk(std::chrono::milliseconds a_Dt, int a_ChunkX, int a_ChunkZ, cChunk * a_Chunk)
 {
 	// m_Ticks has already been increased in Simulate()
-	for (cSimulators::iterator itr = m_Simulators.begin(); itr != m_Simulators.end(); ++itr)
+	m_NumChunksSimulatedMetric.Add();
+	auto & Profiler = m_World.GetTickProfiler();
+	for (const auto & Item : m_Simulators)
 	{
-		if ((m_Ticks % itr->second) == 0)
+		if ((m_Ticks % Item.m_Rate) != 0)
 		{
-			itr->first->SimulateChunk(a_Dt, a_ChunkX, a_ChunkZ, a_Chunk);
+			continue;
+		}
+		if (Profiler.IsCapturingDetails())
+		{
+			const auto Start = std::chrono::steady_clock::now();
+			Item.m_Simulator->SimulateChunk(a_Dt, a_ChunkX, a_ChunkZ, a_Chunk);
+			Profiler.AddSimulatorTiming(Item.m_Name, std::chrono::steady_clock::now() - Start);
+		}
+		else
+		{
+			Item.m_Simulator->SimulateChunk(a_Dt, a_ChunkX, a_ChunkZ, a_Chunk);
 		}
 	}
 }
@@ -62,11 +89,13 @@ void cSimulatorManager::SimulateChunk(std::chrono::milliseconds a_Dt, int a_Chun
 void cSimulatorManager::WakeUp(cChunk & a_Chunk, Vector3i a_Position)
 {
 	ASSERT(a_Chunk.IsValid());
+	m_NumWakeUpsMetric.Add();
 
 	for (const auto & Item : m_Simulators)
 	{
-		Item.first->WakeUp(a_Chunk, a_Position, a_Chunk.GetBlock(a_Position));
+		Item.m_Simulator->WakeUp(a_Chunk, a_Position, a_Chunk.GetBlock(a_Position));
 	}
+	a_Chunk.WakeUpBlockEntity(a_Position);
 
 	for (const auto & Offset : cSimulator::AdjacentOffsets)
 	{
@@ -88,8 +117,9 @@ void cSimulatorManager::WakeUp(cChunk & a_Chunk, Vector3i a_Position)
 
 		for (const auto & Item : m_Simulators)
 		{
-			Item.first->WakeUp(*Chunk, Relative, Offset, Block);
+			Item.m_Simulator->WakeUp(*Chunk, Relative, Offset, Block);
 		}
+		Chunk->WakeUpBlockEntity(Relative);
 	}
 }
 
@@ -99,9 +129,29 @@ void cSimulatorManager::WakeUp(cChunk & a_Chunk, Vector3i a_Position)
 
 void cSimulatorManager::WakeUp(const cCuboid & a_Area)
 {
+	m_NumWakeUpsMetric.Add();
 	for (const auto & Item : m_Simulators)
 	{
-		Item.first->WakeUp(a_Area);
+		Item.m_Simulator->WakeUp(a_Area);
+	}
+
+	// Wake up the block entities in the area and around it:
+	cCuboid Area(a_Area);
+	Area.Sort();
+	Area.Expand(1, 1, 1, 1, 1, 1);
+	const auto ChunkStart = cChunkDef::BlockToChunk(Area.p1);
+	const auto ChunkEnd = cChunkDef::BlockToChunk(Area.p2);
+	for (int ChunkZ = ChunkStart.m_ChunkZ; ChunkZ <= ChunkEnd.m_ChunkZ; ++ChunkZ)
+	{
+		for (int ChunkX = ChunkStart.m_ChunkX; ChunkX <= ChunkEnd.m_ChunkX; ++ChunkX)
+		{
+			m_World.DoWithChunk(ChunkX, ChunkZ, [&Area](cChunk & a_Chunk)
+				{
+					a_Chunk.WakeUpBlockEntities(Area);
+					return true;
+				}
+			);
+		}
 	}
 }
 
@@ -109,7 +159,7 @@ void cSimulatorManager::WakeUp(const cCuboid & a_Area)
 
 
 
-void cSimulatorManager::RegisterSimulator(cSimulator * a_Simulator, int a_Rate)
+void cSimulatorManager::RegisterSimulator(cSimulator * a_Simulator, int a_Rate, const char * a_Name)
 {
-	m_Simulators.push_back(std::make_pair(a_Simulator, a_Rate));
+	m_Simulators.push_back({a_Simulator, a_Rate, a_Name});
 }
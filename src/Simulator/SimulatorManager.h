@@ -21,6 +21,9 @@ class cChunk;
 // fwd: World.h
 class cWorld;
 
+// fwd: Metrics.h
+class cMetricCounter;
+
 
 
 
@@ -39,24 +42,37 @@ public:
 	void SimulateChunk(std::chrono::milliseconds a_DT, int a_ChunkX, int a_ChunkZ, cChunk * a_Chunk);
 
 	/* Called when a single block changes, wakes all simulators up for the block and its face-neighbors.
-	The simulator implementation may also decide to wake blocks farther away. */
+	The simulator implementation may also decide to wake blocks farther away.
+	Also wakes up any sleeping block entities at the block and its face-neighbors. */
 	void WakeUp(cChunk & a_Chunk, Vector3i a_Position);
 
 	/** Does the same processing as WakeUp, but for all blocks within the specified area.
 	Has better performance than calling WakeUp for each block individually, due to neighbor-checking.
 	All chunks intersected by the area should be valid (outputs a warning if not).
-	Note that, unlike WakeUp(), this call adds blocks not only face-neighboring, but also edge-neighboring and corner-neighboring the specified area. */
+	Note that, unlike WakeUp(), this call adds blocks not only face-neighboring, but also edge-neighboring and corner-neighboring the specified area.
+	Sleeping block entities within the area and next to it are woken up, too. */
 	void WakeUp(const cCuboid & a_Area);
 
-	void RegisterSimulator(cSimulator * a_Simulator, int a_Rate);  // Takes ownership of the simulator object!
+	/** Adds the simulator to be run every a_Rate ticks. a_Name is a static string identifying the simulator in the tick profiler. */
+	void RegisterSimulator(cSimulator * a_Simulator, int a_Rate, const char * a_Name);  // Takes ownership of the simulator object!
 
 protected:
 
-	typedef std::vector <std::pair<cSimulator *, int> > cSimulators;
+	struct sSimulator
+	{
+		cSimulator * m_Simulator;
+		int m_Rate;
+		const char * m_Name;
+	};
+	typedef std::vector<sSimulator> cSimulators;
 
 	cWorld & m_World;
 	cSimulators m_Simulators;
 	long long   m_Ticks;
+
+	/** The number of the chunks simulated and of the blocks woken up, in cMetrics; a measure of the simulators' work. */
+	cMetricCounter & m_NumChunksSimulatedMetric;
+	cMetricCounter & m_NumWakeUpsMetric;
 };
 
 
@@ -71,6 +71,23 @@ Compression::Compressor::~Compressor()
 
 
 
+void Compression::Compressor::SetCompressionFactor(int CompressionFactor)
+{
+	const auto Handle = libdeflate_alloc_compressor(CompressionFactor);
+
+	if (Handle == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	libdeflate_free_compressor(m_Handle);
+	m_Handle = Handle;
+}
+
+
+
+
+
 template <auto Algorithm>
 Compression::Result Compression::Compressor::Compress(const void * const Input, const size_t Size)
 {
@@ -48,6 +48,9 @@ namespace Compression
 		Compressor(int CompressionFactor = 6);
 		~Compressor();
 
+		/** Changes the compression factor [0-12] used by the subsequent compressions. */
+		void SetCompressionFactor(int CompressionFactor);
+
 		Result CompressGZip(ContiguousByteBufferView Input);
 		Result CompressZLib(ContiguousByteBufferView Input);
 		Result CompressZLib(const void * Input, size_t Size);
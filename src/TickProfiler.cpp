@@ -0,0 +1,469 @@
+
+// TickProfiler.cpp
+
+// Implements the cTickProfiler class that times the phases of each world tick and captures a detailed breakdown of the slow ticks
+
+#include "Globals.h"
+#include "TickProfiler.h"
+#include "OSSupport/File.h"
+
+
+
+
+
+/** The profiler whose tick is running on the current thread. */
+static thread_local cTickProfiler * g_CurrentProfiler = nullptr;
+
+
+
+
+
+/** Returns the duration in milliseconds, for the reports. */
+static double ToMSec(std::chrono::nanoseconds a_Duration)
+{
+	return static_cast<double>(a_Duration.count()) / 1000000;
+}
+
+
+
+
+
+/** Sorts the timings by their duration, the longest first, and keeps at most a_MaxCount of them. */
+static void SortTimings(std::vector<cTickProfiler::sTiming> & a_Timings, size_t a_MaxCount)
+{
+	auto Longer = [](const cTickProfiler::sTiming & a_First, const cTickProfiler::sTiming & a_Second)
+	{
+		return (a_First.m_Duration > a_Second.m_Duration);
+	};
+	if (a_Timings.size() > a_MaxCount)
+	{
+		std::partial_sort(a_Timings.begin(), a_Timings.begin() + static_cast<ptrdiff_t>(a_MaxCount), a_Timings.end(), Longer);
+		a_Timings.resize(a_MaxCount);
+	}
+	else
+	{
+		std::sort(a_Timings.begin(), a_Timings.end(), Longer);
+	}
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cTickProfiler:
+
+cTickProfiler::cTickProfiler(void):
+	m_SlowTickThreshold(0),
+	m_TickNumber(0),
+	m_IsCapturingDetails(false),
+	m_NumDetailTicksLeft(0),
+	m_Phases(),
+	m_NumSkippedLogWrites(0),
+	m_NumTicks(0),
+	m_NumSlowTicks(0),
+	m_NumDetailedSlowTicks(0),
+	m_MaxTickDuration(0)
+{
+}
+
+
+
+
+
+void cTickProfiler::BeginTick(Int64 a_TickNumber)
+{
+	m_TickNumber = a_TickNumber;
+	m_IsCapturingDetails = (
+		(m_SlowTickThreshold.count() > 0) &&
+		((m_NumDetailTicksLeft > 0) || (a_TickNumber % DetailSampleInterval == 0))
+	);
+	if (m_NumDetailTicksLeft > 0)
+	{
+		m_NumDetailTicksLeft -= 1;
+	}
+	m_Phases.fill(std::chrono::nanoseconds(0));
+	m_ChunkTimings.clear();
+	m_PluginHookTimings.clear();
+	m_SimulatorTimings.clear();
+	g_CurrentProfiler = this;
+	m_TickStart = std::chrono::steady_clock::now();
+	m_PhaseStart = m_TickStart;
+}
+
+
+
+
+
+std::chrono::nanoseconds cTickProfiler::EndPhase(ePhase a_Phase)
+{
+	const auto Now = std::chrono::steady_clock::now();
+	const auto Duration = std::chrono::duration_cast<std::chrono::nanoseconds>(Now - m_PhaseStart);
+	m_Phases[a_Phase] += Duration;
+	m_PhaseStart = Now;
+	return Duration;
+}
+
+
+
+
+
+std::chrono::nanoseconds cTickProfiler::EndTick(void)
+{
+	const auto Duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_TickStart);
+	g_CurrentProfiler = nullptr;
+
+	// Build the breakdown outside the lock, only the slow ticks need it:
+	const bool IsSlow = (m_SlowTickThreshold.count() > 0) && (Duration > m_SlowTickThreshold);
+	sSlowTick SlowTick;
+	if (IsSlow)
+	{
+		SlowTick = CaptureSlowTick(Duration);
+
+		// Collect the details in the next few ticks, in case the lag persists:
+		m_NumDetailTicksLeft = DetailTicksAfterSlowTick;
+	}
+
+	{
+		cCSLock Lock(m_CS);
+		m_NumTicks += 1;
+		m_MaxTickDuration = std::max(m_MaxTickDuration, Duration);
+		for (size_t i = 0; i < m_Phases.size(); i++)
+		{
+			m_PhaseStats[i].m_Total += m_Phases[i];
+			m_PhaseStats[i].m_Max = std::max(m_PhaseStats[i].m_Max, m_Phases[i]);
+		}
+		if (IsSlow)
+		{
+			m_NumSlowTicks += 1;
+			if (SlowTick.m_HasDetails)
+			{
+				m_NumDetailedSlowTicks += 1;
+			}
+			if (m_SlowTicks.size() >= MaxSlowTicks)
+			{
+				m_SlowTicks.pop_front();
+			}
+			m_SlowTicks.push_back(SlowTick);
+		}
+	}
+
+	// Log the slow tick, at most once per second so that a struggling server isn't slowed down further by the disk writes:
+	if (IsSlow && !m_LogFileName.empty())
+	{
+		const auto Now = std::chrono::steady_clock::now();
+		if (Now - m_LastLogWrite < std::chrono::seconds(1))
+		{
+			m_NumSkippedLogWrites += 1;
+		}
+		else
+		{
+			WriteToLog(SlowTick);
+			m_LastLogWrite = Now;
+			m_NumSkippedLogWrites = 0;
+		}
+	}
+	return Duration;
+}
+
+
+
+
+
+void cTickProfiler::AddChunkTiming(cChunkCoords a_Coords, std::chrono::nanoseconds a_Duration)
+{
+	m_ChunkTimings.emplace_back(a_Coords, a_Duration);
+}
+
+
+
+
+
+void cTickProfiler::AddPluginHookTiming(const AString & a_PluginName, const char * a_HookName, std::chrono::nanoseconds a_Duration)
+{
+	// There are only a few plugins and hooks called in a tick, a linear search is fast enough:
+	for (auto & Timing: m_PluginHookTimings)
+	{
+		if ((Timing.m_HookName == a_HookName) && (Timing.m_PluginName == a_PluginName))
+		{
+			Timing.m_Duration += a_Duration;
+			return;
+		}
+	}
+	m_PluginHookTimings.push_back({a_PluginName, a_HookName, a_Duration});
+}
+
+
+
+
+
+void cTickProfiler::AddSimulatorTiming(const char * a_SimulatorName, std::chrono::nanoseconds a_Duration)
+{
+	for (auto & Timing: m_SimulatorTimings)
+	{
+		if (Timing.first == a_SimulatorName)
+		{
+			Timing.second += a_Duration;
+			return;
+		}
+	}
+	m_SimulatorTimings.emplace_back(a_SimulatorName, a_Duration);
+}
+
+
+
+
+
+cTickProfiler * cTickProfiler::GetCurrent(void)
+{
+	return g_CurrentProfiler;
+}
+
+
+
+
+
+AString cTickProfiler::GetReport(size_t a_NumTop)
+{
+	/** The timings of a single item summed up over all the captured slow ticks. */
+	struct sAggregate
+	{
+		std::chrono::nanoseconds m_Total{0};
+		std::chrono::nanoseconds m_Max{0};
+		unsigned m_NumSlowTicks = 0;
+	};
+	std::array<std::map<AString, sAggregate>, 3> Categories;
+	static const char * CategoryNames[] = { "chunks", "plugin hooks", "simulators" };
+	static_assert(ARRAYCOUNT(CategoryNames) == std::tuple_size<decltype(Categories)>::value, "Each category needs a name");
+
+	AString res;
+	{
+		cCSLock Lock(m_CS);
+		if (m_NumTicks == 0)
+		{
+			return "No ticks profiled yet\n";
+		}
+		res.append(fmt::format(FMT_STRING("{} ticks profiled, longest {:.2f} ms\n"), m_NumTicks, ToMSec(m_MaxTickDuration)));
+		res.append("Phases (avg / max ms):\n");
+		for (size_t i = 0; i < m_PhaseStats.size(); i++)
+		{
+			res.append(fmt::format(FMT_STRING("  {:<18} {:8.3f} / {:8.3f}\n"),
+				GetPhaseName(static_cast<ePhase>(i)),
+				ToMSec(m_PhaseStats[i].m_Total) / m_NumTicks,
+				ToMSec(m_PhaseStats[i].m_Max)
+			));
+		}
+		if (m_SlowTickThreshold.count() <= 0)
+		{
+			res.append("The slow tick capture is disabled\n");
+			return res;
+		}
+		res.append(fmt::format(FMT_STRING("{} slow ticks (over {} ms), {} of them with the details, the last {} captured\n"),
+			m_NumSlowTicks, m_SlowTickThreshold.count(), m_NumDetailedSlowTicks, m_SlowTicks.size()
+		));
+
+		for (const auto & SlowTick: m_SlowTicks)
+		{
+			const std::vector<sTiming> * Timings[] = { &SlowTick.m_Chunks, &SlowTick.m_PluginHooks, &SlowTick.m_Simulators };
+			for (size_t i = 0; i < Categories.size(); i++)
+			{
+				for (const auto & Timing: *Timings[i])
+				{
+					auto & Aggregate = Categories[i][Timing.m_Name];
+					Aggregate.m_Total += Timing.m_Duration;
+					Aggregate.m_Max = std::max(Aggregate.m_Max, Timing.m_Duration);
+					Aggregate.m_NumSlowTicks += 1;
+				}
+			}
+		}
+	}
+
+	// Output the worst offenders in each category:
+	for (size_t i = 0; i < Categories.size(); i++)
+	{
+		std::vector<std::pair<AString, sAggregate>> Sorted(Categories[i].begin(), Categories[i].end());
+		std::sort(Sorted.begin(), Sorted.end(), [](const std::pair<AString, sAggregate> & a_First, const std::pair<AString, sAggregate> & a_Second)
+			{
+				return (a_First.second.m_Total > a_Second.second.m_Total);
+			}
+		);
+		if (Sorted.size() > a_NumTop)
+		{
+			Sorted.resize(a_NumTop);
+		}
+		res.append(fmt::format(FMT_STRING("Top {} {} in the slow ticks (total / max ms, slow ticks):\n"), Sorted.size(), CategoryNames[i]));
+		for (const auto & Item: Sorted)
+		{
+			res.append(fmt::format(FMT_STRING("  {:<32} {:8.3f} / {:8.3f} {:4}\n"),
+				Item.first, ToMSec(Item.second.m_Total), ToMSec(Item.second.m_Max), Item.second.m_NumSlowTicks
+			));
+		}
+	}
+	return res;
+}
+
+
+
+
+
+std::vector<cTickProfiler::sSlowTick> cTickProfiler::GetSlowTicks(void)
+{
+	cCSLock Lock(m_CS);
+	return std::vector<sSlowTick>(m_SlowTicks.begin(), m_SlowTicks.end());
+}
+
+
+
+
+
+void cTickProfiler::Reset(void)
+{
+	cCSLock Lock(m_CS);
+	m_NumTicks = 0;
+	m_NumSlowTicks = 0;
+	m_NumDetailedSlowTicks = 0;
+	m_MaxTickDuration = std::chrono::nanoseconds(0);
+	m_PhaseStats.fill(sPhaseStats());
+	m_SlowTicks.clear();
+}
+
+
+
+
+
+const char * cTickProfiler::GetPhaseName(ePhase a_Phase)
+{
+	switch (a_Phase)
+	{
+		case phPluginHook:      return "plugin_hook";
+		case phBroadcasts:      return "broadcasts";
+		case phChunkDataSets:   return "chunk_data_sets";
+		case phQueuedBlocks:    return "queued_blocks";
+		case phChunkMap:        return "chunk_map";
+		case phMobs:            return "mobs";
+		case phEntityAdditions: return "entity_additions";
+		case phMaps:            return "maps";
+		case phTasks:           return "tasks";
+		case phWeather:         return "weather";
+		case phSimulators:      return "simulators";
+		case phUnloadSave:      return "unload_save";
+		case phCount:           break;
+	}
+	UNREACHABLE("Unsupported tick phase");
+}
+
+
+
+
+
+cTickProfiler::sSlowTick cTickProfiler::CaptureSlowTick(std::chrono::nanoseconds a_Duration)
+{
+	sSlowTick res;
+	res.m_TickNumber = m_TickNumber;
+	res.m_Time = time(nullptr);
+	res.m_HasDetails = m_IsCapturingDetails;
+	res.m_Duration = a_Duration;
+	res.m_Phases = m_Phases;
+
+	// Only keep the slowest chunks, there may be thousands of them:
+	auto Longer = [](const std::pair<cChunkCoords, std::chrono::nanoseconds> & a_First, const std::pair<cChunkCoords, std::chrono::nanoseconds> & a_Second)
+	{
+		return (a_First.second > a_Second.second);
+	};
+	const auto NumChunks = std::min(m_ChunkTimings.size(), MaxItemsPerCategory);
+	std::partial_sort(m_ChunkTimings.begin(), m_ChunkTimings.begin() + static_cast<ptrdiff_t>(NumChunks), m_ChunkTimings.end(), Longer);
+	res.m_Chunks.reserve(NumChunks);
+	for (size_t i = 0; i < NumChunks; i++)
+	{
+		res.m_Chunks.push_back({m_ChunkTimings[i].first.ToString(), m_ChunkTimings[i].second});
+	}
+
+	for (const auto & Timing: m_PluginHookTimings)
+	{
+		res.m_PluginHooks.push_back({fmt::format(FMT_STRING("{}: {}"), Timing.m_PluginName, Timing.m_HookName), Timing.m_Duration});
+	}
+	SortTimings(res.m_PluginHooks, MaxItemsPerCategory);
+
+	for (const auto & Timing: m_SimulatorTimings)
+	{
+		res.m_Simulators.push_back({Timing.first, Timing.second});
+	}
+	SortTimings(res.m_Simulators, MaxItemsPerCategory);
+	return res;
+}
+
+
+
+
+
+void cTickProfiler::WriteToLog(const sSlowTick & a_SlowTick)
+{
+	if (cFile::GetSize(m_LogFileName) > MaxLogFileSize)
+	{
+		cFile::Replace(m_LogFileName, m_LogFileName + ".1");
+	}
+	cFile File(m_LogFileName, cFile::fmAppend);
+	if (!File.IsOpen())
+	{
+		// Don't retry in each tick, the log is just a diagnostic aid:
+		LOGWARNING("Cannot open the slow tick log file \"%s\", slow ticks will not be logged.", m_LogFileName);
+		m_LogFileName.clear();
+		return;
+	}
+	auto Text = FormatSlowTick(a_SlowTick);
+	if (m_NumSkippedLogWrites > 0)
+	{
+		Text.append(fmt::format(FMT_STRING("  ({} more slow ticks since the previous entry not logged)\n"), m_NumSkippedLogWrites));
+	}
+	File.Write(Text);
+}
+
+
+
+
+
+AString cTickProfiler::FormatSlowTick(const sSlowTick & a_SlowTick)
+{
+	struct tm TimeInfo;
+#ifdef _MSC_VER
+	localtime_s(&TimeInfo, &a_SlowTick.m_Time);
+#else
+	localtime_r(&a_SlowTick.m_Time, &TimeInfo);
+#endif
+
+	AString res = fmt::format(FMT_STRING("[{:04d}-{:02d}-{:02d} {:02d}:{:02d}:{:02d}] Tick {} took {:.2f} ms\n"),
+		TimeInfo.tm_year + 1900, TimeInfo.tm_mon + 1, TimeInfo.tm_mday, TimeInfo.tm_hour, TimeInfo.tm_min, TimeInfo.tm_sec,
+		a_SlowTick.m_TickNumber, ToMSec(a_SlowTick.m_Duration)
+	);
+	res.append("  Phases:");
+	for (size_t i = 0; i < a_SlowTick.m_Phases.size(); i++)
+	{
+		res.append(fmt::format(FMT_STRING(" {} {:.2f} ms{}"), GetPhaseName(static_cast<ePhase>(i)), ToMSec(a_SlowTick.m_Phases[i]), (i + 1 < a_SlowTick.m_Phases.size()) ? "," : "\n"));
+	}
+
+	auto AppendTimings = [&res](const char * a_Caption, const std::vector<sTiming> & a_Timings)
+	{
+		if (a_Timings.empty())
+		{
+			return;
+		}
+		res.append(fmt::format(FMT_STRING("  {}:"), a_Caption));
+		for (const auto & Timing: a_Timings)
+		{
+			res.append(fmt::format(FMT_STRING(" {} {:.2f} ms{}"), Timing.m_Name, ToMSec(Timing.m_Duration), (&Timing == &a_Timings.back()) ? "\n" : ","));
+		}
+	};
+	if (!a_SlowTick.m_HasDetails)
+	{
+		res.append("  No details, the tick didn't collect them\n");
+		return res;
+	}
+	AppendTimings("Slowest chunks", a_SlowTick.m_Chunks);
+	AppendTimings("Plugin hooks", a_SlowTick.m_PluginHooks);
+	AppendTimings("Simulators", a_SlowTick.m_Simulators);
+	return res;
+}
+
+
+
+
@@ -0,0 +1,209 @@
+
+// TickProfiler.h
+
+// Declares the cTickProfiler class that times the phases of each world tick and captures a detailed breakdown of the slow ticks
+
+#pragma once
+
+#include "ChunkDef.h"
+#include "OSSupport/CriticalSection.h"
+
+
+
+
+
+/** Times the phases of a world's ticks.
+Each tick's phases are measured and summed up into the per-phase statistics. When the whole tick takes longer than
+the slow-tick threshold, its breakdown is kept in memory (for the "tickprofile" console command) and appended
+to a rolling log file.
+Timing each chunk, plugin hook handler and simulator is too expensive to do all the time, so only some ticks collect
+these detailed timings: the DetailTicksAfterSlowTick ticks following a slow tick, since the lag tends to persist,
+and every DetailSampleInterval-th tick, so that an isolated slow tick may get its details, too.
+The tick functions and the Add...Timing() functions are called from the world's tick thread only, the reporting
+functions may be called from any thread. */
+class cTickProfiler
+{
+public:
+
+	/** The phases of the world tick, in the order in which they run. */
+	enum ePhase
+	{
+		phPluginHook,
+		phBroadcasts,
+		phChunkDataSets,
+		phQueuedBlocks,
+		phChunkMap,
+		phMobs,
+		phEntityAdditions,
+		phMaps,
+		phTasks,
+		phWeather,
+		phSimulators,
+		phUnloadSave,
+
+		phCount
+	};
+
+	/** The time spent in a single item of a slow tick's breakdown: a chunk, a plugin's hook handler or a simulator. */
+	struct sTiming
+	{
+		AString m_Name;
+		std::chrono::nanoseconds m_Duration;
+	};
+
+	/** The breakdown of a single slow tick. */
+	struct sSlowTick
+	{
+		/** The world age, in ticks, of the slow tick. */
+		Int64 m_TickNumber;
+
+		/** The wallclock time at which the tick ended. */
+		time_t m_Time;
+
+		/** True if the tick collected the detailed timings, false if only its phases are known. */
+		bool m_HasDetails;
+
+		std::chrono::nanoseconds m_Duration;
+		std::array<std::chrono::nanoseconds, phCount> m_Phases;
+
+		/** The slowest items of the tick in each category, the slowest first.
+		Only the MaxItemsPerCategory slowest chunks are kept. */
+		std::vector<sTiming> m_Chunks;
+		std::vector<sTiming> m_PluginHooks;
+		std::vector<sTiming> m_Simulators;
+	};
+
+
+	/** The number of the slow ticks kept in memory; the older ones are dropped. */
+	static const size_t MaxSlowTicks = 64;
+
+	/** The maximum number of the slowest chunks kept for each slow tick. */
+	static const size_t MaxItemsPerCategory = 16;
+
+	/** The number of the ticks following a slow tick that collect the detailed timings. */
+	static const unsigned DetailTicksAfterSlowTick = 20;
+
+	/** Every tick whose number is a multiple of this collects the detailed timings. */
+	static const Int64 DetailSampleInterval = 100;
+
+	/** The size of the log file above which it is rotated. */
+	static const long MaxLogFileSize = 4 * 1024 * 1024;
+
+
+	cTickProfiler(void);
+
+	/** Sets the tick duration above which the tick's breakdown is captured.
+	Zero disables the capture, and with it the detailed timing of the chunks, plugin hooks and simulators. */
+	void SetSlowTickThreshold(std::chrono::milliseconds a_Threshold) { m_SlowTickThreshold = a_Threshold; }
+
+	/** Sets the file into which the slow ticks are logged. An empty name disables logging into the file.
+	When the file grows over MaxLogFileSize, it is renamed by appending ".1" and a new one is started. */
+	void SetLogFileName(const AString & a_LogFileName) { m_LogFileName = a_LogFileName; }
+
+	/** Starts timing a new tick, a_TickNumber is the world age, in ticks. */
+	void BeginTick(Int64 a_TickNumber);
+
+	/** Ends the specified phase, which has started at the end of the previous phase (or at the tick's start).
+	Returns the phase's duration. */
+	std::chrono::nanoseconds EndPhase(ePhase a_Phase);
+
+	/** Ends the tick; if it was slow, captures its breakdown. Returns the tick's duration. */
+	std::chrono::nanoseconds EndTick(void);
+
+	/** Returns true if the current tick collects the detailed timings; the callers of the Add...Timing() functions
+	should only measure the time if this returns true. See the class description for which ticks do. */
+	bool IsCapturingDetails(void) const { return m_IsCapturingDetails; }
+
+	/** Adds the time spent ticking the specified chunk in the current tick. */
+	void AddChunkTiming(cChunkCoords a_Coords, std::chrono::nanoseconds a_Duration);
+
+	/** Adds the time spent in the specified plugin's handler of the specified hook in the current tick.
+	a_HookName is expected to be a static string. */
+	void AddPluginHookTiming(const AString & a_PluginName, const char * a_HookName, std::chrono::nanoseconds a_Duration);
+
+	/** Adds the time spent in the specified simulator in the current tick. a_SimulatorName is expected to be a static string. */
+	void AddSimulatorTiming(const char * a_SimulatorName, std::chrono::nanoseconds a_Duration);
+
+	/** Returns the profiler whose tick is running on the current thread, or nullptr if there's none.
+	Used for the timings collected by code that doesn't know which world it is running for, such as the plugin hooks. */
+	static cTickProfiler * GetCurrent(void);
+
+	/** Returns the per-phase statistics and the a_NumTop worst offenders in each category of the captured slow ticks,
+	as text for the "tickprofile" console command. */
+	AString GetReport(size_t a_NumTop);
+
+	/** Returns a copy of the captured slow ticks, the oldest first. */
+	std::vector<sSlowTick> GetSlowTicks(void);
+
+	/** Clears the statistics and the captured slow ticks. */
+	void Reset(void);
+
+	/** Returns the name of the phase, as used in the reports and in the metrics' labels. */
+	static const char * GetPhaseName(ePhase a_Phase);
+
+protected:
+
+	/** The time spent in a plugin's hook handler during the current tick. */
+	struct sPluginHookTiming
+	{
+		AString m_PluginName;
+		const char * m_HookName;
+		std::chrono::nanoseconds m_Duration;
+	};
+
+	/** The statistics of a single phase since the last reset. */
+	struct sPhaseStats
+	{
+		std::chrono::nanoseconds m_Total{0};
+		std::chrono::nanoseconds m_Max{0};
+	};
+
+
+	std::chrono::milliseconds m_SlowTickThreshold;
+	AString m_LogFileName;
+
+	/** The state of the tick being run. Accessed only from the tick thread. */
+	Int64 m_TickNumber;
+	bool m_IsCapturingDetails;
+
+	/** The number of the upcoming ticks that collect the detailed timings because of a recent slow tick. */
+	unsigned m_NumDetailTicksLeft;
+	std::chrono::steady_clock::time_point m_TickStart;
+	std::chrono::steady_clock::time_point m_PhaseStart;
+	std::array<std::chrono::nanoseconds, phCount> m_Phases;
+	std::vector<std::pair<cChunkCoords, std::chrono::nanoseconds>> m_ChunkTimings;
+	std::vector<sPluginHookTiming> m_PluginHookTimings;
+	std::vector<std::pair<const char *, std::chrono::nanoseconds>> m_SimulatorTimings;
+
+	/** The time when the last slow tick was written into the log file; the file is written at most once per second. */
+	std::chrono::steady_clock::time_point m_LastLogWrite;
+
+	/** The number of the slow ticks not written into the log file since the last write, due to the rate limit. */
+	unsigned m_NumSkippedLogWrites;
+
+	/** Protects the statistics and the captured slow ticks below against multithreaded access. */
+	cCriticalSection m_CS;
+
+	UInt64 m_NumTicks;
+	UInt64 m_NumSlowTicks;
+	UInt64 m_NumDetailedSlowTicks;
+	std::chrono::nanoseconds m_MaxTickDuration;
+	std::array<sPhaseStats, phCount> m_PhaseStats;
+
+	/** The last MaxSlowTicks slow ticks, the oldest first. */
+	std::deque<sSlowTick> m_SlowTicks;
+
+
+	/** Builds the breakdown of the current tick out of the collected timings. */
+	sSlowTick CaptureSlowTick(std::chrono::nanoseconds a_Duration);
+
+	/** Appends the slow tick's breakdown to the log file, rotating the file if it has grown too large. */
+	void WriteToLog(const sSlowTick & a_SlowTick);
+
+	/** Returns the slow tick's breakdown formatted as text. */
+	static AString FormatSlowTick(const sSlowTick & a_SlowTick);
+};
+
+
+
+
@@ -7,6 +7,8 @@
 #include "Entities/Player.h"
 #include "Server.h"
 #include "Root.h"
+#include "Metrics.h"
+#include "Bindings/PluginManager.h"
 
 #include "HTTP/HTTPServerConnection.h"
 #include "HTTP/HTTPFormParser.h"
@@ -237,7 +239,10 @@ bool cWebAdmin::LoadIniFile(void)
 		m_IniFile.AddHeaderComment(" [User:admin]");
 		m_IniFile.AddHeaderComment(" Password=admin");
 		m_IniFile.AddHeaderComment(" Please restart Cuberite to apply changes made in this file!");
+		m_IniFile.AddHeaderComment(" MetricsEnabled serves the server's metrics for Prometheus at /metrics, to the same logins");
+		m_IniFile.AddHeaderComment(" The time spent in each plugin's callbacks is served at /pluginstats, to the same logins");
 		m_IniFile.SetValue("WebAdmin", "Ports", DEFAULT_WEBADMIN_PORTS);
+		m_IniFile.SetValueB("WebAdmin", "MetricsEnabled", true);
 		m_IniFile.WriteFile("webadmin.ini");
 	}
 
@@ -248,23 +253,33 @@ bool cWebAdmin::LoadIniFile(void)
 
 
 
-void cWebAdmin::HandleWebadminRequest(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request)
+bool cWebAdmin::CheckAuth(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request, const AString & a_Realm)
 {
 	if (!a_Request.HasAuth())
 	{
-		a_Connection.SendNeedAuth("Cuberite WebAdmin");
-		return;
+		a_Connection.SendNeedAuth(a_Realm);
+		return false;
 	}
 
-	// Check auth:
+	cCSLock Lock(m_CS);
+	AString UserPassword = m_IniFile.GetValue("User:" + a_Request.GetAuthUsername(), "Password", "");
+	if ((UserPassword == "") || (a_Request.GetAuthPassword() != UserPassword))
 	{
-		cCSLock Lock(m_CS);
-		AString UserPassword = m_IniFile.GetValue("User:" + a_Request.GetAuthUsername(), "Password", "");
-		if ((UserPassword == "") || (a_Request.GetAuthPassword() != UserPassword))
-		{
-			a_Connection.SendNeedAuth("Cuberite WebAdmin - bad username or password");
-			return;
-		}
+		a_Connection.SendNeedAuth(a_Realm + " - bad username or password");
+		return false;
+	}
+	return true;
+}
+
+
+
+
+
+void cWebAdmin::HandleWebadminRequest(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request)
+{
+	if (!CheckAuth(a_Connection, a_Request, "Cuberite WebAdmin"))
+	{
+		return;
 	}
 
 	// Check if the contents should be wrapped in the template:
@@ -345,6 +360,64 @@ void cWebAdmin::HandleWebadminRequest(cHTTPServerConnection & a_Connection, cHTT
 
 
 
+void cWebAdmin::HandleMetricsRequest(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request)
+{
+	{
+		cCSLock Lock(m_CS);
+		if (!m_IniFile.GetValueB("WebAdmin", "MetricsEnabled", true))
+		{
+			a_Connection.SendStatusAndReason(404, "Not found");
+			return;
+		}
+	}
+	if (!CheckAuth(a_Connection, a_Request, "Cuberite Metrics"))
+	{
+		return;
+	}
+
+	cHTTPOutgoingResponse Resp;
+	Resp.SetContentType("text/plain; version=0.0.4");
+	a_Connection.Send(Resp);
+	a_Connection.Send(cMetrics::Get().GetPrometheusText());
+	a_Connection.FinishResponse();
+}
+
+
+
+
+
+void cWebAdmin::HandlePluginStatsRequest(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request)
+{
+	if (!CheckAuth(a_Connection, a_Request, "Cuberite WebAdmin"))
+	{
+		return;
+	}
+
+	// "/pluginstats/<PluginName>" selects a single plugin:
+	AString PluginName;
+	const auto & Path = a_Request.GetURLPath();
+	if (Path.size() > 13)
+	{
+		auto Decoded = URLDecode(Path.substr(13));
+		if (!Decoded.first)
+		{
+			a_Connection.SendStatusAndReason(400, "Bad plugin name");
+			return;
+		}
+		PluginName = Decoded.second;
+	}
+
+	cHTTPOutgoingResponse Resp;
+	Resp.SetContentType("text/plain");
+	a_Connection.Send(Resp);
+	a_Connection.Send(cPluginManager::Get()->GetPluginCpuStatsSnapshot(PluginName));
+	a_Connection.FinishResponse();
+}
+
+
+
+
+
 void cWebAdmin::HandleRootRequest(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request)
 {
 	UNUSED(a_Request);
@@ -658,6 +731,14 @@ void cWebAdmin::OnRequestFinished(cHTTPServerConnection & a_Connection, cHTTPInc
 		// The root needs no body handler and is fully handled in the OnRequestFinished() call
 		HandleRootRequest(a_Connection, a_Request);
 	}
+	else if (a_Request.GetURLPath() == "/metrics")
+	{
+		HandleMetricsRequest(a_Connection, a_Request);
+	}
+	else if ((a_Request.GetURLPath() == "/pluginstats") || (a_Request.GetURLPath().compare(0, 13, "/pluginstats/") == 0))
+	{
+		HandlePluginStatsRequest(a_Connection, a_Request);
+	}
 	else
 	{
 		HandleFileRequest(a_Connection, a_Request);
@@ -260,9 +260,21 @@ protected:
 	Returns true if webadmin is enabled, false if disabled. */
 	bool LoadIniFile(void);
 
+	/** Checks the request's credentials against the webadmin users.
+	Returns true if the request may proceed; otherwise asks the client for the credentials and returns false. */
+	bool CheckAuth(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request, const AString & a_Realm);
+
 	/** Handles requests coming to the "/webadmin" or "/~webadmin" URLs */
 	void HandleWebadminRequest(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request);
 
+	/** Handles requests for the "/metrics" URL, sending all of cMetrics in the Prometheus text format. */
+	void HandleMetricsRequest(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request);
+
+	/** Handles requests for the "/pluginstats" URL, sending the time spent in the plugins' callbacks as plain text.
+	The report comes from the snapshot refreshed by the tick thread every second, the network thread never waits for the tick thread.
+	"/pluginstats/<PluginName>" lists all the callbacks of the single plugin. */
+	void HandlePluginStatsRequest(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request);
+
 	/** Handles requests for the root page */
 	void HandleRootRequest(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request);
 
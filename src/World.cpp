@@ -2,6 +2,7 @@
 #include "Globals.h"  // NOTE: MSVC stupidness requires this to be the same across all modules
 
 #include "World.h"
+#include "BlockAreaWriter.h"
 #include "BlockInfo.h"
 #include "ClientHandle.h"
 #include "Physics/Explodinator.h"
@@ -57,6 +58,7 @@
 
 #include "SpawnPrepare.h"
 #include "FastRandom.h"
+#include "Metrics.h"
 #include "OpaqueWorld.h"
 
 
@@ -213,13 +215,15 @@ cWorld::cWorld(
 	m_GeneratorCallbacks(*this),
 	m_ChunkSender(*this),
 	m_Lighting(*this),
-	m_TickThread(*this)
+	m_TickThread(*this),
+	m_ShouldQueueExplosions(false)
 {
 	LOGD("cWorld::cWorld(\"%s\")", a_WorldName.c_str());
 
 	cFile::CreateFolderRecursive(m_DataPath);
 
 	m_ChunkMap.TrackInDeadlockDetect(a_DeadlockDetect, m_WorldName);
+	RegisterMetrics();
 
 	// Load the scoreboard
 	cScoreboardSerializer Serializer(m_DataPath, &m_Scoreboard);
@@ -250,6 +254,15 @@ cWorld::cWorld(
 	}
 	m_UnusedDirtyChunksCap = static_cast<size_t>(UnusedDirtyChunksCap);
 
+	// Ticks longer than the threshold get their breakdown captured, the ticks following them collect the details; zero disables the capture:
+	int SlowTickThreshold = IniFile.GetValueSetI("TickProfiler", "SlowTickThresholdMS", 100);
+	m_TickProfiler.SetSlowTickThreshold(std::chrono::milliseconds(std::max(SlowTickThreshold, 0)));
+	if (IniFile.GetValueSetB("TickProfiler", "LogSlowTicks", true))
+	{
+		cFile::CreateFolder("logs");
+		m_TickProfiler.SetLogFileName(fmt::format(FMT_STRING("logs{}slowticks_{}.log"), cFile::PathSeparator(), m_WorldName));
+	}
+
 	m_BroadcastDeathMessages = IniFile.GetValueSetB("Broadcasting", "BroadcastDeathMessages", true);
 	m_BroadcastAchievementMessages = IniFile.GetValueSetB("Broadcasting", "BroadcastAchievementMessages", true);
 
@@ -419,11 +432,11 @@ cWorld::cWorld(
 	m_RedstoneSimulator = InitializeRedstoneSimulator(IniFile);
 
 	// Water, Lava and Redstone simulators get registered in their initialize function.
-	m_SimulatorManager->RegisterSimulator(m_SandSimulator.get(), 1);
-	m_SimulatorManager->RegisterSimulator(m_FireSimulator.get(), 1);
+	m_SimulatorManager->RegisterSimulator(m_SandSimulator.get(), 1, "Sand");
+	m_SimulatorManager->RegisterSimulator(m_FireSimulator.get(), 1, "Fire");
 
 	m_Storage.Initialize(*this, m_StorageSchema, m_StorageCompressionFactor);
-	m_Generator.Initialize(m_GeneratorCallbacks, m_GeneratorCallbacks, IniFile);
+	m_Generator.Initialize(m_GeneratorCallbacks, m_GeneratorCallbacks, IniFile, m_WorldName);
 
 	m_MapManager.LoadMapData();
 
@@ -682,13 +695,14 @@ void cWorld::InitializeSpawn(void)
 
 
 
-void cWorld::Start()
+void cWorld::Start(cDeadlockDetect & a_DeadlockDetect)
 {
 	m_Lighting.Start();
 	m_Storage.Start();
 	m_Generator.Start();
 	m_ChunkSender.Start();
 	m_TickThread.Start();
+	a_DeadlockDetect.TrackThread(m_TickThread, Printf("World %s tick", m_WorldName.c_str()));
 }
 
 
@@ -977,6 +991,7 @@ void cWorld::Stop(cDeadlockDetect & a_DeadlockDetect)
 		IniFile.SetValueI("General", "WorldAgeMS", static_cast<Int64>(m_WorldAge.count()));
 	IniFile.WriteFile(m_IniFileName);
 
+	a_DeadlockDetect.UntrackThread(m_TickThread);
 	m_TickThread.Stop();
 	m_Lighting.Stop();
 	m_Generator.Stop();
@@ -1002,8 +1017,16 @@ void cWorld::Stop(cDeadlockDetect & a_DeadlockDetect)
 
 void cWorld::Tick(std::chrono::milliseconds a_Dt, std::chrono::milliseconds a_LastTickDurationMSec)
 {
+	// Each phase is timed from the end of the previous one:
+	m_TickProfiler.BeginTick(m_WorldTickAge.count());
+	auto EndPhase = [this](cTickProfiler::ePhase a_Phase)
+	{
+		m_TickPhaseMetrics[a_Phase]->Record(m_TickProfiler.EndPhase(a_Phase));
+	};
+
 	// Notify the plugins:
 	cPluginManager::Get()->CallHookWorldTick(*this, a_Dt, a_LastTickDurationMSec);
+	EndPhase(cTickProfiler::phPluginHook);
 
 	m_WorldAge += a_Dt;
 	m_WorldTickAge++;
@@ -1027,17 +1050,30 @@ void cWorld::Tick(std::chrono::milliseconds a_Dt, std::chrono::milliseconds a_La
 	{
 		BroadcastPlayerListUpdatePing();
 	}
+	EndPhase(cTickProfiler::phBroadcasts);
 
 	TickQueuedChunkDataSets();
+	EndPhase(cTickProfiler::phChunkDataSets);
 	TickQueuedBlocks();
+	EndPhase(cTickProfiler::phQueuedBlocks);
+	m_ShouldQueueExplosions = true;
 	m_ChunkMap.Tick(a_Dt);
+	m_ShouldQueueExplosions = false;
+	TickQueuedExplosions();
+	EndPhase(cTickProfiler::phChunkMap);
 	TickMobs(a_Dt);
+	EndPhase(cTickProfiler::phMobs);
 	TickQueuedEntityAdditions();
+	EndPhase(cTickProfiler::phEntityAdditions);
 	m_MapManager.TickMaps();
+	EndPhase(cTickProfiler::phMaps);
 	TickQueuedTasks();
+	EndPhase(cTickProfiler::phTasks);
 	TickWeather(static_cast<float>(a_Dt.count()));
+	EndPhase(cTickProfiler::phWeather);
 
 	GetSimulatorManager()->Simulate(static_cast<float>(a_Dt.count()));
+	EndPhase(cTickProfiler::phSimulators);
 
 	if (m_WorldAge - m_LastChunkCheck > std::chrono::seconds(10))
 	{
@@ -1055,6 +1091,14 @@ void cWorld::Tick(std::chrono::milliseconds a_Dt, std::chrono::milliseconds a_La
 			SaveAllChunks();
 		}
 	}
+	EndPhase(cTickProfiler::phUnloadSave);
+
+	// Update the gauges once a second:
+	if ((m_WorldTickAge % 20_tick) == 0_tick)
+	{
+		UpdateMetrics();
+	}
+	m_TickMetric->Record(m_TickProfiler.EndTick());
 }
 
 
@@ -1262,6 +1306,44 @@ void cWorld::TickQueuedEntityAdditions(void)
 
 
 
+void cWorld::RegisterMetrics(void)
+{
+	auto & Metrics = cMetrics::Get();
+	m_TickMetric = &Metrics.GetHistogram("cuberite_world_tick_seconds", "The duration of the world ticks", {{"world", m_WorldName}});
+	for (size_t i = 0; i < m_TickPhaseMetrics.size(); i++)
+	{
+		m_TickPhaseMetrics[i] = &Metrics.GetHistogram(
+			"cuberite_world_tick_phase_seconds", "The duration of the phases of the world ticks",
+			{{"world", m_WorldName}, {"phase", cTickProfiler::GetPhaseName(static_cast<cTickProfiler::ePhase>(i))}}
+		);
+	}
+
+	static const AString QueueLengthName("cuberite_world_queue_length");
+	static const AString QueueLengthHelp("The number of the chunks waiting in the world's worker thread queues");
+	m_GeneratorQueueMetric   = &Metrics.GetGauge(QueueLengthName, QueueLengthHelp, {{"world", m_WorldName}, {"queue", "generator"}});
+	m_LightingQueueMetric    = &Metrics.GetGauge(QueueLengthName, QueueLengthHelp, {{"world", m_WorldName}, {"queue", "lighting"}});
+	m_StorageLoadQueueMetric = &Metrics.GetGauge(QueueLengthName, QueueLengthHelp, {{"world", m_WorldName}, {"queue", "storage_load"}});
+	m_StorageSaveQueueMetric = &Metrics.GetGauge(QueueLengthName, QueueLengthHelp, {{"world", m_WorldName}, {"queue", "storage_save"}});
+	m_NumChunksMetric = &Metrics.GetGauge("cuberite_world_chunks", "The number of the chunks loaded in the world", {{"world", m_WorldName}});
+}
+
+
+
+
+
+void cWorld::UpdateMetrics(void)
+{
+	m_GeneratorQueueMetric->Set(static_cast<Int64>(GetGeneratorQueueLength()));
+	m_LightingQueueMetric->Set(static_cast<Int64>(GetLightingQueueLength()));
+	m_StorageLoadQueueMetric->Set(static_cast<Int64>(GetStorageLoadQueueLength()));
+	m_StorageSaveQueueMetric->Set(static_cast<Int64>(GetStorageSaveQueueLength()));
+	m_NumChunksMetric->Set(static_cast<Int64>(GetNumChunks()));
+}
+
+
+
+
+
 void cWorld::TickQueuedTasks(void)
 {
 	// Move the tasks to be executed to a seperate vector to avoid deadlocks on accessing m_Tasks
@@ -1383,6 +1465,13 @@ void cWorld::DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_Blo
 			}
 		}
 
+		if (m_ShouldQueueExplosions && (a_Source == eExplosionSource::esPrimedTNT))
+		{
+			// Chain TNT detonates lots of TNT within a single tick, carry them out together once the chunks have ticked:
+			m_QueuedExplosions.push_back({ a_ExplosionSize, { a_BlockX, a_BlockY, a_BlockZ }, a_CanCauseFire, a_SourceData });
+			return;
+		}
+
 		Explodinator::Kaboom(*this, Vector3d(a_BlockX, a_BlockY, a_BlockZ), FloorC(a_ExplosionSize), a_CanCauseFire, Entity);
 		cPluginManager::Get()->CallHookExploded(*this, a_ExplosionSize, a_CanCauseFire, a_BlockX, a_BlockY, a_BlockZ, a_Source, a_SourceData);
 	}
@@ -1392,6 +1481,35 @@ void cWorld::DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_Blo
 
 
 
+void cWorld::TickQueuedExplosions(void)
+{
+	if (m_QueuedExplosions.empty())
+	{
+		return;
+	}
+
+	// The hooks may cause more explosions, those are carried out right away:
+	auto Queued = std::move(m_QueuedExplosions);
+	m_QueuedExplosions.clear();
+
+	std::vector<Explodinator::sExplosion> Explosions;
+	Explosions.reserve(Queued.size());
+	for (const auto & Explosion: Queued)
+	{
+		Explosions.push_back({ Explosion.m_Position, FloorC(Explosion.m_Size), Explosion.m_CanCauseFire, static_cast<const cEntity *>(Explosion.m_SourceData) });
+	}
+	Explodinator::Kaboom(*this, Explosions);
+
+	for (const auto & Explosion: Queued)
+	{
+		cPluginManager::Get()->CallHookExploded(*this, Explosion.m_Size, Explosion.m_CanCauseFire, Explosion.m_Position.x, Explosion.m_Position.y, Explosion.m_Position.z, eExplosionSource::esPrimedTNT, Explosion.m_SourceData);
+	}
+}
+
+
+
+
+
 bool cWorld::DoWithBlockEntityAt(const Vector3i a_Position, cBlockEntityCallback a_Callback)
 {
 	return m_ChunkMap.DoWithBlockEntityAt(a_Position, a_Callback);
@@ -1778,6 +1896,42 @@ bool cWorld::WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlock
 
 
 
+/** Writes the next steps of the area, and queues itself for the next tick until the whole area is written. */
+static void WriteBlockAreaSteps(cWorld & a_World, std::shared_ptr<cBlockAreaWriter> a_Writer, std::function<void(cWorld &, bool)> a_OnFinished)
+{
+	if (!a_Writer->WriteSteps(a_World, cBlockAreaWriter::BLOCKS_PER_TICK))
+	{
+		a_World.QueueTask([Writer = std::move(a_Writer), OnFinished = std::move(a_OnFinished)](cWorld & a_NextTickWorld)
+			{
+				WriteBlockAreaSteps(a_NextTickWorld, Writer, OnFinished);
+			}
+		);
+		return;
+	}
+	if (a_OnFinished != nullptr)
+	{
+		a_OnFinished(a_World, a_Writer->IsSuccessful());
+	}
+}
+
+
+
+
+
+void cWorld::WriteBlockAreaInSteps(std::shared_ptr<const cBlockArea> a_Area, Vector3i a_MinCoords, int a_DataTypes, std::function<void(cWorld &, bool)> a_OnFinished)
+{
+	auto Writer = std::make_shared<cBlockAreaWriter>(std::move(a_Area), a_MinCoords, a_DataTypes);
+	QueueTask([Writer = std::move(Writer), OnFinished = std::move(a_OnFinished)](cWorld & a_World)
+		{
+			WriteBlockAreaSteps(a_World, Writer, OnFinished);
+		}
+	);
+}
+
+
+
+
+
 void cWorld::SpawnItemPickups(const cItems & a_Pickups, Vector3i a_BlockPos, double a_FlyAwaySpeed, bool a_IsPlayerCreated)
 {
 	auto & random = GetRandomProvider();
@@ -3048,7 +3202,7 @@ cRedstoneSimulator * cWorld::InitializeRedstoneSimulator(cIniFile & a_IniFile)
 		res = new cIncrementalRedstoneSimulator(*this);
 	}
 
-	m_SimulatorManager->RegisterSimulator(res, 2 /* Two game ticks is a redstone tick */);
+	m_SimulatorManager->RegisterSimulator(res, 2 /* Two game ticks is a redstone tick */, "Redstone");
 
 	return res;
 }
@@ -3118,7 +3272,7 @@ cFluidSimulator * cWorld::InitializeFluidSimulator(cIniFile & a_IniFile, const c
 		}
 	}
 
-	m_SimulatorManager->RegisterSimulator(res, Rate);
+	m_SimulatorManager->RegisterSimulator(res, Rate, a_FluidName);
 
 	return res;
 }
@@ -19,6 +19,7 @@
 #include "Blocks/WorldInterface.h"
 #include "Blocks/BroadcastInterface.h"
 #include "EffectID.h"
+#include "TickProfiler.h"
 
 
 
@@ -37,6 +38,8 @@ class cCuboid;
 class cCompositeChat;
 class cDeadlockDetect;
 class cUUID;
+class cMetricGauge;
+class cMetricHistogram;
 
 struct SetChunkData;
 
@@ -400,6 +403,12 @@ public:
 	Doesn't wake up simulators, use WakeUpSimulatorsInArea() for that. */
 	virtual bool WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlockY, int a_MinBlockZ, int a_DataTypes) override;
 
+	/** Writes the block area into the specified coords in small, bounded steps, a few chunk sections per tick, see cBlockAreaWriter.
+	Keeps the tick responsive while writing large areas; the world sees the area partially written in the meantime.
+	The area must not be modified until the write is finished. a_OnFinished, if assigned, is called on the tick thread
+	once the whole area has been written, with true if all the chunks have been processed. */
+	void WriteBlockAreaInSteps(std::shared_ptr<const cBlockArea> a_Area, Vector3i a_MinCoords, int a_DataTypes, std::function<void(cWorld &, bool)> a_OnFinished);  // Exported as cBlockArea:WriteInSteps() in ManualBindings_BlockArea.cpp
+
 	// tolua_begin
 
 	/** Spawns item pickups for each item in the list.
@@ -591,6 +600,9 @@ public:
 
 	inline cSimulatorManager * GetSimulatorManager(void) { return m_SimulatorManager.get(); }
 
+	/** Returns the profiler of the world's ticks. */
+	cTickProfiler & GetTickProfiler(void) { return m_TickProfiler; }
+
 	inline cFluidSimulator * GetWaterSimulator(void) { return m_WaterSimulator; }
 	inline cFluidSimulator * GetLavaSimulator (void) { return m_LavaSimulator; }
 	inline cRedstoneSimulator * GetRedstoneSimulator(void) { return m_RedstoneSimulator; }
@@ -600,6 +612,8 @@ public:
 
 	/** Does an explosion with the specified strength at the specified coordinates.
 	Executes the HOOK_EXPLODING and HOOK_EXPLODED hooks as part of the processing.
+	The explosions of the primed TNT detonated while the chunks are ticking are coalesced: HOOK_EXPLODING is called right away,
+	the explosion itself and HOOK_EXPLODED once the chunks have ticked, together with the other TNT that detonated in that tick.
 	a_SourceData exact type depends on the a_Source, see the declaration of the esXXX constants in Defines.h for details.
 	Exported to Lua manually in ManualBindings_World.cpp in order to support the variable a_SourceData param. */
 	virtual void DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_BlockY, double a_BlockZ, bool a_CanCauseFire, eExplosionSource a_Source, void * a_SourceData) override;
@@ -767,8 +781,9 @@ public:
 
 	void InitializeSpawn(void);
 
-	/** Starts threads that belong to this world. */
-	void Start();
+	/** Starts threads that belong to this world.
+	The tick thread is tracked in a_DeadlockDetect for the sampling profiler. */
+	void Start(cDeadlockDetect & a_DeadlockDetect);
 
 	/** Stops threads that belong to this world (part of deinit).
 	a_DeadlockDetect is used for tracking this world's age, detecting a possible deadlock. */
@@ -1099,6 +1114,41 @@ private:
 	/** Queue for the chunk data to be set into m_ChunkMap by the tick thread. Protected by m_CSSetChunkDataQueue */
 	std::vector<SetChunkData> m_SetChunkDataQueue;
 
+	/** An explosion of a primed TNT, queued by DoExplosionAt() while the chunks are ticking. */
+	struct sQueuedExplosion
+	{
+		double m_Size;
+		Vector3d m_Position;
+		bool m_CanCauseFire;
+
+		/** The exploding cTNTEntity; it stays in the world until the queued tasks are executed, after the explosion. */
+		void * m_SourceData;
+	};
+
+	/** Set while the chunks are ticking, DoExplosionAt() then queues the explosions of the primed TNT instead of carrying them out. */
+	bool m_ShouldQueueExplosions;
+
+	/** The explosions of the primed TNT detonated during the current chunk map tick. Accessed only by the tick thread. */
+	std::vector<sQueuedExplosion> m_QueuedExplosions;
+
+	/** Times the phases of each tick and captures the breakdown of the slow ticks. */
+	cTickProfiler m_TickProfiler;
+
+	/** The duration of the whole tick. Owned by cMetrics, as are the other metrics. */
+	cMetricHistogram * m_TickMetric;
+
+	/** The durations of the tick phases, indexed by cTickProfiler::ePhase. */
+	std::array<cMetricHistogram *, cTickProfiler::phCount> m_TickPhaseMetrics;
+
+	/** The lengths of the generator, lighting, storage load and storage save queues, updated once a second by the tick thread. */
+	cMetricGauge * m_GeneratorQueueMetric;
+	cMetricGauge * m_LightingQueueMetric;
+	cMetricGauge * m_StorageLoadQueueMetric;
+	cMetricGauge * m_StorageSaveQueueMetric;
+
+	/** The number of the chunks loaded in the world, updated once a second by the tick thread. */
+	cMetricGauge * m_NumChunksMetric;
+
 	void Tick(std::chrono::milliseconds a_Dt, std::chrono::milliseconds a_LastTickDurationMSec);
 
 	/** Handles the weather in each tick */
@@ -1117,6 +1167,15 @@ private:
 	/** Executes all tasks queued onto the tick thread */
 	void TickQueuedTasks(void);
 
+	/** Carries out the explosions queued in m_QueuedExplosions all at once, then calls HOOK_EXPLODED for each of them. */
+	void TickQueuedExplosions(void);
+
+	/** Looks up the metrics of this world in cMetrics. */
+	void RegisterMetrics(void);
+
+	/** Updates the world's gauges in cMetrics. */
+	void UpdateMetrics(void);
+
 	/** Unloads all chunks immediately. */
 	void UnloadUnusedChunks(void);
 
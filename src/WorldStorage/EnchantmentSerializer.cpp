@@ -5,7 +5,7 @@
 #include "FastNBT.h"
 #include "../Enchantments.h"
 
-void EnchantmentSerializer::WriteToNBTCompound(const cEnchantments & a_Enchantments, cFastNBTWriter & a_Writer, const AString & a_ListTagName)
+void EnchantmentSerializer::WriteToNBTCompound(const cEnchantments & a_Enchantments, cFastNBTWriter & a_Writer, std::string_view a_ListTagName)
 {
 	// Write the enchantments into the specified NBT writer
 	// begin with the LIST tag of the specified name ("ench" or "StoredEnchantments")
@@ -113,6 +113,10 @@ AString cNBTParseErrorCategory::message(int a_Condition) const
 		{
 			return "Unknown tag";
 		}
+		case eNBTParseError::npNestingTooDeep:
+		{
+			return "Tags nested too deep";
+		}
 	}
 	UNREACHABLE("Unsupported nbt parse error");
 }
@@ -151,34 +155,45 @@ cParsedNBT::cParsedNBT(const ContiguousByteBufferView a_Data) :
 	m_Data(a_Data),
 	m_Pos(0)
 {
-	m_Error = Parse();
+	m_Error = Parse(TAG_Compound);
+}
+
+
+
+
+
+cParsedNBT::cParsedNBT(const ContiguousByteBufferView a_Data, const eTagType a_RootType) :
+	m_Data(a_Data),
+	m_Pos(0)
+{
+	m_Error = Parse(a_RootType);
 }
 
 
 
 
 
-eNBTParseError cParsedNBT::Parse(void)
+eNBTParseError cParsedNBT::Parse(const eTagType a_RootType)
 {
 	if (m_Data.size() < 3)
 	{
 		// Data too short
 		return eNBTParseError::npNeedBytes;
 	}
-	if (m_Data[0] != std::byte(TAG_Compound))
+	if (m_Data[0] != std::byte(a_RootType))
 	{
-		// The top-level tag must be a Compound
+		// The top-level tag must be of the requested type, a Compound for whole NBTs
 		return eNBTParseError::npNoTopLevelCompound;
 	}
 
 	m_Tags.reserve(NBT_RESERVE_SIZE);
 
-	m_Tags.emplace_back(TAG_Compound, -1);
+	m_Tags.emplace_back(a_RootType, -1);
 
 	m_Pos = 1;
 
 	PROPAGATE_ERROR(ReadString(m_Tags.back().m_NameStart, m_Tags.back().m_NameLength));
-	return ReadCompound();
+	return ReadTag();
 }
 
 
@@ -462,14 +477,367 @@ size_t cParsedNBT::GetMinTagSize(eTagType a_TagType)
 
 
 
+////////////////////////////////////////////////////////////////////////////////
+// cNBTStreamReader:
+
+cNBTStreamReader::cNBTStreamReader(const ContiguousByteBufferView a_Data) :
+	m_Data(a_Data),
+	m_Error(eNBTParseError::npSuccess),
+	m_Pos(0),
+	m_Depth(-1),
+	m_HasTag(false),
+	m_TagStart(0),
+	m_Type(TAG_End),
+	m_ChildrenType(TAG_End),
+	m_Count(0),
+	m_DataStart(0),
+	m_DataLength(0)
+{
+	if (m_Data.size() < 3)
+	{
+		// Data too short
+		SetError(eNBTParseError::npNeedBytes);
+		return;
+	}
+	if (m_Data[0] != std::byte(TAG_Compound))
+	{
+		// The top-level tag must be a Compound
+		SetError(eNBTParseError::npNoTopLevelCompound);
+		return;
+	}
+
+	// Skip the top-level compound's name, the reader starts inside the compound:
+	m_Pos = 1;
+	auto Err = ReadName();
+	if (Err != eNBTParseError::npSuccess)
+	{
+		SetError(Err);
+		return;
+	}
+	m_Depth = 0;
+	m_Stack[0] = { TAG_Compound, TAG_End, 0 };
+}
+
+
+
+
+
+bool cNBTStreamReader::NextTag(void)
+{
+	if (!IsValid() || (m_Depth < 0))
+	{
+		return false;
+	}
+
+	// Skip the items of the current tag, if the caller didn't enter it:
+	if (m_HasTag && ((m_Type == TAG_Compound) || (m_Type == TAG_List)))
+	{
+		if (!SkipChildren())
+		{
+			return false;
+		}
+	}
+	m_HasTag = false;
+
+	auto & Parent = m_Stack[m_Depth];
+	m_TagStart = m_Pos;
+	if (Parent.m_Type == TAG_List)
+	{
+		if (Parent.m_Remaining == 0)
+		{
+			// No more items, leave the list:
+			m_Depth--;
+			return false;
+		}
+		Parent.m_Remaining--;
+		m_Type = Parent.m_ChildrenType;
+		m_Name = {};
+	}
+	else
+	{
+		if (m_Pos >= m_Data.size())
+		{
+			return SetError(eNBTParseError::npCompoundImbalancedTag);
+		}
+		const auto TagType = m_Data[m_Pos];
+		if (TagType > std::byte(TAG_Max))
+		{
+			return SetError(eNBTParseError::npUnknownTag);
+		}
+		m_Pos++;
+		if (TagType == std::byte(TAG_End))
+		{
+			// No more children, leave the compound:
+			m_Depth--;
+			return false;
+		}
+		m_Type = static_cast<eTagType>(TagType);
+		auto Err = ReadName();
+		if (Err != eNBTParseError::npSuccess)
+		{
+			return SetError(Err);
+		}
+	}
+
+	auto Err = ReadTagHeader();
+	if (Err != eNBTParseError::npSuccess)
+	{
+		return SetError(Err);
+	}
+	m_HasTag = true;
+	return true;
+}
+
+
+
+
+
+bool cNBTStreamReader::EnterTag(void)
+{
+	ASSERT(m_HasTag);
+	ASSERT((m_Type == TAG_Compound) || (m_Type == TAG_List));
+
+	if (!IsValid())
+	{
+		return false;
+	}
+	if (m_Depth >= MAX_STACK - 1)
+	{
+		return SetError(eNBTParseError::npNestingTooDeep);
+	}
+	m_Depth++;
+	m_Stack[m_Depth] = { m_Type, m_ChildrenType, m_Count };
+	m_HasTag = false;
+	return true;
+}
+
+
+
+
+
+ContiguousByteBufferView cNBTStreamReader::ReadRawTag(void)
+{
+	ASSERT(m_HasTag);
+	ASSERT(m_Stack[m_Depth].m_Type == TAG_Compound);
+
+	const auto Type = m_Type;
+	const auto Name = m_Name;
+	const auto TagStart = m_TagStart;
+	if (((Type == TAG_Compound) || (Type == TAG_List)) && !SkipChildren())
+	{
+		return {};
+	}
+
+	// Skipping the children overwrote the current tag, restore it; it's been consumed, though:
+	m_Type = Type;
+	m_Name = Name;
+	m_HasTag = false;
+	return m_Data.substr(TagStart, m_Pos - TagStart);
+}
+
+
+
+
+
+eNBTParseError cNBTStreamReader::ReadName(void)
+{
+	NEEDBYTES(2, eNBTParseError::npStringMissingLength);
+	const auto Length = static_cast<size_t>(static_cast<UInt16>(GetBEShort(m_Data.data() + m_Pos)));
+	NEEDBYTES(2 + Length, eNBTParseError::npStringInvalidLength);
+	m_Name = { reinterpret_cast<const char *>(m_Data.data()) + m_Pos + 2, Length };
+	m_Pos += 2 + Length;
+	return eNBTParseError::npSuccess;
+}
+
+
+
+
+
+#define CASE_SIMPLE_TAG(TAGTYPE, LEN) \
+	case TAG_##TAGTYPE: \
+	{ \
+		NEEDBYTES(LEN, eNBTParseError::npSimpleMissing); \
+		m_DataStart = m_Pos; \
+		m_DataLength = LEN; \
+		m_Pos += LEN; \
+		return eNBTParseError::npSuccess; \
+	}
+
+eNBTParseError cNBTStreamReader::ReadTagHeader(void)
+{
+	switch (m_Type)
+	{
+		CASE_SIMPLE_TAG(Byte,   1)
+		CASE_SIMPLE_TAG(Short,  2)
+		CASE_SIMPLE_TAG(Int,    4)
+		CASE_SIMPLE_TAG(Long,   8)
+		CASE_SIMPLE_TAG(Float,  4)
+		CASE_SIMPLE_TAG(Double, 8)
+
+		case TAG_String:
+		{
+			NEEDBYTES(2, eNBTParseError::npStringMissingLength);
+			m_DataLength = static_cast<size_t>(static_cast<UInt16>(GetBEShort(m_Data.data() + m_Pos)));
+			NEEDBYTES(2 + m_DataLength, eNBTParseError::npStringInvalidLength);
+			m_DataStart = m_Pos + 2;
+			m_Pos += 2 + m_DataLength;
+			return eNBTParseError::npSuccess;
+		}
+
+		case TAG_ByteArray:
+		case TAG_IntArray:
+		{
+			NEEDBYTES(4, eNBTParseError::npArrayMissingLength);
+			const int Count = GetBEInt(m_Data.data() + m_Pos);
+			m_Pos += 4;
+			const size_t ElementSize = (m_Type == TAG_IntArray) ? 4 : 1;
+			if ((Count < 0) || (static_cast<size_t>(Count) > (m_Data.size() - m_Pos) / ElementSize))
+			{
+				return eNBTParseError::npArrayInvalidLength;
+			}
+			m_Count = static_cast<size_t>(Count);
+			m_DataStart = m_Pos;
+			m_DataLength = m_Count * ElementSize;
+			m_Pos += m_DataLength;
+			return eNBTParseError::npSuccess;
+		}
+
+		case TAG_List:
+		{
+			NEEDBYTES(1, eNBTParseError::npListMissingType);
+			const auto ChildrenType = m_Data[m_Pos];
+			if (ChildrenType > std::byte(TAG_Max))
+			{
+				return eNBTParseError::npUnknownTag;
+			}
+			m_ChildrenType = static_cast<eTagType>(ChildrenType);
+			m_Pos++;
+			NEEDBYTES(4, eNBTParseError::npListMissingLength);
+			const int Count = GetBEInt(m_Data.data() + m_Pos);
+			m_Pos += 4;
+			if ((Count < 0) || (static_cast<size_t>(Count) > (m_Data.size() - m_Pos) / cParsedNBT::GetMinTagSize(m_ChildrenType)))
+			{
+				return eNBTParseError::npListInvalidLength;
+			}
+			m_Count = static_cast<size_t>(Count);
+			return eNBTParseError::npSuccess;
+		}
+
+		case TAG_Compound:
+		{
+			// The children are read by NextTag()
+			m_Count = 0;
+			return eNBTParseError::npSuccess;
+		}
+
+		case TAG_End:
+		{
+			return eNBTParseError::npUnknownTag;
+		}
+	}
+	UNREACHABLE("Unsupported nbt tag type");
+}
+
+#undef CASE_SIMPLE_TAG
+
+
+
+
+
+bool cNBTStreamReader::SkipChildren(void)
+{
+	ASSERT((m_Type == TAG_Compound) || (m_Type == TAG_List));
+
+	// Lists of fixed-size items can be skipped in one go, the size has been checked by ReadTagHeader():
+	if (m_Type == TAG_List)
+	{
+		size_t ItemSize = 0;
+		switch (m_ChildrenType)
+		{
+			case TAG_Byte:   ItemSize = 1; break;
+			case TAG_Short:  ItemSize = 2; break;
+			case TAG_Int:    ItemSize = 4; break;
+			case TAG_Long:   ItemSize = 8; break;
+			case TAG_Float:  ItemSize = 4; break;
+			case TAG_Double: ItemSize = 8; break;
+			default: break;
+		}
+		if ((ItemSize > 0) || (m_Count == 0))
+		{
+			m_Pos += ItemSize * m_Count;
+			m_HasTag = false;
+			return true;
+		}
+	}
+
+	// Enter the tag and read everything nested in it, entering all the compounds and lists, until the reader is back at this level:
+	const auto Depth = m_Depth;
+	if (!EnterTag())
+	{
+		return false;
+	}
+	while (m_Depth > Depth)
+	{
+		if (NextTag())
+		{
+			if (((m_Type == TAG_Compound) || (m_Type == TAG_List)) && !EnterTag())
+			{
+				return false;
+			}
+		}
+		else if (!IsValid())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+
+
+bool cNBTStreamReader::SetError(const eNBTParseError a_Error)
+{
+	m_Error = a_Error;
+	m_HasTag = false;
+	return false;
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cFastNBTWriter:
 
-cFastNBTWriter::cFastNBTWriter(const AString & a_RootTagName) :
-	m_CurrentStack(0)
+cFastNBTWriter::cFastNBTWriter(const std::string_view a_RootTagName) :
+	m_CurrentStack(0),
+	m_Result(m_OwnResult)
+{
+	m_OwnResult.reserve(100 KiB);
+	Start(a_RootTagName);
+}
+
+
+
+
+
+cFastNBTWriter::cFastNBTWriter(ContiguousByteBuffer & a_Buffer, const std::string_view a_RootTagName) :
+	m_CurrentStack(0),
+	m_Result(a_Buffer)
+{
+	m_Result.clear();
+	Start(a_RootTagName);
+}
+
+
+
+
+
+void cFastNBTWriter::Start(const std::string_view a_RootTagName)
 {
 	m_Stack[0].m_Type = TAG_Compound;
-	m_Result.reserve(100 KiB);
 	m_Result.push_back(std::byte(TAG_Compound));
 	WriteString(a_RootTagName);
 }
@@ -478,7 +846,7 @@ cFastNBTWriter::cFastNBTWriter(const AString & a_RootTagName) :
 
 
 
-void cFastNBTWriter::BeginCompound(const AString & a_Name)
+void cFastNBTWriter::BeginCompound(const std::string_view a_Name)
 {
 	if (m_CurrentStack >= MAX_STACK - 1)
 	{
@@ -509,7 +877,7 @@ void cFastNBTWriter::EndCompound(void)
 
 
 
-void cFastNBTWriter::BeginList(const AString & a_Name, eTagType a_ChildrenType)
+void cFastNBTWriter::BeginList(const std::string_view a_Name, eTagType a_ChildrenType)
 {
 	if (m_CurrentStack >= MAX_STACK - 1)
 	{
@@ -548,7 +916,7 @@ void cFastNBTWriter::EndList(void)
 
 
 
-void cFastNBTWriter::AddByte(const AString & a_Name, unsigned char a_Value)
+void cFastNBTWriter::AddByte(const std::string_view a_Name, unsigned char a_Value)
 {
 	TagCommon(a_Name, TAG_Byte);
 	m_Result.push_back(std::byte(a_Value));
@@ -558,7 +926,7 @@ void cFastNBTWriter::AddByte(const AString & a_Name, unsigned char a_Value)
 
 
 
-void cFastNBTWriter::AddShort(const AString & a_Name, Int16 a_Value)
+void cFastNBTWriter::AddShort(const std::string_view a_Name, Int16 a_Value)
 {
 	TagCommon(a_Name, TAG_Short);
 	UInt16 Value = htons(static_cast<UInt16>(a_Value));
@@ -569,7 +937,7 @@ void cFastNBTWriter::AddShort(const AString & a_Name, Int16 a_Value)
 
 
 
-void cFastNBTWriter::AddInt(const AString & a_Name, Int32 a_Value)
+void cFastNBTWriter::AddInt(const std::string_view a_Name, Int32 a_Value)
 {
 	TagCommon(a_Name, TAG_Int);
 	UInt32 Value = htonl(static_cast<UInt32>(a_Value));
@@ -580,7 +948,7 @@ void cFastNBTWriter::AddInt(const AString & a_Name, Int32 a_Value)
 
 
 
-void cFastNBTWriter::AddLong(const AString & a_Name, Int64 a_Value)
+void cFastNBTWriter::AddLong(const std::string_view a_Name, Int64 a_Value)
 {
 	TagCommon(a_Name, TAG_Long);
 	UInt64 Value = HostToNetwork8(&a_Value);
@@ -591,7 +959,7 @@ void cFastNBTWriter::AddLong(const AString & a_Name, Int64 a_Value)
 
 
 
-void cFastNBTWriter::AddFloat(const AString & a_Name, float a_Value)
+void cFastNBTWriter::AddFloat(const std::string_view a_Name, float a_Value)
 {
 	TagCommon(a_Name, TAG_Float);
 	UInt32 Value = HostToNetwork4(&a_Value);
@@ -602,7 +970,7 @@ void cFastNBTWriter::AddFloat(const AString & a_Name, float a_Value)
 
 
 
-void cFastNBTWriter::AddDouble(const AString & a_Name, double a_Value)
+void cFastNBTWriter::AddDouble(const std::string_view a_Name, double a_Value)
 {
 	TagCommon(a_Name, TAG_Double);
 	UInt64 Value = HostToNetwork8(&a_Value);
@@ -613,7 +981,7 @@ void cFastNBTWriter::AddDouble(const AString & a_Name, double a_Value)
 
 
 
-void cFastNBTWriter::AddString(const AString & a_Name, const std::string_view a_Value)
+void cFastNBTWriter::AddString(const std::string_view a_Name, const std::string_view a_Value)
 {
 	TagCommon(a_Name, TAG_String);
 	const UInt16 Length = htons(static_cast<UInt16>(a_Value.size()));
@@ -625,7 +993,7 @@ void cFastNBTWriter::AddString(const AString & a_Name, const std::string_view a_
 
 
 
-void cFastNBTWriter::AddByteArray(const AString & a_Name, const char * a_Value, size_t a_NumElements)
+void cFastNBTWriter::AddByteArray(const std::string_view a_Name, const char * a_Value, size_t a_NumElements)
 {
 	TagCommon(a_Name, TAG_ByteArray);
 	UInt32 len = htonl(static_cast<UInt32>(a_NumElements));
@@ -637,7 +1005,7 @@ void cFastNBTWriter::AddByteArray(const AString & a_Name, const char * a_Value,
 
 
 
-void cFastNBTWriter::AddByteArray(const AString & a_Name, size_t a_NumElements, unsigned char a_Value)
+void cFastNBTWriter::AddByteArray(const std::string_view a_Name, size_t a_NumElements, unsigned char a_Value)
 {
 	TagCommon(a_Name, TAG_ByteArray);
 	UInt32 len = htonl(static_cast<UInt32>(a_NumElements));
@@ -649,21 +1017,19 @@ void cFastNBTWriter::AddByteArray(const AString & a_Name, size_t a_NumElements,
 
 
 
-void cFastNBTWriter::AddIntArray(const AString & a_Name, const Int32 * a_Value, size_t a_NumElements)
+void cFastNBTWriter::AddIntArray(const std::string_view a_Name, const Int32 * a_Value, size_t a_NumElements)
 {
 	TagCommon(a_Name, TAG_IntArray);
 	UInt32 len = htonl(static_cast<UInt32>(a_NumElements));
-	size_t cap = m_Result.capacity();
-	size_t size = m_Result.length();
-	if ((cap - size) < (4 + a_NumElements * 4))
-	{
-		m_Result.reserve(size + 4 + (a_NumElements * 4));
-	}
 	m_Result.append(reinterpret_cast<const std::byte *>(&len), sizeof(len));
+
+	// Convert the elements in place, rather than appending them one by one:
+	const size_t Start = m_Result.size();
+	m_Result.resize(Start + a_NumElements * 4);
+	std::byte * Dst = m_Result.data() + Start;
 	for (size_t i = 0; i < a_NumElements; i++)
 	{
-		UInt32 Element = htonl(static_cast<UInt32>(a_Value[i]));
-		m_Result.append(reinterpret_cast<const std::byte *>(&Element), sizeof(Element));
+		SetBEInt(Dst + i * 4, a_Value[i]);
 	}
 }
 
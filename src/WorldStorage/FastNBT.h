@@ -8,9 +8,14 @@ The fast parser parses the data into a vector of cFastNBTTag structures. These s
 but themselves are allocated in a vector, thus minimizing reallocation.
 The structures have a minimal constructor, setting all member "pointers" to "invalid".
 
+The stream reader doesn't build any tree at all, it is pulled through the data tag by tag (NextTag(), EnterTag()),
+and the tags that the caller doesn't enter are skipped. It is used for loading chunks, where most of the data
+is read exactly once, in order.
+
 The fast writer doesn't need a NBT tree structure built beforehand, it is commanded to open, append and close tags
 (just like XML); it keeps the internal tag stack and reports errors in usage.
-It directly outputs a string containing the serialized NBT data.
+It directly outputs a string containing the serialized NBT data, either into its own buffer, or into a buffer
+provided by the caller, so that the buffer's memory can be reused for multiple NBTs.
 */
 
 
@@ -123,6 +128,7 @@ enum class eNBTParseError
 	npArrayMissingLength,
 	npArrayInvalidLength,
 	npUnknownTag,
+	npNestingTooDeep,
 };
 
 // The following is required to make an error_code constructible from an eNBTParseError
@@ -154,6 +160,10 @@ class cParsedNBT
 public:
 	cParsedNBT(ContiguousByteBufferView a_Data);
 
+	/** Parses a single named tag of the specified type, such as a List tag cut out of a larger NBT by cNBTStreamReader::ReadRawTag().
+	The parsed tag is the root tag, with the index GetRoot(). */
+	cParsedNBT(ContiguousByteBufferView a_Data, eTagType a_RootType);
+
 	bool IsValid(void) const { return (m_Error == eNBTParseError::npSuccess); }
 
 	/** Returns the error code for the parsing of the NBT data. */
@@ -289,6 +299,10 @@ public:
 		return { reinterpret_cast<const char *>(GetData(a_Tag)), GetDataLength(a_Tag) };
 	}
 
+	/** Returns the minimum size, in bytes, of the specified tag type.
+	Used for sanity-checking. */
+	static size_t GetMinTagSize(eTagType a_TagType);
+
 	/** Returns the tag's name. For tags that are not named, returns an empty string. */
 	inline AString GetName(int a_Tag) const
 	{
@@ -306,15 +320,183 @@ protected:
 	// Used while parsing:
 	size_t m_Pos;
 
-	eNBTParseError Parse(void);
+	eNBTParseError Parse(eTagType a_RootType);
 	eNBTParseError ReadString(size_t & a_StringStart, size_t & a_StringLen);  // Reads a simple string (2 bytes length + data), sets the string descriptors
 	eNBTParseError ReadCompound(void);  // Reads the latest tag as a compound
 	eNBTParseError ReadList(eTagType a_ChildrenType);  // Reads the latest tag as a list of items of type a_ChildrenType
 	eNBTParseError ReadTag(void);       // Reads the latest tag, depending on its m_Type setting
 
-	/** Returns the minimum size, in bytes, of the specified tag type.
-	Used for sanity-checking. */
-	static size_t GetMinTagSize(eTagType a_TagType);
+} ;
+
+
+
+
+
+/** Pull-style NBT reader that reads the tags in the order in which they are stored, without building a tag tree.
+The reader starts inside the top-level compound. NextTag() moves to the next tag in the current compound or list,
+EnterTag() makes the following NextTag() calls iterate over the current compound's or list's items instead.
+Tags that are not entered are skipped as a whole. Once a compound or list has no more items, NextTag() returns false
+and the reader is back in the parent, with the compound or list consumed; the parent's NextTag() continues after it.
+NextTag() returns false on a parse error, too, use IsValid() to tell the two apart.
+The data passed in the constructor is assumed to be valid throughout the object's life, the returned views point into it. */
+class cNBTStreamReader
+{
+public:
+	cNBTStreamReader(ContiguousByteBufferView a_Data);
+
+	bool IsValid(void) const { return (m_Error == eNBTParseError::npSuccess); }
+
+	/** Returns the error code for the parsing of the NBT data. */
+	std::error_code GetErrorCode() const { return m_Error; }
+
+	/** Returns the position where an error occurred while parsing. */
+	size_t GetErrorPos() const { return m_Pos; }
+
+	/** Moves to the next tag in the current compound or list, skipping the rest of the current tag.
+	Returns false if there are no more tags (leaving the compound or list) or on a parse error.
+	The tag accessors are not valid after this returns false. */
+	bool NextTag(void);
+
+	/** Makes the following NextTag() calls iterate over the items of the current tag, which must be a Compound or a List.
+	Returns false on a parse error. */
+	bool EnterTag(void);
+
+	/** Skips the current tag and returns its entire data, starting with the tag type and name.
+	The returned data can be parsed by cParsedNBT(data, GetType()). Only valid for tags in a compound, not list items.
+	Returns an empty view on a parse error. */
+	ContiguousByteBufferView ReadRawTag(void);
+
+	/** Returns the nesting level of the current tag, 0 for the children of the top-level compound. */
+	int GetDepth(void) const { return m_Depth; }
+
+	eTagType GetType(void) const { return m_Type; }
+
+	/** Returns the tag's name. For tags that are not named (list items), returns an empty string. */
+	std::string_view GetName(void) const { return m_Name; }
+
+	/** Returns the children type for a List tag; undefined on other tags. If list empty, returns TAG_End. */
+	eTagType GetChildrenType(void) const
+	{
+		ASSERT(m_Type == TAG_List);
+		return (m_Count == 0) ? TAG_End : m_ChildrenType;
+	}
+
+	/** Returns the number of items in a List tag, or the number of elements of a ByteArray or IntArray tag. */
+	size_t GetCount(void) const { return m_Count; }
+
+	/** Returns the length of the tag's data, in bytes.
+	Not valid for Compound or List tags! */
+	size_t GetDataLength(void) const
+	{
+		ASSERT(m_Type != TAG_List);
+		ASSERT(m_Type != TAG_Compound);
+		return m_DataLength;
+	}
+
+	/** Returns the data stored in this tag.
+	Not valid for Compound or List tags! */
+	const std::byte * GetData(void) const
+	{
+		ASSERT(m_Type != TAG_List);
+		ASSERT(m_Type != TAG_Compound);
+		return m_Data.data() + m_DataStart;
+	}
+
+	/** Returns the value stored in a Byte tag. Not valid for any other tag type. */
+	unsigned char GetByte(void) const
+	{
+		ASSERT(m_Type == TAG_Byte);
+		return static_cast<unsigned char>(m_Data[m_DataStart]);
+	}
+
+	/** Returns the value stored in a Short tag. Not valid for any other tag type. */
+	Int16 GetShort(void) const
+	{
+		ASSERT(m_Type == TAG_Short);
+		return GetBEShort(GetData());
+	}
+
+	/** Returns the value stored in an Int tag. Not valid for any other tag type. */
+	Int32 GetInt(void) const
+	{
+		ASSERT(m_Type == TAG_Int);
+		return GetBEInt(GetData());
+	}
+
+	/** Returns the value stored in a Long tag. Not valid for any other tag type. */
+	Int64 GetLong(void) const
+	{
+		ASSERT(m_Type == TAG_Long);
+		return NetworkToHostLong8(GetData());
+	}
+
+	/** Returns the value stored in a Float tag. Not valid for any other tag type. */
+	float GetFloat(void) const
+	{
+		ASSERT(m_Type == TAG_Float);
+		Int32 i = GetBEInt(GetData());
+		float f;
+		memcpy(&f, &i, sizeof(f));
+		return f;
+	}
+
+	/** Returns the value stored in a Double tag. Not valid for any other tag type. */
+	double GetDouble(void) const
+	{
+		ASSERT(m_Type == TAG_Double);
+		return NetworkToHostDouble8(GetData());
+	}
+
+	/** Returns the value stored in a String tag. Not valid for any other tag type. */
+	std::string_view GetStringView(void) const
+	{
+		ASSERT(m_Type == TAG_String);
+		return { reinterpret_cast<const char *>(GetData()), m_DataLength };
+	}
+
+protected:
+
+	/** A compound or list that the reader has entered. */
+	struct sParent
+	{
+		eTagType m_Type;          // TAG_Compound or TAG_List
+		eTagType m_ChildrenType;  // for TAG_List, the item type
+		size_t m_Remaining;       // for TAG_List, the number of items not read yet
+	} ;
+
+	static const int MAX_STACK = 64;
+
+	ContiguousByteBufferView m_Data;
+	eNBTParseError m_Error;
+
+	/** The read position; after the current tag's header (for Compound and List tags) or after the entire tag (for the others). */
+	size_t m_Pos;
+
+	// The stack of the entered compounds and lists; m_Stack[0] is the top-level compound, m_Depth + 1 items are valid
+	sParent m_Stack[MAX_STACK];
+	int m_Depth;
+
+	// The current tag:
+	bool m_HasTag;          // false before the first tag of a compound / list and after leaving one
+	size_t m_TagStart;      // position of the tag type (compound children) or the data (list items)
+	eTagType m_Type;
+	std::string_view m_Name;
+	eTagType m_ChildrenType;
+	size_t m_Count;
+	size_t m_DataStart;
+	size_t m_DataLength;
+
+	/** Reads the header of the current tag's data, based on m_Type, and skips over any data apart from Compound and List items. */
+	eNBTParseError ReadTagHeader(void);
+
+	/** Skips over the items of the current Compound or List tag. */
+	bool SkipChildren(void);
+
+	/** Reads the name of the current tag, a simple string (2 bytes length + data). */
+	eNBTParseError ReadName(void);
+
+	/** Records the error and returns false. */
+	bool SetError(eNBTParseError a_Error);
 } ;
 
 
@@ -324,26 +506,33 @@ protected:
 class cFastNBTWriter
 {
 public:
-	cFastNBTWriter(const AString & a_RootTagName = "");
+	cFastNBTWriter(std::string_view a_RootTagName = "");
+
+	/** Creates a writer that outputs into a_Buffer, replacing its contents.
+	The buffer's capacity is kept, so a buffer reused for multiple NBTs is allocated only once. */
+	cFastNBTWriter(ContiguousByteBuffer & a_Buffer, std::string_view a_RootTagName = "");
 
-	void BeginCompound(const AString & a_Name);
+	cFastNBTWriter(const cFastNBTWriter &) = delete;
+	cFastNBTWriter & operator = (const cFastNBTWriter &) = delete;
+
+	void BeginCompound(std::string_view a_Name);
 	void EndCompound(void);
 
-	void BeginList(const AString & a_Name, eTagType a_ChildrenType);
+	void BeginList(std::string_view a_Name, eTagType a_ChildrenType);
 	void EndList(void);
 
-	void AddByte     (const AString & a_Name, unsigned char a_Value);
-	void AddShort    (const AString & a_Name, Int16 a_Value);
-	void AddInt      (const AString & a_Name, Int32 a_Value);
-	void AddLong     (const AString & a_Name, Int64 a_Value);
-	void AddFloat    (const AString & a_Name, float a_Value);
-	void AddDouble   (const AString & a_Name, double a_Value);
-	void AddString   (const AString & a_Name, std::string_view a_Value);
-	void AddByteArray(const AString & a_Name, const char * a_Value, size_t a_NumElements);
-	void AddByteArray(const AString & a_Name, size_t a_NumElements, unsigned char a_Value);
-	void AddIntArray (const AString & a_Name, const Int32 * a_Value, size_t a_NumElements);
-
-	void AddByteArray(const AString & a_Name, const AString & a_Value)
+	void AddByte     (std::string_view a_Name, unsigned char a_Value);
+	void AddShort    (std::string_view a_Name, Int16 a_Value);
+	void AddInt      (std::string_view a_Name, Int32 a_Value);
+	void AddLong     (std::string_view a_Name, Int64 a_Value);
+	void AddFloat    (std::string_view a_Name, float a_Value);
+	void AddDouble   (std::string_view a_Name, double a_Value);
+	void AddString   (std::string_view a_Name, std::string_view a_Value);
+	void AddByteArray(std::string_view a_Name, const char * a_Value, size_t a_NumElements);
+	void AddByteArray(std::string_view a_Name, size_t a_NumElements, unsigned char a_Value);
+	void AddIntArray (std::string_view a_Name, const Int32 * a_Value, size_t a_NumElements);
+
+	void AddByteArray(std::string_view a_Name, const AString & a_Value)
 	{
 		AddByteArray(a_Name, a_Value.data(), a_Value.size());
 	}
@@ -368,13 +557,20 @@ protected:
 	sParent m_Stack[MAX_STACK];
 	int     m_CurrentStack;
 
-	ContiguousByteBuffer m_Result;
+	/** The buffer used when the caller doesn't provide one. */
+	ContiguousByteBuffer m_OwnResult;
+
+	/** The buffer into which the NBT is written; either m_OwnResult or the buffer provided by the caller. */
+	ContiguousByteBuffer & m_Result;
 
 	bool IsStackTopCompound(void) const { return (m_Stack[m_CurrentStack].m_Type == TAG_Compound); }
 
 	void WriteString(std::string_view a_Data);
 
-	inline void TagCommon(const AString & a_Name, eTagType a_Type)
+	/** Writes the root compound's header. */
+	void Start(std::string_view a_RootTagName);
+
+	inline void TagCommon(std::string_view a_Name, eTagType a_Type)
 	{
 		// If we're directly inside a list, check that the list is of the correct type:
 		ASSERT((m_Stack[m_CurrentStack].m_Type != TAG_List) || (m_Stack[m_CurrentStack].m_ItemType == a_Type));
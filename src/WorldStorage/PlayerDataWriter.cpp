@@ -0,0 +1,522 @@
+
+// PlayerDataWriter.cpp
+
+// Implements the cPlayerDataWriter class that writes the player data files on a background thread
+
+#include "Globals.h"
+#include "PlayerDataWriter.h"
+#include "FastNBT.h"
+#include "../JsonUtils.h"
+#include "../OSSupport/GZipFile.h"
+
+
+
+
+
+namespace
+{
+
+/** Returns the NBT tag type in which the JSON value is stored on its own. */
+eTagType GetTagType(const Json::Value & a_Value)
+{
+	switch (a_Value.type())
+	{
+		case Json::nullValue:    return TAG_Compound;
+		case Json::booleanValue: return TAG_Byte;
+		case Json::realValue:    return TAG_Double;
+		case Json::arrayValue:   return TAG_List;
+		case Json::objectValue:  return TAG_Compound;
+		case Json::intValue:
+		{
+			auto Value = a_Value.asInt64();
+			return ((Value >= std::numeric_limits<Int32>::min()) && (Value <= std::numeric_limits<Int32>::max())) ? TAG_Int : TAG_Long;
+		}
+		case Json::uintValue:
+		{
+			auto Value = a_Value.asUInt64();
+			if (Value <= static_cast<UInt64>(std::numeric_limits<Int32>::max()))
+			{
+				return TAG_Int;
+			}
+			return (Value <= static_cast<UInt64>(std::numeric_limits<Int64>::max())) ? TAG_Long : TAG_Double;
+		}
+		case Json::stringValue:
+		{
+			// NBT strings have a 16-bit length, longer ones are stored as byte arrays:
+			return (a_Value.asString().size() <= std::numeric_limits<UInt16>::max()) ? TAG_String : TAG_ByteArray;
+		}
+	}
+	UNREACHABLE("Unsupported JSON value type");
+}
+
+
+
+
+
+/** Returns the NBT tag type in which all the items of the JSON array can be stored, TAG_End for an empty array.
+Returns false if the items don't have a common type. */
+bool GetListItemType(const Json::Value & a_Array, eTagType & a_ItemType)
+{
+	a_ItemType = TAG_End;
+	for (const auto & Item: a_Array)
+	{
+		auto Type = GetTagType(Item);
+		if ((a_ItemType == TAG_End) || (a_ItemType == Type))
+		{
+			a_ItemType = Type;
+		}
+		else if (
+			((a_ItemType == TAG_Int) || (a_ItemType == TAG_Long) || (a_ItemType == TAG_Double)) &&
+			((Type == TAG_Int) || (Type == TAG_Long) || (Type == TAG_Double))
+		)
+		{
+			// Numbers are widened to the largest type in the array:
+			a_ItemType = std::max(a_ItemType, Type);
+		}
+		else if (
+			((a_ItemType == TAG_String) || (a_ItemType == TAG_ByteArray)) &&
+			((Type == TAG_String) || (Type == TAG_ByteArray))
+		)
+		{
+			a_ItemType = TAG_ByteArray;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+
+
+/** Writes the JSON value into the NBT as a tag of the specified type, which is either GetTagType() of the value, or a wider type. */
+void WriteValue(cFastNBTWriter & a_Writer, std::string_view a_Name, const Json::Value & a_Value, eTagType a_Type)
+{
+	switch (a_Type)
+	{
+		case TAG_Byte:   a_Writer.AddByte(a_Name, a_Value.asBool() ? 1 : 0); return;
+		case TAG_Int:    a_Writer.AddInt(a_Name, static_cast<Int32>(a_Value.asInt64())); return;
+		case TAG_Long:   a_Writer.AddLong(a_Name, a_Value.asInt64()); return;
+		case TAG_Double: a_Writer.AddDouble(a_Name, a_Value.asDouble()); return;
+		case TAG_String: a_Writer.AddString(a_Name, a_Value.asString()); return;
+		case TAG_ByteArray:
+		{
+			a_Writer.AddByteArray(a_Name, a_Value.asString());
+			return;
+		}
+		case TAG_Compound:
+		{
+			a_Writer.BeginCompound(a_Name);
+			if (a_Value.isObject())
+			{
+				for (auto itr = a_Value.begin(), end = a_Value.end(); itr != end; ++itr)
+				{
+					if (!itr->isNull())
+					{
+						WriteValue(a_Writer, itr.name(), *itr, GetTagType(*itr));
+					}
+				}
+			}
+			a_Writer.EndCompound();
+			return;
+		}
+		case TAG_List:
+		{
+			eTagType ItemType;
+			if (GetListItemType(a_Value, ItemType))
+			{
+				a_Writer.BeginList(a_Name, ItemType);
+				for (const auto & Item: a_Value)
+				{
+					WriteValue(a_Writer, "", Item, ItemType);
+				}
+			}
+			else
+			{
+				// Mixed items, wrap each one in a compound:
+				a_Writer.BeginList(a_Name, TAG_Compound);
+				for (const auto & Item: a_Value)
+				{
+					a_Writer.BeginCompound("");
+					WriteValue(a_Writer, "", Item, GetTagType(Item));
+					a_Writer.EndCompound();
+				}
+			}
+			a_Writer.EndList();
+			return;
+		}
+		default: break;
+	}
+	UNREACHABLE("Unsupported NBT tag type");
+}
+
+
+
+
+
+/** Returns true if the list was written by WriteValue() for an array of mixed items, each wrapped in a compound. */
+bool IsWrappedList(const cParsedNBT & a_NBT, int a_Tag)
+{
+	if (a_NBT.GetChildrenType(a_Tag) != TAG_Compound)
+	{
+		return false;
+	}
+	for (int Child = a_NBT.GetFirstChild(a_Tag); Child >= 0; Child = a_NBT.GetNextSibling(Child))
+	{
+		int Value = a_NBT.GetFirstChild(Child);
+		if ((Value < 0) || (a_NBT.GetNextSibling(Value) >= 0) || !a_NBT.GetName(Value).empty())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+
+
+/** Returns the JSON value stored in the NBT tag. */
+Json::Value ReadValue(const cParsedNBT & a_NBT, int a_Tag)
+{
+	switch (a_NBT.GetType(a_Tag))
+	{
+		case TAG_Byte:   return Json::Value(a_NBT.GetByte(a_Tag) != 0);
+		case TAG_Short:  return Json::Value(a_NBT.GetShort(a_Tag));
+		case TAG_Int:    return Json::Value(a_NBT.GetInt(a_Tag));
+		case TAG_Long:   return Json::Value(static_cast<Json::Int64>(a_NBT.GetLong(a_Tag)));
+		case TAG_Float:  return Json::Value(a_NBT.GetFloat(a_Tag));
+		case TAG_Double: return Json::Value(a_NBT.GetDouble(a_Tag));
+		case TAG_String: return Json::Value(a_NBT.GetString(a_Tag));
+		case TAG_ByteArray:
+		{
+			auto Data = reinterpret_cast<const char *>(a_NBT.GetData(a_Tag));
+			return Json::Value(Data, Data + a_NBT.GetDataLength(a_Tag));
+		}
+		case TAG_IntArray:
+		{
+			Json::Value Res(Json::arrayValue);
+			for (size_t i = 0; i < a_NBT.GetDataLength(a_Tag); i += 4)
+			{
+				Res.append(GetBEInt(a_NBT.GetData(a_Tag) + i));
+			}
+			return Res;
+		}
+		case TAG_List:
+		{
+			Json::Value Res(Json::arrayValue);
+			bool IsWrapped = IsWrappedList(a_NBT, a_Tag);
+			for (int Child = a_NBT.GetFirstChild(a_Tag); Child >= 0; Child = a_NBT.GetNextSibling(Child))
+			{
+				Res.append(ReadValue(a_NBT, IsWrapped ? a_NBT.GetFirstChild(Child) : Child));
+			}
+			return Res;
+		}
+		case TAG_Compound:
+		{
+			Json::Value Res(Json::objectValue);
+			for (int Child = a_NBT.GetFirstChild(a_Tag); Child >= 0; Child = a_NBT.GetNextSibling(Child))
+			{
+				Res[a_NBT.GetName(Child)] = ReadValue(a_NBT, Child);
+			}
+			return Res;
+		}
+		case TAG_End: break;
+	}
+	return Json::Value();
+}
+
+}  // namespace (anonymous)
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cPlayerDataWriter:
+
+cPlayerDataWriter::cPlayerDataWriter(void) :
+	Super("Player Data Writer"),
+	m_Format(eFormat::Json)
+{
+}
+
+
+
+
+
+cPlayerDataWriter::~cPlayerDataWriter()
+{
+	Stop();
+
+	// Write anything that has been queued after the thread has finished:
+	Flush();
+}
+
+
+
+
+
+void cPlayerDataWriter::Start(eFormat a_Format)
+{
+	m_Format = a_Format;
+	Super::Start();
+}
+
+
+
+
+
+void cPlayerDataWriter::Queue(AString && a_FileBaseName, Json::Value && a_Data, eFormat a_Format)
+{
+	{
+		cCSLock Lock(m_CSQueue);
+		auto & FileData = m_Queue[std::move(a_FileBaseName)];
+		FileData.m_Data = std::move(a_Data);
+		FileData.m_Format = a_Format;
+	}
+	m_Event.Set();
+}
+
+
+
+
+
+bool cPlayerDataWriter::Load(const AString & a_FileBaseName, Json::Value & a_Data)
+{
+	cCSLock WriteLock(m_CSWrite);
+
+	// The queued data is newer than the file:
+	{
+		cCSLock Lock(m_CSQueue);
+		auto itr = m_Queue.find(a_FileBaseName);
+		if (itr != m_Queue.end())
+		{
+			a_Data = itr->second.m_Data;
+			return true;
+		}
+	}
+
+	auto OtherFormat = (m_Format == eFormat::Json) ? eFormat::NBT : eFormat::Json;
+	return (
+		LoadFile(a_FileBaseName, m_Format, a_Data) ||
+		LoadFile(a_FileBaseName, OtherFormat, a_Data)
+	);
+}
+
+
+
+
+
+void cPlayerDataWriter::Flush(void)
+{
+	while (WriteNext())
+	{
+	}
+}
+
+
+
+
+
+void cPlayerDataWriter::Stop(void)
+{
+	m_ShouldTerminate = true;
+	m_Event.Set();
+	Super::Stop();
+}
+
+
+
+
+
+cPlayerDataWriter::eFormat cPlayerDataWriter::FormatFromString(const AString & a_Name, eFormat a_Default)
+{
+	if (NoCaseCompare(a_Name, "json") == 0)
+	{
+		return eFormat::Json;
+	}
+	if (NoCaseCompare(a_Name, "nbt") == 0)
+	{
+		return eFormat::NBT;
+	}
+	return a_Default;
+}
+
+
+
+
+
+ContiguousByteBuffer cPlayerDataWriter::JsonToNBT(const Json::Value & a_Object)
+{
+	ASSERT(a_Object.isObject());
+
+	cFastNBTWriter Writer;
+	for (auto itr = a_Object.begin(), end = a_Object.end(); itr != end; ++itr)
+	{
+		if (!itr->isNull())
+		{
+			WriteValue(Writer, itr.name(), *itr, GetTagType(*itr));
+		}
+	}
+	Writer.Finish();
+	return ContiguousByteBuffer(Writer.GetResult());
+}
+
+
+
+
+
+bool cPlayerDataWriter::NBTToJson(ContiguousByteBufferView a_NBT, Json::Value & a_Object)
+{
+	cParsedNBT NBT(a_NBT);
+	if (!NBT.IsValid() || (NBT.GetType(NBT.GetRoot()) != TAG_Compound))
+	{
+		return false;
+	}
+	a_Object = ReadValue(NBT, NBT.GetRoot());
+	return true;
+}
+
+
+
+
+
+bool cPlayerDataWriter::WriteNext(void)
+{
+	cCSLock WriteLock(m_CSWrite);
+
+	AString FileBaseName;
+	sFileData FileData;
+	{
+		cCSLock Lock(m_CSQueue);
+		if (m_Queue.empty())
+		{
+			return false;
+		}
+		auto Node = m_Queue.extract(m_Queue.begin());
+		FileBaseName = std::move(Node.key());
+		FileData = std::move(Node.mapped());
+	}
+
+	WriteFile(FileBaseName, FileData);
+	return true;
+}
+
+
+
+
+
+void cPlayerDataWriter::WriteFile(const AString & a_FileBaseName, const sFileData & a_FileData)
+{
+	auto FolderEnd = a_FileBaseName.find_last_of("/\\");
+	if (FolderEnd != AString::npos)
+	{
+		cFile::CreateFolderRecursive(a_FileBaseName.substr(0, FolderEnd + 1));
+	}
+
+	// Write into a temporary file, then replace the old file with it, so that the old file stays intact if the write fails:
+	auto FileName = a_FileBaseName + GetExtension(a_FileData.m_Format);
+	auto TempFileName = FileName + ".tmp";
+	try
+	{
+		OutputFileStream File(TempFileName, OutputFileStream::binary);
+		if (a_FileData.m_Format == eFormat::NBT)
+		{
+			File << Compression::Compressor().CompressGZip(JsonToNBT(a_FileData.m_Data)).GetStringView();
+		}
+		else
+		{
+			File << JsonUtils::WriteStyledString(a_FileData.m_Data);
+		}
+		File.close();
+	}
+	catch (const std::exception & Oops)
+	{
+		LOGWARNING("Error writing player data to file \"%s\": %s. Player will lose their progress", FileName, Oops.what());
+		cFile::DeleteFile(TempFileName);
+		return;
+	}
+	if (!cFile::Replace(TempFileName, FileName))
+	{
+		LOGWARNING("Error writing player data to file \"%s\": cannot replace the file. Player will lose their progress", FileName);
+		cFile::DeleteFile(TempFileName);
+		return;
+	}
+
+	// Remove the file in the other format, once the data is safely stored in this one:
+	auto OtherFileName = a_FileBaseName + GetExtension((a_FileData.m_Format == eFormat::Json) ? eFormat::NBT : eFormat::Json);
+	if (cFile::IsFile(OtherFileName))
+	{
+		cFile::DeleteFile(OtherFileName);
+	}
+}
+
+
+
+
+
+bool cPlayerDataWriter::LoadFile(const AString & a_FileBaseName, eFormat a_Format, Json::Value & a_Data)
+{
+	auto FileName = a_FileBaseName + GetExtension(a_Format);
+	try
+	{
+		if (a_Format == eFormat::NBT)
+		{
+			if (!NBTToJson(GZipFile::ReadRestOfFile(FileName).GetView(), a_Data))
+			{
+				throw std::runtime_error(fmt::format(FMT_STRING("Cannot parse NBT file \"{}\""), FileName));
+			}
+		}
+		else
+		{
+			InputFileStream(FileName) >> a_Data;
+		}
+	}
+	catch (const Json::Exception & Oops)
+	{
+		// Parse failure:
+		throw std::runtime_error(Oops.what());
+	}
+	catch (const InputFileStream::failure &)
+	{
+		if (errno == ENOENT)
+		{
+			// The file doesn't exist in this format:
+			return false;
+		}
+
+		throw;
+	}
+	return true;
+}
+
+
+
+
+
+const char * cPlayerDataWriter::GetExtension(eFormat a_Format)
+{
+	switch (a_Format)
+	{
+		case eFormat::Json: return ".json";
+		case eFormat::NBT:  return ".nbt";
+	}
+	UNREACHABLE("Unsupported player data format");
+}
+
+
+
+
+
+void cPlayerDataWriter::Execute(void)
+{
+	while (!m_ShouldTerminate)
+	{
+		m_Event.Wait();
+		Flush();
+	}
+}
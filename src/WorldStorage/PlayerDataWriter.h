@@ -0,0 +1,117 @@
+
+// PlayerDataWriter.h
+
+// Declares the cPlayerDataWriter class that writes the player data files on a background thread
+
+
+
+
+
+#pragma once
+
+#include "../OSSupport/IsThread.h"
+#include "json/json.h"
+
+
+
+
+
+/** Writes the player data and statistics files on a background thread, so that saving a player costs the tick thread only the snapshot of the data.
+The data is queued as a JSON tree and serialized on the writer thread, into either a JSON file or a gzipped NBT file.
+Each file is written under a temporary name and then renamed over the old one, so that a crash never leaves a truncated file behind.
+Queueing a file that is still waiting to be written replaces the older snapshot, so each file is written at most once per batch. */
+class cPlayerDataWriter:
+	public cIsThread
+{
+	using Super = cIsThread;
+
+public:
+
+	/** The formats in which the files can be stored. */
+	enum class eFormat
+	{
+		Json,  // Styled JSON text, ".json"
+		NBT,   // Gzipped NBT converted from the JSON tree by JsonToNBT(), ".nbt"
+	};
+
+
+	cPlayerDataWriter(void);
+	virtual ~cPlayerDataWriter() override;
+
+	/** Starts the writer thread; the player data is then stored in the specified format. */
+	void Start(eFormat a_Format);
+
+	/** Returns the format in which the player data is stored. */
+	eFormat GetFormat(void) const { return m_Format; }
+
+	/** Queues the data to be written into the specified file, given without the extension, and wakes up the thread.
+	After the file is written, the file of the same name in the other format is deleted, which migrates the files to the new format. */
+	void Queue(AString && a_FileBaseName, Json::Value && a_Data, eFormat a_Format);
+
+	/** Loads the data of the specified file, given without the extension.
+	Data that hasn't been written yet is returned instead of the file contents; otherwise the file in the configured format is read first, then the other one.
+	Returns false if the file doesn't exist in either format, throws std::runtime_error if it cannot be read or parsed. */
+	bool Load(const AString & a_FileBaseName, Json::Value & a_Data);
+
+	/** Writes all the currently queued files on the caller thread.
+	Serialized with the writer thread. */
+	void Flush(void);
+
+	void Stop(void);
+
+	/** Parses the format name used in settings.ini, case-insensitive. Returns a_Default for unknown names. */
+	static eFormat FormatFromString(const AString & a_Name, eFormat a_Default);
+
+	/** Converts the JSON object into an NBT with the root compound of the same structure.
+	Objects are stored as compounds, arrays as lists, with the numbers in an array unified to a common type.
+	Arrays of mixed values are stored as a list of compounds, each holding the value in a single child with an empty name.
+	Null members are left out, null array items are stored as empty compounds. */
+	static ContiguousByteBuffer JsonToNBT(const Json::Value & a_Object);
+
+	/** Converts the NBT written by JsonToNBT() back into the JSON object.
+	Returns false if the data is not a valid NBT. */
+	static bool NBTToJson(ContiguousByteBufferView a_NBT, Json::Value & a_Object);
+
+protected:
+
+	/** A snapshot of a file's data, waiting to be written. */
+	struct sFileData
+	{
+		Json::Value m_Data;
+		eFormat m_Format;
+	};
+
+
+	/** The format in which the player data is stored. */
+	eFormat m_Format;
+
+	/** Protects m_Queue. */
+	cCriticalSection m_CSQueue;
+
+	/** Held while a file is taken out of the queue and written.
+	Load() holds it as well, so that it never reads a file that is being replaced. */
+	cCriticalSection m_CSWrite;
+
+	/** The files waiting to be written, keyed by the file name without the extension. */
+	std::map<AString, sFileData> m_Queue;
+
+	/** Set when a file is queued, or when the thread should terminate. */
+	cEvent m_Event;
+
+
+	/** Takes the next file out of the queue and writes it. Returns false if the queue was empty. */
+	bool WriteNext(void);
+
+	/** Writes the file, logging any errors. */
+	static void WriteFile(const AString & a_FileBaseName, const sFileData & a_FileData);
+
+	/** Reads the file in the specified format into a_Data.
+	Returns false if the file doesn't exist, throws std::runtime_error if it cannot be read or parsed. */
+	static bool LoadFile(const AString & a_FileBaseName, eFormat a_Format, Json::Value & a_Data);
+
+	/** Returns the file extension used for the format, including the dot. */
+	static const char * GetExtension(eFormat a_Format);
+
+	// cIsThread overrides:
+	virtual void Execute(void) override;
+};
@@ -15,24 +15,6 @@
 
 namespace StatisticsSerializer
 {
-	static auto MakeStatisticsDirectory(const std::string & WorldPath, std::string && FileName)
-	{
-		// Even though stats are shared between worlds, they are (usually) saved
-		// inside the folder of the default world.
-
-		// Path to the world's statistics folder.
-		const auto Path = WorldPath + cFile::GetPathSeparator() + "stats";
-
-		// Ensure that the directory exists.
-		cFile::CreateFolder(Path);
-
-		return Path + cFile::GetPathSeparator() + std::move(FileName) + ".json";
-	}
-
-
-
-
-
 	static void SaveStatToJSON(const StatisticsManager & Manager, Json::Value & a_Out)
 	{
 		if (Manager.Custom.empty())
@@ -189,11 +171,21 @@ namespace StatisticsSerializer
 
 
 
-	void Load(StatisticsManager & Manager, const std::string & WorldPath, std::string && FileName)
+	std::string GetFileBaseName(const std::string & WorldPath, std::string && FileName)
 	{
-		Json::Value Root;
-		InputFileStream(MakeStatisticsDirectory(WorldPath, std::move(FileName))) >> Root;
+		// Even though stats are shared between worlds, they are (usually) saved
+		// inside the folder of the default world.
+
+		// The file is in the world's statistics folder, the folder is created when the file is written.
+		return WorldPath + cFile::GetPathSeparator() + "stats" + cFile::GetPathSeparator() + std::move(FileName);
+	}
 
+
+
+
+
+	void LoadFromJSON(StatisticsManager & Manager, const Json::Value & Root)
+	{
 		LoadLegacyFromJSON(Manager, Root);
 		LoadCustomStatFromJSON(Manager, Root["stats"]["custom"]);
 	}
@@ -202,13 +194,13 @@ namespace StatisticsSerializer
 
 
 
-	void Save(const StatisticsManager & Manager, const std::string & WorldPath, std::string && FileName)
+	Json::Value SaveToJSON(const StatisticsManager & Manager)
 	{
 		Json::Value Root;
 
 		SaveStatToJSON(Manager, Root["stats"]);
 		Root["DataVersion"] = NamespaceSerializer::DataVersion();
 
-		OutputFileStream(MakeStatisticsDirectory(WorldPath, std::move(FileName))) << Root;
+		return Root;
 	}
 }
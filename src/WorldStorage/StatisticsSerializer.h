@@ -22,9 +22,12 @@ namespace Json { class Value; }
 
 namespace StatisticsSerializer
 {
-	/* Try to load the player statistics. */
-	void Load(StatisticsManager & Manager, const std::string & WorldPath, std::string && FileName);
+	/* Returns the path of the player statistics file, without the extension. */
+	std::string GetFileBaseName(const std::string & WorldPath, std::string && FileName);
 
-	/* Try to save the player statistics. */
-	void Save(const StatisticsManager & Manager, const std::string & WorldPath, std::string && FileName);
+	/* Loads the player statistics from the data stored in the statistics file. */
+	void LoadFromJSON(StatisticsManager & Manager, const Json::Value & Root);
+
+	/* Returns the player statistics as the data stored in the statistics file. */
+	Json::Value SaveToJSON(const StatisticsManager & Manager);
 }
@@ -317,13 +317,7 @@ bool cWSSAnvil::LoadChunkFromData(const cChunkCoords & a_Chunk, const Contiguous
 	try
 	{
 		const auto Extracted = m_Extractor.ExtractZLib(a_Data);
-		cParsedNBT NBT(Extracted.GetView());
-
-		if (!NBT.IsValid())
-		{
-			// NBT Parsing failed:
-			throw std::runtime_error(fmt::format("NBT parsing failed. {} at position {}.", NBT.GetErrorCode().message(), NBT.GetErrorPos()));
-		}
+		cNBTStreamReader NBT(Extracted.GetView());
 
 		// Load the data from NBT:
 		return LoadChunkFromNBT(a_Chunk, NBT, a_Data);
@@ -341,7 +335,7 @@ bool cWSSAnvil::LoadChunkFromData(const cChunkCoords & a_Chunk, const Contiguous
 
 Compression::Result cWSSAnvil::SaveChunkToData(const cChunkCoords & a_Chunk)
 {
-	cFastNBTWriter Writer;
+	cFastNBTWriter Writer(m_NBTBuffer);
 	NBTChunkSerializer::Serialize(*m_World, a_Chunk, Writer);
 	Writer.Finish();
 
@@ -352,84 +346,173 @@ Compression::Result cWSSAnvil::SaveChunkToData(const cChunkCoords & a_Chunk)
 
 
 
-bool cWSSAnvil::LoadChunkFromNBT(const cChunkCoords & a_Chunk, const cParsedNBT & a_NBT, const ContiguousByteBufferView a_RawChunkData)
+/** Throws an exception describing the parse error, if the NBT reader has run into one. */
+static void ThrowIfNBTInvalid(const cNBTStreamReader & a_NBT)
+{
+	if (!a_NBT.IsValid())
+	{
+		// NBT Parsing failed:
+		throw std::runtime_error(fmt::format("NBT parsing failed. {} at position {}.", a_NBT.GetErrorCode().message(), a_NBT.GetErrorPos()));
+	}
+}
+
+
+
+
+
+bool cWSSAnvil::LoadChunkFromNBT(const cChunkCoords & a_Chunk, cNBTStreamReader & a_NBT, const ContiguousByteBufferView a_RawChunkData)
 {
 	struct SetChunkData Data(a_Chunk);
 
-	// Load the blockdata, blocklight and skylight:
-	int Level = a_NBT.FindChildByName(0, "Level");
-	if (Level < 0)
+	// The tags are read in the order they are stored in; the entities and block entities are only located and loaded at the end,
+	// since the block entities need the block data:
+	bool HasLevel = false, HasSections = false, HasBiomes = false, HasHeightMap = false;
+	ContiguousByteBufferView EntitiesTag, BlockEntitiesTag;
+	while (a_NBT.NextTag())
+	{
+		if (HasLevel || (a_NBT.GetType() != TAG_Compound) || (a_NBT.GetName() != "Level"))
+		{
+			continue;
+		}
+		HasLevel = true;
+		a_NBT.EnterTag();
+		while (a_NBT.NextTag())
+		{
+			const auto Name = a_NBT.GetName();
+			if ((Name == "Sections") && (a_NBT.GetType() == TAG_List) && !HasSections)
+			{
+				eTagType SectionsType = a_NBT.GetChildrenType();
+				if ((SectionsType != TAG_Compound) && (SectionsType != TAG_End))
+				{
+					ChunkLoadFailed(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, "NBT tag has wrong type: Sections", a_RawChunkData);
+					return false;
+				}
+				HasSections = true;
+
+				// Load the blockdata, blocklight and skylight:
+				a_NBT.EnterTag();
+				while (a_NBT.NextTag())
+				{
+					int Y = -1;
+					const std::byte * BlockData = nullptr;
+					const std::byte * MetaData = nullptr;
+					const std::byte * BlockLightData = nullptr;
+					const std::byte * SkyLightData = nullptr;
+					a_NBT.EnterTag();
+					while (a_NBT.NextTag())
+					{
+						const auto SectionTagName = a_NBT.GetName();
+						if (SectionTagName == "Y")
+						{
+							Y = (a_NBT.GetType() == TAG_Byte) ? a_NBT.GetByte() : -1;
+						}
+						else if (SectionTagName == "Blocks")
+						{
+							BlockData = GetSectionData(a_NBT, ChunkBlockData::SectionBlockCount);
+						}
+						else if (SectionTagName == "Data")
+						{
+							MetaData = GetSectionData(a_NBT, ChunkBlockData::SectionMetaCount);
+						}
+						else if (SectionTagName == "BlockLight")
+						{
+							BlockLightData = GetSectionData(a_NBT, ChunkLightData::SectionLightCount);
+						}
+						else if (SectionTagName == "SkyLight")
+						{
+							SkyLightData = GetSectionData(a_NBT, ChunkLightData::SectionLightCount);
+						}
+					}  // while (section's tags)
+					ThrowIfNBTInvalid(a_NBT);
+
+					if (Y < 0)
+					{
+						ChunkLoadFailed(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, "NBT tag missing or has wrong: Y", a_RawChunkData);
+						return false;
+					}
+					if (Y > static_cast<int>(cChunkDef::NumSections - 1))
+					{
+						ChunkLoadFailed(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, "NBT tag exceeds chunk bounds: Y", a_RawChunkData);
+						return false;
+					}
+
+					if ((BlockData != nullptr) && (MetaData != nullptr) && (SkyLightData != nullptr) && (BlockLightData != nullptr))
+					{
+						Data.BlockData.SetSection(*reinterpret_cast<const ChunkBlockData::SectionType *>(BlockData), *reinterpret_cast<const ChunkBlockData::SectionMetaType *>(MetaData), static_cast<size_t>(Y));
+						Data.LightData.SetSection(*reinterpret_cast<const ChunkLightData::SectionType *>(BlockLightData), *reinterpret_cast<const ChunkLightData::SectionType *>(SkyLightData), static_cast<size_t>(Y));
+					}
+					else
+					{
+						ChunkLoadFailed(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, "Missing chunk block/light data", a_RawChunkData);
+						return false;
+					}
+				}  // while (Sections[])
+			}
+			else if ((Name == "Biomes") && !HasBiomes)
+			{
+				// Load the biomes from NBT, if present and valid:
+				HasBiomes = LoadBiomeMapFromNBT(Data.BiomeMap, a_NBT);
+			}
+			else if ((Name == "HeightMap") && !HasHeightMap)
+			{
+				// Height map too:
+				HasHeightMap = LoadHeightMapFromNBT(Data.HeightMap, a_NBT);
+			}
+			else if ((Name == "Entities") && EntitiesTag.empty() && (a_NBT.GetType() == TAG_List) && (a_NBT.GetCount() > 0))
+			{
+				EntitiesTag = a_NBT.ReadRawTag();
+			}
+			else if ((Name == "TileEntities") && BlockEntitiesTag.empty() && (a_NBT.GetType() == TAG_List) && (a_NBT.GetCount() > 0))
+			{
+				BlockEntitiesTag = a_NBT.ReadRawTag();
+			}
+			else if (Name == "MCSIsLightValid")
+			{
+				Data.IsLightValid = true;
+			}
+		}  // while (Level's tags)
+	}  // while (top-level tags)
+	ThrowIfNBTInvalid(a_NBT);
+
+	if (!HasLevel)
 	{
 		ChunkLoadFailed(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, "Missing NBT tag: Level", a_RawChunkData);
 		return false;
 	}
-
-	int Sections = a_NBT.FindChildByName(Level, "Sections");
-	if ((Sections < 0) || (a_NBT.GetType(Sections) != TAG_List))
+	if (!HasSections)
 	{
 		ChunkLoadFailed(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, "Missing NBT tag: Sections", a_RawChunkData);
 		return false;
 	}
-
-	eTagType SectionsType = a_NBT.GetChildrenType(Sections);
-	if ((SectionsType != TAG_Compound) && (SectionsType != TAG_End))
+	if (!HasBiomes)
 	{
-		ChunkLoadFailed(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, "NBT tag has wrong type: Sections", a_RawChunkData);
+		ChunkLoadFailed(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, "Missing chunk biome data", a_RawChunkData);
 		return false;
 	}
-	for (int Child = a_NBT.GetFirstChild(Sections); Child >= 0; Child = a_NBT.GetNextSibling(Child))
+	if (!HasHeightMap)
 	{
-		const int SectionYTag = a_NBT.FindChildByName(Child, "Y");
-		if ((SectionYTag < 0) || (a_NBT.GetType(SectionYTag) != TAG_Byte))
-		{
-			ChunkLoadFailed(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, "NBT tag missing or has wrong: Y", a_RawChunkData);
-			return false;
-		}
-
-		const int Y = a_NBT.GetByte(SectionYTag);
-		if ((Y < 0) || (Y > static_cast<int>(cChunkDef::NumSections - 1)))
-		{
-			ChunkLoadFailed(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, "NBT tag exceeds chunk bounds: Y", a_RawChunkData);
-			return false;
-		}
+		ChunkLoadFailed(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, "Missing chunk height data", a_RawChunkData);
+		return false;
+	}
 
-		const auto
-			BlockData = GetSectionData(a_NBT, Child, "Blocks", ChunkBlockData::SectionBlockCount),
-			MetaData = GetSectionData(a_NBT, Child, "Data", ChunkBlockData::SectionMetaCount),
-			BlockLightData = GetSectionData(a_NBT, Child, "BlockLight", ChunkLightData::SectionLightCount),
-			SkyLightData = GetSectionData(a_NBT, Child, "SkyLight", ChunkLightData::SectionLightCount);
-		if ((BlockData != nullptr) && (MetaData != nullptr) && (SkyLightData != nullptr) && (BlockLightData != nullptr))
-		{
-			Data.BlockData.SetSection(*reinterpret_cast<const ChunkBlockData::SectionType *>(BlockData), *reinterpret_cast<const ChunkBlockData::SectionMetaType *>(MetaData), static_cast<size_t>(Y));
-			Data.LightData.SetSection(*reinterpret_cast<const ChunkLightData::SectionType *>(BlockLightData), *reinterpret_cast<const ChunkLightData::SectionType *>(SkyLightData), static_cast<size_t>(Y));
-		}
-		else
+	// Load the entities from NBT; their loaders look the tags up by name, so they are parsed into a tag tree, one list at a time:
+	if (!EntitiesTag.empty())
+	{
+		cParsedNBT Entities(EntitiesTag, TAG_List);
+		if (Entities.IsValid())
 		{
-			ChunkLoadFailed(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, "Missing chunk block/light data", a_RawChunkData);
-			return false;
+			LoadEntitiesFromNBT(Data.Entities, Entities, Entities.GetRoot());
 		}
-	}  // for itr - LevelSections[]
-
-	// Load the biomes from NBT, if present and valid:
-	if (!LoadBiomeMapFromNBT(Data.BiomeMap, a_NBT, a_NBT.FindChildByName(Level, "Biomes")))
-	{
-		ChunkLoadFailed(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, "Missing chunk biome data", a_RawChunkData);
-		return false;
 	}
-
-	// Height map too:
-	if (!LoadHeightMapFromNBT(Data.HeightMap, a_NBT, a_NBT.FindChildByName(Level, "HeightMap")))
+	if (!BlockEntitiesTag.empty())
 	{
-		ChunkLoadFailed(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, "Missing chunk height data", a_RawChunkData);
-		return false;
+		cParsedNBT BlockEntities(BlockEntitiesTag, TAG_List);
+		if (BlockEntities.IsValid())
+		{
+			LoadBlockEntitiesFromNBT(Data.BlockEntities, BlockEntities, BlockEntities.GetRoot(), Data.BlockData);
+		}
 	}
 
-	// Load the entities from NBT:
-	LoadEntitiesFromNBT     (Data.Entities,      a_NBT, a_NBT.FindChildByName(Level, "Entities"));
-	LoadBlockEntitiesFromNBT(Data.BlockEntities, a_NBT, a_NBT.FindChildByName(Level, "TileEntities"), Data.BlockData);
-
-	Data.IsLightValid = (a_NBT.FindChildByName(Level, "MCSIsLightValid") > 0);
-
 	/*
 	// Uncomment this block for really cool stuff :)
 	// DEBUG magic: Invert the underground, so that we can see the MC generator in action :)
@@ -474,18 +557,17 @@ bool cWSSAnvil::LoadChunkFromNBT(const cChunkCoords & a_Chunk, const cParsedNBT
 
 
 
-bool cWSSAnvil::LoadBiomeMapFromNBT(cChunkDef::BiomeMap & a_BiomeMap, const cParsedNBT & a_NBT, const int a_TagIdx)
+bool cWSSAnvil::LoadBiomeMapFromNBT(cChunkDef::BiomeMap & a_BiomeMap, const cNBTStreamReader & a_NBT)
 {
 	if (
-		(a_TagIdx < 0) ||
-		(a_NBT.GetType(a_TagIdx) != TAG_ByteArray) ||
-		(a_NBT.GetDataLength(a_TagIdx) != std::size(a_BiomeMap))
+		(a_NBT.GetType() != TAG_ByteArray) ||
+		(a_NBT.GetDataLength() != std::size(a_BiomeMap))
 	)
 	{
 		return false;
 	}
 
-	const auto * const BiomeData = a_NBT.GetData(a_TagIdx);
+	const auto * const BiomeData = a_NBT.GetData();
 	for (size_t i = 0; i < ARRAYCOUNT(a_BiomeMap); i++)
 	{
 		if (BiomeData[i] > std::byte(EMCSBiome::biMaxVariantBiome))
@@ -504,18 +586,17 @@ bool cWSSAnvil::LoadBiomeMapFromNBT(cChunkDef::BiomeMap & a_BiomeMap, const cPar
 
 
 
-bool cWSSAnvil::LoadHeightMapFromNBT(cChunkDef::HeightMap & a_HeightMap, const cParsedNBT & a_NBT, const int a_TagIdx)
+bool cWSSAnvil::LoadHeightMapFromNBT(cChunkDef::HeightMap & a_HeightMap, const cNBTStreamReader & a_NBT)
 {
 	if (
-		(a_TagIdx < 0) ||
-		(a_NBT.GetType(a_TagIdx) != TAG_IntArray) ||
-		(a_NBT.GetDataLength(a_TagIdx) != (4 * std::size(a_HeightMap)))
+		(a_NBT.GetType() != TAG_IntArray) ||
+		(a_NBT.GetDataLength() != (4 * std::size(a_HeightMap)))
 	)
 	{
 		return false;
 	}
 
-	const auto * const HeightData = a_NBT.GetData(a_TagIdx);
+	const auto * const HeightData = a_NBT.GetData();
 	for (int RelZ = 0; RelZ < cChunkDef::Width; RelZ++)
 	{
 		for (int RelX = 0; RelX < cChunkDef::Width; RelX++)
@@ -4015,12 +4096,11 @@ bool cWSSAnvil::cMCAFile::GetChunkData(const cChunkCoords & a_Chunk, ContiguousB
 
 
 
-const std::byte * cWSSAnvil::GetSectionData(const cParsedNBT & a_NBT, int a_Tag, const AString & a_ChildName, size_t a_Length)
+const std::byte * cWSSAnvil::GetSectionData(const cNBTStreamReader & a_NBT, size_t a_Length)
 {
-	int Child = a_NBT.FindChildByName(a_Tag, a_ChildName);
-	if ((Child >= 0) && (a_NBT.GetType(Child) == TAG_ByteArray) && (a_NBT.GetDataLength(Child) == a_Length))
+	if ((a_NBT.GetType() == TAG_ByteArray) && (a_NBT.GetDataLength() == a_Length))
 	{
-		return a_NBT.GetData(Child);
+		return a_NBT.GetData();
 	}
 	return nullptr;
 }
@@ -101,14 +101,17 @@ protected:
 	Compression::Extractor m_Extractor;
 	Compression::Compressor m_Compressor;
 
+	/** The buffer into which the chunks are serialized before compressing, kept so that its memory is reused for all the chunks. */
+	ContiguousByteBuffer m_NBTBuffer;
+
 	/** Reports that the specified chunk failed to load and saves the chunk data to an external file. */
 	void ChunkLoadFailed(int a_ChunkX, int a_ChunkZ, const AString & a_Reason, ContiguousByteBufferView a_ChunkDataToSave);
 
 	/** Gets chunk data from the correct file; locks file CS as needed */
 	bool GetChunkData(const cChunkCoords & a_Chunk, ContiguousByteBuffer & a_Data);
 
-	/** Copies a_Length bytes of data from the specified NBT Tag's Child into the a_Destination buffer */
-	const std::byte * GetSectionData(const cParsedNBT & a_NBT, int a_Tag, const AString & a_ChildName, size_t a_Length);
+	/** Returns the data of the reader's current tag if it is a ByteArray of a_Length bytes, nullptr otherwise. */
+	const std::byte * GetSectionData(const cNBTStreamReader & a_NBT, size_t a_Length);
 
 	/** Sets chunk data into the correct file; locks file CS as needed */
 	bool SetChunkData(const cChunkCoords & a_Chunk, ContiguousByteBufferView a_Data);
@@ -119,15 +122,16 @@ protected:
 	/** Saves the chunk into datastream (no locking needed) */
 	Compression::Result SaveChunkToData(const cChunkCoords & a_Chunk);
 
-	/** Loads the chunk from NBT data (no locking needed).
-	a_RawChunkData is the raw (compressed) chunk data, used for offloading when chunk loading fails. */
-	bool LoadChunkFromNBT(const cChunkCoords & a_Chunk, const cParsedNBT & a_NBT, ContiguousByteBufferView a_RawChunkData);
+	/** Loads the chunk from NBT data, reading through it in a single pass (no locking needed).
+	a_RawChunkData is the raw (compressed) chunk data, used for offloading when chunk loading fails.
+	Throws an exception if the NBT data is malformed. */
+	bool LoadChunkFromNBT(const cChunkCoords & a_Chunk, cNBTStreamReader & a_NBT, ContiguousByteBufferView a_RawChunkData);
 
-	/** Loads the chunk's biome map into a_BiomeMap if biomes present and valid; returns false otherwise. */
-	bool LoadBiomeMapFromNBT(cChunkDef::BiomeMap & a_BiomeMap, const cParsedNBT & a_NBT, int a_TagIdx);
+	/** Loads the chunk's biome map from the reader's current tag into a_BiomeMap if valid; returns false otherwise. */
+	bool LoadBiomeMapFromNBT(cChunkDef::BiomeMap & a_BiomeMap, const cNBTStreamReader & a_NBT);
 
-	/** Loads the chunk's height map into a_HeightMap if heights present and valid; returns false otherwise. */
-	bool LoadHeightMapFromNBT(cChunkDef::HeightMap & a_HeightMap, const cParsedNBT & a_NBT, int a_TagIdx);
+	/** Loads the chunk's height map from the reader's current tag into a_HeightMap if valid; returns false otherwise. */
+	bool LoadHeightMapFromNBT(cChunkDef::HeightMap & a_HeightMap, const cNBTStreamReader & a_NBT);
 
 	/** Loads the chunk's entities from NBT data (a_Tag is the Level\\Entities list tag; may be -1) */
 	void LoadEntitiesFromNBT(cEntityList & a_Entitites, const cParsedNBT & a_NBT, int a_Tag);
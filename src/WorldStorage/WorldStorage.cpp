@@ -12,6 +12,7 @@
 #include "../Generating/ChunkGenerator.h"
 #include "../Entities/Entity.h"
 #include "../BlockEntities/BlockEntity.h"
+#include "../Metrics.h"
 
 
 
@@ -40,7 +41,11 @@ protected:
 cWorldStorage::cWorldStorage(void) :
 	Super("World Storage Executor"),
 	m_World(nullptr),
-	m_SaveSchema(nullptr)
+	m_SaveSchema(nullptr),
+	m_NumLoadedMetric(nullptr),
+	m_NumSavedMetric(nullptr),
+	m_LoadTimeMetric(nullptr),
+	m_SaveTimeMetric(nullptr)
 {
 }
 
@@ -65,6 +70,13 @@ void cWorldStorage::Initialize(cWorld & a_World, const AString & a_StorageSchema
 	m_World = &a_World;
 	m_StorageSchemaName = a_StorageSchemaName;
 	InitSchemas(a_StorageCompressionFactor);
+
+	auto & Metrics = cMetrics::Get();
+	const auto & WorldName = a_World.GetName();
+	m_NumLoadedMetric = &Metrics.GetCounter("cuberite_chunks_loaded_total", "The number of the chunks loaded from the storage", {{"world", WorldName}});
+	m_NumSavedMetric  = &Metrics.GetCounter("cuberite_chunks_saved_total",  "The number of the chunks saved to the storage",    {{"world", WorldName}});
+	m_LoadTimeMetric  = &Metrics.GetHistogram("cuberite_chunk_storage_seconds", "The time taken to load or save a chunk", {{"world", WorldName}, {"operation", "load"}});
+	m_SaveTimeMetric  = &Metrics.GetHistogram("cuberite_chunk_storage_seconds", "The time taken to load or save a chunk", {{"world", WorldName}, {"operation", "save"}});
 }
 
 
@@ -235,7 +247,11 @@ bool cWorldStorage::LoadOneChunk(void)
 	}
 
 	// Load the chunk:
-	LoadChunk(ToLoad.m_ChunkX, ToLoad.m_ChunkZ);
+	cMetricTimer Timer(*m_LoadTimeMetric);
+	if (LoadChunk(ToLoad.m_ChunkX, ToLoad.m_ChunkZ))
+	{
+		m_NumLoadedMetric->Add();
+	}
 
 	return true;
 }
@@ -257,10 +273,12 @@ bool cWorldStorage::SaveOneChunk(void)
 	// Save the chunk, if it's valid:
 	if (m_World->IsChunkValid(ToSave.m_ChunkX, ToSave.m_ChunkZ))
 	{
+		cMetricTimer Timer(*m_SaveTimeMetric);
 		m_World->MarkChunkSaving(ToSave.m_ChunkX, ToSave.m_ChunkZ);
 		if (m_SaveSchema->SaveChunk(cChunkCoords(ToSave.m_ChunkX, ToSave.m_ChunkZ)))
 		{
 			m_World->MarkChunkSaved(ToSave.m_ChunkX, ToSave.m_ChunkZ);
+			m_NumSavedMetric->Add();
 		}
 	}
 
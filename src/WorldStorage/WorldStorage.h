@@ -21,6 +21,8 @@
 
 // fwd:
 class cWorld;
+class cMetricCounter;
+class cMetricHistogram;
 
 
 
@@ -92,6 +94,12 @@ protected:
 	/** Set when there's any addition to the queues */
 	cEvent m_Event;
 
+	/** The number of the chunks loaded and saved, and the time taken by each, in cMetrics. Set in Initialize(). */
+	cMetricCounter * m_NumLoadedMetric;
+	cMetricCounter * m_NumSavedMetric;
+	cMetricHistogram * m_LoadTimeMetric;
+	cMetricHistogram * m_SaveTimeMetric;
+
 
 	/** Loads the chunk specified; returns true on success, false on failure */
 	bool LoadChunk(int a_ChunkX, int a_ChunkZ);
@@ -22,6 +22,9 @@ bool g_ShouldLogCommIn;
 bool g_ShouldLogCommOut;
 bool g_RunAsService;
 
+/** The number of the network event loop threads, 0 for one per CPU core. */
+static unsigned g_NumNetworkThreads = 0;
+
 
 
 
@@ -36,6 +39,7 @@ static void ParseArguments(int argc, char ** argv, cMemorySettingsRepository & a
 	TCLAP::ValueArg<int> slotsArg    ("s", "max-players",         "Maximum number of slots for the server to use, overrides setting in setting.ini", false, -1, "number", cmd);
 	TCLAP::ValueArg<AString> confArg ("c", "config-file",         "Config file to use", false, "settings.ini", "string", cmd);
 	TCLAP::MultiArg<int> portsArg    ("p", "port",                "The port number the server should listen to", false, "port", cmd);
+	TCLAP::ValueArg<int> netThreadsArg("",  "network-threads",     "Number of threads serving the network connections, 0 for one per CPU core", false, 0, "number", cmd);
 	TCLAP::SwitchArg commLogArg      ("",  "log-comm",            "Log server client communications to file", cmd);
 	TCLAP::SwitchArg commLogInArg    ("",  "log-comm-in",         "Log inbound server client communications to file", cmd);
 	TCLAP::SwitchArg commLogOutArg   ("",  "log-comm-out",        "Log outbound server client communications to file", cmd);
@@ -64,6 +68,10 @@ static void ParseArguments(int argc, char ** argv, cMemorySettingsRepository & a
 			a_Settings.AddValue("Server", "Ports", std::to_string(port));
 		}
 	}
+	if (netThreadsArg.isSet())
+	{
+		g_NumNetworkThreads = static_cast<unsigned>(std::max(netThreadsArg.getValue(), 0));
+	}
 	if (noFileLogArg.getValue())
 	{
 		a_Settings.AddValue("Server", "DisableLogFile", true);
@@ -165,7 +173,7 @@ static int UniversalMain(int argc, char * argv[], const bool a_RunningAsService)
 				NetworkRAII()
 				{
 					// Initialize LibEvent:
-					cNetworkSingleton::Get().Initialise();
+					cNetworkSingleton::Get().Initialise(g_NumNetworkThreads);
 				}
 
 				~NetworkRAII()
@@ -0,0 +1,142 @@
+// BlockAreaBenchmark.cpp
+
+// Measures the throughput of the bulk cBlockArea operations on a 10M-block area
+
+#include "Globals.h"
+#include "BlockArea.h"
+#include "BlockAreaWriter.h"
+#include "PatternChunkProvider.h"
+
+
+
+
+
+/** The size of the benchmarked area, about 10M blocks. */
+static const Vector3i AREA_SIZE(256, 160, 256);
+
+
+
+
+
+/** Discards the written pieces, so that the stepped write measures only the splitting of the area into them. */
+class cDiscardingProvider:
+	public cForEachChunkProvider
+{
+public:
+	virtual bool ForEachChunkInRect(int aMinChunkX, int aMaxChunkX, int aMinChunkZ, int aMaxChunkZ, cChunkDataCallback & aCallback) override
+	{
+		return false;
+	}
+
+	virtual bool WriteBlockArea(cBlockArea & aArea, int aMinBlockX, int aMinBlockY, int aMinBlockZ, int aDataTypes) override
+	{
+		return true;
+	}
+};
+
+
+
+
+
+/** Measures the specified operation and logs its throughput. */
+template <typename Fn>
+static void measure(const char * aName, Fn aFn)
+{
+	auto start = std::chrono::steady_clock::now();
+	aFn();
+	auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	auto numBlocks = static_cast<double>(AREA_SIZE.x) * AREA_SIZE.y * AREA_SIZE.z;
+	LOG("%-16s %8.1f ms, %7.1f Mblocks / s", aName, ms, numBlocks / ms / 1000);
+}
+
+
+
+
+
+int main()
+{
+	LOG("BlockArea benchmark started, %u hardware threads", std::thread::hardware_concurrency());
+
+	cPatternChunkProvider provider(0, AREA_SIZE.x / cChunkDef::Width, 0, AREA_SIZE.z / cChunkDef::Width);
+	cBlockArea area;
+	measure("Read", [&]()
+		{
+			area.Read(provider, 8, 8 + AREA_SIZE.x - 1, 10, 10 + AREA_SIZE.y - 1, 8, 8 + AREA_SIZE.z - 1, cBlockArea::baTypes | cBlockArea::baMetas);
+		}
+	);
+
+	cBlockArea other;
+	other.Create(AREA_SIZE, cBlockArea::baTypes | cBlockArea::baMetas);
+	other.Merge(area, 0, 0, 0, cBlockArea::msOverwrite);
+	measure("Merge Imprint", [&]()
+		{
+			area.Merge(other, 0, 0, 0, cBlockArea::msImprint);
+		}
+	);
+	measure("Merge FillAir", [&]()
+		{
+			area.Merge(other, 0, 0, 0, cBlockArea::msFillAir);
+		}
+	);
+	measure("Merge Lake", [&]()
+		{
+			area.Merge(other, 0, 0, 0, cBlockArea::msLake);
+		}
+	);
+	measure("Merge Mask", [&]()
+		{
+			area.Merge(other, 0, 0, 0, cBlockArea::msMask);
+		}
+	);
+	measure("RotateCW", [&]()
+		{
+			area.RotateCW();
+		}
+	);
+	measure("RotateCCWNoMeta", [&]()
+		{
+			area.RotateCCWNoMeta();
+		}
+	);
+	measure("MirrorXY", [&]()
+		{
+			area.MirrorXY();
+		}
+	);
+	measure("MirrorYZ", [&]()
+		{
+			area.MirrorYZ();
+		}
+	);
+	measure("MirrorYZNoMeta", [&]()
+		{
+			area.MirrorYZNoMeta();
+		}
+	);
+
+	// The stepped write, split into the per-tick batches; the longest batch is what a single tick pays:
+	auto shared = std::make_shared<cBlockArea>();
+	area.CopyTo(*shared);
+	std::chrono::steady_clock::duration longestBatch{};
+	size_t numBatches = 0;
+	measure("WriteInSteps", [&]()
+		{
+			cDiscardingProvider provider;
+			cBlockAreaWriter writer(shared, {8, 10, 8}, cBlockArea::baTypes | cBlockArea::baMetas);
+			bool isFinished = false;
+			while (!isFinished)
+			{
+				auto start = std::chrono::steady_clock::now();
+				isFinished = writer.WriteSteps(provider, cBlockAreaWriter::BLOCKS_PER_TICK);
+				longestBatch = std::max(longestBatch, std::chrono::steady_clock::now() - start);
+				numBatches += 1;
+			}
+		}
+	);
+	LOG("WriteInSteps: %u ticks, the longest batch took %.3f ms",
+		static_cast<unsigned>(numBatches), std::chrono::duration<double, std::milli>(longestBatch).count()
+	);
+
+	LOG("BlockArea benchmark finished");
+	return 0;
+}
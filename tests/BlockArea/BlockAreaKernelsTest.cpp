@@ -0,0 +1,341 @@
+// BlockAreaKernelsTest.cpp
+
+// Tests that the row-wise merging, rotating and mirroring of cBlockArea give exactly the same results as the per-block rules
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "BlockArea.h"
+#include "Blocks/BlockHandler.h"
+
+
+
+
+
+/** The block types used for filling the areas, so that all the special cases of the merge strategies get hit.
+The odd types have their metas transformed by the stub block handler. */
+static const BLOCKTYPE g_Palette[] =
+{
+	E_BLOCK_AIR, E_BLOCK_AIR, E_BLOCK_AIR, E_BLOCK_STONE, E_BLOCK_GRASS, E_BLOCK_DIRT, E_BLOCK_MYCELIUM, E_BLOCK_SPONGE,
+	E_BLOCK_WATER, E_BLOCK_STATIONARY_WATER, E_BLOCK_LAVA, E_BLOCK_STATIONARY_LAVA, E_BLOCK_PLANKS, E_BLOCK_LOG, E_BLOCK_SAND,
+};
+
+
+
+
+
+/** Creates an area of the specified size and datatypes, filled with a pattern derived from the relative coords and the seed. */
+static std::unique_ptr<cBlockArea> createArea(Vector3i aSize, int aDataTypes, int aSeed)
+{
+	auto area = std::make_unique<cBlockArea>();
+	area->Create(aSize, aDataTypes);
+	for (int y = 0; y < aSize.y; y++) for (int z = 0; z < aSize.z; z++) for (int x = 0; x < aSize.x; x++)
+	{
+		auto hash = static_cast<unsigned>((x * 31 + y * 17 + z * 7 + aSeed) * 2654435761U);
+		auto type = g_Palette[(hash >> 8) % ARRAYCOUNT(g_Palette)];
+		if ((aDataTypes & cBlockArea::baMetas) != 0)
+		{
+			area->SetRelBlockTypeMeta(x, y, z, type, static_cast<NIBBLETYPE>((hash >> 20) % 3));
+		}
+		else
+		{
+			area->SetRelBlockType(x, y, z, type);
+		}
+	}
+	return area;
+}
+
+
+
+
+
+/** Returns true if the two areas have the same size and exactly the same blocktypes and blockmetas. */
+static bool isSameArea(const cBlockArea & aArea1, const cBlockArea & aArea2)
+{
+	if ((aArea1.GetSize() != aArea2.GetSize()) || (aArea1.GetDataTypes() != aArea2.GetDataTypes()))
+	{
+		return false;
+	}
+	auto count = aArea1.GetBlockCount();
+	if (!std::equal(aArea1.GetBlockTypes(), aArea1.GetBlockTypes() + count, aArea2.GetBlockTypes()))
+	{
+		return false;
+	}
+	if (aArea1.HasBlockMetas() && !std::equal(aArea1.GetBlockMetas(), aArea1.GetBlockMetas() + count, aArea2.GetBlockMetas()))
+	{
+		return false;
+	}
+	return true;
+}
+
+
+
+
+
+/** Combines a single block the way the merge strategies are documented to. */
+static void referenceCombine(cBlockArea::eMergeStrategy aStrategy, bool aMetasValid, BLOCKTYPE & aDstType, BLOCKTYPE aSrcType, NIBBLETYPE & aDstMeta, NIBBLETYPE aSrcMeta)
+{
+	const auto overwrite = [&](BLOCKTYPE aType, NIBBLETYPE aMeta)
+	{
+		aDstType = aType;
+		if (aMetasValid)
+		{
+			aDstMeta = aMeta;
+		}
+	};
+	const auto isLiquid = [](BLOCKTYPE aType)
+	{
+		return (
+			(aType == E_BLOCK_WATER) || (aType == E_BLOCK_STATIONARY_WATER) ||
+			(aType == E_BLOCK_LAVA) || (aType == E_BLOCK_STATIONARY_LAVA)
+		);
+	};
+	bool isSame = (aDstType == aSrcType) && (!aMetasValid || (aDstMeta == aSrcMeta));
+	switch (aStrategy)
+	{
+		case cBlockArea::msOverwrite:   overwrite(aSrcType, aSrcMeta); return;
+		case cBlockArea::msFillAir:     if (aDstType == E_BLOCK_AIR)    { overwrite(aSrcType, aSrcMeta); } return;
+		case cBlockArea::msImprint:     if (aSrcType != E_BLOCK_AIR)    { overwrite(aSrcType, aSrcMeta); } return;
+		case cBlockArea::msSpongePrint: if (aSrcType != E_BLOCK_SPONGE) { overwrite(aSrcType, aSrcMeta); } return;
+		case cBlockArea::msDifference:
+		{
+			if (isSame)
+			{
+				overwrite(E_BLOCK_AIR, 0);
+			}
+			else
+			{
+				overwrite(aSrcType, aSrcMeta);
+			}
+			return;
+		}
+		case cBlockArea::msSimpleCompare:
+		{
+			aDstType = isSame ? E_BLOCK_AIR : E_BLOCK_STONE;
+			return;
+		}
+		case cBlockArea::msMask:
+		{
+			if (!aMetasValid || !isSame)
+			{
+				overwrite(E_BLOCK_AIR, 0);
+			}
+			return;
+		}
+		case cBlockArea::msLake:
+		{
+			if (aSrcType == E_BLOCK_SPONGE)
+			{
+				return;
+			}
+			if (aSrcType == E_BLOCK_AIR)
+			{
+				overwrite(E_BLOCK_AIR, 0);
+				return;
+			}
+			if (isLiquid(aDstType))
+			{
+				return;
+			}
+			if (isLiquid(aSrcType))
+			{
+				overwrite(aSrcType, aSrcMeta);
+				return;
+			}
+			if ((aSrcType == E_BLOCK_STONE) && ((aDstType == E_BLOCK_DIRT) || (aDstType == E_BLOCK_GRASS) || (aDstType == E_BLOCK_MYCELIUM)))
+			{
+				overwrite(E_BLOCK_STONE, 0);
+			}
+			return;
+		}
+	}
+}
+
+
+
+
+
+/** Merges the areas block by block, in the YZX order.
+aDst and aSrc may be the same object, the blocks already merged are then used as the source for the later ones. */
+static void referenceMerge(cBlockArea & aDst, const cBlockArea & aSrc, Vector3i aRelPos, cBlockArea::eMergeStrategy aStrategy)
+{
+	bool metasValid = aDst.HasBlockMetas() && aSrc.HasBlockMetas();
+	for (int y = 0; y < aDst.GetSizeY(); y++) for (int z = 0; z < aDst.GetSizeZ(); z++) for (int x = 0; x < aDst.GetSizeX(); x++)
+	{
+		auto srcPos = Vector3i(x, y, z) - aRelPos;
+		if (!aSrc.IsValidRelCoords(srcPos))
+		{
+			continue;
+		}
+		BLOCKTYPE dstType = aDst.GetRelBlockType(x, y, z);
+		NIBBLETYPE dstMeta = metasValid ? aDst.GetRelBlockMeta(x, y, z) : 0;
+		BLOCKTYPE srcType = aSrc.GetRelBlockType(srcPos.x, srcPos.y, srcPos.z);
+		NIBBLETYPE srcMeta = metasValid ? aSrc.GetRelBlockMeta(srcPos.x, srcPos.y, srcPos.z) : 0;
+		referenceCombine(aStrategy, metasValid, dstType, srcType, dstMeta, srcMeta);
+		aDst.SetRelBlockType(x, y, z, dstType);
+		if (metasValid)
+		{
+			aDst.SetRelBlockMeta(x, y, z, dstMeta);
+		}
+	}
+}
+
+
+
+
+
+/** Tests all the merge strategies, with and without metas, for various sizes and offsets, against the per-block rules. */
+static void testMerge()
+{
+	static const cBlockArea::eMergeStrategy strategies[] =
+	{
+		cBlockArea::msOverwrite, cBlockArea::msFillAir, cBlockArea::msImprint, cBlockArea::msLake,
+		cBlockArea::msSpongePrint, cBlockArea::msDifference, cBlockArea::msSimpleCompare, cBlockArea::msMask,
+	};
+	static const Vector3i relPositions[] =
+	{
+		{0, 0, 0}, {3, 1, 2}, {-5, -1, -7}, {17, 2, -3}, {-1, 0, 40},
+	};
+	for (auto dstTypes: {static_cast<int>(cBlockArea::baTypes), cBlockArea::baTypes | cBlockArea::baMetas})
+	{
+		for (auto srcTypes: {static_cast<int>(cBlockArea::baTypes), cBlockArea::baTypes | cBlockArea::baMetas})
+		{
+			auto src = createArea({37, 5, 29}, srcTypes, 1);
+			auto orig = createArea({45, 7, 51}, dstTypes, 2);
+			for (auto strategy: strategies)
+			{
+				for (const auto & relPos: relPositions)
+				{
+					cBlockArea actual, expected;
+					actual.CopyFrom(*orig);
+					expected.CopyFrom(*orig);
+					actual.Merge(*src, relPos, strategy);
+					referenceMerge(expected, *src, relPos, strategy);
+					bool isSame = isSameArea(actual, expected);
+					TEST_TRUE(isSame);
+				}
+			}
+		}
+	}
+}
+
+
+
+
+
+/** Tests merging an area into itself, where the source and destination rows overlap. */
+static void testSelfMerge()
+{
+	for (auto strategy: {cBlockArea::msOverwrite, cBlockArea::msImprint, cBlockArea::msDifference})
+	{
+		for (const auto & relPos: {Vector3i(1, 0, 0), Vector3i(-3, 0, 0), Vector3i(5, 1, 0), Vector3i(0, 0, 0)})
+		{
+			auto actual = createArea({70, 4, 6}, cBlockArea::baTypes | cBlockArea::baMetas, 3);
+			cBlockArea expected;
+			expected.CopyFrom(*actual);
+			actual->Merge(*actual, relPos, strategy);
+			referenceMerge(expected, expected, relPos, strategy);
+			bool isSame = isSameArea(*actual, expected);
+			TEST_TRUE(isSame);
+		}
+	}
+}
+
+
+
+
+
+/** Returns the area rotated or mirrored block by block.
+aNewPos maps the relative coords in aOrig to the relative coords in the result, aMetaFn transforms the metas (or is nullptr). */
+template <typename NewPosFn>
+static std::unique_ptr<cBlockArea> referenceTransform(const cBlockArea & aOrig, Vector3i aNewSize, NewPosFn aNewPos, NIBBLETYPE (cBlockHandler::*aMetaFn)(NIBBLETYPE) const)
+{
+	auto res = std::make_unique<cBlockArea>();
+	res->Create(aNewSize, aOrig.GetDataTypes());
+	for (int y = 0; y < aOrig.GetSizeY(); y++) for (int z = 0; z < aOrig.GetSizeZ(); z++) for (int x = 0; x < aOrig.GetSizeX(); x++)
+	{
+		auto newPos = aNewPos(x, y, z);
+		auto type = aOrig.GetRelBlockType(x, y, z);
+		res->SetRelBlockType(newPos.x, newPos.y, newPos.z, type);
+		if (aOrig.HasBlockMetas())
+		{
+			auto meta = aOrig.GetRelBlockMeta(x, y, z);
+			res->SetRelBlockMeta(newPos.x, newPos.y, newPos.z, (aMetaFn == nullptr) ? meta : (cBlockHandler::For(type).*aMetaFn)(meta));
+		}
+	}
+	return res;
+}
+
+
+
+
+
+/** Tests the rotations and mirrors, with and without metas, against their per-block definitions. */
+static void testRotateMirror()
+{
+	// Sizes that are not multiples of the tile size, are odd (the middle plane when mirroring) or degenerate:
+	static const Vector3i sizes[] =
+	{
+		{1, 1, 1}, {2, 3, 1}, {17, 5, 33}, {64, 2, 32}, {33, 3, 70}, {100, 1, 3},
+	};
+	for (const auto & size: sizes)
+	{
+		for (auto dataTypes: {static_cast<int>(cBlockArea::baTypes), cBlockArea::baTypes | cBlockArea::baMetas})
+		{
+			auto orig = createArea(size, dataTypes, size.x + size.z);
+			const Vector3i rotatedSize(size.z, size.y, size.x);
+			const auto rotCW  = [&](int x, int y, int z) { return Vector3i(size.z - z - 1, y, x); };
+			const auto rotCCW = [&](int x, int y, int z) { return Vector3i(z, y, size.x - x - 1); };
+			struct
+			{
+				void (cBlockArea::*m_Fn)(void);
+				Vector3i m_NewSize;
+				std::function<Vector3i(int, int, int)> m_NewPos;
+				NIBBLETYPE (cBlockHandler::*m_MetaFn)(NIBBLETYPE) const;
+				bool m_IsMirror;
+			} transforms[] =
+			{
+				{&cBlockArea::RotateCW,        rotatedSize, rotCW,  &cBlockHandler::MetaRotateCW, false},
+				{&cBlockArea::RotateCCW,       rotatedSize, rotCCW, &cBlockHandler::MetaRotateCCW, false},
+				{&cBlockArea::RotateCWNoMeta,  rotatedSize, rotCW,  nullptr, false},
+				{&cBlockArea::RotateCCWNoMeta, rotatedSize, rotCCW, nullptr, false},
+				{&cBlockArea::MirrorXY,        size, [&](int x, int y, int z) { return Vector3i(x, y, size.z - z - 1); }, &cBlockHandler::MetaMirrorXY, true},
+				{&cBlockArea::MirrorXZ,        size, [&](int x, int y, int z) { return Vector3i(x, size.y - y - 1, z); }, &cBlockHandler::MetaMirrorXZ, true},
+				{&cBlockArea::MirrorYZ,        size, [&](int x, int y, int z) { return Vector3i(size.x - x - 1, y, z); }, &cBlockHandler::MetaMirrorYZ, true},
+				{&cBlockArea::MirrorXYNoMeta,  size, [&](int x, int y, int z) { return Vector3i(x, y, size.z - z - 1); }, nullptr, true},
+				{&cBlockArea::MirrorXZNoMeta,  size, [&](int x, int y, int z) { return Vector3i(x, size.y - y - 1, z); }, nullptr, true},
+				{&cBlockArea::MirrorYZNoMeta,  size, [&](int x, int y, int z) { return Vector3i(size.x - x - 1, y, z); }, nullptr, true},
+			};
+			for (const auto & transform: transforms)
+			{
+				cBlockArea actual;
+				actual.CopyFrom(*orig);
+				(actual.*transform.m_Fn)();
+				auto expected = referenceTransform(*orig, transform.m_NewSize, transform.m_NewPos, transform.m_MetaFn);
+
+				// The mirrors have always left the metas of the middle plane of an odd-sized area untransformed:
+				if (transform.m_IsMirror && (transform.m_MetaFn != nullptr) && orig->HasBlockMetas())
+				{
+					for (int y = 0; y < size.y; y++) for (int z = 0; z < size.z; z++) for (int x = 0; x < size.x; x++)
+					{
+						if (transform.m_NewPos(x, y, z) == Vector3i(x, y, z))
+						{
+							expected->SetRelBlockMeta(x, y, z, orig->GetRelBlockMeta(x, y, z));
+						}
+					}
+				}
+				bool isSame = isSameArea(actual, *expected);
+				TEST_TRUE(isSame);
+			}
+		}
+	}
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("BlockAreaKernels",
+	testMerge();
+	testSelfMerge();
+	testRotateMirror();
+)
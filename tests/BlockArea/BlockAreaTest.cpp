@@ -0,0 +1,261 @@
+// BlockAreaTest.cpp
+
+// Tests the bulk cBlockArea operations on areas large enough to be processed in parallel
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "BlockArea.h"
+#include "BlockAreaWriter.h"
+#include "PatternChunkProvider.h"
+
+
+
+
+
+/** Fills the area with a pattern derived from the relative coords and the specified seed. */
+static void fillPattern(cBlockArea & aArea, int aSeed)
+{
+	const auto & size = aArea.GetSize();
+	for (int y = 0; y < size.y; y++) for (int z = 0; z < size.z; z++) for (int x = 0; x < size.x; x++)
+	{
+		auto hash = static_cast<unsigned>((x * 31 + y * 17 + z * 7 + aSeed) * 2654435761U);
+		auto type = ((hash >> 8) % 3 == 0) ? E_BLOCK_AIR : static_cast<BLOCKTYPE>(hash >> 16);
+		aArea.SetRelBlockTypeMeta(x, y, z, type, static_cast<NIBBLETYPE>((hash >> 4) & 0x0f));
+	}
+}
+
+
+
+
+
+/** Tests that reading an area gives the data of the chunks, for an area spanning several chunks with unaligned borders. */
+static void testRead()
+{
+	cPatternChunkProvider provider(-4, 4, -4, 4);
+	cBlockArea area;
+	TEST_TRUE(area.Read(provider, -50, 57, 10, 109, -40, 63, cBlockArea::baTypes | cBlockArea::baMetas | cBlockArea::baSkyLight));
+	TEST_EQUAL(area.GetSize(), Vector3i(108, 100, 104));
+	for (int y = 10; y <= 109; y++) for (int z = -40; z <= 63; z++) for (int x = -50; x <= 57; x++)
+	{
+		TEST_EQUAL(area.GetBlockType(x, y, z), cPatternChunkProvider::patternType(x, y, z));
+		TEST_EQUAL(area.GetBlockMeta(x, y, z), cPatternChunkProvider::patternMeta(x, y, z));
+		TEST_EQUAL(area.GetBlockSkyLight(x, y, z), 0x0f);
+	}
+
+	// Reading outside the provided chunks fails:
+	TEST_FALSE(area.Read(provider, 0, 100, 0, 10, 0, 10));
+}
+
+
+
+
+
+/** Tests merging a large area, compared to the per-block merging rules. */
+static void testMerge()
+{
+	cBlockArea src, orig;
+	src.Create(120, 70, 110);
+	orig.Create(130, 80, 120);
+	fillPattern(src, 1);
+	fillPattern(orig, 2);
+	const Vector3i ofs(5, 6, 7);
+
+	for (auto strategy: {cBlockArea::msOverwrite, cBlockArea::msImprint, cBlockArea::msFillAir})
+	{
+		cBlockArea dst;
+		dst.CopyFrom(orig);
+		dst.Merge(src, ofs, strategy);
+		for (int y = 0; y < orig.GetSizeY(); y++) for (int z = 0; z < orig.GetSizeZ(); z++) for (int x = 0; x < orig.GetSizeX(); x++)
+		{
+			BLOCKTYPE expectedType = orig.GetRelBlockType(x, y, z);
+			NIBBLETYPE expectedMeta = orig.GetRelBlockMeta(x, y, z);
+			Vector3i srcPos = Vector3i(x, y, z) - ofs;
+			if (src.IsValidRelCoords(srcPos))
+			{
+				BLOCKTYPE srcType = src.GetRelBlockType(srcPos.x, srcPos.y, srcPos.z);
+				NIBBLETYPE srcMeta = src.GetRelBlockMeta(srcPos.x, srcPos.y, srcPos.z);
+				if (
+					(strategy == cBlockArea::msOverwrite) ||
+					((strategy == cBlockArea::msImprint) && (srcType != E_BLOCK_AIR)) ||
+					((strategy == cBlockArea::msFillAir) && (expectedType == E_BLOCK_AIR))
+				)
+				{
+					expectedType = srcType;
+					expectedMeta = srcMeta;
+				}
+			}
+			TEST_EQUAL(dst.GetRelBlockType(x, y, z), expectedType);
+			TEST_EQUAL(dst.GetRelBlockMeta(x, y, z), expectedMeta);
+		}
+	}
+}
+
+
+
+
+
+/** Tests merging a large area into itself, where the merged slabs overlap.
+The result must be the same as when merging serially, block by block, in the area's order. */
+static void testSelfMerge()
+{
+	for (const auto & ofs: {Vector3i(2, 1, 3), Vector3i(-1, -2, 0)})
+	{
+		cBlockArea area, expected;
+		area.Create(130, 80, 120);
+		fillPattern(area, 3);
+		expected.CopyFrom(area);
+
+		area.Merge(area, ofs, cBlockArea::msImprint);
+
+		const auto & size = expected.GetSize();
+		for (int y = 0; y < size.y; y++) for (int z = 0; z < size.z; z++) for (int x = 0; x < size.x; x++)
+		{
+			Vector3i dstPos = Vector3i(x, y, z) + ofs;
+			if (!expected.IsValidRelCoords(dstPos) || (expected.GetRelBlockType(x, y, z) == E_BLOCK_AIR))
+			{
+				continue;
+			}
+			expected.SetRelBlockTypeMeta(dstPos.x, dstPos.y, dstPos.z, expected.GetRelBlockType(x, y, z), expected.GetRelBlockMeta(x, y, z));
+		}
+		for (int y = 0; y < size.y; y++) for (int z = 0; z < size.z; z++) for (int x = 0; x < size.x; x++)
+		{
+			TEST_EQUAL(area.GetRelBlockType(x, y, z), expected.GetRelBlockType(x, y, z));
+			TEST_EQUAL(area.GetRelBlockMeta(x, y, z), expected.GetRelBlockMeta(x, y, z));
+		}
+	}
+}
+
+
+
+
+
+/** Tests rotating a large area, both with and without metas. */
+static void testRotate()
+{
+	cBlockArea orig;
+	orig.Create(150, 60, 130);
+	fillPattern(orig, 3);
+
+	cBlockArea area;
+	area.CopyFrom(orig);
+	area.RotateCW();
+	TEST_EQUAL(area.GetSize(), Vector3i(130, 60, 150));
+	for (int y = 0; y < orig.GetSizeY(); y++) for (int z = 0; z < orig.GetSizeZ(); z++) for (int x = 0; x < orig.GetSizeX(); x++)
+	{
+		TEST_EQUAL(area.GetRelBlockType(orig.GetSizeZ() - z - 1, y, x), orig.GetRelBlockType(x, y, z));
+	}
+	area.RotateCCW();
+	for (int y = 0; y < orig.GetSizeY(); y++) for (int z = 0; z < orig.GetSizeZ(); z++) for (int x = 0; x < orig.GetSizeX(); x++)
+	{
+		TEST_EQUAL(area.GetRelBlockType(x, y, z), orig.GetRelBlockType(x, y, z));
+		TEST_EQUAL(area.GetRelBlockMeta(x, y, z), orig.GetRelBlockMeta(x, y, z));
+	}
+
+	area.RotateCCWNoMeta();
+	for (int y = 0; y < orig.GetSizeY(); y++) for (int z = 0; z < orig.GetSizeZ(); z++) for (int x = 0; x < orig.GetSizeX(); x++)
+	{
+		TEST_EQUAL(area.GetRelBlockType(z, y, orig.GetSizeX() - x - 1), orig.GetRelBlockType(x, y, z));
+		TEST_EQUAL(area.GetRelBlockMeta(z, y, orig.GetSizeX() - x - 1), orig.GetRelBlockMeta(x, y, z));
+	}
+	area.RotateCWNoMeta();
+	for (int y = 0; y < orig.GetSizeY(); y++) for (int z = 0; z < orig.GetSizeZ(); z++) for (int x = 0; x < orig.GetSizeX(); x++)
+	{
+		TEST_EQUAL(area.GetRelBlockType(x, y, z), orig.GetRelBlockType(x, y, z));
+		TEST_EQUAL(area.GetRelBlockMeta(x, y, z), orig.GetRelBlockMeta(x, y, z));
+	}
+}
+
+
+
+
+
+/** Records the pieces written by a cBlockAreaWriter into a single area, checking that each piece lies within a single chunk section. */
+class cRecordingProvider:
+	public cForEachChunkProvider
+{
+public:
+
+	cRecordingProvider(Vector3i aOrigin, Vector3i aSize)
+	{
+		mWorld.Create(aSize, cBlockArea::baTypes | cBlockArea::baMetas);
+		mWorld.SetOrigin(aOrigin);
+	}
+
+	/** The area into which the pieces are written, in the world coords. */
+	cBlockArea mWorld;
+
+	/** The number of blocks written since the last reset. */
+	size_t mNumBlocks = 0;
+
+	// cForEachChunkProvider overrides:
+	virtual bool ForEachChunkInRect(int aMinChunkX, int aMaxChunkX, int aMinChunkZ, int aMaxChunkZ, cChunkDataCallback & aCallback) override
+	{
+		return false;
+	}
+
+	virtual bool WriteBlockArea(cBlockArea & aArea, int aMinBlockX, int aMinBlockY, int aMinBlockZ, int aDataTypes) override
+	{
+		const Vector3i min(aMinBlockX, aMinBlockY, aMinBlockZ);
+		const auto max = min + aArea.GetSize() - Vector3i(1, 1, 1);
+		TEST_TRUE((cChunkDef::BlockToChunk(min) == cChunkDef::BlockToChunk(max)));
+		TEST_EQUAL(min.y / cChunkDef::SectionHeight, max.y / cChunkDef::SectionHeight);
+		TEST_EQUAL(aDataTypes, (cBlockArea::baTypes | cBlockArea::baMetas));
+		mWorld.Merge(aArea, min - mWorld.GetOrigin(), cBlockArea::msOverwrite);
+		mNumBlocks += static_cast<size_t>(aArea.GetVolume());
+		return true;
+	}
+};
+
+
+
+
+
+/** Tests writing an area in bounded steps, each within a single chunk section, for an area with unaligned borders. */
+static void testWriteInSteps()
+{
+	auto area = std::make_shared<cBlockArea>();
+	area->Create(40, 37, 35, cBlockArea::baTypes | cBlockArea::baMetas);
+	fillPattern(*area, 7);
+	const Vector3i minCoords(-20, 5, -9);
+	cRecordingProvider provider(minCoords, area->GetSize());
+
+	// The area is split at X = -16, 0, 16; Y = 16, 32; Z = 0, 16:
+	cBlockAreaWriter writer(area, minCoords, cBlockArea::baTypes | cBlockArea::baMetas);
+	TEST_EQUAL(writer.GetNumSteps(), 4U * 3U * 3U);
+
+	// Each call writes at least the requested number of blocks, and at most one section's worth more:
+	const size_t maxBlocks = 5000;
+	const auto volume = static_cast<size_t>(area->GetVolume());
+	size_t numWritten = 0;
+	while (!writer.WriteSteps(provider, maxBlocks))
+	{
+		TEST_GREATER_THAN_OR_EQUAL(provider.mNumBlocks, maxBlocks);
+		TEST_LESS_THAN_OR_EQUAL(provider.mNumBlocks, maxBlocks + cChunkDef::SectionHeight * cChunkDef::Width * cChunkDef::Width);
+		numWritten += provider.mNumBlocks;
+		provider.mNumBlocks = 0;
+	}
+	numWritten += provider.mNumBlocks;
+	TEST_EQUAL(numWritten, volume);
+	TEST_TRUE(writer.IsFinished());
+	TEST_TRUE(writer.IsSuccessful());
+
+	// The pieces add up to the whole area:
+	const auto & size = area->GetSize();
+	for (int y = 0; y < size.y; y++) for (int z = 0; z < size.z; z++) for (int x = 0; x < size.x; x++)
+	{
+		TEST_EQUAL(provider.mWorld.GetRelBlockType(x, y, z), area->GetRelBlockType(x, y, z));
+		TEST_EQUAL(provider.mWorld.GetRelBlockMeta(x, y, z), area->GetRelBlockMeta(x, y, z));
+	}
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("BlockArea",
+	testRead();
+	testMerge();
+	testSelfMerge();
+	testRotate();
+	testWriteInSteps();
+)
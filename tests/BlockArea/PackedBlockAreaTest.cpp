@@ -0,0 +1,198 @@
+// PackedBlockAreaTest.cpp
+
+// Tests that cPackedBlockArea stores and returns exactly the blocks of a cBlockArea
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "PackedBlockArea.h"
+
+
+
+
+
+/** Creates an area of the specified size using the specified number of different blocks, placed pseudo-randomly. */
+static std::unique_ptr<cBlockArea> createArea(Vector3i aSize, unsigned aNumBlocks, int aSeed)
+{
+	auto area = std::make_unique<cBlockArea>();
+	area->Create(aSize, cBlockArea::baTypes | cBlockArea::baMetas);
+	for (int y = 0; y < aSize.y; y++) for (int z = 0; z < aSize.z; z++) for (int x = 0; x < aSize.x; x++)
+	{
+		auto hash = static_cast<unsigned>((x * 31 + y * 17 + z * 7 + aSeed) * 2654435761U);
+		auto block = (hash >> 8) % aNumBlocks;
+		area->SetRelBlockTypeMeta(x, y, z, static_cast<BLOCKTYPE>(block * 7 % 256), static_cast<NIBBLETYPE>(block / 256 + block % 3));
+	}
+	return area;
+}
+
+
+
+
+
+/** Returns true if the two areas have the same size and exactly the same blocktypes and blockmetas. */
+static bool isSameArea(const cBlockArea & aArea1, const cBlockArea & aArea2)
+{
+	if (aArea1.GetSize() != aArea2.GetSize())
+	{
+		return false;
+	}
+	auto count = aArea1.GetBlockCount();
+	return (
+		std::equal(aArea1.GetBlockTypes(), aArea1.GetBlockTypes() + count, aArea2.GetBlockTypes()) &&
+		std::equal(aArea1.GetBlockMetas(), aArea1.GetBlockMetas() + count, aArea2.GetBlockMetas())
+	);
+}
+
+
+
+
+
+/** Tests that packing and unpacking gives the original area, for sizes within one section, and spanning partial sections. */
+static void testRoundtrip()
+{
+	static const Vector3i sizes[] = { {1, 1, 1}, {5, 4, 3}, {16, 16, 16}, {17, 33, 40}, {70, 5, 20} };
+	for (const auto & size: sizes)
+	{
+		for (auto numBlocks: {1U, 2U, 5U, 300U})
+		{
+			auto orig = createArea(size, numBlocks, size.x);
+			cPackedBlockArea packed;
+			packed.Pack(*orig);
+			TEST_EQUAL(packed.GetSize(), size);
+
+			cBlockArea unpacked;
+			packed.Unpack(unpacked);
+			bool isSame = isSameArea(*orig, unpacked);
+			TEST_TRUE(isSame);
+
+			// Single block reads:
+			for (int y = 0; y < size.y; y++) for (int z = 0; z < size.z; z++) for (int x = 0; x < size.x; x++)
+			{
+				BLOCKTYPE type;
+				NIBBLETYPE meta;
+				packed.GetRelBlockTypeMeta(x, y, z, type, meta);
+				TEST_EQUAL(type, orig->GetRelBlockType(x, y, z));
+				TEST_EQUAL(meta, orig->GetRelBlockMeta(x, y, z));
+			}
+		}
+	}
+}
+
+
+
+
+
+/** Tests unpacking a part of the area, including parts reaching outside of it. */
+static void testPartialUnpack()
+{
+	auto orig = createArea({40, 20, 35}, 6, 1);
+	cPackedBlockArea packed;
+	packed.Pack(*orig);
+
+	static const cCuboid areas[] =
+	{
+		cCuboid({0, 0, 0}, {39, 19, 34}),
+		cCuboid({3, 2, 1}, {3, 2, 1}),
+		cCuboid({15, 0, 15}, {16, 19, 16}),
+		cCuboid({-10, 5, 20}, {10, 100, 50}),
+		cCuboid({30, 10, 30}, {20, 0, 10}),  // Unsorted
+	};
+	for (const auto & area: areas)
+	{
+		cCuboid cropped(area);
+		cropped.Sort();
+		cropped.ClampX(0, 39);
+		cropped.ClampY(0, 19);
+		cropped.ClampZ(0, 34);
+		cBlockArea expected;
+		expected.Create(cropped.DifX() + 1, cropped.DifY() + 1, cropped.DifZ() + 1, cBlockArea::baTypes | cBlockArea::baMetas);
+		expected.Merge(*orig, -cropped.p1, cBlockArea::msOverwrite);
+
+		cBlockArea unpacked;
+		TEST_TRUE(packed.Unpack(unpacked, area));
+		bool isSame = isSameArea(expected, unpacked);
+		TEST_TRUE(isSame);
+	}
+
+	// Areas outside don't unpack anything:
+	cBlockArea unpacked;
+	TEST_FALSE(packed.Unpack(unpacked, cCuboid({40, 0, 0}, {50, 10, 10})));
+	TEST_FALSE(packed.Unpack(unpacked, cCuboid({0, -10, 0}, {10, -1, 10})));
+}
+
+
+
+
+
+/** Tests writing single blocks, growing the section palettes past several bit widths. */
+static void testSetBlocks()
+{
+	auto expected = createArea({20, 18, 17}, 1, 0);
+	cPackedBlockArea packed;
+	packed.Pack(*expected);
+	for (int i = 0; i < 3000; i++)
+	{
+		auto hash = static_cast<unsigned>(i * 2654435761U);
+		int x = static_cast<int>(hash % 20);
+		int y = static_cast<int>((hash >> 5) % 18);
+		int z = static_cast<int>((hash >> 10) % 17);
+		auto type = static_cast<BLOCKTYPE>(i % 256);
+		auto meta = static_cast<NIBBLETYPE>((i / 256) % 16);
+		switch (i % 3)
+		{
+			case 0:
+			{
+				packed.SetRelBlockTypeMeta(x, y, z, type, meta);
+				expected->SetRelBlockTypeMeta(x, y, z, type, meta);
+				break;
+			}
+			case 1:
+			{
+				packed.SetRelBlockType(x, y, z, type);
+				expected->SetRelBlockType(x, y, z, type);
+				break;
+			}
+			case 2:
+			{
+				packed.SetRelBlockMeta(x, y, z, meta);
+				expected->SetRelBlockMeta(x, y, z, meta);
+				break;
+			}
+		}
+	}
+	cBlockArea unpacked;
+	packed.Unpack(unpacked);
+	bool isSame = isSameArea(*expected, unpacked);
+	TEST_TRUE(isSame);
+}
+
+
+
+
+
+/** Tests that an area made of a few blocks takes a fraction of the cBlockArea memory. */
+static void testMemoryUsage()
+{
+	auto orig = createArea({64, 32, 64}, 4, 2);
+	cPackedBlockArea packed;
+	packed.Pack(*orig);
+
+	// The cBlockArea uses 2 bytes per block, the packed area 2 bits per block plus the section overhead:
+	auto unpackedSize = orig->GetBlockCount() * 2;
+	TEST_LESS_THAN_OR_EQUAL(packed.GetMemoryUsage(), unpackedSize / 6);
+
+	// A single-block area stores only the palettes:
+	auto air = createArea({64, 32, 64}, 1, 0);
+	packed.Pack(*air);
+	TEST_LESS_THAN_OR_EQUAL(packed.GetMemoryUsage(), 4096);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("PackedBlockArea",
+	testRoundtrip();
+	testPartialUnpack();
+	testSetBlocks();
+	testMemoryUsage();
+)
@@ -0,0 +1,106 @@
+
+// PatternChunkProvider.h
+
+// Declares the cPatternChunkProvider class that provides chunks filled with a known pattern, for cBlockArea reading tests
+
+
+
+
+
+#pragma once
+
+#include "ForEachChunkProvider.h"
+#include "ChunkDataCallback.h"
+
+
+
+
+
+class cPatternChunkProvider:
+	public cForEachChunkProvider
+{
+public:
+
+	/** Returns the block type of the pattern at the specified world coords. */
+	static BLOCKTYPE patternType(int aX, int aY, int aZ)
+	{
+		return static_cast<BLOCKTYPE>(aX * 7 + aY * 13 + aZ * 3);
+	}
+
+	/** Returns the block meta of the pattern at the specified world coords. */
+	static NIBBLETYPE patternMeta(int aX, int aY, int aZ)
+	{
+		return static_cast<NIBBLETYPE>((aX + 2 * aY + 3 * aZ) & 0x0f);
+	}
+
+	/** Creates the data for all the chunks in the specified range up front, so that the reads measure only the copying. */
+	cPatternChunkProvider(int aMinChunkX, int aMaxChunkX, int aMinChunkZ, int aMaxChunkZ)
+	{
+		struct sBuffers
+		{
+			cChunkDef::BlockTypes mTypes;
+			cChunkDef::BlockNibbles mMetas;
+			cChunkDef::BlockNibbles mLight;
+		};
+		auto buffers = std::make_unique<sBuffers>();
+		auto & types = buffers->mTypes;
+		auto & metas = buffers->mMetas;
+		auto & light = buffers->mLight;
+		std::fill(std::begin(light), std::end(light), static_cast<NIBBLETYPE>(0xff));
+		for (int chunkZ = aMinChunkZ; chunkZ <= aMaxChunkZ; chunkZ++)
+		{
+			for (int chunkX = aMinChunkX; chunkX <= aMaxChunkX; chunkX++)
+			{
+				std::fill(std::begin(metas), std::end(metas), static_cast<NIBBLETYPE>(0));
+				for (int y = 0; y < cChunkDef::Height; y++) for (int z = 0; z < cChunkDef::Width; z++) for (int x = 0; x < cChunkDef::Width; x++)
+				{
+					int worldX = chunkX * cChunkDef::Width + x;
+					int worldZ = chunkZ * cChunkDef::Width + z;
+					types[cChunkDef::MakeIndex(x, y, z)] = patternType(worldX, y, worldZ);
+					cChunkDef::PackNibble(metas, cChunkDef::MakeIndex(x, y, z), patternMeta(worldX, y, worldZ));
+				}
+				auto & chunk = mChunks[{chunkX, chunkZ}];
+				chunk.mBlockData.SetAll(types, metas);
+				chunk.mLightData.SetAll(light, light);
+			}
+		}
+	}
+
+	// cForEachChunkProvider overrides:
+	virtual bool ForEachChunkInRect(int aMinChunkX, int aMaxChunkX, int aMinChunkZ, int aMaxChunkZ, cChunkDataCallback & aCallback) override
+	{
+		bool res = true;
+		for (int chunkZ = aMinChunkZ; chunkZ <= aMaxChunkZ; chunkZ++)
+		{
+			for (int chunkX = aMinChunkX; chunkX <= aMaxChunkX; chunkX++)
+			{
+				auto itr = mChunks.find({chunkX, chunkZ});
+				if (itr == mChunks.end())
+				{
+					res = false;
+					continue;
+				}
+				if (aCallback.Coords(chunkX, chunkZ))
+				{
+					aCallback.ChunkData(itr->second.mBlockData, itr->second.mLightData);
+				}
+			}
+		}
+		return res;
+	}
+
+	virtual bool WriteBlockArea(cBlockArea & aArea, int aMinBlockX, int aMinBlockY, int aMinBlockZ, int aDataTypes) override
+	{
+		return false;
+	}
+
+protected:
+
+	struct sChunk
+	{
+		ChunkBlockData mBlockData;
+		ChunkLightData mLightData;
+	};
+
+	std::map<std::pair<int, int>, sChunk> mChunks;
+};
@@ -0,0 +1,182 @@
+
+// Stubs.cpp
+
+// Implements stubs of various Cuberite methods that are needed for linking but not for runtime
+// This is required so that we don't bring in the entire Cuberite via dependencies
+
+#include "Globals.h"
+#include "BlockInfo.h"
+#include "Blocks/BlockHandler.h"
+#include "BlockEntities/BlockEntity.h"
+
+
+
+
+
+cBoundingBox::cBoundingBox(double, double, double, double, double, double)
+{
+}
+
+
+
+
+
+cBoundingBox cBlockHandler::GetPlacementCollisionBox(BLOCKTYPE a_XM, BLOCKTYPE a_XP, BLOCKTYPE a_YM, BLOCKTYPE a_YP, BLOCKTYPE a_ZM, BLOCKTYPE a_ZP) const
+{
+	return cBoundingBox(0, 0, 0, 0, 0, 0);
+}
+
+
+
+
+
+void cBlockHandler::OnUpdate(cChunkInterface & a_ChunkInterface, cWorldInterface & a_WorldInterface, cBlockPluginInterface & a_PluginInterface, cChunk & a_Chunk, const Vector3i a_RelPos) const
+{
+}
+
+
+
+
+
+void cBlockHandler::OnNeighborChanged(cChunkInterface & a_ChunkInterface, Vector3i a_BlockPos, eBlockFace a_WhichNeighbor) const
+{
+}
+
+
+
+
+
+void cBlockHandler::NeighborChanged(cChunkInterface & a_ChunkInterface, Vector3i a_BlockPos, eBlockFace a_WhichNeighbor)
+{
+}
+
+
+
+
+
+cItems cBlockHandler::ConvertToPickups(const NIBBLETYPE a_BlockMeta, const cItem * const a_Tool) const
+{
+	return cItems();
+}
+
+
+
+
+
+bool cBlockHandler::CanBeAt(const cChunk & a_Chunk, const Vector3i a_Position, const NIBBLETYPE a_Meta) const
+{
+	return true;
+}
+
+
+
+
+
+bool cBlockHandler::IsUseable() const
+{
+	return false;
+}
+
+
+
+
+
+bool cBlockHandler::DoesIgnoreBuildCollision(const cWorld & a_World, const cItem & a_HeldItem, Vector3i a_Position, NIBBLETYPE a_Meta, eBlockFace a_ClickedBlockFace, bool a_ClickedDirectly) const
+{
+	return m_BlockType == E_BLOCK_AIR;
+}
+
+
+
+
+
+void cBlockHandler::Check(cChunkInterface & a_ChunkInterface, cBlockPluginInterface & a_PluginInterface, Vector3i a_RelPos, cChunk & a_Chunk) const
+{
+}
+
+
+
+
+
+ColourID cBlockHandler::GetMapBaseColourID(NIBBLETYPE a_Meta) const
+{
+	return 0;
+}
+
+
+
+
+
+bool cBlockHandler::IsInsideBlock(Vector3d a_Position, const NIBBLETYPE a_BlockMeta) const
+{
+	return true;
+}
+
+
+
+
+
+/** A handler that changes the metas in each rotation and mirror, so that the tests can check the metas get transformed.
+Each transformation is a distinct permutation of the metas, CCW being the inverse of CW. */
+class cTransformingBlockHandler final :
+	public cBlockHandler
+{
+	using Super = cBlockHandler;
+
+public:
+
+	using Super::Super;
+
+	virtual NIBBLETYPE MetaRotateCCW(NIBBLETYPE a_Meta) const override { return (a_Meta + 15) & 0x0f; }
+	virtual NIBBLETYPE MetaRotateCW(NIBBLETYPE a_Meta)  const override { return (a_Meta + 1) & 0x0f; }
+	virtual NIBBLETYPE MetaMirrorXY(NIBBLETYPE a_Meta)  const override { return a_Meta ^ 0x01; }
+	virtual NIBBLETYPE MetaMirrorXZ(NIBBLETYPE a_Meta)  const override { return a_Meta ^ 0x02; }
+	virtual NIBBLETYPE MetaMirrorYZ(NIBBLETYPE a_Meta)  const override { return a_Meta ^ 0x04; }
+};
+
+
+
+
+
+const cBlockHandler & cBlockHandler::For(BLOCKTYPE a_BlockType)
+{
+	// Dummy handlers, odd block types transform their metas:
+	static cBlockHandler Handler(E_BLOCK_AIR);
+	static cTransformingBlockHandler TransformingHandler(E_BLOCK_STONE);
+	return ((a_BlockType % 2) == 1) ? TransformingHandler : Handler;
+}
+
+
+
+
+
+bool cBlockEntity::IsBlockEntityBlockType(BLOCKTYPE a_BlockType)
+{
+	return false;
+}
+
+
+
+
+
+void cBlockEntity::SetPos(Vector3i a_NewPos)
+{
+}
+
+
+
+
+
+OwnedBlockEntity cBlockEntity::Clone(Vector3i a_Pos)
+{
+	return nullptr;
+}
+
+
+
+
+
+OwnedBlockEntity cBlockEntity::CreateByBlockType(BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta, Vector3i a_Pos, cWorld * a_World)
+{
+	return nullptr;
+}
@@ -0,0 +1,271 @@
+// BlockEntityTickSchedulerTest.cpp
+
+// Tests the cBlockEntityTickScheduler: sleeping, waking up, scheduled wake-ups and removing the block entities
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "BlockEntities/BlockEntityTickScheduler.h"
+
+
+
+
+
+/** A block entity with the members that the scheduler manages, counting its ticks. */
+class cFakeBlockEntity
+{
+public:
+
+	bool m_IsSleeping = false;
+	bool m_WantsToSleep = false;
+	cTickTimeLong m_WakeUpAge = cTickTimeLong::max();
+
+	/** The number of times the block entity was ticked. */
+	int m_NumTicks = 0;
+
+	/** Called in each tick of the block entity, if set. */
+	std::function<void(cFakeBlockEntity &)> m_OnTick;
+
+
+	/** Same as cBlockEntity::Sleep(). */
+	void Sleep(cTickTimeLong a_WakeUpAge = cTickTimeLong::max())
+	{
+		m_WantsToSleep = true;
+		m_WakeUpAge = a_WakeUpAge;
+	}
+};
+
+using cScheduler = cBlockEntityTickScheduler<cFakeBlockEntity>;
+
+
+
+
+
+/** Ticks the scheduler at the specified world age, the way cChunk::Tick() does. */
+static void tick(cScheduler & aScheduler, int aWorldAge)
+{
+	aScheduler.Tick(cTickTimeLong(aWorldAge), [](cFakeBlockEntity & aBlockEntity)
+		{
+			aBlockEntity.m_NumTicks += 1;
+			if (aBlockEntity.m_OnTick)
+			{
+				aBlockEntity.m_OnTick(aBlockEntity);
+			}
+		}
+	);
+}
+
+
+
+
+
+/** Tests that the block entities are ticked until they request sleep. */
+static void testSleep()
+{
+	cScheduler scheduler;
+	cFakeBlockEntity awake, sleepy;
+	scheduler.Add(awake);
+	scheduler.Add(sleepy);
+	sleepy.m_OnTick = [](cFakeBlockEntity & aBlockEntity) { aBlockEntity.Sleep(); };
+
+	tick(scheduler, 1);
+	TEST_EQUAL(awake.m_NumTicks, 1);
+	TEST_EQUAL(sleepy.m_NumTicks, 1);
+	TEST_TRUE(sleepy.m_IsSleeping);
+	TEST_FALSE(sleepy.m_WantsToSleep);
+	TEST_EQUAL(scheduler.GetNumAwake(), 1);
+
+	// Without a wake-up, the sleeping block entity isn't ticked anymore:
+	for (int age = 2; age < 100; age++)
+	{
+		tick(scheduler, age);
+	}
+	TEST_EQUAL(awake.m_NumTicks, 99);
+	TEST_EQUAL(sleepy.m_NumTicks, 1);
+	TEST_EQUAL(scheduler.GetNumWakeUps(), 0);
+}
+
+
+
+
+
+/** Tests the wake-ups by an event, outside of the ticks and while ticking. */
+static void testWakeUp()
+{
+	cScheduler scheduler;
+	cFakeBlockEntity first, second;
+	scheduler.Add(first);
+	scheduler.Add(second);
+	first.m_OnTick = [](cFakeBlockEntity & aBlockEntity) { aBlockEntity.Sleep(); };
+	second.m_OnTick = [](cFakeBlockEntity & aBlockEntity) { aBlockEntity.Sleep(); };
+	tick(scheduler, 1);
+	TEST_TRUE(first.m_IsSleeping);
+	TEST_TRUE(second.m_IsSleeping);
+
+	// A woken block entity is ticked again, a repeated wake-up doesn't tick it twice:
+	scheduler.WakeUp(first);
+	scheduler.WakeUp(first);
+	TEST_FALSE(first.m_IsSleeping);
+	tick(scheduler, 2);
+	TEST_EQUAL(first.m_NumTicks, 2);
+	TEST_EQUAL(second.m_NumTicks, 1);
+
+	// A block entity woken up while ticking another one is ticked from the next tick on:
+	first.m_OnTick = [&scheduler, &second](cFakeBlockEntity & aBlockEntity)
+	{
+		scheduler.WakeUp(second);
+		aBlockEntity.Sleep();
+	};
+	scheduler.WakeUp(first);
+	tick(scheduler, 3);
+	TEST_EQUAL(first.m_NumTicks, 3);
+	TEST_EQUAL(second.m_NumTicks, 1);
+	TEST_FALSE(second.m_IsSleeping);
+	tick(scheduler, 4);
+	TEST_EQUAL(second.m_NumTicks, 2);
+
+	// A wake-up after requesting sleep within the same tick cancels the request:
+	second.m_OnTick = [&scheduler](cFakeBlockEntity & aBlockEntity)
+	{
+		aBlockEntity.Sleep();
+		scheduler.WakeUp(aBlockEntity);
+	};
+	scheduler.WakeUp(second);
+	tick(scheduler, 5);
+	TEST_FALSE(second.m_IsSleeping);
+	tick(scheduler, 6);
+	TEST_EQUAL(second.m_NumTicks, 4);
+	TEST_EQUAL(scheduler.GetNumAwake(), 1);
+}
+
+
+
+
+
+/** Tests the wake-ups scheduled at a world age, and their cancelling by an earlier wake-up. */
+static void testScheduledWakeUp()
+{
+	cScheduler scheduler;
+	cFakeBlockEntity blockEntity;
+	scheduler.Add(blockEntity);
+	blockEntity.m_OnTick = [](cFakeBlockEntity & aBlockEntity) { aBlockEntity.Sleep(cTickTimeLong(10)); };
+
+	tick(scheduler, 1);
+	TEST_EQUAL(scheduler.GetNumWakeUps(), 1);
+	for (int age = 2; age < 10; age++)
+	{
+		tick(scheduler, age);
+	}
+	TEST_EQUAL(blockEntity.m_NumTicks, 1);
+
+	// Ticked at the scheduled age, then sleeps again until the next one:
+	blockEntity.m_OnTick = [](cFakeBlockEntity & aBlockEntity) { aBlockEntity.Sleep(cTickTimeLong(20)); };
+	tick(scheduler, 10);
+	TEST_EQUAL(blockEntity.m_NumTicks, 2);
+	TEST_EQUAL(scheduler.GetNumWakeUps(), 1);
+
+	// An earlier wake-up drops the scheduled one:
+	scheduler.WakeUp(blockEntity);
+	TEST_EQUAL(scheduler.GetNumWakeUps(), 0);
+	blockEntity.m_OnTick = [](cFakeBlockEntity & aBlockEntity) { aBlockEntity.Sleep(); };
+	tick(scheduler, 11);
+	TEST_EQUAL(blockEntity.m_NumTicks, 3);
+	for (int age = 12; age < 30; age++)
+	{
+		tick(scheduler, age);
+	}
+	TEST_EQUAL(blockEntity.m_NumTicks, 3);
+}
+
+
+
+
+
+/** Tests that the removed block entities are neither ticked nor woken up, even when removed while ticking. */
+static void testRemove()
+{
+	cScheduler scheduler;
+	auto remover = std::make_unique<cFakeBlockEntity>();
+	auto victim = std::make_unique<cFakeBlockEntity>();
+	auto self = std::make_unique<cFakeBlockEntity>();
+	auto scheduled = std::make_unique<cFakeBlockEntity>();
+	scheduler.Add(*remover);
+	scheduler.Add(*victim);
+	scheduler.Add(*self);
+	scheduler.Add(*scheduled);
+
+	// A sleeping block entity with a scheduled wake-up is unscheduled when removed:
+	scheduled->m_OnTick = [](cFakeBlockEntity & aBlockEntity) { aBlockEntity.Sleep(cTickTimeLong(5)); };
+	tick(scheduler, 1);
+	TEST_EQUAL(scheduler.GetNumWakeUps(), 1);
+	scheduler.Remove(*scheduled);
+	scheduled.reset();
+	TEST_EQUAL(scheduler.GetNumWakeUps(), 0);
+
+	// A block entity removed by another one's tick isn't ticked in the same tick; one can remove itself, too:
+	remover->m_OnTick = [&scheduler, &victim](cFakeBlockEntity &)
+	{
+		scheduler.Remove(*victim);
+		victim.reset();
+	};
+	self->m_OnTick = [&scheduler](cFakeBlockEntity & aBlockEntity) { scheduler.Remove(aBlockEntity); };
+	tick(scheduler, 2);
+	TEST_EQUAL(victim, nullptr);
+	TEST_EQUAL(self->m_NumTicks, 2);
+	TEST_EQUAL(scheduler.GetNumAwake(), 1);
+	self.reset();
+
+	remover->m_OnTick = nullptr;
+	for (int age = 3; age < 10; age++)
+	{
+		tick(scheduler, age);
+	}
+	TEST_EQUAL(remover->m_NumTicks, 9);
+}
+
+
+
+
+
+/** Tests replacing all the block entities, the way cChunk::SetAllData() does. */
+static void testReplaceAll()
+{
+	cScheduler scheduler;
+	auto oldAwake = std::make_unique<cFakeBlockEntity>();
+	auto oldScheduled = std::make_unique<cFakeBlockEntity>();
+	scheduler.Add(*oldAwake);
+	scheduler.Add(*oldScheduled);
+	oldScheduled->m_OnTick = [](cFakeBlockEntity & aBlockEntity) { aBlockEntity.Sleep(cTickTimeLong(5)); };
+	tick(scheduler, 1);
+	TEST_EQUAL(scheduler.GetNumWakeUps(), 1);
+
+	// Replace the old block entities with new ones, which start awake, even if they slept before:
+	cFakeBlockEntity newBlockEntity;
+	newBlockEntity.m_IsSleeping = true;
+	newBlockEntity.m_WakeUpAge = cTickTimeLong(3);
+	scheduler.Clear();
+	oldAwake.reset();
+	oldScheduled.reset();
+	scheduler.Add(newBlockEntity);
+	TEST_FALSE(newBlockEntity.m_IsSleeping);
+	TEST_EQUAL(scheduler.GetNumAwake(), 1);
+	TEST_EQUAL(scheduler.GetNumWakeUps(), 0);
+
+	// Only the new one is ticked, also past the old scheduled wake-up:
+	for (int age = 2; age < 10; age++)
+	{
+		tick(scheduler, age);
+	}
+	TEST_EQUAL(newBlockEntity.m_NumTicks, 8);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("BlockEntityTickScheduler",
+	testSleep();
+	testWakeUp();
+	testScheduledWakeUp();
+	testRemove();
+	testReplaceAll();
+)
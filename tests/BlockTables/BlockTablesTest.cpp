@@ -0,0 +1,58 @@
+// BlockTablesTest.cpp
+
+// Tests that the BlockTables lookup tables give the same protocol block IDs as the palette functions they are built from
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "BlockType.h"
+#include "Protocol/Palettes/BlockTables.h"
+#include "Protocol/Palettes/Palette_1_13.h"
+#include "Protocol/Palettes/Palette_1_13_1.h"
+#include "Protocol/Palettes/Palette_1_14.h"
+#include "Protocol/Palettes/Upgrade.h"
+
+
+
+
+
+/** Tests that each entry in the table is the ID given by the palette function for the upgraded block. */
+template <UInt32 Palette(BlockState)>
+static void testTable(const BlockTables::Table & aTable)
+{
+	for (size_t block = 0; block < 256; block++)
+	{
+		for (NIBBLETYPE meta = 0; meta < 16; meta++)
+		{
+			auto blockType = static_cast<BLOCKTYPE>(block);
+			TEST_EQUAL(aTable[BlockTables::Index(blockType, meta)], Palette(PaletteUpgrade::FromBlock(blockType, meta)));
+		}
+	}
+}
+
+
+
+
+
+/** Tests the tables of all the palettes. */
+static void testTables()
+{
+	testTable<&Palette_1_13::From>(BlockTables::From_1_13());
+	testTable<&Palette_1_13_1::From>(BlockTables::From_1_13_1());
+	testTable<&Palette_1_14::From>(BlockTables::From_1_14());
+
+	// Some well-known blocks:
+	TEST_EQUAL(BlockTables::From_1_13()[BlockTables::Index(E_BLOCK_AIR, 0)], 0);
+	TEST_EQUAL(BlockTables::From_1_13()[BlockTables::Index(E_BLOCK_STONE, 0)], 1);
+	TEST_EQUAL(BlockTables::From_1_14()[BlockTables::Index(E_BLOCK_STONE, 1)], 2);  // Granite
+
+	// The tables are built once:
+	TEST_EQUAL(&BlockTables::From_1_14(), &BlockTables::From_1_14());
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("BlockTables",
+	testTables();
+)
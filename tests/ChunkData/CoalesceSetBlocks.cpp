@@ -0,0 +1,75 @@
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "BlockType.h"
+#include "ChunkDef.h"
+
+
+
+
+/** Tests that only the last change of each block is kept. */
+static void testLastChangeWins()
+{
+	sSetBlockVector changes;
+	changes.emplace_back(0, 0, 1, 2, 3, E_BLOCK_STONE, 0);
+	changes.emplace_back(0, 0, 5, 6, 7, E_BLOCK_DIRT, 0);
+	changes.emplace_back(0, 0, 1, 2, 3, E_BLOCK_AIR, 0);
+	changes.emplace_back(0, 0, 0, 0, 0, E_BLOCK_GRASS, 0);
+	changes.emplace_back(0, 0, 1, 2, 3, E_BLOCK_WOOL, 4);
+	changes.emplace_back(0, 0, 5, 6, 7, E_BLOCK_SAND, 1);
+
+	CoalesceSetBlocks(changes);
+	TEST_EQUAL(changes.size(), 3U);
+
+	// The changes are sorted by their block index:
+	TEST_EQUAL(changes[0].GetRelativePos(), Vector3i(0, 0, 0));
+	TEST_EQUAL(changes[0].m_BlockType, E_BLOCK_GRASS);
+	TEST_EQUAL(changes[1].GetRelativePos(), Vector3i(1, 2, 3));
+	TEST_EQUAL(changes[1].m_BlockType, E_BLOCK_WOOL);
+	TEST_EQUAL(changes[1].m_BlockMeta, 4);
+	TEST_EQUAL(changes[2].GetRelativePos(), Vector3i(5, 6, 7));
+	TEST_EQUAL(changes[2].m_BlockType, E_BLOCK_SAND);
+	TEST_EQUAL(changes[2].m_BlockMeta, 1);
+}
+
+
+
+
+
+/** Tests that distinct changes are all kept, and that small vectors are handled. */
+static void testDistinct()
+{
+	sSetBlockVector changes;
+	CoalesceSetBlocks(changes);
+	TEST_TRUE(changes.empty());
+
+	changes.emplace_back(0, 0, 15, 255, 15, E_BLOCK_STONE, 0);
+	CoalesceSetBlocks(changes);
+	TEST_EQUAL(changes.size(), 1U);
+
+	changes.clear();
+	for (int y = 0; y < cChunkDef::Height; y++)
+	{
+		for (int x = cChunkDef::Width - 1; x >= 0; x--)
+		{
+			changes.emplace_back(0, 0, x, y, 0, E_BLOCK_STONE, 0);
+		}
+	}
+	CoalesceSetBlocks(changes);
+	TEST_EQUAL(changes.size(), static_cast<size_t>(cChunkDef::Width * cChunkDef::Height));
+	for (size_t i = 1; i < changes.size(); i++)
+	{
+		TEST_TRUE(
+			cChunkDef::MakeIndex(changes[i - 1].m_RelX, changes[i - 1].m_RelY, changes[i - 1].m_RelZ) <
+			cChunkDef::MakeIndex(changes[i].m_RelX, changes[i].m_RelY, changes[i].m_RelZ)
+		);
+	}
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("ChunkData CoalesceSetBlocks",
+	testLastChangeWins();
+	testDistinct();
+)
@@ -0,0 +1,278 @@
+// ChunkSectionPaletteTest.cpp
+
+// Tests the cChunkSectionPalette class: the section-local palettes are decoded and compared against the global palette output
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "BlockType.h"
+#include "ByteBuffer.h"
+#include "Protocol/ChunkSectionPalette.h"
+#include "Protocol/Palettes/BlockTables.h"
+
+
+
+
+
+/** A single chunk section's blocks and metas. */
+struct sSection
+{
+	ChunkBlockData::BlockArray mBlocks{};
+	ChunkBlockData::MetaArray mMetas{};
+
+	void set(size_t aIndex, BLOCKTYPE aBlock, NIBBLETYPE aMeta = 0)
+	{
+		mBlocks[aIndex] = aBlock;
+		cChunkDef::PackNibble(mMetas.data(), aIndex, aMeta);
+	}
+};
+
+
+
+
+
+/** The 1.9 - 1.12 global palette. */
+static UInt32 paletteLegacy(BLOCKTYPE aBlock, NIBBLETYPE aMeta)
+{
+	return static_cast<UInt32>((aBlock << 4) | aMeta);
+}
+
+
+
+
+
+/** The 1.13 global palette. */
+static UInt32 palette393(BLOCKTYPE aBlock, NIBBLETYPE aMeta)
+{
+	return BlockTables::From_1_13()[BlockTables::Index(aBlock, aMeta)];
+}
+
+
+
+
+
+/** Writes the section the way the serializer did before the local palettes: the global palette with the full bits per entry.
+The 1.9 - 1.12 format has a zero palette length, the 1.13+ format has no palette length at all. */
+template <typename PaletteFn>
+static void writeGlobalSection(cByteBuffer & aOut, const sSection * aSection, PaletteFn aPalette, UInt8 aBitsPerEntry, bool aWritePaletteLength)
+{
+	aOut.WriteBEUInt8(aBitsPerEntry);
+	if (aWritePaletteLength)
+	{
+		aOut.WriteVarInt32(0);
+	}
+	aOut.WriteVarInt32(static_cast<UInt32>(ChunkBlockData::SectionBlockCount * aBitsPerEntry / 64));
+	UInt64 buffer = 0;
+	unsigned char bitIndex = 0;
+	for (size_t i = 0; i < ChunkBlockData::SectionBlockCount; i++)
+	{
+		auto value = (aSection == nullptr) ? aPalette(0, 0) : aPalette(aSection->mBlocks[i], cChunkDef::ExpandNibble(aSection->mMetas.data(), i));
+		buffer |= static_cast<UInt64>(value) << bitIndex;
+		auto remaining = static_cast<char>(aBitsPerEntry - (64 - bitIndex));
+		if (remaining >= 0)
+		{
+			aOut.WriteBEUInt64(buffer);
+			buffer = static_cast<UInt64>(value >> (aBitsPerEntry - remaining));
+			bitIndex = static_cast<unsigned char>(remaining);
+		}
+		else
+		{
+			bitIndex += aBitsPerEntry;
+		}
+	}
+}
+
+
+
+
+
+/** Reads a section written in either format and returns the global ID of each block.
+aGlobalHasPaletteLength tells whether the global palette sections have the zero palette length (1.9 - 1.12). */
+static std::vector<UInt32> readSection(cByteBuffer & aIn, bool aGlobalHasPaletteLength, UInt8 & aBitsPerEntry)
+{
+	TEST_TRUE(aIn.ReadBEUInt8(aBitsPerEntry));
+	std::vector<UInt32> palette;
+	bool isLocal = (aBitsPerEntry <= cChunkSectionPalette::MaxLocalBitsPerEntry);
+	if (isLocal || aGlobalHasPaletteLength)
+	{
+		UInt32 paletteLength;
+		TEST_TRUE(aIn.ReadVarInt32(paletteLength));
+		TEST_EQUAL(paletteLength == 0, !isLocal);
+		for (UInt32 i = 0; i < paletteLength; i++)
+		{
+			UInt32 entry;
+			TEST_TRUE(aIn.ReadVarInt32(entry));
+			palette.push_back(entry);
+		}
+	}
+	UInt32 dataLength;
+	TEST_TRUE(aIn.ReadVarInt32(dataLength));
+	TEST_EQUAL(dataLength, ChunkBlockData::SectionBlockCount * aBitsPerEntry / 64);
+	std::vector<UInt64> data(dataLength);
+	for (auto & word: data)
+	{
+		TEST_TRUE(aIn.ReadBEUInt64(word));
+	}
+
+	// Unpack the entries, which may span two words:
+	std::vector<UInt32> res;
+	UInt64 mask = (UInt64(1) << aBitsPerEntry) - 1;
+	for (size_t i = 0; i < ChunkBlockData::SectionBlockCount; i++)
+	{
+		size_t bit = i * aBitsPerEntry;
+		UInt64 value = data[bit / 64] >> (bit % 64);
+		if ((bit % 64) + aBitsPerEntry > 64)
+		{
+			value |= data[bit / 64 + 1] << (64 - bit % 64);
+		}
+		value &= mask;
+		if (isLocal)
+		{
+			TEST_TRUE(value < palette.size());
+			res.push_back(palette[value]);
+		}
+		else
+		{
+			res.push_back(static_cast<UInt32>(value));
+		}
+	}
+	return res;
+}
+
+
+
+
+
+/** Writes the section with the local palette and with the global palette, and checks that both decode into the same global IDs.
+Returns the bits per entry used by the local palette. */
+template <typename PaletteFn>
+static UInt8 testSection(cChunkSectionPalette & aPalette, const sSection * aSection, PaletteFn aPaletteFn, UInt8 aGlobalBitsPerEntry, bool aGlobalHasPaletteLength)
+{
+	cByteBuffer local(64 KiB), global(64 KiB);
+	aPalette.Build((aSection == nullptr) ? nullptr : &aSection->mBlocks, (aSection == nullptr) ? nullptr : &aSection->mMetas, aPaletteFn, aGlobalBitsPerEntry);
+	aPalette.Write(local, aGlobalHasPaletteLength);
+	writeGlobalSection(global, aSection, aPaletteFn, aGlobalBitsPerEntry, aGlobalHasPaletteLength);
+
+	UInt8 localBits, globalBits;
+	auto localIDs = readSection(local, aGlobalHasPaletteLength, localBits);
+	auto globalIDs = readSection(global, aGlobalHasPaletteLength, globalBits);
+	TEST_EQUAL(local.GetReadableSpace(), 0);
+	TEST_EQUAL(globalBits, aGlobalBitsPerEntry);
+	TEST_EQUAL(localBits, aPalette.GetBitsPerEntry());
+	TEST_TRUE(localIDs == globalIDs);
+
+	// A section using the global palette is written exactly as before:
+	if (aPalette.IsGlobal())
+	{
+		local.ResetRead();
+		global.ResetRead();
+		ContiguousByteBuffer localData, globalData;
+		local.ReadAll(localData);
+		global.ReadAll(globalData);
+		TEST_TRUE(localData == globalData);
+	}
+	return localBits;
+}
+
+
+
+
+
+/** Tests the sections typical for the world: empty, terrain and a mix of many blocks, in both the 1.9 and the 1.13 formats. */
+static void testTypicalSections()
+{
+	cChunkSectionPalette palette;
+	for (int format = 0; format < 2; format++)
+	{
+		auto check = [&palette, format](const sSection * aSection)
+		{
+			return (format == 0) ?
+				testSection(palette, aSection, &paletteLegacy, 13, true) :
+				testSection(palette, aSection, &palette393, 14, false);
+		};
+
+		// An empty section is all air, a single palette entry:
+		TEST_EQUAL(check(nullptr), 4);
+		TEST_EQUAL(palette.GetEntries().size(), 1);
+
+		// Stone with some ores and variants fits into the minimal 4 bits:
+		sSection terrain;
+		for (size_t i = 0; i < ChunkBlockData::SectionBlockCount; i++)
+		{
+			terrain.set(i, E_BLOCK_STONE, static_cast<NIBBLETYPE>(i % 7));
+		}
+		terrain.set(100, E_BLOCK_COAL_ORE);
+		terrain.set(200, E_BLOCK_IRON_ORE);
+		terrain.set(4095, E_BLOCK_DIAMOND_ORE);
+		TEST_EQUAL(check(&terrain), 4);
+		TEST_EQUAL(palette.GetEntries().size(), 10);
+
+		// 17 distinct blocks need 5 bits:
+		sSection mixed;
+		for (size_t i = 0; i < ChunkBlockData::SectionBlockCount; i++)
+		{
+			mixed.set(i, E_BLOCK_WOOL, static_cast<NIBBLETYPE>(i % 16));
+		}
+		mixed.set(1234, E_BLOCK_GLASS);
+		TEST_EQUAL(check(&mixed), 5);
+
+		// The empty section again, the previous sections' blocks are not in its palette:
+		TEST_EQUAL(check(nullptr), 4);
+		TEST_EQUAL(palette.GetEntries().size(), 1);
+	}
+}
+
+
+
+
+
+/** Tests the palette sizes around the limit of the local palette. */
+static void testPaletteLimits()
+{
+	cChunkSectionPalette palette;
+
+	// 256 distinct legacy values still fit the local palette with 8 bits:
+	sSection full;
+	for (size_t i = 0; i < ChunkBlockData::SectionBlockCount; i++)
+	{
+		auto value = i % 256;
+		full.set(i, static_cast<BLOCKTYPE>(value / 16), static_cast<NIBBLETYPE>(value % 16));
+	}
+	TEST_EQUAL(testSection(palette, &full, &paletteLegacy, 13, true), 8);
+	TEST_FALSE(palette.IsGlobal());
+	TEST_EQUAL(palette.GetEntries().size(), 256);
+
+	// 257 distinct legacy values use the global palette:
+	full.set(4000, 200, 0);
+	TEST_EQUAL(testSection(palette, &full, &paletteLegacy, 13, true), 13);
+	TEST_TRUE(palette.IsGlobal());
+	TEST_TRUE(palette.GetEntries().empty());
+
+	// All the 4096 possible blocks, in both formats; in 1.13 many of them map onto the same ID:
+	sSection all;
+	for (size_t i = 0; i < ChunkBlockData::SectionBlockCount; i++)
+	{
+		all.set(i, static_cast<BLOCKTYPE>(i / 16), static_cast<NIBBLETYPE>(i % 16));
+	}
+	TEST_EQUAL(testSection(palette, &all, &paletteLegacy, 13, true), 13);
+	TEST_EQUAL(testSection(palette, &all, &palette393, 14, false), 14);
+
+	// Metas that the 1.13 palette maps onto the same state share the palette entry:
+	sSection air;
+	for (size_t i = 0; i < ChunkBlockData::SectionBlockCount; i++)
+	{
+		air.set(i, E_BLOCK_AIR, static_cast<NIBBLETYPE>(i % 16));
+	}
+	TEST_EQUAL(testSection(palette, &air, &palette393, 14, false), 4);
+	TEST_EQUAL(palette.GetEntries().size(), 1);
+	TEST_EQUAL(testSection(palette, &air, &paletteLegacy, 13, true), 4);
+	TEST_EQUAL(palette.GetEntries().size(), 16);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("ChunkSectionPalette",
+	testTypicalSections();
+	testPaletteLimits();
+)
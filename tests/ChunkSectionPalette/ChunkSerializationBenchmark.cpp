@@ -0,0 +1,184 @@
+// ChunkSerializationBenchmark.cpp
+
+// Measures the cost of encoding the blocks of full chunks for each protocol version through cChunkSectionPalette, the way cChunkDataSerializer does,
+// mapping the blocks through the palette functions and through the BlockTables lookup tables
+
+#include "Globals.h"
+#include "BlockType.h"
+#include "ByteBuffer.h"
+#include "FastRandom.h"
+#include "Protocol/ChunkSectionPalette.h"
+#include "Protocol/Palettes/BlockTables.h"
+#include "Protocol/Palettes/Palette_1_13.h"
+#include "Protocol/Palettes/Palette_1_13_1.h"
+#include "Protocol/Palettes/Palette_1_14.h"
+#include "Protocol/Palettes/Upgrade.h"
+
+
+
+
+
+/** The number of chunks encoded in each measurement. */
+static const int NUM_CHUNKS = 200;
+
+/** The number of sections in a chunk. */
+static const size_t NUM_SECTIONS = 16;
+
+/** The blocks and metas of a single chunk section, in the format stored by ChunkBlockData. */
+struct sSection
+{
+	ChunkBlockData::BlockArray mBlocks{};
+	ChunkBlockData::MetaArray mMetas{};
+};
+
+
+
+
+
+/** Generates the sections of a terrain-like chunk: stone with ores at the bottom, then dirt, grass and air with a few plants. */
+static std::vector<sSection> generateChunk(int aSeed)
+{
+	cFastRandom random;
+	std::vector<sSection> res(NUM_SECTIONS);
+	for (size_t y = 0; y < NUM_SECTIONS * 16; y++)
+	{
+		auto & section = res[y / 16];
+		for (size_t i = 0; i < 256; i++)
+		{
+			auto idx = (y % 16) * 256 + i;
+			auto height = 60 + (static_cast<size_t>(aSeed) + i) % 8;
+			BLOCKTYPE block = E_BLOCK_AIR;
+			NIBBLETYPE meta = 0;
+			if (y < height - 4)
+			{
+				block = (random.RandInt(100) < 3) ? E_BLOCK_COAL_ORE : E_BLOCK_STONE;
+				meta = (block == E_BLOCK_STONE) ? static_cast<NIBBLETYPE>(random.RandInt(6)) : 0;
+			}
+			else if (y < height)
+			{
+				block = E_BLOCK_DIRT;
+			}
+			else if (y == height)
+			{
+				block = E_BLOCK_GRASS;
+			}
+			else if ((y == height + 1) && (random.RandInt(10) == 0))
+			{
+				block = E_BLOCK_TALL_GRASS;
+				meta = 1;
+			}
+			section.mBlocks[idx] = block;
+			cChunkDef::PackNibble(section.mMetas.data(), idx, meta);
+		}
+	}
+	return res;
+}
+
+
+
+
+
+/** Writes the block data of all the sections of the chunk, mapped through aPalette, the way cChunkDataSerializer does for 1.9+.
+aIsLegacy selects the 1.9 - 1.12 format, which has a palette length even for the global palette. */
+template <typename Palette>
+static void writeChunk(cChunkSectionPalette & aSectionPalette, const std::vector<sSection> & aChunk, UInt8 aGlobalBitsPerEntry, bool aIsLegacy, Palette aPalette, cByteBuffer & aOut)
+{
+	for (const auto & section: aChunk)
+	{
+		aSectionPalette.Build(&section.mBlocks, &section.mMetas, aPalette, aGlobalBitsPerEntry);
+		aSectionPalette.Write(aOut, aIsLegacy);
+	}
+}
+
+
+
+
+
+/** Encodes all the chunks through the palette and logs the time per chunk. Returns a checksum of the encoded data. */
+template <typename Palette>
+static UInt64 measure(const char * aName, const std::vector<std::vector<sSection>> & aChunks, UInt8 aGlobalBitsPerEntry, bool aIsLegacy, Palette aPalette)
+{
+	cChunkSectionPalette sectionPalette;
+	cByteBuffer out(1 MiB);
+	ContiguousByteBuffer data;
+	UInt64 res = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (const auto & chunk: aChunks)
+	{
+		writeChunk(sectionPalette, chunk, aGlobalBitsPerEntry, aIsLegacy, aPalette, out);
+		data.clear();
+		out.ReadAll(data);
+		out.CommitRead();
+		for (auto b: data)
+		{
+			res = res * 31 + static_cast<UInt64>(b);
+		}
+	}
+	auto us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	LOG("%-36s %8.1f us / chunk", aName, us / aChunks.size());
+	return res;
+}
+
+
+
+
+
+/** Measures the palette function and the lookup table of a single protocol version, and checks that they encode the same data. */
+template <UInt32 PaletteFn(BlockState)>
+static bool measureVersion(const char * aVersion, const std::vector<std::vector<sSection>> & aChunks, const BlockTables::Table & aTable)
+{
+	auto fnSum = measure(fmt::format("{}, palette functions", aVersion).c_str(), aChunks, 14, false, [](BLOCKTYPE aBlock, NIBBLETYPE aMeta)
+		{
+			return PaletteFn(PaletteUpgrade::FromBlock(aBlock, aMeta));
+		}
+	);
+	auto tableSum = measure(fmt::format("{}, lookup table", aVersion).c_str(), aChunks, 14, false, [&aTable](BLOCKTYPE aBlock, NIBBLETYPE aMeta)
+		{
+			return aTable[BlockTables::Index(aBlock, aMeta)];
+		}
+	);
+	if (fnSum != tableSum)
+	{
+		LOGERROR("The lookup table for %s encodes different data than the palette functions", aVersion);
+		return false;
+	}
+	return true;
+}
+
+
+
+
+
+int main()
+{
+	std::vector<std::vector<sSection>> chunks;
+	for (int i = 0; i < NUM_CHUNKS; i++)
+	{
+		chunks.push_back(generateChunk(i));
+	}
+	LOG("Chunk serialization benchmark started, %d chunks", NUM_CHUNKS);
+
+	// The tables are built on first use, measure that separately:
+	auto start = std::chrono::steady_clock::now();
+	BlockTables::From_1_13();
+	BlockTables::From_1_13_1();
+	BlockTables::From_1_14();
+	LOG("Building the lookup tables: %.2f ms", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+	// 1.9 - 1.12 use the legacy value directly:
+	measure("1.9 - 1.12, legacy value", chunks, 13, true, [](BLOCKTYPE aBlock, NIBBLETYPE aMeta)
+		{
+			return (aBlock << 4) | aMeta;
+		}
+	);
+
+	if (
+		!measureVersion<&Palette_1_13::From>("1.13", chunks, BlockTables::From_1_13()) ||
+		!measureVersion<&Palette_1_13_1::From>("1.13.1 - 1.13.2", chunks, BlockTables::From_1_13_1()) ||
+		!measureVersion<&Palette_1_14::From>("1.14", chunks, BlockTables::From_1_14())
+	)
+	{
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,131 @@
+// CompressionPolicyTest.cpp
+
+// Tests the cCompressionPolicy class: the network matching and the adaptive level tuning
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "Protocol/CompressionPolicy.h"
+#include "MemorySettingsRepository.h"
+
+
+
+
+
+/** Tests parsing the IPv4 networks. */
+static void testParseNetwork()
+{
+	UInt32 address = 0, mask = 0;
+	TEST_TRUE(cCompressionPolicy::ParseNetwork("10.1.2.3", address, mask));
+	TEST_EQUAL(address, 0x0a010203U);
+	TEST_EQUAL(mask, 0xffffffffU);
+	TEST_TRUE(cCompressionPolicy::ParseNetwork("192.168.77.1/16", address, mask));
+	TEST_EQUAL(address, 0xc0a80000U);
+	TEST_EQUAL(mask, 0xffff0000U);
+
+	TEST_FALSE(cCompressionPolicy::ParseNetwork("10.1.2", address, mask));
+	TEST_FALSE(cCompressionPolicy::ParseNetwork("10.1.2.256", address, mask));
+	TEST_FALSE(cCompressionPolicy::ParseNetwork("10.1..3", address, mask));
+	TEST_FALSE(cCompressionPolicy::ParseNetwork("10.1.2.3/0", address, mask));
+	TEST_FALSE(cCompressionPolicy::ParseNetwork("10.1.2.3/33", address, mask));
+	TEST_FALSE(cCompressionPolicy::ParseNetwork("::1", address, mask));
+}
+
+
+
+
+
+/** Tests that the connections from the configured networks don't use compression. */
+static void testIsEnabledFor()
+{
+	cMemorySettingsRepository settings;
+	settings.AddValue("Compression", "NoCompressionNetworks", AString("127.0.0.0/8, 10.1.2.3, ::1, invalid"));
+	cCompressionPolicy policy;
+	policy.Load(settings);
+
+	TEST_FALSE(policy.IsEnabledFor("127.0.0.1"));
+	TEST_FALSE(policy.IsEnabledFor("127.255.0.9"));
+	TEST_FALSE(policy.IsEnabledFor("::ffff:127.0.0.1"));
+	TEST_FALSE(policy.IsEnabledFor("10.1.2.3"));
+	TEST_FALSE(policy.IsEnabledFor("::1"));
+	TEST_TRUE(policy.IsEnabledFor("10.1.2.4"));
+	TEST_TRUE(policy.IsEnabledFor("128.0.0.1"));
+	TEST_TRUE(policy.IsEnabledFor("2001:db8::1"));
+
+	// The defaults compress everything:
+	cMemorySettingsRepository defaultSettings;
+	cCompressionPolicy defaultPolicy;
+	defaultPolicy.Load(defaultSettings);
+	TEST_TRUE(defaultPolicy.IsEnabledFor("127.0.0.1"));
+	TEST_EQUAL(defaultPolicy.GetThreshold(), 256U);
+	TEST_EQUAL(defaultPolicy.GetLevel(), 6);
+}
+
+
+
+
+
+/** Tests the adaptive level tuning rules. */
+static void testTuneLevel()
+{
+	cMemorySettingsRepository settings;
+	settings.AddValue("Compression", "Level", static_cast<Int64>(4));
+	settings.AddValue("Compression", "MinLevel", static_cast<Int64>(2));
+	settings.AddValue("Compression", "MaxLevel", static_cast<Int64>(6));
+	settings.AddValue("Compression", "CPUBudgetPercent", static_cast<Int64>(10));
+	cCompressionPolicy policy;
+	policy.Load(settings);
+
+	// Over the CPU budget, the level is lowered down to the minimum, even if the link is congested:
+	TEST_EQUAL(policy.TuneLevel(4, 0.2, true, false), 3);
+	TEST_EQUAL(policy.TuneLevel(2, 0.2, false, false), 2);
+
+	// A congested link raises the level up to the maximum:
+	TEST_EQUAL(policy.TuneLevel(4, 0.01, true, false), 5);
+	TEST_EQUAL(policy.TuneLevel(6, 0.01, true, false), 6);
+
+	// An idle link returns to the configured level, raising it only with a reserve in the CPU budget:
+	TEST_EQUAL(policy.TuneLevel(6, 0.01, false, true), 5);
+	TEST_EQUAL(policy.TuneLevel(2, 0.01, false, true), 3);
+	TEST_EQUAL(policy.TuneLevel(2, 0.07, false, true), 2);
+	TEST_EQUAL(policy.TuneLevel(4, 0.01, false, true), 4);
+
+	// Neither congested nor idle keeps the level:
+	TEST_EQUAL(policy.TuneLevel(5, 0.01, false, false), 5);
+
+	// A non-adaptive policy never changes the level:
+	cMemorySettingsRepository fixedSettings;
+	fixedSettings.AddValue("Compression", "Adaptive", false);
+	cCompressionPolicy fixedPolicy;
+	fixedPolicy.Load(fixedSettings);
+	TEST_EQUAL(fixedPolicy.TuneLevel(4, 0.5, true, false), 4);
+}
+
+
+
+
+
+/** Tests collecting and resetting the statistics. */
+static void testStats()
+{
+	cCompressionPolicy policy;
+	policy.AddStats(6, 1000, 400, std::chrono::microseconds(50));
+	policy.AddUncompressedStats(300);
+	auto stats = policy.GetStats(true);
+	TEST_NOTEQUAL(stats.find("level 6: 1 packets"), AString::npos);
+	TEST_NOTEQUAL(stats.find("no compression: 1 packets"), AString::npos);
+
+	// The statistics state that the chunk data doesn't follow the per-connection levels:
+	TEST_NOTEQUAL(stats.find("the chunk data is compressed once for each level in use"), AString::npos);
+	TEST_EQUAL(policy.GetStats(false).find("level 6"), AString::npos);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("CompressionPolicy",
+	testParseNetwork();
+	testIsEnabledFor();
+	testTuneLevel();
+	testStats();
+)
@@ -0,0 +1,113 @@
+// CraftingRecipesBenchmark.cpp
+
+// Measures the speed of the indexed recipe lookup over the full crafting.txt, against the original linear lookup
+
+#include "Globals.h"
+#include "CraftingRecipesTester.h"
+
+
+
+
+
+/** Number of times each grid is looked up. */
+static const int NUM_ROUNDS = 20;
+
+
+
+
+
+/** Returns the number of milliseconds elapsed since aStart. */
+static double msSince(std::chrono::steady_clock::time_point aStart)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - aStart).count();
+}
+
+
+
+
+
+/** Creates the grids to look up: every recipe at every offset, plus the same number of grids not matching anything. */
+static std::vector<std::array<cItem, 9>> createGrids(cCraftingRecipesTester & aRecipes)
+{
+	std::vector<std::array<cItem, 9>> res;
+	std::array<cItem, 9> grid;
+	for (size_t i = 0; i < aRecipes.GetNumRecipes(); i++)
+	{
+		for (int y = 0; y < 3; y++) for (int x = 0; x < 3; x++)
+		{
+			if (aRecipes.FillGridWithRecipe(i, x, y, grid.data()))
+			{
+				res.push_back(grid);
+
+				// Add an extra item to make a non-matching grid, as typically seen while the player is filling the grid:
+				for (auto & cell: grid)
+				{
+					if (cell.IsEmpty())
+					{
+						cell = cItem(E_BLOCK_DIRT);
+						res.push_back(grid);
+						break;
+					}
+				}
+			}
+		}
+	}
+	return res;
+}
+
+
+
+
+
+/** Looks up all the grids NUM_ROUNDS times using the specified lookup function, returns the number of recipes found. */
+template <typename LookupFn>
+static size_t lookUpAll(const std::vector<std::array<cItem, 9>> & aGrids, LookupFn aLookupFn)
+{
+	size_t numFound = 0;
+	for (int round = 0; round < NUM_ROUNDS; round++)
+	{
+		for (const auto & grid: aGrids)
+		{
+			std::unique_ptr<cCraftingRecipesTester::cRecipe> recipe(aLookupFn(grid.data()));
+			if (recipe != nullptr)
+			{
+				numFound += 1;
+			}
+		}
+	}
+	return numFound;
+}
+
+
+
+
+
+int main()
+{
+	LOG("CraftingRecipes benchmark started");
+
+	cCraftingRecipesTester recipes;
+	auto grids = createGrids(recipes);
+	LOG("Looking up %zu grids %d times", grids.size(), NUM_ROUNDS);
+
+	auto start = std::chrono::steady_clock::now();
+	auto numFoundLinear = lookUpAll(grids, [&recipes](const cItem * aGrid)
+		{
+			return recipes.FindRecipeLinear(aGrid, 3, 3);
+		}
+	);
+	auto linearMs = msSince(start);
+	LOG("Linear lookup:  %.1f ms (%zu found)", linearMs, numFoundLinear);
+
+	start = std::chrono::steady_clock::now();
+	auto numFoundIndexed = lookUpAll(grids, [&recipes](const cItem * aGrid)
+		{
+			return recipes.FindRecipe(aGrid, 3, 3);
+		}
+	);
+	auto indexedMs = msSince(start);
+	LOG("Indexed lookup: %.1f ms (%zu found)", indexedMs, numFoundIndexed);
+
+	LOG("Speedup: %.1fx", linearMs / indexedMs);
+	return (numFoundLinear == numFoundIndexed) ? 0 : 1;
+}
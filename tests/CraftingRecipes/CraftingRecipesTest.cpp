@@ -0,0 +1,150 @@
+// CraftingRecipesTest.cpp
+
+// Tests that the indexed recipe lookup in cCraftingRecipes finds the same recipes as the original linear lookup
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "CraftingRecipesTester.h"
+
+
+
+
+
+using cRecipePtr = std::unique_ptr<cCraftingRecipesTester::cRecipe>;
+
+
+
+
+
+/** Checks that the two recipes found by the different lookups are the same. */
+static void compareRecipes(const cRecipePtr & aIndexed, const cRecipePtr & aLinear)
+{
+	bool isIndexedFound = (aIndexed != nullptr);
+	bool isLinearFound = (aLinear != nullptr);
+	TEST_EQUAL(isIndexedFound, isLinearFound);
+	if (!isIndexedFound)
+	{
+		return;
+	}
+	TEST_EQUAL(aIndexed->m_Result.m_ItemType,   aLinear->m_Result.m_ItemType);
+	TEST_EQUAL(aIndexed->m_Result.m_ItemDamage, aLinear->m_Result.m_ItemDamage);
+	TEST_EQUAL(aIndexed->m_Result.m_ItemCount,  aLinear->m_Result.m_ItemCount);
+	TEST_EQUAL(aIndexed->m_Ingredients.size(),  aLinear->m_Ingredients.size());
+	for (size_t i = 0; i < aIndexed->m_Ingredients.size(); i++)
+	{
+		TEST_EQUAL(aIndexed->m_Ingredients[i].x, aLinear->m_Ingredients[i].x);
+		TEST_EQUAL(aIndexed->m_Ingredients[i].y, aLinear->m_Ingredients[i].y);
+	}
+}
+
+
+
+
+
+/** Tests that every recipe from crafting.txt, laid out at every possible offset, is found by both lookups the same way. */
+static void testAllRecipes(cCraftingRecipesTester & aRecipes)
+{
+	TEST_GREATER_THAN_OR_EQUAL(aRecipes.GetNumRecipes(), 100);
+	size_t numFound = 0;
+	cItem grid[9];
+	for (size_t i = 0; i < aRecipes.GetNumRecipes(); i++)
+	{
+		for (int y = 0; y < 3; y++) for (int x = 0; x < 3; x++)
+		{
+			if (!aRecipes.FillGridWithRecipe(i, x, y, grid))
+			{
+				continue;
+			}
+			cRecipePtr indexed(aRecipes.FindRecipe(grid, 3, 3));
+			cRecipePtr linear(aRecipes.FindRecipeLinear(grid, 3, 3));
+			compareRecipes(indexed, linear);
+			if (indexed != nullptr)
+			{
+				numFound += 1;
+			}
+		}
+	}
+	LOG("Found recipes for %zu recipe layouts", numFound);
+	TEST_GREATER_THAN_OR_EQUAL(numFound, aRecipes.GetNumRecipes());
+}
+
+
+
+
+
+/** Tests that grids mixing the ingredients of several recipes are resolved the same way by both lookups. */
+static void testRandomGrids(cCraftingRecipesTester & aRecipes)
+{
+	// Collect the ingredient items used in the recipes:
+	std::vector<cItem> items;
+	cItem grid[9];
+	for (size_t i = 0; i < aRecipes.GetNumRecipes(); i++)
+	{
+		if (aRecipes.FillGridWithRecipe(i, 0, 0, grid))
+		{
+			for (const auto & item: grid)
+			{
+				if (!item.IsEmpty())
+				{
+					items.push_back(item);
+				}
+			}
+		}
+	}
+
+	std::mt19937 rnd(1);
+	for (int i = 0; i < 20000; i++)
+	{
+		// Start with a recipe, then change a few cells:
+		if (!aRecipes.FillGridWithRecipe(rnd() % aRecipes.GetNumRecipes(), 0, 0, grid))
+		{
+			continue;
+		}
+		auto numChanges = rnd() % 3;
+		for (unsigned c = 0; c < numChanges; c++)
+		{
+			auto & cell = grid[rnd() % 9];
+			if ((rnd() % 3) == 0)
+			{
+				cell.Empty();
+			}
+			else
+			{
+				cell = items[rnd() % items.size()];
+			}
+		}
+		cRecipePtr indexed(aRecipes.FindRecipe(grid, 3, 3));
+		cRecipePtr linear(aRecipes.FindRecipeLinear(grid, 3, 3));
+		compareRecipes(indexed, linear);
+	}
+}
+
+
+
+
+
+/** Tests the grids that don't match anything. */
+static void testNoMatch(cCraftingRecipesTester & aRecipes)
+{
+	cItem grid[9];
+	cRecipePtr empty3x3(aRecipes.FindRecipe(grid, 3, 3));
+	TEST_TRUE(empty3x3 == nullptr);
+	cRecipePtr empty2x2(aRecipes.FindRecipe(grid, 2, 2));
+	TEST_TRUE(empty2x2 == nullptr);
+
+	// Bedrock is not craftable:
+	grid[4] = cItem(E_BLOCK_BEDROCK);
+	cRecipePtr bedrock(aRecipes.FindRecipe(grid, 3, 3));
+	TEST_TRUE(bedrock == nullptr);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("CraftingRecipes",
+	cCraftingRecipesTester recipes;
+	testAllRecipes(recipes);
+	testRandomGrids(recipes);
+	testNoMatch(recipes);
+)
@@ -0,0 +1,132 @@
+
+// CraftingRecipesTester.h
+
+// Declares the cCraftingRecipesTester class that exposes the recipe lookup of cCraftingRecipes to the tests
+// and provides the original linear lookup as the reference to compare against
+
+
+
+
+
+#pragma once
+
+#include "CraftingRecipes.h"
+
+
+
+
+
+class cCraftingRecipesTester:
+	public cCraftingRecipes
+{
+public:
+
+	using cCraftingRecipes::cRecipe;
+	using cCraftingRecipes::FindRecipe;
+
+	size_t GetNumRecipes(void) const { return m_Recipes.size(); }
+
+	/** Finds the recipe by walking all the recipes, as cCraftingRecipes did before using the index.
+	Same semantics as FindRecipeCropped(). */
+	cRecipe * FindRecipeCroppedLinear(const cItem * aCraftingGrid, int aGridWidth, int aGridHeight, int aGridStride)
+	{
+		for (const auto recipe: m_Recipes)
+		{
+			int maxOfsX = aGridWidth  - recipe->m_Width;
+			int maxOfsY = aGridHeight - recipe->m_Height;
+			for (int x = 0; x <= maxOfsX; x++) for (int y = 0; y <= maxOfsY; y++)
+			{
+				auto res = MatchRecipe(aCraftingGrid, aGridWidth, aGridHeight, aGridStride, recipe, x, y);
+				if (res != nullptr)
+				{
+					return res;
+				}
+			}
+		}
+		return nullptr;
+	}
+
+	/** Same as FindRecipe(), but using the linear lookup. */
+	cRecipe * FindRecipeLinear(const cItem * aCraftingGrid, int aGridWidth, int aGridHeight)
+	{
+		int left = MAX_GRID_WIDTH, top = MAX_GRID_HEIGHT;
+		int right = 0, bottom = 0;
+		for (int y = 0; y < aGridHeight; y++) for (int x = 0; x < aGridWidth; x++)
+		{
+			if (!aCraftingGrid[x + y * aGridWidth].IsEmpty())
+			{
+				right  = std::max(x, right);
+				bottom = std::max(y, bottom);
+				left   = std::min(x, left);
+				top    = std::min(y, top);
+			}
+		}
+		if ((right < left) || (bottom < top))
+		{
+			return nullptr;
+		}
+		auto res = FindRecipeCroppedLinear(aCraftingGrid + left + aGridWidth * top, right - left + 1, bottom - top + 1, aGridWidth);
+		if (res != nullptr)
+		{
+			for (auto & slot: res->m_Ingredients)
+			{
+				slot.x += left;
+				slot.y += top;
+			}
+		}
+		return res;
+	}
+
+	/** Fills the 3x3 grid with the ingredients of the specified recipe, shifted by the specified offset.
+	The "anywhere" ingredients are put into the first free cell they allow.
+	Returns false if the recipe doesn't fit the grid at that offset. */
+	bool FillGridWithRecipe(size_t aRecipeId, int aOffsetX, int aOffsetY, cItem * aGrid) const
+	{
+		const auto & recipe = *m_Recipes[aRecipeId];
+		if ((recipe.m_Width + aOffsetX > MAX_GRID_WIDTH) || (recipe.m_Height + aOffsetY > MAX_GRID_HEIGHT))
+		{
+			return false;
+		}
+		for (int i = 0; i < MAX_GRID_WIDTH * MAX_GRID_HEIGHT; i++)
+		{
+			aGrid[i].Empty();
+		}
+		auto makeItem = [](const cItem & aIngredient)
+		{
+			return cItem(aIngredient.m_ItemType, 1, std::max<short>(aIngredient.m_ItemDamage, 0));
+		};
+		for (const auto & slot: recipe.m_Ingredients)
+		{
+			if ((slot.x >= 0) && (slot.y >= 0))
+			{
+				aGrid[slot.x + aOffsetX + MAX_GRID_WIDTH * (slot.y + aOffsetY)] = makeItem(slot.m_Item);
+			}
+		}
+		for (const auto & slot: recipe.m_Ingredients)
+		{
+			if ((slot.x >= 0) && (slot.y >= 0))
+			{
+				continue;
+			}
+			bool placed = false;
+			for (int y = 0; (y < MAX_GRID_HEIGHT) && !placed; y++) for (int x = 0; (x < MAX_GRID_WIDTH) && !placed; x++)
+			{
+				if (
+					((slot.x >= 0) && (x != slot.x + aOffsetX)) ||
+					((slot.y >= 0) && (y != slot.y + aOffsetY)) ||
+					!aGrid[x + MAX_GRID_WIDTH * y].IsEmpty()
+				)
+				{
+					continue;
+				}
+				aGrid[x + MAX_GRID_WIDTH * y] = makeItem(slot.m_Item);
+				placed = true;
+			}
+			if (!placed)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+};
@@ -0,0 +1,147 @@
+// Stubs.cpp
+
+// Implements stubs of various Cuberite methods that are needed for linking but not for runtime
+// This is required so that we don't bring in the entire Cuberite via dependencies
+
+#include "Globals.h"
+#include "Item.h"
+#include "Root.h"
+#include "Bindings/PluginManager.h"
+
+
+
+
+
+decltype(cRoot::s_Root) cRoot::s_Root;
+
+
+
+
+
+cEnchantments::cEnchantments()
+{
+}
+
+
+
+
+
+cEnchantments::cEnchantments(const AString & a_StringSpec)
+{
+}
+
+
+
+
+
+void cEnchantments::Clear()
+{
+	m_Enchantments.clear();
+}
+
+
+
+
+
+cItem::cItem():
+	m_ItemType(E_ITEM_EMPTY),
+	m_ItemCount(0),
+	m_ItemDamage(0),
+	m_RepairCost(0)
+{
+}
+
+
+
+
+
+cItem::cItem(
+	short a_ItemType,
+	char a_ItemCount,
+	short a_ItemDamage,
+	const AString & a_Enchantments,
+	const AString & a_CustomName,
+	const AStringVector & a_LoreTable
+):
+	m_ItemType    (a_ItemType),
+	m_ItemCount   (a_ItemCount),
+	m_ItemDamage  (a_ItemDamage),
+	m_Enchantments(a_Enchantments),
+	m_CustomName  (a_CustomName),
+	m_LoreTable   (a_LoreTable),
+	m_RepairCost  (0)
+{
+}
+
+
+
+
+
+void cItem::Empty()
+{
+	m_ItemType = E_ITEM_EMPTY;
+	m_ItemCount = 0;
+	m_ItemDamage = 0;
+	m_Enchantments.Clear();
+	m_CustomName = "";
+	m_LoreTable.clear();
+	m_RepairCost = 0;
+	m_FireworkItem.EmptyData();
+	m_ItemColor.Clear();
+}
+
+
+
+
+
+void cItem::Clear()
+{
+	Empty();
+}
+
+
+
+
+
+cItem cItem::CopyOne(void) const
+{
+	cItem res(*this);
+	res.m_ItemCount = 1;
+	return res;
+}
+
+
+
+
+
+int cFireworkItem::GetVanillaColourCodeFromDye(NIBBLETYPE a_DyeMeta)
+{
+	return 0;
+}
+
+
+
+
+
+bool cPluginManager::CallHookPreCrafting(cPlayer & a_Player, cCraftingGrid & a_Grid, cCraftingRecipe & a_Recipe)
+{
+	return false;
+}
+
+
+
+
+
+bool cPluginManager::CallHookCraftingNoRecipe(cPlayer & a_Player, cCraftingGrid & a_Grid, cCraftingRecipe & a_Recipe)
+{
+	return false;
+}
+
+
+
+
+
+bool cPluginManager::CallHookPostCrafting(cPlayer & a_Player, cCraftingGrid & a_Grid, cCraftingRecipe & a_Recipe)
+{
+	return false;
+}
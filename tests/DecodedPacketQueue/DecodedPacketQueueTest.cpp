@@ -0,0 +1,176 @@
+// DecodedPacketQueueTest.cpp
+
+// Tests the cDecodedPacketQueue: the packet order, the size bound and the decoding errors handed over to the tick thread
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "Protocol/DecodedPacketQueue.h"
+
+
+
+
+
+using eError = cDecodedPacketQueue::eError;
+
+
+
+
+
+/** Returns a packet of the specified size, filled with the specified value. */
+static ContiguousByteBuffer makePacket(size_t aSize, unsigned char aValue)
+{
+	return ContiguousByteBuffer(aSize, static_cast<std::byte>(aValue));
+}
+
+
+
+
+
+/** Handles all the queued packets, appending them to aHandled. Returns the reported error. */
+static eError handleAll(cDecodedPacketQueue & aQueue, std::vector<ContiguousByteBuffer> & aHandled, AString & aErrorReason)
+{
+	return aQueue.HandleAll([&aHandled](const ContiguousByteBufferView aPacket)
+		{
+			aHandled.emplace_back(aPacket);
+		},
+		aErrorReason
+	);
+}
+
+
+
+
+
+/** Tests that the packets are handled in the order in which they were queued, including the empty ones. */
+static void testOrder()
+{
+	cDecodedPacketQueue queue(1000);
+	TEST_TRUE(queue.Push(makePacket(10, 1)));
+	TEST_TRUE(queue.Push(makePacket(0, 0)));
+	TEST_TRUE(queue.Push(makePacket(3, 2)));
+
+	std::vector<ContiguousByteBuffer> handled;
+	AString reason;
+	TEST_EQUAL(handleAll(queue, handled, reason), eError::None);
+	TEST_EQUAL(handled.size(), 3U);
+	TEST_TRUE(handled[0] == makePacket(10, 1));
+	TEST_TRUE(handled[1].empty());
+	TEST_TRUE(handled[2] == makePacket(3, 2));
+
+	// The handled packets are gone, the queue keeps working:
+	handled.clear();
+	TEST_EQUAL(handleAll(queue, handled, reason), eError::None);
+	TEST_TRUE(handled.empty());
+	TEST_TRUE(queue.Push(makePacket(5, 3)));
+	TEST_EQUAL(handleAll(queue, handled, reason), eError::None);
+	TEST_EQUAL(handled.size(), 1U);
+}
+
+
+
+
+
+/** Tests that overflowing the queue is reported once, after the packets queued before it, and stops the queueing. */
+static void testQueueFull()
+{
+	// Each packet takes its size plus 4 bytes of framing:
+	cDecodedPacketQueue queue(100);
+	TEST_TRUE(queue.Push(makePacket(46, 1)));
+	TEST_TRUE(queue.Push(makePacket(46, 2)));
+	TEST_FALSE(queue.HasError());
+	TEST_FALSE(queue.Push(makePacket(1, 3)));
+	TEST_TRUE(queue.HasError());
+
+	// Nothing is queued after the error, even if it would fit:
+	TEST_FALSE(queue.Push(makePacket(0, 0)));
+
+	std::vector<ContiguousByteBuffer> handled;
+	AString reason;
+	TEST_EQUAL(handleAll(queue, handled, reason), eError::QueueFull);
+	TEST_EQUAL(handled.size(), 2U);
+	TEST_TRUE(handled[1] == makePacket(46, 2));
+
+	// The error is reported only once:
+	TEST_EQUAL(handleAll(queue, handled, reason), eError::None);
+	TEST_EQUAL(handled.size(), 2U);
+}
+
+
+
+
+
+/** Tests that a decoding error carries its reason to the tick thread and isn't overwritten by a later error. */
+static void testMalformed()
+{
+	cDecodedPacketQueue queue(1000);
+	TEST_TRUE(queue.Push(makePacket(10, 1)));
+	queue.SetMalformed("Compression packet incomplete");
+	queue.SetQueueFull();
+	queue.SetMalformed("Something else");
+	TEST_FALSE(queue.Push(makePacket(10, 2)));
+
+	std::vector<ContiguousByteBuffer> handled;
+	AString reason;
+	TEST_EQUAL(handleAll(queue, handled, reason), eError::Malformed);
+	TEST_EQUAL(reason, "Compression packet incomplete");
+	TEST_EQUAL(handled.size(), 1U);
+}
+
+
+
+
+
+/** Tests the queue used from a decoding thread and a handling thread at once: all the packets arrive in order,
+and the error comes after the last packet. */
+static void testThreads()
+{
+	// The queue is large enough for all the packets, so that it never overflows, however the threads get scheduled:
+	static const UInt32 NumPackets = 20000;
+	cDecodedPacketQueue queue(2 MiB);
+
+	std::thread decoder([&queue]()
+		{
+			for (UInt32 i = 0; i < NumPackets; i++)
+			{
+				ContiguousByteBuffer packet(reinterpret_cast<const std::byte *>(&i), sizeof(i));
+				packet.append(i % 50, std::byte(0));
+				TEST_TRUE(queue.Push(packet));
+			}
+			queue.SetMalformed("Done");
+		}
+	);
+
+	UInt32 expected = 0;
+	AString reason;
+	eError error = eError::None;
+	while (error == eError::None)
+	{
+		error = queue.HandleAll([&expected](const ContiguousByteBufferView aPacket)
+			{
+				UInt32 number;
+				TEST_GREATER_THAN_OR_EQUAL(aPacket.size(), sizeof(number));
+				memcpy(&number, aPacket.data(), sizeof(number));
+				TEST_EQUAL(number, expected);
+				TEST_EQUAL(aPacket.size(), sizeof(number) + number % 50);
+				expected += 1;
+			},
+			reason
+		);
+	}
+	decoder.join();
+
+	TEST_EQUAL(error, eError::Malformed);
+	TEST_EQUAL(reason, "Done");
+	TEST_EQUAL(expected, NumPackets);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("DecodedPacketQueue",
+	testOrder();
+	testQueueFull();
+	testMalformed();
+	testThreads();
+)
@@ -0,0 +1,207 @@
+// ExplodinatorBenchmark.cpp
+
+// Measures the tracing of chain TNT, hundreds of explosions within a single tick, one by one and as a single batch
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "OSSupport/ThreadPool.h"
+#include "TestWorld.h"
+
+
+
+
+
+/** The number of the chunks around the chunk (0, 0), in each direction, in the benchmarked world. */
+static const int WORLD_RADIUS = 4;
+
+/** The number of the explosions within the tick. */
+static const size_t NUM_EXPLOSIONS = 400;
+
+/** The power of the exploding TNT. */
+static const int TNT_POWER = 4;
+
+/** The number of times each measurement is repeated, the shortest one counts. */
+static const int NUM_REPEATS = 5;
+
+
+
+
+
+/** An explosion within the benchmarked tick. */
+struct sExplosion
+{
+	cChunkCoords mChunk;
+
+	/** The centre of the explosion, relative to mChunk. */
+	Vector3f mPosition;
+
+	std::vector<float> mIntensities;
+};
+
+
+
+
+
+/** Creates the world, with TNT filling the blocks at heights 32 to 95 and air elsewhere. */
+static std::unique_ptr<cTestWorld> makeTntWorld()
+{
+	auto world = std::make_unique<cTestWorld>(0, WORLD_RADIUS);
+	world->Fill(E_BLOCK_AIR);
+	for (auto & chunk: world->mChunks)
+	{
+		auto & blocks = chunk.second.mBlocks;
+		std::fill(blocks.begin() + cChunkDef::MakeIndex(0, 32, 0), blocks.begin() + cChunkDef::MakeIndex(0, 96, 0), E_BLOCK_TNT);
+	}
+	return world;
+}
+
+
+
+
+
+/** Returns the explosions within aSize blocks around the centre of the chunk (0, 0), with the rays' intensities drawn. */
+static std::vector<sExplosion> makeExplosions(float aSize)
+{
+	std::minstd_rand random(1);
+	std::uniform_real_distribution<float> horizontal(8 - aSize / 2, 8 + aSize / 2);
+	std::uniform_real_distribution<float> vertical(40, 88);
+	std::uniform_real_distribution<float> intensity(0.7f * TNT_POWER, 1.3f * TNT_POWER);
+	std::vector<sExplosion> res;
+	for (size_t i = 0; i < NUM_EXPLOSIONS; i++)
+	{
+		const Vector3f position(horizontal(random), vertical(random), horizontal(random));
+		const auto chunk = cChunkDef::BlockToChunk(position.Floor());
+		sExplosion explosion{ chunk, { position.x - chunk.m_ChunkX * cChunkDef::Width, position.y, position.z - chunk.m_ChunkZ * cChunkDef::Width }, {} };
+		for (size_t ray = 0; ray < Explodinator::NumRays; ray++)
+		{
+			explosion.mIntensities.push_back(intensity(random));
+		}
+		res.push_back(std::move(explosion));
+	}
+	return res;
+}
+
+
+
+
+
+/** Runs the operation on a fresh world NUM_REPEATS times and returns the shortest duration, in milliseconds. */
+template <typename Fn>
+static double measure(Fn aFn)
+{
+	double res = std::numeric_limits<double>::max();
+	for (int i = 0; i < NUM_REPEATS; i++)
+	{
+		auto world = makeTntWorld();
+		auto start = std::chrono::steady_clock::now();
+		aFn(*world);
+		res = std::min(res, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	return res;
+}
+
+
+
+
+
+/** Traces all the explosions one after another, with the original tracing, as Kaboom() did before. */
+static void traceOriginal(cTestWorld & aWorld, const std::vector<sExplosion> & aExplosions)
+{
+	for (const auto & explosion: aExplosions)
+	{
+		size_t ray = 0;
+		Explodinator::ForEachRayDirection([&](const Vector3f aDirection)
+		{
+			OriginalExplodinator::DestructionTrace(
+				aWorld.FindChunk(explosion.mChunk.m_ChunkX, explosion.mChunk.m_ChunkZ), explosion.mPosition, aDirection,
+				TNT_POWER, false, explosion.mIntensities[ray], nullptr
+			);
+			ray += 1;
+		});
+	}
+}
+
+
+
+
+
+/** Traces all the explosions as a single batch, including taking the snapshot. Returns the number of the destroyed blocks. */
+static size_t traceBatch(cTestWorld & aWorld, const std::vector<sExplosion> & aExplosions, cThreadPool & aPool, size_t & aSnapshotBytes)
+{
+	std::vector<Explodinator::sBlast> blasts;
+	for (const auto & explosion: aExplosions)
+	{
+		blasts.push_back({ explosion.mChunk, explosion.mPosition, TNT_POWER, explosion.mIntensities, {} });
+	}
+	Explodinator::cBlastSnapshot snapshot(blasts);
+	aWorld.FillSnapshot(snapshot);
+	Explodinator::TraceBlasts(snapshot, blasts, aPool);
+	aSnapshotBytes = snapshot.GetNumBytes();
+
+	size_t res = 0;
+	for (const auto & blast: blasts)
+	{
+		res += blast.m_Destroyed.size();
+	}
+	return res;
+}
+
+
+
+
+
+/** Benchmarks the explosions spread over aSize blocks of the TNT-filled world. */
+static void benchmark(const char * aName, float aSize)
+{
+	const auto explosions = makeExplosions(aSize);
+
+	size_t numDestroyed = 0;
+	const auto originalMs = measure([&](cTestWorld & aWorld)
+	{
+		traceOriginal(aWorld, explosions);
+		numDestroyed = aWorld.mDestroyed.size();
+	});
+
+	cThreadPool serial(0);
+	size_t snapshotBytes = 0;
+	size_t numBatchDestroyed = 0;
+	const auto serialMs = measure([&](cTestWorld & aWorld)
+	{
+		numBatchDestroyed = traceBatch(aWorld, explosions, serial, snapshotBytes);
+	});
+	if (numBatchDestroyed != numDestroyed)
+	{
+		LOGERROR("%s: The batch destroyed %u blocks instead of %u", aName, static_cast<unsigned>(numBatchDestroyed), static_cast<unsigned>(numDestroyed));
+	}
+
+	auto & parallel = cThreadPool::Get();
+	const auto parallelMs = measure([&](cTestWorld & aWorld)
+	{
+		traceBatch(aWorld, explosions, parallel, snapshotBytes);
+	});
+
+	LOG("%s: %u explosions, %u blocks destroyed, snapshot of %u KiB", aName,
+		static_cast<unsigned>(explosions.size()), static_cast<unsigned>(numDestroyed), static_cast<unsigned>(snapshotBytes / 1024)
+	);
+	LOG("  one by one (original)  %8.1f ms", originalMs);
+	LOG("  batch, serial          %8.1f ms", serialMs);
+	LOG("  batch, %2u threads      %8.1f ms", static_cast<unsigned>(parallel.GetConcurrency()), parallelMs);
+}
+
+
+
+
+
+int main()
+{
+	LOG("Explodinator benchmark started, %u hardware threads", std::thread::hardware_concurrency());
+
+	// A TNT cannon, all the explosions overlap:
+	benchmark("Cannon", 8);
+
+	// TNT spread over several chunks, groups of the explosions don't overlap:
+	benchmark("Spread", 2 * WORLD_RADIUS * cChunkDef::Width - 16);
+
+	LOG("Explodinator benchmark finished");
+	return 0;
+}
@@ -0,0 +1,241 @@
+// ExplodinatorTest.cpp
+
+// Tests the explosion ray tracing, of single explosions and of batches, against the original implementation
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "OSSupport/ThreadPool.h"
+#include "TestWorld.h"
+
+
+
+
+
+/** Draws the intensities of the rays of an explosion, in the order of the rays. */
+static std::vector<float> randomIntensities(std::minstd_rand & aRandom, int aPower)
+{
+	std::uniform_real_distribution<float> Intensity(0.7f * aPower, 1.3f * aPower);
+	std::vector<float> Res;
+	for (size_t i = 0; i < Explodinator::NumRays; i++)
+	{
+		Res.push_back(Intensity(aRandom));
+	}
+	return Res;
+}
+
+
+
+
+
+/** Explodes the same world with both the original and the current tracing, and checks that they destroy the same blocks in the same order.
+aPosition is relative to the exploding chunk (0, 0). */
+static void testMatchesOriginal(unsigned aSeed, const Vector3f aPosition, int aPower, const std::set<std::pair<int, int>> & aUnloaded = {})
+{
+	const auto Radius = Explodinator::GetMaximumReach(aPower) / cChunkDef::Width + 1;
+	cTestWorld Original(aSeed, Radius, aUnloaded);
+	cTestWorld Current(aSeed, Radius, aUnloaded);
+
+	// The exploding TNT has left its block empty:
+	*Original.FindBlock(aPosition.Floor()) = E_BLOCK_AIR;
+	*Current.FindBlock(aPosition.Floor()) = E_BLOCK_AIR;
+
+	// Both get the same random intensities, in the same order:
+	std::minstd_rand Random(aSeed);
+	const auto Intensities = randomIntensities(Random, aPower);
+	size_t NumRays = 0;
+	Explodinator::ForEachRayDirection([&](const Vector3f aDirection)
+	{
+		OriginalExplodinator::DestructionTrace(Original.FindChunk(0, 0), aPosition, aDirection, aPower, false, Intensities[NumRays], nullptr);
+		Explodinator::TraceRay(Current, aPosition, aDirection, Intensities[NumRays]);
+		NumRays += 1;
+	});
+
+	TEST_EQUAL(NumRays, Explodinator::NumRays);
+	TEST_TRUE(!Original.mDestroyed.empty());
+	TEST_EQUAL(Current.mDestroyed.size(), Original.mDestroyed.size());
+	TEST_TRUE(Current.mDestroyed == Original.mDestroyed);
+	TEST_TRUE(Current.HasSameBlocks(Original));
+}
+
+
+
+
+
+/** Explodes random positions within the chunk (0, 0) with both the original and the current tracing. */
+static void testMatchesOriginalRandom()
+{
+	std::minstd_rand Random(42);
+	std::uniform_real_distribution<float> Horizontal(0, cChunkDef::Width);
+	std::uniform_real_distribution<float> Vertical(1, cChunkDef::Height - 1);
+	for (unsigned Seed = 10; Seed < 30; Seed++)
+	{
+		testMatchesOriginal(Seed, { Horizontal(Random), Vertical(Random), Horizontal(Random) }, 4);
+	}
+}
+
+
+
+
+
+/** Explodes a batch of explosions, some of them overlapping, one after another with the original tracing,
+and all at once with TraceBlasts() on a_Pool. Checks that both destroy the same blocks, in the same order for each explosion. */
+static void testBatchMatchesOriginal(unsigned aSeed, cThreadPool & aPool)
+{
+	const std::set<std::pair<int, int>> Unloaded = {{2, -2}};
+	cTestWorld Original(aSeed, 3, Unloaded);
+	cTestWorld Current(aSeed, 3, Unloaded);
+
+	// A chain of overlapping explosions, two separate ones and one next to the unloaded chunk:
+	const std::vector<std::pair<Vector3f, int>> Explosions =
+	{
+		{{  8.5f,  64.5f,   8.5f}, 4},
+		{{ 10.5f,  63.5f,   6.5f}, 4},
+		{{-20.5f, 100.5f, -20.5f}, 4},
+		{{ 12.5f,  66.5f,  17.5f}, 4},
+		{{ 30.5f,  64.5f, -17.5f}, 3},
+		{{ -1.5f,  64.5f,   7.5f}, 5},
+		{{ 40.5f,   3.5f,  40.5f}, 4},
+		{{  9.5f,  64.5f,   8.5f}, 4},
+	};
+
+	std::minstd_rand Random(aSeed);
+	std::vector<Explodinator::sBlast> Blasts;
+	std::vector<std::vector<Vector3i>> OriginalDestroyed;
+	for (const auto & Explosion: Explosions)
+	{
+		const auto Position = Explosion.first;
+		const auto Power = Explosion.second;
+		const auto Chunk = cChunkDef::BlockToChunk(Position.Floor());
+		const Vector3f Relative(Position.x - Chunk.m_ChunkX * cChunkDef::Width, Position.y, Position.z - Chunk.m_ChunkZ * cChunkDef::Width);
+		Blasts.push_back({ Chunk, Relative, Power, randomIntensities(Random, Power), {} });
+
+		size_t Ray = 0;
+		Original.mDestroyed.clear();
+		Explodinator::ForEachRayDirection([&](const Vector3f aDirection)
+		{
+			OriginalExplodinator::DestructionTrace(Original.FindChunk(Chunk.m_ChunkX, Chunk.m_ChunkZ), Relative, aDirection, Power, false, Blasts.back().m_Intensities[Ray], nullptr);
+			Ray += 1;
+		});
+		OriginalDestroyed.push_back(Original.mDestroyed);
+	}
+
+	Explodinator::cBlastSnapshot Snapshot(Blasts);
+	Current.FillSnapshot(Snapshot);
+	Explodinator::TraceBlasts(Snapshot, Blasts, aPool);
+
+	// Apply the blasts to the world, checking that they destroy each block only once:
+	for (size_t i = 0; i < Blasts.size(); i++)
+	{
+		const auto & Blast = Blasts[i];
+		std::vector<Vector3i> Destroyed;
+		for (const auto & Position: Blast.m_Destroyed)
+		{
+			Destroyed.push_back(Position.addedXZ(Blast.m_Chunk.m_ChunkX * cChunkDef::Width, Blast.m_Chunk.m_ChunkZ * cChunkDef::Width));
+			Current.DestroyBlock(Destroyed.back());
+		}
+		TEST_TRUE(!Destroyed.empty());
+		TEST_EQUAL(Destroyed.size(), OriginalDestroyed[i].size());
+		TEST_TRUE(Destroyed == OriginalDestroyed[i]);
+	}
+	TEST_TRUE(Current.HasSameBlocks(Original));
+}
+
+
+
+
+
+/** Tests that the snapshot covers only the chunks and sections within the blasts' reach. */
+static void testSnapshotBounds()
+{
+	std::vector<Explodinator::sBlast> Blasts;
+	Blasts.push_back({ {0, 0}, {8.5f, 64.5f, 8.5f}, 4, {}, {} });
+	Explodinator::cBlastSnapshot Single(Blasts);
+	TEST_EQUAL(Single.GetChunkCoords().size(), 1U);
+	TEST_EQUAL(Single.GetMinSection(), 3);
+	TEST_EQUAL(Single.GetMaxSection(), 4);
+
+	// The chunks not filled in are not available:
+	TEST_EQUAL(Single.GetNumBytes(), 0U);
+	TEST_EQUAL(Single.GetChunkBlocks({0, 0}), nullptr);
+	Single.SetSection({0, 0}, 3, nullptr);
+	TEST_NOTEQUAL(Single.GetChunkBlocks({0, 0}), nullptr);
+	TEST_EQUAL(Single.GetNumBytes(), 2U * cChunkDef::SectionHeight * cChunkDef::Width * cChunkDef::Width);
+
+	// A blast at the chunk's corner and the bottom of the world reaches its neighbours, and no more sections:
+	Blasts.push_back({ {5, 5}, {0.5f, 1.5f, 0.5f}, 4, {}, {} });
+	Explodinator::cBlastSnapshot Two(Blasts);
+	TEST_EQUAL(Two.GetChunkCoords().size(), 5U);
+	TEST_EQUAL(Two.GetMinSection(), 0);
+	TEST_EQUAL(Two.GetMaxSection(), 4);
+}
+
+
+
+
+
+/** Tests that a ray sees the blocks destroyed by the rays traced before it, and can reach further because of them. */
+static void testLaterRaysSeeDestruction()
+{
+	cTestWorld World(0, 1);
+	World.Fill(E_BLOCK_STONE);
+
+	// Two identical rays along the X axis, the second one continues where the first one cleared the way:
+	const Vector3f Origin(0.5f, 64.5f, 0.5f);
+	Explodinator::TraceRay(World, Origin, {1, 0, 0}, 4);
+	const auto NumFirst = World.mDestroyed.size();
+	TEST_GREATER_THAN_OR_EQUAL(NumFirst, 1U);
+	Explodinator::TraceRay(World, Origin, {1, 0, 0}, 4);
+	TEST_GREATER_THAN_OR_EQUAL(World.mDestroyed.size(), NumFirst + 1);
+	for (size_t i = 0; i < World.mDestroyed.size(); i++)
+	{
+		TEST_EQUAL(World.mDestroyed[i], Vector3i(static_cast<int>(i), 64, 0));
+	}
+}
+
+
+
+
+
+/** Tests that the rays stop at unloaded chunks and at the vertical bounds of the world. */
+static void testBounds()
+{
+	// Only the exploding chunk is loaded, all of it air, so the rays are only stopped by the bounds:
+	cTestWorld World(0, 0);
+	World.Fill(E_BLOCK_AIR);
+	*World.FindBlock({15, 1, 0}) = E_BLOCK_DIRT;
+	*World.FindBlock({5, 0, 5}) = E_BLOCK_DIRT;
+
+	// A strong ray along the X axis reaches the edge of the chunk and stops there:
+	Explodinator::TraceRay(World, {0.5f, 1.5f, 0.5f}, {1, 0, 0}, 100);
+	TEST_EQUAL(World.mDestroyed.size(), 1U);
+	TEST_EQUAL(World.mDestroyed[0], Vector3i(15, 1, 0));
+
+	// A ray straight down destroys the bottom block and leaves the world:
+	Explodinator::TraceRay(World, {5.5f, 3.5f, 5.5f}, {0, -1, 0}, 100);
+	TEST_EQUAL(World.mDestroyed.size(), 2U);
+	TEST_EQUAL(World.mDestroyed[1], Vector3i(5, 0, 5));
+
+	// A ray going up doesn't wrap around:
+	Explodinator::TraceRay(World, {0.5f, 250.5f, 15.5f}, {0, 1, 0}, 100);
+	TEST_EQUAL(World.mDestroyed.size(), 2U);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("Explodinator",
+	testMatchesOriginal(1, {8.5f, 64.5f, 8.5f}, 4);
+	testMatchesOriginal(2, {0.5f, 64.5f, 15.5f}, 4);
+	testMatchesOriginal(3, {-0.5f, 2.5f, 0.5f}, 10, {{1, 0}, {-1, -1}});
+	testMatchesOriginal(4, {15.9f, 254.5f, 0.1f}, 6, {{1, 1}});
+	testMatchesOriginalRandom();
+	testLaterRaysSeeDestruction();
+	testBounds();
+	testSnapshotBounds();
+	cThreadPool Serial(0);
+	cThreadPool Parallel(3);
+	testBatchMatchesOriginal(5, Serial);
+	testBatchMatchesOriginal(5, Parallel);
+	testBatchMatchesOriginal(6, Parallel);
+)
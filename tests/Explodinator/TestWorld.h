@@ -0,0 +1,308 @@
+// TestWorld.h
+
+// Declares the cTestWorld class, a few chunks of random blocks to explode, and the original explosion tracing to compare with
+
+/*
+The OriginalExplodinator namespace contains DestructionTrace() and RebaseRelativePosition() exactly as they were in
+Explodinator.cpp before the tracing was moved to ExplosionTracer.h, only with cChunk replaced by cTestChunk, which
+provides the same interface, and DestroyBlock() reduced to destroying the block in the test world.
+TestHelpers.h needs to be included before this file.
+*/
+
+
+
+
+
+#pragma once
+
+#include "Physics/ExplosionTracer.h"
+#include "Physics/ExplosionBatch.h"
+
+// fwd:
+class cEntity;
+class cTestWorld;
+
+
+
+
+
+/** A single chunk of the test world, provides the part of the cChunk interface used by the original tracing. */
+class cTestChunk
+{
+public:
+
+	cTestChunk(cTestWorld & aWorld, int aChunkX, int aChunkZ):
+		mWorld(aWorld),
+		mChunkX(aChunkX),
+		mChunkZ(aChunkZ),
+		mBlocks(cChunkDef::NumBlocks, E_BLOCK_AIR)
+	{
+	}
+
+	cChunkCoords GetPos() const { return { mChunkX, mChunkZ }; }
+
+	bool IsValid() const { return true; }
+
+	BLOCKTYPE GetBlock(Vector3i aRelPos) const { return mBlocks[static_cast<size_t>(cChunkDef::MakeIndex(aRelPos.x, aRelPos.y, aRelPos.z))]; }
+
+	/** Returns the chunk containing the position relative to this chunk, and adjusts the position to be relative to it.
+	Returns nullptr if the chunk isn't loaded. */
+	cTestChunk * GetRelNeighborChunkAdjustCoords(Vector3i & aRelPos) const;
+
+	/** Destroys the block at the position relative to this chunk, and records it in the world. */
+	void DestroyBlock(Vector3i aRelPos);
+
+	cTestWorld & mWorld;
+	int mChunkX;
+	int mChunkZ;
+	std::vector<BLOCKTYPE> mBlocks;
+};
+
+
+
+
+
+/** A few chunks of blocks around the chunk (0, 0); the coords are absolute.
+Serves as the block source for Explodinator::TraceRay(), for explosions in the chunk (0, 0), and records the blocks it destroys. */
+class cTestWorld
+{
+public:
+
+	/** Creates the chunks within aRadius of the chunk (0, 0), except the ones in aUnloaded, filled with random blocks. */
+	cTestWorld(unsigned aSeed, int aRadius, const std::set<std::pair<int, int>> & aUnloaded = {})
+	{
+		static const BLOCKTYPE Blocks[] =
+		{
+			E_BLOCK_AIR, E_BLOCK_AIR, E_BLOCK_AIR, E_BLOCK_DIRT, E_BLOCK_STONE, E_BLOCK_SAND, E_BLOCK_WATER, E_BLOCK_OBSIDIAN, E_BLOCK_PLANKS, E_BLOCK_BEDROCK
+		};
+		std::minstd_rand Random(aSeed);
+		for (int ChunkZ = -aRadius; ChunkZ <= aRadius; ChunkZ++)
+		{
+			for (int ChunkX = -aRadius; ChunkX <= aRadius; ChunkX++)
+			{
+				if (aUnloaded.count({ChunkX, ChunkZ}) > 0)
+				{
+					continue;
+				}
+				auto & Chunk = mChunks.emplace(std::piecewise_construct, std::forward_as_tuple(ChunkX, ChunkZ), std::forward_as_tuple(*this, ChunkX, ChunkZ)).first->second;
+				for (auto & Block: Chunk.mBlocks)
+				{
+					Block = Blocks[Random() % ARRAYCOUNT(Blocks)];
+				}
+			}
+		}
+	}
+
+	cTestWorld(const cTestWorld &) = delete;
+
+	/** Fills all the loaded chunks with the specified block. */
+	void Fill(BLOCKTYPE aBlock)
+	{
+		for (auto & Chunk: mChunks)
+		{
+			std::fill(Chunk.second.mBlocks.begin(), Chunk.second.mBlocks.end(), aBlock);
+		}
+	}
+
+	cTestChunk * GetChunk(int aChunkX, int aChunkZ)
+	{
+		return FindChunk(aChunkX, aChunkZ);
+	}
+
+	static BLOCKTYPE GetBlock(const cTestChunk & aChunk, const Vector3i aRelPos)
+	{
+		return aChunk.GetBlock(aRelPos);
+	}
+
+	static void DestroyBlock(cTestChunk & aChunk, const Vector3i aRelPos)
+	{
+		aChunk.DestroyBlock(aRelPos);
+	}
+
+	/** Destroys the (non-air) block at the absolute position and records it. */
+	void DestroyBlock(const Vector3i aPosition)
+	{
+		auto Block = FindBlock(aPosition);
+		TEST_NOTEQUAL(Block, nullptr);
+		TEST_NOTEQUAL(*Block, E_BLOCK_AIR);
+		*Block = E_BLOCK_AIR;
+		mDestroyed.push_back(aPosition);
+	}
+
+	/** Returns the chunk with the specified coords, or nullptr if it isn't loaded. */
+	cTestChunk * FindChunk(int aChunkX, int aChunkZ)
+	{
+		auto itr = mChunks.find({aChunkX, aChunkZ});
+		return (itr == mChunks.end()) ? nullptr : &itr->second;
+	}
+
+	/** Returns the block at the specified position, or nullptr if its chunk isn't loaded. */
+	BLOCKTYPE * FindBlock(const Vector3i aPosition)
+	{
+		const auto ChunkX = FAST_FLOOR_DIV(aPosition.x, cChunkDef::Width);
+		const auto ChunkZ = FAST_FLOOR_DIV(aPosition.z, cChunkDef::Width);
+		auto Chunk = FindChunk(ChunkX, ChunkZ);
+		if (Chunk == nullptr)
+		{
+			return nullptr;
+		}
+		const auto Index = cChunkDef::MakeIndex(aPosition.x - ChunkX * cChunkDef::Width, aPosition.y, aPosition.z - ChunkZ * cChunkDef::Width);
+		return &Chunk->mBlocks[static_cast<size_t>(Index)];
+	}
+
+	/** Returns true if both worlds have the same chunks loaded, with the same blocks. */
+	bool HasSameBlocks(const cTestWorld & aOther) const
+	{
+		return std::equal(mChunks.begin(), mChunks.end(), aOther.mChunks.begin(), aOther.mChunks.end(),
+			[](const auto & aChunk1, const auto & aChunk2)
+			{
+				return (aChunk1.first == aChunk2.first) && (aChunk1.second.mBlocks == aChunk2.second.mBlocks);
+			}
+		);
+	}
+
+	/** Copies the sections of the loaded chunks that the snapshot wants into it. */
+	void FillSnapshot(Explodinator::cBlastSnapshot & aSnapshot)
+	{
+		const auto SectionBlockCount = cChunkDef::SectionHeight * cChunkDef::Width * cChunkDef::Width;
+		for (const auto & Coords: aSnapshot.GetChunkCoords())
+		{
+			const auto Chunk = FindChunk(Coords.m_ChunkX, Coords.m_ChunkZ);
+			if (Chunk == nullptr)
+			{
+				continue;
+			}
+			for (int Y = aSnapshot.GetMinSection(); Y <= aSnapshot.GetMaxSection(); Y++)
+			{
+				aSnapshot.SetSection(Coords, Y, Chunk->mBlocks.data() + Y * SectionBlockCount);
+			}
+		}
+	}
+
+	/** The loaded chunks. */
+	std::map<std::pair<int, int>, cTestChunk> mChunks;
+
+	/** The absolute positions of the destroyed blocks, in the order in which they were destroyed. */
+	std::vector<Vector3i> mDestroyed;
+};
+
+
+
+
+
+inline cTestChunk * cTestChunk::GetRelNeighborChunkAdjustCoords(Vector3i & aRelPos) const
+{
+	// The most common case, inside this chunk, is just as fast as in cChunk:
+	if (
+		(aRelPos.x >= 0) && (aRelPos.x < cChunkDef::Width) &&
+		(aRelPos.z >= 0) && (aRelPos.z < cChunkDef::Width)
+	)
+	{
+		return const_cast<cTestChunk *>(this);
+	}
+
+	const auto AbsX = aRelPos.x + mChunkX * cChunkDef::Width;
+	const auto AbsZ = aRelPos.z + mChunkZ * cChunkDef::Width;
+	const auto ChunkX = FAST_FLOOR_DIV(AbsX, cChunkDef::Width);
+	const auto ChunkZ = FAST_FLOOR_DIV(AbsZ, cChunkDef::Width);
+	const auto Chunk = mWorld.FindChunk(ChunkX, ChunkZ);
+	if (Chunk != nullptr)
+	{
+		aRelPos.x = AbsX - ChunkX * cChunkDef::Width;
+		aRelPos.z = AbsZ - ChunkZ * cChunkDef::Width;
+	}
+	return Chunk;
+}
+
+
+
+
+
+inline void cTestChunk::DestroyBlock(const Vector3i aRelPos)
+{
+	mWorld.DestroyBlock(aRelPos.addedXZ(mChunkX * cChunkDef::Width, mChunkZ * cChunkDef::Width));
+}
+
+
+
+
+
+namespace OriginalExplodinator
+{
+	using Explodinator::StepUnit;
+	using Explodinator::StepAttenuation;
+	using Explodinator::GetExplosionAbsorption;
+
+	/** The original DestroyBlock(), reduced to destroying the block in the test world. */
+	static void DestroyBlock(cTestChunk & a_Chunk, const Vector3i a_Position, const int a_Power, const bool a_Fiery, const cEntity * const a_ExplodingEntity)
+	{
+		UNUSED(a_Power);
+		UNUSED(a_Fiery);
+		UNUSED(a_ExplodingEntity);
+
+		const auto DestroyedBlock = a_Chunk.GetBlock(a_Position);
+		if (DestroyedBlock == E_BLOCK_AIR)
+		{
+			// There's nothing left for us here, but a barren and empty land
+			// Let's go.
+			return;
+		}
+
+		a_Chunk.DestroyBlock(a_Position);
+	}
+
+	/** Make a From Chunk-relative Position into a To Chunk-relative position. */
+	static Vector3f RebaseRelativePosition(const cChunkCoords a_From, const cChunkCoords a_To, const Vector3f a_Position)
+	{
+		return
+		{
+			a_Position.x + (a_From.m_ChunkX - a_To.m_ChunkX) * cChunkDef::Width,
+			a_Position.y,
+			a_Position.z + (a_From.m_ChunkZ - a_To.m_ChunkZ) * cChunkDef::Width
+		};
+	}
+
+	/** Traces the path taken by one Explosion Lazor (tm) with given direction and intensity, that will destroy blocks until it is exhausted. */
+	static void DestructionTrace(cTestChunk * a_Chunk, Vector3f a_Origin, const Vector3f a_Direction, const int a_Power, const bool a_Fiery, float a_Intensity, const cEntity * const a_ExplodingEntity)
+	{
+		// The current position the ray is at.
+		auto Checkpoint = a_Origin;
+
+		// The displacement that the ray in one iteration step should travel.
+		const auto Step = a_Direction.NormalizeCopy() * StepUnit;
+
+		// Loop until intensity runs out:
+		while (a_Intensity > 0)
+		{
+			auto Position = Checkpoint.Floor();
+			if (!cChunkDef::IsValidHeight(Position.y))
+			{
+				break;
+			}
+
+			const auto Neighbour = a_Chunk->GetRelNeighborChunkAdjustCoords(Position);
+			if ((Neighbour == nullptr) || !Neighbour->IsValid())
+			{
+				break;
+			}
+
+			a_Intensity -= GetExplosionAbsorption(Neighbour->GetBlock(Position));
+			if (a_Intensity <= 0)
+			{
+				// The ray is exhausted:
+				break;
+			}
+
+			DestroyBlock(*Neighbour, Position, a_Power, a_Fiery, a_ExplodingEntity);
+
+			// Adjust coordinates to be relative to the neighbour chunk:
+			Checkpoint = RebaseRelativePosition(a_Chunk->GetPos(), Neighbour->GetPos(), Checkpoint);
+			a_Origin = RebaseRelativePosition(a_Chunk->GetPos(), Neighbour->GetPos(), a_Origin);
+			a_Chunk = Neighbour;
+
+			// Increment the simulation, weaken the ray:
+			Checkpoint += Step;
+			a_Intensity -= StepAttenuation;
+		}
+	}
+}
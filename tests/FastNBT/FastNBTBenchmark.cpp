@@ -0,0 +1,300 @@
+// FastNBTBenchmark.cpp
+
+// Measures the chunk NBT throughput of cParsedNBT, cNBTStreamReader and cFastNBTWriter
+// Usage: FastNBTBenchmark [<region file.mca>]
+// Without a region file, 1024 generated chunk-like NBTs are used
+
+#include "Globals.h"
+#include "NBTHelpers.h"
+#include "StringCompression.h"
+#include "OSSupport/File.h"
+
+
+
+
+
+/** The number of times each measured operation goes through all the chunks. */
+static const int NUM_REPEATS = 10;
+
+
+
+
+
+/** Reads all the chunks stored in the specified Anvil region file and returns their uncompressed NBT data. */
+static std::vector<ContiguousByteBuffer> loadRegionFile(const AString & aFileName)
+{
+	std::vector<ContiguousByteBuffer> res;
+	auto file = cFile::ReadWholeFile(aFileName);
+	if (file.size() < 8192)
+	{
+		LOGERROR("Cannot read region file %s", aFileName);
+		return res;
+	}
+	auto data = reinterpret_cast<const std::byte *>(file.data());
+	Compression::Extractor extractor;
+	for (size_t i = 0; i < 1024; i++)
+	{
+		// The header has the 3-byte sector offset and 1-byte sector count for each chunk:
+		auto location = static_cast<UInt32>(GetBEInt(data + i * 4));
+		size_t offset = (location >> 8) * 4096;
+		if ((offset == 0) || (offset + 5 > file.size()))
+		{
+			continue;
+		}
+
+		// Each chunk starts with the 4-byte length and 1-byte compression type (2 = zlib):
+		auto length = static_cast<size_t>(GetBEInt(data + offset));
+		if ((length < 1) || (offset + 4 + length > file.size()) || (data[offset + 4] != std::byte(2)))
+		{
+			continue;
+		}
+		auto extracted = extractor.ExtractZLib({ data + offset + 5, length - 1 });
+		res.emplace_back(extracted.GetView());
+	}
+	return res;
+}
+
+
+
+
+
+/** Generates 1024 chunk-like NBTs. */
+static std::vector<ContiguousByteBuffer> generateChunks()
+{
+	std::vector<ContiguousByteBuffer> res;
+	for (int i = 0; i < 1024; i++)
+	{
+		cFastNBTWriter writer;
+		writeChunkNBT(writer, i);
+		res.emplace_back(writer.GetResult());
+	}
+	return res;
+}
+
+
+
+
+
+/** Returns a checksum of all the data in the children of the specified tag, visiting each tag once. */
+static size_t checksumParsed(const cParsedNBT & aNBT, int aTag)
+{
+	size_t res = 0;
+	for (int child = aNBT.GetFirstChild(aTag); child >= 0; child = aNBT.GetNextSibling(child))
+	{
+		res += aNBT.GetName(child).size();
+		if ((aNBT.GetType(child) == TAG_Compound) || (aNBT.GetType(child) == TAG_List))
+		{
+			res += checksumParsed(aNBT, child);
+		}
+		else
+		{
+			res += aNBT.GetDataLength(child);
+		}
+	}
+	return res;
+}
+
+
+
+
+
+/** Returns a checksum of all the data in the remaining tags of the reader's current level, the same as checksumParsed(). */
+static size_t checksumStream(cNBTStreamReader & aReader)
+{
+	size_t res = 0;
+	while (aReader.NextTag())
+	{
+		res += aReader.GetName().size();
+		if ((aReader.GetType() == TAG_Compound) || (aReader.GetType() == TAG_List))
+		{
+			aReader.EnterTag();
+			res += checksumStream(aReader);
+		}
+		else
+		{
+			res += aReader.GetDataLength();
+		}
+	}
+	return res;
+}
+
+
+
+
+
+/** Returns a checksum of the data that chunk loading uses from the NBT, accessed the way WSSAnvil used to, through the tag tree. */
+static size_t loadChunkParsed(const cParsedNBT & aNBT)
+{
+	size_t res = 0;
+	int level = aNBT.FindChildByName(aNBT.GetRoot(), "Level");
+	int sections = aNBT.FindChildByName(level, "Sections");
+	for (int section = aNBT.GetFirstChild(sections); section >= 0; section = aNBT.GetNextSibling(section))
+	{
+		for (auto name: { "Y", "Blocks", "Data", "BlockLight", "SkyLight" })
+		{
+			int child = aNBT.FindChildByName(section, name);
+			res += (child < 0) ? 0 : aNBT.GetDataLength(child);
+		}
+	}
+	for (auto name: { "Biomes", "HeightMap", "Entities", "TileEntities" })
+	{
+		res += (aNBT.FindChildByName(level, name) < 0) ? 0 : 1;
+	}
+	return res;
+}
+
+
+
+
+
+/** Returns the same checksum as loadChunkParsed(), accessing the data the way WSSAnvil does, through the stream reader. */
+static size_t loadChunkStream(cNBTStreamReader & aReader)
+{
+	size_t res = 0;
+	while (aReader.NextTag())
+	{
+		if (aReader.GetName() != "Level")
+		{
+			continue;
+		}
+		aReader.EnterTag();
+		while (aReader.NextTag())
+		{
+			auto name = aReader.GetName();
+			if (name == "Sections")
+			{
+				aReader.EnterTag();
+				while (aReader.NextTag())
+				{
+					aReader.EnterTag();
+					while (aReader.NextTag())
+					{
+						auto sectionName = aReader.GetName();
+						if ((sectionName == "Y") || (sectionName == "Blocks") || (sectionName == "Data") || (sectionName == "BlockLight") || (sectionName == "SkyLight"))
+						{
+							res += aReader.GetDataLength();
+						}
+					}
+				}
+			}
+			else if ((name == "Entities") || (name == "TileEntities"))
+			{
+				res += aReader.ReadRawTag().empty() ? 0 : 1;
+			}
+			else if ((name == "Biomes") || (name == "HeightMap"))
+			{
+				res += 1;
+			}
+		}
+	}
+	return res;
+}
+
+
+
+
+
+/** Runs the specified operation on all the chunks NUM_REPEATS times, logs its throughput and returns the sum of its results. */
+template <typename Fn>
+static size_t measure(const char * aName, const std::vector<ContiguousByteBuffer> & aChunks, Fn aFn)
+{
+	size_t numBytes = 0;
+	for (const auto & chunk: aChunks)
+	{
+		numBytes += chunk.size();
+	}
+	size_t res = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < NUM_REPEATS; i++)
+	{
+		for (const auto & chunk: aChunks)
+		{
+			res += aFn(chunk);
+		}
+	}
+	auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / NUM_REPEATS;
+	LOG("%-30s %8.2f ms, %7.1f MiB / s, %7.1f chunks / ms", aName, ms, static_cast<double>(numBytes) / ms / 1024 / 1024 * 1000, static_cast<double>(aChunks.size()) / ms);
+	return res;
+}
+
+
+
+
+
+int main(int argc, char ** argv)
+{
+	auto chunks = (argc > 1) ? loadRegionFile(argv[1]) : generateChunks();
+	if (chunks.empty())
+	{
+		LOGERROR("No chunks to benchmark");
+		return 1;
+	}
+	LOG("FastNBT benchmark started, %u chunks", static_cast<unsigned>(chunks.size()));
+
+	// Reading all the tags:
+	auto parsedSum = measure("Read all, cParsedNBT", chunks, [](const ContiguousByteBuffer & aChunk)
+		{
+			cParsedNBT nbt(aChunk);
+			return checksumParsed(nbt, nbt.GetRoot());
+		}
+	);
+	auto streamSum = measure("Read all, cNBTStreamReader", chunks, [](const ContiguousByteBuffer & aChunk)
+		{
+			cNBTStreamReader reader(aChunk);
+			return checksumStream(reader);
+		}
+	);
+	if (parsedSum != streamSum)
+	{
+		LOGERROR("The readers disagree on the chunk data");
+		return 1;
+	}
+
+	// Reading what chunk loading uses:
+	parsedSum = measure("Load chunk, cParsedNBT", chunks, [](const ContiguousByteBuffer & aChunk)
+		{
+			return loadChunkParsed(cParsedNBT(aChunk));
+		}
+	);
+	streamSum = measure("Load chunk, cNBTStreamReader", chunks, [](const ContiguousByteBuffer & aChunk)
+		{
+			cNBTStreamReader reader(aChunk);
+			return loadChunkStream(reader);
+		}
+	);
+	if (parsedSum != streamSum)
+	{
+		LOGERROR("The readers disagree on the chunk data");
+		return 1;
+	}
+
+	// Writing a copy of the chunk, with and without reusing the output buffer:
+	measure("Copy, cFastNBTWriter", chunks, [](const ContiguousByteBuffer & aChunk)
+		{
+			cNBTStreamReader reader(aChunk);
+			cFastNBTWriter writer;
+			copyTags(reader, writer);
+			writer.Finish();
+			return writer.GetResult().size();
+		}
+	);
+	ContiguousByteBuffer buffer;
+	auto copySize = measure("Copy, cFastNBTWriter reused", chunks, [&buffer](const ContiguousByteBuffer & aChunk)
+		{
+			cNBTStreamReader reader(aChunk);
+			cFastNBTWriter writer(buffer);
+			copyTags(reader, writer);
+			writer.Finish();
+			return writer.GetResult().size();
+		}
+	);
+
+	// The copies are only allowed to differ in the root name and the children type of empty lists:
+	size_t origSize = 0;
+	for (const auto & chunk: chunks)
+	{
+		origSize += chunk.size() * NUM_REPEATS;
+	}
+	LOG("Copied %u of %u bytes", static_cast<unsigned>(copySize), static_cast<unsigned>(origSize));
+	return 0;
+}
@@ -0,0 +1,284 @@
+// FastNBTTest.cpp
+
+// Tests the cFastNBTWriter, cParsedNBT and cNBTStreamReader classes against each other
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "NBTHelpers.h"
+
+
+
+
+
+/** Returns a textual dump of the remaining tags at the reader's current level, including their children. */
+static AString dumpStream(cNBTStreamReader & aReader)
+{
+	AString res;
+	while (aReader.NextTag())
+	{
+		res.append(fmt::format("{} \"{}\"", static_cast<int>(aReader.GetType()), aReader.GetName()));
+		if ((aReader.GetType() == TAG_Compound) || (aReader.GetType() == TAG_List))
+		{
+			aReader.EnterTag();
+			res.append(" {\n").append(dumpStream(aReader)).append("}\n");
+		}
+		else
+		{
+			res.append(": ").append(reinterpret_cast<const char *>(aReader.GetData()), aReader.GetDataLength()).append("\n");
+		}
+	}
+	return res;
+}
+
+
+
+
+
+/** Returns a textual dump of the children of the specified tag, in the same format as dumpStream(). */
+static AString dumpParsed(const cParsedNBT & aNBT, int aTag)
+{
+	AString res;
+	for (int child = aNBT.GetFirstChild(aTag); child >= 0; child = aNBT.GetNextSibling(child))
+	{
+		res.append(fmt::format("{} \"{}\"", static_cast<int>(aNBT.GetType(child)), aNBT.GetName(child)));
+		if ((aNBT.GetType(child) == TAG_Compound) || (aNBT.GetType(child) == TAG_List))
+		{
+			res.append(" {\n").append(dumpParsed(aNBT, child)).append("}\n");
+		}
+		else
+		{
+			res.append(": ").append(reinterpret_cast<const char *>(aNBT.GetData(child)), aNBT.GetDataLength(child)).append("\n");
+		}
+	}
+	return res;
+}
+
+
+
+
+
+/** Writes a small NBT with each of the tag types. */
+static ContiguousByteBuffer writeAllTypes()
+{
+	cFastNBTWriter writer("root");
+	writer.AddByte("byte", 200);
+	writer.AddShort("short", -1234);
+	writer.AddInt("int", 123456789);
+	writer.AddLong("long", -1234567890123LL);
+	writer.AddFloat("float", 1.5f);
+	writer.AddDouble("double", -2.25);
+	writer.AddString("string", "text");
+	writer.AddByteArray("bytes", "abc", 3);
+	Int32 ints[] = { 1, -2, 3 };
+	writer.AddIntArray("ints", ints, 3);
+	writer.BeginCompound("skipped");
+	writer.BeginList("nested", TAG_Int);
+	writer.AddInt("", 5);
+	writer.EndList();
+	writer.EndCompound();
+	writer.BeginList("list", TAG_Compound);
+	for (int i = 0; i < 3; i++)
+	{
+		writer.BeginCompound("");
+		writer.AddInt("i", i);
+		writer.EndCompound();
+	}
+	writer.EndList();
+	writer.BeginList("empty", TAG_Compound);
+	writer.EndList();
+	writer.AddByte("last", 1);
+	writer.Finish();
+	return ContiguousByteBuffer(writer.GetResult());
+}
+
+
+
+
+
+/** Tests that the stream reader reads back the values written by the writer, including skipping and cutting out tags. */
+static void testValues()
+{
+	auto data = writeAllTypes();
+	cNBTStreamReader reader(data);
+	TEST_TRUE(reader.NextTag());
+	TEST_EQUAL(reader.GetName(), "byte");
+	TEST_EQUAL(reader.GetByte(), 200);
+	TEST_TRUE(reader.NextTag());
+	TEST_EQUAL(reader.GetShort(), -1234);
+	TEST_TRUE(reader.NextTag());
+	TEST_EQUAL(reader.GetInt(), 123456789);
+	TEST_TRUE(reader.NextTag());
+	TEST_EQUAL(reader.GetLong(), -1234567890123LL);
+	TEST_TRUE(reader.NextTag());
+	TEST_EQUAL(reader.GetFloat(), 1.5f);
+	TEST_TRUE(reader.NextTag());
+	TEST_EQUAL(reader.GetDouble(), -2.25);
+	TEST_TRUE(reader.NextTag());
+	TEST_EQUAL(reader.GetStringView(), "text");
+	TEST_TRUE(reader.NextTag());
+	TEST_EQUAL(reader.GetType(), TAG_ByteArray);
+	TEST_EQUAL(reader.GetCount(), 3);
+	TEST_EQUAL(reader.GetData()[2], std::byte('c'));
+	TEST_TRUE(reader.NextTag());
+	TEST_EQUAL(reader.GetType(), TAG_IntArray);
+	TEST_EQUAL(reader.GetCount(), 3);
+	TEST_EQUAL(GetBEInt(reader.GetData() + 4), -2);
+
+	// The compound is not entered, the next tag comes after all of its contents:
+	TEST_TRUE(reader.NextTag());
+	TEST_EQUAL(reader.GetName(), "skipped");
+	TEST_TRUE(reader.NextTag());
+	TEST_EQUAL(reader.GetName(), "list");
+	TEST_EQUAL(reader.GetChildrenType(), TAG_Compound);
+	TEST_EQUAL(reader.GetCount(), 3);
+
+	// Cut the list out and parse it on its own:
+	auto rawList = reader.ReadRawTag();
+	TEST_EQUAL(reader.GetDepth(), 0);
+	cParsedNBT list(rawList, TAG_List);
+	TEST_TRUE(list.IsValid());
+	TEST_EQUAL(list.GetName(list.GetRoot()), "list");
+	int i = 0;
+	for (int child = list.GetFirstChild(list.GetRoot()); child >= 0; child = list.GetNextSibling(child), i++)
+	{
+		TEST_EQUAL(list.GetInt(list.FindChildByName(child, "i")), i);
+	}
+	TEST_EQUAL(i, 3);
+
+	// An empty list reports no children type, same as cParsedNBT:
+	TEST_TRUE(reader.NextTag());
+	TEST_EQUAL(reader.GetName(), "empty");
+	TEST_EQUAL(reader.GetChildrenType(), TAG_End);
+	TEST_TRUE(reader.EnterTag());
+	TEST_FALSE(reader.NextTag());
+	TEST_EQUAL(reader.GetDepth(), 0);
+
+	TEST_TRUE(reader.NextTag());
+	TEST_EQUAL(reader.GetName(), "last");
+	TEST_FALSE(reader.NextTag());
+	TEST_FALSE(reader.NextTag());
+	TEST_TRUE(reader.IsValid());
+}
+
+
+
+
+
+/** Tests that both the readers see the same tags in chunk-like NBTs, and that copying through the stream reader preserves them. */
+static void testReadersAgree()
+{
+	ContiguousByteBuffer buffer;
+	for (int seed = 0; seed < 20; seed++)
+	{
+		cFastNBTWriter writer(buffer);
+		writeChunkNBT(writer, seed);
+		cParsedNBT parsed(writer.GetResult());
+		TEST_TRUE(parsed.IsValid());
+		cNBTStreamReader reader(writer.GetResult());
+		auto streamDump = dumpStream(reader);
+		TEST_TRUE(reader.IsValid());
+		auto parsedDump = dumpParsed(parsed, parsed.GetRoot());
+		TEST_EQUAL(streamDump, parsedDump);
+
+		cNBTStreamReader copyReader(writer.GetResult());
+		cFastNBTWriter copyWriter;
+		copyTags(copyReader, copyWriter);
+		copyWriter.Finish();
+		TEST_TRUE(copyReader.IsValid());
+		cNBTStreamReader copyDumpReader(copyWriter.GetResult());
+		auto copyDump = dumpStream(copyDumpReader);
+		TEST_EQUAL(copyDump, streamDump);
+	}
+}
+
+
+
+
+
+/** Tests that malformed data is reported as an error by the stream reader, the same way cParsedNBT does. */
+static void testMalformed()
+{
+	// Every truncation of a valid NBT is invalid:
+	auto data = writeAllTypes();
+	for (size_t len = 0; len < data.size(); len++)
+	{
+		auto truncated = ContiguousByteBufferView(data).substr(0, len);
+		cNBTStreamReader reader(truncated);
+		dumpStream(reader);
+		TEST_FALSE(reader.IsValid());
+		TEST_FALSE(cParsedNBT(truncated).IsValid());
+	}
+
+	// Unknown tag type:
+	const std::byte unknownTag[] = { std::byte(TAG_Compound), std::byte(0), std::byte(0), std::byte(42), std::byte(0), std::byte(0), std::byte(0) };
+	cNBTStreamReader unknownTagReader({ unknownTag, sizeof(unknownTag) });
+	TEST_FALSE(unknownTagReader.NextTag());
+	TEST_EQUAL(unknownTagReader.GetErrorCode(), eNBTParseError::npUnknownTag);
+
+	// A list claiming more items than the data can hold:
+	cFastNBTWriter writer;
+	writer.BeginList("list", TAG_Long);
+	writer.AddLong("", 1);
+	writer.EndList();
+	writer.Finish();
+	ContiguousByteBuffer longList(writer.GetResult());
+	SetBEInt(longList.data() + 3 + 1 + 2 + 4 + 1, 1000);  // Root header, list type, name, children type
+	cNBTStreamReader longListReader(longList);
+	TEST_FALSE(longListReader.NextTag());
+	TEST_EQUAL(longListReader.GetErrorCode(), eNBTParseError::npListInvalidLength);
+
+	// Compounds nested too deep, skipped as a whole:
+	ContiguousByteBuffer deep = { std::byte(TAG_Compound), std::byte(0), std::byte(0) };
+	for (int i = 0; i < 1000; i++)
+	{
+		deep.append({ std::byte(TAG_Compound), std::byte(0), std::byte(0) });
+	}
+	deep.append(1001, std::byte(TAG_End));
+	cNBTStreamReader deepReader(deep);
+	TEST_TRUE(deepReader.NextTag());
+	TEST_FALSE(deepReader.NextTag());
+	TEST_EQUAL(deepReader.GetErrorCode(), eNBTParseError::npNestingTooDeep);
+}
+
+
+
+
+
+/** Tests that a writer outputting into a caller-provided buffer replaces its contents and keeps its memory. */
+static void testBufferReuse()
+{
+	// A copy would keep referencing the original writer's buffer:
+	static_assert(!std::is_copy_constructible_v<cFastNBTWriter>);
+	static_assert(!std::is_copy_assignable_v<cFastNBTWriter>);
+
+	ContiguousByteBuffer buffer;
+	{
+		cFastNBTWriter writer(buffer, "first");
+		writeChunkNBT(writer, 1);
+	}
+	auto firstSize = buffer.size();
+	auto capacity = buffer.capacity();
+	TEST_TRUE(cParsedNBT(buffer).IsValid());
+
+	cFastNBTWriter writer(buffer, "second");
+	writer.AddInt("value", 1);
+	writer.Finish();
+	TEST_EQUAL(writer.GetResult().data(), buffer.data());
+	TEST_LESS_THAN_OR_EQUAL(buffer.size(), firstSize);
+	TEST_EQUAL(buffer.capacity(), capacity);
+	cParsedNBT parsed(buffer);
+	TEST_TRUE(parsed.IsValid());
+	TEST_EQUAL(parsed.GetName(parsed.GetRoot()), "second");
+	TEST_EQUAL(parsed.GetInt(parsed.FindChildByName(parsed.GetRoot(), "value")), 1);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("FastNBT",
+	testValues();
+	testReadersAgree();
+	testMalformed();
+	testBufferReuse();
+)
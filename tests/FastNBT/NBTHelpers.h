@@ -0,0 +1,179 @@
+// NBTHelpers.h
+
+// Helper functions shared by the FastNBT test and benchmark: a chunk-like NBT generator and a reader-to-writer copy
+
+#pragma once
+
+#include "WorldStorage/FastNBT.h"
+
+
+
+
+
+/** Writes an NBT resembling an Anvil chunk, as written by NBTChunkSerializer, into aWriter (which is then finished).
+The contents are pseudo-random, based on aSeed. */
+inline void writeChunkNBT(cFastNBTWriter & aWriter, int aSeed)
+{
+	auto random = [&aSeed]()
+	{
+		aSeed = aSeed * 1103515245 + 12345;
+		return (aSeed >> 8) & 0xffff;
+	};
+
+	aWriter.BeginCompound("Level");
+	aWriter.AddInt("xPos", aSeed % 32);
+	aWriter.AddInt("zPos", aSeed / 32);
+
+	// Entities:
+	aWriter.BeginList("Entities", TAG_Compound);
+	for (int i = random() % 16; i > 0; i--)
+	{
+		aWriter.BeginCompound("");
+		aWriter.AddString("id", "minecraft:zombie");
+		aWriter.BeginList("Pos", TAG_Double);
+		aWriter.AddDouble("", random() / 100.0);
+		aWriter.AddDouble("", random() % 256);
+		aWriter.AddDouble("", random() / 100.0);
+		aWriter.EndList();
+		aWriter.BeginList("Motion", TAG_Double);
+		aWriter.AddDouble("", 0);
+		aWriter.AddDouble("", -0.08);
+		aWriter.AddDouble("", 0);
+		aWriter.EndList();
+		aWriter.BeginList("Rotation", TAG_Float);
+		aWriter.AddFloat("", static_cast<float>(random() % 360));
+		aWriter.AddFloat("", 0);
+		aWriter.EndList();
+		aWriter.AddShort("Health", static_cast<Int16>(random() % 20));
+		aWriter.AddByte("OnGround", 1);
+		aWriter.AddLong("UUIDMost", static_cast<Int64>(random()) << 40);
+		aWriter.BeginList("Equipment", TAG_Compound);
+		for (int e = 0; e < 5; e++)
+		{
+			aWriter.BeginCompound("");
+			aWriter.AddShort("id", static_cast<Int16>(random() % 400));
+			aWriter.AddByte("Count", 1);
+			aWriter.EndCompound();
+		}
+		aWriter.EndList();
+		aWriter.EndCompound();
+	}
+	aWriter.EndList();
+
+	// Block entities:
+	aWriter.BeginList("TileEntities", TAG_Compound);
+	for (int i = random() % 6; i > 0; i--)
+	{
+		aWriter.BeginCompound("");
+		aWriter.AddString("id", "Chest");
+		aWriter.AddInt("x", random() % 16);
+		aWriter.AddInt("y", random() % 256);
+		aWriter.AddInt("z", random() % 16);
+		aWriter.BeginList("Items", TAG_Compound);
+		for (int s = random() % 27; s > 0; s--)
+		{
+			aWriter.BeginCompound("");
+			aWriter.AddShort("id", static_cast<Int16>(random() % 400));
+			aWriter.AddShort("Damage", 0);
+			aWriter.AddByte("Count", static_cast<unsigned char>(random() % 64));
+			aWriter.AddByte("Slot", static_cast<unsigned char>(s));
+			aWriter.BeginCompound("tag");
+			aWriter.AddString("Name", "A renamed item");
+			aWriter.EndCompound();
+			aWriter.EndCompound();
+		}
+		aWriter.EndList();
+		aWriter.EndCompound();
+	}
+	aWriter.EndList();
+
+	// Block data:
+	aWriter.BeginList("Sections", TAG_Compound);
+	char blocks[4096];
+	for (int y = 0; y < 16; y++)
+	{
+		for (auto & block: blocks)
+		{
+			block = static_cast<char>((random() % 8 == 0) ? random() % 256 : 1);
+		}
+		aWriter.BeginCompound("");
+		aWriter.AddByteArray("Blocks", blocks, sizeof(blocks));
+		aWriter.AddByteArray("Data", blocks, sizeof(blocks) / 2);
+		aWriter.AddByteArray("BlockLight", 2048, 0);
+		aWriter.AddByteArray("SkyLight", 2048, 0xff);
+		aWriter.AddByte("Y", static_cast<unsigned char>(y));
+		aWriter.EndCompound();
+	}
+	aWriter.EndList();
+
+	char biomes[256];
+	Int32 heights[256];
+	for (size_t i = 0; i < 256; i++)
+	{
+		biomes[i] = static_cast<char>(random() % 40);
+		heights[i] = random() % 256;
+	}
+	aWriter.AddByteArray("Biomes", biomes, sizeof(biomes));
+	aWriter.AddIntArray("HeightMap", heights, 256);
+	aWriter.AddByte("MCSIsLightValid", 1);
+	aWriter.AddByte("TerrainPopulated", 1);
+	aWriter.AddLong("LastUpdate", 1234567);
+	aWriter.EndCompound();  // "Level"
+	aWriter.AddInt("DataVersion", 1343);
+	aWriter.Finish();
+}
+
+
+
+
+
+/** Copies all the remaining tags at the reader's current level, including their children, into the writer. */
+inline void copyTags(cNBTStreamReader & aReader, cFastNBTWriter & aWriter)
+{
+	while (aReader.NextTag())
+	{
+		auto name = aReader.GetName();
+		switch (aReader.GetType())
+		{
+			case TAG_Byte:   aWriter.AddByte(name, aReader.GetByte()); break;
+			case TAG_Short:  aWriter.AddShort(name, aReader.GetShort()); break;
+			case TAG_Int:    aWriter.AddInt(name, aReader.GetInt()); break;
+			case TAG_Long:   aWriter.AddLong(name, aReader.GetLong()); break;
+			case TAG_Float:  aWriter.AddFloat(name, aReader.GetFloat()); break;
+			case TAG_Double: aWriter.AddDouble(name, aReader.GetDouble()); break;
+			case TAG_String: aWriter.AddString(name, aReader.GetStringView()); break;
+			case TAG_ByteArray:
+			{
+				aWriter.AddByteArray(name, reinterpret_cast<const char *>(aReader.GetData()), aReader.GetDataLength());
+				break;
+			}
+			case TAG_IntArray:
+			{
+				std::vector<Int32> values(aReader.GetCount());
+				for (size_t i = 0; i < values.size(); i++)
+				{
+					values[i] = GetBEInt(aReader.GetData() + i * 4);
+				}
+				aWriter.AddIntArray(name, values.data(), values.size());
+				break;
+			}
+			case TAG_List:
+			{
+				aWriter.BeginList(name, aReader.GetChildrenType());
+				aReader.EnterTag();
+				copyTags(aReader, aWriter);
+				aWriter.EndList();
+				break;
+			}
+			case TAG_Compound:
+			{
+				aWriter.BeginCompound(name);
+				aReader.EnterTag();
+				copyTags(aReader, aWriter);
+				aWriter.EndCompound();
+				break;
+			}
+			case TAG_End: break;
+		}
+	}
+}
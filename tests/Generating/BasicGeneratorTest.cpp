@@ -304,6 +304,74 @@ static void testRepeatability(cChunkGenerator & aDefaultOverworldGenerator, cChu
 
 
 
+/** Creates a default Overworld generator with the disk cache enabled, stored in the specified file. */
+static std::unique_ptr<cChunkGenerator> createDiskCachedGenerator(const AString & aFileName, int aSeed)
+{
+	cIniFile ini;
+	ini.AddValue("General", "Dimension", "Overworld");
+	ini.AddValueI("Seed", "Seed", aSeed);
+	ini.AddValue("Generator", "Finishers", "");
+	ini.AddValueB("Generator", "DiskCache", true);
+	ini.AddValue("Generator", "DiskCacheFile", aFileName);
+	ini.AddValueI("Generator", "DiskCacheSize", 64);
+	return cChunkGenerator::CreateFromIniFile(ini);
+}
+
+
+
+
+
+/** Tests that the generator disk cache returns the same biomes as the generator itself,
+both when written and when read back by a new generator instance, and that it is invalidated by a seed change. */
+static void testDiskCache(cChunkGenerator & aDefaultOverworldGen)
+{
+	LOG("Testing the generator disk cache...");
+	const AString fileName = "BasicGeneratorTest.cache";
+	cFile::DeleteFile(fileName);
+
+	std::vector<cChunkCoords> coords;
+	for (int i = 0; i < 20; ++i)
+	{
+		coords.emplace_back(i - 10, 3 * i);
+	}
+
+	// Fill the cache and read it back from a fresh generator instance (so that the in-memory caches are empty):
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		auto gen = createDiskCachedGenerator(fileName, 1);
+		TEST_NOTEQUAL(gen, nullptr);
+		for (const auto & c: coords)
+		{
+			cChunkDef::BiomeMap expected, cached;
+			aDefaultOverworldGen.GenerateBiomes(c, expected);
+			gen->GenerateBiomes(c, cached);
+			TEST_EQUAL_MSG(memcmp(expected, cached, sizeof(expected)), 0, Printf("Pass %d, chunk %s", pass, c.ToString()));
+		}
+	}
+
+	// Changing the seed must invalidate the cache:
+	cIniFile ini2;
+	ini2.AddValue("General", "Dimension", "Overworld");
+	ini2.AddValueI("Seed", "Seed", 2);
+	ini2.AddValue("Generator", "Finishers", "");
+	auto uncachedGen2 = cChunkGenerator::CreateFromIniFile(ini2);
+	auto cachedGen2 = createDiskCachedGenerator(fileName, 2);
+	for (const auto & c: coords)
+	{
+		cChunkDef::BiomeMap expected, cached;
+		uncachedGen2->GenerateBiomes(c, expected);
+		cachedGen2->GenerateBiomes(c, cached);
+		TEST_EQUAL_MSG(memcmp(expected, cached, sizeof(expected)), 0, Printf("Seed 2, chunk %s", c.ToString()));
+	}
+
+	cachedGen2.reset();
+	cFile::DeleteFile(fileName);
+}
+
+
+
+
+
 IMPLEMENT_TEST_MAIN("BasicGeneratorTest",
 	// Create a default Overworld generator:
 	cIniFile iniOverworld;
@@ -324,4 +392,5 @@ IMPLEMENT_TEST_MAIN("BasicGeneratorTest",
 	testGenerateOverworld(*defaultOverworldGen);
 	testGenerateNether(*defaultNetherGen);
 	testRepeatability(*defaultOverworldGen, *defaultNetherGen);
+	testDiskCache(*defaultOverworldGen);
 )
@@ -0,0 +1,60 @@
+// GridStructGenBenchmark.cpp
+
+// Measures the time needed to generate an area of chunks with all the grid-based structure generators enabled
+// Needs to be run from the Server folder, so that the prefabs can be loaded
+
+#include "Globals.h"
+#include "Generating/ChunkGenerator.h"
+#include "Generating/ChunkDesc.h"
+#include "IniFile.h"
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	// The size of the generated area, in chunks, may be given on the command line:
+	int areaSize = 64;
+	if ((argc > 1) && (!StringToInteger(argv[1], areaSize) || (areaSize <= 0)))
+	{
+		LOGERROR("Usage: %s [AreaSizeInChunks]", argv[0]);
+		return 1;
+	}
+
+	cIniFile ini;
+	ini.AddValue("General", "Dimension", "Overworld");
+	ini.AddValueI("Seed", "Seed", 1);
+	ini.AddValue("Generator", "Finishers",
+		"Mineshafts, "
+		"DungeonRooms, "
+		"Villages, "
+		"SinglePieceStructures: JungleTemple|WitchHut|DesertPyramid|DesertWell, "
+		"PieceStructures: RainbowRoad|TreePaths|UnderwaterBase"
+	);
+	auto gen = cChunkGenerator::CreateFromIniFile(ini);
+	if (gen == nullptr)
+	{
+		LOGERROR("Cannot create the generator");
+		return 1;
+	}
+
+	LOG("Generating %d * %d chunks...", areaSize, areaSize);
+	auto start = std::chrono::steady_clock::now();
+	for (int x = 0; x < areaSize; ++x)
+	{
+		for (int z = 0; z < areaSize; ++z)
+		{
+			cChunkDesc chd({x - areaSize / 2, z - areaSize / 2});
+			gen->Generate(chd);
+		}
+	}
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+	LOG("Generated %d chunks in %d ms (%.3f ms per chunk)",
+		areaSize * areaSize, static_cast<int>(duration.count()), static_cast<double>(duration.count()) / (areaSize * areaSize)
+	);
+
+	// Destroy the generator, so that the structure generators log their cache statistics:
+	gen.reset();
+	return 0;
+}
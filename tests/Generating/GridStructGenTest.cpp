@@ -0,0 +1,161 @@
+// GridStructGenTest.cpp
+
+// Implements the tests for the cGridStructGen structure cache
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "Generating/GridStructGen.h"
+
+
+
+
+
+/** A cGridStructGen descendant that creates empty structures and counts the calls to CreateStructure(). */
+class cTestGridStructGen:
+	public cGridStructGen
+{
+	using Super = cGridStructGen;
+
+public:
+
+	cTestGridStructGen(size_t aMaxCacheSize):
+		Super(0, 64, 64, 16, 16, 32, 32, aMaxCacheSize),
+		mNumCreated(0)
+	{
+	}
+
+	/** Returns the structures for the specified chunk, publishing the protected function for the tests. */
+	cStructurePtrs getStructures(int aChunkX, int aChunkZ)
+	{
+		cStructurePtrs res;
+		GetStructuresForChunk(aChunkX, aChunkZ, res);
+		return res;
+	}
+
+	std::atomic<size_t> mNumCreated;
+
+protected:
+
+	class cTestStructure:
+		public cStructure
+	{
+		using Super = cStructure;
+
+	public:
+		using Super::Super;
+		virtual void DrawIntoChunk(cChunkDesc & aChunkDesc) override {}
+	};
+
+	virtual cStructurePtr CreateStructure(int aGridX, int aGridZ, int aOriginX, int aOriginZ) override
+	{
+		mNumCreated++;
+		return std::make_shared<cTestStructure>(aGridX, aGridZ, aOriginX, aOriginZ);
+	}
+};
+
+
+
+
+
+/** Tests that the structures are returned in grid order, each grid cell exactly once, and that repeated queries hit the cache. */
+static void testCacheHits()
+{
+	cTestGridStructGen gen(1000);
+	auto first = gen.getStructures(3, -5);
+	TEST_EQUAL(first.empty(), false);
+	TEST_EQUAL(gen.mNumCreated.load(), first.size());
+	TEST_EQUAL(gen.GetNumCacheMisses(), first.size());
+	TEST_EQUAL(gen.GetNumCacheHits(), 0);
+
+	// Each grid cell is returned exactly once, X-major:
+	std::set<std::pair<int, int>> cells;
+	std::pair<int, int> prev(std::numeric_limits<int>::min(), std::numeric_limits<int>::min());
+	for (const auto & structure: first)
+	{
+		std::pair<int, int> cell(structure->m_GridX, structure->m_GridZ);
+		TEST_EQUAL(cells.insert(cell).second, true);
+		TEST_EQUAL(prev < cell, true);
+		prev = cell;
+	}
+
+	// The second query for the same chunk is served entirely from the cache, returning the same objects:
+	auto second = gen.getStructures(3, -5);
+	TEST_EQUAL(gen.mNumCreated.load(), first.size());
+	TEST_EQUAL(gen.GetNumCacheHits(), first.size());
+	TEST_EQUAL(first, second);
+
+	// A neighbor chunk shares most of the grid cells:
+	gen.getStructures(4, -5);
+	TEST_LESS_THAN_OR_EQUAL(gen.mNumCreated.load(), first.size() * 2);
+}
+
+
+
+
+
+/** Tests that the least recently used structures are evicted once the cache is full. */
+static void testEviction()
+{
+	cTestGridStructGen gen(8);  // Room for two chunks' worth of structures
+	auto first = gen.getStructures(3, -5);
+	auto numPerQuery = first.size();
+	TEST_EQUAL(numPerQuery, 4);
+
+	// Query chunks far enough away that the first chunk's structures get evicted:
+	for (int i = 1; i <= 10; ++i)
+	{
+		gen.getStructures(i * 100, 0);
+	}
+	auto created = gen.mNumCreated.load();
+	auto again = gen.getStructures(3, -5);
+	TEST_EQUAL(gen.mNumCreated.load(), created + numPerQuery);
+
+	// The re-created structures are new objects:
+	TEST_NOTEQUAL(first.front(), again.front());
+
+	// The most recent query is still cached:
+	gen.getStructures(3, -5);
+	TEST_EQUAL(gen.mNumCreated.load(), created + numPerQuery);
+}
+
+
+
+
+
+/** Tests that the cache can be queried from multiple threads at once. */
+static void testMultithreaded()
+{
+	cTestGridStructGen gen(64);
+	std::atomic<size_t> numReturned(0);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([&gen, &numReturned, t]()
+			{
+				for (int x = 0; x < 32; ++x)
+				{
+					for (int z = 0; z < 32; ++z)
+					{
+						numReturned += gen.getStructures(x + t * 8, z).size();
+					}
+				}
+			}
+		);
+	}
+	for (auto & thr: threads)
+	{
+		thr.join();
+	}
+	TEST_EQUAL(gen.GetNumCacheHits() + gen.GetNumCacheMisses(), numReturned.load());
+	TEST_EQUAL(gen.GetNumCacheMisses(), gen.mNumCreated.load());
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("GridStructGen",
+	testCacheHits();
+	testEviction();
+	testMultithreaded();
+)
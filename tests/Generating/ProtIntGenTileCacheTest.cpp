@@ -0,0 +1,121 @@
+// ProtIntGenTileCacheTest.cpp
+
+// Tests that the tiled evaluation of the prototyping int generators produces the same values as the direct evaluation
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "Generating/ProtIntGen.h"
+
+
+
+
+
+/** Creates a generator chain containing the zoom, smooth and neighbor-dependent stages used by the biome generators. */
+static std::shared_ptr<cProtIntGen> createChain(int aSeed)
+{
+	return
+		std::make_shared<cProtIntGenSmooth     >(aSeed + 1,
+		std::make_shared<cProtIntGenZoom       >(aSeed + 2,
+		std::make_shared<cProtIntGenBiomeEdges >(aSeed + 3,
+		std::make_shared<cProtIntGenZoom       >(aSeed + 4,
+		std::make_shared<cProtIntGenBiomes     >(aSeed + 5,
+		std::make_shared<cProtIntGenAddIslands >(aSeed + 6, 200,
+		std::make_shared<cProtIntGenZoom       >(aSeed + 7,
+		std::make_shared<cProtIntGenLandOcean  >(aSeed + 8, 30
+	))))))));
+}
+
+
+
+
+
+/** Compares the cached and direct values of a single area. */
+static void compareArea(cProtIntGen & aDirect, cProtIntGen & aCached, int aMinX, int aMinZ, size_t aSizeX, size_t aSizeZ)
+{
+	std::vector<int> direct(aSizeX * aSizeZ), cached(aSizeX * aSizeZ);
+	aDirect.GetInts(aMinX, aMinZ, aSizeX, aSizeZ, direct.data());
+	aCached.GetInts(aMinX, aMinZ, aSizeX, aSizeZ, cached.data());
+	TEST_EQUAL(direct, cached);
+}
+
+
+
+
+
+/** Tests that the cached values are identical to the direct ones, for areas within a tile, spanning several tiles, and with negative coords. */
+static void testIdenticalOutput()
+{
+	auto direct = createChain(1);
+	cProtIntGenTileCache cached(12, 8, createChain(1));
+
+	compareArea(*direct, cached, 0, 0, 8, 8);         // Within a single tile
+	compareArea(*direct, cached, -4, -4, 8, 8);       // Four tiles around the origin
+	compareArea(*direct, cached, 10, -30, 20, 5);     // A row of tiles
+	compareArea(*direct, cached, -100, 37, 25, 25);   // Nine tiles
+	compareArea(*direct, cached, -13, -13, 1, 1);     // A single value
+
+	// A sweep of chunk-like requests, as the biome generator does:
+	for (int z = -40; z < 40; z += 8)
+	{
+		for (int x = -40; x < 40; x += 8)
+		{
+			compareArea(*direct, cached, x, z, 8, 8);
+		}
+	}
+	TEST_GREATER_THAN_OR_EQUAL(cached.GetNumHits(), 1);
+}
+
+
+
+
+
+/** Tests that neighboring requests share the tiles. */
+static void testTileSharing()
+{
+	cProtIntGenTileCache cached(16, 4, createChain(2));
+	int values[8 * 8];
+	cached.GetInts(0, 0, 8, 8, values);
+	TEST_EQUAL(cached.GetNumMisses(), 1);
+	cached.GetInts(8, 0, 8, 8, values);
+	cached.GetInts(0, 8, 8, 8, values);
+	cached.GetInts(8, 8, 8, 8, values);
+	TEST_EQUAL(cached.GetNumMisses(), 1);
+	TEST_EQUAL(cached.GetNumHits(), 3);
+}
+
+
+
+
+
+/** Tests that the cache can be queried from multiple threads at once. */
+static void testMultithreaded()
+{
+	auto direct = createChain(3);
+	cProtIntGenTileCache cached(12, 8, createChain(3));
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([&direct, &cached, t]()
+			{
+				for (int i = 0; i < 50; ++i)
+				{
+					compareArea(*direct, cached, t * 5 + i * 3, i * 2 - 50, 10, 10);
+				}
+			}
+		);
+	}
+	for (auto & thr: threads)
+	{
+		thr.join();
+	}
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("ProtIntGenTileCache",
+	testIdenticalOutput();
+	testTileSharing();
+	testMultithreaded();
+)
@@ -0,0 +1,218 @@
+// HookRateLimiterTest.cpp
+
+// Tests the cHookRateLimiter: the supported hooks, the coalescing of the calls per subject, the coalescing and flushing of the player moves
+// and the purging of the stale subjects
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "Bindings/HookRateLimiter.h"
+#include "Bindings/PluginManager.h"
+
+
+
+
+
+using cClock = cHookRateLimiter::cClock;
+using sMove = cHookRateLimiter::sMove;
+
+
+
+
+
+/** Tests that only the hooks that cannot be cancelled, or have an observe-only variant, may be rate-limited. */
+static void testSupportedHooks()
+{
+	TEST_TRUE(cHookRateLimiter::IsSupported(cPluginManager::HOOK_TICK));
+	TEST_TRUE(cHookRateLimiter::IsSupported(cPluginManager::HOOK_WORLD_TICK));
+	TEST_TRUE(cHookRateLimiter::IsSupported(cPluginManager::HOOK_PLAYER_MOVING));
+
+	// A skipped call of a cancellable hook would let the event through without the plugin seeing it:
+	TEST_FALSE(cHookRateLimiter::IsSupported(cPluginManager::HOOK_CHAT));
+	TEST_FALSE(cHookRateLimiter::IsSupported(cPluginManager::HOOK_PLAYER_BREAKING_BLOCK));
+	TEST_FALSE(cHookRateLimiter::IsSupported(cPluginManager::HOOK_NUM_HOOKS));
+}
+
+
+
+
+
+/** Tests that the calls within the interval are skipped and their time deltas reach the next call that is made. */
+static void testCoalescing()
+{
+	const auto start = cClock::now();
+	cHookRateLimiter limiter(std::chrono::milliseconds(200), start);
+
+	// Tick every 50 ms for two seconds; the first tick calls right away, then every fourth one:
+	float totalDt = 0;
+	int numCalls = 0;
+	for (int i = 0; i < 40; i++)
+	{
+		float dt = -1;
+		const bool shouldCall = limiter.Trigger(0, 50, start + std::chrono::milliseconds(i * 50), dt);
+		TEST_EQUAL(shouldCall, (i % 4 == 0));
+		if (shouldCall)
+		{
+			TEST_EQUAL(dt, ((i == 0) ? 50.0f : 200.0f));
+			totalDt += dt;
+			numCalls += 1;
+		}
+		else
+		{
+			TEST_EQUAL(dt, -1.0f);
+		}
+	}
+	TEST_EQUAL(numCalls, 10);
+
+	// The deltas of the last three skipped ticks are delivered by the next due tick, nothing is lost:
+	float dt = 0;
+	TEST_TRUE(limiter.Trigger(0, 50, start + std::chrono::milliseconds(2000), dt));
+	TEST_EQUAL(totalDt + dt, 41 * 50.0f);
+
+	// A zero interval calls each time:
+	cHookRateLimiter unlimited(std::chrono::milliseconds(0), start);
+	TEST_TRUE(unlimited.Trigger(0, 50, start, dt));
+	TEST_TRUE(unlimited.Trigger(0, 50, start, dt));
+	TEST_EQUAL(dt, 50.0f);
+}
+
+
+
+
+
+/** Tests that each subject (world) is rate-limited separately. */
+static void testSubjects()
+{
+	const auto start = cClock::now();
+	cHookRateLimiter limiter(std::chrono::milliseconds(100), start);
+	float dt = 0;
+	TEST_TRUE(limiter.Trigger(1, 50, start, dt));
+	TEST_TRUE(limiter.Trigger(2, 50, start, dt));
+	TEST_FALSE(limiter.Trigger(1, 50, start + std::chrono::milliseconds(50), dt));
+	TEST_FALSE(limiter.Trigger(2, 20, start + std::chrono::milliseconds(50), dt));
+	TEST_FALSE(limiter.Trigger(2, 20, start + std::chrono::milliseconds(70), dt));
+	TEST_TRUE(limiter.Trigger(1, 50, start + std::chrono::milliseconds(100), dt));
+	TEST_EQUAL(dt, 100.0f);
+	TEST_TRUE(limiter.Trigger(2, 20, start + std::chrono::milliseconds(100), dt));
+	TEST_EQUAL(dt, 60.0f);
+	TEST_EQUAL(limiter.GetNumSubjects(), 2U);
+}
+
+
+
+
+
+/** Tests that the player moves within the interval are coalesced into a single move, spanning from the first to the last one. */
+static void testMoves()
+{
+	const auto start = cClock::now();
+	cHookRateLimiter limiter(std::chrono::milliseconds(100), start);
+	sMove move;
+
+	// The first move calls right away:
+	TEST_TRUE(limiter.TriggerMove(1, 10, sMove{{0, 0, 0}, {1, 0, 0}, true}, start, move));
+	TEST_EQUAL(move.m_OldPosition, Vector3d(0, 0, 0));
+	TEST_EQUAL(move.m_NewPosition, Vector3d(1, 0, 0));
+	TEST_TRUE(move.m_PreviousIsOnGround);
+
+	// The moves within the interval are coalesced, the due call reports them as a single move:
+	TEST_FALSE(limiter.TriggerMove(1, 10, sMove{{1, 0, 0}, {2, 0, 0}, false}, start + std::chrono::milliseconds(50), move));
+	TEST_FALSE(limiter.TriggerMove(1, 10, sMove{{2, 0, 0}, {3, 0, 0}, true}, start + std::chrono::milliseconds(70), move));
+	TEST_TRUE(limiter.TriggerMove(1, 10, sMove{{3, 0, 0}, {4, 0, 0}, true}, start + std::chrono::milliseconds(100), move));
+	TEST_EQUAL(move.m_OldPosition, Vector3d(1, 0, 0));
+	TEST_EQUAL(move.m_NewPosition, Vector3d(4, 0, 0));
+	TEST_FALSE(move.m_PreviousIsOnGround);
+
+	// Each player is limited separately:
+	TEST_TRUE(limiter.TriggerMove(2, 10, sMove{{0, 5, 0}, {0, 6, 0}, true}, start + std::chrono::milliseconds(110), move));
+	TEST_EQUAL(move.m_NewPosition, Vector3d(0, 6, 0));
+	TEST_EQUAL(limiter.GetNumSubjects(), 2U);
+}
+
+
+
+
+
+/** Tests that the coalesced move of a player that has stopped moving is flushed once the interval has elapsed, only in its world. */
+static void testFlushMoves()
+{
+	const auto start = cClock::now();
+	cHookRateLimiter limiter(std::chrono::milliseconds(100), start);
+	sMove move;
+	cHookRateLimiter::cSubjectMoves moves;
+
+	// Nothing to flush after a call:
+	TEST_TRUE(limiter.TriggerMove(1, 10, sMove{{0, 0, 0}, {1, 0, 0}, true}, start, move));
+	TEST_TRUE(limiter.TriggerMove(2, 20, sMove{{0, 0, 0}, {1, 0, 0}, true}, start, move));
+	limiter.FlushMoves(10, start + std::chrono::seconds(1), moves);
+	TEST_TRUE(moves.empty());
+
+	// The player moves twice and stops, the flush waits for the interval:
+	TEST_FALSE(limiter.TriggerMove(1, 10, sMove{{1, 0, 0}, {2, 0, 0}, true}, start + std::chrono::milliseconds(20), move));
+	TEST_FALSE(limiter.TriggerMove(1, 10, sMove{{2, 0, 0}, {3, 0, 0}, false}, start + std::chrono::milliseconds(40), move));
+	TEST_FALSE(limiter.TriggerMove(2, 20, sMove{{1, 0, 0}, {2, 0, 0}, true}, start + std::chrono::milliseconds(40), move));
+	limiter.FlushMoves(10, start + std::chrono::milliseconds(50), moves);
+	TEST_TRUE(moves.empty());
+
+	// Only the players in the flushed world are flushed:
+	limiter.FlushMoves(10, start + std::chrono::milliseconds(100), moves);
+	TEST_EQUAL(moves.size(), 1U);
+	TEST_EQUAL(moves[0].first, 1U);
+	TEST_EQUAL(moves[0].second.m_OldPosition, Vector3d(1, 0, 0));
+	TEST_EQUAL(moves[0].second.m_NewPosition, Vector3d(3, 0, 0));
+	TEST_TRUE(moves[0].second.m_PreviousIsOnGround);
+
+	// The flushed move counts as a call, the player's next move within the interval is coalesced again:
+	moves.clear();
+	limiter.FlushMoves(10, start + std::chrono::milliseconds(200), moves);
+	TEST_TRUE(moves.empty());
+	TEST_FALSE(limiter.TriggerMove(1, 10, sMove{{3, 0, 0}, {4, 0, 0}, true}, start + std::chrono::milliseconds(150), move));
+
+	// A move pending in a world that the player has left is dropped, the coalescing starts afresh in the new world:
+	TEST_TRUE(limiter.TriggerMove(2, 10, sMove{{7, 0, 0}, {8, 0, 0}, true}, start + std::chrono::milliseconds(200), move));
+	TEST_EQUAL(move.m_OldPosition, Vector3d(7, 0, 0));
+	limiter.FlushMoves(20, start + std::chrono::seconds(1), moves);
+	TEST_TRUE(moves.empty());
+}
+
+
+
+
+
+/** Tests that the subjects that stop triggering the hook, such as unloaded worlds, are dropped after a while. */
+static void testPurge()
+{
+	const auto start = cClock::now();
+	cHookRateLimiter limiter(std::chrono::milliseconds(100), start);
+	float dt = 0;
+	limiter.Trigger(1, 50, start, dt);
+	limiter.Trigger(2, 50, start, dt);
+
+	// Only subject 1 keeps ticking; subject 2 is kept until it has been gone for the purge age:
+	auto now = start;
+	while (now - start < cHookRateLimiter::PURGE_AGE)
+	{
+		now += std::chrono::seconds(1);
+		limiter.Trigger(1, 1000, now, dt);
+		TEST_EQUAL(limiter.GetNumSubjects(), 2U);
+	}
+	now += cHookRateLimiter::PURGE_AGE;
+	limiter.Trigger(1, 1000, now, dt);
+	TEST_EQUAL(limiter.GetNumSubjects(), 1U);
+
+	// A subject that comes back starts afresh, with a call right away:
+	TEST_TRUE(limiter.Trigger(2, 50, now, dt));
+	TEST_EQUAL(dt, 50.0f);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("HookRateLimiter",
+	testSupportedHooks();
+	testCoalescing();
+	testSubjects();
+	testMoves();
+	testFlushMoves();
+	testPurge();
+)
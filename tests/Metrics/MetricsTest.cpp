@@ -0,0 +1,175 @@
+// MetricsTest.cpp
+
+// Tests the cMetrics registry: the histogram buckets and percentiles, the registration and the Prometheus export
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "Metrics.h"
+
+
+
+
+
+/** Tests that the histogram buckets cover all the values in order, with the bounded relative error. */
+static void testHistogramBuckets()
+{
+	// Each bucket starts where the previous one ended:
+	for (size_t i = 1; i < cMetricHistogram::NumBuckets; i++)
+	{
+		auto lower = cMetricHistogram::BucketLowerBound(i);
+		TEST_EQUAL(cMetricHistogram::BucketIndex(lower), i);
+		TEST_EQUAL(cMetricHistogram::BucketIndex(lower - 1), i - 1);
+	}
+
+	// The width of each bucket is at most 1 / NumSubBuckets of its lower bound:
+	for (size_t i = cMetricHistogram::NumSubBuckets; i + 1 < cMetricHistogram::NumBuckets; i++)
+	{
+		auto lower = cMetricHistogram::BucketLowerBound(i);
+		auto width = cMetricHistogram::BucketLowerBound(i + 1) - lower;
+		TEST_LESS_THAN_OR_EQUAL(width * cMetricHistogram::NumSubBuckets, lower);
+	}
+
+	// The huge values are clamped into the last bucket:
+	TEST_EQUAL(cMetricHistogram::BucketIndex(cMetricHistogram::MaxValueNs), cMetricHistogram::NumBuckets - 1);
+	TEST_EQUAL(cMetricHistogram::BucketIndex(std::numeric_limits<UInt64>::max()), cMetricHistogram::NumBuckets - 1);
+}
+
+
+
+
+
+/** Tests the histogram statistics. */
+static void testHistogramPercentiles()
+{
+	cMetricHistogram histogram;
+	TEST_EQUAL(histogram.GetPercentile(0.5).count(), 0);
+
+	// 1 .. 1000 microseconds:
+	for (int i = 1; i <= 1000; i++)
+	{
+		histogram.Record(std::chrono::microseconds(i));
+	}
+	TEST_EQUAL(histogram.GetCount(), 1000U);
+	TEST_EQUAL(histogram.GetMax(), std::chrono::microseconds(1000));
+	TEST_EQUAL(histogram.GetSum(), std::chrono::microseconds(500500));
+	auto p50 = static_cast<double>(histogram.GetPercentile(0.5).count());
+	auto p99 = static_cast<double>(histogram.GetPercentile(0.99).count());
+	TEST_GREATER_THAN_OR_EQUAL(p50, 500000.0);
+	TEST_LESS_THAN_OR_EQUAL(p50, 500000.0 * 1.125);
+	TEST_GREATER_THAN_OR_EQUAL(p99, 990000.0);
+	TEST_LESS_THAN_OR_EQUAL(p99, 1000000.0);
+	TEST_EQUAL(histogram.GetPercentile(1), std::chrono::microseconds(1000));
+
+	// Negative durations count as zero:
+	histogram.Record(std::chrono::nanoseconds(-5));
+	TEST_EQUAL(histogram.GetPercentile(0).count(), 1);
+}
+
+
+
+
+
+/** Tests that the registry returns the same metric for the same name and labels, and refuses the conflicting registrations. */
+static void testRegistry()
+{
+	cMetrics metrics;
+	auto & counter = metrics.GetCounter("test_packets_total", "Packets", {{"direction", "in"}});
+	counter.Add();
+	counter.Add(2);
+	TEST_EQUAL(&metrics.GetCounter("test_packets_total", "Packets", {{"direction", "in"}}), &counter);
+	TEST_NOTEQUAL(&metrics.GetCounter("test_packets_total", "Packets", {{"direction", "out"}}), &counter);
+	TEST_EQUAL(counter.GetValue(), 3U);
+
+	TEST_THROWS(metrics.GetGauge("test_packets_total", "Packets"), std::logic_error);
+	TEST_THROWS(metrics.GetGauge("0invalid", "Invalid"), std::logic_error);
+	TEST_THROWS(metrics.GetGauge("test_gauge", "Invalid label", {{"bad-label", "x"}}), std::logic_error);
+	TEST_THROWS(metrics.GetHistogram("test_histogram", "Reserved label", {{"le", "x"}}), std::logic_error);
+
+	auto & gauge = metrics.GetGauge("test_queue_length", "Queue");
+	gauge.Set(10);
+	gauge.Add(-3);
+	TEST_EQUAL(gauge.GetValue(), 7);
+
+	auto samples = metrics.GetSamples();
+	TEST_EQUAL(samples.size(), 3U);
+	TEST_EQUAL(samples[0].m_Name, "test_packets_total");
+	TEST_EQUAL(samples[0].m_Labels.at("direction"), "in");
+	TEST_EQUAL(samples[0].m_Value, 3);
+	TEST_EQUAL(samples[2].m_Value, 7);
+}
+
+
+
+
+
+/** Tests the Prometheus text format of each metric type. */
+static void testPrometheusExport()
+{
+	cMetrics metrics;
+	metrics.GetCounter("test_total", "A \"counter\"\nwith\\escapes", {{"world", "a\"b"}}).Add(5);
+	auto & histogram = metrics.GetHistogram("test_seconds", "A histogram");
+	histogram.Record(std::chrono::microseconds(10));
+	histogram.Record(std::chrono::milliseconds(2));
+	histogram.Record(std::chrono::seconds(100));
+	metrics.GetHistogram("test_seconds", "A histogram", {{"phase", "mobs"}}).Record(std::chrono::microseconds(1));
+
+	auto text = metrics.GetPrometheusText();
+	TEST_NOTEQUAL(text.find("# HELP test_total A \"counter\"\\nwith\\\\escapes\n"), AString::npos);
+	TEST_NOTEQUAL(text.find("# TYPE test_total counter\n"), AString::npos);
+	TEST_NOTEQUAL(text.find("test_total{world=\"a\\\"b\"} 5\n"), AString::npos);
+	TEST_NOTEQUAL(text.find("# TYPE test_seconds histogram\n"), AString::npos);
+	TEST_NOTEQUAL(text.find("test_seconds_bucket{le=\"4.096e-06\"} 0\n"), AString::npos);
+	TEST_NOTEQUAL(text.find("test_seconds_bucket{le=\"1.6384e-05\"} 1\n"), AString::npos);
+	TEST_NOTEQUAL(text.find("test_seconds_bucket{le=\"68.719476736\"} 2\n"), AString::npos);
+	TEST_NOTEQUAL(text.find("test_seconds_bucket{le=\"+Inf\"} 3\n"), AString::npos);
+	TEST_NOTEQUAL(text.find("test_seconds_count 3\n"), AString::npos);
+	TEST_NOTEQUAL(text.find("test_seconds_bucket{phase=\"mobs\",le=\"4.096e-06\"} 1\n"), AString::npos);
+	TEST_NOTEQUAL(text.find("test_seconds_count{phase=\"mobs\"} 1\n"), AString::npos);
+
+	// The family header is written only once:
+	TEST_EQUAL(text.find("# TYPE test_seconds"), text.rfind("# TYPE test_seconds"));
+}
+
+
+
+
+
+/** Tests that the metrics updated from several threads don't lose any values. */
+static void testThreaded()
+{
+	cMetrics metrics;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&metrics, t]()
+			{
+				auto & counter = metrics.GetCounter("test_threaded_total", "Threaded");
+				auto & histogram = metrics.GetHistogram("test_threaded_seconds", "Threaded", {{"thread", std::to_string(t % 2)}});
+				for (int i = 0; i < 100000; i++)
+				{
+					counter.Add();
+					histogram.RecordNs(static_cast<UInt64>(i));
+				}
+			}
+		);
+	}
+	for (auto & thread: threads)
+	{
+		thread.join();
+	}
+	TEST_EQUAL(metrics.GetCounter("test_threaded_total", "Threaded").GetValue(), 400000U);
+	TEST_EQUAL(metrics.GetHistogram("test_threaded_seconds", "Threaded", {{"thread", "0"}}).GetCount(), 200000U);
+	TEST_EQUAL(metrics.GetHistogram("test_threaded_seconds", "Threaded", {{"thread", "1"}}).GetMax().count(), 99999);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("Metrics",
+	testHistogramBuckets();
+	testHistogramPercentiles();
+	testRegistry();
+	testPrometheusExport();
+	testThreaded();
+)
@@ -1,11 +1,12 @@
 
 // EchoServer.cpp
 
-// Implements an Echo server using the LibEvent-based cNetwork API, as a test of that API
+// Implements an Echo server using the LibEvent-based cNetwork API, and measures its throughput
+// Usage: EchoServer [<seconds per measurement>] [<max event loops>]
+// For an increasing number of the network event loops, connects an increasing number of clients to the server,
+// each client keeping a block of data bouncing off the server, and logs the connection rate and the echoed data rate.
 
 #include "Globals.h"
-#include <iostream>
-#include <string>
 #include "OSSupport/Network.h"
 #include "OSSupport/NetworkSingleton.h"
 
@@ -13,6 +14,35 @@
 
 
 
+/** The port on which the echo server listens. */
+static const UInt16 PORT = 9876;
+
+/** The size of the data block each client keeps bouncing off the server. */
+static const size_t BLOCK_SIZE = 16 KiB;
+
+
+
+
+
+/** The number of the server-side links that haven't been closed yet. */
+static std::atomic<int> g_NumServerLinks(0);
+
+
+
+
+
+/** The counters shared by all the clients of a single measurement. */
+struct sStats
+{
+	std::atomic<UInt64> m_BytesReceived{0};
+	std::atomic<int> m_NumConnected{0};
+	std::atomic<int> m_NumFailed{0};
+};
+
+
+
+
+
 /** cTCPLink callbacks that echo everything they receive back to the remote peer. */
 class cEchoLinkCallbacks:
 	public cTCPLink::cCallbacks
@@ -22,6 +52,7 @@ class cEchoLinkCallbacks:
 	{
 		ASSERT(m_Link == nullptr);
 		m_Link = a_Link;
+		g_NumServerLinks += 1;
 	}
 
 
@@ -30,38 +61,24 @@ class cEchoLinkCallbacks:
 		ASSERT(m_Link != nullptr);
 
 		// Echo the incoming data back to outgoing data:
-		LOGD("%p (%s:%d): Data received (%u bytes), echoing back.", static_cast<void *>(m_Link.get()), m_Link->GetRemoteIP().c_str(), m_Link->GetRemotePort(), static_cast<unsigned>(a_Size));
 		m_Link->Send(a_Data, a_Size);
-		LOGD("Echo queued");
-
-		// Search for a Ctrl+Z, if found, drop the connection:
-		for (size_t i = 0; i < a_Size; i++)
-		{
-			if (a_Data[i] == '\x1a')
-			{
-				m_Link->Close();
-				m_Link.reset();
-				return;
-			}
-		}
 	}
 
 
 	virtual void OnRemoteClosed(void) override
 	{
 		ASSERT(m_Link != nullptr);
-
-		LOGD("%p (%s:%d): Remote has closed the connection.", static_cast<void *>(m_Link.get()), m_Link->GetRemoteIP().c_str(), m_Link->GetRemotePort());
 		m_Link.reset();
+		g_NumServerLinks -= 1;
 	}
 
 
 	virtual void OnError(int a_ErrorCode, const AString & a_ErrorMsg) override
 	{
+		// The benchmark clients drop their connections, the resets are expected:
 		ASSERT(m_Link != nullptr);
-
-		LOGD("%p (%s:%d): Error %d in the cEchoLinkCallbacks: %s", static_cast<void *>(m_Link.get()), m_Link->GetRemoteIP().c_str(), m_Link->GetRemotePort(), a_ErrorCode, a_ErrorMsg.c_str());
 		m_Link.reset();
+		g_NumServerLinks -= 1;
 	}
 
 	/** The link attached to this callbacks instance. */
@@ -77,16 +94,11 @@ class cEchoServerCallbacks:
 {
 	virtual cTCPLink::cCallbacksPtr OnIncomingConnection(const AString & a_RemoteIPAddress, UInt16 a_RemotePort) override
 	{
-		LOGD("New incoming connection(%s:%d).", a_RemoteIPAddress.c_str(), a_RemotePort);
 		return std::make_shared<cEchoLinkCallbacks>();
 	}
 
 	virtual void OnAccepted(cTCPLink & a_Link) override
 	{
-		LOGD("New client accepted (%s:%d), sending welcome message.", a_Link.GetRemoteIP().c_str(), a_Link.GetRemotePort());
-		// Send a welcome message to each connecting client:
-		a_Link.Send("Welcome to the simple echo server.\r\n");
-		LOGD("Welcome message queued.");
 	}
 
 	virtual void OnError(int a_ErrorCode, const AString & a_ErrorMsg) override
@@ -99,47 +111,172 @@ class cEchoServerCallbacks:
 
 
 
-static void DoTest(void)
+/** A client that sends a block of data upon connecting, and then sends back everything it receives from the echo server. */
+class cBenchmarkClient:
+	public cNetwork::cConnectCallbacks,
+	public cTCPLink::cCallbacks
 {
-	LOGD("EchoServer: starting up");
-	cServerHandlePtr Server = cNetwork::Listen(9876, std::make_shared<cEchoServerCallbacks>());
-	if (!Server->IsListening())
-	{
-		LOGWARNING("Cannot listen on port 9876");
-		abort();
-	}
-	ASSERT(Server->IsListening());
-
-	// Wait for the user to terminate the server:
-	printf("Press enter to close the server.\n");
-	AString line;
-	std::getline(std::cin, line);
-
-	// Close the server and all its active connections:
-	LOG("Server terminating.");
-	Server->Close();
-	ASSERT(!Server->IsListening());
-	Server.reset();
-	LOGD("Server has been closed.");
-}
+public:
 
+	cBenchmarkClient(sStats & a_Stats):
+		m_Stats(a_Stats)
+	{
+	}
+
+	/** Drops the connection. */
+	void Close(void)
+	{
+		if (m_Link != nullptr)
+		{
+			m_Link->Close();
+		}
+	}
+
+	/** Releases the link, breaking the ownership cycle between the link and its callbacks. Call after Close(). */
+	void Release(void)
+	{
+		m_Link.reset();
+	}
+
+protected:
 
+	sStats & m_Stats;
 
+	/** The link to the server. Released by Release(), so that the callbacks don't race with the benchmark thread. */
+	cTCPLinkPtr m_Link;
+
+
+	// cNetwork::cConnectCallbacks overrides:
+	virtual void OnConnected(cTCPLink & a_Link) override
+	{
+		a_Link.Send(AString(BLOCK_SIZE, 'x'));
+		m_Stats.m_NumConnected += 1;
+	}
 
+	// cTCPLink::cCallbacks overrides:
+	virtual void OnLinkCreated(cTCPLinkPtr a_Link) override
+	{
+		m_Link = a_Link;
+	}
 
-int main()
+	virtual void OnReceivedData(const char * a_Data, size_t a_Size) override
+	{
+		m_Stats.m_BytesReceived += a_Size;
+		m_Link->Send(a_Data, a_Size);
+	}
+
+	virtual void OnRemoteClosed(void) override
+	{
+	}
+
+	// Shared by both the callbacks interfaces:
+	virtual void OnError(int a_ErrorCode, const AString & a_ErrorMsg) override
+	{
+		LOGD("Benchmark client error %d: %s", a_ErrorCode, a_ErrorMsg.c_str());
+		m_Stats.m_NumFailed += 1;
+	}
+};
+
+
+
+
+
+/** Connects the specified number of clients to the echo server, measures the echoed data rate for the specified time and logs the results. */
+static void measure(size_t a_NumEventLoops, int a_NumClients, std::chrono::milliseconds a_Duration)
 {
-	DoTest();
+	using namespace std::chrono;
 
-	printf("Press enter to exit test.\n");
-	AString line;
-	std::getline(std::cin, line);
-	cNetworkSingleton::Get().Terminate();
+	// Connect all the clients:
+	sStats Stats;
+	std::vector<std::shared_ptr<cBenchmarkClient>> Clients;
+	auto Start = steady_clock::now();
+	for (int i = 0; i < a_NumClients; i++)
+	{
+		auto Client = std::make_shared<cBenchmarkClient>(Stats);
+		cNetwork::Connect("127.0.0.1", PORT, Client, Client);
+		Clients.push_back(std::move(Client));
+	}
+	while ((Stats.m_NumConnected + Stats.m_NumFailed < a_NumClients) && (steady_clock::now() - Start < 10s))
+	{
+		std::this_thread::sleep_for(1ms);
+	}
+	auto ConnectMSec = duration<double, std::milli>(steady_clock::now() - Start).count();
+
+	// Measure the echoed data:
+	auto BytesBefore = Stats.m_BytesReceived.load();
+	Start = steady_clock::now();
+	std::this_thread::sleep_for(a_Duration);
+	auto Bytes = Stats.m_BytesReceived.load() - BytesBefore;
+	auto Seconds = duration<double>(steady_clock::now() - Start).count();
+
+	LOG("%2u event loops, %4d clients (%d failed): connected in %8.2f ms, echoed %8.1f MiB / s",
+		static_cast<unsigned>(a_NumEventLoops), a_NumClients, Stats.m_NumFailed.load(), ConnectMSec,
+		static_cast<double>(Bytes) / Seconds / 1024 / 1024
+	);
+
+	// Disconnect the clients; give the callbacks already in progress time to finish before releasing the links:
+	for (auto & Client: Clients)
+	{
+		Client->Close();
+	}
+	std::this_thread::sleep_for(100ms);
+	for (auto & Client: Clients)
+	{
+		Client->Release();
+	}
+	Clients.clear();
 
-	LOG("Network test finished.");
-	return 0;
+	// Wait for the server to notice, so that the next measurement starts clean:
+	Start = steady_clock::now();
+	while ((g_NumServerLinks > 0) && (steady_clock::now() - Start < 10s))
+	{
+		std::this_thread::sleep_for(1ms);
+	}
 }
 
 
 
 
+
+int main(int argc, char ** argv)
+{
+	std::chrono::milliseconds Duration(1000);
+	if (argc > 1)
+	{
+		Duration = std::chrono::milliseconds(static_cast<int>(std::stod(argv[1]) * 1000));
+	}
+
+	auto MaxEventLoops = std::max(std::thread::hardware_concurrency(), 1U);
+	if (argc > 2)
+	{
+		MaxEventLoops = static_cast<unsigned>(std::max(std::stoi(argv[2]), 1));
+	}
+	for (unsigned NumEventLoops = 1;; NumEventLoops = std::min(NumEventLoops * 2, MaxEventLoops))
+	{
+		cNetworkSingleton::Get().Initialise(NumEventLoops);
+		cServerHandlePtr Server = cNetwork::Listen(PORT, std::make_shared<cEchoServerCallbacks>());
+		if (!Server->IsListening())
+		{
+			LOGWARNING("Cannot listen on port %d", PORT);
+			abort();
+		}
+
+		for (int NumClients = 1; NumClients <= 256; NumClients *= 4)
+		{
+			measure(cNetworkSingleton::Get().GetNumEventLoops(), NumClients, Duration);
+		}
+
+		// Close the server and all its active connections:
+		Server->Close();
+		Server.reset();
+		cNetworkSingleton::Get().Terminate();
+
+		if (NumEventLoops == MaxEventLoops)
+		{
+			break;
+		}
+	}
+
+	LOG("Network benchmark finished.");
+	return 0;
+}
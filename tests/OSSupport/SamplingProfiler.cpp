@@ -0,0 +1,97 @@
+// SamplingProfiler.cpp
+
+// Tests that the cSamplingProfiler captures the stacks of a busy thread and exports them in the folded format
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "OSSupport/IsThread.h"
+#include "OSSupport/SamplingProfiler.h"
+
+
+
+
+
+/** A thread that keeps the CPU busy until stopped. */
+class cBusyThread:
+	public cIsThread
+{
+public:
+
+	cBusyThread(void):
+		cIsThread("Busy thread")
+	{
+	}
+
+	std::atomic<UInt64> m_Counter{0};
+
+protected:
+
+	virtual void Execute(void) override
+	{
+		while (!m_ShouldTerminate)
+		{
+			m_Counter.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+};
+
+
+
+
+
+static void testSampling()
+{
+	cSamplingProfiler profiler;
+	if (!cSamplingProfiler::IsSupported())
+	{
+		LOG("Stack sampling is not supported on this platform, skipping the test");
+		return;
+	}
+
+	cBusyThread thread;
+	thread.Start();
+	profiler.TrackThread(thread, "Busy");
+	for (int i = 0; i < 50; i++)
+	{
+		profiler.Sample();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	profiler.UntrackThread(thread);
+	thread.Stop();
+	TEST_GREATER_THAN_OR_EQUAL(profiler.GetNumSamples(), 40U);
+	TEST_EQUAL(profiler.GetNumSamples() + profiler.GetNumFailedSamples(), 50U);
+
+	// Each line is the thread's name, the frames and the number of samples; the counts add up to the number of samples:
+	auto folded = profiler.GetFoldedStacks();
+	UInt64 numSamples = 0;
+	for (const auto & line: StringSplit(folded, "\n"))
+	{
+		if (line.empty())
+		{
+			continue;
+		}
+		TEST_EQUAL(line.compare(0, 5, "Busy;"), 0);
+		auto space = line.rfind(' ');
+		TEST_NOTEQUAL(space, AString::npos);
+		UInt64 count = 0;
+		TEST_TRUE(StringToInteger(line.substr(space + 1), count));
+		numSamples += count;
+	}
+	TEST_EQUAL(numSamples, profiler.GetNumSamples());
+
+	// The untracked thread is no longer sampled:
+	profiler.Sample();
+	TEST_EQUAL(profiler.GetNumSamples() + profiler.GetNumFailedSamples(), 50U);
+
+	profiler.Clear();
+	TEST_EQUAL(profiler.GetNumSamples(), 0U);
+	TEST_EQUAL(profiler.GetFoldedStacks(), "");
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("SamplingProfiler",
+	testSampling();
+)
@@ -0,0 +1,127 @@
+// ThreadPool.cpp
+
+// Tests the cThreadPool: running batches from several threads at once and from within the tasks
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "OSSupport/ThreadPool.h"
+
+
+
+
+
+/** Tests that all the tasks of a batch are run exactly once, before RunAll() returns. */
+static void testRunAll(cThreadPool & a_Pool)
+{
+	std::vector<std::atomic<int>> NumRuns(100);
+	std::vector<cThreadPool::cTask> Tasks;
+	for (auto & Runs : NumRuns)
+	{
+		Tasks.emplace_back([&Runs]()
+			{
+				Runs += 1;
+			}
+		);
+	}
+	a_Pool.RunAll(Tasks);
+	for (const auto & Runs : NumRuns)
+	{
+		TEST_EQUAL(Runs.load(), 1);
+	}
+
+	// An empty batch is fine, too:
+	a_Pool.RunAll({});
+}
+
+
+
+
+
+/** Tests that the tasks can use the pool themselves without a deadlock, even if there are more of them than the workers. */
+static void testNested(cThreadPool & a_Pool)
+{
+	std::atomic<int> NumRuns(0);
+	std::vector<cThreadPool::cTask> Inner;
+	for (int i = 0; i < 10; i++)
+	{
+		Inner.emplace_back([&NumRuns]()
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				NumRuns += 1;
+			}
+		);
+	}
+	std::vector<cThreadPool::cTask> Outer;
+	for (int i = 0; i < 10; i++)
+	{
+		Outer.emplace_back([&a_Pool, &Inner]()
+			{
+				a_Pool.RunAll(Inner);
+			}
+		);
+	}
+	a_Pool.RunAll(Outer);
+	TEST_EQUAL(NumRuns.load(), 100);
+}
+
+
+
+
+
+/** Tests several threads running their batches at the same time. */
+static void testConcurrentBatches(cThreadPool & a_Pool)
+{
+	std::vector<std::thread> Threads;
+	std::atomic<int> NumRuns(0);
+	for (int i = 0; i < 4; i++)
+	{
+		Threads.emplace_back([&a_Pool, &NumRuns]()
+			{
+				for (int j = 0; j < 100; j++)
+				{
+					std::vector<std::atomic<int>> BatchRuns(j % 7 + 1);
+					std::vector<cThreadPool::cTask> Tasks;
+					for (auto & Runs : BatchRuns)
+					{
+						Tasks.emplace_back([&Runs, &NumRuns]()
+							{
+								Runs += 1;
+								NumRuns += 1;
+							}
+						);
+					}
+					a_Pool.RunAll(Tasks);
+					for (const auto & Runs : BatchRuns)
+					{
+						TEST_EQUAL(Runs.load(), 1);
+					}
+				}
+			}
+		);
+	}
+	for (auto & Thread : Threads)
+	{
+		Thread.join();
+	}
+	int Expected = 0;
+	for (int j = 0; j < 100; j++)
+	{
+		Expected += 4 * (j % 7 + 1);
+	}
+	TEST_EQUAL(NumRuns.load(), Expected);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("ThreadPool",
+	for (size_t NumWorkers : {0U, 1U, 3U})
+	{
+		cThreadPool Pool(NumWorkers);
+		TEST_EQUAL(Pool.GetConcurrency(), NumWorkers + 1);
+		testRunAll(Pool);
+		testNested(Pool);
+		testConcurrentBatches(Pool);
+	}
+)
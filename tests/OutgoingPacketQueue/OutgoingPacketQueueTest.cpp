@@ -0,0 +1,260 @@
+// OutgoingPacketQueueTest.cpp
+
+// Tests the cOutgoingPacketQueue: the order of the priority classes, the entity spawns following their chunk, holding back the chunk data
+// and marking the chunks that have left the queue
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "Protocol/OutgoingPacketQueue.h"
+
+
+
+
+
+using ePriority = cOutgoingPacketQueue::ePriority;
+using cClock = cOutgoingPacketQueue::cClock;
+
+/** The link queue size above which the tested queues hold back the chunk data. */
+static const size_t MaxLinkQueueSize = 100;
+
+/** The queued chunk data size above which the tested queues report congestion. */
+static const size_t MaxQueuedChunkData = 10;
+
+
+
+
+
+/** Returns the data consisting of the single byte. */
+static ContiguousByteBuffer makeData(char aValue)
+{
+	return ContiguousByteBuffer(1, static_cast<std::byte>(aValue));
+}
+
+
+
+
+
+/** Pops the data to be sent from the queue, as a string, for a link that has aLinkQueueSize bytes to send. */
+static AString pop(cOutgoingPacketQueue & aQueue, size_t aLinkQueueSize, cClock::time_point aNow = cClock::now())
+{
+	ContiguousByteBuffer out;
+	aQueue.Pop(out, aLinkQueueSize, aNow);
+	return AString(reinterpret_cast<const char *>(out.data()), out.size());
+}
+
+
+
+
+
+/** Tests that the classes are sent out in the order of their priority, and the data within a class in the order of queueing. */
+static void testOrder()
+{
+	cOutgoingPacketQueue queue(MaxLinkQueueSize, MaxQueuedChunkData);
+	queue.Push(makeData('c'), ePriority::Chunk);
+	queue.Push(makeData('e'), ePriority::Entity);
+	queue.Push(makeData('C'), ePriority::Critical);
+	queue.Push(makeData('d'), ePriority::Chunk);
+	queue.Push(makeData('f'), ePriority::Entity);
+	queue.Push(makeData('D'), ePriority::Critical);
+	TEST_EQUAL(queue.GetNumQueuedBytes(ePriority::Critical), 2U);
+	TEST_EQUAL(queue.GetNumQueuedBytes(ePriority::Entity), 2U);
+	TEST_EQUAL(queue.GetNumQueuedBytes(ePriority::Chunk), 2U);
+
+	TEST_EQUAL(pop(queue, 0), "CDefcd");
+	TEST_EQUAL(pop(queue, 0), "");
+	TEST_EQUAL(queue.GetNumQueuedBytes(ePriority::Chunk), 0U);
+}
+
+
+
+
+
+/** Tests that the entity spawns are sent after the chunk data queued before them,
+and that the entity data queued after a spawn doesn't overtake it. */
+static void testSpawns()
+{
+	cOutgoingPacketQueue queue(MaxLinkQueueSize, MaxQueuedChunkData);
+
+	// The chunk sender sends the chunk and then spawns its entities, which are updated later on:
+	queue.Push(makeData('e'), ePriority::Entity);
+	queue.Push(makeData('c'), ePriority::Chunk);
+	queue.Push(makeData('s'), ePriority::EntitySpawn);
+	queue.Push(makeData('m'), ePriority::Entity);
+	queue.Push(makeData('C'), ePriority::Critical);
+	TEST_EQUAL(queue.GetNumQueuedBytes(ePriority::EntitySpawn), 3U);
+	TEST_EQUAL(pop(queue, 0), "Cecsm");
+
+	// Once the spawns have been sent, the entity data takes precedence over the chunk data again:
+	queue.Push(makeData('c'), ePriority::Chunk);
+	queue.Push(makeData('m'), ePriority::Entity);
+	TEST_EQUAL(pop(queue, 0), "mc");
+
+	// While the spawns are held back, the entity data queued after them is held back with them:
+	queue.Push(makeData('c'), ePriority::Chunk);
+	queue.Push(makeData('s'), ePriority::EntitySpawn);
+	queue.Push(makeData('m'), ePriority::Entity);
+	queue.Push(makeData('C'), ePriority::Critical);
+	TEST_EQUAL(pop(queue, MaxLinkQueueSize), "C");
+	queue.Push(makeData('n'), ePriority::Entity);
+	TEST_EQUAL(pop(queue, MaxLinkQueueSize), "");
+	TEST_EQUAL(pop(queue, 0), "csmn");
+	queue.Push(makeData('m'), ePriority::Entity);
+	TEST_EQUAL(queue.GetNumQueuedBytes(ePriority::Entity), 1U);
+}
+
+
+
+
+
+/** Tests that the chunk data is held back while the link is congested, and the stalls are counted. */
+static void testHoldBack()
+{
+	cOutgoingPacketQueue queue(MaxLinkQueueSize, MaxQueuedChunkData);
+	const auto start = cClock::now();
+
+	// Nothing is held back without chunk data, not even on a congested link, and no stall is counted:
+	queue.Push(makeData('e'), ePriority::Entity);
+	TEST_EQUAL(pop(queue, MaxLinkQueueSize, start), "e");
+	TEST_EQUAL(queue.GetNumStalls(), 0U);
+	TEST_FALSE(queue.IsStalled());
+
+	// The chunk data is held back on a congested link, the rest goes out:
+	queue.Push(makeData('c'), ePriority::Chunk);
+	queue.Push(makeData('C'), ePriority::Critical);
+	queue.Push(makeData('e'), ePriority::Entity);
+	TEST_EQUAL(pop(queue, MaxLinkQueueSize, start), "Ce");
+	TEST_TRUE(queue.IsStalled());
+	TEST_EQUAL(queue.GetNumStalls(), 1U);
+
+	// More chunk data queues up behind it, a single stall lasts until the link catches up:
+	queue.Push(makeData('d'), ePriority::Chunk);
+	TEST_EQUAL(pop(queue, MaxLinkQueueSize + 1, start + std::chrono::milliseconds(100)), "");
+	TEST_EQUAL(queue.GetNumStalls(), 1U);
+	TEST_TRUE((queue.GetStallTime(start + std::chrono::milliseconds(150)) == std::chrono::milliseconds(150)));
+	TEST_EQUAL(pop(queue, MaxLinkQueueSize - 1, start + std::chrono::milliseconds(200)), "cd");
+	TEST_FALSE(queue.IsStalled());
+	TEST_TRUE((queue.GetStallTime(start + std::chrono::seconds(10)) == std::chrono::milliseconds(200)));
+
+	// Another stall adds up:
+	queue.Push(makeData('c'), ePriority::Chunk);
+	TEST_EQUAL(pop(queue, MaxLinkQueueSize, start + std::chrono::seconds(1)), "");
+	TEST_EQUAL(pop(queue, 0, start + std::chrono::milliseconds(1300)), "c");
+	TEST_EQUAL(queue.GetNumStalls(), 2U);
+	TEST_TRUE((queue.GetStallTime(start + std::chrono::seconds(10)) == std::chrono::milliseconds(500)));
+}
+
+
+
+
+
+/** Tests the congestion reported to the chunk streaming, on a backed up link or with too much chunk data held back. */
+static void testCongestion()
+{
+	cOutgoingPacketQueue queue(MaxLinkQueueSize, MaxQueuedChunkData);
+	TEST_FALSE(queue.IsCongested(0));
+	TEST_FALSE(queue.IsCongested(MaxLinkQueueSize - 1));
+	TEST_TRUE(queue.IsCongested(MaxLinkQueueSize));
+
+	// The critical and entity data don't count, only the chunk data does:
+	for (size_t i = 0; i < MaxQueuedChunkData; i++)
+	{
+		queue.Push(makeData('C'), ePriority::Critical);
+		queue.Push(makeData('e'), ePriority::Entity);
+	}
+	TEST_FALSE(queue.IsCongested(0));
+	for (size_t i = 0; i < MaxQueuedChunkData - 1; i++)
+	{
+		queue.Push(makeData('c'), ePriority::Chunk);
+	}
+	TEST_FALSE(queue.IsCongested(0));
+	queue.Push(makeData('s'), ePriority::EntitySpawn);
+	TEST_TRUE(queue.IsCongested(0));
+
+	pop(queue, 0);
+	TEST_FALSE(queue.IsCongested(0));
+}
+
+
+
+
+
+/** Tests that all the data is flushed when the link closes, and that leaving a world drops its data, spawns included. */
+static void testPopAllAndClear()
+{
+	cOutgoingPacketQueue queue(MaxLinkQueueSize, MaxQueuedChunkData);
+	queue.Push(makeData('c'), ePriority::Chunk);
+	queue.Push(makeData('s'), ePriority::EntitySpawn);
+	queue.Push(makeData('m'), ePriority::Entity);
+	queue.Push(makeData('C'), ePriority::Critical);
+	TEST_EQUAL(pop(queue, MaxLinkQueueSize), "C");
+
+	ContiguousByteBuffer out;
+	queue.PopAll(out);
+	TEST_TRUE((out == ContiguousByteBuffer(reinterpret_cast<const std::byte *>("csm"), 3)));
+
+	// Leaving the world drops the spawns, the entity data doesn't wait for them anymore:
+	queue.Push(makeData('c'), ePriority::Chunk);
+	queue.Push(makeData('s'), ePriority::EntitySpawn);
+	queue.Push(makeData('C'), ePriority::Critical);
+	queue.ClearWorldData();
+	queue.Push(makeData('m'), ePriority::Entity);
+	queue.Push(makeData('d'), ePriority::Chunk);
+	TEST_EQUAL(pop(queue, 0), "Cmd");
+}
+
+
+
+
+
+/** Tests that a chunk data mark is reached once the chunk has left the queue, regardless of the chunks queued after it. */
+static void testChunkDataMark()
+{
+	cOutgoingPacketQueue queue(MaxLinkQueueSize, MaxQueuedChunkData);
+	TEST_TRUE(queue.HasPopped(queue.GetChunkDataMark()));
+
+	// The other classes don't move the mark:
+	queue.Push(makeData('C'), ePriority::Critical);
+	queue.Push(makeData('e'), ePriority::Entity);
+	TEST_TRUE(queue.HasPopped(queue.GetChunkDataMark()));
+
+	// The mark of a chunk held back on a congested link isn't reached:
+	queue.Push(makeData('c'), ePriority::Chunk);
+	const auto mark = queue.GetChunkDataMark();
+	TEST_FALSE(queue.HasPopped(mark));
+	TEST_EQUAL(pop(queue, MaxLinkQueueSize), "Ce");
+	TEST_FALSE(queue.HasPopped(mark));
+
+	// Once the chunk is sent, the mark is reached, even though more chunks are queued after it:
+	TEST_EQUAL(pop(queue, 0), "c");
+	queue.Push(makeData('d'), ePriority::Chunk);
+	queue.Push(makeData('s'), ePriority::EntitySpawn);
+	queue.Push(makeData('m'), ePriority::Entity);
+	TEST_TRUE(queue.HasPopped(mark));
+	const auto nextMark = queue.GetChunkDataMark();
+	TEST_FALSE(queue.HasPopped(nextMark));
+
+	// The entity data held back behind the spawn counts as chunk data:
+	queue.Push(makeData('n'), ePriority::Entity);
+	TEST_FALSE((queue.GetChunkDataMark() == nextMark));
+
+	// Dropping the data of the world counts as having left the queue:
+	queue.ClearWorldData();
+	TEST_TRUE(queue.HasPopped(queue.GetChunkDataMark()));
+	queue.Push(makeData('c'), ePriority::Chunk);
+	ContiguousByteBuffer out;
+	queue.PopAll(out);
+	TEST_TRUE(queue.HasPopped(queue.GetChunkDataMark()));
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("OutgoingPacketQueue",
+	testOrder();
+	testSpawns();
+	testHoldBack();
+	testCongestion();
+	testPopAllAndClear();
+	testChunkDataMark();
+)
@@ -0,0 +1,155 @@
+// PermissionTrieBenchmark.cpp
+
+// Measures the speed of cPermissionTrie lookups against the split-and-compare algorithm previously used by cPlayer
+
+#include "Globals.h"
+#include "PermissionTrie.h"
+
+
+
+
+
+/** The split-and-compare matching, same as cPlayer::PermissionMatches(). */
+static bool permissionMatches(const AStringVector & aPermission, const AStringVector & aTemplate)
+{
+	size_t lenP = aPermission.size();
+	size_t lenT = aTemplate.size();
+	size_t minLen = std::min(lenP, lenT);
+	for (size_t i = 0; i < minLen; i++)
+	{
+		if (aTemplate[i] == "*")
+		{
+			return true;
+		}
+		if (aPermission[i] != aTemplate[i])
+		{
+			return false;
+		}
+	}
+	return (lenP == lenT);
+}
+
+
+
+
+
+/** The previous cPlayer::HasPermission() implementation. */
+static bool hasPermissionSplit(const AString & aPermission, const std::vector<AStringVector> & aPermissions, const std::vector<AStringVector> & aRestrictions)
+{
+	auto split = StringSplit(aPermission, ".");
+	for (const auto & restriction: aRestrictions)
+	{
+		if (permissionMatches(split, restriction))
+		{
+			return false;
+		}
+	}
+	for (const auto & permission: aPermissions)
+	{
+		if (permissionMatches(split, permission))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+
+/** Creates a rank-like permission set: a few plugins granted entirely, the rest command by command. */
+static void createPermissions(size_t aNumPlugins, size_t aNumCommands, AStringVector & aPermissions, AStringVector & aRestrictions, AStringVector & aQueries)
+{
+	static const char * subCommands[] = {"self", "other", "list", "admin"};
+	for (size_t p = 0; p < aNumPlugins; p++)
+	{
+		auto plugin = Printf("plugin%zu", p);
+		if (p % 10 == 0)
+		{
+			aPermissions.push_back(plugin + ".*");
+		}
+		for (size_t c = 0; c < aNumCommands; c++)
+		{
+			auto command = Printf("%s.command%zu", plugin, c);
+			for (const auto sub: subCommands)
+			{
+				auto permission = Printf("%s.%s", command, sub);
+				if ((p % 10 != 0) && (c % 3 != 2))
+				{
+					aPermissions.push_back(permission);
+				}
+				aQueries.push_back(permission);
+			}
+		}
+		aRestrictions.push_back(plugin + ".command0.admin");
+	}
+	aQueries.push_back("core.build");
+	aQueries.push_back("unknown.plugin.command");
+}
+
+
+
+
+
+/** Runs the lookups for the specified set sizes and prints the timings. */
+static void benchmark(size_t aNumPlugins, size_t aNumCommands)
+{
+	AStringVector permissions, restrictions, queries;
+	createPermissions(aNumPlugins, aNumCommands, permissions, restrictions, queries);
+
+	std::vector<AStringVector> splitPermissions, splitRestrictions;
+	for (const auto & permission: permissions)
+	{
+		splitPermissions.push_back(StringSplit(permission, "."));
+	}
+	for (const auto & restriction: restrictions)
+	{
+		splitRestrictions.push_back(StringSplit(restriction, "."));
+	}
+	cPermissionTrie permissionTrie, restrictionTrie;
+	permissionTrie.Compile(permissions);
+	restrictionTrie.Compile(restrictions);
+
+	const size_t numRounds = 200;
+	size_t numGrantedSplit = 0, numGrantedTrie = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < numRounds; r++)
+	{
+		for (const auto & query: queries)
+		{
+			numGrantedSplit += hasPermissionSplit(query, splitPermissions, splitRestrictions) ? 1 : 0;
+		}
+	}
+	auto mid = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < numRounds; r++)
+	{
+		for (const auto & query: queries)
+		{
+			numGrantedTrie += (!restrictionTrie.Matches(query) && permissionTrie.Matches(query)) ? 1 : 0;
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	auto numLookups = static_cast<double>(numRounds * queries.size());
+	auto nsSplit = std::chrono::duration<double, std::nano>(mid - start).count() / numLookups;
+	auto nsTrie = std::chrono::duration<double, std::nano>(end - mid).count() / numLookups;
+	LOG("%zu permissions, %zu restrictions: split %.0f ns / lookup, trie %.0f ns / lookup (%.1fx)%s",
+		permissions.size(), restrictions.size(), nsSplit, nsTrie, nsSplit / nsTrie,
+		(numGrantedSplit == numGrantedTrie) ? "" : " RESULTS DIFFER!"
+	);
+}
+
+
+
+
+
+int main()
+{
+	LOG("PermissionTrie benchmark");
+	benchmark(2, 5);
+	benchmark(10, 10);
+	benchmark(30, 10);
+	benchmark(100, 10);
+	return 0;
+}
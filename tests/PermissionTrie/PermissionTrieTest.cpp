@@ -0,0 +1,127 @@
+// PermissionTrieTest.cpp
+
+// Tests that cPermissionTrie matches permissions the same way as the split-and-compare algorithm in cPlayer
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "PermissionTrie.h"
+
+
+
+
+
+/** The reference matching algorithm, same as cPlayer::PermissionMatches(). */
+static bool permissionMatches(const AStringVector & aPermission, const AStringVector & aTemplate)
+{
+	size_t lenP = aPermission.size();
+	size_t lenT = aTemplate.size();
+	size_t minLen = std::min(lenP, lenT);
+	for (size_t i = 0; i < minLen; i++)
+	{
+		if (aTemplate[i] == "*")
+		{
+			return true;
+		}
+		if (aPermission[i] != aTemplate[i])
+		{
+			return false;
+		}
+	}
+	return (lenP == lenT);
+}
+
+
+
+
+
+/** Returns true if any of the templates matches the permission, using the reference algorithm. */
+static bool anyMatches(const AString & aPermission, const AStringVector & aTemplates)
+{
+	auto split = StringSplit(aPermission, ".");
+	for (const auto & templ: aTemplates)
+	{
+		if (permissionMatches(split, StringSplit(templ, ".")))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+
+/** Tests the basic exact and wildcard matches. */
+static void testBasic()
+{
+	cPermissionTrie trie;
+	TEST_FALSE(trie.Matches("core.build"));
+
+	trie.Compile({"core.build", "core.tp.*", "worldedit.*", "a.b.c"});
+	TEST_TRUE(trie.Matches("core.build"));
+	TEST_FALSE(trie.Matches("core"));
+	TEST_FALSE(trie.Matches("core.build.extra"));
+	TEST_TRUE(trie.Matches("core.tp.player"));
+	TEST_TRUE(trie.Matches("core.tp.player.other"));
+	TEST_FALSE(trie.Matches("core.tp"));
+	TEST_TRUE(trie.Matches("worldedit.anything"));
+	TEST_FALSE(trie.Matches("worldedit"));
+	TEST_TRUE(trie.Matches("a.b.c"));
+	TEST_FALSE(trie.Matches("a.b"));
+	TEST_FALSE(trie.Matches("a.b.d"));
+
+	// Recompiling replaces the previous contents:
+	trie.Compile({"*"});
+	TEST_TRUE(trie.Matches("core.build"));
+	TEST_TRUE(trie.Matches("x"));
+	trie.Compile({});
+	TEST_FALSE(trie.Matches("core.build"));
+}
+
+
+
+
+
+/** Tests that the trie gives the same results as the reference algorithm, including the odd cases of empty parts and wildcards in the middle. */
+static void testEquivalence()
+{
+	AStringVector templates =
+	{
+		"core.build", "core.tp.*", "core.*.admin", "plugin..empty", ".leading", "trailing.",
+		"*.star", "deep.a.b.c.d.e", "deep.a", "x.*.*", "", "*a", "mid.*x.y",
+	};
+	AStringVector permissions =
+	{
+		"core.build", "core.tp", "core.tp.x", "core.anything", "core.anything.admin", "core", "core.",
+		"plugin..empty", "plugin.empty", "plugin..", ".leading", "leading", "trailing", "trailing.", "trailing..",
+		"star", "a.star", ".", "..", "deep.a", "deep.a.b", "deep.a.b.c.d.e", "deep.a.b.c.d.e.f", "x", "x.y",
+		"*a", "*a.b", "mid.*x.y", "mid.z", "*", "*.star", "zzz",
+	};
+
+	// Test each template on its own, and all of them together:
+	for (const auto & templ: templates)
+	{
+		cPermissionTrie trie;
+		trie.Compile({templ});
+		for (const auto & perm: permissions)
+		{
+			TEST_EQUAL_MSG(trie.Matches(perm), anyMatches(perm, {templ}), Printf("Template \"%s\", permission \"%s\"", templ, perm));
+		}
+	}
+	cPermissionTrie trie;
+	trie.Compile(templates);
+	for (const auto & perm: permissions)
+	{
+		TEST_EQUAL_MSG(trie.Matches(perm), anyMatches(perm, templates), Printf("All templates, permission \"%s\"", perm));
+	}
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("PermissionTrie",
+	testBasic();
+	testEquivalence();
+)
@@ -0,0 +1,213 @@
+// PlayerDataWriterTest.cpp
+
+// Tests the cPlayerDataWriter class: the JSON to NBT conversion, the file writing, loading and format migration
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "WorldStorage/PlayerDataWriter.h"
+#include "OSSupport/File.h"
+
+
+
+
+
+/** The folder in which the test files are written. */
+static const AString TEST_FOLDER = "PlayerDataWriterTest";
+
+
+
+
+
+/** Returns a JSON object resembling the player data saved by cPlayer. */
+static Json::Value createPlayerData(int aSeed)
+{
+	Json::Value res;
+	res["position"].append(1.5 * aSeed);
+	res["position"].append(64.0);
+	res["position"].append(-10.25);
+	res["health"] = 19.5;
+	res["xpTotal"] = aSeed;
+	res["isflying"] = (aSeed % 2 == 0);
+	res["lastknownname"] = "player" + std::to_string(aSeed);
+	res["bigNumber"] = Json::Int64(1) << 40;
+	for (int i = 0; i < 4; i++)
+	{
+		Json::Value item;
+		item["ID"] = (i == 0) ? -1 : i * 10 + aSeed;
+		if (i > 0)
+		{
+			item["Count"] = i;
+			item["Lore"].append("line 1");
+			item["Lore"].append("line 2");
+		}
+		res["inventory"].append(item);
+	}
+	res["knownRecipes"] = Json::Value(Json::arrayValue);
+	res["numbers"].append(1);
+	res["numbers"].append(Json::Int64(1) << 35);
+	res["numbers"].append(0.5);
+	res["mixed"].append(1);
+	res["mixed"].append("text");
+	res["mixed"].append(Json::Value(Json::objectValue));
+	res["mixed"].append(true);
+	res["longString"] = AString(70000, 'a');
+	return res;
+}
+
+
+
+
+
+/** Tests that converting JSON to NBT and back gives the same JSON. */
+static void testNBTRoundtrip()
+{
+	auto orig = createPlayerData(1);
+	auto nbt = cPlayerDataWriter::JsonToNBT(orig);
+	Json::Value converted;
+	TEST_TRUE(cPlayerDataWriter::NBTToJson(nbt, converted));
+
+	// Numbers in an array are widened to a common type:
+	TEST_EQUAL(converted["numbers"][0].asDouble(), 1);
+	TEST_EQUAL(converted["numbers"][1].asDouble(), static_cast<double>(Json::Int64(1) << 35));
+	TEST_EQUAL(converted["numbers"][2].asDouble(), 0.5);
+	orig.removeMember("numbers");
+	converted.removeMember("numbers");
+	TEST_EQUAL(converted, orig);
+
+	// Unsigned values are read back as signed:
+	Json::Value seed;
+	seed["enchantmentSeed"] = 4000000000U;
+	seed["null"] = Json::Value();
+	TEST_TRUE(cPlayerDataWriter::NBTToJson(cPlayerDataWriter::JsonToNBT(seed), converted));
+	TEST_EQUAL(converted["enchantmentSeed"].asUInt(), 4000000000U);
+	TEST_FALSE(converted.isMember("null"));
+
+	// Invalid data:
+	TEST_FALSE(cPlayerDataWriter::NBTToJson(ContiguousByteBufferView(nbt).substr(0, nbt.size() / 2), converted));
+}
+
+
+
+
+
+/** Tests that the queued data is loaded before it is written, and that the file replaces the old one. */
+static void testWriteAndLoad()
+{
+	auto fileBase = TEST_FOLDER + "/sub/player";
+	cPlayerDataWriter writer;
+	Json::Value loaded;
+	TEST_FALSE(writer.Load(fileBase, loaded));
+
+	// Queued data is loaded before it's written; a newer snapshot replaces the queued one:
+	writer.Queue(AString(fileBase), createPlayerData(1), cPlayerDataWriter::eFormat::Json);
+	writer.Queue(AString(fileBase), createPlayerData(2), cPlayerDataWriter::eFormat::Json);
+	TEST_FALSE(cFile::IsFile(fileBase + ".json"));
+	TEST_TRUE(writer.Load(fileBase, loaded));
+	TEST_EQUAL(loaded, createPlayerData(2));
+
+	writer.Flush();
+	TEST_TRUE(cFile::IsFile(fileBase + ".json"));
+	TEST_FALSE(cFile::IsFile(fileBase + ".json.tmp"));
+	TEST_TRUE(writer.Load(fileBase, loaded));
+	TEST_EQUAL(loaded, createPlayerData(2));
+
+	// Overwriting the file:
+	writer.Queue(AString(fileBase), createPlayerData(3), cPlayerDataWriter::eFormat::Json);
+	writer.Flush();
+	TEST_TRUE(writer.Load(fileBase, loaded));
+	TEST_EQUAL(loaded, createPlayerData(3));
+
+	// A corrupted file is reported:
+	OutputFileStream(fileBase + ".json") << "{ \"broken\": ";
+	TEST_THROWS_ANY(writer.Load(fileBase, loaded));
+	cFile::DeleteFolderContents(TEST_FOLDER + "/sub");
+}
+
+
+
+
+
+/** Tests that the files in the other format are read, and replaced by the files in the configured format once written. */
+static void testMigration()
+{
+	auto fileBase = TEST_FOLDER + "/migrated";
+	{
+		cPlayerDataWriter jsonWriter;
+		jsonWriter.Queue(AString(fileBase), createPlayerData(4), cPlayerDataWriter::eFormat::Json);
+	}
+	TEST_TRUE(cFile::IsFile(fileBase + ".json"));
+
+	cPlayerDataWriter writer;
+	writer.Start(cPlayerDataWriter::eFormat::NBT);
+	Json::Value loaded;
+	TEST_TRUE(writer.Load(fileBase, loaded));
+	TEST_EQUAL(loaded, createPlayerData(4));
+
+	loaded["xpTotal"] = 100;
+	writer.Queue(AString(fileBase), Json::Value(loaded), writer.GetFormat());
+	writer.Stop();
+	writer.Flush();
+	TEST_TRUE(cFile::IsFile(fileBase + ".nbt"));
+	TEST_FALSE(cFile::IsFile(fileBase + ".json"));
+	Json::Value migrated;
+	TEST_TRUE(writer.Load(fileBase, migrated));
+	TEST_EQUAL(migrated["xpTotal"].asInt(), 100);
+	migrated["numbers"] = loaded["numbers"];
+	TEST_EQUAL(migrated, loaded);
+	cFile::DeleteFile(fileBase + ".nbt");
+}
+
+
+
+
+
+/** Tests that the thread writes all the files queued from several threads. */
+static void testThreaded()
+{
+	cPlayerDataWriter writer;
+	writer.Start(cPlayerDataWriter::eFormat::NBT);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&writer, t]()
+			{
+				for (int i = 0; i < 100; i++)
+				{
+					writer.Queue(fmt::format("{}/t{}/{}", TEST_FOLDER, t, i % 20), createPlayerData(i), cPlayerDataWriter::eFormat::NBT);
+				}
+			}
+		);
+	}
+	for (auto & thread: threads)
+	{
+		thread.join();
+	}
+	writer.Stop();
+	writer.Flush();
+
+	// Each file has the last snapshot queued for it:
+	for (int t = 0; t < 4; t++)
+	{
+		for (int i = 0; i < 20; i++)
+		{
+			auto fileBase = fmt::format("{}/t{}/{}", TEST_FOLDER, t, i);
+			Json::Value loaded;
+			TEST_TRUE(cFile::IsFile(fileBase + ".nbt"));
+			TEST_TRUE(writer.Load(fileBase, loaded));
+			TEST_EQUAL(loaded["xpTotal"].asInt(), 80 + i);
+		}
+		cFile::DeleteFolderContents(fmt::format("{}/t{}", TEST_FOLDER, t));
+	}
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("PlayerDataWriter",
+	cFile::CreateFolder(TEST_FOLDER);
+	testNBTRoundtrip();
+	testWriteAndLoad();
+	testMigration();
+	testThreaded();
+)
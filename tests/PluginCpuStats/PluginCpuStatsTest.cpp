@@ -0,0 +1,208 @@
+// PluginCpuStatsTest.cpp
+
+// Tests the cPluginCpuStats: the per-callback and per-tick accounting, the hooks, the report and the cMetrics histograms
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "Bindings/PluginCpuStats.h"
+#include "Metrics.h"
+
+
+
+
+
+/** Returns the histogram into which the stats record the calls of the specified plugin's callback. */
+static cMetricHistogram & getCallbackMetric(const AString & a_PluginName, const AString & a_Callback)
+{
+	return cMetrics::Get().GetHistogram("cuberite_plugin_callback_seconds", "", {{"plugin", a_PluginName}, {"callback", a_Callback}});
+}
+
+
+
+
+
+/** Tests the cumulative statistics of the callbacks and of the whole plugin. */
+static void testCallbacks()
+{
+	cPluginCpuStats stats("Test");
+	stats.Record("OnChat", std::chrono::microseconds(10));
+	stats.Record("OnChat", std::chrono::microseconds(30));
+	stats.Record("Command /spawn", std::chrono::microseconds(100));
+	{
+		cPluginCpuStats::cTimer timer(&stats, "ScheduleTask");
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+
+	auto totals = stats.GetTotals();
+	TEST_EQUAL(totals.m_Name, "Test");
+	TEST_EQUAL(totals.m_NumCalls, 4U);
+	TEST_GREATER_THAN_OR_EQUAL(totals.m_TotalTime, std::chrono::microseconds(2140));
+	TEST_GREATER_THAN_OR_EQUAL(totals.m_MaxCallTime, std::chrono::milliseconds(2));
+
+	// The callbacks are sorted by their total time, the longest first:
+	auto callbacks = stats.GetCallbacks();
+	TEST_EQUAL(callbacks.size(), 3U);
+	TEST_EQUAL(callbacks[0].m_Name, "ScheduleTask");
+	TEST_EQUAL(callbacks[1].m_Name, "Command /spawn");
+	TEST_EQUAL(callbacks[2].m_Name, "OnChat");
+	TEST_EQUAL(callbacks[2].m_NumCalls, 2U);
+	TEST_EQUAL(callbacks[2].m_TotalTime, std::chrono::microseconds(40));
+	TEST_EQUAL(callbacks[2].m_MaxCallTime, std::chrono::microseconds(30));
+
+	// Each call is recorded into the callback's histogram:
+	TEST_EQUAL(getCallbackMetric("Test", "OnChat").GetCount(), 2U);
+	TEST_EQUAL(getCallbackMetric("Test", "OnChat").GetMax(), std::chrono::microseconds(30));
+
+	// A timer without the stats records nothing:
+	{
+		cPluginCpuStats::cTimer timer(nullptr, "OnChat");
+	}
+	TEST_EQUAL(stats.GetTotals().m_NumCalls, 4U);
+
+	// The report lists the top callbacks:
+	auto report = stats.GetReport(2);
+	TEST_EQUAL(report.compare(0, 14, "Test: 4 calls,"), 0);
+	TEST_NOTEQUAL(report.find("\n  ScheduleTask: 1 calls,"), AString::npos);
+	TEST_NOTEQUAL(report.find("\n  Command /spawn: 1 calls, total 0.10 ms, avg 0.100 ms, max 0.100 ms;"), AString::npos);
+	TEST_EQUAL(report.find("OnChat"), AString::npos);
+	TEST_NOTEQUAL(report.find("... and 1 more callbacks"), AString::npos);
+
+	// Reset clears the stats, but not the histograms:
+	stats.Reset();
+	TEST_EQUAL(stats.GetTotals().m_NumCalls, 0U);
+	TEST_TRUE(stats.GetCallbacks().empty());
+	TEST_EQUAL(getCallbackMetric("Test", "OnChat").GetCount(), 2U);
+}
+
+
+
+
+
+/** Tests that the hooks are recorded under their name, together with the other callbacks, also after a reset. */
+static void testHooks()
+{
+	cPluginCpuStats stats("HookTest");
+	stats.RecordHook(5, "OnChat", std::chrono::microseconds(10));
+	stats.RecordHook(5, "OnChat", std::chrono::microseconds(20));
+	stats.Record("OnChat", std::chrono::microseconds(30));
+	stats.RecordHook(cPluginCpuStats::NumHookSlots - 1, "OnWorldTick", std::chrono::microseconds(100));
+	auto callbacks = stats.GetCallbacks();
+	TEST_EQUAL(callbacks.size(), 2U);
+	TEST_EQUAL(callbacks[0].m_Name, "OnWorldTick");
+	TEST_EQUAL(callbacks[1].m_Name, "OnChat");
+	TEST_EQUAL(callbacks[1].m_NumCalls, 3U);
+	TEST_EQUAL(callbacks[1].m_TotalTime, std::chrono::microseconds(60));
+	TEST_EQUAL(stats.GetTotals().m_NumCalls, 4U);
+	TEST_EQUAL(getCallbackMetric("HookTest", "OnChat").GetCount(), 3U);
+
+	// The hook's callback survives the reset:
+	stats.Reset();
+	TEST_TRUE(stats.GetCallbacks().empty());
+	stats.RecordHook(5, "OnChat", std::chrono::microseconds(10));
+	callbacks = stats.GetCallbacks();
+	TEST_EQUAL(callbacks.size(), 1U);
+	TEST_EQUAL(callbacks[0].m_Name, "OnChat");
+	TEST_EQUAL(callbacks[0].m_NumCalls, 1U);
+	TEST_EQUAL(stats.GetTotals().m_TotalTime, std::chrono::microseconds(10));
+}
+
+
+
+
+
+/** Tests the per-tick statistics. */
+static void testTicks()
+{
+	cPluginCpuStats stats("TickTest");
+	stats.Record("OnWorldTick", std::chrono::microseconds(100));
+	stats.Record("OnWorldTick", std::chrono::microseconds(200));
+	stats.Record("OnChat", std::chrono::microseconds(50));
+
+	// The times within the tick are not reported until the tick ends:
+	TEST_EQUAL(stats.GetTotals().m_LastTickTime, std::chrono::nanoseconds(0));
+	stats.EndTick();
+	auto totals = stats.GetTotals();
+	TEST_EQUAL(totals.m_LastTickTime, std::chrono::microseconds(350));
+	TEST_EQUAL(totals.m_MaxTickTime, std::chrono::microseconds(350));
+	TEST_EQUAL(stats.GetCallbacks()[0].m_LastTickTime, std::chrono::microseconds(300));
+
+	// A quieter tick keeps the maximum:
+	stats.Record("OnWorldTick", std::chrono::microseconds(10));
+	stats.EndTick();
+	totals = stats.GetTotals();
+	TEST_EQUAL(totals.m_LastTickTime, std::chrono::microseconds(10));
+	TEST_EQUAL(totals.m_MaxTickTime, std::chrono::microseconds(350));
+	auto callbacks = stats.GetCallbacks();
+	TEST_EQUAL(callbacks[1].m_Name, "OnChat");
+	TEST_EQUAL(callbacks[1].m_LastTickTime, std::chrono::nanoseconds(0));
+	TEST_EQUAL(callbacks[1].m_MaxTickTime, std::chrono::microseconds(50));
+
+	// Each tick's total is recorded into the plugin's tick histogram:
+	auto & tickMetric = cMetrics::Get().GetHistogram("cuberite_plugin_tick_seconds", "", {{"plugin", "TickTest"}});
+	TEST_EQUAL(tickMetric.GetCount(), 2U);
+	TEST_EQUAL(tickMetric.GetMax(), std::chrono::microseconds(350));
+}
+
+
+
+
+
+/** Tests that renaming the plugin moves the recording to the histograms of the new name. */
+static void testRename()
+{
+	cPluginCpuStats stats("OldName");
+	stats.Record("OnChat", std::chrono::microseconds(10));
+	stats.SetPluginName("NewName");
+	stats.Record("OnChat", std::chrono::microseconds(10));
+	TEST_EQUAL(stats.GetTotals().m_Name, "NewName");
+	TEST_EQUAL(stats.GetTotals().m_NumCalls, 2U);
+	TEST_EQUAL(getCallbackMetric("OldName", "OnChat").GetCount(), 1U);
+	TEST_EQUAL(getCallbackMetric("NewName", "OnChat").GetCount(), 1U);
+}
+
+
+
+
+
+/** Tests that the calls over the budget don't disturb the accounting, from several threads at once. */
+static void testBudgetsAndThreads()
+{
+	cPluginCpuStats stats("ThreadTest");
+	stats.SetBudgets(std::chrono::milliseconds(1), std::chrono::milliseconds(1));
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 4; i++)
+	{
+		threads.emplace_back([&stats]()
+			{
+				for (int j = 0; j < 1000; j++)
+				{
+					stats.RecordHook(3, "OnPlayerMoving", std::chrono::milliseconds(2));
+					stats.Record("OnPlayerMoving", std::chrono::milliseconds(2));
+				}
+			}
+		);
+	}
+	for (auto & thread: threads)
+	{
+		thread.join();
+	}
+	stats.EndTick();
+	auto totals = stats.GetTotals();
+	TEST_EQUAL(totals.m_NumCalls, 8000U);
+	TEST_EQUAL(totals.m_TotalTime, std::chrono::seconds(16));
+	TEST_EQUAL(totals.m_LastTickTime, std::chrono::seconds(16));
+	TEST_EQUAL(stats.GetCallbacks().size(), 1U);
+	TEST_EQUAL(stats.GetCallbacks()[0].m_MaxCallTime, std::chrono::milliseconds(2));
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("PluginCpuStats",
+	testCallbacks();
+	testHooks();
+	testTicks();
+	testRename();
+	testBudgetsAndThreads();
+)
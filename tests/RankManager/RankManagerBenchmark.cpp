@@ -0,0 +1,131 @@
+// RankManagerBenchmark.cpp
+
+// Measures the speed of cRankManager with 10k players, against the per-query SQLite lookups previously used
+
+#include "Globals.h"
+#include "RankManager.h"
+#include "Protocol/MojangAPI.h"
+#include "SQLiteCpp/Statement.h"
+
+
+
+
+
+static const char * DB_FILE_NAME = "RankManagerBenchmark.sqlite";
+
+
+
+
+
+/** Returns the number of milliseconds elapsed since aStart. */
+static double msSince(std::chrono::steady_clock::time_point aStart)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - aStart).count();
+}
+
+
+
+
+
+/** The previous cRankManager::GetPlayerPermissions() implementation, querying the DB directly. */
+static AStringVector getPlayerPermissionsSQL(SQLite::Database & aDB, const cUUID & aPlayerUUID, const AString & aDefaultRank)
+{
+	AString rank;
+	{
+		SQLite::Statement stmt(aDB, "SELECT Rank.Name FROM Rank LEFT JOIN PlayerRank ON Rank.RankID = PlayerRank.RankID WHERE PlayerRank.PlayerUUID = ?");
+		stmt.bind(1, aPlayerUUID.ToShortString());
+		rank = stmt.executeStep() ? stmt.getColumn(0).getText() : aDefaultRank;
+	}
+	AStringVector res;
+	SQLite::Statement stmt(aDB,
+		"SELECT PermissionItem.Permission FROM PermissionItem "
+			"LEFT JOIN RankPermGroup ON RankPermGroup.PermGroupID = PermissionItem.PermGroupID "
+			"LEFT JOIN Rank ON Rank.RankID = RankPermGroup.RankID "
+		"WHERE Rank.Name = ?"
+	);
+	stmt.bind(1, rank);
+	while (stmt.executeStep())
+	{
+		res.push_back(stmt.getColumn(0).getText());
+	}
+	return res;
+}
+
+
+
+
+
+int main()
+{
+	const int numPlayers = 10000;
+	const int numRanks = 20;
+	LOG("RankManager benchmark, %d players", numPlayers);
+	cFile::Delete(DB_FILE_NAME);
+
+	std::vector<cUUID> uuids;
+	for (int i = 0; i < numPlayers; i++)
+	{
+		cUUID uuid;
+		uuid.FromString(Printf("%08x-0000-4000-8000-000000000000", i));
+		uuids.push_back(uuid);
+	}
+
+	cMojangAPI mojangAPI;
+	{
+		// Create the ranks and assign all the players:
+		cRankManager rm(DB_FILE_NAME);
+		rm.Initialize(mojangAPI);
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < numRanks; r++)
+		{
+			auto rank = Printf("Rank%d", r);
+			rm.AddRank(rank, "", "", "");
+			rm.AddGroup(rank);
+			rm.AddGroupToRank(rank, rank);
+			for (int p = 0; p < 20; p++)
+			{
+				rm.AddPermissionToGroup(Printf("plugin%d.command%d", r, p), rank);
+			}
+		}
+		for (int i = 0; i < numPlayers; i++)
+		{
+			rm.SetPlayerRank(uuids[i], Printf("Player%d", i), Printf("Rank%d", i % numRanks));
+		}
+		auto msQueued = msSince(start);
+		rm.Flush();
+		LOG("Assigning: %.1f ms on the caller thread, %.1f ms until written to the DB", msQueued, msSince(start));
+	}
+
+	// Reload:
+	auto start = std::chrono::steady_clock::now();
+	cRankManager rm(DB_FILE_NAME);
+	rm.Initialize(mojangAPI);
+	LOG("Loading the DB: %.1f ms", msSince(start));
+
+	// Query all the players' permissions, as on player join:
+	size_t numPermissions = 0;
+	start = std::chrono::steady_clock::now();
+	for (const auto & uuid: uuids)
+	{
+		numPermissions += rm.GetPlayerPermissions(uuid).size();
+		numPermissions += rm.GetPlayerRestrictions(uuid).size();
+		AString prefix, suffix, color;
+		rm.GetPlayerMsgVisuals(uuid, prefix, suffix, color);
+	}
+	auto msModel = msSince(start);
+
+	size_t numPermissionsSQL = 0;
+	SQLite::Database db(DB_FILE_NAME, SQLite::OPEN_READONLY);
+	start = std::chrono::steady_clock::now();
+	for (const auto & uuid: uuids)
+	{
+		numPermissionsSQL += getPlayerPermissionsSQL(db, uuid, rm.GetDefaultRank()).size();
+	}
+	auto msSQL = msSince(start);
+	LOG("Player lookups: in-memory model %.1f ms (permissions, restrictions, visuals), SQL %.1f ms (permissions only)%s",
+		msModel, msSQL, (numPermissions == numPermissionsSQL) ? "" : " RESULTS DIFFER!"
+	);
+
+	cFile::Delete(DB_FILE_NAME);
+	return 0;
+}
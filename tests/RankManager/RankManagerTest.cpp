@@ -0,0 +1,252 @@
+// RankManagerTest.cpp
+
+// Tests the cRankManager's in-memory model and its persistence into the DB
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "RankManager.h"
+#include "Protocol/MojangAPI.h"
+#include "SQLiteCpp/Statement.h"
+
+
+
+
+
+static const char * DB_FILE_NAME = "RankManagerTest.sqlite";
+
+
+
+
+
+/** Returns a UUID that is unique for the specified number. */
+static cUUID makeUUID(int aNum)
+{
+	cUUID res;
+	res.FromString(Printf("%08x-0000-4000-8000-000000000000", aNum));
+	return res;
+}
+
+
+
+
+
+/** Returns the single integer that the specified query reads from the test DB, or -1 if it returns no rows. */
+static int queryDBInt(const char * aSQL)
+{
+	SQLite::Database db(DB_FILE_NAME);
+	SQLite::Statement stmt(db, aSQL);
+	if (!stmt.executeStep())
+	{
+		return -1;
+	}
+	return stmt.getColumn(0).getInt();
+}
+
+
+
+
+
+/** Tests the defaults created in an empty DB. */
+static void testDefaults()
+{
+	cFile::Delete(DB_FILE_NAME);
+	cMojangAPI mojangAPI;
+	cRankManager rm(DB_FILE_NAME);
+	rm.Initialize(mojangAPI);
+
+	TEST_EQUAL(rm.GetDefaultRank(), "Default");
+	TEST_EQUAL(rm.GetAllRanks(), AStringVector({"Default", "VIP", "Operator", "Admin"}));
+	TEST_EQUAL(rm.GetAllGroups(), AStringVector({"Default", "Kick", "Teleport", "Everything"}));
+	TEST_EQUAL(rm.GetRankPermissions("Operator"), AStringVector({"core.teleport", "core.kick"}));
+	TEST_EQUAL(rm.GetRankGroups("Operator"), AStringVector({"Teleport", "Kick"}));
+
+	// A player without a rank gets the default rank's permissions:
+	auto uuid = makeUUID(1);
+	TEST_FALSE(rm.IsPlayerRankSet(uuid));
+	TEST_EQUAL(rm.GetPlayerRankName(uuid), "");
+	TEST_EQUAL(rm.GetPlayerPermissions(uuid), AStringVector({"core.help", "core.build"}));
+}
+
+
+
+
+
+/** Tests the changes to the ranks, groups and players, and that they survive a reload from the DB. */
+static void testChangesPersist()
+{
+	cFile::Delete(DB_FILE_NAME);
+	auto player1 = makeUUID(1);
+	auto player2 = makeUUID(2);
+	{
+		cMojangAPI mojangAPI;
+		cRankManager rm(DB_FILE_NAME);
+		rm.Initialize(mojangAPI);
+
+		rm.AddRank("Builder", "[B]", "", "@2");
+		rm.AddGroups({"Build", "Fly", "Build"});
+		rm.AddGroups({"Kick", "Swim"});  // An existing group doesn't stop the rest
+		TEST_TRUE(rm.GroupExists("Swim"));
+		TEST_TRUE(rm.AddGroupToRank("Build", "Builder"));
+		TEST_TRUE(rm.AddGroupToRank("Fly", "Builder"));
+		TEST_TRUE(rm.AddGroupToRank("Build", "Builder"));  // Duplicate, still succeeds
+		TEST_FALSE(rm.AddGroupToRank("Build", "NoSuchRank"));
+		TEST_TRUE(rm.AddPermissionsToGroup({"build.place", "build.break", "build.place"}, "Build"));
+		TEST_TRUE(rm.AddRestrictionToGroup("build.tnt", "Build"));
+		TEST_TRUE(rm.AddPermissionToGroup("fly", "Fly"));
+		rm.SetPlayerRank(player1, "Zed", "Builder");
+		rm.SetPlayerRank(player2, "alice", "VIP");
+
+		// The changes are visible immediately:
+		TEST_EQUAL(rm.GetPlayerPermissions(player1), AStringVector({"build.place", "build.break", "fly"}));
+		TEST_EQUAL(rm.GetPlayerRestrictions(player1), AStringVector({"build.tnt"}));
+		TEST_EQUAL(rm.GetAllPlayerUUIDs(), std::vector<cUUID>({player2, player1}));
+
+		// Removing a group from a rank doesn't affect other ranks using the group:
+		TEST_TRUE(rm.AddGroupToRank("Fly", "VIP"));
+		rm.RemoveGroupFromRank("Fly", "Builder");
+		TEST_FALSE(rm.IsGroupInRank("Fly", "Builder"));
+		TEST_TRUE(rm.IsGroupInRank("Fly", "VIP"));
+
+		// Renames are reflected everywhere:
+		TEST_TRUE(rm.RenameRank("Builder", "Architect"));
+		TEST_FALSE(rm.RenameRank("VIP", "Architect"));
+		TEST_TRUE(rm.RenameGroup("Build", "Construct"));
+		TEST_EQUAL(rm.GetPlayerRankName(player1), "Architect");
+		TEST_EQUAL(rm.GetRankGroups("Architect"), AStringVector({"Construct"}));
+		TEST_TRUE(rm.SetDefaultRank("VIP"));
+		rm.UpdatePlayerName(player1, "Bob");
+	}
+
+	// The default rank is stored by its ID:
+	TEST_EQUAL(queryDBInt("SELECT RankID FROM DefaultRank"), queryDBInt("SELECT RankID FROM Rank WHERE Name = 'VIP'"));
+
+	// Reload from the DB:
+	cMojangAPI mojangAPI;
+	cRankManager rm(DB_FILE_NAME);
+	rm.Initialize(mojangAPI);
+	TEST_EQUAL(rm.GetDefaultRank(), "VIP");
+	TEST_EQUAL(rm.GetAllRanks(), AStringVector({"Default", "VIP", "Operator", "Admin", "Architect"}));
+	TEST_EQUAL(rm.GetPlayerRankName(player1), "Architect");
+	TEST_EQUAL(rm.GetPlayerName(player1), "Bob");
+	TEST_EQUAL(rm.GetPlayerPermissions(player1), AStringVector({"build.place", "build.break"}));
+	TEST_EQUAL(rm.GetPlayerRestrictions(player1), AStringVector({"build.tnt"}));
+	TEST_EQUAL(rm.GetRankGroups("VIP"), AStringVector({"Teleport", "Fly"}));
+	AString prefix, suffix, color;
+	TEST_TRUE(rm.GetPlayerMsgVisuals(player1, prefix, suffix, color));
+	TEST_EQUAL(prefix, "[B]");
+	TEST_EQUAL(color, "@2");
+
+	// Removing the rank re-assigns its players; removing the default rank moves the default:
+	rm.RemoveRank("Architect", "Operator");
+	TEST_EQUAL(rm.GetPlayerRankName(player1), "Operator");
+	rm.RemoveRank("VIP", "");
+	TEST_TRUE(rm.RankExists("VIP"));  // Cannot remove the default rank without a replacement
+	rm.RemoveRank("VIP", "Operator");
+	TEST_FALSE(rm.RankExists("VIP"));
+	TEST_EQUAL(rm.GetDefaultRank(), "Operator");
+	TEST_EQUAL(rm.GetPlayerRankName(player2), "Operator");
+	rm.RemoveGroup("Construct");
+	TEST_FALSE(rm.GroupExists("Construct"));
+	rm.Flush();
+	TEST_EQUAL(queryDBInt("SELECT COUNT(*) FROM RestrictionItem"), 0);
+
+	// Reload once more:
+	cRankManager rm2(DB_FILE_NAME);
+	rm2.Initialize(mojangAPI);
+	TEST_EQUAL(rm2.GetDefaultRank(), "Operator");
+	TEST_FALSE(rm2.RankExists("VIP"));
+	TEST_FALSE(rm2.GroupExists("Construct"));
+	TEST_EQUAL(rm2.GetPlayerRankName(player1), "Operator");
+	TEST_EQUAL(rm2.GetPlayerRankName(player2), "Operator");
+	TEST_EQUAL(rm2.GetAllRestrictions(), AStringVector());
+}
+
+
+
+
+
+/** Tests that a change that fails to write into the DB is rolled back in the model, too. */
+static void testFailedWriteRollsBack()
+{
+	cFile::Delete(DB_FILE_NAME);
+	cMojangAPI mojangAPI;
+	{
+		cRankManager rm(DB_FILE_NAME);
+		rm.Initialize(mojangAPI);
+		TEST_TRUE(rm.Flush());
+
+		// Make the DB refuse a single permission:
+		{
+			SQLite::Database db(DB_FILE_NAME, SQLite::OPEN_READWRITE);
+			db.exec(
+				"CREATE TRIGGER RefusePermission BEFORE INSERT ON PermissionItem WHEN NEW.Permission = 'refused' "
+				"BEGIN SELECT RAISE(ABORT, 'refused by the test'); END"
+			);
+		}
+
+		// The refused permission disappears from the model, the other changes stay:
+		TEST_TRUE(rm.AddPermissionsToGroup({"accepted", "refused"}, "Default"));
+		rm.SetPlayerRank(makeUUID(1), "Zed", "VIP");
+		TEST_FALSE(rm.Flush());
+		TEST_TRUE(rm.IsPermissionInGroup("accepted", "Default"));
+		TEST_FALSE(rm.IsPermissionInGroup("refused", "Default"));
+		TEST_EQUAL(rm.GetPlayerRankName(makeUUID(1)), "VIP");
+		TEST_EQUAL(rm.GetDefaultRank(), "Default");
+		TEST_TRUE(rm.Flush());
+	}
+
+	// The model matched the DB:
+	cRankManager rm(DB_FILE_NAME);
+	rm.Initialize(mojangAPI);
+	TEST_EQUAL(rm.GetGroupPermissions("Default"), AStringVector({"core.help", "core.build", "accepted"}));
+	TEST_EQUAL(rm.GetPlayerRankName(makeUUID(1)), "VIP");
+}
+
+
+
+
+
+/** Tests that concurrent readers and writers see a consistent model. */
+static void testMultithreaded()
+{
+	cFile::Delete(DB_FILE_NAME);
+	cMojangAPI mojangAPI;
+	cRankManager rm(DB_FILE_NAME);
+	rm.Initialize(mojangAPI);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([&rm, t]()
+			{
+				for (int i = 0; i < 250; ++i)
+				{
+					auto uuid = makeUUID(t * 1000 + i);
+					rm.SetPlayerRank(uuid, Printf("Player%d_%d", t, i), "Operator");
+					TEST_EQUAL(rm.GetPlayerPermissions(uuid).size(), 2);
+				}
+			}
+		);
+	}
+	for (auto & thr: threads)
+	{
+		thr.join();
+	}
+	rm.Flush();
+
+	cRankManager rm2(DB_FILE_NAME);
+	rm2.Initialize(mojangAPI);
+	TEST_EQUAL(rm2.GetAllPlayerUUIDs().size(), 1000);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("RankManager",
+	testDefaults();
+	testChangesPersist();
+	testFailedWriteRollsBack();
+	testMultithreaded();
+	cFile::Delete(DB_FILE_NAME);
+)
@@ -0,0 +1,25 @@
+
+// Stubs.cpp
+
+// Implements stubs of various Cuberite methods that are needed for linking but not for runtime
+// This is required so that we don't bring in the entire Cuberite via dependencies
+
+#include "Globals.h"
+#include "Protocol/MojangAPI.h"
+
+
+
+
+
+cMojangAPI::cMojangAPI(void) :
+	m_RankMgr(nullptr)
+{
+}
+
+
+
+
+
+cMojangAPI::~cMojangAPI()
+{
+}
@@ -0,0 +1,191 @@
+// TickProfilerTest.cpp
+
+// Tests the cTickProfiler: the phase timing, the slow tick capture, sampling the details, the report and the log file
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "TickProfiler.h"
+#include "OSSupport/File.h"
+
+
+
+
+
+/** Runs a tick in which the chunk map phase takes a_ChunkMapTime, reporting a few fake timings. */
+static void runTick(cTickProfiler & a_Profiler, Int64 a_TickNumber, std::chrono::milliseconds a_ChunkMapTime)
+{
+	a_Profiler.BeginTick(a_TickNumber);
+	TEST_EQUAL(cTickProfiler::GetCurrent(), &a_Profiler);
+	a_Profiler.EndPhase(cTickProfiler::phPluginHook);
+	if (a_Profiler.IsCapturingDetails())
+	{
+		for (int i = 0; i < 40; i++)
+		{
+			a_Profiler.AddChunkTiming({i, -i}, std::chrono::microseconds(i));
+		}
+		a_Profiler.AddPluginHookTiming("Core", "OnWorldTick", std::chrono::microseconds(10));
+		a_Profiler.AddPluginHookTiming("Core", "OnWorldTick", std::chrono::microseconds(15));
+		a_Profiler.AddPluginHookTiming("Other", "OnWorldTick", std::chrono::microseconds(5));
+		a_Profiler.AddSimulatorTiming("Fire", std::chrono::microseconds(3));
+		a_Profiler.AddSimulatorTiming("Water", std::chrono::microseconds(7));
+	}
+	std::this_thread::sleep_for(a_ChunkMapTime);
+	auto ChunkMapTime = a_Profiler.EndPhase(cTickProfiler::phChunkMap);
+	TEST_GREATER_THAN_OR_EQUAL(ChunkMapTime, a_ChunkMapTime);
+	auto TickTime = a_Profiler.EndTick();
+	TEST_GREATER_THAN_OR_EQUAL(TickTime, ChunkMapTime);
+	TEST_EQUAL(cTickProfiler::GetCurrent(), nullptr);
+}
+
+
+
+
+
+/** Tests that only the ticks over the threshold are captured, and the ticks following them with their breakdown. */
+static void testSlowTickCapture()
+{
+	cTickProfiler profiler;
+	profiler.SetSlowTickThreshold(std::chrono::milliseconds(20));
+	runTick(profiler, 1, std::chrono::milliseconds(0));
+	TEST_TRUE(profiler.GetSlowTicks().empty());
+
+	// The first slow tick hasn't collected the details:
+	runTick(profiler, 2, std::chrono::milliseconds(30));
+	auto slowTicks = profiler.GetSlowTicks();
+	TEST_EQUAL(slowTicks.size(), 1U);
+	TEST_EQUAL(slowTicks[0].m_TickNumber, 2);
+	TEST_TRUE(!slowTicks[0].m_HasDetails);
+	TEST_TRUE(slowTicks[0].m_Chunks.empty());
+	TEST_GREATER_THAN_OR_EQUAL(slowTicks[0].m_Phases[cTickProfiler::phChunkMap], std::chrono::milliseconds(30));
+
+	// The following slow tick has:
+	runTick(profiler, 3, std::chrono::milliseconds(30));
+	slowTicks = profiler.GetSlowTicks();
+	TEST_EQUAL(slowTicks.size(), 2U);
+	const auto & slowTick = slowTicks[1];
+	TEST_EQUAL(slowTick.m_TickNumber, 3);
+	TEST_TRUE(slowTick.m_HasDetails);
+	TEST_GREATER_THAN_OR_EQUAL(slowTick.m_Phases[cTickProfiler::phChunkMap], std::chrono::milliseconds(30));
+
+	// Only the slowest chunks are kept, the slowest first:
+	TEST_EQUAL(slowTick.m_Chunks.size(), cTickProfiler::MaxItemsPerCategory);
+	TEST_EQUAL(slowTick.m_Chunks[0].m_Name, "[39, -39]");
+	TEST_EQUAL(slowTick.m_Chunks[0].m_Duration, std::chrono::microseconds(39));
+
+	// The repeated plugin hook and simulator timings are summed up:
+	TEST_EQUAL(slowTick.m_PluginHooks.size(), 2U);
+	TEST_EQUAL(slowTick.m_PluginHooks[0].m_Name, "Core: OnWorldTick");
+	TEST_EQUAL(slowTick.m_PluginHooks[0].m_Duration, std::chrono::microseconds(25));
+	TEST_EQUAL(slowTick.m_Simulators.size(), 2U);
+	TEST_EQUAL(slowTick.m_Simulators[0].m_Name, "Water");
+
+	// The report lists the top offenders:
+	runTick(profiler, 4, std::chrono::milliseconds(30));
+	auto report = profiler.GetReport(3);
+	TEST_NOTEQUAL(report.find("4 ticks profiled"), AString::npos);
+	TEST_NOTEQUAL(report.find("3 slow ticks (over 20 ms), 2 of them with the details"), AString::npos);
+	TEST_NOTEQUAL(report.find("Top 3 chunks"), AString::npos);
+	TEST_NOTEQUAL(report.find("[39, -39]"), AString::npos);
+	TEST_EQUAL(report.find("[36, -36]"), AString::npos);
+	TEST_NOTEQUAL(report.find("Core: OnWorldTick"), AString::npos);
+
+	profiler.Reset();
+	TEST_TRUE(profiler.GetSlowTicks().empty());
+	TEST_EQUAL(profiler.GetReport(3), "No ticks profiled yet\n");
+}
+
+
+
+
+
+/** Tests that the details are collected only in the sampled ticks and in the ticks following a slow tick. */
+static void testDetailSampling()
+{
+	cTickProfiler profiler;
+	profiler.SetSlowTickThreshold(std::chrono::milliseconds(20));
+	auto isCapturing = [&profiler](Int64 aTickNumber)
+	{
+		profiler.BeginTick(aTickNumber);
+		bool res = profiler.IsCapturingDetails();
+		profiler.EndTick();
+		return res;
+	};
+	TEST_TRUE(!isCapturing(1));
+	TEST_TRUE(isCapturing(cTickProfiler::DetailSampleInterval));
+	TEST_TRUE(!isCapturing(cTickProfiler::DetailSampleInterval + 1));
+
+	// A slow tick turns the details on for a limited number of the following ticks:
+	runTick(profiler, 1000, std::chrono::milliseconds(30));
+	Int64 tickNumber = 1001;
+	for (unsigned i = 0; i < cTickProfiler::DetailTicksAfterSlowTick; i++)
+	{
+		TEST_TRUE(isCapturing(tickNumber++));
+	}
+	TEST_TRUE(!isCapturing(tickNumber));
+}
+
+
+
+
+
+/** Tests that a zero threshold disables the detailed timing and the capture. */
+static void testDisabledCapture()
+{
+	cTickProfiler profiler;
+	profiler.SetSlowTickThreshold(std::chrono::milliseconds(0));
+	profiler.BeginTick(1);
+	TEST_TRUE(!profiler.IsCapturingDetails());
+	profiler.EndTick();
+	runTick(profiler, 2, std::chrono::milliseconds(5));
+	TEST_TRUE(profiler.GetSlowTicks().empty());
+	TEST_NOTEQUAL(profiler.GetReport(5).find("The slow tick capture is disabled"), AString::npos);
+}
+
+
+
+
+
+/** Tests that the slow ticks are written into the log file, at most once per second. */
+static void testLogFile()
+{
+	const AString fileName("TickProfilerTest.log");
+	cFile::DeleteFile(fileName);
+	{
+		cTickProfiler profiler;
+		profiler.SetSlowTickThreshold(std::chrono::milliseconds(1));
+		profiler.SetLogFileName(fileName);
+		runTick(profiler, 9, std::chrono::milliseconds(5));
+		runTick(profiler, 10, std::chrono::milliseconds(5));
+		TEST_EQUAL(profiler.GetSlowTicks().size(), 2U);
+	}
+	auto contents = cFile::ReadWholeFile(fileName);
+	TEST_NOTEQUAL(contents.find("] Tick 9 took "), AString::npos);
+	TEST_NOTEQUAL(contents.find("No details, the tick didn't collect them\n"), AString::npos);
+	TEST_EQUAL(contents.find("Tick 10"), AString::npos);
+	cFile::DeleteFile(fileName);
+
+	// The sampled tick is logged with its details:
+	{
+		cTickProfiler profiler;
+		profiler.SetSlowTickThreshold(std::chrono::milliseconds(1));
+		profiler.SetLogFileName(fileName);
+		runTick(profiler, cTickProfiler::DetailSampleInterval, std::chrono::milliseconds(5));
+		runTick(profiler, cTickProfiler::DetailSampleInterval + 1, std::chrono::milliseconds(5));
+	}
+	contents = cFile::ReadWholeFile(fileName);
+	TEST_NOTEQUAL(contents.find("Slowest chunks: [39, -39] 0.04 ms,"), AString::npos);
+	TEST_NOTEQUAL(contents.find("Plugin hooks: Core: OnWorldTick 0.03 ms, Other: OnWorldTick 0.01 ms\n"), AString::npos);
+	TEST_EQUAL(contents.find(fmt::format(FMT_STRING("Tick {}"), cTickProfiler::DetailSampleInterval + 1)), AString::npos);
+	cFile::DeleteFile(fileName);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("TickProfiler",
+	testSlowTickCapture();
+	testDetailSampling();
+	testDisabledCapture();
+	testLogFile();
+)